@@ -68,6 +68,54 @@ extern "C" {
  */
 #define U_CELL_SOCK_MAX_NUM_SOCKETS 7
 
+#ifndef U_CELL_SOCK_RX_CACHE_SIZE_BYTES
+/** The size of the receive cache given to each TCP socket when
+ * it is created.  With a receive cache, data is drained from the
+ * module in segments of up to #U_CELL_SOCK_MAX_SEGMENT_SIZE_BYTES
+ * when the module indicates that data has arrived (or on the
+ * first read) and subsequent reads are served from RAM, saving
+ * an AT round trip for each small read.  Zero, the default,
+ * means no receive cache; the size may also be changed for
+ * an individual socket at run-time with the #U_SOCK_OPT_RCVBUF
+ * socket option, which is how a receive cache may be switched
+ * on or off.  A size of at least #U_CELL_SOCK_MAX_SEGMENT_SIZE_BYTES
+ * is recommended.
+ */
+# define U_CELL_SOCK_RX_CACHE_SIZE_BYTES 0
+#endif
+
+#ifndef U_CELL_SOCK_TX_BUFFER_SIZE_BYTES
+/** The size of the transmit buffer given to each TCP socket when
+ * it is created.  With a transmit buffer, small writes are
+ * collected and sent to the module together, in segments of up to
+ * #U_CELL_SOCK_MAX_SEGMENT_SIZE_BYTES, once a segment's worth has
+ * built up, the buffer is full, #U_CELL_SOCK_TX_BUFFER_FLUSH_MS
+ * has passed since the first unsent write or the socket is closed,
+ * saving an AT round trip (and potentially an over-the-air packet)
+ * for each small write.  Zero, the default, means no transmit
+ * buffer; the size may also be changed for an individual socket
+ * at run-time with the #U_SOCK_OPT_SNDBUF socket option and
+ * buffering may be bypassed, flushing anything already buffered,
+ * by setting #U_SOCK_OPT_TCP_NODELAY.  A transmit buffer requires
+ * the timer API of the port.  Since a buffered write returns before
+ * the data is sent, should the module fail to take buffered data
+ * the data is dropped and every subsequent write returns
+ * -#U_SOCK_EIO; if no write has done so, closing the socket returns
+ * -#U_SOCK_EIO, the socket being closed nevertheless.  The same
+ * applies to any data the module has still not taken when the
+ * socket is closed.
+ */
+# define U_CELL_SOCK_TX_BUFFER_SIZE_BYTES 0
+#endif
+
+#ifndef U_CELL_SOCK_TX_BUFFER_FLUSH_MS
+/** The longest time that data written to a socket with a transmit
+ * buffer (see #U_CELL_SOCK_TX_BUFFER_SIZE_BYTES) may wait in the
+ * buffer before it is sent to the module.
+ */
+# define U_CELL_SOCK_TX_BUFFER_FLUSH_MS 100
+#endif
+
 #ifndef U_CELL_SOCK_CONNECT_TIMEOUT_SECONDS
 /** The amount of time allowed to connect a socket.
  */
@@ -84,6 +132,25 @@ extern "C" {
  * TYPES
  * -------------------------------------------------------------- */
 
+/** Statistics for the receive cache of a socket, see
+ * #U_CELL_SOCK_RX_CACHE_SIZE_BYTES.
+ */
+typedef struct {
+    int32_t readCount;    /**< the number of calls to uCellSockRead()
+                               while there was a receive cache. */
+    int32_t readHitCount; /**< the number of those calls that were
+                               served entirely from the receive
+                               cache, without talking to the module. */
+    int32_t fillCount;    /**< the number of times data was read from
+                               the module into the receive cache. */
+    size_t bytesFilled;   /**< the number of bytes read from the module
+                               into the receive cache. */
+    size_t bytesDirect;   /**< the number of bytes read from the module
+                               straight into the buffer of the caller
+                               of uCellSockRead() because the read was
+                               at least as large as the receive cache. */
+} uCellSockRxCacheStats_t;
+
 /* ----------------------------------------------------------------
  * FUNCTIONS:  WORKAROUND FOR LINKER ISSUE
  * -------------------------------------------------------------- */
@@ -229,6 +296,17 @@ bool uCellSockBlockingGet(uDeviceHandle_t cellHandle,
  * of #U_SOCK_OPT_LEVEL_SOCK, and option value of
  * #U_SOCK_OPT_RCVTIMEO and then the option value would be
  * a pointer to a structure of type timeval.
+ * For a TCP socket the #U_SOCK_OPT_RCVBUF option, with an
+ * int32_t parameter, sets the size of the receive cache (see
+ * #U_CELL_SOCK_RX_CACHE_SIZE_BYTES), zero to remove it; this
+ * will fail with -#U_SOCK_EBUSY if the receive cache holds more
+ * unread data than the new size would allow.  Likewise
+ * #U_SOCK_OPT_SNDBUF sets the size of the transmit buffer (see
+ * #U_CELL_SOCK_TX_BUFFER_SIZE_BYTES), zero to remove it, failing
+ * with -#U_SOCK_EBUSY if the module won't take enough of the
+ * buffered data to fit the new size, and setting
+ * #U_SOCK_OPT_TCP_NODELAY to a non-zero value flushes the transmit
+ * buffer and sends all subsequent writes straight to the module.
  *
  * @param cellHandle        the handle of the cellular instance.
  * @param sockHandle        the handle of the socket.
@@ -416,7 +494,10 @@ int32_t uCellSockReceiveFrom(uDeviceHandle_t cellHandle,
  * FUNCTIONS: STREAM (TCP)
  * -------------------------------------------------------------- */
 
-/** Send bytes over a connected socket.
+/** Send bytes over a connected socket.  If the socket has a
+ * transmit buffer (see #U_CELL_SOCK_TX_BUFFER_SIZE_BYTES) the bytes
+ * may be held there and sent to the module later, in which case
+ * they are counted as sent.
  *
  * @param cellHandle     the handle of the cellular instance.
  * @param sockHandle     the handle of the socket.
@@ -615,6 +696,23 @@ int32_t uCellSockGetBytesReceived(uDeviceHandle_t cellHandle,
 int32_t uCellSockGetBytesPending(uDeviceHandle_t cellHandle,
                                  int32_t sockHandle);
 
+/** Get the statistics of the receive cache of a socket, see
+ * #U_CELL_SOCK_RX_CACHE_SIZE_BYTES.  The statistics are kept
+ * while the socket has a receive cache and are reset when
+ * the size of the receive cache is changed.
+ *
+ * @param cellHandle  the handle of the cellular instance.
+ * @param sockHandle  the handle of the socket.
+ * @param[out] pStats a place to put the statistics; cannot be NULL.
+ * @return            zero on success else negated value of
+ *                    U_SOCK_Exxx from u_sock_errno.h; if the
+ *                    socket has no receive cache -#U_SOCK_ENOBUFS
+ *                    is returned.
+ */
+int32_t uCellSockRxCacheStatsGet(uDeviceHandle_t cellHandle,
+                                 int32_t sockHandle,
+                                 uCellSockRxCacheStats_t *pStats);
+
 #ifdef __cplusplus
 }
 #endif
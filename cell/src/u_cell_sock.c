@@ -37,6 +37,8 @@
 
 #include "u_cfg_sw.h"
 
+#include "u_error_common.h"
+
 #include "u_port.h"
 #include "u_port_heap.h"
 #include "u_port_debug.h"
@@ -102,6 +104,55 @@
  * TYPES
  * -------------------------------------------------------------- */
 
+/** The receive cache of a cellular socket, see
+ * U_CELL_SOCK_RX_CACHE_SIZE_BYTES.
+ */
+typedef struct {
+    uPortMutexHandle_t mutex; /**< Protects the receive cache and
+                                   serialises reads from the
+                                   module; NULL if there has never
+                                   been a receive cache.  Once
+                                   created it belongs to the entry
+                                   in gSockets, not to the socket,
+                                   since a reader may be waiting on
+                                   it when the socket is freed, and
+                                   is only deleted by
+                                   uCellSockDeinit(). */
+    char *pBuffer; /**< NULL if there is no receive cache. */
+    size_t size; /**< The size of pBuffer. */
+    size_t readIndex; /**< Where the unread data starts in pBuffer. */
+    size_t length; /**< The amount of unread data in pBuffer. */
+    uCellSockRxCacheStats_t stats;
+} uCellSockRxCache_t;
+
+/** The transmit buffer of a cellular socket, see
+ * U_CELL_SOCK_TX_BUFFER_SIZE_BYTES.
+ */
+typedef struct {
+    uPortMutexHandle_t mutex; /**< Protects the transmit buffer and
+                                   serialises writes to the module;
+                                   NULL if there has never been a
+                                   transmit buffer.  Like the mutex
+                                   of the receive cache, this belongs
+                                   to the entry in gSockets and is
+                                   only deleted by uCellSockDeinit(). */
+    uPortTimerHandle_t timer; /**< Flushes the transmit buffer when
+                                   data has sat in it for
+                                   U_CELL_SOCK_TX_BUFFER_FLUSH_MS;
+                                   kept, stopped, along with mutex. */
+    char *pBuffer; /**< NULL if there is no transmit buffer. */
+    size_t size; /**< The size of pBuffer. */
+    size_t length; /**< The amount of unsent data in pBuffer. */
+    int32_t negErrno; /**< Negated value of U_SOCK_Exxx if buffered
+                           data has been lost, returned by every
+                           subsequent write, else zero. */
+    bool negErrnoReported; /**< Set once negErrno has been returned,
+                                so that uCellSockClose() need not
+                                report it again. */
+    bool noDelay; /**< Set by U_SOCK_OPT_TCP_NODELAY: if true
+                       writes go straight to the module. */
+} uCellSockTxBuffer_t;
+
 /** A cellular socket.
  */
 typedef struct {
@@ -115,6 +166,9 @@ typedef struct {
                                    uses for the socket instance.
                                    -1 if this socket is not in use. */
     volatile int32_t pendingBytes;
+    uSockProtocol_t protocol;
+    uCellSockRxCache_t rxCache;
+    uCellSockTxBuffer_t txBuffer;
     void (*pAsyncClosedCallback) (uDeviceHandle_t, int32_t); /**< Set to NULL
                                                           if socket is
                                                           not in use. */
@@ -148,6 +202,722 @@ static int32_t gNextSockHandle = 0;
  */
 static uCellSockSocket_t gSockets[U_CELL_SOCK_MAX_NUM_SOCKETS];
 
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS: RECEIVE
+ * -------------------------------------------------------------- */
+
+// Read bytes from the module for a connected socket, returning
+// the number of bytes read or negated value of U_SOCK_Exxx.
+static int32_t readModule(const uCellPrivateInstance_t *pInstance,
+                          uCellSockSocket_t *pSocket,
+                          void *pData, size_t dataSizeBytes)
+{
+    int32_t negErrnoLocalOrSize = -U_SOCK_EWOULDBLOCK;
+    uAtClientHandle_t atHandle = pInstance->atHandle;
+    int32_t dataLengthMax = U_CELL_SOCK_MAX_SEGMENT_SIZE_BYTES;
+    int32_t x = -1;
+    int32_t thisWantedReceiveSize;
+    int32_t thisActualReceiveSize;
+    int32_t totalReceivedSize = 0;
+
+    if (pInstance->socketsHexMode) {
+        dataLengthMax /= 2;
+    }
+
+    if (pSocket->pendingBytes == 0) {
+        // If the URC has not filled in pendingBytes,
+        // ask the module directly if there is anything
+        // to read
+        uAtClientLock(atHandle);
+        uAtClientCommandStart(atHandle, "AT+USORD=");
+        uAtClientWriteInt(atHandle, pSocket->sockHandleModule);
+        // Zero bytes to read, just want to know the number
+        // of bytes waiting
+        uAtClientWriteInt(atHandle, 0);
+        uAtClientCommandStop(atHandle);
+        uAtClientResponseStart(atHandle, "+USORD:");
+        // Skip the socket ID
+        uAtClientSkipParameters(atHandle, 1);
+        // Read the amount of data
+        x = uAtClientReadInt(atHandle);
+        uAtClientResponseStop(atHandle);
+        // Update pending bytes here, before
+        // unlocking, as otherwise a data callback
+        // triggered by a URC could be sitting waiting
+        // to grab the AT lock and jump in before
+        // pending bytes has been updated, leading it
+        // back into here again, etc, etc.
+        if (x > 0) {
+            pSocket->pendingBytes = x;
+            // DON'T call the user data callback here:
+            // we already have the AT interface locked
+            // and a user might try to call back into
+            // here which would result in deadlock.
+            // They will get their received data, there
+            // is no need to worry.
+        }
+        uAtClientUnlock(atHandle);
+    }
+    if (pSocket->pendingBytes > 0) {
+        negErrnoLocalOrSize = U_SOCK_ENONE;
+        // Run around the loop until we run out of
+        // pending data or room in the buffer
+        while ((dataSizeBytes > 0) &&
+               (pSocket->pendingBytes > 0) &&
+               (negErrnoLocalOrSize == U_SOCK_ENONE)) {
+            thisWantedReceiveSize = dataLengthMax;
+            if (thisWantedReceiveSize > (int32_t) dataSizeBytes) {
+                thisWantedReceiveSize = (int32_t) dataSizeBytes;
+            }
+            uAtClientLock(atHandle);
+            uAtClientCommandStart(atHandle, "AT+USORD=");
+            uAtClientWriteInt(atHandle, pSocket->sockHandleModule);
+            // Number of bytes to read
+            uAtClientWriteInt(atHandle, thisWantedReceiveSize);
+            uAtClientCommandStop(atHandle);
+            uAtClientResponseStart(atHandle, "+USORD:");
+            // Skip the socket ID
+            uAtClientSkipParameters(atHandle, 1);
+            // Read the amount of data
+            thisActualReceiveSize = uAtClientReadInt(atHandle);
+            if (thisActualReceiveSize > (int32_t) dataSizeBytes) {
+                thisActualReceiveSize = (int32_t) dataSizeBytes;
+            }
+            if (thisActualReceiveSize > 0) {
+                if (pInstance->socketsHexMode) {
+                    // In hex mode decode the hex string
+                    // straight into pData
+                    uAtClientReadHexData(atHandle,
+                                         (char *) pData +
+                                         totalReceivedSize,
+                                         thisActualReceiveSize);
+                } else {
+                    // Binary mode, don't stop for anything!
+                    uAtClientIgnoreStopTag(atHandle);
+                    // Get the leading quote mark out of the way
+                    uAtClientReadBytes(atHandle, NULL, 1, true);
+                    // Now read out the available data
+                    uAtClientReadBytes(atHandle,
+                                       (char *) pData +
+                                       totalReceivedSize,
+                                       thisActualReceiveSize, true);
+                    // Make sure we wait for the stop tag before
+                    // going around again
+                    uAtClientRestoreStopTag(atHandle);
+                }
+            }
+            uAtClientResponseStop(atHandle);
+            // BEFORE unlocking, work out what's happened.
+            // This is to prevent a URC being processed that
+            // may indicate data left and over-write pendingBytes
+            // while we're also writing to it.
+            if ((uAtClientErrorGet(atHandle) == 0) &&
+                (thisActualReceiveSize >= 0)) {
+                // Must use what +USORD returns here as it may be less
+                // or more than we asked for and also may be
+                // more than pendingBytes, depending on how
+                // the URCs landed
+                // This update of pendingBytes will be overwritten
+                // by the URC but we have to do something here
+                // 'cos we don't get a URC to tell us when pendingBytes
+                // has gone to zero.
+                if (thisActualReceiveSize > pSocket->pendingBytes) {
+                    pSocket->pendingBytes = 0;
+                } else {
+                    pSocket->pendingBytes -= thisActualReceiveSize;
+                }
+                totalReceivedSize += thisActualReceiveSize;
+                dataSizeBytes -= thisActualReceiveSize;
+            } else {
+                negErrnoLocalOrSize = -U_SOCK_EIO;
+            }
+            uAtClientUnlock(atHandle);
+        }
+    }
+
+    if (totalReceivedSize > 0) {
+        negErrnoLocalOrSize = totalReceivedSize;
+    }
+
+    return negErrnoLocalOrSize;
+}
+
+
+// Free a receive cache, but NOT its mutex: readCached() may be
+// waiting on that in another task, and will find that the socket
+// has gone once it gets it.
+static void rxCacheFree(uCellSockRxCache_t *pRxCache)
+{
+    uPortMutexHandle_t mutex = pRxCache->mutex;
+
+    if (mutex != NULL) {
+        // Lock the mutex to make sure no-one is using the
+        // receive cache before we free it
+        U_PORT_MUTEX_LOCK(mutex);
+        uPortFree(pRxCache->pBuffer);
+        memset(pRxCache, 0, sizeof(*pRxCache));
+        pRxCache->mutex = mutex;
+        U_PORT_MUTEX_UNLOCK(mutex);
+    } else {
+        memset(pRxCache, 0, sizeof(*pRxCache));
+    }
+}
+
+// Set the size of a receive cache, zero to remove it, keeping
+// any unread data, returning a (non-negated) value of U_SOCK_Exxx.
+static int32_t rxCacheSizeSet(uCellSockRxCache_t *pRxCache, size_t size)
+{
+    int32_t errnoLocal = U_SOCK_ENONE;
+    char *pBuffer = NULL;
+
+    if ((pRxCache->mutex == NULL) && (size > 0) &&
+        (uPortMutexCreate(&(pRxCache->mutex)) != 0)) {
+        errnoLocal = U_SOCK_ENOMEM;
+    }
+
+    if ((errnoLocal == U_SOCK_ENONE) && (pRxCache->mutex != NULL)) {
+        U_PORT_MUTEX_LOCK(pRxCache->mutex);
+        if (size < pRxCache->length) {
+            // Can't throw away data that has been received,
+            // the application must read it first
+            errnoLocal = U_SOCK_EBUSY;
+        } else {
+            if (size > 0) {
+                pBuffer = (char *) pUPortMalloc(size);
+                if (pBuffer == NULL) {
+                    errnoLocal = U_SOCK_ENOMEM;
+                } else if (pRxCache->length > 0) {
+                    memcpy(pBuffer, pRxCache->pBuffer + pRxCache->readIndex,
+                           pRxCache->length);
+                }
+            }
+            if (errnoLocal == U_SOCK_ENONE) {
+                uPortFree(pRxCache->pBuffer);
+                pRxCache->pBuffer = pBuffer;
+                pRxCache->size = size;
+                pRxCache->readIndex = 0;
+                memset(&(pRxCache->stats), 0, sizeof(pRxCache->stats));
+            }
+        }
+        U_PORT_MUTEX_UNLOCK(pRxCache->mutex);
+    }
+
+    return errnoLocal;
+}
+
+// Copy up to dataSizeBytes of unread data out of a receive cache,
+// returning the number of bytes copied; the receive cache mutex
+// must be locked.
+static size_t rxCacheCopy(uCellSockRxCache_t *pRxCache,
+                          char *pData, size_t dataSizeBytes)
+{
+    size_t length = pRxCache->length;
+
+    if (length > dataSizeBytes) {
+        length = dataSizeBytes;
+    }
+    if (length > 0) {
+        memcpy(pData, pRxCache->pBuffer + pRxCache->readIndex, length);
+        pRxCache->readIndex += length;
+        pRxCache->length -= length;
+    }
+    if (pRxCache->length == 0) {
+        pRxCache->readIndex = 0;
+    }
+
+    return length;
+}
+
+// Fill the free space in a receive cache from the module,
+// returning the number of bytes added or negated value of
+// U_SOCK_Exxx; the receive cache mutex must be locked.
+static int32_t rxCacheFill(const uCellPrivateInstance_t *pInstance,
+                           uCellSockSocket_t *pSocket)
+{
+    int32_t negErrnoLocalOrSize = -U_SOCK_ENOBUFS;
+    uCellSockRxCache_t *pRxCache = &(pSocket->rxCache);
+
+    // Move any unread data to the start so that the
+    // module can be drained in whole segments
+    if ((pRxCache->readIndex > 0) && (pRxCache->length > 0)) {
+        memmove(pRxCache->pBuffer, pRxCache->pBuffer + pRxCache->readIndex,
+                pRxCache->length);
+    }
+    pRxCache->readIndex = 0;
+    if (pRxCache->length < pRxCache->size) {
+        negErrnoLocalOrSize = readModule(pInstance, pSocket,
+                                         pRxCache->pBuffer + pRxCache->length,
+                                         pRxCache->size - pRxCache->length);
+        if (negErrnoLocalOrSize > 0) {
+            pRxCache->length += negErrnoLocalOrSize;
+            pRxCache->stats.fillCount++;
+            pRxCache->stats.bytesFilled += negErrnoLocalOrSize;
+        }
+    }
+
+    return negErrnoLocalOrSize;
+}
+
+// Called when the module has indicated that there is data to
+// read: drain it into the receive cache of the socket, if there is one.
+static void rxCachePrefetch(uCellSockSocket_t *pSocket)
+{
+    uCellSockRxCache_t *pRxCache = &(pSocket->rxCache);
+    const uCellPrivateInstance_t *pInstance;
+
+    if (pRxCache->mutex != NULL) {
+        pInstance = pUCellPrivateGetInstance(pSocket->cellHandle);
+        U_PORT_MUTEX_LOCK(pRxCache->mutex);
+        if ((pInstance != NULL) && (pRxCache->pBuffer != NULL) &&
+            (pSocket->pendingBytes > 0)) {
+            rxCacheFill(pInstance, pSocket);
+        }
+        U_PORT_MUTEX_UNLOCK(pRxCache->mutex);
+    }
+}
+
+// Read bytes for a connected socket through its receive cache,
+// returning the number of bytes read or negated value of U_SOCK_Exxx;
+// sockHandle is used to check that the socket is still the one
+// that was asked for once the receive cache mutex has been locked.
+static int32_t readCached(const uCellPrivateInstance_t *pInstance,
+                          uCellSockSocket_t *pSocket, int32_t sockHandle,
+                          void *pData, size_t dataSizeBytes)
+{
+    int32_t negErrnoLocalOrSize = -U_SOCK_EWOULDBLOCK;
+    uCellSockRxCache_t *pRxCache = &(pSocket->rxCache);
+    size_t totalReceivedSize;
+    size_t leftToReceiveSize;
+
+    U_PORT_MUTEX_LOCK(pRxCache->mutex);
+
+    if (pSocket->sockHandle != sockHandle) {
+        // The socket was closed, and freed by closedCallback(),
+        // while we were waiting for the mutex
+        negErrnoLocalOrSize = -U_SOCK_EINVAL;
+    } else if (pRxCache->pBuffer != NULL) {
+        pRxCache->stats.readCount++;
+        // Serve what we can from the receive cache
+        totalReceivedSize = rxCacheCopy(pRxCache, (char *) pData, dataSizeBytes);
+        leftToReceiveSize = dataSizeBytes - totalReceivedSize;
+        if (leftToReceiveSize == 0) {
+            if (totalReceivedSize > 0) {
+                pRxCache->stats.readHitCount++;
+            }
+        } else if ((totalReceivedSize == 0) || (pSocket->pendingBytes > 0)) {
+            // Only talk to the module if there is nothing to return
+            // or the module is known to have more data
+            if (leftToReceiveSize >= pRxCache->size) {
+                // No point in going through the receive cache, read
+                // straight into the caller's buffer
+                negErrnoLocalOrSize = readModule(pInstance, pSocket,
+                                                 (char *) pData + totalReceivedSize,
+                                                 leftToReceiveSize);
+                if (negErrnoLocalOrSize > 0) {
+                    pRxCache->stats.bytesDirect += negErrnoLocalOrSize;
+                    totalReceivedSize += negErrnoLocalOrSize;
+                }
+            } else {
+                negErrnoLocalOrSize = rxCacheFill(pInstance, pSocket);
+                if (negErrnoLocalOrSize > 0) {
+                    totalReceivedSize += rxCacheCopy(pRxCache,
+                                                     (char *) pData + totalReceivedSize,
+                                                     leftToReceiveSize);
+                }
+            }
+        }
+        if (totalReceivedSize > 0) {
+            negErrnoLocalOrSize = (int32_t) totalReceivedSize;
+        }
+    } else {
+        // The receive cache has been switched off
+        negErrnoLocalOrSize = readModule(pInstance, pSocket,
+                                         pData, dataSizeBytes);
+    }
+
+    U_PORT_MUTEX_UNLOCK(pRxCache->mutex);
+
+    return negErrnoLocalOrSize;
+}
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS: TRANSMIT
+ * -------------------------------------------------------------- */
+
+// Do AT+USOER, for debug purposes.
+static void doUsoer(uAtClientHandle_t atHandle)
+{
+    uAtClientLock(atHandle);
+    uAtClientCommandStart(atHandle, "AT+USOER");
+    uAtClientCommandStop(atHandle);
+    uAtClientResponseStart(atHandle, "+USOER:");
+    uAtClientResponseStop(atHandle);
+    uAtClientUnlock(atHandle);
+}
+
+// Write bytes to the module for a connected socket, returning
+// the number of bytes written or negated value of U_SOCK_Exxx.
+static int32_t writeModule(const uCellPrivateInstance_t *pInstance,
+                           const uCellSockSocket_t *pSocket,
+                           const void *pData, size_t dataSizeBytes)
+{
+    int32_t negErrnoLocalOrSize = U_SOCK_ENONE;
+    uAtClientHandle_t atHandle = pInstance->atHandle;
+    int32_t leftToSendSize = (int32_t) dataSizeBytes;
+    int32_t sentSize = 0;
+    int32_t dataOffset = 0;
+    int32_t thisSendSize = U_CELL_SOCK_MAX_SEGMENT_SIZE_BYTES;
+    size_t x = 0;
+    bool written = true;
+    char *pHexBuffer = NULL;
+
+    if (pInstance->socketsHexMode) {
+        thisSendSize /= 2;
+        negErrnoLocalOrSize = -U_SOCK_ENOMEM;
+        pHexBuffer = (char *)pUPortMalloc(thisSendSize * 2 + 1); // +1 for terminator
+    }
+    if (!pInstance->socketsHexMode || (pHexBuffer != NULL)) {
+        negErrnoLocalOrSize = U_SOCK_ENONE;
+        x = 0;
+        while ((leftToSendSize > 0) &&
+               (negErrnoLocalOrSize == U_SOCK_ENONE) &&
+               (x < U_CELL_SOCK_TCP_RETRY_LIMIT) &&
+               written) {
+            if (leftToSendSize < thisSendSize) {
+                thisSendSize = leftToSendSize;
+            }
+            uAtClientLock(atHandle);
+            uAtClientCommandStart(atHandle, "AT+USOWR=");
+            // Write module socket handle
+            uAtClientWriteInt(atHandle, pSocket->sockHandleModule);
+            // Number of bytes to follow
+            uAtClientWriteInt(atHandle, (int32_t) thisSendSize);
+            written = false;
+            if (pHexBuffer) {
+                // Make the hex-coded null terminated string
+                uBinToHex((const char *) pData + dataOffset,
+                          thisSendSize, pHexBuffer);
+                pHexBuffer[thisSendSize * 2] = 0;
+                // Send the hex mode data as a string
+                //lint -e(679) Suppress suspicious truncation
+                uAtClientWriteString(atHandle, pHexBuffer, true);
+                uAtClientCommandStop(atHandle);
+                written = true;
+            } else {
+                uAtClientCommandStop(atHandle);
+                // Wait for the prompt
+                if (uAtClientWaitCharacter(atHandle, '@') == 0) {
+                    // Wait for it...
+                    uPortTaskBlock(50);
+                    // Go!
+                    uAtClientWriteBytes(atHandle,
+                                        (const char *) pData + dataOffset,
+                                        thisSendSize, true);
+                    written = true;
+                }
+            }
+            if (written) {
+                // Grab the response
+                uAtClientResponseStart(atHandle, "+USOWR:");
+                // Skip the socket ID
+                uAtClientSkipParameters(atHandle, 1);
+                // Bytes sent
+                sentSize = uAtClientReadInt(atHandle);
+                uAtClientResponseStop(atHandle);
+                // Note: the sentSize check below is because we have seen cases
+                // where the module returns just "OK", missing out the "+USOWR: x"
+                // response; what to do when this happens?  The AT unlock check
+                // will pass because it has been sent an "OK", but has the data
+                // been sent or was the OK for a previous "AT" and we have somehow
+                // or other become unsynchronised with the module? Gonna assume
+                // the worst, that the data has not been sent.
+                if (sentSize < 0) {
+                    sentSize = 0;
+                }
+                if (uAtClientUnlock(atHandle) == 0) {
+                    dataOffset += sentSize;
+                    leftToSendSize -= sentSize;
+                    // Technically, it should be OK to
+                    // send fewer bytes than asked for,
+                    // however if this happens a lot we'll
+                    // get stuck, which isn't desirable,
+                    // so use the loop counter to avoid that
+                    if (sentSize < thisSendSize) {
+                        x++;
+                    }
+                } else {
+                    negErrnoLocalOrSize = -U_SOCK_EIO;
+                    // Got an AT interface error, see
+                    // what the module's socket error
+                    // number has to say for debug purposes
+                    doUsoer(atHandle);
+                }
+            } else {
+                negErrnoLocalOrSize = -U_SOCK_EIO;
+                uAtClientUnlock(atHandle);
+            }
+        }
+    }
+    // Free the buffer
+    uPortFree(pHexBuffer);
+
+    if (negErrnoLocalOrSize == U_SOCK_ENONE) {
+        // All is good
+        negErrnoLocalOrSize = ((int32_t) dataSizeBytes) - leftToSendSize;
+    }
+
+    return negErrnoLocalOrSize;
+}
+
+// Write out whatever is in the transmit buffer of a socket,
+// returning the number of bytes written or negated value of
+// U_SOCK_Exxx; the transmit buffer mutex must be locked.  Anything
+// the module doesn't take is kept and the flush timer restarted
+// so that it is tried again later, unless the AT interface has
+// failed (-U_SOCK_EIO), in which case retrying would be pointless:
+// the buffered data is thrown away and the error is kept in
+// negErrno to be returned by the next write or by close.
+static int32_t txBufferFlush(const uCellPrivateInstance_t *pInstance,
+                             const uCellSockSocket_t *pSocket,
+                             uCellSockTxBuffer_t *pTxBuffer)
+{
+    int32_t negErrnoLocalOrSize = 0;
+
+    if (pTxBuffer->length > 0) {
+        negErrnoLocalOrSize = writeModule(pInstance, pSocket,
+                                          pTxBuffer->pBuffer,
+                                          pTxBuffer->length);
+        if (negErrnoLocalOrSize == -U_SOCK_EIO) {
+            pTxBuffer->length = 0;
+            pTxBuffer->negErrno = negErrnoLocalOrSize;
+            pTxBuffer->negErrnoReported = false;
+        } else if (negErrnoLocalOrSize > 0) {
+            pTxBuffer->length -= negErrnoLocalOrSize;
+            if (pTxBuffer->length > 0) {
+                memmove(pTxBuffer->pBuffer,
+                        pTxBuffer->pBuffer + negErrnoLocalOrSize,
+                        pTxBuffer->length);
+            }
+        }
+        if (pTxBuffer->length > 0) {
+            uPortTimerStart(pTxBuffer->timer);
+        }
+    }
+
+    return negErrnoLocalOrSize;
+}
+
+// Callback, run by the AT client's callback task, to flush
+// the transmit buffer of a socket.
+static void txFlushCallback(const uAtClientHandle_t atHandle,
+                            void *pParameter)
+{
+    uCellSockSocket_t *pSocket = (uCellSockSocket_t *) pParameter;
+    uCellSockTxBuffer_t *pTxBuffer = &(pSocket->txBuffer);
+    const uCellPrivateInstance_t *pInstance;
+
+    (void) atHandle;
+
+    if (pTxBuffer->mutex != NULL) {
+        pInstance = pUCellPrivateGetInstance(pSocket->cellHandle);
+        U_PORT_MUTEX_LOCK(pTxBuffer->mutex);
+        if ((pInstance != NULL) && (pTxBuffer->pBuffer != NULL)) {
+            txBufferFlush(pInstance, pSocket, pTxBuffer);
+        }
+        U_PORT_MUTEX_UNLOCK(pTxBuffer->mutex);
+    }
+}
+
+// Callback for the flush timer of a transmit buffer: the timer
+// task may not have the stack for AT exchanges so the flush itself
+// is passed on to the AT client's callback task.
+static void txFlushTimerCallback(const uPortTimerHandle_t timerHandle,
+                                 void *pParameter)
+{
+    uCellSockSocket_t *pSocket = (uCellSockSocket_t *) pParameter;
+    uAtClientHandle_t atHandle = pSocket->atHandle;
+
+    (void) timerHandle;
+
+    if (atHandle != NULL) {
+        uAtClientCallback(atHandle, txFlushCallback, pSocket);
+    }
+}
+
+// Free a transmit buffer, but NOT its mutex or timer: as for
+// rxCacheFree(), writeBuffered() may be waiting on the mutex in
+// another task and a flush may already be queued; any data still
+// in the transmit buffer is lost.
+static void txBufferFree(uCellSockTxBuffer_t *pTxBuffer)
+{
+    uPortMutexHandle_t mutex = pTxBuffer->mutex;
+    uPortTimerHandle_t timer = pTxBuffer->timer;
+
+    if (mutex != NULL) {
+        // Lock the mutex to make sure no-one is using the
+        // transmit buffer before we free it
+        U_PORT_MUTEX_LOCK(mutex);
+        uPortFree(pTxBuffer->pBuffer);
+        if (timer != NULL) {
+            uPortTimerStop(timer);
+        }
+        memset(pTxBuffer, 0, sizeof(*pTxBuffer));
+        pTxBuffer->mutex = mutex;
+        pTxBuffer->timer = timer;
+        U_PORT_MUTEX_UNLOCK(mutex);
+    } else {
+        memset(pTxBuffer, 0, sizeof(*pTxBuffer));
+    }
+}
+
+// Set the size of the transmit buffer of a socket, zero to
+// remove it, flushing any buffered data that would not fit,
+// returning a (non-negated) value of U_SOCK_Exxx.
+static int32_t txBufferSizeSet(const uCellPrivateInstance_t *pInstance,
+                               uCellSockSocket_t *pSocket, size_t size)
+{
+    int32_t errnoLocal = U_SOCK_ENONE;
+    uCellSockTxBuffer_t *pTxBuffer = &(pSocket->txBuffer);
+    char *pBuffer = NULL;
+    int32_t x;
+
+    if ((pTxBuffer->mutex == NULL) && (size > 0)) {
+        if (uPortMutexCreate(&(pTxBuffer->mutex)) != 0) {
+            errnoLocal = U_SOCK_ENOMEM;
+        } else {
+            x = uPortTimerCreate(&(pTxBuffer->timer), "cellSockTx",
+                                 txFlushTimerCallback, pSocket,
+                                 U_CELL_SOCK_TX_BUFFER_FLUSH_MS, false);
+            if (x != 0) {
+                // Without a timer buffered data might never be sent
+                errnoLocal = U_SOCK_ENOMEM;
+                if (x == (int32_t) U_ERROR_COMMON_NOT_IMPLEMENTED) {
+                    errnoLocal = U_SOCK_ENOSYS;
+                }
+                uPortMutexDelete(pTxBuffer->mutex);
+                memset(pTxBuffer, 0, sizeof(*pTxBuffer));
+            }
+        }
+    }
+
+    if ((errnoLocal == U_SOCK_ENONE) && (pTxBuffer->mutex != NULL)) {
+        U_PORT_MUTEX_LOCK(pTxBuffer->mutex);
+        if (size < pTxBuffer->length) {
+            txBufferFlush(pInstance, pSocket, pTxBuffer);
+        }
+        if (size < pTxBuffer->length) {
+            // Can't throw away data the application has written
+            errnoLocal = U_SOCK_EBUSY;
+        } else {
+            if (size > 0) {
+                pBuffer = (char *) pUPortMalloc(size);
+                if (pBuffer == NULL) {
+                    errnoLocal = U_SOCK_ENOMEM;
+                } else if (pTxBuffer->length > 0) {
+                    memcpy(pBuffer, pTxBuffer->pBuffer, pTxBuffer->length);
+                }
+            }
+            if (errnoLocal == U_SOCK_ENONE) {
+                uPortFree(pTxBuffer->pBuffer);
+                pTxBuffer->pBuffer = pBuffer;
+                pTxBuffer->size = size;
+                if (pTxBuffer->length == 0) {
+                    uPortTimerStop(pTxBuffer->timer);
+                }
+            }
+        }
+        U_PORT_MUTEX_UNLOCK(pTxBuffer->mutex);
+    }
+
+    return errnoLocal;
+}
+
+// Write bytes for a connected socket through its transmit buffer,
+// returning the number of bytes accepted or negated value of
+// U_SOCK_Exxx.  Small writes are collected in the transmit buffer
+// until a segment's worth has built up, the buffer is full or the
+// flush timer expires; a write that is at least a segment long
+// and finds the buffer empty is passed straight to the module.
+// As for readCached(), sockHandle is checked once the mutex has
+// been locked.
+static int32_t writeBuffered(const uCellPrivateInstance_t *pInstance,
+                             uCellSockSocket_t *pSocket, int32_t sockHandle,
+                             const void *pData, size_t dataSizeBytes)
+{
+    int32_t negErrnoLocalOrSize = 0;
+    uCellSockTxBuffer_t *pTxBuffer = &(pSocket->txBuffer);
+    size_t threshold = U_CELL_SOCK_MAX_SEGMENT_SIZE_BYTES;
+    size_t thisSize;
+    bool wasEmpty;
+    bool isGone;
+
+    if (pInstance->socketsHexMode) {
+        threshold /= 2;
+    }
+
+    U_PORT_MUTEX_LOCK(pTxBuffer->mutex);
+
+    // The socket may have been closed, and freed by
+    // closedCallback(), while we were waiting for the mutex
+    isGone = (pSocket->sockHandle != sockHandle);
+
+    if (!isGone && (pTxBuffer->pBuffer != NULL) && (pTxBuffer->length > 0) &&
+        (pTxBuffer->length + dataSizeBytes > pTxBuffer->size) &&
+        !pTxBuffer->noDelay) {
+        // Not enough room: get rid of what's buffered first
+        negErrnoLocalOrSize = txBufferFlush(pInstance, pSocket, pTxBuffer);
+    }
+
+    if (isGone) {
+        negErrnoLocalOrSize = -U_SOCK_EINVAL;
+    } else if (pTxBuffer->negErrno != 0) {
+        // Data written earlier has been lost: the socket is
+        // no good any more
+        negErrnoLocalOrSize = pTxBuffer->negErrno;
+        pTxBuffer->negErrnoReported = true;
+    } else if ((pTxBuffer->pBuffer == NULL) || pTxBuffer->noDelay) {
+        negErrnoLocalOrSize = writeModule(pInstance, pSocket,
+                                          pData, dataSizeBytes);
+    } else {
+        if (threshold > pTxBuffer->size) {
+            threshold = pTxBuffer->size;
+        }
+        if ((pTxBuffer->length == 0) && (dataSizeBytes >= threshold)) {
+            // Nothing to coalesce with and big enough on its own
+            negErrnoLocalOrSize = writeModule(pInstance, pSocket,
+                                              pData, dataSizeBytes);
+        } else {
+            thisSize = pTxBuffer->size - pTxBuffer->length;
+            if (thisSize > dataSizeBytes) {
+                thisSize = dataSizeBytes;
+            }
+            if (thisSize > 0) {
+                wasEmpty = (pTxBuffer->length == 0);
+                memcpy(pTxBuffer->pBuffer + pTxBuffer->length,
+                       pData, thisSize);
+                pTxBuffer->length += thisSize;
+                negErrnoLocalOrSize = (int32_t) thisSize;
+                if (pTxBuffer->length >= threshold) {
+                    // Errors are not reported here since the data
+                    // has been accepted: the flush timer will retry
+                    // or, if the flush has failed for good, the
+                    // next write will report it
+                    txBufferFlush(pInstance, pSocket, pTxBuffer);
+                } else if (wasEmpty) {
+                    uPortTimerStart(pTxBuffer->timer);
+                }
+            } else if ((dataSizeBytes > 0) && (negErrnoLocalOrSize >= 0)) {
+                // The module didn't take enough to make room
+                negErrnoLocalOrSize = -U_SOCK_EWOULDBLOCK;
+            }
+        }
+    }
+
+    U_PORT_MUTEX_UNLOCK(pTxBuffer->mutex);
+
+    return negErrnoLocalOrSize;
+}
+
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS: LIST MANAGEMENT
  * -------------------------------------------------------------- */
@@ -186,17 +956,6 @@ static uCellSockSocket_t *pFindBySockHandleModule(const uAtClientHandle_t atHand
     return pSock;
 }
 
-// Do AT+USOER, for debug purposes.
-static void doUsoer(uAtClientHandle_t atHandle)
-{
-    uAtClientLock(atHandle);
-    uAtClientCommandStart(atHandle, "AT+USOER");
-    uAtClientCommandStop(atHandle);
-    uAtClientResponseStart(atHandle, "+USOER:");
-    uAtClientResponseStop(atHandle);
-    uAtClientUnlock(atHandle);
-}
-
 // Create a socket entry in the list.
 static uCellSockSocket_t *pSockCreate(int32_t sockHandle,
                                       uDeviceHandle_t cellHandle,
@@ -219,6 +978,10 @@ static uCellSockSocket_t *pSockCreate(int32_t sockHandle,
         pSock->atHandle = atHandle;
         pSock->sockHandleModule = -1;
         pSock->pendingBytes = 0;
+        pSock->protocol = U_SOCK_PROTOCOL_TCP;
+        // The receive cache and transmit buffer were cleared
+        // by uCellSockInit() or sockFree(), which leaves their
+        // mutexes in place
         pSock->pAsyncClosedCallback = NULL;
         pSock->pDataCallback = NULL;
         pSock->pClosedCallback = NULL;
@@ -241,6 +1004,8 @@ static void sockFree(int32_t sockHandle)
             pSock->atHandle = NULL;
             pSock->sockHandleModule = -1;
             pSock->pendingBytes = 0;
+            rxCacheFree(&(pSock->rxCache));
+            txBufferFree(&(pSock->txBuffer));
             pSock->pAsyncClosedCallback = NULL;
             pSock->pDataCallback = NULL;
             pSock->pClosedCallback = NULL;
@@ -267,9 +1032,14 @@ static void dataCallback(const uAtClientHandle_t atHandle,
     if (sockHandle >= 0) {
         // Find the entry
         pSocket = pFindBySockHandle(sockHandle);
-        if ((pSocket != NULL) && (pSocket->pDataCallback != NULL)) {
-            pSocket->pDataCallback(pSocket->cellHandle,
-                                   sockHandle);
+        if (pSocket != NULL) {
+            // Fill the receive cache, if there is one, before
+            // letting the user know that there is data
+            rxCachePrefetch(pSocket);
+            if (pSocket->pDataCallback != NULL) {
+                pSocket->pDataCallback(pSocket->cellHandle,
+                                       sockHandle);
+            }
         }
     }
 }
@@ -329,9 +1099,11 @@ static void UUSORD_UUSORF_urc(const uAtClientHandle_t atHandle,
         pSocket = pFindBySockHandleModule(atHandle,
                                           sockHandleModule);
         if (pSocket != NULL) {
-            // Call the user call-back via the trampoline
+            // Call the user call-back, and fill the
+            // receive cache, via the trampoline
             if ((dataSizeBytes > 0) &&
-                (pSocket->pDataCallback != NULL)) {
+                ((pSocket->pDataCallback != NULL) ||
+                 (pSocket->rxCache.pBuffer != NULL))) {
                 uAtClientCallback(atHandle,
                                   dataCallback,
                                   (void *) (pSocket->sockHandle));
@@ -571,6 +1343,125 @@ static int32_t getOptionLinger(const uCellSockSocket_t *pSocket,
     return errnoLocal;
 }
 
+// Set the size of the receive cache of a socket, returning
+// a (non-negated) value of U_SOCK_Exxx.
+static int32_t setOptionRxCache(uCellSockSocket_t *pSocket,
+                                const void *pOptionValue,
+                                size_t optionValueLength)
+{
+    int32_t errnoLocal = U_SOCK_EINVAL;
+
+    // Only TCP sockets have a receive cache
+    if ((pSocket->protocol == U_SOCK_PROTOCOL_TCP) &&
+        (pOptionValue != NULL) &&
+        (optionValueLength >= sizeof(int32_t)) &&
+        (*((const int32_t *) pOptionValue) >= 0)) {
+        errnoLocal = rxCacheSizeSet(&(pSocket->rxCache),
+                                    (size_t) *((const int32_t *) pOptionValue));
+    }
+
+    return errnoLocal;
+}
+
+// Get the size of the receive cache of a socket, returning
+// a (non-negated) value of U_SOCK_Exxx.
+static int32_t getOptionRxCache(const uCellSockSocket_t *pSocket,
+                                void *pOptionValue,
+                                size_t *pOptionValueLength)
+{
+    int32_t errnoLocal = U_SOCK_EINVAL;
+
+    if ((pSocket->protocol == U_SOCK_PROTOCOL_TCP) &&
+        (pOptionValueLength != NULL)) {
+        if (pOptionValue != NULL) {
+            if (*pOptionValueLength >= sizeof(int32_t)) {
+                errnoLocal = U_SOCK_ENONE;
+                *((int32_t *) pOptionValue) = (int32_t) pSocket->rxCache.size;
+                *pOptionValueLength = sizeof(int32_t);
+            }
+        } else {
+            errnoLocal = U_SOCK_ENONE;
+            // Caller just wants to know the length required
+            *pOptionValueLength = sizeof(int32_t);
+        }
+    }
+
+    return errnoLocal;
+}
+
+// Set the size of the transmit buffer of a socket, returning
+// a (non-negated) value of U_SOCK_Exxx.
+static int32_t setOptionTxBuffer(const uCellPrivateInstance_t *pInstance,
+                                 uCellSockSocket_t *pSocket,
+                                 const void *pOptionValue,
+                                 size_t optionValueLength)
+{
+    int32_t errnoLocal = U_SOCK_EINVAL;
+
+    // Only TCP sockets have a transmit buffer
+    if ((pSocket->protocol == U_SOCK_PROTOCOL_TCP) &&
+        (pOptionValue != NULL) &&
+        (optionValueLength >= sizeof(int32_t)) &&
+        (*((const int32_t *) pOptionValue) >= 0)) {
+        errnoLocal = txBufferSizeSet(pInstance, pSocket,
+                                     (size_t) *((const int32_t *) pOptionValue));
+    }
+
+    return errnoLocal;
+}
+
+// Get the size of the transmit buffer of a socket, returning
+// a (non-negated) value of U_SOCK_Exxx.
+static int32_t getOptionTxBuffer(const uCellSockSocket_t *pSocket,
+                                 void *pOptionValue,
+                                 size_t *pOptionValueLength)
+{
+    int32_t errnoLocal = U_SOCK_EINVAL;
+
+    if ((pSocket->protocol == U_SOCK_PROTOCOL_TCP) &&
+        (pOptionValueLength != NULL)) {
+        if (pOptionValue != NULL) {
+            if (*pOptionValueLength >= sizeof(int32_t)) {
+                errnoLocal = U_SOCK_ENONE;
+                *((int32_t *) pOptionValue) = (int32_t) pSocket->txBuffer.size;
+                *pOptionValueLength = sizeof(int32_t);
+            }
+        } else {
+            errnoLocal = U_SOCK_ENONE;
+            // Caller just wants to know the length required
+            *pOptionValueLength = sizeof(int32_t);
+        }
+    }
+
+    return errnoLocal;
+}
+
+// Set the TCP no-delay option: as well as being passed to the
+// module, this switches write coalescing in the transmit buffer
+// off (flushing it) or back on.  Returns a (non-negated) value
+// of U_SOCK_Exxx.
+static int32_t setOptionNoDelay(const uCellPrivateInstance_t *pInstance,
+                                uCellSockSocket_t *pSocket,
+                                const void *pOptionValue,
+                                size_t optionValueLength)
+{
+    uCellSockTxBuffer_t *pTxBuffer = &(pSocket->txBuffer);
+
+    if ((pTxBuffer->mutex != NULL) && (pOptionValue != NULL) &&
+        (optionValueLength >= sizeof(int32_t))) {
+        U_PORT_MUTEX_LOCK(pTxBuffer->mutex);
+        pTxBuffer->noDelay = (*((const int32_t *) pOptionValue) != 0);
+        if (pTxBuffer->noDelay && (pTxBuffer->pBuffer != NULL)) {
+            txBufferFlush(pInstance, pSocket, pTxBuffer);
+        }
+        U_PORT_MUTEX_UNLOCK(pTxBuffer->mutex);
+    }
+
+    return setOptionInt(pSocket, U_SOCK_OPT_LEVEL_TCP,
+                        U_SOCK_OPT_TCP_NODELAY, pOptionValue,
+                        optionValueLength);
+}
+
 // Set hex mode on the underlying AT interface on or off.
 int32_t setHexMode(uDeviceHandle_t cellHandle, bool hexModeOnNotOff)
 {
@@ -677,6 +1568,8 @@ int32_t uCellSockInit()
             pSock->sockHandle = -1;
             pSock->sockHandleModule = -1;
             pSock->pendingBytes = 0;
+            memset(&(pSock->rxCache), 0, sizeof(pSock->rxCache));
+            memset(&(pSock->txBuffer), 0, sizeof(pSock->txBuffer));
             pSock->pDataCallback = NULL;
             pSock->pClosedCallback = NULL;
         }
@@ -717,9 +1610,29 @@ int32_t uCellSockInitInstance(uDeviceHandle_t cellHandle)
 // Deinitialise the cellular sockets layer.
 void uCellSockDeinit()
 {
+    uCellSockSocket_t *pSock;
+
     if (gInitialised) {
-        // Nothing to do, URCs will have been
-        // removed on close
+        // URCs will have been removed on close, just
+        // need to delete the receive cache and transmit
+        // buffer mutexes/timers that sockFree() leaves behind
+        for (size_t x = 0; (x < sizeof(gSockets) / sizeof(gSockets[0])); x++) {
+            pSock = &(gSockets[x]);
+            rxCacheFree(&(pSock->rxCache));
+            if (pSock->rxCache.mutex != NULL) {
+                uPortMutexDelete(pSock->rxCache.mutex);
+                pSock->rxCache.mutex = NULL;
+            }
+            txBufferFree(&(pSock->txBuffer));
+            if (pSock->txBuffer.timer != NULL) {
+                uPortTimerDelete(pSock->txBuffer.timer);
+                pSock->txBuffer.timer = NULL;
+            }
+            if (pSock->txBuffer.mutex != NULL) {
+                uPortMutexDelete(pSock->txBuffer.mutex);
+                pSock->txBuffer.mutex = NULL;
+            }
+        }
         gInitialised = false;
     }
 }
@@ -752,6 +1665,7 @@ int32_t uCellSockCreate(uDeviceHandle_t cellHandle,
             gNextSockHandle = 0;
         }
         if (pSocket != NULL) {
+            pSocket->protocol = protocol;
             // Create the socket in the cellular module
             uAtClientLock(atHandle);
             uAtClientCommandStart(atHandle, "AT+USOCR=");
@@ -769,6 +1683,22 @@ int32_t uCellSockCreate(uDeviceHandle_t cellHandle,
             if (uAtClientUnlock(atHandle) == 0) {
                 // All good
                 negErrnoLocal = pSocket->sockHandle;
+#if U_CELL_SOCK_RX_CACHE_SIZE_BYTES > 0
+                if (protocol == U_SOCK_PROTOCOL_TCP) {
+                    // Give the socket a receive cache; if there
+                    // isn't the memory for it the socket will
+                    // work without one
+                    rxCacheSizeSet(&(pSocket->rxCache),
+                                   U_CELL_SOCK_RX_CACHE_SIZE_BYTES);
+                }
+#endif
+#if U_CELL_SOCK_TX_BUFFER_SIZE_BYTES > 0
+                if (protocol == U_SOCK_PROTOCOL_TCP) {
+                    // Likewise a transmit buffer
+                    txBufferSizeSet(pInstance, pSocket,
+                                    U_CELL_SOCK_TX_BUFFER_SIZE_BYTES);
+                }
+#endif
             } else {
                 // Free the socket again
                 sockFree(pSocket->sockHandle);
@@ -858,6 +1788,7 @@ int32_t uCellSockClose(uDeviceHandle_t cellHandle,
     uCellSockSocket_t *pSocket;
     uAtClientDeviceError_t deviceError;
     int32_t atError = -1;
+    int32_t negErrnoTx = 0;
 
     // Find the instance
     pInstance = pUCellPrivateGetInstance(cellHandle);
@@ -868,6 +1799,33 @@ int32_t uCellSockClose(uDeviceHandle_t cellHandle,
             pSocket = pFindBySockHandle(sockHandle);
             if (pSocket != NULL) {
                 errnoLocal = U_SOCK_EIO;
+                if (pSocket->txBuffer.mutex != NULL) {
+                    // Send anything that is still buffered; whatever
+                    // the module won't take is lost, as is anything
+                    // lost earlier, and, if no write has yet said so,
+                    // the error is returned once the socket is closed
+                    // so that the application finds out
+                    U_PORT_MUTEX_LOCK(pSocket->txBuffer.mutex);
+                    negErrnoTx = txBufferFlush(pInstance, pSocket,
+                                               &(pSocket->txBuffer));
+                    if (pSocket->txBuffer.length > 0) {
+                        pSocket->txBuffer.length = 0;
+                        uPortTimerStop(pSocket->txBuffer.timer);
+                        if (pSocket->txBuffer.negErrno == 0) {
+                            if (negErrnoTx >= 0) {
+                                negErrnoTx = -U_SOCK_EIO;
+                            }
+                            pSocket->txBuffer.negErrno = negErrnoTx;
+                            pSocket->txBuffer.negErrnoReported = false;
+                        }
+                    }
+                    negErrnoTx = 0;
+                    if (!pSocket->txBuffer.negErrnoReported) {
+                        negErrnoTx = pSocket->txBuffer.negErrno;
+                        pSocket->txBuffer.negErrnoReported = true;
+                    }
+                    U_PORT_MUTEX_UNLOCK(pSocket->txBuffer.mutex);
+                }
                 // Close the socket through the cellular module
                 // If have seen modules return ERROR to this
                 // immediately so try a few times
@@ -901,8 +1859,8 @@ int32_t uCellSockClose(uDeviceHandle_t cellHandle,
                 }
 
                 if (atError == 0) {
-                    // All good
-                    errnoLocal = U_SOCK_ENONE;
+                    // All good, unless buffered data was lost
+                    errnoLocal = -negErrnoTx;
                     pSocket->pAsyncClosedCallback = pCallback;
                     if (pCallback == NULL) {
                         // If no callback was given, or one
@@ -997,6 +1955,19 @@ int32_t uCellSockOptionSet(uDeviceHandle_t cellHandle,
                                     errnoLocal = setOptionLinger(pSocket, pOptionValue,
                                                                  optionValueLength);
                                     break;
+                                // The receive buffer option which
+                                // sets the size of the receive cache
+                                case U_SOCK_OPT_RCVBUF:
+                                    errnoLocal = setOptionRxCache(pSocket, pOptionValue,
+                                                                  optionValueLength);
+                                    break;
+                                // The send buffer option which
+                                // sets the size of the transmit buffer
+                                case U_SOCK_OPT_SNDBUF:
+                                    errnoLocal = setOptionTxBuffer(pInstance, pSocket,
+                                                                   pOptionValue,
+                                                                   optionValueLength);
+                                    break;
                                 default:
                                     break;
                             }
@@ -1018,10 +1989,16 @@ int32_t uCellSockOptionSet(uDeviceHandle_t cellHandle,
                             break;
                         case U_SOCK_OPT_LEVEL_TCP:
                             switch (option) {
-                                // The supported options, both of
-                                // which have an integer as a
-                                // parameter
+                                // No-delay also controls the
+                                // transmit buffer
                                 case U_SOCK_OPT_TCP_NODELAY:
+                                    errnoLocal = setOptionNoDelay(pInstance, pSocket,
+                                                                  pOptionValue,
+                                                                  optionValueLength);
+                                    break;
+                                // The other supported option,
+                                // which has an integer as a
+                                // parameter
                                 case U_SOCK_OPT_TCP_KEEPIDLE:
                                     errnoLocal = setOptionInt(pSocket, level,
                                                               option, pOptionValue,
@@ -1083,6 +2060,18 @@ int32_t uCellSockOptionGet(uDeviceHandle_t cellHandle,
                                     errnoLocal = getOptionLinger(pSocket, pOptionValue,
                                                                  pOptionValueLength);
                                     break;
+                                // The receive buffer option which
+                                // gets the size of the receive cache
+                                case U_SOCK_OPT_RCVBUF:
+                                    errnoLocal = getOptionRxCache(pSocket, pOptionValue,
+                                                                  pOptionValueLength);
+                                    break;
+                                // The send buffer option which
+                                // gets the size of the transmit buffer
+                                case U_SOCK_OPT_SNDBUF:
+                                    errnoLocal = getOptionTxBuffer(pSocket, pOptionValue,
+                                                                   pOptionValueLength);
+                                    break;
                                 default:
                                     break;
                             }
@@ -1343,8 +2332,6 @@ int32_t uCellSockReceiveFrom(uDeviceHandle_t cellHandle,
     int32_t x;
     int32_t port = -1;
     int32_t receivedSize = -1;
-    int32_t readLength;
-    char *pHexBuffer = NULL;
 
     buffer[0] = 0;  // In case of slip-ups
 
@@ -1433,46 +2420,29 @@ int32_t uCellSockReceiveFrom(uDeviceHandle_t cellHandle,
                     }
                     if (receivedSize > 0) {
                         if (pInstance->socketsHexMode) {
-                            // In hex mode we need a buffer to dump
-                            // the hex into and then we can decode it
-                            negErrnoLocalOrSize = -U_SOCK_ENOMEM;
-                            //lint -e{647} Suppress suspicious truncation
-                            pHexBuffer = (char *) pUPortMalloc(receivedSize * 2 + 1);  // +1 for terminator
-                        }
-                        if (!pInstance->socketsHexMode || (pHexBuffer != NULL)) {
-                            if (pHexBuffer != NULL) {
-                                // In hex mode we can read in the whole string
-                                //lint -e{647} Suppress suspicious truncation
-                                readLength = uAtClientReadString(atHandle, pHexBuffer,
-                                                                 receivedSize * 2 + 1, false);
-                                if (readLength > 0) {
-                                    x = (int32_t) dataSizeBytes * 2;
-                                    if (readLength > x) {
-                                        readLength = x;
-                                    }
-                                    uHexToBin(pHexBuffer, readLength, (char *) pData);
-                                }
-                                // Free memory
-                                uPortFree(pHexBuffer);
-                            } else {
-                                // Binary mode, don't stop for anything!
-                                uAtClientIgnoreStopTag(atHandle);
-                                // Get the leading quote mark out of the way
-                                uAtClientReadBytes(atHandle, NULL, 1, true);
-                                // Now read out all the actual data,
-                                // first the bit we want
-                                uAtClientReadBytes(atHandle, (char *) pData,
+                            // In hex mode decode the hex string straight
+                            // into pData, anything beyond dataSizeBytes
+                            // being thrown away
+                            uAtClientReadHexData(atHandle, (char *) pData,
+                                                 dataSizeBytes);
+                        } else {
+                            // Binary mode, don't stop for anything!
+                            uAtClientIgnoreStopTag(atHandle);
+                            // Get the leading quote mark out of the way
+                            uAtClientReadBytes(atHandle, NULL, 1, true);
+                            // Now read out all the actual data,
+                            // first the bit we want
+                            uAtClientReadBytes(atHandle, (char *) pData,
+                                               dataSizeBytes, true);
+                            if (receivedSize > (int32_t) dataSizeBytes) {
+                                //...and then the rest poured away to NULL
+                                uAtClientReadBytes(atHandle, NULL,
+                                                   receivedSize -
                                                    dataSizeBytes, true);
-                                if (receivedSize > (int32_t) dataSizeBytes) {
-                                    //...and then the rest poured away to NULL
-                                    uAtClientReadBytes(atHandle, NULL,
-                                                       receivedSize -
-                                                       dataSizeBytes, true);
-                                }
-                                // Make sure to wait for the stop tag before
-                                // we finish
-                                uAtClientRestoreStopTag(atHandle);
                             }
+                            // Make sure to wait for the stop tag before
+                            // we finish
+                            uAtClientRestoreStopTag(atHandle);
                         }
                     }
                     uAtClientResponseStop(atHandle);
@@ -1528,120 +2498,24 @@ int32_t uCellSockWrite(uDeviceHandle_t cellHandle,
 {
     int32_t negErrnoLocalOrSize = -U_SOCK_EINVAL;
     uCellPrivateInstance_t *pInstance;
-    uAtClientHandle_t atHandle;
     uCellSockSocket_t *pSocket;
-    int32_t leftToSendSize = (int32_t) dataSizeBytes;
-    int32_t sentSize = 0;
-    int32_t dataOffset = 0;
-    int32_t thisSendSize = U_CELL_SOCK_MAX_SEGMENT_SIZE_BYTES;
-    size_t x = 0;
-    bool written = true;
-    char *pHexBuffer = NULL;
 
     // Find the instance
     pInstance = pUCellPrivateGetInstance(cellHandle);
     if (pInstance != NULL) {
-        atHandle = pInstance->atHandle;
-        if (pInstance->socketsHexMode) {
-            thisSendSize /= 2;
-            negErrnoLocalOrSize = -U_SOCK_ENOMEM;
-            pHexBuffer = (char *)pUPortMalloc(thisSendSize * 2 + 1); // +1 for terminator
-        }
         // Find the entry
         if (sockHandle >= 0) {
             pSocket = pFindBySockHandle(sockHandle);
             if (pSocket != NULL) {
-                if (!pInstance->socketsHexMode || (pHexBuffer != NULL)) {
-                    negErrnoLocalOrSize = U_SOCK_ENONE;
-                    x = 0;
-                    while ((leftToSendSize > 0) &&
-                           (negErrnoLocalOrSize == U_SOCK_ENONE) &&
-                           (x < U_CELL_SOCK_TCP_RETRY_LIMIT) &&
-                           written) {
-                        if (leftToSendSize < thisSendSize) {
-                            thisSendSize = leftToSendSize;
-                        }
-                        uAtClientLock(atHandle);
-                        uAtClientCommandStart(atHandle, "AT+USOWR=");
-                        // Write module socket handle
-                        uAtClientWriteInt(atHandle, pSocket->sockHandleModule);
-                        // Number of bytes to follow
-                        uAtClientWriteInt(atHandle, (int32_t) thisSendSize);
-                        written = false;
-                        if (pHexBuffer) {
-                            // Make the hex-coded null terminated string
-                            uBinToHex((const char *) pData + dataOffset,
-                                      thisSendSize, pHexBuffer);
-                            pHexBuffer[thisSendSize * 2] = 0;
-                            // Send the hex mode data as a string
-                            //lint -e(679) Suppress suspicious truncation
-                            uAtClientWriteString(atHandle, pHexBuffer, true);
-                            uAtClientCommandStop(atHandle);
-                            written = true;
-                        } else {
-                            uAtClientCommandStop(atHandle);
-                            // Wait for the prompt
-                            if (uAtClientWaitCharacter(atHandle, '@') == 0) {
-                                // Wait for it...
-                                uPortTaskBlock(50);
-                                // Go!
-                                uAtClientWriteBytes(atHandle,
-                                                    (const char *) pData + dataOffset,
-                                                    thisSendSize, true);
-                                written = true;
-                            }
-                        }
-                        if (written) {
-                            // Grab the response
-                            uAtClientResponseStart(atHandle, "+USOWR:");
-                            // Skip the socket ID
-                            uAtClientSkipParameters(atHandle, 1);
-                            // Bytes sent
-                            sentSize = uAtClientReadInt(atHandle);
-                            uAtClientResponseStop(atHandle);
-                            // Note: the sentSize check below is because we have seen cases
-                            // where the module returns just "OK", missing out the "+USOWR: x"
-                            // response; what to do when this happens?  The AT unlock check
-                            // will pass because it has been sent an "OK", but has the data
-                            // been sent or was the OK for a previous "AT" and we have somehow
-                            // or other become unsynchronised with the module? Gonna assume
-                            // the worst, that the data has not been sent.
-                            if (sentSize < 0) {
-                                sentSize = 0;
-                            }
-                            if (uAtClientUnlock(atHandle) == 0) {
-                                dataOffset += sentSize;
-                                leftToSendSize -= sentSize;
-                                // Technically, it should be OK to
-                                // send fewer bytes than asked for,
-                                // however if this happens a lot we'll
-                                // get stuck, which isn't desirable,
-                                // so use the loop counter to avoid that
-                                if (sentSize < thisSendSize) {
-                                    x++;
-                                }
-                            } else {
-                                negErrnoLocalOrSize = -U_SOCK_EIO;
-                                // Got an AT interface error, see
-                                // what the module's socket error
-                                // number has to say for debug purposes
-                                doUsoer(atHandle);
-                            }
-                        } else {
-                            negErrnoLocalOrSize = -U_SOCK_EIO;
-                            uAtClientUnlock(atHandle);
-                        }
-                    }
+                if (pSocket->txBuffer.mutex != NULL) {
+                    negErrnoLocalOrSize = writeBuffered(pInstance, pSocket, sockHandle,
+                                                        pData, dataSizeBytes);
+                } else {
+                    negErrnoLocalOrSize = writeModule(pInstance, pSocket,
+                                                      pData, dataSizeBytes);
                 }
             }
         }
-        // Free the buffer
-        uPortFree(pHexBuffer);
-    }
-
-    if (negErrnoLocalOrSize == U_SOCK_ENONE) {
-        // All is good
-        negErrnoLocalOrSize = ((int32_t) dataSizeBytes) - leftToSendSize;
     }
 
     return negErrnoLocalOrSize;
@@ -1654,165 +2528,26 @@ int32_t uCellSockRead(uDeviceHandle_t cellHandle,
 {
     int32_t negErrnoLocalOrSize = -U_SOCK_EINVAL;
     uCellPrivateInstance_t *pInstance;
-    uAtClientHandle_t atHandle;
     uCellSockSocket_t *pSocket;
-    int32_t dataLengthMax = U_CELL_SOCK_MAX_SEGMENT_SIZE_BYTES;
-    int32_t x = -1;
-    int32_t thisWantedReceiveSize;
-    int32_t thisActualReceiveSize;
-    int32_t totalReceivedSize = 0;
-    int32_t readLength;
-    char *pHexBuffer = NULL;
 
     // Find the instance
     pInstance = pUCellPrivateGetInstance(cellHandle);
     if (pInstance != NULL) {
-        atHandle = pInstance->atHandle;
-        if (pInstance->socketsHexMode) {
-            dataLengthMax /= 2;
-        }
         // Find the entry
         if (sockHandle >= 0) {
             pSocket = pFindBySockHandle(sockHandle);
             if (pSocket != NULL) {
-                negErrnoLocalOrSize = -U_SOCK_EWOULDBLOCK;
-                if (pSocket->pendingBytes == 0) {
-                    // If the URC has not filled in pendingBytes,
-                    // ask the module directly if there is anything
-                    // to read
-                    uAtClientLock(atHandle);
-                    uAtClientCommandStart(atHandle, "AT+USORD=");
-                    uAtClientWriteInt(atHandle, pSocket->sockHandleModule);
-                    // Zero bytes to read, just want to know the number
-                    // of bytes waiting
-                    uAtClientWriteInt(atHandle, 0);
-                    uAtClientCommandStop(atHandle);
-                    uAtClientResponseStart(atHandle, "+USORD:");
-                    // Skip the socket ID
-                    uAtClientSkipParameters(atHandle, 1);
-                    // Read the amount of data
-                    x = uAtClientReadInt(atHandle);
-                    uAtClientResponseStop(atHandle);
-                    // Update pending bytes here, before
-                    // unlocking, as otherwise a data callback
-                    // triggered by a URC could be sitting waiting
-                    // to grab the AT lock and jump in before
-                    // pending bytes has been updated, leading it
-                    // back into here again, etc, etc.
-                    if (x > 0) {
-                        pSocket->pendingBytes = x;
-                        // DON'T call the user data callback here:
-                        // we already have the AT interface locked
-                        // and a user might try to call back into
-                        // here which would result in deadlock.
-                        // They will get their received data, there
-                        // is no need to worry.
-                    }
-                    uAtClientUnlock(atHandle);
-                }
-                if (pSocket->pendingBytes > 0) {
-                    negErrnoLocalOrSize = U_SOCK_ENONE;
-                    // Run around the loop until we run out of
-                    // pending data or room in the buffer
-                    while ((dataSizeBytes > 0) &&
-                           (pSocket->pendingBytes > 0) &&
-                           (negErrnoLocalOrSize == U_SOCK_ENONE)) {
-                        thisWantedReceiveSize = dataLengthMax;
-                        if (thisWantedReceiveSize > (int32_t) dataSizeBytes) {
-                            thisWantedReceiveSize = (int32_t) dataSizeBytes;
-                        }
-                        uAtClientLock(atHandle);
-                        uAtClientCommandStart(atHandle, "AT+USORD=");
-                        uAtClientWriteInt(atHandle, pSocket->sockHandleModule);
-                        // Number of bytes to read
-                        uAtClientWriteInt(atHandle, thisWantedReceiveSize);
-                        uAtClientCommandStop(atHandle);
-                        uAtClientResponseStart(atHandle, "+USORD:");
-                        // Skip the socket ID
-                        uAtClientSkipParameters(atHandle, 1);
-                        // Read the amount of data
-                        thisActualReceiveSize = uAtClientReadInt(atHandle);
-                        if (thisActualReceiveSize > (int32_t) dataSizeBytes) {
-                            thisActualReceiveSize = (int32_t) dataSizeBytes;
-                        }
-                        if (thisActualReceiveSize > 0) {
-                            if (pInstance->socketsHexMode) {
-                                // In hex mode we need a buffer to dump
-                                // the hex into and then we can decode it
-                                negErrnoLocalOrSize = -U_SOCK_ENOMEM;
-                                //lint -e{647} Suppress suspicious truncation
-                                pHexBuffer = (char *) pUPortMalloc(thisActualReceiveSize * 2 + 1);  // +1 for terminator
-                            }
-                            if (!pInstance->socketsHexMode || (pHexBuffer != NULL)) {
-                                negErrnoLocalOrSize = U_SOCK_ENONE;
-                                if (pHexBuffer != NULL) {
-                                    // In hex mode we can read in the whole string
-                                    //lint -e{647} Suppress suspicious truncation
-                                    readLength = uAtClientReadString(atHandle, pHexBuffer,
-                                                                     thisActualReceiveSize * 2 + 1,
-                                                                     false);
-                                    if (readLength > 0) {
-                                        x = ((int32_t) dataSizeBytes) * 2;
-                                        if (readLength > x) {
-                                            readLength = x;
-                                        }
-                                        uHexToBin(pHexBuffer, readLength,
-                                                  (char *) pData + totalReceivedSize);
-                                    }
-                                    // Free memory
-                                    uPortFree(pHexBuffer);
-                                } else {
-                                    // Binary mode, don't stop for anything!
-                                    uAtClientIgnoreStopTag(atHandle);
-                                    // Get the leading quote mark out of the way
-                                    uAtClientReadBytes(atHandle, NULL, 1, true);
-                                    // Now read out the available data
-                                    uAtClientReadBytes(atHandle,
-                                                       (char *) pData +
-                                                       totalReceivedSize,
-                                                       thisActualReceiveSize, true);
-                                    // Make sure we wait for the stop tag before
-                                    // going around again
-                                    uAtClientRestoreStopTag(atHandle);
-                                }
-                            }
-                        }
-                        uAtClientResponseStop(atHandle);
-                        // BEFORE unlocking, work out what's happened.
-                        // This is to prevent a URC being processed that
-                        // may indicate data left and over-write pendingBytes
-                        // while we're also writing to it.
-                        if ((uAtClientErrorGet(atHandle) == 0) &&
-                            (thisActualReceiveSize >= 0)) {
-                            // Must use what +USORD returns here as it may be less
-                            // or more than we asked for and also may be
-                            // more than pendingBytes, depending on how
-                            // the URCs landed
-                            // This update of pendingBytes will be overwritten
-                            // by the URC but we have to do something here
-                            // 'cos we don't get a URC to tell us when pendingBytes
-                            // has gone to zero.
-                            if (thisActualReceiveSize > pSocket->pendingBytes) {
-                                pSocket->pendingBytes = 0;
-                            } else {
-                                pSocket->pendingBytes -= thisActualReceiveSize;
-                            }
-                            totalReceivedSize += thisActualReceiveSize;
-                            dataSizeBytes -= thisActualReceiveSize;
-                        } else {
-                            negErrnoLocalOrSize = -U_SOCK_EIO;
-                        }
-                        uAtClientUnlock(atHandle);
-                    }
+                if (pSocket->rxCache.mutex != NULL) {
+                    negErrnoLocalOrSize = readCached(pInstance, pSocket, sockHandle,
+                                                     pData, dataSizeBytes);
+                } else {
+                    negErrnoLocalOrSize = readModule(pInstance, pSocket,
+                                                     pData, dataSizeBytes);
                 }
             }
         }
     }
 
-    if (totalReceivedSize > 0) {
-        negErrnoLocalOrSize = totalReceivedSize;
-    }
-
     return negErrnoLocalOrSize;
 }
 
@@ -2089,7 +2824,13 @@ int32_t uCellSockGetBytesPending(uDeviceHandle_t cellHandle,
             pSocket = pFindBySockHandle(sockHandle);
             if (pSocket != NULL) {
                 // Return the value we have stored based on URCs
+                // plus anything waiting in the receive cache
                 negErrnoLocalOrSize = pSocket->pendingBytes;
+                if (pSocket->rxCache.mutex != NULL) {
+                    U_PORT_MUTEX_LOCK(pSocket->rxCache.mutex);
+                    negErrnoLocalOrSize += (int32_t) pSocket->rxCache.length;
+                    U_PORT_MUTEX_UNLOCK(pSocket->rxCache.mutex);
+                }
             }
         }
     }
@@ -2097,4 +2838,36 @@ int32_t uCellSockGetBytesPending(uDeviceHandle_t cellHandle,
     return negErrnoLocalOrSize;
 }
 
+// Get the statistics of the receive cache of a socket.
+int32_t uCellSockRxCacheStatsGet(uDeviceHandle_t cellHandle,
+                                 int32_t sockHandle,
+                                 uCellSockRxCacheStats_t *pStats)
+{
+    int32_t errnoLocal = U_SOCK_EINVAL;
+    uCellPrivateInstance_t *pInstance;
+    uCellSockSocket_t *pSocket;
+
+    // Find the instance
+    pInstance = pUCellPrivateGetInstance(cellHandle);
+    if ((pInstance != NULL) && (pStats != NULL)) {
+        // Find the entry
+        if (sockHandle >= 0) {
+            pSocket = pFindBySockHandle(sockHandle);
+            if (pSocket != NULL) {
+                errnoLocal = U_SOCK_ENOBUFS;
+                if (pSocket->rxCache.mutex != NULL) {
+                    U_PORT_MUTEX_LOCK(pSocket->rxCache.mutex);
+                    if (pSocket->rxCache.pBuffer != NULL) {
+                        *pStats = pSocket->rxCache.stats;
+                        errnoLocal = U_SOCK_ENONE;
+                    }
+                    U_PORT_MUTEX_UNLOCK(pSocket->rxCache.mutex);
+                }
+            }
+        }
+    }
+
+    return -errnoLocal;
+}
+
 // End of file
@@ -56,6 +56,7 @@
 
 #include "u_at_client.h"
 
+#include "u_sock_errno.h" // For U_SOCK_ENOBUFS and U_SOCK_ENOSYS
 #include "u_sock.h"
 
 #include "u_cell_module_type.h"
@@ -433,6 +434,115 @@ static void checkOptionSet(uDeviceHandle_t cellHandle, int32_t sockHandle,
     uPortFree(pValueRead);
 }
 
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS: TRANSMIT BUFFER
+ * -------------------------------------------------------------- */
+
+// Return the number of AT+USOWR commands the AT client has sent
+// since its metrics were switched on.
+static int32_t getNumUsowr()
+{
+    uAtClientMetrics_t *pMetrics;
+    int32_t numUsowr = 0;
+
+    pMetrics = (uAtClientMetrics_t *) pUPortMalloc(sizeof(*pMetrics));
+    U_PORT_TEST_ASSERT(pMetrics != NULL);
+    U_PORT_TEST_ASSERT(uAtClientMetricsGet(gHandles.atClientHandle,
+                                           pMetrics) == 0);
+    for (size_t x = 0; x < pMetrics->numCommands; x++) {
+        if (strcmp(pMetrics->command[x].prefix, "AT+USOWR") == 0) {
+            numUsowr = pMetrics->command[x].count;
+        }
+    }
+    uPortFree(pMetrics);
+
+    return numUsowr;
+}
+
+// Write numWrites chunks of writeSize bytes to the given TCP
+// socket, which has a transmit buffer and is connected to an echo
+// server, check that nothing goes to the module until the flush
+// timer goes off and that everything then goes in a single
+// AT+USOWR, and read the echo back into pBuffer, which must be
+// big enough for it.
+static void checkTxBufferWrites(uDeviceHandle_t cellHandle,
+                                int32_t sockHandle, char *pBuffer,
+                                int32_t numWrites, int32_t writeSize)
+{
+    int32_t numUsowr;
+    int32_t y = 0;
+    int32_t z;
+
+    // Switching metrics on resets them
+    U_PORT_TEST_ASSERT(uAtClientMetricsOn(gHandles.atClientHandle) == 0);
+    U_TEST_PRINT_LINE("writing %d chunk(s) of %d byte(s)...",
+                      numWrites, writeSize);
+    for (int32_t x = 0; x < numWrites; x++) {
+        U_PORT_TEST_ASSERT(uCellSockWrite(cellHandle, sockHandle,
+                                          gAllChars + (x * writeSize),
+                                          writeSize) == writeSize);
+    }
+    // Nothing should have gone to the module yet: the writes
+    // are far smaller than a segment and the flush timer, which
+    // was started by the first of them, can't have gone off
+    numUsowr = getNumUsowr();
+    U_TEST_PRINT_LINE("%d AT+USOWR before the flush timer.", numUsowr);
+    U_PORT_TEST_ASSERT(numUsowr == 0);
+    // Give the flush timer time to go off
+    uPortTaskBlock(U_CELL_SOCK_TX_BUFFER_FLUSH_MS + 1000);
+    numUsowr = getNumUsowr();
+    uAtClientMetricsOff(gHandles.atClientHandle);
+    U_TEST_PRINT_LINE("%d write(s) went out in %d AT+USOWR.",
+                      numWrites, numUsowr);
+    U_PORT_TEST_ASSERT(numUsowr == 1);
+
+    // Get the echo back, which also shows that the data
+    // got to the echo server, out of the way of what follows
+    memset(pBuffer, 0, numWrites * writeSize);
+    for (size_t x = 0; (x < 20) && (y < numWrites * writeSize); x++) {
+        z = uCellSockRead(cellHandle, sockHandle, pBuffer + y,
+                          (numWrites * writeSize) - y);
+        if (z > 0) {
+            y += z;
+        } else {
+            uPortTaskBlock(500);
+        }
+    }
+    U_PORT_TEST_ASSERT(y == numWrites * writeSize);
+    U_PORT_TEST_ASSERT(memcmp(pBuffer, gAllChars, y) == 0);
+}
+
+// If the given TCP socket, connected to an echo server, has a
+// transmit buffer, check that several small writes go to the
+// module as a single AT+USOWR and that a lone small write is sent
+// when the flush timer goes off.
+static void checkTxBufferCoalesce(uDeviceHandle_t cellHandle,
+                                  int32_t sockHandle, char *pBuffer)
+{
+    int32_t sndBuf = 0;
+    size_t length = sizeof(sndBuf);
+    int32_t numWrites = 4;
+    int32_t writeSize = 10;
+
+    U_PORT_TEST_ASSERT(uCellSockOptionGet(cellHandle, sockHandle,
+                                          U_SOCK_OPT_LEVEL_SOCK,
+                                          U_SOCK_OPT_SNDBUF,
+                                          (void *) &sndBuf, &length) == 0);
+    if (sndBuf < numWrites * writeSize) {
+        U_TEST_PRINT_LINE("no transmit buffer, not checking coalescing.");
+    } else if (uAtClientMetricsOn(gHandles.atClientHandle) != 0) {
+        U_TEST_PRINT_LINE("AT client metrics not available, not checking"
+                          " coalescing.");
+    } else {
+        // Several small writes
+        checkTxBufferWrites(cellHandle, sockHandle, pBuffer,
+                            numWrites, writeSize);
+        // A lone small write, sent only by the flush timer
+        checkTxBufferWrites(cellHandle, sockHandle, pBuffer,
+                            1, writeSize);
+    }
+}
+
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS: CALLBACKS
  * -------------------------------------------------------------- */
@@ -535,6 +645,8 @@ U_PORT_TEST_FUNCTION("[cellSock]", "cellSockBasic")
     int32_t w;
     int32_t z;
     size_t count;
+    size_t length;
+    uCellSockRxCacheStats_t rxCacheStats;
     char *pBuffer;
     int32_t heapUsed;
 
@@ -734,14 +846,47 @@ U_PORT_TEST_FUNCTION("[cellSock]", "cellSockBasic")
     U_PORT_TEST_ASSERT(uCellSockHexModeOff(cellHandle) == 0);
     U_PORT_TEST_ASSERT(!uCellSockHexModeIsOn(cellHandle));
 
-    // Do this twice: once with binary mode and once with hex mode
-    for (size_t a = 0; a < 2; a++) {
+    // Do this three times: once with binary mode, once with hex
+    // mode and once with binary mode, a receive cache and, if the
+    // platform supports timers, a transmit buffer
+    for (size_t a = 0; a < 3; a++) {
         gDataCallbackCalledTcp = false;
         if (a == 0) {
             U_PORT_TEST_ASSERT(!uCellSockHexModeIsOn(cellHandle));
-        } else {
+        } else if (a == 1) {
             U_PORT_TEST_ASSERT(uCellSockHexModeOn(cellHandle) == 0);
             U_PORT_TEST_ASSERT(uCellSockHexModeIsOn(cellHandle));
+        } else {
+            U_PORT_TEST_ASSERT(uCellSockHexModeOff(cellHandle) == 0);
+            U_PORT_TEST_ASSERT(!uCellSockHexModeIsOn(cellHandle));
+            y = U_CELL_SOCK_MAX_SEGMENT_SIZE_BYTES;
+            U_PORT_TEST_ASSERT(uCellSockOptionSet(cellHandle, gSockHandleTcp,
+                                                  U_SOCK_OPT_LEVEL_SOCK,
+                                                  U_SOCK_OPT_RCVBUF,
+                                                  (void *) &y, sizeof(y)) == 0);
+            y = 0;
+            length = sizeof(y);
+            U_PORT_TEST_ASSERT(uCellSockOptionGet(cellHandle, gSockHandleTcp,
+                                                  U_SOCK_OPT_LEVEL_SOCK,
+                                                  U_SOCK_OPT_RCVBUF,
+                                                  (void *) &y, &length) == 0);
+            U_PORT_TEST_ASSERT(length == sizeof(y));
+            U_PORT_TEST_ASSERT(y == U_CELL_SOCK_MAX_SEGMENT_SIZE_BYTES);
+            y = U_CELL_SOCK_MAX_SEGMENT_SIZE_BYTES;
+            z = uCellSockOptionSet(cellHandle, gSockHandleTcp,
+                                   U_SOCK_OPT_LEVEL_SOCK,
+                                   U_SOCK_OPT_SNDBUF,
+                                   (void *) &y, sizeof(y));
+            U_PORT_TEST_ASSERT((z == 0) || (z == -U_SOCK_ENOSYS));
+            if (z == 0) {
+                y = 0;
+                length = sizeof(y);
+                U_PORT_TEST_ASSERT(uCellSockOptionGet(cellHandle, gSockHandleTcp,
+                                                      U_SOCK_OPT_LEVEL_SOCK,
+                                                      U_SOCK_OPT_SNDBUF,
+                                                      (void *) &y, &length) == 0);
+                U_PORT_TEST_ASSERT(y == U_CELL_SOCK_MAX_SEGMENT_SIZE_BYTES);
+            }
         }
         // Send the TCP echo data in random sized chunks
         U_TEST_PRINT_LINE("sending %d byte(s) to %s:%d in random sized"
@@ -813,6 +958,39 @@ U_PORT_TEST_FUNCTION("[cellSock]", "cellSockBasic")
         U_PORT_TEST_ASSERT(memcmp(pBuffer, gAllChars,
                                   sizeof(gAllChars)) == 0);
         U_PORT_TEST_ASSERT(!gClosedCallbackCalledTcp);
+        if (a == 2) {
+            // Check the receive cache statistics: everything
+            // must have come through the receive cache
+            U_PORT_TEST_ASSERT(uCellSockRxCacheStatsGet(cellHandle,
+                                                        gSockHandleTcp,
+                                                        &rxCacheStats) == 0);
+            U_TEST_PRINT_LINE("receive cache: %d read(s), %d hit(s), %d fill(s)"
+                              " of %d byte(s) in total, %d byte(s) direct.",
+                              rxCacheStats.readCount, rxCacheStats.readHitCount,
+                              rxCacheStats.fillCount, rxCacheStats.bytesFilled,
+                              rxCacheStats.bytesDirect);
+            U_PORT_TEST_ASSERT(rxCacheStats.readCount > 0);
+            U_PORT_TEST_ASSERT(rxCacheStats.bytesFilled + rxCacheStats.bytesDirect ==
+                               sizeof(gAllChars));
+            // Check that small writes are coalesced
+            checkTxBufferCoalesce(cellHandle, gSockHandleTcp, pBuffer);
+            // Switch the receive cache off again
+            y = 0;
+            U_PORT_TEST_ASSERT(uCellSockOptionSet(cellHandle, gSockHandleTcp,
+                                                  U_SOCK_OPT_LEVEL_SOCK,
+                                                  U_SOCK_OPT_RCVBUF,
+                                                  (void *) &y, sizeof(y)) == 0);
+            U_PORT_TEST_ASSERT(uCellSockRxCacheStatsGet(cellHandle,
+                                                        gSockHandleTcp,
+                                                        &rxCacheStats) == -U_SOCK_ENOBUFS);
+            // Switch the transmit buffer off, which is always allowed
+            // here since everything written has been echoed
+            y = 0;
+            U_PORT_TEST_ASSERT(uCellSockOptionSet(cellHandle, gSockHandleTcp,
+                                                  U_SOCK_OPT_LEVEL_SOCK,
+                                                  U_SOCK_OPT_SNDBUF,
+                                                  (void *) &y, sizeof(y)) == 0);
+        }
     }
 
     // Sockets should both still be open
@@ -397,6 +397,37 @@ extern "C" {
 # define U_AT_CLIENT_ACTIVITY_PIN_HYSTERESIS_INTERVAL_MS 10
 #endif
 
+#ifndef U_AT_CLIENT_METRICS_MAX_NUM_COMMANDS
+/** The maximum number of different AT commands that the metrics
+ * of an AT client can keep track of, only relevant if
+ * U_CFG_AT_CLIENT_METRICS is defined.
+ */
+# define U_AT_CLIENT_METRICS_MAX_NUM_COMMANDS 16
+#endif
+
+#ifndef U_AT_CLIENT_METRICS_MAX_NUM_URCS
+/** The maximum number of different URCs that the metrics
+ * of an AT client can keep track of, only relevant if
+ * U_CFG_AT_CLIENT_METRICS is defined.
+ */
+# define U_AT_CLIENT_METRICS_MAX_NUM_URCS 16
+#endif
+
+#ifndef U_AT_CLIENT_METRICS_PREFIX_MAX_LENGTH_BYTES
+/** The maximum length of the command or URC prefix stored in
+ * the metrics, not including the null terminator; longer
+ * prefixes are truncated.
+ */
+# define U_AT_CLIENT_METRICS_PREFIX_MAX_LENGTH_BYTES 15
+#endif
+
+/** The number of latency buckets in #uAtClientMetricsCommand_t:
+ * bucket 0 counts latencies of 0 ms and bucket n counts latencies
+ * from 2^(n-1) to (2^n) - 1 ms, the last bucket also counting
+ * everything longer.
+ */
+#define U_AT_CLIENT_METRICS_NUM_LATENCY_BUCKETS 16
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -433,6 +464,69 @@ typedef struct {
     int32_t code;
 } uAtClientDeviceError_t;
 
+/** The metrics for one AT command, see uAtClientMetricsGet().
+ * Latency is the time from uAtClientCommandStart() to the final
+ * result (e.g. "OK") having been read.
+ */
+typedef struct {
+    char prefix[U_AT_CLIENT_METRICS_PREFIX_MAX_LENGTH_BYTES + 1]; /**< the AT
+                                                                       command up to
+                                                                       any '=' or '?',
+                                                                       e.g. "AT+CSQ". */
+    int32_t count;          /**< the number of times the command was sent. */
+    int32_t errorCount;     /**< the number of times the command failed,
+                                 including timeouts. */
+    int32_t timeoutCount;   /**< the number of times the command timed out. */
+    int32_t latencyMinMs;   /**< the shortest latency. */
+    int32_t latencyMaxMs;   /**< the longest latency. */
+    int64_t latencyTotalMs; /**< the sum of all latencies; divide by count
+                                 for the mean. */
+    int32_t latencyBucket[U_AT_CLIENT_METRICS_NUM_LATENCY_BUCKETS]; /**< a histogram
+                                                                         of latencies,
+                                                                         see
+                                                                         uAtClientMetricsLatencyPercentileMs(). */
+} uAtClientMetricsCommand_t;
+
+/** The metrics for one URC, see uAtClientMetricsGet().
+ */
+typedef struct {
+    char prefix[U_AT_CLIENT_METRICS_PREFIX_MAX_LENGTH_BYTES + 1]; /**< the URC prefix,
+                                                                       e.g. "+CEREG:". */
+    int32_t count;              /**< the number of times the URC was received. */
+    int32_t handlerTimeTotalMs; /**< the total time spent in the URC handler. */
+    int32_t handlerTimeMaxMs;   /**< the longest time spent in the URC handler. */
+} uAtClientMetricsUrc_t;
+
+/** The metrics of an AT client, see uAtClientMetricsGet().
+ */
+typedef struct {
+    int32_t durationMs;       /**< how long metrics have been collected for. */
+    int64_t bytesIn;          /**< the number of bytes received, after any
+                                   intercept function. */
+    int64_t bytesOut;         /**< the number of bytes sent, before any
+                                   intercept function. */
+    int32_t timeoutCount;     /**< the number of AT timeouts. */
+    int32_t urcTimeTotalMs;   /**< the total time spent in URC handlers. */
+    int32_t streamLockCount;  /**< the number of times the stream was locked
+                                   with uAtClientLock(). */
+    int32_t streamLockContendedCount; /**< the number of times uAtClientLock()
+                                           had to wait for the stream. */
+    int32_t streamLockWaitTotalMs;    /**< the total time uAtClientLock()
+                                           spent waiting for the stream. */
+    int32_t commandUntrackedCount; /**< the number of commands sent that could
+                                        not be tracked because the command
+                                        table was full. */
+    int32_t urcUntrackedCount;     /**< the number of URCs received that could
+                                        not be tracked because the URC table
+                                        was full. */
+    size_t numCommands;       /**< the number of entries used in command[]. */
+    uAtClientMetricsCommand_t command[U_AT_CLIENT_METRICS_MAX_NUM_COMMANDS]; /**< per
+                                                                                  command
+                                                                                  metrics. */
+    size_t numUrcs;           /**< the number of entries used in urc[]. */
+    uAtClientMetricsUrc_t urc[U_AT_CLIENT_METRICS_MAX_NUM_URCS]; /**< per URC metrics. */
+} uAtClientMetrics_t;
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS: INITIALISATION AND CONFIGURATION
  * -------------------------------------------------------------- */
@@ -651,6 +745,36 @@ int32_t uAtClientDelayGet(const uAtClientHandle_t atHandle);
 void uAtClientDelaySet(uAtClientHandle_t atHandle,
                        int32_t delayMs);
 
+/** Make the delay between ending one AT command and starting
+ * the next adaptive.  The delay set with uAtClientDelaySet()
+ * remains the maximum: each time an AT command completes
+ * without error the delay in use is reduced by 1 ms, down to
+ * a minimum of delayMinMs, while any error or timeout puts it
+ * straight back to the maximum.  This is useful at high baud
+ * rates, where the fixed delay can dominate the time taken by
+ * short AT commands.  The delay is not adaptive by default;
+ * if uAtClientDelaySet() is called the adaptive delay starts
+ * again from the new maximum.
+ *
+ * @param atHandle    the handle of the AT client.
+ * @param delayMinMs  the minimum delay in milliseconds; use -1
+ *                    (or any value not less than the delay set
+ *                    with uAtClientDelaySet()) to switch the
+ *                    adaptive delay off.
+ */
+void uAtClientDelayAdaptiveSet(uAtClientHandle_t atHandle,
+                               int32_t delayMinMs);
+
+/** Get the delay between ending one AT command and starting
+ * the next that is currently in use; this is the same as the
+ * value returned by uAtClientDelayGet() unless
+ * uAtClientDelayAdaptiveSet() has been called.
+ *
+ * @param atHandle  the handle of the AT client.
+ * @return          the delay in milliseconds.
+ */
+int32_t uAtClientDelayAdaptiveGet(const uAtClientHandle_t atHandle);
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS: SEND AN AT COMMAND
  * -------------------------------------------------------------- */
@@ -974,6 +1098,63 @@ int32_t uAtClientReadBytes(uAtClientHandle_t atHandle,
                            char *pBuffer, size_t lengthBytes,
                            bool standalone);
 
+/** Read the given number of bytes from the received AT response
+ * stream without copying them: pCallback is called with each
+ * contiguous span of the bytes as it sits in the receive buffer
+ * of the AT client; there will be one call if all of the bytes are
+ * already in the receive buffer, more if they have to be read in
+ * from the stream in stages.  This is intended for binary data
+ * of known length (e.g. the payload of an IP socket read) that
+ * is to be passed directly to its destination.  The stop tag is
+ * NOT looked for, as if uAtClientIgnoreStopTag() had been called,
+ * and the bytes are taken to form a standalone sequence (see the
+ * standalone parameter of uAtClientReadBytes()).
+ *
+ * IMPORTANT: pCallback is called with the AT client locked and
+ * must NOT call back into the AT client; the span it is given
+ * is only valid for the duration of the call.
+ *
+ * @param atHandle      the handle of the AT client.
+ * @param lengthBytes   the number of bytes to read.
+ * @param[in] pCallback the function to call with each span; may be
+ *                      NULL, in which case the bytes are thrown away.
+ * @param[in] pParam    a parameter that will be passed to pCallback
+ *                      as its last parameter; may be NULL.
+ * @return              the number of bytes read or negative
+ *                      error code.
+ */
+int32_t uAtClientReadBytesSpan(uAtClientHandle_t atHandle,
+                               size_t lengthBytes,
+                               void (*pCallback) (const char *pSpan,
+                                                  size_t length,
+                                                  void *pParam),
+                               void *pParam);
+
+/** Read a parameter that is a string of hex digits (quoted or not,
+ * e.g. `"DEADBEEF"`) from the received AT response stream and
+ * decode it, as it is read, into binary; this avoids the need for
+ * an intermediate buffer for the hex string.  The decoded data is
+ * written to pBuffer up to lengthBytes, any more is thrown away.
+ * As for uAtClientReadString(), reading continues until the
+ * delimiter or the stop tag is found; the stop tag is not looked
+ * for within quotes and characters that are not hex digits are
+ * ignored, so the stop tag must not itself contain hex digits.
+ *
+ * @param atHandle      the handle of the AT client.
+ * @param[out] pBuffer  a buffer in which to place the decoded
+ *                      binary data.  May be set to NULL in which
+ *                      case the data is thrown away.
+ * @param lengthBytes   the maximum number of bytes to decode into
+ *                      pBuffer.
+ * @return              the number of bytes decoded into pBuffer (or
+ *                      that would have been, if pBuffer is NULL),
+ *                      or negative error code if a read timeout
+ *                      occurs before the delimiter or the stop tag
+ *                      is found.
+ */
+int32_t uAtClientReadHexData(uAtClientHandle_t atHandle,
+                             char *pBuffer, size_t lengthBytes);
+
 /** Marks the end of an AT response, should be called
  * after uAtClientResponseStart() when all of the
  * wanted parameters have been read.  The remainder of
@@ -1088,6 +1269,10 @@ int32_t uAtClientWaitCharacter(uAtClientHandle_t atHandle,
  * uAtClientUrcHandlerGetFirst() / uAtClientUrcHandlerGetNext()
  * functions.
  *
+ * IMPORTANT: do not call this from a URC handler, since it
+ * has to lock the AT stream; if you need to do that then
+ * have your handler call uAtClientCallback().
+ *
  * @param atHandle           the handle of the AT client.
  * @param[in] pPrefix        the prefix for the URC. A prefix might
  *                           for example be "+CEREG:".
@@ -1111,6 +1296,10 @@ int32_t uAtClientSetUrcHandler(uAtClientHandle_t atHandle,
  * when you know that atHandle is not going to be pulled out
  * from underneath it.
  *
+ * IMPORTANT: do not call this from a URC handler, since it
+ * has to lock the AT stream; if you need to do that then
+ * have your handler call uAtClientCallback().
+ *
  * @param atHandle     the handle of the AT client.
  * @param[in] pPrefix  the prefix for the URC, which would have been
  *                     set in a call to uAtClientSetUrcHandler().
@@ -1494,6 +1683,21 @@ void uAtClientStreamInterceptRx(uAtClientHandle_t atHandle,
                                                     void *),
                                 void *pContext);
 
+/** Get whether a transmit or receive intercept function, see
+ * uAtClientStreamInterceptTx() and uAtClientStreamInterceptRx(),
+ * is currently installed.  Since there can only be one of each,
+ * code that wants to install an intercept of its own can use
+ * this to avoid displacing someone else's (e.g. that of an EDM
+ * stream).  As for the functions that install an intercept, this
+ * function should only be called when the AT client has been
+ * locked (with uAtClientLock()) if the answer is to remain valid.
+ *
+ * @param atHandle  the handle of the AT client.
+ * @return          true if a transmit or receive intercept
+ *                  function is installed, else false.
+ */
+bool uAtClientStreamInterceptIsSet(uAtClientHandle_t atHandle);
+
 /** Set a wake-up handler function.  This is useful where the
  * other end of the link is a module which may go to sleep
  * to save power and require some specific handling to recover
@@ -1617,6 +1821,64 @@ int32_t uAtClientGetActivityPinSettings(const uAtClientHandle_t atHandle,
                                         int32_t *pReadyMs, int32_t *pHysteresisMs,
                                         bool *pHighIsOn);
 
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS: METRICS
+ * -------------------------------------------------------------- */
+
+/** Start collecting metrics for an AT client: per AT command counts
+ * and latencies, per URC counts and handler times, bytes in/out,
+ * timeouts and stream lock contention.  If metrics are already being
+ * collected they are reset.  Metrics are only available if
+ * U_CFG_AT_CLIENT_METRICS is defined; they take a little over 2 kbytes of
+ * heap, with the default table sizes, while switched on.
+ *
+ * @param atHandle  the handle of the AT client.
+ * @return          zero on success else negative error code;
+ *                  #U_ERROR_COMMON_NOT_SUPPORTED if
+ *                  U_CFG_AT_CLIENT_METRICS is not defined.
+ */
+int32_t uAtClientMetricsOn(uAtClientHandle_t atHandle);
+
+/** Stop collecting metrics for an AT client and free the memory
+ * they occupied.
+ *
+ * @param atHandle  the handle of the AT client.
+ */
+void uAtClientMetricsOff(uAtClientHandle_t atHandle);
+
+/** Get the metrics of an AT client.
+ *
+ * @param atHandle      the handle of the AT client.
+ * @param[out] pMetrics a place to put the metrics; cannot be NULL.
+ * @return              zero on success else negative error code;
+ *                      #U_ERROR_COMMON_NOT_SUPPORTED if
+ *                      U_CFG_AT_CLIENT_METRICS is not defined,
+ *                      #U_ERROR_COMMON_NOT_INITIALISED if
+ *                      uAtClientMetricsOn() has not been called.
+ */
+int32_t uAtClientMetricsGet(uAtClientHandle_t atHandle,
+                            uAtClientMetrics_t *pMetrics);
+
+/** Print the metrics of an AT client as a table.
+ *
+ * @param atHandle  the handle of the AT client.
+ */
+void uAtClientMetricsPrint(uAtClientHandle_t atHandle);
+
+/** Work out a percentile of the latency of an AT command from
+ * the histogram in its metrics.  The histogram buckets are
+ * powers of two in size and so the answer is the upper end of
+ * the bucket in which the percentile falls, limited to the
+ * maximum latency seen.
+ *
+ * @param[in] pCommand  the metrics for the AT command; cannot be NULL.
+ * @param percentile    the percentile, e.g. 99, range 1 to 100.
+ * @return              the latency in milliseconds else negative
+ *                      error code.
+ */
+int32_t uAtClientMetricsLatencyPercentileMs(const uAtClientMetricsCommand_t *pCommand,
+                                            int32_t percentile);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,273 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _U_AT_CLIENT_TRANSCRIPT_H_
+#define _U_AT_CLIENT_TRANSCRIPT_H_
+
+/* Only header files representing a direct and unavoidable
+ * dependency between the API of this module and the API
+ * of another module should be included here; otherwise
+ * please keep #includes to your .c files. */
+
+#include "u_device_serial.h" // uDeviceSerial_t
+#include "u_at_client.h"     // uAtClientHandle_t
+
+/** \addtogroup _AT-client
+ *  @{
+ */
+
+/** @file
+ * @brief This header file defines a means of recording the AT
+ * traffic between an AT client and a module as a "transcript" and
+ * of replaying that transcript later, with no module present, from a
+ * virtual serial device that behaves like the module did: it checks
+ * what the AT client writes against what was recorded and sends
+ * back what the module sent, with the recorded timing.  This allows
+ * code sitting on top of the AT client (e.g. sockets, MQTT, HTTP)
+ * to be regression-tested and benchmarked on a PC, without hardware.
+ *
+ * Recording is done with uAtClientTranscriptRecordStart() and
+ * uAtClientTranscriptRecordStop(), which use the stream intercept
+ * functions uAtClientStreamInterceptTx() and
+ * uAtClientStreamInterceptRx() and hence can't be used at the same
+ * time as anything else that intercepts the stream (e.g. 3GPP 27.010
+ * CMUX, chip to chip security or EDM).  The transcript is written to
+ * a buffer supplied by the caller; it is up to the application to
+ * store it somewhere (e.g. in a file) if required.
+ *
+ * To replay a transcript, create a virtual serial device with
+ * pUAtClientTranscriptReplayCreate(), open it and add an AT client
+ * on it as a #U_AT_CLIENT_STREAM_TYPE_VIRTUAL_SERIAL stream, then
+ * run the same operations as were run when the transcript was
+ * recorded.  uAtClientTranscriptReplayStatsGet() can be used to
+ * check that the AT client wrote what was expected.
+ *
+ * The format of a transcript is a four byte header, the characters
+ * "uAT" followed by a version byte (#U_AT_CLIENT_TRANSCRIPT_VERSION),
+ * then any number of records, each of which is:
+ *
+ * - one byte, #U_AT_CLIENT_TRANSCRIPT_RECORD_TYPE_TX for data written
+ *   by the AT client or #U_AT_CLIENT_TRANSCRIPT_RECORD_TYPE_RX for
+ *   data received from the module,
+ * - the time in milliseconds since the start of the previous record
+ *   (or since the start of recording for the first record),
+ *   unsigned, encoded seven bits at a time, least significant first,
+ *   with the top bit of each byte set if there is another byte to come,
+ * - the length of the data, two bytes, little-endian,
+ * - the data.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** The version of the transcript format.
+ */
+#define U_AT_CLIENT_TRANSCRIPT_VERSION 1
+
+/** The size of the transcript header.
+ */
+#define U_AT_CLIENT_TRANSCRIPT_HEADER_SIZE_BYTES 4
+
+/** The record type for data written by the AT client.
+ */
+#define U_AT_CLIENT_TRANSCRIPT_RECORD_TYPE_TX 'T'
+
+/** The record type for data received from the module.
+ */
+#define U_AT_CLIENT_TRANSCRIPT_RECORD_TYPE_RX 'R'
+
+#ifndef U_AT_CLIENT_TRANSCRIPT_RX_MERGE_MS
+/** When recording, received data that arrives within this many
+ * milliseconds of the previous lot of received data is added to
+ * the same record, rather than starting a new one; this keeps
+ * transcripts compact at the expense of timing detail.  Data
+ * written by the AT client always joins the previous record if
+ * that was also written by the AT client, since the replay device
+ * treats written data as a continuous stream anyway.
+ */
+# define U_AT_CLIENT_TRANSCRIPT_RX_MERGE_MS 10
+#endif
+
+#ifndef U_AT_CLIENT_TRANSCRIPT_REPLAY_IDLE_MS
+/** The maximum time for which the task of a replay device,
+ * which sends the received data events, sleeps when it has nothing
+ * to do.
+ */
+# define U_AT_CLIENT_TRANSCRIPT_REPLAY_IDLE_MS 1000
+#endif
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** Context for recording a transcript, populated by
+ * uAtClientTranscriptRecordStart(); the caller need only provide
+ * the storage, which must remain valid until
+ * uAtClientTranscriptRecordStop() has returned.  Other than
+ * length and bytesLost, which may be read at any time, the
+ * contents should be treated as private.
+ */
+typedef struct {
+    uAtClientHandle_t atHandle; /**< the AT client being recorded. */
+    char *pBuffer;          /**< the buffer the transcript is written to. */
+    size_t size;            /**< the size of pBuffer. */
+    size_t length;          /**< the length of the transcript so far. */
+    size_t bytesLost;       /**< the number of bytes of traffic that could
+                                 not be recorded because pBuffer was full. */
+    size_t lastRecordOffset; /**< the offset of the length field of the
+                                  last record in pBuffer. */
+    char lastRecordType;    /**< the type of the last record, zero if
+                                 there has not been one. */
+    int32_t lastRecordTimeMs; /**< the time that the last record started. */
+    int32_t lastDataTimeMs; /**< the time that data was last added. */
+} uAtClientTranscriptRecord_t;
+
+/** Statistics from a replay device.
+ */
+typedef struct {
+    int32_t recordsReplayed; /**< the number of records replayed in
+                                  full so far. */
+    int32_t mismatchCount;   /**< the number of records written by
+                                  the AT client that did not match
+                                  those in the transcript. */
+    size_t bytesUnexpected;  /**< the number of bytes written by the AT
+                                  client after the transcript had ended. */
+    size_t bytesOverflow;    /**< the number of bytes of received data
+                                  that were lost because the receive
+                                  buffer was full when the AT client
+                                  wrote the data that followed them. */
+    size_t bytesWritten;     /**< the number of bytes written by the
+                                  AT client. */
+    size_t bytesRead;        /**< the number of bytes read by the
+                                  AT client. */
+    bool done;               /**< true if the whole of the transcript
+                                  has been replayed. */
+} uAtClientTranscriptReplayStats_t;
+
+/* ----------------------------------------------------------------
+ * FUNCTIONS: RECORD
+ * -------------------------------------------------------------- */
+
+/** Start recording the traffic of an AT client.  Any data in the
+ * receive buffers of the AT client will be lost (see
+ * uAtClientStreamInterceptRx()).  This function will lock the
+ * AT client while it hooks in and hence must not be called while
+ * the AT client is locked by the calling task.
+ *
+ * Recording uses the transmit and receive intercepts of the AT
+ * client, so it is not possible to record a transcript while
+ * another intercept is installed, e.g. that of the EDM stream of
+ * a short-range module; #U_ERROR_COMMON_BUSY is returned in that
+ * case.  Likewise, nothing else should install an intercept on the
+ * AT client until uAtClientTranscriptRecordStop() has been called.
+ *
+ * @param atHandle      the handle of the AT client.
+ * @param[out] pRecord  storage for the recording context; cannot
+ *                      be NULL.
+ * @param[out] pBuffer  the buffer to write the transcript to;
+ *                      cannot be NULL.
+ * @param size          the amount of storage at pBuffer, must be
+ *                      at least #U_AT_CLIENT_TRANSCRIPT_HEADER_SIZE_BYTES.
+ * @return              zero on success else negative error code;
+ *                      #U_ERROR_COMMON_BUSY if another intercept
+ *                      is already installed on the AT client.
+ */
+int32_t uAtClientTranscriptRecordStart(uAtClientHandle_t atHandle,
+                                       uAtClientTranscriptRecord_t *pRecord,
+                                       char *pBuffer, size_t size);
+
+/** Stop recording.  As for uAtClientTranscriptRecordStart(), this
+ * function must not be called while the AT client is locked by the
+ * calling task.
+ *
+ * @param[in] pRecord  the recording context that was passed to
+ *                     uAtClientTranscriptRecordStart(); cannot be
+ *                     NULL.
+ * @return             on success the length of the transcript,
+ *                     else negative error code; check the bytesLost
+ *                     field of pRecord to determine if the
+ *                     transcript is complete.
+ */
+int32_t uAtClientTranscriptRecordStop(uAtClientTranscriptRecord_t *pRecord);
+
+/* ----------------------------------------------------------------
+ * FUNCTIONS: REPLAY
+ * -------------------------------------------------------------- */
+
+/** Create a virtual serial device that replays a transcript.  When
+ * the device has been opened, any records of data received from the
+ * module that are at the start of the transcript are made available
+ * to be read with the recorded timing; after that, each time the
+ * data the AT client writes completes a record of written data, the
+ * received data that followed it in the transcript is made
+ * available, again with the recorded timing.  Should the AT client
+ * write data before all of the preceding received data has become
+ * available, that data is made available at once (and any of it that
+ * does not fit into the receive buffer is lost).
+ *
+ * The device supports open(), close(), getReceiveSize(), read(),
+ * write() and the event functions.  The event callback is called
+ * in the task of the replay device, which is created with the stack
+ * size and priority passed to eventCallbackSet().
+ *
+ * @param[in] pTranscript    the transcript, which must remain valid
+ *                           until uAtClientTranscriptReplayDelete()
+ *                           has been called; cannot be NULL.
+ * @param length             the length of the transcript.
+ * @param timeScalePercent   the timing to use, as a percentage of
+ *                           that recorded: 100 to replay at the
+ *                           recorded speed, 0 to make received data
+ *                           available as soon as possible.
+ * @return                   on success a pointer to the serial device,
+ *                           else NULL.
+ */
+uDeviceSerial_t *pUAtClientTranscriptReplayCreate(const char *pTranscript,
+                                                  size_t length,
+                                                  int32_t timeScalePercent);
+
+/** Get the statistics of a replay device.
+ *
+ * @param[in] pDeviceSerial  a replay device created by
+ *                           pUAtClientTranscriptReplayCreate();
+ *                           cannot be NULL.
+ * @param[out] pStats        a place to put the statistics; cannot
+ *                           be NULL.
+ * @return                   zero on success else negative error code.
+ */
+int32_t uAtClientTranscriptReplayStatsGet(uDeviceSerial_t *pDeviceSerial,
+                                          uAtClientTranscriptReplayStats_t *pStats);
+
+/** Delete a replay device, closing it first if required.
+ *
+ * @param[in] pDeviceSerial  a replay device created by
+ *                           pUAtClientTranscriptReplayCreate().
+ */
+void uAtClientTranscriptReplayDelete(uDeviceSerial_t *pDeviceSerial);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @}*/
+
+#endif // _U_AT_CLIENT_TRANSCRIPT_H_
+
+// End of file
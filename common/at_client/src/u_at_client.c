@@ -316,6 +316,19 @@ typedef struct uAtClientUrc_t {
     struct uAtClientUrc_t *pNext;
 } uAtClientUrc_t;
 
+/** A node in the compiled URC prefix trie.  All of the nodes
+ * of a trie are held in a single array, index zero being the
+ * root; the children of a node form a singly-linked list of
+ * siblings and, since no node can point at the root, zero is
+ * used to mean "none".
+ */
+typedef struct {
+    char character;          /** The character this node matches. */
+    uint16_t firstChild;     /** Index of the first child node, zero if none. */
+    uint16_t nextSibling;    /** Index of the next sibling node, zero if none. */
+    uAtClientUrc_t *pUrc;    /** The URC whose prefix ends at this node, else NULL. */
+} uAtClientUrcTrieNode_t;
+
 /** The definition of a tag.
  */
 typedef struct {
@@ -421,12 +434,18 @@ typedef struct uAtClientInstance_t {
     void (*pConsecutiveTimeoutsCallback) (uAtClientHandle_t, int32_t *);
     char delimiter; /** The delimiter used between parameters. */
     int32_t delayMs; /** The delay from ending one AT command to starting the next. */
+    int32_t delayAdaptiveMinMs; /** The minimum delay if the delay is adaptive, else -1. */
+    int32_t delayAdaptiveMs; /** The delay currently in use if the delay is adaptive. */
+    uPortSemaphoreHandle_t dataSemaphore; /** Given when the stream signals that data has
+                                              been received, NULL if there isn't one. */
     uErrorCode_t error; /** The current error status. */
     uAtClientDeviceError_t deviceError; /** The error reported by the AT server. */
     uAtClientScope_t scope; /** The scope, where we're at in the AT command. */
     uAtClientTag_t stopTag; /** The stop tag for the current scope. */
     uAtClientUrc_t *pUrcList; /** Linked-list anchor for URC handlers. */
     uAtClientUrc_t *pUrcRead;  /** Pointer used when reading the URC handlers. */
+    uAtClientUrcTrieNode_t *pUrcTrie; /** pUrcList compiled into a prefix trie, NULL if
+                                          there isn't one (no URCs or no memory). */
     int32_t lastResponseStopMs; /** The time the last response ended in milliseconds. */
     int32_t lockTimeMs; /** The time when the stream was locked. */
     int32_t lastTxTimeMs; /** The time when the last transmit activity was carried out, set to -1 initially. */
@@ -451,6 +470,13 @@ typedef struct uAtClientInstance_t {
                                    as its fourth parameter. */
     uAtClientWakeUp_t *pWakeUp; /** Pointer to a wake-up handler structure. */
     uAtClientActivityPin_t *pActivityPin; /** Pointer to an activity pin structure. */
+#ifdef U_CFG_AT_CLIENT_METRICS
+    uAtClientMetrics_t *pMetrics; /** Metrics, NULL if not being collected. */
+    int32_t metricsCommandIndex; /** Index into pMetrics->command[] of the AT command
+                                     in progress, -1 if none. */
+    int32_t metricsCommandStartMs; /** The time the AT command in progress started. */
+    int32_t metricsStartMs; /** The time metrics collection started. */
+#endif
     struct uAtClientInstance_t *pNext;
 } uAtClientInstance_t;
 
@@ -639,6 +665,190 @@ static void printLogDebug(const uAtClientDetailedDebug_t *pDebug,
 }
 #endif
 
+#ifdef U_CFG_AT_CLIENT_METRICS
+// Copy a command or URC prefix into the metrics storage at pPrefix,
+// stopping at '=' or '?' and truncating as necessary.
+static void metricsPrefixCopy(char *pPrefix, const char *pString)
+{
+    size_t x = 0;
+
+    while ((x < U_AT_CLIENT_METRICS_PREFIX_MAX_LENGTH_BYTES) &&
+           (*pString != 0) && (*pString != '=') && (*pString != '?')) {
+        *(pPrefix + x) = *pString;
+        pString++;
+        x++;
+    }
+    *(pPrefix + x) = 0;
+}
+#endif
+
+// Note the start of an AT command in the metrics.
+// pClient->mutex should be locked before this is called.
+static void metricsCommandStart(uAtClientInstance_t *pClient,
+                                const char *pCommand)
+{
+#ifdef U_CFG_AT_CLIENT_METRICS
+    uAtClientMetrics_t *pMetrics = pClient->pMetrics;
+    char prefix[U_AT_CLIENT_METRICS_PREFIX_MAX_LENGTH_BYTES + 1];
+    size_t x = 0;
+
+    pClient->metricsCommandIndex = -1;
+    if ((pMetrics != NULL) && (pCommand != NULL)) {
+        metricsPrefixCopy(prefix, pCommand);
+        while ((x < pMetrics->numCommands) &&
+               (strcmp(pMetrics->command[x].prefix, prefix) != 0)) {
+            x++;
+        }
+        if ((x == pMetrics->numCommands) &&
+            (x < sizeof(pMetrics->command) / sizeof(pMetrics->command[0]))) {
+            // A new one
+            memcpy(pMetrics->command[x].prefix, prefix, sizeof(prefix));
+            pMetrics->command[x].latencyMinMs = INT_MAX;
+            pMetrics->numCommands++;
+        }
+        if (x < pMetrics->numCommands) {
+            pMetrics->command[x].count++;
+            pClient->metricsCommandIndex = (int32_t) x;
+            pClient->metricsCommandStartMs = uPortGetTickTimeMs();
+        } else {
+            pMetrics->commandUntrackedCount++;
+        }
+    }
+#else
+    (void) pClient;
+    (void) pCommand;
+#endif
+}
+
+// Note the end of an AT command in the metrics, if one is
+// in progress.
+// pClient->mutex should be locked before this is called.
+static void metricsCommandStop(uAtClientInstance_t *pClient)
+{
+#ifdef U_CFG_AT_CLIENT_METRICS
+    uAtClientMetricsCommand_t *pCommand;
+    int32_t latencyMs;
+    size_t bucket = 0;
+
+    if ((pClient->pMetrics != NULL) && (pClient->metricsCommandIndex >= 0)) {
+        pCommand = &(pClient->pMetrics->command[pClient->metricsCommandIndex]);
+        latencyMs = uPortGetTickTimeMs() - pClient->metricsCommandStartMs;
+        if (latencyMs < 0) {
+            latencyMs = 0;
+        }
+        if ((pClient->error != U_ERROR_COMMON_SUCCESS) ||
+            (pClient->deviceError.type != U_AT_CLIENT_DEVICE_ERROR_TYPE_NO_ERROR)) {
+            pCommand->errorCount++;
+        }
+        if (latencyMs < pCommand->latencyMinMs) {
+            pCommand->latencyMinMs = latencyMs;
+        }
+        if (latencyMs > pCommand->latencyMaxMs) {
+            pCommand->latencyMaxMs = latencyMs;
+        }
+        pCommand->latencyTotalMs += latencyMs;
+        // Bucket n holds latencies up to (2^n) - 1
+        while ((latencyMs > 0) &&
+               (bucket < sizeof(pCommand->latencyBucket) / sizeof(pCommand->latencyBucket[0]) - 1)) {
+            latencyMs >>= 1;
+            bucket++;
+        }
+        pCommand->latencyBucket[bucket]++;
+    }
+    pClient->metricsCommandIndex = -1;
+#else
+    (void) pClient;
+#endif
+}
+
+// Note a timeout in the metrics.
+static void metricsTimeout(const uAtClientInstance_t *pClient)
+{
+#ifdef U_CFG_AT_CLIENT_METRICS
+    if (pClient->pMetrics != NULL) {
+        pClient->pMetrics->timeoutCount++;
+        if (pClient->metricsCommandIndex >= 0) {
+            pClient->pMetrics->command[pClient->metricsCommandIndex].timeoutCount++;
+        }
+    }
+#else
+    (void) pClient;
+#endif
+}
+
+// Note a URC in the metrics.
+static void metricsUrc(const uAtClientInstance_t *pClient,
+                       const char *pPrefix, int32_t handlerTimeMs)
+{
+#ifdef U_CFG_AT_CLIENT_METRICS
+    uAtClientMetrics_t *pMetrics = pClient->pMetrics;
+    char prefix[U_AT_CLIENT_METRICS_PREFIX_MAX_LENGTH_BYTES + 1];
+    size_t x = 0;
+
+    if (pMetrics != NULL) {
+        pMetrics->urcTimeTotalMs += handlerTimeMs;
+        metricsPrefixCopy(prefix, pPrefix);
+        while ((x < pMetrics->numUrcs) &&
+               (strcmp(pMetrics->urc[x].prefix, prefix) != 0)) {
+            x++;
+        }
+        if ((x == pMetrics->numUrcs) &&
+            (x < sizeof(pMetrics->urc) / sizeof(pMetrics->urc[0]))) {
+            // A new one
+            memcpy(pMetrics->urc[x].prefix, prefix, sizeof(prefix));
+            pMetrics->numUrcs++;
+        }
+        if (x < pMetrics->numUrcs) {
+            pMetrics->urc[x].count++;
+            pMetrics->urc[x].handlerTimeTotalMs += handlerTimeMs;
+            if (handlerTimeMs > pMetrics->urc[x].handlerTimeMaxMs) {
+                pMetrics->urc[x].handlerTimeMaxMs = handlerTimeMs;
+            }
+        } else {
+            pMetrics->urcUntrackedCount++;
+        }
+    }
+#else
+    (void) pClient;
+    (void) pPrefix;
+    (void) handlerTimeMs;
+#endif
+}
+
+// Note bytes received/sent in the metrics.
+static void metricsBytes(const uAtClientInstance_t *pClient,
+                         size_t bytesIn, size_t bytesOut)
+{
+#ifdef U_CFG_AT_CLIENT_METRICS
+    if (pClient->pMetrics != NULL) {
+        pClient->pMetrics->bytesIn += bytesIn;
+        pClient->pMetrics->bytesOut += bytesOut;
+    }
+#else
+    (void) pClient;
+    (void) bytesIn;
+    (void) bytesOut;
+#endif
+}
+
+// Note a lock of the stream in the metrics.
+static void metricsStreamLock(const uAtClientInstance_t *pClient,
+                              int32_t waitMs)
+{
+#ifdef U_CFG_AT_CLIENT_METRICS
+    if (pClient->pMetrics != NULL) {
+        pClient->pMetrics->streamLockCount++;
+        if (waitMs > 0) {
+            pClient->pMetrics->streamLockContendedCount++;
+            pClient->pMetrics->streamLockWaitTotalMs += waitMs;
+        }
+    }
+#else
+    (void) pClient;
+    (void) waitMs;
+#endif
+}
+
 // Find an AT client instance in the list by stream handle.
 // gMutex should be locked before this is called.
 static uAtClientInstance_t *pGetAtClientInstance(int32_t streamHandle,
@@ -782,12 +992,22 @@ static void removeClient(uAtClientInstance_t *pClient)
             break;
     }
 
+    // The stream callbacks are gone so nothing can give
+    // the data semaphore any more
+    if (pClient->dataSemaphore != NULL) {
+        uPortSemaphoreDelete(pClient->dataSemaphore);
+    }
+
     // Free any URC handlers it had.
     while (pClient->pUrcList != NULL) {
         pUrc = pClient->pUrcList;
         pClient->pUrcList = pUrc->pNext;
         uPortFree(pUrc);
     }
+    uPortFree(pClient->pUrcTrie);
+#ifdef U_CFG_AT_CLIENT_METRICS
+    uPortFree(pClient->pMetrics);
+#endif
 
     // Remove any activity pin
     uPortFree(pClient->pActivityPin);
@@ -1087,6 +1307,12 @@ static void consecutiveTimeout(uAtClientInstance_t *pClient)
 {
     uAtClientCallback_t cb;
 
+    // The AT server may not have been ready for us, go back
+    // to the full inter-command delay
+    pClient->delayAdaptiveMs = pClient->delayMs;
+
+    metricsTimeout(pClient);
+
     U_PORT_MUTEX_LOCK(gMutexEventQueue);
 
     pClient->numConsecutiveAtTimeouts++;
@@ -1173,7 +1399,7 @@ static void bufferReset(const uAtClientInstance_t *pClient,
 
 // Set the read position to 0 and move the buffer's
 // unread content to the beginning.
-static void bufferRewind(const uAtClientInstance_t *pClient)
+static void bufferCompact(const uAtClientInstance_t *pClient)
 {
     uAtClientReceiveBuffer_t *pBuffer = pClient->pReceiveBuffer;
 
@@ -1204,6 +1430,37 @@ static void bufferRewind(const uAtClientInstance_t *pClient)
     }
 }
 
+// Give back the space in the buffer occupied by characters that
+// have been read.  Everything in the AT client works relative to
+// readIndex, so rather than moving the unread content down to the
+// start of the buffer every time a line is consumed, which is a
+// lot of copying when a large amount of unread data (e.g. the
+// payload of a socket read) sits behind short lines, the move is
+// only done when the space that has been read is at least as large
+// as the free space remaining at the end of the buffer, i.e. when
+// the free space would be at least doubled by it.
+static void bufferRewind(const uAtClientInstance_t *pClient)
+{
+    uAtClientReceiveBuffer_t *pBuffer = pClient->pReceiveBuffer;
+
+    if ((pBuffer->readIndex > 0) &&
+        ((pBuffer->lengthBuffered >= pBuffer->dataBufferSize) ||
+         (pBuffer->readIndex >= pBuffer->dataBufferSize - pBuffer->lengthBuffered))) {
+        bufferCompact(pClient);
+    }
+}
+
+// Wait for up to waitMs for the stream to signal that data has been
+// received, or just wait if there is no way of being signalled.
+static void waitForData(const uAtClientInstance_t *pClient, int32_t waitMs)
+{
+    if (pClient->dataSemaphore != NULL) {
+        uPortSemaphoreTryTake(pClient->dataSemaphore, waitMs);
+    } else {
+        uPortTaskBlock(waitMs);
+    }
+}
+
 // Read from the UART/serial interface in nice coherent lines.
 static int32_t serialReadNoStutter(uAtClientInstance_t *pClient,
                                    uAtClientBlockState_t blockState,
@@ -1237,20 +1494,26 @@ static int32_t serialReadNoStutter(uAtClientInstance_t *pClient,
             readLength += thisReadLength;
             pBuffer += thisReadLength;
             bufferSize -= thisReadLength;
-            if (blockState == U_AT_CLIENT_BLOCK_STATE_NOTHING_RECEIVED) {
-                // Got something: now wait for more
-                blockState = U_AT_CLIENT_BLOCK_STATE_WAIT_FOR_MORE;
-                uPortTaskBlock(U_AT_CLIENT_STREAM_READ_RETRY_DELAY_MS);
+            if (blockState != U_AT_CLIENT_BLOCK_STATE_DO_NOT_BLOCK) {
+                if (*(pBuffer - 1) == '\n') {
+                    // What we have ends with a complete line, there
+                    // is no stutter to wait for: let the parser at it
+                    blockState = U_AT_CLIENT_BLOCK_STATE_DO_NOT_BLOCK;
+                } else {
+                    // Got part of something: now wait for more, waking
+                    // up as soon as it arrives
+                    blockState = U_AT_CLIENT_BLOCK_STATE_WAIT_FOR_MORE;
+                    waitForData(pClient, U_AT_CLIENT_STREAM_READ_RETRY_DELAY_MS);
+                }
             }
         } else {
             if (blockState == U_AT_CLIENT_BLOCK_STATE_WAIT_FOR_MORE) {
                 // We were waiting for more but we have received nothing
                 // so stop blocking now
                 blockState = U_AT_CLIENT_BLOCK_STATE_DO_NOT_BLOCK;
-            } else {
-                uPortTaskBlock(U_AT_CLIENT_STREAM_READ_RETRY_DELAY_MS);
+            } else if (blockState == U_AT_CLIENT_BLOCK_STATE_NOTHING_RECEIVED) {
+                waitForData(pClient, U_AT_CLIENT_STREAM_READ_RETRY_DELAY_MS);
             }
-
         }
     } while ((bufferSize > 0) &&
              (blockState != U_AT_CLIENT_BLOCK_STATE_DO_NOT_BLOCK) &&
@@ -1345,6 +1608,10 @@ static bool bufferFill(uAtClientInstance_t *pClient,
         }
     }
 
+    // Make room by giving back the space of what has been read,
+    // if that is worth doing
+    bufferRewind(pClient);
+
     // Reset buffer if it has become full
     if (pReceiveBuffer->lengthBuffered == pReceiveBuffer->dataBufferSize) {
 #if U_CFG_OS_CLIB_LEAKS
@@ -1526,7 +1793,10 @@ static bool bufferFill(uAtClientInstance_t *pClient,
         }
 
         LOG_BUFFER_FILL(14);
-        uPortTaskBlock(U_AT_CLIENT_STREAM_READ_RETRY_DELAY_MS);
+        if ((readLength == 0) &&
+            (pollTimeRemaining(atTimeoutMs, pClient->lockTimeMs) > 0)) {
+            waitForData(pClient, U_AT_CLIENT_STREAM_READ_RETRY_DELAY_MS);
+        }
     } while ((readLength == 0) &&
              (pollTimeRemaining(atTimeoutMs, pClient->lockTimeMs) > 0));
 
@@ -1538,12 +1808,13 @@ static bool bufferFill(uAtClientInstance_t *pClient,
         if (!eventIsCallback) {
 #endif
             printAt(pClient, U_AT_CLIENT_DATA_BUFFER_PTR(pReceiveBuffer) +
-                    pReceiveBuffer->length + pReceiveBuffer->readIndex,
+                    pReceiveBuffer->length,
                     readLength);
 #if U_CFG_OS_CLIB_LEAKS
         }
 #endif
         pReceiveBuffer->length += readLength;
+        metricsBytes(pClient, readLength, 0);
         LOG_BUFFER_FILL(16);
     }
 
@@ -1597,6 +1868,34 @@ static int32_t bufferReadChar(uAtClientInstance_t *pClient)
     return character;
 }
 
+// Get a pointer to the unread data in the receive buffer, bringing
+// more in if there is none, and the length of it in *pLength; the
+// data is NOT consumed, the caller should advance readIndex by the
+// amount it uses.  Timeouts are handled as for bufferReadChar(),
+// in which case NULL is returned.
+static const char *pBufferSpan(uAtClientInstance_t *pClient,
+                               size_t *pLength)
+{
+    uAtClientReceiveBuffer_t *pReceiveBuffer = pClient->pReceiveBuffer;
+    const char *pSpan = NULL;
+
+    *pLength = 0;
+    if (pReceiveBuffer->readIndex >= pReceiveBuffer->length) {
+        // Nothing left: bufferReadChar() will bring more data
+        // in, consuming the first character of it, which we
+        // then put back
+        if (bufferReadChar(pClient) >= 0) {
+            pReceiveBuffer->readIndex--;
+        }
+    }
+    if (pReceiveBuffer->readIndex < pReceiveBuffer->length) {
+        pSpan = U_AT_CLIENT_DATA_BUFFER_PTR(pReceiveBuffer) + pReceiveBuffer->readIndex;
+        *pLength = pReceiveBuffer->length - pReceiveBuffer->readIndex;
+    }
+
+    return pSpan;
+}
+
 // Look for pString at the start of the current receive buffer
 // without bringing more data into it, and if the string
 // is there consume it.
@@ -1606,8 +1905,6 @@ static bool bufferMatch(const uAtClientInstance_t *pClient,
     uAtClientReceiveBuffer_t *pReceiveBuffer = pClient->pReceiveBuffer;
     bool found = false;
 
-    bufferRewind(pClient);
-
     if ((pReceiveBuffer->length - pReceiveBuffer->readIndex) >= length) {
         if (pString && (memcmp(U_AT_CLIENT_DATA_BUFFER_PTR(pReceiveBuffer) +
                                pReceiveBuffer->readIndex,
@@ -1736,49 +2033,170 @@ static void informationResponseStop(uAtClientInstance_t *pClient)
     }
 }
 
-// Iterate through URCs and check if one of them matches the current
-// contents of the receive buffer. If a URC is matched, set the
+// Find the child of the given trie node that matches character,
+// returning its index or zero if there is none.
+static size_t urcTrieFindChild(const uAtClientUrcTrieNode_t *pTrie,
+                               size_t node, char character)
+{
+    size_t child = pTrie[node].firstChild;
+
+    while ((child != 0) && (pTrie[child].character != character)) {
+        child = pTrie[child].nextSibling;
+    }
+
+    return child;
+}
+
+// Compile the URC list of an AT client into a prefix trie, so that
+// matching a URC costs the length of its prefix rather than the
+// number of URC handlers.  If there is not enough memory NULL is
+// returned and the list will be searched instead.
+// urcPermittedMutex should be locked before this is called.
+static uAtClientUrcTrieNode_t *pUrcTrieBuild(const uAtClientInstance_t *pClient)
+{
+    uAtClientUrcTrieNode_t *pTrie = NULL;
+    uAtClientUrcTrieNode_t *pTrieExact = NULL;
+    size_t numNodesMax = 1;
+    size_t numNodes = 1;
+    size_t node;
+    size_t child;
+
+    // Work out the worst case number of nodes: one for every
+    // character of every prefix plus the root
+    for (uAtClientUrc_t *pUrc = pClient->pUrcList; pUrc != NULL; pUrc = pUrc->pNext) {
+        numNodesMax += pUrc->prefixLength;
+    }
+    if ((pClient->pUrcList != NULL) && (numNodesMax <= UINT16_MAX)) {
+        pTrie = (uAtClientUrcTrieNode_t *) pUPortMalloc(numNodesMax * sizeof(*pTrie));
+    }
+    if (pTrie != NULL) {
+        memset(pTrie, 0, sizeof(*pTrie));
+        for (uAtClientUrc_t *pUrc = pClient->pUrcList; pUrc != NULL; pUrc = pUrc->pNext) {
+            node = 0;
+            for (size_t x = 0; x < pUrc->prefixLength; x++) {
+                child = urcTrieFindChild(pTrie, node, *(pUrc->pPrefix + x));
+                if (child == 0) {
+                    // Add a new child to the front of the siblings
+                    child = numNodes;
+                    numNodes++;
+                    pTrie[child].character = *(pUrc->pPrefix + x);
+                    pTrie[child].firstChild = 0;
+                    pTrie[child].nextSibling = pTrie[node].firstChild;
+                    pTrie[child].pUrc = NULL;
+                    pTrie[node].firstChild = (uint16_t) child;
+                }
+                node = child;
+            }
+            pTrie[node].pUrc = pUrc;
+        }
+        // Prefixes usually share their leading characters so
+        // move the trie into memory of exactly the right size;
+        // if that fails just keep the larger one
+        if (numNodes < numNodesMax) {
+            pTrieExact = (uAtClientUrcTrieNode_t *) pUPortMalloc(numNodes * sizeof(*pTrie));
+            if (pTrieExact != NULL) {
+                memcpy(pTrieExact, pTrie, numNodes * sizeof(*pTrie));
+                uPortFree(pTrie);
+                pTrie = pTrieExact;
+            }
+        }
+    }
+
+    return pTrie;
+}
+
+// Rebuild the URC trie of an AT client after its URC list has been
+// changed.  The trie is read with only the stream locked, so the
+// new one is swapped in under the stream lock and the old one is
+// only freed once that is done, at which point no-one can be using
+// it or any URC that has been taken out of the list.
+// urcPermittedMutex should be locked before this is called.
+static void urcTrieReplace(uAtClientInstance_t *pClient)
+{
+    uAtClientUrcTrieNode_t *pTrie = pUrcTrieBuild(pClient);
+    uAtClientUrcTrieNode_t *pTrieOld;
+    uPortMutexHandle_t streamMutex;
+
+    streamMutex = streamLock(pClient);
+    pTrieOld = pClient->pUrcTrie;
+    pClient->pUrcTrie = pTrie;
+    uPortMutexUnlock(streamMutex);
+
+    uPortFree(pTrieOld);
+}
+
+// Find the URC with the longest prefix that matches the start of the
+// receive buffer using the compiled trie, without consuming anything.
+static uAtClientUrc_t *pUrcTrieMatch(const uAtClientInstance_t *pClient)
+{
+    const uAtClientUrcTrieNode_t *pTrie = pClient->pUrcTrie;
+    uAtClientReceiveBuffer_t *pReceiveBuffer = pClient->pReceiveBuffer;
+    const char *pData = U_AT_CLIENT_DATA_BUFFER_PTR(pReceiveBuffer) +
+                        pReceiveBuffer->readIndex;
+    size_t length = pReceiveBuffer->length - pReceiveBuffer->readIndex;
+    uAtClientUrc_t *pUrc = pTrie->pUrc;
+    size_t node = 0;
+
+    for (size_t x = 0; (x < length) && (pTrie[node].firstChild != 0); x++) {
+        node = urcTrieFindChild(pTrie, node, *(pData + x));
+        if (node == 0) {
+            break;
+        }
+        if (pTrie[node].pUrc != NULL) {
+            pUrc = pTrie[node].pUrc;
+        }
+    }
+
+    return pUrc;
+}
+
+// Check if one of the URCs matches the current contents of the
+// receive buffer, using the compiled trie if there is one, else by
+// iterating through the URC list. If a URC is matched, set the
 // scope to information response and, after the URC's handler has
 // returned, finish off the information response scope by consuming
 // up to CR/LF.
 static bool bufferMatchOneUrc(uAtClientInstance_t *pClient)
 {
-    size_t prefixLength = 0;
-    bool found = false;
+    uAtClientUrc_t *pUrc = NULL;
     int32_t now;
     uErrorCode_t savedError;
 
-    bufferRewind(pClient);
+    if (pClient->pUrcTrie != NULL) {
+        pUrc = pUrcTrieMatch(pClient);
+        if (pUrc != NULL) {
+            // Consume the matching part
+            pClient->pReceiveBuffer->readIndex += pUrc->prefixLength;
+        }
+    } else {
+        pUrc = pClient->pUrcList;
+        while ((pUrc != NULL) && !bufferMatch(pClient, pUrc->pPrefix, pUrc->prefixLength)) {
+            pUrc = pUrc->pNext;
+        }
+    }
 
-    for (uAtClientUrc_t *pUrc = pClient->pUrcList;
-         !found && (pUrc != NULL);
-         pUrc = pUrc->pNext) {
-        prefixLength = pUrc->prefixLength;
-        if (pClient->pReceiveBuffer->length >= prefixLength) {
-            if (bufferMatch(pClient, pUrc->pPrefix, prefixLength)) {
-                setScope(pClient, U_AT_CLIENT_SCOPE_INFORMATION);
-                now = uPortGetTickTimeMs();
-                // Before heading off into URCness, save
-                // the current error state and reset
-                // it so that the URC doesn't suffer the error
-                savedError = pClient->error;
-                pClient->error = U_ERROR_COMMON_SUCCESS;
-                if (processAsync(pClient->magicNumber) && pUrc->pHandler) {
-                    pUrc->pHandler(pClient, pUrc->pHandlerParam);
-                }
-                informationResponseStop(pClient);
-                // Put the error state back again
-                pClient->error = savedError;
-                // Put the error state back again
-                // Add the amount of time spent in the URC
-                // world to the start time
-                pClient->lockTimeMs += uPortGetTickTimeMs() - now;
-                found = true;
-            }
+    if (pUrc != NULL) {
+        setScope(pClient, U_AT_CLIENT_SCOPE_INFORMATION);
+        now = uPortGetTickTimeMs();
+        // Before heading off into URCness, save
+        // the current error state and reset
+        // it so that the URC doesn't suffer the error
+        savedError = pClient->error;
+        pClient->error = U_ERROR_COMMON_SUCCESS;
+        if (processAsync(pClient->magicNumber) && pUrc->pHandler) {
+            pUrc->pHandler(pClient, pUrc->pHandlerParam);
         }
+        informationResponseStop(pClient);
+        // Put the error state back again
+        pClient->error = savedError;
+        // Add the amount of time spent in the URC
+        // world to the start time
+        now = uPortGetTickTimeMs() - now;
+        pClient->lockTimeMs += now;
+        metricsUrc(pClient, pUrc->pPrefix, now);
     }
 
-    return found;
+    return (pUrc != NULL);
 }
 
 // Read a string parameter.
@@ -1888,6 +2306,132 @@ static int32_t readString(uAtClientInstance_t *pClient,
     return lengthRead;
 }
 
+// Read lengthBytes of binary data, with no stop tag to look
+// for, a span of the receive buffer at a time, copying each span
+// to pBuffer, if not NULL, and passing it to pCallback, if not NULL.
+// The mutex should be locked before this is called.
+static int32_t readSpans(uAtClientInstance_t *pClient,
+                         size_t lengthBytes, char *pBuffer,
+                         void (*pCallback) (const char *, size_t, void *),
+                         void *pParam)
+{
+    uAtClientReceiveBuffer_t *pReceiveBuffer = pClient->pReceiveBuffer;
+    size_t lengthRead = 0;
+    const char *pSpan;
+    size_t length;
+
+    while ((lengthRead < lengthBytes) &&
+           (pClient->error == U_ERROR_COMMON_SUCCESS)) {
+        pSpan = pBufferSpan(pClient, &length);
+        if (pSpan != NULL) {
+            if (length > lengthBytes - lengthRead) {
+                length = lengthBytes - lengthRead;
+            }
+            if (pBuffer != NULL) {
+                memcpy(pBuffer + lengthRead, pSpan, length);
+            }
+            if (pCallback != NULL) {
+                pCallback(pSpan, length, pParam);
+            }
+            pReceiveBuffer->readIndex += length;
+            lengthRead += length;
+        }
+    }
+
+    return (pClient->error == U_ERROR_COMMON_SUCCESS) ? (int32_t) lengthRead : -1;
+}
+
+// Return the value of a hex digit, -1 if c is not a hex digit.
+static int32_t hexDigitValue(int32_t c)
+{
+    int32_t value = -1;
+
+    if ((c >= '0') && (c <= '9')) {
+        value = c - '0';
+    } else if ((c >= 'A') && (c <= 'F')) {
+        value = c - 'A' + 10;
+    } else if ((c >= 'a') && (c <= 'f')) {
+        value = c - 'a' + 10;
+    }
+
+    return value;
+}
+
+// Read a hex string parameter, decoding it into pBuffer as it
+// goes; works in the same way as readString() except that there
+// is no terminator and, since it is all thrown away, anything
+// that is not a hex digit needn't be removed.
+// The mutex should be locked before this is called.
+static int32_t readHexData(uAtClientInstance_t *pClient,
+                           char *pBuffer, size_t lengthBytes)
+{
+    uAtClientTag_t *pStopTag = &(pClient->stopTag);
+    int32_t lengthRead = 0;
+    int32_t matchPos = 0;
+    bool delimiterFound = false;
+    bool inQuotes = false;
+    int32_t highNibble = -1;
+    int32_t nibble;
+    int32_t c;
+
+    while ((pClient->error == U_ERROR_COMMON_SUCCESS) &&
+           !delimiterFound && !pStopTag->found) {
+        c = bufferReadChar(pClient);
+        if (c == -1) {
+            // Error
+            setError(pClient, U_ERROR_COMMON_DEVICE_ERROR);
+        } else if (!inQuotes && (c == pClient->delimiter)) {
+            // Reached delimiter
+            delimiterFound = true;
+        } else if (c == '\"') {
+            // Switch into or out of quotes
+            matchPos = 0;
+            inQuotes = !inQuotes;
+        } else {
+            if (!inQuotes && (pStopTag->pTagDef->length > 0)) {
+                // It could be a stop tag
+                if (c == *(pStopTag->pTagDef->pString + matchPos)) {
+                    matchPos++;
+                } else {
+                    // If it wasn't a stop tag, reset
+                    // the match position and check again
+                    // in case it is the start of a new stop tag
+                    matchPos = 0;
+                    if (c == *(pStopTag->pTagDef->pString)) {
+                        matchPos++;
+                    }
+                }
+                if (matchPos == (int32_t) pStopTag->pTagDef->length) {
+                    pStopTag->found = true;
+                }
+            } else {
+                // Not anything
+                matchPos = 0;
+            }
+            nibble = hexDigitValue(c);
+            if (nibble >= 0) {
+                if (highNibble < 0) {
+                    highNibble = nibble;
+                } else {
+                    if (lengthRead < (int32_t) lengthBytes) {
+                        if (pBuffer != NULL) {
+                            *(pBuffer + lengthRead) = (char) ((highNibble << 4) | nibble);
+                        }
+                        lengthRead++;
+                    }
+                    highNibble = -1;
+                }
+            }
+        }
+    }
+
+    if (pClient->error != U_ERROR_COMMON_SUCCESS) {
+        lengthRead = -1;
+    }
+
+    return lengthRead;
+}
+
 // Read an integer.
 // The mutex should be locked before this is called.
 static int32_t readInt(uAtClientInstance_t *pClient)
@@ -2008,10 +2552,12 @@ static bool processResponse(uAtClientInstance_t *pClient,
                         // between it and where we are now to read
                         pTmp = pMemStr(U_AT_CLIENT_DATA_BUFFER_PTR(pClient->pReceiveBuffer) +
                                        pClient->pReceiveBuffer->readIndex,
-                                       pClient->pReceiveBuffer->length,
+                                       pClient->pReceiveBuffer->length -
+                                       pClient->pReceiveBuffer->readIndex,
                                        U_AT_CLIENT_CRLF, U_AT_CLIENT_CRLF_LENGTH_BYTES);
                         if ((pTmp != NULL) &&
-                            (pTmp - U_AT_CLIENT_DATA_BUFFER_PTR(pClient->pReceiveBuffer)) > 0) {
+                            (pTmp - (U_AT_CLIENT_DATA_BUFFER_PTR(pClient->pReceiveBuffer) +
+                                     pClient->pReceiveBuffer->readIndex)) > 0) {
                             // There is a CR/LF after some stuff
                             // to read and there was no prefix,
                             // so return now so that the caller
@@ -2212,6 +2758,7 @@ static size_t write(uAtClientInstance_t *pClient,
     // if *everything* was written
     if (pClient->error == U_ERROR_COMMON_SUCCESS) {
         printAt(pClient, pDataStart, length);
+        metricsBytes(pClient, 0, length);
     } else {
         length = 0;
     }
@@ -2244,7 +2791,8 @@ static bool writeCheckAndDelimit(uAtClientInstance_t *pClient)
     return isOk;
 }
 
-// Check if a URC handler is already in the list.
+// Check if a URC handler is already in the list; this doesn't
+// use the trie since that may only be read with the stream locked.
 static bool findUrcHandler(const uAtClientInstance_t *pClient,
                            const char *pPrefix)
 {
@@ -2435,6 +2983,11 @@ static void urcCallback(int32_t streamHandle, uint32_t eventBitmask,
 
     if ((pClient != NULL) &&
         (pClient->streamHandle == streamHandle)) {
+        if ((eventBitmask & U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED) &&
+            (pClient->dataSemaphore != NULL)) {
+            // Wake up anyone waiting in bufferFill()
+            uPortSemaphoreGive(pClient->dataSemaphore);
+        }
         if (uPortMutexTryLock(pClient->urcPermittedMutex, 0) == 0) {
 
             if (pClient->pUrcHijack != NULL) {
@@ -2477,7 +3030,8 @@ static void urcCallback(int32_t streamHandle, uint32_t eventBitmask,
                                     // If no bufferMatch was found, look for CR/LF
                                 } else if (pMemStr(U_AT_CLIENT_DATA_BUFFER_PTR(pReceiveBuffer) +
                                                    pReceiveBuffer->readIndex,
-                                                   pReceiveBuffer->length,
+                                                   pReceiveBuffer->length -
+                                                   pReceiveBuffer->readIndex,
                                                    U_AT_CLIENT_CRLF, U_AT_CLIENT_CRLF_LENGTH_BYTES) != NULL) {
                                     // Consume everything up to the CR/LF
                                     consumeToString(pClient, U_AT_CLIENT_CRLF);
@@ -2704,6 +3258,15 @@ uAtClientHandle_t uAtClientAdd(int32_t streamHandle,
                         pClient->delimiter = U_AT_CLIENT_DEFAULT_DELIMITER;
                         mutexStackInit(&(pClient->lockedStreamMutexStack));
                         pClient->delayMs = U_AT_CLIENT_DEFAULT_DELAY_MS;
+                        pClient->delayAdaptiveMinMs = -1;
+#ifdef U_CFG_AT_CLIENT_METRICS
+                        pClient->metricsCommandIndex = -1;
+#endif
+                        pClient->delayAdaptiveMs = pClient->delayMs;
+                        // Not fatal if this fails, bufferFill() just polls
+                        if (uPortSemaphoreCreate(&(pClient->dataSemaphore), 0, 1) != 0) {
+                            pClient->dataSemaphore = NULL;
+                        }
                         clearError(pClient);
                         // This will also set stopTag
                         setScope(pClient, U_AT_CLIENT_SCOPE_NONE);
@@ -2753,6 +3316,9 @@ uAtClientHandle_t uAtClientAdd(int32_t streamHandle,
 
                 if (errorCode != 0) {
                     // Clean up on failure
+                    if (pClient->dataSemaphore != NULL) {
+                        uPortSemaphoreDelete(pClient->dataSemaphore);
+                    }
                     if (pClient->urcPermittedMutex != NULL) {
                         uPortMutexDelete(pClient->urcPermittedMutex);
                     }
@@ -2949,7 +3515,42 @@ void uAtClientDelaySet(uAtClientHandle_t atHandle,
     // Keep Lint happy
     if (atHandle != NULL) {
         ((uAtClientInstance_t *) atHandle)->delayMs = delayMs;
+        ((uAtClientInstance_t *) atHandle)->delayAdaptiveMs = delayMs;
+    }
+}
+
+// Make the delay between AT commands adaptive.
+void uAtClientDelayAdaptiveSet(uAtClientHandle_t atHandle,
+                               int32_t delayMinMs)
+{
+    uAtClientInstance_t *pClient = (uAtClientInstance_t *) atHandle;
+
+    if (pClient != NULL) {
+
+        U_AT_CLIENT_LOCK_CLIENT_MUTEX(pClient);
+
+        pClient->delayAdaptiveMinMs = -1;
+        if ((delayMinMs >= 0) && (delayMinMs < pClient->delayMs)) {
+            pClient->delayAdaptiveMinMs = delayMinMs;
+        }
+        pClient->delayAdaptiveMs = pClient->delayMs;
+
+        U_AT_CLIENT_UNLOCK_CLIENT_MUTEX(pClient);
+    }
+}
+
+// Get the delay between AT commands currently in use.
+//lint -e{818} suppress "could be declared as pointing to const": it is!
+int32_t uAtClientDelayAdaptiveGet(const uAtClientHandle_t atHandle)
+{
+    const uAtClientInstance_t *pClient = (const uAtClientInstance_t *) atHandle;
+    int32_t delayMs = pClient->delayMs;
+
+    if (pClient->delayAdaptiveMinMs >= 0) {
+        delayMs = pClient->delayAdaptiveMs;
     }
+
+    return delayMs;
 }
 
 /* ----------------------------------------------------------------
@@ -2961,13 +3562,16 @@ void uAtClientLock(uAtClientHandle_t atHandle)
 {
     uAtClientInstance_t *pClient = (uAtClientInstance_t *) atHandle;
     uPortMutexHandle_t streamMutex;
+    int32_t startTimeMs;
 
     // IMPORTANT: this can't lock pClient->mutex as it
     // needs to wait on the stream mutex and if it locked
     // pClient->mutex that would prevent uAtClientUnlock()
     // from working.
     if ((pClient != NULL) && (pClient->streamMutex != NULL)) {
+        startTimeMs = uPortGetTickTimeMs();
         streamMutex = streamLock(pClient);
+        metricsStreamLock(pClient, uPortGetTickTimeMs() - startTimeMs);
         mutexStackPush(&(pClient->lockedStreamMutexStack), streamMutex);
         if (pClient->pActivityPin != NULL) {
             while (uPortGetTickTimeMs() - pClient->pActivityPin->lastToggleTime <
@@ -3024,6 +3628,9 @@ int32_t uAtClientUnlock(uAtClientHandle_t atHandle)
 
     U_AT_CLIENT_LOCK_CLIENT_MUTEX(pClient);
 
+    // In case the AT command never got as far as its final result
+    metricsCommandStop(pClient);
+
     streamMutex = mutexStackPop(&(pClient->lockedStreamMutexStack));
     if (streamMutex != NULL) {
         unlockNoDataCheck(pClient, streamMutex);
@@ -3101,18 +3708,26 @@ void uAtClientCommandStart(uAtClientHandle_t atHandle,
                            const char *pCommand)
 {
     uAtClientInstance_t *pClient = (uAtClientInstance_t *) atHandle;
+    int32_t delayMs;
 
     U_AT_CLIENT_LOCK_CLIENT_MUTEX(pClient);
 
     if (pClient->error == U_ERROR_COMMON_SUCCESS) {
-        // Wait for delay period if required, constructed this way
-        // to be safe if uPortGetTickTimeMs() wraps
-        if (pClient->delayMs > 0) {
-            while (uPortGetTickTimeMs() - pClient->lastResponseStopMs < pClient->delayMs) {
-                uPortTaskBlock(10);
+        // Wait for what remains of the delay period if required,
+        // constructed this way to be safe if uPortGetTickTimeMs() wraps
+        delayMs = pClient->delayMs;
+        if (pClient->delayAdaptiveMinMs >= 0) {
+            delayMs = pClient->delayAdaptiveMs;
+        }
+        if (delayMs > 0) {
+            delayMs -= uPortGetTickTimeMs() - pClient->lastResponseStopMs;
+            if ((delayMs > 0) && (delayMs <= pClient->delayMs)) {
+                uPortTaskBlock(delayMs);
             }
         }
 
+        metricsCommandStart(pClient, pCommand);
+
         // Send the command, no delimiter at first
         pClient->delimiterRequired = false;
         // Note: allow pCommand to be NULL here only
@@ -3375,6 +3990,17 @@ int32_t uAtClientReadBytes(uAtClientHandle_t atHandle,
 
     U_AT_CLIENT_LOCK_CLIENT_MUTEX(pClient);
 
+    if ((pStopTag->pTagDef->length == 0) &&
+        (pClient->error == U_ERROR_COMMON_SUCCESS)) {
+        // No stop tag to look for, e.g. binary data: rather
+        // than a character at a time, copy across whole
+        // spans of the receive buffer
+        lengthRead = readSpans(pClient, lengthBytes, pBuffer, NULL, NULL);
+        if (lengthRead < 0) {
+            lengthRead = 0;
+        }
+    }
+
     while ((lengthRead < ((int32_t) lengthBytes + matchPos)) &&
            (pClient->error == U_ERROR_COMMON_SUCCESS) &&
            !pStopTag->found) {
@@ -3456,6 +4082,42 @@ int32_t uAtClientReadBytes(uAtClientHandle_t atHandle,
     return lengthRead;
 }
 
+// Read bytes, handing them over as spans of the receive buffer.
+int32_t uAtClientReadBytesSpan(uAtClientHandle_t atHandle,
+                               size_t lengthBytes,
+                               void (*pCallback) (const char *pSpan,
+                                                  size_t length,
+                                                  void *pParam),
+                               void *pParam)
+{
+    uAtClientInstance_t *pClient = (uAtClientInstance_t *) atHandle;
+    int32_t lengthRead;
+
+    U_AT_CLIENT_LOCK_CLIENT_MUTEX(pClient);
+
+    lengthRead = readSpans(pClient, lengthBytes, NULL, pCallback, pParam);
+
+    U_AT_CLIENT_UNLOCK_CLIENT_MUTEX(pClient);
+
+    return lengthRead;
+}
+
+// Read a hex string parameter, decoding it into binary.
+int32_t uAtClientReadHexData(uAtClientHandle_t atHandle,
+                             char *pBuffer, size_t lengthBytes)
+{
+    uAtClientInstance_t *pClient = (uAtClientInstance_t *) atHandle;
+    int32_t lengthRead;
+
+    U_AT_CLIENT_LOCK_CLIENT_MUTEX(pClient);
+
+    lengthRead = readHexData(pClient, pBuffer, lengthBytes);
+
+    U_AT_CLIENT_UNLOCK_CLIENT_MUTEX(pClient);
+
+    return lengthRead;
+}
+
 // Stop the response part of an AT sequence.
 void uAtClientResponseStop(uAtClientHandle_t atHandle)
 {
@@ -3472,6 +4134,21 @@ void uAtClientResponseStop(uAtClientHandle_t atHandle)
         setScope(pClient, U_AT_CLIENT_SCOPE_NONE);
     }
 
+    metricsCommandStop(pClient);
+
+    if (pClient->delayAdaptiveMinMs >= 0) {
+        if ((pClient->error == U_ERROR_COMMON_SUCCESS) &&
+            (pClient->deviceError.type == U_AT_CLIENT_DEVICE_ERROR_TYPE_NO_ERROR)) {
+            // The AT server kept up: try a little less delay next time
+            if (pClient->delayAdaptiveMs > pClient->delayAdaptiveMinMs) {
+                pClient->delayAdaptiveMs--;
+            }
+        } else {
+            // Something went wrong, back to the full delay
+            pClient->delayAdaptiveMs = pClient->delayMs;
+        }
+    }
+
     pClient->lastResponseStopMs = uPortGetTickTimeMs();
 
     U_AT_CLIENT_UNLOCK_CLIENT_MUTEX(pClient);
@@ -3641,7 +4318,7 @@ int32_t uAtClientWaitCharacter(uAtClientHandle_t atHandle,
                 } else {
                     // Remove the processed stuff from the buffer
                     bufferRewind(pClient);
-                    if (pReceiveBuffer->length == 0) {
+                    if (pReceiveBuffer->readIndex >= pReceiveBuffer->length) {
                         // If there's nothing left, try to get more stuff
                         if (!bufferFill(pClient, true)) {
                             // If we don't get any data within
@@ -3725,6 +4402,7 @@ int32_t uAtClientSetUrcHandler(uAtClientHandle_t atHandle,
 
         pUrc->pNext = pClient->pUrcList;
         pClient->pUrcList = pUrc;
+        urcTrieReplace(pClient);
 
         U_PORT_MUTEX_UNLOCK(pClient->urcPermittedMutex);
     }
@@ -3756,6 +4434,7 @@ void uAtClientRemoveUrcHandler(uAtClientHandle_t atHandle,
             } else {
                 pClient->pUrcList = pCurrent->pNext;
             }
+            urcTrieReplace(pClient);
 
             U_PORT_MUTEX_UNLOCK(pClient->urcPermittedMutex);
 
@@ -4060,6 +4739,21 @@ void uAtClientStreamInterceptRx(uAtClientHandle_t atHandle,
     U_AT_CLIENT_UNLOCK_CLIENT_MUTEX(pClient);
 }
 
+// Get whether an intercept function is installed.
+bool uAtClientStreamInterceptIsSet(uAtClientHandle_t atHandle)
+{
+    uAtClientInstance_t *pClient = (uAtClientInstance_t *) atHandle;
+    bool isSet;
+
+    U_AT_CLIENT_LOCK_CLIENT_MUTEX(pClient);
+
+    isSet = (pClient->pInterceptTx != NULL) || (pClient->pInterceptRx != NULL);
+
+    U_AT_CLIENT_UNLOCK_CLIENT_MUTEX(pClient);
+
+    return isSet;
+}
+
 // Set a wake-up handler function.
 int32_t uAtClientSetWakeUpHandler(uAtClientHandle_t atHandle,
                                   int32_t (*pHandler) (uAtClientHandle_t,
@@ -4267,4 +4961,198 @@ int32_t uAtClientGetActivityPinSettings(const uAtClientHandle_t atHandle,
     return activityPin;
 }
 
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS: METRICS
+ * -------------------------------------------------------------- */
+
+// Start collecting metrics.
+int32_t uAtClientMetricsOn(uAtClientHandle_t atHandle)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+#ifdef U_CFG_AT_CLIENT_METRICS
+    uAtClientInstance_t *pClient = (uAtClientInstance_t *) atHandle;
+    uAtClientMetrics_t *pMetrics;
+    uPortMutexHandle_t streamMutex;
+
+    errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    if (pClient != NULL) {
+        errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+        pMetrics = (uAtClientMetrics_t *) pUPortMalloc(sizeof(*pMetrics));
+        if (pMetrics != NULL) {
+            memset(pMetrics, 0, sizeof(*pMetrics));
+
+            // Metrics are updated by whoever has the stream locked,
+            // which may be the URC task, so swap them under that lock
+            streamMutex = streamLock(pClient);
+            U_AT_CLIENT_LOCK_CLIENT_MUTEX(pClient);
+
+            uPortFree(pClient->pMetrics);
+            pClient->pMetrics = pMetrics;
+            pClient->metricsCommandIndex = -1;
+            pClient->metricsStartMs = uPortGetTickTimeMs();
+
+            U_AT_CLIENT_UNLOCK_CLIENT_MUTEX(pClient);
+            uPortMutexUnlock(streamMutex);
+
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        }
+    }
+#else
+    (void) atHandle;
+#endif
+
+    return errorCode;
+}
+
+// Stop collecting metrics.
+void uAtClientMetricsOff(uAtClientHandle_t atHandle)
+{
+#ifdef U_CFG_AT_CLIENT_METRICS
+    uAtClientInstance_t *pClient = (uAtClientInstance_t *) atHandle;
+    uPortMutexHandle_t streamMutex;
+
+    if (pClient != NULL) {
+        streamMutex = streamLock(pClient);
+        U_AT_CLIENT_LOCK_CLIENT_MUTEX(pClient);
+
+        uPortFree(pClient->pMetrics);
+        pClient->pMetrics = NULL;
+        pClient->metricsCommandIndex = -1;
+
+        U_AT_CLIENT_UNLOCK_CLIENT_MUTEX(pClient);
+        uPortMutexUnlock(streamMutex);
+    }
+#else
+    (void) atHandle;
+#endif
+}
+
+// Get the metrics.
+int32_t uAtClientMetricsGet(uAtClientHandle_t atHandle,
+                            uAtClientMetrics_t *pMetrics)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+#ifdef U_CFG_AT_CLIENT_METRICS
+    uAtClientInstance_t *pClient = (uAtClientInstance_t *) atHandle;
+    uPortMutexHandle_t streamMutex;
+
+    errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    if ((pClient != NULL) && (pMetrics != NULL)) {
+        streamMutex = streamLock(pClient);
+        U_AT_CLIENT_LOCK_CLIENT_MUTEX(pClient);
+
+        errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+        if (pClient->pMetrics != NULL) {
+            pClient->pMetrics->durationMs = uPortGetTickTimeMs() - pClient->metricsStartMs;
+            memcpy(pMetrics, pClient->pMetrics, sizeof(*pMetrics));
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        }
+
+        U_AT_CLIENT_UNLOCK_CLIENT_MUTEX(pClient);
+        uPortMutexUnlock(streamMutex);
+    }
+#else
+    (void) atHandle;
+    (void) pMetrics;
+#endif
+
+    return errorCode;
+}
+
+// Print the metrics.
+void uAtClientMetricsPrint(uAtClientHandle_t atHandle)
+{
+#ifdef U_CFG_AT_CLIENT_METRICS
+    uAtClientInstance_t *pClient = (uAtClientInstance_t *) atHandle;
+    uAtClientMetrics_t *pMetrics;
+    const uAtClientMetricsCommand_t *pCommand;
+    const uAtClientMetricsUrc_t *pUrc;
+
+    if (pClient != NULL) {
+        pMetrics = (uAtClientMetrics_t *) pUPortMalloc(sizeof(*pMetrics));
+        if ((pMetrics != NULL) && (uAtClientMetricsGet(atHandle, pMetrics) == 0)) {
+            uPortLog("U_AT_CLIENT_%d-%d: metrics over %d ms: %d byte(s) in,"
+                     " %d byte(s) out, %d timeout(s), %d ms in URC handlers.\n",
+                     pClient->streamType, pClient->streamHandle,
+                     pMetrics->durationMs, (int32_t) pMetrics->bytesIn,
+                     (int32_t) pMetrics->bytesOut, pMetrics->timeoutCount,
+                     pMetrics->urcTimeTotalMs);
+            uPortLog("U_AT_CLIENT_%d-%d: stream locked %d time(s), %d contended,"
+                     " %d ms waiting.\n", pClient->streamType, pClient->streamHandle,
+                     pMetrics->streamLockCount, pMetrics->streamLockContendedCount,
+                     pMetrics->streamLockWaitTotalMs);
+            uPortLog("U_AT_CLIENT_%d-%d: %-*s %7s %6s %8s %6s %6s %6s %6s (ms)\n",
+                     pClient->streamType, pClient->streamHandle,
+                     U_AT_CLIENT_METRICS_PREFIX_MAX_LENGTH_BYTES, "command",
+                     "count", "errors", "timeouts", "min", "mean", "p99", "max");
+            for (size_t x = 0; x < pMetrics->numCommands; x++) {
+                pCommand = &(pMetrics->command[x]);
+                uPortLog("U_AT_CLIENT_%d-%d: %-*s %7d %6d %8d %6d %6d %6d %6d\n",
+                         pClient->streamType, pClient->streamHandle,
+                         U_AT_CLIENT_METRICS_PREFIX_MAX_LENGTH_BYTES, pCommand->prefix,
+                         pCommand->count, pCommand->errorCount, pCommand->timeoutCount,
+                         pCommand->latencyMinMs,
+                         (int32_t) (pCommand->latencyTotalMs / pCommand->count),
+                         uAtClientMetricsLatencyPercentileMs(pCommand, 99),
+                         pCommand->latencyMaxMs);
+            }
+            if (pMetrics->commandUntrackedCount > 0) {
+                uPortLog("U_AT_CLIENT_%d-%d: (plus %d command(s) not tracked).\n",
+                         pClient->streamType, pClient->streamHandle,
+                         pMetrics->commandUntrackedCount);
+            }
+            uPortLog("U_AT_CLIENT_%d-%d: %-*s %7s %6s %8s (ms)\n",
+                     pClient->streamType, pClient->streamHandle,
+                     U_AT_CLIENT_METRICS_PREFIX_MAX_LENGTH_BYTES, "URC",
+                     "count", "total", "max");
+            for (size_t x = 0; x < pMetrics->numUrcs; x++) {
+                pUrc = &(pMetrics->urc[x]);
+                uPortLog("U_AT_CLIENT_%d-%d: %-*s %7d %6d %8d\n",
+                         pClient->streamType, pClient->streamHandle,
+                         U_AT_CLIENT_METRICS_PREFIX_MAX_LENGTH_BYTES, pUrc->prefix,
+                         pUrc->count, pUrc->handlerTimeTotalMs, pUrc->handlerTimeMaxMs);
+            }
+            if (pMetrics->urcUntrackedCount > 0) {
+                uPortLog("U_AT_CLIENT_%d-%d: (plus %d URC(s) not tracked).\n",
+                         pClient->streamType, pClient->streamHandle,
+                         pMetrics->urcUntrackedCount);
+            }
+        }
+        uPortFree(pMetrics);
+    }
+#else
+    (void) atHandle;
+#endif
+}
+
+// Work out a latency percentile.
+int32_t uAtClientMetricsLatencyPercentileMs(const uAtClientMetricsCommand_t *pCommand,
+                                            int32_t percentile)
+{
+    int32_t errorCodeOrLatencyMs = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    int64_t wanted;
+    int64_t total = 0;
+    size_t bucket = 0;
+
+    if ((pCommand != NULL) && (percentile > 0) && (percentile <= 100)) {
+        errorCodeOrLatencyMs = 0;
+        if (pCommand->count > 0) {
+            // The number of samples at or below the percentile, rounded up
+            wanted = (((int64_t) pCommand->count * percentile) + 99) / 100;
+            while ((bucket < sizeof(pCommand->latencyBucket) / sizeof(pCommand->latencyBucket[0])) &&
+                   (total + pCommand->latencyBucket[bucket] < wanted)) {
+                total += pCommand->latencyBucket[bucket];
+                bucket++;
+            }
+            // The top of the bucket, but no more than the maximum seen
+            errorCodeOrLatencyMs = pCommand->latencyMaxMs;
+            if ((bucket < 31) && (((1 << bucket) - 1) < errorCodeOrLatencyMs)) {
+                errorCodeOrLatencyMs = (1 << bucket) - 1;
+            }
+        }
+    }
+
+    return errorCodeOrLatencyMs;
+}
+
 // End of file
@@ -0,0 +1,903 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Only #includes of u_* and the C standard library are allowed here,
+ * no platform stuff and no OS stuff.  Anything required from
+ * the platform/OS must be brought in through u_port* to maintain
+ * portability.
+ */
+
+/** @file
+ * @brief Implementation of AT transcript recording and of the
+ * virtual serial device that replays a transcript.
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+#include "string.h"    // memcpy(), memcmp(), memmove()
+
+#include "u_cfg_os_platform_specific.h" // U_CFG_OS_YIELD_MS
+
+#include "u_error_common.h"
+
+#include "u_port.h"
+#include "u_port_heap.h"
+#include "u_port_os.h"
+
+#include "u_interface.h"
+#include "u_device_serial.h"
+
+#include "u_at_client.h"
+#include "u_at_client_transcript.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** The maximum length of the data in one transcript record.
+ */
+#define U_AT_CLIENT_TRANSCRIPT_RECORD_MAX_LENGTH_BYTES 0xFFFF
+
+/** The maximum size of the header of a record: the type byte,
+ * up to five bytes of time and two bytes of length.
+ */
+#define U_AT_CLIENT_TRANSCRIPT_RECORD_HEADER_MAX_SIZE_BYTES 8
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** The context of a replay device.
+ */
+typedef struct {
+    const char *pTranscript;
+    size_t length;
+    size_t offset; /**< Offset of the next record in pTranscript. */
+    char recordType; /**< Type of the current record, zero if none. */
+    const char *pRecordData;
+    size_t recordLength;
+    size_t recordDone; /**< How much of the current record has been replayed. */
+    bool recordMismatch; /**< True if what was written didn't match the current record. */
+    int32_t recordDueMs; /**< When the current record is due, if it is received data. */
+    int32_t baseTimeMs; /**< The time that the previous record completed. */
+    int32_t timeScalePercent;
+    uPortMutexHandle_t mutex;
+    bool isOpen;
+    char *pRxBuffer;
+    size_t rxBufferSize;
+    bool rxBufferIsMalloced;
+    size_t rxReadIndex;
+    size_t rxLength;
+    void (*pEventCallback)(struct uDeviceSerial_t *, uint32_t, void *);
+    void *pEventCallbackParam;
+    uint32_t eventFilter;
+    uint32_t eventBitMapPending;
+    uPortTaskHandle_t taskHandle;
+    uPortMutexHandle_t taskRunningMutex;
+    uPortSemaphoreHandle_t taskWakeSemaphore;
+    volatile bool taskExit;
+    uAtClientTranscriptReplayStats_t stats;
+} uAtClientTranscriptReplay_t;
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/** The header of a transcript.
+ */
+static const char gHeader[U_AT_CLIENT_TRANSCRIPT_HEADER_SIZE_BYTES] = {'u', 'A', 'T',
+                                                                       U_AT_CLIENT_TRANSCRIPT_VERSION
+                                                                      };
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS: RECORD
+ * -------------------------------------------------------------- */
+
+// Read the length field of the last record.
+static size_t recordLengthGet(const uAtClientTranscriptRecord_t *pRecord)
+{
+    const uint8_t *pLength = (const uint8_t *) pRecord->pBuffer + pRecord->lastRecordOffset;
+
+    return (size_t) *pLength + (((size_t) * (pLength + 1)) << 8);
+}
+
+// Write the length field of the last record.
+static void recordLengthSet(uAtClientTranscriptRecord_t *pRecord, size_t length)
+{
+    char *pLength = pRecord->pBuffer + pRecord->lastRecordOffset;
+
+    *pLength = (char) (length & 0xFF);
+    *(pLength + 1) = (char) ((length >> 8) & 0xFF);
+}
+
+// Add data to a transcript, merging it into the previous
+// record where possible.
+static void recordData(uAtClientTranscriptRecord_t *pRecord,
+                       char type, const char *pData, size_t length)
+{
+    int32_t nowMs = uPortGetTickTimeMs();
+    char header[U_AT_CLIENT_TRANSCRIPT_RECORD_HEADER_MAX_SIZE_BYTES];
+    size_t headerLength;
+    size_t recordLength = 0;
+    uint32_t deltaMs;
+    bool merge;
+    size_t x;
+
+    // Once something has been lost the rest of the
+    // transcript would be misleading, so stop there
+    while ((length > 0) && (pRecord->bytesLost == 0)) {
+        merge = (pRecord->lastRecordType == type) &&
+                ((type == U_AT_CLIENT_TRANSCRIPT_RECORD_TYPE_TX) ||
+                 (nowMs - pRecord->lastDataTimeMs <= U_AT_CLIENT_TRANSCRIPT_RX_MERGE_MS));
+        if (merge) {
+            recordLength = recordLengthGet(pRecord);
+            merge = (recordLength < U_AT_CLIENT_TRANSCRIPT_RECORD_MAX_LENGTH_BYTES);
+        }
+        if (!merge) {
+            // Start a new record
+            header[0] = type;
+            headerLength = 1;
+            deltaMs = (uint32_t) (nowMs - pRecord->lastRecordTimeMs);
+            do {
+                header[headerLength] = (char) (deltaMs & 0x7F);
+                deltaMs >>= 7;
+                if (deltaMs > 0) {
+                    header[headerLength] |= 0x80;
+                }
+                headerLength++;
+            } while (deltaMs > 0);
+            header[headerLength] = 0;
+            header[headerLength + 1] = 0;
+            headerLength += 2;
+            // Only worth it if there's room for some data too
+            if (pRecord->length + headerLength < pRecord->size) {
+                memcpy(pRecord->pBuffer + pRecord->length, header, headerLength);
+                pRecord->length += headerLength;
+                pRecord->lastRecordOffset = pRecord->length - 2;
+                pRecord->lastRecordType = type;
+                pRecord->lastRecordTimeMs = nowMs;
+                recordLength = 0;
+            } else {
+                break;
+            }
+        }
+        x = length;
+        if (x > U_AT_CLIENT_TRANSCRIPT_RECORD_MAX_LENGTH_BYTES - recordLength) {
+            x = U_AT_CLIENT_TRANSCRIPT_RECORD_MAX_LENGTH_BYTES - recordLength;
+        }
+        if (x > pRecord->size - pRecord->length) {
+            x = pRecord->size - pRecord->length;
+        }
+        if (x == 0) {
+            break;
+        }
+        memcpy(pRecord->pBuffer + pRecord->length, pData, x);
+        pRecord->length += x;
+        recordLengthSet(pRecord, recordLength + x);
+        pRecord->lastDataTimeMs = nowMs;
+        pData += x;
+        length -= x;
+    }
+
+    pRecord->bytesLost += length;
+}
+
+// The transmit intercept function: record and pass everything on.
+static const char *pInterceptTx(uAtClientHandle_t atHandle,
+                                const char **ppData,
+                                size_t *pLength,
+                                void *pContext)
+{
+    const char *pData = NULL;
+
+    (void) atHandle;
+
+    if (ppData != NULL) {
+        pData = *ppData;
+        if (*pLength > 0) {
+            recordData((uAtClientTranscriptRecord_t *) pContext,
+                       U_AT_CLIENT_TRANSCRIPT_RECORD_TYPE_TX,
+                       pData, *pLength);
+        }
+        *ppData += *pLength;
+    } else {
+        // A flush: we hold nothing back
+        *pLength = 0;
+    }
+
+    return pData;
+}
+
+// The receive intercept function: record and pass everything on.
+static char *pInterceptRx(uAtClientHandle_t atHandle,
+                          char **ppData, size_t *pLength,
+                          void *pContext)
+{
+    char *pData = NULL;
+
+    (void) atHandle;
+
+    if ((ppData != NULL) && (*pLength > 0)) {
+        pData = *ppData;
+        recordData((uAtClientTranscriptRecord_t *) pContext,
+                   U_AT_CLIENT_TRANSCRIPT_RECORD_TYPE_RX,
+                   pData, *pLength);
+        *ppData += *pLength;
+    } else {
+        *pLength = 0;
+    }
+
+    return pData;
+}
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS: REPLAY
+ * -------------------------------------------------------------- */
+
+// Parse the header of the record at the given offset into a
+// transcript, returning the offset of the data of the record
+// or zero if there is no valid record there.
+static size_t replayRecordParse(const char *pTranscript, size_t length,
+                                size_t offset, char *pType,
+                                uint32_t *pDeltaMs, size_t *pRecordLength)
+{
+    size_t dataOffset = 0;
+    uint32_t deltaMs = 0;
+    int32_t shift = 0;
+    uint8_t byte = 0x80;
+
+    if (offset < length) {
+        *pType = *(pTranscript + offset);
+        offset++;
+        while ((offset < length) && ((byte & 0x80) != 0) && (shift < 32)) {
+            byte = (uint8_t) *(pTranscript + offset);
+            deltaMs |= ((uint32_t) (byte & 0x7F)) << shift;
+            shift += 7;
+            offset++;
+        }
+        if (((*pType == U_AT_CLIENT_TRANSCRIPT_RECORD_TYPE_TX) ||
+             (*pType == U_AT_CLIENT_TRANSCRIPT_RECORD_TYPE_RX)) &&
+            ((byte & 0x80) == 0) && (offset + 2 <= length)) {
+            *pRecordLength = (size_t) (uint8_t) *(pTranscript + offset) +
+                             (((size_t) (uint8_t) * (pTranscript + offset + 1)) << 8);
+            offset += 2;
+            if (offset + *pRecordLength <= length) {
+                *pDeltaMs = deltaMs;
+                dataOffset = offset;
+            }
+        }
+    }
+
+    return dataOffset;
+}
+
+// Move the replay on: start the next record if the current one
+// is done and, if the current record is of received data which is
+// due (or flushRx is true), copy it into the receive buffer.
+// Returns true if data was added to the receive buffer.
+// pReplay->mutex should be locked before this is called.
+static bool replayAdvance(uAtClientTranscriptReplay_t *pReplay, bool flushRx)
+{
+    bool released = false;
+    bool keepGoing = true;
+    int32_t nowMs = uPortGetTickTimeMs();
+    size_t dataOffset;
+    uint32_t deltaMs = 0;
+    char type = 0;
+    size_t x;
+
+    while (keepGoing) {
+        keepGoing = false;
+        if (pReplay->recordType == 0) {
+            dataOffset = replayRecordParse(pReplay->pTranscript, pReplay->length,
+                                           pReplay->offset, &type, &deltaMs,
+                                           &(pReplay->recordLength));
+            if (dataOffset > 0) {
+                pReplay->recordType = type;
+                pReplay->pRecordData = pReplay->pTranscript + dataOffset;
+                pReplay->recordDone = 0;
+                pReplay->recordMismatch = false;
+                pReplay->recordDueMs = pReplay->baseTimeMs +
+                                       (int32_t) (((int64_t) deltaMs * pReplay->timeScalePercent) / 100);
+                pReplay->offset = dataOffset + pReplay->recordLength;
+            } else {
+                // The end or something we can't understand
+                pReplay->offset = pReplay->length;
+            }
+        }
+        if ((pReplay->recordType == U_AT_CLIENT_TRANSCRIPT_RECORD_TYPE_RX) &&
+            (flushRx || (nowMs - pReplay->recordDueMs >= 0))) {
+            // Make the free space in the receive buffer contiguous
+            if ((pReplay->rxReadIndex > 0) && (pReplay->rxLength > 0)) {
+                memmove(pReplay->pRxBuffer, pReplay->pRxBuffer + pReplay->rxReadIndex,
+                        pReplay->rxLength);
+            }
+            pReplay->rxReadIndex = 0;
+            x = pReplay->recordLength - pReplay->recordDone;
+            if (x > pReplay->rxBufferSize - pReplay->rxLength) {
+                x = pReplay->rxBufferSize - pReplay->rxLength;
+            }
+            if (x > 0) {
+                memcpy(pReplay->pRxBuffer + pReplay->rxLength,
+                       pReplay->pRecordData + pReplay->recordDone, x);
+                pReplay->rxLength += x;
+                pReplay->recordDone += x;
+                released = true;
+            }
+            if (flushRx && (pReplay->recordDone < pReplay->recordLength)) {
+                // The AT client has moved on without reading what was
+                // sent: what doesn't fit is lost, as it would be on a UART
+                pReplay->stats.bytesOverflow += pReplay->recordLength - pReplay->recordDone;
+                pReplay->recordDone = pReplay->recordLength;
+            }
+            if (pReplay->recordDone >= pReplay->recordLength) {
+                // Time the next record from when this one was due,
+                // rather than from when someone happened to look
+                pReplay->baseTimeMs = flushRx ? nowMs : pReplay->recordDueMs;
+                pReplay->recordType = 0;
+                pReplay->stats.recordsReplayed++;
+                keepGoing = true;
+            }
+        }
+    }
+
+    return released;
+}
+
+// The task that sends events to the event callback of a replay device.
+static void replayTask(void *pParam)
+{
+    uDeviceSerial_t *pDeviceSerial = (uDeviceSerial_t *) pParam;
+    uAtClientTranscriptReplay_t *pReplay = (uAtClientTranscriptReplay_t *)
+                                           pUInterfaceContext(pDeviceSerial);
+    uint32_t eventBitMap;
+    int32_t waitMs;
+
+    U_PORT_MUTEX_LOCK(pReplay->taskRunningMutex);
+
+    while (!pReplay->taskExit) {
+        U_PORT_MUTEX_LOCK(pReplay->mutex);
+
+        eventBitMap = pReplay->eventBitMapPending;
+        pReplay->eventBitMapPending = 0;
+        if (replayAdvance(pReplay, false)) {
+            eventBitMap |= U_DEVICE_SERIAL_EVENT_BITMASK_DATA_RECEIVED;
+        }
+        eventBitMap &= pReplay->eventFilter;
+        waitMs = U_AT_CLIENT_TRANSCRIPT_REPLAY_IDLE_MS;
+        if (pReplay->recordType == U_AT_CLIENT_TRANSCRIPT_RECORD_TYPE_RX) {
+            // Wake up when the next lot of received data is due;
+            // if it is already due then the receive buffer must be
+            // full so don't spin
+            waitMs = pReplay->recordDueMs - uPortGetTickTimeMs();
+            if (waitMs < U_CFG_OS_YIELD_MS) {
+                waitMs = U_CFG_OS_YIELD_MS;
+            }
+            if (waitMs > U_AT_CLIENT_TRANSCRIPT_REPLAY_IDLE_MS) {
+                waitMs = U_AT_CLIENT_TRANSCRIPT_REPLAY_IDLE_MS;
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK(pReplay->mutex);
+
+        if (eventBitMap != 0) {
+            pReplay->pEventCallback(pDeviceSerial, eventBitMap,
+                                    pReplay->pEventCallbackParam);
+        }
+
+        uPortSemaphoreTryTake(pReplay->taskWakeSemaphore, waitMs);
+    }
+
+    U_PORT_MUTEX_UNLOCK(pReplay->taskRunningMutex);
+
+    // Delete ourself
+    uPortTaskDelete(NULL);
+}
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS: REPLAY DEVICE IMPLEMENTATION
+ * -------------------------------------------------------------- */
+
+// Remove the event callback of a replay device, stopping its task.
+static void replayEventCallbackRemove(struct uDeviceSerial_t *pDeviceSerial)
+{
+    uAtClientTranscriptReplay_t *pReplay = (uAtClientTranscriptReplay_t *)
+                                           pUInterfaceContext(pDeviceSerial);
+
+    if (pReplay->taskHandle != NULL) {
+        pReplay->taskExit = true;
+        uPortSemaphoreGive(pReplay->taskWakeSemaphore);
+        U_PORT_MUTEX_LOCK(pReplay->taskRunningMutex);
+        U_PORT_MUTEX_UNLOCK(pReplay->taskRunningMutex);
+        // Let the task actually exit
+        uPortTaskBlock(U_CFG_OS_YIELD_MS);
+        uPortMutexDelete(pReplay->taskRunningMutex);
+        uPortSemaphoreDelete(pReplay->taskWakeSemaphore);
+        U_PORT_MUTEX_LOCK(pReplay->mutex);
+        pReplay->taskHandle = NULL;
+        pReplay->taskRunningMutex = NULL;
+        pReplay->taskWakeSemaphore = NULL;
+        pReplay->pEventCallback = NULL;
+        pReplay->pEventCallbackParam = NULL;
+        pReplay->eventFilter = 0;
+        pReplay->eventBitMapPending = 0;
+        U_PORT_MUTEX_UNLOCK(pReplay->mutex);
+    }
+}
+
+// Open a replay device, starting the replay from the beginning.
+static int32_t replayOpen(struct uDeviceSerial_t *pDeviceSerial,
+                          void *pReceiveBuffer,
+                          size_t receiveBufferSizeBytes)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uAtClientTranscriptReplay_t *pReplay = (uAtClientTranscriptReplay_t *)
+                                           pUInterfaceContext(pDeviceSerial);
+
+    if (receiveBufferSizeBytes > 0) {
+        U_PORT_MUTEX_LOCK(pReplay->mutex);
+
+        errorCode = (int32_t) U_ERROR_COMMON_BUSY;
+        if (!pReplay->isOpen) {
+            errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+            pReplay->pRxBuffer = (char *) pReceiveBuffer;
+            pReplay->rxBufferIsMalloced = false;
+            if (pReplay->pRxBuffer == NULL) {
+                pReplay->pRxBuffer = (char *) pUPortMalloc(receiveBufferSizeBytes);
+                pReplay->rxBufferIsMalloced = true;
+            }
+            if (pReplay->pRxBuffer != NULL) {
+                pReplay->rxBufferSize = receiveBufferSizeBytes;
+                pReplay->rxReadIndex = 0;
+                pReplay->rxLength = 0;
+                pReplay->offset = U_AT_CLIENT_TRANSCRIPT_HEADER_SIZE_BYTES;
+                pReplay->recordType = 0;
+                pReplay->baseTimeMs = uPortGetTickTimeMs();
+                memset(&(pReplay->stats), 0, sizeof(pReplay->stats));
+                pReplay->isOpen = true;
+                errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK(pReplay->mutex);
+    }
+
+    return errorCode;
+}
+
+// Close a replay device.
+static void replayClose(struct uDeviceSerial_t *pDeviceSerial)
+{
+    uAtClientTranscriptReplay_t *pReplay = (uAtClientTranscriptReplay_t *)
+                                           pUInterfaceContext(pDeviceSerial);
+
+    replayEventCallbackRemove(pDeviceSerial);
+
+    U_PORT_MUTEX_LOCK(pReplay->mutex);
+
+    if (pReplay->isOpen) {
+        if (pReplay->rxBufferIsMalloced) {
+            uPortFree(pReplay->pRxBuffer);
+        }
+        pReplay->pRxBuffer = NULL;
+        pReplay->isOpen = false;
+    }
+
+    U_PORT_MUTEX_UNLOCK(pReplay->mutex);
+}
+
+// Get the number of bytes waiting to be read from a replay device.
+static int32_t replayGetReceiveSize(struct uDeviceSerial_t *pDeviceSerial)
+{
+    int32_t errorCodeOrSize = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uAtClientTranscriptReplay_t *pReplay = (uAtClientTranscriptReplay_t *)
+                                           pUInterfaceContext(pDeviceSerial);
+
+    U_PORT_MUTEX_LOCK(pReplay->mutex);
+
+    if (pReplay->isOpen) {
+        replayAdvance(pReplay, false);
+        errorCodeOrSize = (int32_t) pReplay->rxLength;
+    }
+
+    U_PORT_MUTEX_UNLOCK(pReplay->mutex);
+
+    return errorCodeOrSize;
+}
+
+// Read from a replay device.
+static int32_t replayRead(struct uDeviceSerial_t *pDeviceSerial,
+                          void *pBuffer, size_t sizeBytes)
+{
+    int32_t errorCodeOrLength = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uAtClientTranscriptReplay_t *pReplay = (uAtClientTranscriptReplay_t *)
+                                           pUInterfaceContext(pDeviceSerial);
+
+    U_PORT_MUTEX_LOCK(pReplay->mutex);
+
+    if (pReplay->isOpen) {
+        replayAdvance(pReplay, false);
+        if (sizeBytes > pReplay->rxLength) {
+            sizeBytes = pReplay->rxLength;
+        }
+        memcpy(pBuffer, pReplay->pRxBuffer + pReplay->rxReadIndex, sizeBytes);
+        pReplay->rxReadIndex += sizeBytes;
+        pReplay->rxLength -= sizeBytes;
+        if (pReplay->rxLength == 0) {
+            pReplay->rxReadIndex = 0;
+        }
+        pReplay->stats.bytesRead += sizeBytes;
+        errorCodeOrLength = (int32_t) sizeBytes;
+    }
+
+    U_PORT_MUTEX_UNLOCK(pReplay->mutex);
+
+    return errorCodeOrLength;
+}
+
+// Write to a replay device, checking the data against the transcript.
+static int32_t replayWrite(struct uDeviceSerial_t *pDeviceSerial,
+                           const void *pBuffer, size_t sizeBytes)
+{
+    int32_t errorCodeOrLength = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uAtClientTranscriptReplay_t *pReplay = (uAtClientTranscriptReplay_t *)
+                                           pUInterfaceContext(pDeviceSerial);
+    const char *pData = (const char *) pBuffer;
+    size_t length = sizeBytes;
+    size_t x;
+
+    U_PORT_MUTEX_LOCK(pReplay->mutex);
+
+    if (pReplay->isOpen) {
+        pReplay->stats.bytesWritten += sizeBytes;
+        while (length > 0) {
+            // Anything the module sent before this in the
+            // transcript must be delivered before it now
+            replayAdvance(pReplay, true);
+            if (pReplay->recordType != U_AT_CLIENT_TRANSCRIPT_RECORD_TYPE_TX) {
+                break;
+            }
+            x = pReplay->recordLength - pReplay->recordDone;
+            if (x > length) {
+                x = length;
+            }
+            if (!pReplay->recordMismatch &&
+                (memcmp(pData, pReplay->pRecordData + pReplay->recordDone, x) != 0)) {
+                pReplay->recordMismatch = true;
+                pReplay->stats.mismatchCount++;
+            }
+            pData += x;
+            length -= x;
+            pReplay->recordDone += x;
+            if (pReplay->recordDone >= pReplay->recordLength) {
+                // Whatever the module sent in response is timed from now
+                pReplay->baseTimeMs = uPortGetTickTimeMs();
+                pReplay->recordType = 0;
+                pReplay->stats.recordsReplayed++;
+            }
+        }
+        pReplay->stats.bytesUnexpected += length;
+        errorCodeOrLength = (int32_t) sizeBytes;
+        if (pReplay->taskWakeSemaphore != NULL) {
+            // Let the task work out when to send the next event
+            uPortSemaphoreGive(pReplay->taskWakeSemaphore);
+        }
+    }
+
+    U_PORT_MUTEX_UNLOCK(pReplay->mutex);
+
+    return errorCodeOrLength;
+}
+
+// Set the event callback of a replay device, starting its task.
+static int32_t replayEventCallbackSet(struct uDeviceSerial_t *pDeviceSerial,
+                                      uint32_t filter,
+                                      void (*pFunction)(struct uDeviceSerial_t *,
+                                                        uint32_t,
+                                                        void *),
+                                      void *pParam,
+                                      size_t stackSizeBytes,
+                                      int32_t priority)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uAtClientTranscriptReplay_t *pReplay = (uAtClientTranscriptReplay_t *)
+                                           pUInterfaceContext(pDeviceSerial);
+
+    if ((filter != 0) && (pFunction != NULL)) {
+        U_PORT_MUTEX_LOCK(pReplay->mutex);
+
+        errorCode = (int32_t) U_ERROR_COMMON_BUSY;
+        if (pReplay->taskHandle == NULL) {
+            pReplay->pEventCallback = pFunction;
+            pReplay->pEventCallbackParam = pParam;
+            pReplay->eventFilter = filter;
+            pReplay->eventBitMapPending = 0;
+            pReplay->taskExit = false;
+            errorCode = uPortMutexCreate(&(pReplay->taskRunningMutex));
+            if (errorCode == 0) {
+                errorCode = uPortSemaphoreCreate(&(pReplay->taskWakeSemaphore), 0, 1);
+                if (errorCode == 0) {
+                    errorCode = uPortTaskCreate(replayTask, "atReplay", stackSizeBytes,
+                                                pDeviceSerial, priority,
+                                                &(pReplay->taskHandle));
+                    if (errorCode == 0) {
+                        // Wait for the task to lock the mutex,
+                        // which shows it is running
+                        while (uPortMutexTryLock(pReplay->taskRunningMutex, 0) == 0) {
+                            uPortMutexUnlock(pReplay->taskRunningMutex);
+                            uPortTaskBlock(U_CFG_OS_YIELD_MS);
+                        }
+                    } else {
+                        uPortSemaphoreDelete(pReplay->taskWakeSemaphore);
+                        pReplay->taskWakeSemaphore = NULL;
+                    }
+                }
+                if (errorCode != 0) {
+                    uPortMutexDelete(pReplay->taskRunningMutex);
+                    pReplay->taskRunningMutex = NULL;
+                }
+            }
+            if (errorCode != 0) {
+                pReplay->taskHandle = NULL;
+                pReplay->pEventCallback = NULL;
+                pReplay->pEventCallbackParam = NULL;
+                pReplay->eventFilter = 0;
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK(pReplay->mutex);
+    }
+
+    return errorCode;
+}
+
+// Get the event filter of a replay device.
+static uint32_t replayEventCallbackFilterGet(struct uDeviceSerial_t *pDeviceSerial)
+{
+    uAtClientTranscriptReplay_t *pReplay = (uAtClientTranscriptReplay_t *)
+                                           pUInterfaceContext(pDeviceSerial);
+
+    return pReplay->eventFilter;
+}
+
+// Set the event filter of a replay device.
+static int32_t replayEventCallbackFilterSet(struct uDeviceSerial_t *pDeviceSerial,
+                                            uint32_t filter)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uAtClientTranscriptReplay_t *pReplay = (uAtClientTranscriptReplay_t *)
+                                           pUInterfaceContext(pDeviceSerial);
+
+    if (filter != 0) {
+        U_PORT_MUTEX_LOCK(pReplay->mutex);
+
+        errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+        if (pReplay->taskHandle != NULL) {
+            pReplay->eventFilter = filter;
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        }
+
+        U_PORT_MUTEX_UNLOCK(pReplay->mutex);
+    }
+
+    return errorCode;
+}
+
+// Send an event to the event callback of a replay device; the
+// event is never blocked so this serves for "try send" also.
+static int32_t replayEventTrySend(struct uDeviceSerial_t *pDeviceSerial,
+                                  uint32_t eventBitMap, int32_t delayMs)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uAtClientTranscriptReplay_t *pReplay = (uAtClientTranscriptReplay_t *)
+                                           pUInterfaceContext(pDeviceSerial);
+
+    (void) delayMs;
+
+    U_PORT_MUTEX_LOCK(pReplay->mutex);
+
+    if (pReplay->taskHandle != NULL) {
+        pReplay->eventBitMapPending |= eventBitMap;
+        uPortSemaphoreGive(pReplay->taskWakeSemaphore);
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+    }
+
+    U_PORT_MUTEX_UNLOCK(pReplay->mutex);
+
+    return errorCode;
+}
+
+// Send an event to the event callback of a replay device.
+static int32_t replayEventSend(struct uDeviceSerial_t *pDeviceSerial,
+                               uint32_t eventBitMap)
+{
+    return replayEventTrySend(pDeviceSerial, eventBitMap, 0);
+}
+
+// Determine if we're in the event callback task of a replay device.
+static bool replayEventIsCallback(struct uDeviceSerial_t *pDeviceSerial)
+{
+    uAtClientTranscriptReplay_t *pReplay = (uAtClientTranscriptReplay_t *)
+                                           pUInterfaceContext(pDeviceSerial);
+
+    return (pReplay->taskHandle != NULL) && uPortTaskIsThis(pReplay->taskHandle);
+}
+
+// Get the minimum free stack of the event callback task of a
+// replay device.
+static int32_t replayEventStackMinFree(struct uDeviceSerial_t *pDeviceSerial)
+{
+    int32_t errorCodeOrSize = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uAtClientTranscriptReplay_t *pReplay = (uAtClientTranscriptReplay_t *)
+                                           pUInterfaceContext(pDeviceSerial);
+
+    if (pReplay->taskHandle != NULL) {
+        errorCodeOrSize = uPortTaskStackMinFree(pReplay->taskHandle);
+    }
+
+    return errorCodeOrSize;
+}
+
+// Populate the vector table of a replay device.
+static void replayInit(struct uDeviceSerial_t *pDeviceSerial)
+{
+    pDeviceSerial->open = replayOpen;
+    pDeviceSerial->close = replayClose;
+    pDeviceSerial->getReceiveSize = replayGetReceiveSize;
+    pDeviceSerial->read = replayRead;
+    pDeviceSerial->write = replayWrite;
+    pDeviceSerial->eventCallbackSet = replayEventCallbackSet;
+    pDeviceSerial->eventCallbackRemove = replayEventCallbackRemove;
+    pDeviceSerial->eventCallbackFilterGet = replayEventCallbackFilterGet;
+    pDeviceSerial->eventCallbackFilterSet = replayEventCallbackFilterSet;
+    pDeviceSerial->eventSend = replayEventSend;
+    pDeviceSerial->eventTrySend = replayEventTrySend;
+    pDeviceSerial->eventIsCallback = replayEventIsCallback;
+    pDeviceSerial->eventStackMinFree = replayEventStackMinFree;
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS: RECORD
+ * -------------------------------------------------------------- */
+
+// Start recording.
+int32_t uAtClientTranscriptRecordStart(uAtClientHandle_t atHandle,
+                                       uAtClientTranscriptRecord_t *pRecord,
+                                       char *pBuffer, size_t size)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+
+    if ((atHandle != NULL) && (pRecord != NULL) && (pBuffer != NULL) &&
+        (size >= U_AT_CLIENT_TRANSCRIPT_HEADER_SIZE_BYTES)) {
+        uAtClientLock(atHandle);
+        // Don't displace an intercept that is already installed,
+        // e.g. that of an EDM stream: there can only be one and
+        // there is no way to give it back to its owner afterwards
+        errorCode = (int32_t) U_ERROR_COMMON_BUSY;
+        if (!uAtClientStreamInterceptIsSet(atHandle)) {
+            memset(pRecord, 0, sizeof(*pRecord));
+            pRecord->atHandle = atHandle;
+            pRecord->pBuffer = pBuffer;
+            pRecord->size = size;
+            memcpy(pBuffer, gHeader, sizeof(gHeader));
+            pRecord->length = sizeof(gHeader);
+            pRecord->lastRecordTimeMs = uPortGetTickTimeMs();
+            uAtClientStreamInterceptTx(atHandle, pInterceptTx, (void *) pRecord);
+            uAtClientStreamInterceptRx(atHandle, pInterceptRx, (void *) pRecord);
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        }
+        uAtClientUnlock(atHandle);
+    }
+
+    return errorCode;
+}
+
+// Stop recording.
+int32_t uAtClientTranscriptRecordStop(uAtClientTranscriptRecord_t *pRecord)
+{
+    int32_t errorCodeOrLength = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+
+    if ((pRecord != NULL) && (pRecord->atHandle != NULL)) {
+        uAtClientLock(pRecord->atHandle);
+        uAtClientStreamInterceptTx(pRecord->atHandle, NULL, NULL);
+        uAtClientStreamInterceptRx(pRecord->atHandle, NULL, NULL);
+        uAtClientUnlock(pRecord->atHandle);
+
+        pRecord->atHandle = NULL;
+        errorCodeOrLength = (int32_t) pRecord->length;
+    }
+
+    return errorCodeOrLength;
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS: REPLAY
+ * -------------------------------------------------------------- */
+
+// Create a replay device.
+uDeviceSerial_t *pUAtClientTranscriptReplayCreate(const char *pTranscript,
+                                                  size_t length,
+                                                  int32_t timeScalePercent)
+{
+    uDeviceSerial_t *pDeviceSerial = NULL;
+    uAtClientTranscriptReplay_t *pReplay;
+
+    if ((pTranscript != NULL) && (length >= sizeof(gHeader)) &&
+        (memcmp(pTranscript, gHeader, sizeof(gHeader)) == 0) &&
+        (timeScalePercent >= 0)) {
+        pDeviceSerial = pUDeviceSerialCreate(replayInit, sizeof(uAtClientTranscriptReplay_t));
+        if (pDeviceSerial != NULL) {
+            pReplay = (uAtClientTranscriptReplay_t *) pUInterfaceContext(pDeviceSerial);
+            pReplay->pTranscript = pTranscript;
+            pReplay->length = length;
+            pReplay->offset = sizeof(gHeader);
+            pReplay->timeScalePercent = timeScalePercent;
+            if (uPortMutexCreate(&(pReplay->mutex)) != 0) {
+                uDeviceSerialDelete(pDeviceSerial);
+                pDeviceSerial = NULL;
+            }
+        }
+    }
+
+    return pDeviceSerial;
+}
+
+// Get the statistics of a replay device.
+int32_t uAtClientTranscriptReplayStatsGet(uDeviceSerial_t *pDeviceSerial,
+                                          uAtClientTranscriptReplayStats_t *pStats)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uAtClientTranscriptReplay_t *pReplay;
+
+    if ((pDeviceSerial != NULL) && (pStats != NULL)) {
+        pReplay = (uAtClientTranscriptReplay_t *) pUInterfaceContext(pDeviceSerial);
+
+        U_PORT_MUTEX_LOCK(pReplay->mutex);
+
+        if (pReplay->isOpen) {
+            replayAdvance(pReplay, false);
+        }
+        pReplay->stats.done = (pReplay->recordType == 0) &&
+                              (pReplay->offset >= pReplay->length);
+        *pStats = pReplay->stats;
+
+        U_PORT_MUTEX_UNLOCK(pReplay->mutex);
+
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+    }
+
+    return errorCode;
+}
+
+// Delete a replay device.
+void uAtClientTranscriptReplayDelete(uDeviceSerial_t *pDeviceSerial)
+{
+    uAtClientTranscriptReplay_t *pReplay;
+
+    if (pDeviceSerial != NULL) {
+        pReplay = (uAtClientTranscriptReplay_t *) pUInterfaceContext(pDeviceSerial);
+        replayClose(pDeviceSerial);
+        uPortMutexDelete(pReplay->mutex);
+        uDeviceSerialDelete(pDeviceSerial);
+    }
+}
+
+// End of file
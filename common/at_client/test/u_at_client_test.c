@@ -55,7 +55,10 @@
 #include "u_port_os.h"
 #include "u_port_uart.h"
 
+#include "u_device_serial.h"
+
 #include "u_at_client.h"
+#include "u_at_client_transcript.h"
 #include "u_at_client_test.h"
 #include "u_at_client_test_data.h"
 
@@ -125,6 +128,10 @@
  */
 #define U_AT_CLIENT_TEST_AT_TIMEOUT_TOLERANCE_MS 250
 
+/** The size of buffer to record a transcript into during testing.
+ */
+#define U_AT_CLIENT_TEST_TRANSCRIPT_LENGTH_BYTES 256
+
 /** The AT client buffer length to use during testing:
  * we send non-prefixed response of length 256 bytes plus
  * we need room for initial and trailing line endings. */
@@ -158,6 +165,54 @@ static int32_t gUartAHandle = -1;
  */
 static int32_t gUartBHandle = -1;
 
+/** A transcript of AT+CGMI being sent to a module which responds
+ * 20 ms later; see u_at_client_transcript.h for the format.
+ */
+static const char gAtClientTestTranscript[] = "uAT\x01"
+                                              "T\x00\x08\x00" "AT+CGMI\r"
+                                              "R\x14\x10\x00" "\r\nu-blox\r\n\r\nOK\r\n";
+
+/** A transcript of three socket reads of the same eight bytes, the
+ * first in hex mode, the next two in binary mode where the data
+ * contains what would otherwise look like a stop tag.
+ */
+static const char gAtClientTestTranscriptPayload[] = "uAT\x01"
+                                                     "T\x00\x0d\x00" "AT+USORD=0,8\r"
+                                                     "R\x00\x28\x00" "\r\n+USORD: 0,8,\"0001"
+                                                     "0D0A4F4B0D0A\"\r\n\r\nOK\r\n"
+                                                     "T\x00\x0d\x00" "AT+USORD=0,8\r"
+                                                     "R\x00\x20\x00" "\r\n+USORD: 0,8,\"\x00"
+                                                     "\x01\r\nOK\r\n\"\r\n\r\nOK\r\n"
+                                                     "T\x00\x0d\x00" "AT+USORD=0,8\r"
+                                                     "R\x00\x20\x00" "\r\n+USORD: 0,8,\"\x00"
+                                                     "\x01\r\nOK\r\n\"\r\n\r\nOK\r\n";
+
+/** The payload in gAtClientTestTranscriptPayload.
+ */
+static const char gAtClientTestPayload[] = {0x00, 0x01, '\r', '\n', 'O', 'K', '\r', '\n'};
+
+/** A transcript of the same command sent three times, each time
+ * receiving a set of URCs with colliding prefixes ahead of the
+ * response.
+ */
+static const char gAtClientTestTranscriptUrc[] = "uAT\x01"
+                                                 "T\x00\x05\x00" "AT+X\r"
+                                                 "R\x00\x43\x00" "\r\n+UUSORD: 1\r\n+UUSOR 2\r\n"
+                                                 "+CEREG: 3\r\n+CREG: 4\r\n+CEREGX\r\n"
+                                                 "+X: 5\r\n\r\nOK\r\n"
+                                                 "T\x00\x05\x00" "AT+X\r"
+                                                 "R\x00\x43\x00" "\r\n+UUSORD: 1\r\n+UUSOR 2\r\n"
+                                                 "+CEREG: 3\r\n+CREG: 4\r\n+CEREGX\r\n"
+                                                 "+X: 5\r\n\r\nOK\r\n"
+                                                 "T\x00\x05\x00" "AT+X\r"
+                                                 "R\x00\x43\x00" "\r\n+UUSORD: 1\r\n+UUSOR 2\r\n"
+                                                 "+CEREG: 3\r\n+CREG: 4\r\n+CEREGX\r\n"
+                                                 "+X: 5\r\n\r\nOK\r\n";
+
+/** The URC prefixes used with gAtClientTestTranscriptUrc.
+ */
+static const char *const gpAtClientTestUrcPrefix[] = {"+UUSOR", "+UUSORD:", "+CREG:", "+CEREG:"};
+
 #if (U_CFG_TEST_UART_A >= 0)
 
 /** Store the last consecutive AT time-out call-back here.
@@ -185,6 +240,68 @@ static const char *gpInterceptTxDataLast = NULL;
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
 
+// Callback for uAtClientReadBytesSpan(), appends the span to
+// the buffer pointed to by pParam, which must be big enough.
+static void spanCallback(const char *pSpan, size_t length, void *pParam)
+{
+    char **ppBuffer = (char **) pParam;
+
+    memcpy(*ppBuffer, pSpan, length);
+    *ppBuffer += length;
+}
+
+// A transmit intercept that passes everything on unchanged, used
+// by the atClientTranscript test to stand in for that of, e.g.,
+// an EDM stream.
+static const char *pInterceptTxPassThrough(uAtClientHandle_t atHandle,
+                                           const char **ppData,
+                                           size_t *pLength,
+                                           void *pContext)
+{
+    const char *pData = NULL;
+
+    (void) atHandle;
+    (void) pContext;
+
+    if (ppData != NULL) {
+        pData = *ppData;
+        *ppData += *pLength;
+    }
+
+    return pData;
+}
+
+// URC handler for the atClientUrcTrie test, increments the
+// counter pointed to by pParam.
+static void urcCountHandler(uAtClientHandle_t atHandle, void *pParam)
+{
+    (void) atHandle;
+
+    (*((int32_t *) pParam))++;
+}
+
+// Send the command in gAtClientTestTranscriptUrc and check that
+// each of the URCs of gpAtClientTestUrcPrefix has been called
+// the number of times given in pExpected.
+static void urcCommandCheck(uAtClientHandle_t atClientHandle,
+                            int32_t *pCount, const int32_t *pExpected)
+{
+    size_t numUrcs = sizeof(gpAtClientTestUrcPrefix) / sizeof(gpAtClientTestUrcPrefix[0]);
+
+    memset(pCount, 0, sizeof(int32_t) * numUrcs);
+    uAtClientLock(atClientHandle);
+    uAtClientCommandStart(atClientHandle, "AT+X");
+    uAtClientCommandStop(atClientHandle);
+    uAtClientResponseStart(atClientHandle, "+X:");
+    U_PORT_TEST_ASSERT(uAtClientReadInt(atClientHandle) == 5);
+    uAtClientResponseStop(atClientHandle);
+    U_PORT_TEST_ASSERT(uAtClientUnlock(atClientHandle) == 0);
+    for (size_t x = 0; x < numUrcs; x++) {
+        U_TEST_PRINT_LINE("\"%s\" called %d time(s).", gpAtClientTestUrcPrefix[x], *(pCount + x));
+        U_PORT_TEST_ASSERT(*(pCount + x) == *(pExpected + x));
+    }
+}
+
 #if (U_CFG_TEST_UART_A >= 0)
 
 // AT consecutive timeout callback, used by some of the tests below
@@ -1047,6 +1164,290 @@ U_PORT_TEST_FUNCTION("[atClient]", "atClientInitialisation")
     uPortDeinit();
 }
 
+/** Replay a transcript to an AT client, recording the AT client
+ * while doing so, then replay that recording; no UART is
+ * required.
+ */
+U_PORT_TEST_FUNCTION("[atClient]", "atClientTranscript")
+{
+    uDeviceSerial_t *pDeviceSerial;
+    uAtClientHandle_t atClientHandle;
+    uAtClientTranscriptRecord_t *pRecord;
+    uAtClientTranscriptReplayStats_t stats;
+    char *pTranscript;
+    int32_t length = 0;
+    char buffer[16];
+    int32_t heapUsed;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    heapUsed = uPortGetHeapFree();
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+    U_PORT_TEST_ASSERT(uAtClientInit() == 0);
+
+    pRecord = (uAtClientTranscriptRecord_t *) pUPortMalloc(sizeof(*pRecord));
+    U_PORT_TEST_ASSERT(pRecord != NULL);
+    pTranscript = (char *) pUPortMalloc(U_AT_CLIENT_TEST_TRANSCRIPT_LENGTH_BYTES);
+    U_PORT_TEST_ASSERT(pTranscript != NULL);
+
+    for (size_t x = 0; x < 2; x++) {
+        if (x == 0) {
+            U_TEST_PRINT_LINE("replaying canned transcript...");
+            pDeviceSerial = pUAtClientTranscriptReplayCreate(gAtClientTestTranscript,
+                                                             sizeof(gAtClientTestTranscript) - 1,
+                                                             100);
+        } else {
+            U_TEST_PRINT_LINE("replaying recorded transcript, %d byte(s)...",
+                              length);
+            pDeviceSerial = pUAtClientTranscriptReplayCreate(pTranscript, length, 100);
+        }
+        U_PORT_TEST_ASSERT(pDeviceSerial != NULL);
+        U_PORT_TEST_ASSERT(pDeviceSerial->open(pDeviceSerial, NULL,
+                                               U_AT_CLIENT_TEST_AT_BUFFER_LENGTH_BYTES) == 0);
+        atClientHandle = uAtClientAdd((int32_t) pDeviceSerial,
+                                      U_AT_CLIENT_STREAM_TYPE_VIRTUAL_SERIAL,
+                                      NULL, U_AT_CLIENT_TEST_AT_BUFFER_LENGTH_BYTES);
+        U_PORT_TEST_ASSERT(atClientHandle != NULL);
+        if (x == 0) {
+            // Recording must not displace an intercept that is
+            // already installed (e.g. that of an EDM stream)
+            uAtClientLock(atClientHandle);
+            uAtClientStreamInterceptTx(atClientHandle, pInterceptTxPassThrough, NULL);
+            uAtClientUnlock(atClientHandle);
+            U_PORT_TEST_ASSERT(uAtClientTranscriptRecordStart(atClientHandle, pRecord, pTranscript,
+                                                              U_AT_CLIENT_TEST_TRANSCRIPT_LENGTH_BYTES) ==
+                               (int32_t) U_ERROR_COMMON_BUSY);
+            uAtClientLock(atClientHandle);
+            U_PORT_TEST_ASSERT(uAtClientStreamInterceptIsSet(atClientHandle));
+            uAtClientStreamInterceptTx(atClientHandle, NULL, NULL);
+            U_PORT_TEST_ASSERT(!uAtClientStreamInterceptIsSet(atClientHandle));
+            uAtClientUnlock(atClientHandle);
+            U_PORT_TEST_ASSERT(uAtClientTranscriptRecordStart(atClientHandle, pRecord, pTranscript,
+                                                              U_AT_CLIENT_TEST_TRANSCRIPT_LENGTH_BYTES) == 0);
+        }
+
+        memset(buffer, 0, sizeof(buffer));
+        uAtClientLock(atClientHandle);
+        uAtClientCommandStart(atClientHandle, "AT+CGMI");
+        uAtClientCommandStop(atClientHandle);
+        uAtClientResponseStart(atClientHandle, NULL);
+        uAtClientReadString(atClientHandle, buffer, sizeof(buffer), false);
+        uAtClientResponseStop(atClientHandle);
+        U_PORT_TEST_ASSERT(uAtClientUnlock(atClientHandle) == 0);
+        U_TEST_PRINT_LINE("response was \"%s\".", buffer);
+        U_PORT_TEST_ASSERT(strcmp(buffer, "u-blox") == 0);
+
+        if (x == 0) {
+            length = uAtClientTranscriptRecordStop(pRecord);
+            U_PORT_TEST_ASSERT(length > U_AT_CLIENT_TRANSCRIPT_HEADER_SIZE_BYTES);
+            U_PORT_TEST_ASSERT(pRecord->bytesLost == 0);
+            U_PORT_TEST_ASSERT(!uAtClientStreamInterceptIsSet(atClientHandle));
+        }
+
+        U_PORT_TEST_ASSERT(uAtClientTranscriptReplayStatsGet(pDeviceSerial, &stats) == 0);
+        U_TEST_PRINT_LINE("%d record(s) replayed, %d mismatch(es).",
+                          stats.recordsReplayed, stats.mismatchCount);
+        U_PORT_TEST_ASSERT(stats.done);
+        U_PORT_TEST_ASSERT(stats.mismatchCount == 0);
+        U_PORT_TEST_ASSERT(stats.bytesUnexpected == 0);
+        U_PORT_TEST_ASSERT(stats.bytesOverflow == 0);
+
+        uAtClientRemove(atClientHandle);
+        uAtClientTranscriptReplayDelete(pDeviceSerial);
+    }
+
+    uPortFree(pTranscript);
+    uPortFree(pRecord);
+
+    uAtClientDeinit();
+    uPortDeinit();
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("we have leaked %d byte(s).", heapUsed);
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT(heapUsed <= 0);
+}
+
+/** Read a payload from a replayed transcript in all of the ways
+ * that the AT client provides: as hex decoded in place, as spans of
+ * the receive buffer and as copied bytes; no UART is required.
+ */
+U_PORT_TEST_FUNCTION("[atClient]", "atClientReadPayload")
+{
+    uDeviceSerial_t *pDeviceSerial;
+    uAtClientHandle_t atClientHandle;
+    uAtClientTranscriptReplayStats_t stats;
+    char buffer[16];
+    char *pBuffer;
+    int32_t x;
+    int32_t y;
+    int32_t heapUsed;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    heapUsed = uPortGetHeapFree();
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+    U_PORT_TEST_ASSERT(uAtClientInit() == 0);
+
+    pDeviceSerial = pUAtClientTranscriptReplayCreate(gAtClientTestTranscriptPayload,
+                                                     sizeof(gAtClientTestTranscriptPayload) - 1,
+                                                     0);
+    U_PORT_TEST_ASSERT(pDeviceSerial != NULL);
+    U_PORT_TEST_ASSERT(pDeviceSerial->open(pDeviceSerial, NULL,
+                                           U_AT_CLIENT_TEST_AT_BUFFER_LENGTH_BYTES) == 0);
+    atClientHandle = uAtClientAdd((int32_t) pDeviceSerial,
+                                  U_AT_CLIENT_STREAM_TYPE_VIRTUAL_SERIAL,
+                                  NULL, U_AT_CLIENT_TEST_AT_BUFFER_LENGTH_BYTES);
+    U_PORT_TEST_ASSERT(atClientHandle != NULL);
+
+    for (size_t z = 0; z < 3; z++) {
+        memset(buffer, 0xFF, sizeof(buffer));
+        uAtClientLock(atClientHandle);
+        uAtClientCommandStart(atClientHandle, "AT+USORD=");
+        uAtClientWriteInt(atClientHandle, 0);
+        uAtClientWriteInt(atClientHandle, sizeof(gAtClientTestPayload));
+        uAtClientCommandStop(atClientHandle);
+        uAtClientResponseStart(atClientHandle, "+USORD:");
+        uAtClientSkipParameters(atClientHandle, 1);
+        x = uAtClientReadInt(atClientHandle);
+        U_PORT_TEST_ASSERT(x == sizeof(gAtClientTestPayload));
+        switch (z) {
+            case 0:
+                U_TEST_PRINT_LINE("reading payload as hex...");
+                // Ask for less than there is to check that
+                // the remainder is thrown away
+                y = uAtClientReadHexData(atClientHandle, buffer, x - 1);
+                U_PORT_TEST_ASSERT(y == x - 1);
+                break;
+            case 1:
+                U_TEST_PRINT_LINE("reading payload as spans...");
+                uAtClientIgnoreStopTag(atClientHandle);
+                uAtClientReadBytes(atClientHandle, NULL, 1, true);
+                pBuffer = buffer;
+                y = uAtClientReadBytesSpan(atClientHandle, x, spanCallback, &pBuffer);
+                U_PORT_TEST_ASSERT(y == x);
+                U_PORT_TEST_ASSERT(pBuffer == buffer + x);
+                uAtClientRestoreStopTag(atClientHandle);
+                break;
+            default:
+                U_TEST_PRINT_LINE("reading payload as bytes...");
+                uAtClientIgnoreStopTag(atClientHandle);
+                uAtClientReadBytes(atClientHandle, NULL, 1, true);
+                y = uAtClientReadBytes(atClientHandle, buffer, x, true);
+                U_PORT_TEST_ASSERT(y == x);
+                uAtClientRestoreStopTag(atClientHandle);
+                break;
+        }
+        uAtClientResponseStop(atClientHandle);
+        U_PORT_TEST_ASSERT(uAtClientUnlock(atClientHandle) == 0);
+        U_PORT_TEST_ASSERT(memcmp(buffer, gAtClientTestPayload, y) == 0);
+        U_PORT_TEST_ASSERT(buffer[y] == (char) 0xFF);
+    }
+
+    U_PORT_TEST_ASSERT(uAtClientTranscriptReplayStatsGet(pDeviceSerial, &stats) == 0);
+    U_PORT_TEST_ASSERT(stats.done);
+    U_PORT_TEST_ASSERT(stats.mismatchCount == 0);
+
+    uAtClientRemove(atClientHandle);
+    uAtClientTranscriptReplayDelete(pDeviceSerial);
+
+    uAtClientDeinit();
+    uPortDeinit();
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("we have leaked %d byte(s).", heapUsed);
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT(heapUsed <= 0);
+}
+
+/** Check that URCs are matched by the longest prefix, both when
+ * one prefix is the start of another and when prefixes share a
+ * start, and that matching follows handlers being added and
+ * removed.  Uses a canned transcript so needs no UART.
+ */
+U_PORT_TEST_FUNCTION("[atClient]", "atClientUrcTrie")
+{
+    uDeviceSerial_t *pDeviceSerial;
+    uAtClientHandle_t atClientHandle;
+    uAtClientTranscriptReplayStats_t stats;
+    int32_t count[sizeof(gpAtClientTestUrcPrefix) / sizeof(gpAtClientTestUrcPrefix[0])];
+    // All handlers present: each URC goes to its own handler
+    const int32_t expectedAll[] = {1, 1, 1, 1};
+    // "+UUSORD:" removed: both "+UUSOR" URCs go to "+UUSOR"
+    const int32_t expectedRemoved[] = {2, 0, 1, 1};
+    // "+UUSOR" and "+CREG:" removed, "+UUSORD:" added back
+    const int32_t expectedAdded[] = {0, 1, 0, 1};
+    int32_t heapUsed;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    heapUsed = uPortGetHeapFree();
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+    U_PORT_TEST_ASSERT(uAtClientInit() == 0);
+
+    pDeviceSerial = pUAtClientTranscriptReplayCreate(gAtClientTestTranscriptUrc,
+                                                     sizeof(gAtClientTestTranscriptUrc) - 1,
+                                                     0);
+    U_PORT_TEST_ASSERT(pDeviceSerial != NULL);
+    U_PORT_TEST_ASSERT(pDeviceSerial->open(pDeviceSerial, NULL,
+                                           U_AT_CLIENT_TEST_AT_BUFFER_LENGTH_BYTES) == 0);
+    atClientHandle = uAtClientAdd((int32_t) pDeviceSerial,
+                                  U_AT_CLIENT_STREAM_TYPE_VIRTUAL_SERIAL,
+                                  NULL, U_AT_CLIENT_TEST_AT_BUFFER_LENGTH_BYTES);
+    U_PORT_TEST_ASSERT(atClientHandle != NULL);
+
+    for (size_t x = 0; x < sizeof(count) / sizeof(count[0]); x++) {
+        U_PORT_TEST_ASSERT(uAtClientSetUrcHandler(atClientHandle, gpAtClientTestUrcPrefix[x],
+                                                  urcCountHandler, &(count[x])) == 0);
+    }
+    // Setting the same prefix again should do nothing
+    U_PORT_TEST_ASSERT(uAtClientSetUrcHandler(atClientHandle, gpAtClientTestUrcPrefix[0],
+                                              urcCountHandler, &(count[0])) == 0);
+
+    U_TEST_PRINT_LINE("all URC handlers present...");
+    urcCommandCheck(atClientHandle, count, expectedAll);
+
+    U_TEST_PRINT_LINE("\"%s\" removed...", gpAtClientTestUrcPrefix[1]);
+    uAtClientRemoveUrcHandler(atClientHandle, gpAtClientTestUrcPrefix[1]);
+    urcCommandCheck(atClientHandle, count, expectedRemoved);
+
+    U_TEST_PRINT_LINE("\"%s\" and \"%s\" removed, \"%s\" added back...",
+                      gpAtClientTestUrcPrefix[0], gpAtClientTestUrcPrefix[2],
+                      gpAtClientTestUrcPrefix[1]);
+    uAtClientRemoveUrcHandler(atClientHandle, gpAtClientTestUrcPrefix[0]);
+    uAtClientRemoveUrcHandler(atClientHandle, gpAtClientTestUrcPrefix[2]);
+    U_PORT_TEST_ASSERT(uAtClientSetUrcHandler(atClientHandle, gpAtClientTestUrcPrefix[1],
+                                              urcCountHandler, &(count[1])) == 0);
+    urcCommandCheck(atClientHandle, count, expectedAdded);
+
+    U_PORT_TEST_ASSERT(uAtClientTranscriptReplayStatsGet(pDeviceSerial, &stats) == 0);
+    U_PORT_TEST_ASSERT(stats.done);
+    U_PORT_TEST_ASSERT(stats.mismatchCount == 0);
+
+    uAtClientRemove(atClientHandle);
+    uAtClientTranscriptReplayDelete(pDeviceSerial);
+
+    uAtClientDeinit();
+    uPortDeinit();
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("we have leaked %d byte(s).", heapUsed);
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT(heapUsed <= 0);
+}
+
 #if (U_CFG_TEST_UART_A >= 0)
 /** Add an AT client then try getting and setting all of the
  * configuration items.  Requires one UART with no
@@ -1057,6 +1458,8 @@ U_PORT_TEST_FUNCTION("[atClient]", "atClientConfiguration")
     uAtClientHandle_t atClientHandle;
     bool thingIsOn;
     int32_t x;
+    int32_t y;
+    uAtClientMetrics_t *pMetrics;
     char c;
     int32_t heapUsed;
     int32_t heapClibLossOffset = (int32_t) gSystemHeapLost;
@@ -1134,6 +1537,48 @@ U_PORT_TEST_FUNCTION("[atClient]", "atClientConfiguration")
     U_TEST_PRINT_LINE("delay is now %d ms.", x);
     U_PORT_TEST_ASSERT(x == U_AT_CLIENT_DEFAULT_DELAY_MS + 1);
 
+    // The adaptive delay starts at the maximum and
+    // is off unless the minimum is less than that
+    U_PORT_TEST_ASSERT(uAtClientDelayAdaptiveGet(atClientHandle) == x);
+    uAtClientDelayAdaptiveSet(atClientHandle, x);
+    U_PORT_TEST_ASSERT(uAtClientDelayAdaptiveGet(atClientHandle) == x);
+    uAtClientDelayAdaptiveSet(atClientHandle, 1);
+    U_TEST_PRINT_LINE("adaptive delay is %d ms.",
+                      uAtClientDelayAdaptiveGet(atClientHandle));
+    U_PORT_TEST_ASSERT(uAtClientDelayAdaptiveGet(atClientHandle) == x);
+    uAtClientDelayAdaptiveSet(atClientHandle, -1);
+    U_PORT_TEST_ASSERT(uAtClientDelayAdaptiveGet(atClientHandle) == x);
+
+    // Metrics may not be compiled in, in which case
+    // they should say so
+    pMetrics = (uAtClientMetrics_t *) pUPortMalloc(sizeof(*pMetrics));
+    U_PORT_TEST_ASSERT(pMetrics != NULL);
+    y = uAtClientMetricsGet(atClientHandle, pMetrics);
+    if (uAtClientMetricsOn(atClientHandle) == 0) {
+        U_TEST_PRINT_LINE("metrics are on.");
+        U_PORT_TEST_ASSERT(y == (int32_t) U_ERROR_COMMON_NOT_INITIALISED);
+        U_PORT_TEST_ASSERT(uAtClientMetricsGet(atClientHandle, pMetrics) == 0);
+        U_PORT_TEST_ASSERT(pMetrics->numCommands == 0);
+        U_PORT_TEST_ASSERT(pMetrics->numUrcs == 0);
+        uAtClientMetricsPrint(atClientHandle);
+        uAtClientMetricsOff(atClientHandle);
+        U_PORT_TEST_ASSERT(uAtClientMetricsGet(atClientHandle,
+                                               pMetrics) == (int32_t) U_ERROR_COMMON_NOT_INITIALISED);
+    } else {
+        U_TEST_PRINT_LINE("metrics are not compiled in.");
+        U_PORT_TEST_ASSERT(y == (int32_t) U_ERROR_COMMON_NOT_SUPPORTED);
+    }
+    // The percentile calculation is always available
+    memset(pMetrics, 0, sizeof(*pMetrics));
+    pMetrics->command[0].count = 4;
+    pMetrics->command[0].latencyMaxMs = 100;
+    pMetrics->command[0].latencyBucket[3] = 3; // 4 to 7 ms
+    pMetrics->command[0].latencyBucket[7] = 1; // 64 to 127 ms
+    U_PORT_TEST_ASSERT(uAtClientMetricsLatencyPercentileMs(&(pMetrics->command[0]), 50) == 7);
+    U_PORT_TEST_ASSERT(uAtClientMetricsLatencyPercentileMs(&(pMetrics->command[0]), 99) == 100);
+    U_PORT_TEST_ASSERT(uAtClientMetricsLatencyPercentileMs(&(pMetrics->command[0]), 0) < 0);
+    uPortFree(pMetrics);
+
     // Can't do much with this other than set it
     U_TEST_PRINT_LINE("setting consecutive AT timeout callback...");
     uAtClientTimeoutCallbackSet(atClientHandle,
@@ -46,6 +46,15 @@ extern "C" {
 #define U_EDM_STREAM_EVENT_QUEUE_SIZE 3
 #endif
 
+#ifndef U_SHORT_RANGE_EDM_STREAM_MAX_NUM
+/** The maximum number of EDM streams, i.e. short-range modules
+ * on separate UARTs, that may be open at any one time.  Each
+ * open stream has its own event queue (and hence task) and, up
+ * to #U_SHORT_RANGE_PBUF_POOL_COUNT, its own pbuf pools.
+ */
+# define U_SHORT_RANGE_EDM_STREAM_MAX_NUM 2
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -75,18 +84,21 @@ typedef void (*uEdmDataEventCallback_t)(int32_t edmStreamHandle,
  * FUNCTIONS
  * -------------------------------------------------------------- */
 
-/** Initialise stream handling.
+/** Initialise stream handling; may be called more than once.
  *
  * @return  zero on success else negative error code.
  */
 int32_t uShortRangeEdmStreamInit();
 
-/** Shutdown stream handling.
+/** Shutdown stream handling.  This does nothing while any
+ * stream is still open, since the streams may belong to
+ * different short-range modules.
  */
 void uShortRangeEdmStreamDeinit();
 
 /** Open an instance. Needs an open UART instance that is not accessed
- * by any other module.
+ * by any other module.  Up to #U_SHORT_RANGE_EDM_STREAM_MAX_NUM
+ * instances may be open at once, each on a different UART.
  *
  * @param uartHandle       the UART HW block to use.
  * @return                 a stream handle else negative
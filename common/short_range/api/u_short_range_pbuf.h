@@ -41,6 +41,16 @@ extern "C" {
  * COMPILE-TIME MACROS
  * -------------------------------------------------------------- */
 
+#ifndef U_SHORT_RANGE_PBUF_POOL_COUNT
+/** The number of independent sets of pbuf/pbuf list pools; each
+ * EDM stream allocates from the set given by its handle modulo
+ * this number, so that one busy stream can't starve another of
+ * pbufs.  The memory of a set is only allocated when it is first
+ * used.
+ */
+# define U_SHORT_RANGE_PBUF_POOL_COUNT 2
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -56,6 +66,7 @@ extern "C" {
 typedef U_PACKED_STRUCT(uShortRangePbuf_t) {
     struct uShortRangePbuf_t *pNext; /**< Used for linked list of pBuf */
     uint16_t length; /**< Number of used bytes in the data buffer */
+    uint8_t refCount; /**< Number of pbuf lists referring to this pbuf */
     char data[];  /**< Data buffer */
 } uShortRangePbuf_t;
 #ifdef _MSC_VER
@@ -75,6 +86,10 @@ typedef U_PACKED_STRUCT(uShortRangePbufList_t) {
     uint16_t totalLen;
     // edm channel of this payload
     int8_t edmChannel;
+    // offset of the unread data in the head pbuf; pbufs may
+    // be shared between lists and so are never modified once
+    // they have been added to a list
+    uint16_t headOffset;
 } uShortRangePbufList_t;
 // *INDENT-ON*
 
@@ -91,7 +106,8 @@ typedef struct uShortRangePktList_t {
 /* ----------------------------------------------------------------
  * FUNCTIONS
  * -------------------------------------------------------------- */
-/** Initialize the memory pool for shortrange.
+/** Initialize the memory pools for shortrange, all
+ * #U_SHORT_RANGE_PBUF_POOL_COUNT sets of them.
  *
  * @return zero on success else negative error code.
  */
@@ -102,8 +118,8 @@ int32_t uShortRangeMemPoolInit(void);
  */
 void uShortRangeMemPoolDeInit(void);
 
-/** Allocate fixed size memory from gEdmPayLoadPool memory pool.
- * Refer to gEdmPayLoadPool in u_short_range_pbuf.c
+/** Allocate fixed size memory from the first pbuf pool, same as
+ * uShortRangePbufAllocFromPool() with a pool index of zero.
  * Memory pool should have been initialized before using this
  * API. Refer to uShortRangeMemPoolInit()
  *
@@ -113,8 +129,20 @@ void uShortRangeMemPoolDeInit(void);
  */
 int32_t uShortRangePbufAlloc(uShortRangePbuf_t **ppBuf);
 
-/** Allocate memory for pbuf list from the pbuf list
- * memory pool. Refer to gPBufListPool in u_short_range_pbuf.c
+/** Allocate fixed size memory from the given pbuf pool.
+ * Memory pool should have been initialized before using this
+ * API. Refer to uShortRangeMemPoolInit()
+ *
+ * @param poolIndex  the pool set to allocate from, 0 to
+ *                   #U_SHORT_RANGE_PBUF_POOL_COUNT - 1.
+ * @param[out] ppBuf a double pointer to destination pbuf.
+ * @return  data size of the returned pbuf, on failure negative error code.
+ */
+int32_t uShortRangePbufAllocFromPool(int32_t poolIndex, uShortRangePbuf_t **ppBuf);
+
+/** Allocate memory for pbuf list from the first pbuf list
+ * memory pool, same as pUShortRangePbufListAllocFromPool()
+ * with a pool index of zero.
  * Memory pool should have been initialized before using this
  * API. Refer to uShortRangeMemPoolInit()
  *
@@ -123,8 +151,22 @@ int32_t uShortRangePbufAlloc(uShortRangePbuf_t **ppBuf);
  */
 uShortRangePbufList_t *pUShortRangePbufListAlloc(void);
 
+/** Allocate memory for pbuf list from the given pbuf list
+ * memory pool.
+ * Memory pool should have been initialized before using this
+ * API. Refer to uShortRangeMemPoolInit()
+ *
+ * @param poolIndex  the pool set to allocate from, 0 to
+ *                   #U_SHORT_RANGE_PBUF_POOL_COUNT - 1.
+ * @return           pointer to uShortRangePbufList_t or NULL.
+ */
+uShortRangePbufList_t *pUShortRangePbufListAllocFromPool(int32_t poolIndex);
+
 /** Put the allocated memory for pbufs and packet in to their
- * free list of respective pool.
+ * free list of respective pool; the pool each was allocated
+ * from is found from its address.  A pbuf that is shared with
+ * another pbuf list (see pUShortRangePbufListShare()) is only
+ * put back when the last list referring to it is freed.
  *
  * @param[in] pBufList Pointer to the packet.
  */
@@ -150,13 +192,47 @@ size_t uShortRangePbufListConsumeData(uShortRangePbufList_t *pBufList, char *pDa
 
 /** Link a new pbuf list to the existing pbuf list.
  *  The pointer allocated for the new pbuf list from the pbuf list pool
- *  will be added to its free list.
+ *  will be added to its free list.  Neither list may have been
+ *  shared with pUShortRangePbufListShare() and nothing may have
+ *  been read from the new list.
  *
  * @param[in] pOldList  pointer to the existing pbuf list.
  * @param[out] pNewList pointer to the new pbuf list.
  */
 void uShortRangePbufListMerge(uShortRangePbufList_t *pOldList, uShortRangePbufList_t *pNewList);
 
+/** Get a span of the unread data in a pbuf list without copying
+ * it, for a consumer that can take data in pieces (e.g. to pass
+ * on to a callback).  Set *ppBuf to NULL to get the first span,
+ * then call again with the same ppBuf to get the next.  The data
+ * remains valid until the pbuf list is freed; it is not consumed.
+ *
+ * @param[in] pBufList     pointer to the pbuf list.
+ * @param[in,out] ppBuf    the pbuf of the previous span, NULL to
+ *                         start at the beginning.
+ * @param[out] pLength     a place to put the length of the span.
+ * @return                 a pointer to the span, NULL if there are
+ *                         no more.
+ */
+const char *pUShortRangePbufListSpan(const uShortRangePbufList_t *pBufList,
+                                     const uShortRangePbuf_t **ppBuf,
+                                     size_t *pLength);
+
+/** Share the unread data of a pbuf list with a new pbuf list,
+ * without copying it: both lists refer to the same pbufs, which
+ * are only freed when both lists have been freed.  This allows
+ * one packet to be delivered to more than one consumer.  The data
+ * of shared pbufs is never modified, hence each list may be read
+ * independently, but a shared list may not be used with
+ * uShortRangePbufListMerge().
+ *
+ * @param[in] pBufList pointer to the pbuf list to share.
+ * @return             the new pbuf list, allocated from the same
+ *                     pool as pBufList, or NULL if there is no
+ *                     memory; free it with uShortRangePbufListFree().
+ */
+uShortRangePbufList_t *pUShortRangePbufListShare(uShortRangePbufList_t *pBufList);
+
 /** Insert a pbuf list to the packet list.
  *
  * @param[in,out] pPktList pointer to the packet list.
@@ -166,6 +242,17 @@ void uShortRangePbufListMerge(uShortRangePbufList_t *pOldList, uShortRangePbufLi
 int32_t uShortRangePktListAppend(uShortRangePktList_t *pPktList,
                                  uShortRangePbufList_t *pBufList);
 
+/** Take the first packet from a packet list: the caller becomes
+ * the owner of the pbuf list, may read it without copying with
+ * pUShortRangePbufListSpan() and must free it with
+ * uShortRangePbufListFree() when done.
+ *
+ * @param[in,out] pPktList pointer to the packet list.
+ * @return                 the pbuf list of the packet, NULL if
+ *                         there are no packets.
+ */
+uShortRangePbufList_t *pUShortRangePktListTake(uShortRangePktList_t *pPktList);
+
 /** Read and consume a packet in a packet list.
  * If the given buffer size cannot accommodate the size of a complete packet, partial
  * data will be copied.
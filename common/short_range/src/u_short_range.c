@@ -764,11 +764,6 @@ int32_t uShortRangeOpenUart(uShortRangeModuleType_t moduleType,
         return (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
     }
 
-    // TODO: once we allow multiple edm streams this should be removed
-    if (gpUShortRangePrivateInstanceList != NULL) {
-        return (int32_t) U_SHORT_RANGE_ERROR_INIT_INTERNAL;
-    }
-
     if ((moduleType <= U_SHORT_RANGE_MODULE_TYPE_INTERNAL) ||
         (pUartConfig == NULL)) {
         return handleOrErrorCode;
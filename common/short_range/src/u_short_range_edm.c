@@ -54,41 +54,39 @@
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
-typedef enum {
-    EDM_PARSER_STATE_PARSE_START_BYTE,
-    EDM_PARSER_STATE_PARSE_PAYLOAD_LENGTH,
-    EDM_PARSER_STATE_PARSE_HEADER_LENGTH,
-    EDM_PARSER_STATE_ALLOCATE_PBUFLIST,
-    EDM_PARSER_STATE_ALLOCATE_PAYLOAD,
-    EDM_PARSER_STATE_ACCUMULATE_PAYLOAD,
-    EDM_PARSER_STATE_PARSE_TAIL_BYTE,
-    EDM_PARSER_STATE_WAIT_FOR_EVENT_PROCESSING
-} edmParserState_t;
 
 /* ----------------------------------------------------------------
  * STATIC PROTOTYPES
  * -------------------------------------------------------------- */
 static int32_t getBtProfile(char value, uShortRangeBtProfile_t *profile);
 static int32_t getIpProtocol(char value, uShortRangeIpProtocol_t *protocol);
-static uShortRangeEdmEvent_t *allocateEdmEvent(void);
-static uShortRangeEdmEvent_t *parseConnectBtEvent(uint8_t channel, char *buffer,
+static uShortRangeEdmEvent_t *allocateEdmEvent(uShortRangeEdmParser_t *pParser);
+static uShortRangeEdmEvent_t *parseConnectBtEvent(uShortRangeEdmParser_t *pParser,
+                                                  uint8_t channel, char *buffer,
                                                   uint16_t payloadLength);
-static uShortRangeEdmEvent_t *parseConnectIpv4Event(uint8_t channel, char *buffer,
+static uShortRangeEdmEvent_t *parseConnectIpv4Event(uShortRangeEdmParser_t *pParser,
+                                                    uint8_t channel, char *buffer,
                                                     uint16_t payloadLength);
-static uShortRangeEdmEvent_t *parseConnectIpv6Event(uint8_t channel, char *buffer,
+static uShortRangeEdmEvent_t *parseConnectIpv6Event(uShortRangeEdmParser_t *pParser,
+                                                    uint8_t channel, char *buffer,
                                                     uint16_t payloadLength);
-static uShortRangeEdmEvent_t *parseConnectEvent(uint8_t channel, uShortRangePbufList_t *pBufList);
-static uShortRangeEdmEvent_t *parseDisconnectEvent(uint8_t channel);
-static uShortRangeEdmEvent_t *parseDataEvent(uint8_t channel, uShortRangePbufList_t *pBufList);
-static uShortRangeEdmEvent_t *parseAtResponseOrEvent(uShortRangePbufList_t *pBufList);
-static uShortRangeEdmEvent_t *parseEdmPayload(uint16_t idAndType, uint8_t channel,
+static uShortRangeEdmEvent_t *parseConnectEvent(uShortRangeEdmParser_t *pParser,
+                                                uint8_t channel, uShortRangePbufList_t *pBufList);
+static uShortRangeEdmEvent_t *parseDisconnectEvent(uShortRangeEdmParser_t *pParser,
+                                                   uint8_t channel);
+static uShortRangeEdmEvent_t *parseDataEvent(uShortRangeEdmParser_t *pParser,
+                                             uint8_t channel, uShortRangePbufList_t *pBufList);
+static uShortRangeEdmEvent_t *parseAtResponseOrEvent(uShortRangeEdmParser_t *pParser,
+                                                     uShortRangePbufList_t *pBufList);
+static uShortRangeEdmEvent_t *parseEdmPayload(uShortRangeEdmParser_t *pParser,
+                                              uint16_t idAndType, uint8_t channel,
                                               uShortRangePbufList_t *pBufList);
+static void parseByte(uShortRangeEdmParser_t *pParser, char c,
+                      uShortRangeEdmEvent_t **ppResultEvent);
 
 /* ----------------------------------------------------------------
  * STATIC VARIABLES
  * -------------------------------------------------------------- */
-static edmParserState_t gEdmParserState = EDM_PARSER_STATE_PARSE_START_BYTE;
-static uShortRangePbufList_t *gCurPBufList = NULL;
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -130,14 +128,13 @@ static int32_t getIpProtocol(char value, uShortRangeIpProtocol_t *pProtocol)
     return U_SHORT_RANGE_EDM_OK;
 }
 
-static uShortRangeEdmEvent_t *allocateEdmEvent(void)
+static uShortRangeEdmEvent_t *allocateEdmEvent(uShortRangeEdmParser_t *pParser)
 {
-    static uShortRangeEdmEvent_t gEdmEvent;
-
-    return &gEdmEvent;
+    return &pParser->event;
 }
 
-static uShortRangeEdmEvent_t *parseConnectBtEvent(uint8_t channel, char *pBuffer,
+static uShortRangeEdmEvent_t *parseConnectBtEvent(uShortRangeEdmParser_t *pParser,
+                                                  uint8_t channel, char *pBuffer,
                                                   uint16_t payloadLength)
 {
     uShortRangeEdmEvent_t *pEvent = NULL;
@@ -146,7 +143,7 @@ static uShortRangeEdmEvent_t *parseConnectBtEvent(uint8_t channel, char *pBuffer
 
     if ((payloadLength == 10) && (result == U_SHORT_RANGE_EDM_OK)) {
         uShortRangeEdmConnectionEventBt_t *pEvtData;
-        pEvent = allocateEdmEvent();
+        pEvent = allocateEdmEvent(pParser);
         pEvent->type = U_SHORT_RANGE_EDM_EVENT_CONNECT_BT;
         pEvtData = &pEvent->params.btConnectEvent;
         pEvtData->channel = channel;
@@ -159,7 +156,8 @@ static uShortRangeEdmEvent_t *parseConnectBtEvent(uint8_t channel, char *pBuffer
     return pEvent;
 }
 
-static uShortRangeEdmEvent_t *parseConnectIpv4Event(uint8_t channel, char *pBuffer,
+static uShortRangeEdmEvent_t *parseConnectIpv4Event(uShortRangeEdmParser_t *pParser,
+                                                    uint8_t channel, char *pBuffer,
                                                     uint16_t payloadLength)
 {
     uShortRangeEdmEvent_t *pEvent = NULL;
@@ -168,7 +166,7 @@ static uShortRangeEdmEvent_t *parseConnectIpv4Event(uint8_t channel, char *pBuff
 
     if ((payloadLength == 14) && (result == U_SHORT_RANGE_EDM_OK)) {
         uShortRangeEdmConnectionEventIpv4_t *pEvtData;
-        pEvent = allocateEdmEvent();
+        pEvent = allocateEdmEvent(pParser);
         pEvent->type = U_SHORT_RANGE_EDM_EVENT_CONNECT_IPv4;
         pEvtData = &pEvent->params.ipv4ConnectEvent;
         pEvtData->channel = channel;
@@ -186,7 +184,8 @@ static uShortRangeEdmEvent_t *parseConnectIpv4Event(uint8_t channel, char *pBuff
     return pEvent;
 }
 
-static uShortRangeEdmEvent_t *parseConnectIpv6Event(uint8_t channel, char *pBuffer,
+static uShortRangeEdmEvent_t *parseConnectIpv6Event(uShortRangeEdmParser_t *pParser,
+                                                    uint8_t channel, char *pBuffer,
                                                     uint16_t payloadLength)
 {
     uShortRangeEdmEvent_t *pEvent = NULL;
@@ -195,7 +194,7 @@ static uShortRangeEdmEvent_t *parseConnectIpv6Event(uint8_t channel, char *pBuff
 
     if ((payloadLength == 38) && (result == U_SHORT_RANGE_EDM_OK)) {
         uShortRangeEdmConnectionEventIpv6_t *pEvtData;
-        pEvent = allocateEdmEvent();
+        pEvent = allocateEdmEvent(pParser);
         pEvent->type = U_SHORT_RANGE_EDM_EVENT_CONNECT_IPv6;
         pEvtData = &pEvent->params.ipv6ConnectEvent;
         pEvtData->channel = channel;
@@ -213,7 +212,8 @@ static uShortRangeEdmEvent_t *parseConnectIpv6Event(uint8_t channel, char *pBuff
     return pEvent;
 }
 
-static uShortRangeEdmEvent_t *parseConnectEvent(uint8_t channel, uShortRangePbufList_t *pBufList)
+static uShortRangeEdmEvent_t *parseConnectEvent(uShortRangeEdmParser_t *pParser,
+                                                uint8_t channel, uShortRangePbufList_t *pBufList)
 {
     uShortRangeEdmEvent_t *pEvent = NULL;
     uint16_t payloadLength = 0;
@@ -229,15 +229,15 @@ static uShortRangeEdmEvent_t *parseConnectEvent(uint8_t channel, uShortRangePbuf
         switch (type) {
 
             case U_SHORT_RANGE_EDM_CONNECTION_TYPE_BT:
-                pEvent = parseConnectBtEvent(channel, pBuffer, payloadLength);
+                pEvent = parseConnectBtEvent(pParser, channel, pBuffer, payloadLength);
                 break;
 
             case U_SHORT_RANGE_EDM_CONNECTION_TYPE_IPv4:
-                pEvent = parseConnectIpv4Event(channel, pBuffer, payloadLength);
+                pEvent = parseConnectIpv4Event(pParser, channel, pBuffer, payloadLength);
                 break;
 
             case U_SHORT_RANGE_EDM_CONNECTION_TYPE_IPv6:
-                pEvent = parseConnectIpv6Event(channel, pBuffer, payloadLength);
+                pEvent = parseConnectIpv6Event(pParser, channel, pBuffer, payloadLength);
                 break;
 
             default:
@@ -248,23 +248,25 @@ static uShortRangeEdmEvent_t *parseConnectEvent(uint8_t channel, uShortRangePbuf
     return pEvent;
 }
 
-static uShortRangeEdmEvent_t *parseDisconnectEvent(uint8_t channel)
+static uShortRangeEdmEvent_t *parseDisconnectEvent(uShortRangeEdmParser_t *pParser,
+                                                   uint8_t channel)
 {
     uShortRangeEdmEvent_t *pEvent;
 
-    pEvent = allocateEdmEvent();
+    pEvent = allocateEdmEvent(pParser);
     pEvent->type = U_SHORT_RANGE_EDM_EVENT_DISCONNECT;
     pEvent->params.disconnectEvent.channel = channel;
 
     return pEvent;
 }
 
-static uShortRangeEdmEvent_t *parseDataEvent(uint8_t channel, uShortRangePbufList_t *pBufList)
+static uShortRangeEdmEvent_t *parseDataEvent(uShortRangeEdmParser_t *pParser,
+                                             uint8_t channel, uShortRangePbufList_t *pBufList)
 {
     uShortRangeEdmEvent_t *pEvent = NULL;
 
     if ((pBufList != NULL) && (pBufList->totalLen > 0)) {
-        pEvent = allocateEdmEvent();
+        pEvent = allocateEdmEvent(pParser);
         pEvent->type = U_SHORT_RANGE_EDM_EVENT_DATA;
         pEvent->params.dataEvent.channel = channel;
         pEvent->params.dataEvent.pBufList = pBufList;
@@ -273,15 +275,17 @@ static uShortRangeEdmEvent_t *parseDataEvent(uint8_t channel, uShortRangePbufLis
     return pEvent;
 }
 
-static uShortRangeEdmEvent_t *parseAtResponseOrEvent(uShortRangePbufList_t *pBufList)
+static uShortRangeEdmEvent_t *parseAtResponseOrEvent(uShortRangeEdmParser_t *pParser,
+                                                     uShortRangePbufList_t *pBufList)
 {
-    uShortRangeEdmEvent_t *pEvent = allocateEdmEvent();
+    uShortRangeEdmEvent_t *pEvent = allocateEdmEvent(pParser);
     pEvent->type = U_SHORT_RANGE_EDM_EVENT_AT;
     pEvent->params.atEvent.pBufList = pBufList;
     return pEvent;
 }
 
-static uShortRangeEdmEvent_t *parseEdmPayload(uint16_t idAndType, uint8_t channel,
+static uShortRangeEdmEvent_t *parseEdmPayload(uShortRangeEdmParser_t *pParser,
+                                              uint16_t idAndType, uint8_t channel,
                                               uShortRangePbufList_t *pBufList)
 {
     uShortRangeEdmEvent_t *pEvent = NULL;
@@ -289,26 +293,26 @@ static uShortRangeEdmEvent_t *parseEdmPayload(uint16_t idAndType, uint8_t channe
     switch (idAndType) {
 
         case U_SHORT_RANGE_EDM_TYPE_CONNECT_EVENT:
-            pEvent = parseConnectEvent(channel, pBufList);
+            pEvent = parseConnectEvent(pParser, channel, pBufList);
             uShortRangePbufListFree(pBufList);
             break;
 
         case U_SHORT_RANGE_EDM_TYPE_DISCONNECT_EVENT:
-            pEvent = parseDisconnectEvent(channel);
+            pEvent = parseDisconnectEvent(pParser, channel);
             uShortRangePbufListFree(pBufList);
             break;
 
         case U_SHORT_RANGE_EDM_TYPE_DATA_EVENT:
-            pEvent = parseDataEvent(channel, pBufList);
+            pEvent = parseDataEvent(pParser, channel, pBufList);
             break;
 
         case U_SHORT_RANGE_EDM_TYPE_AT_RESPONSE:
         case U_SHORT_RANGE_EDM_TYPE_AT_EVENT:
-            pEvent = parseAtResponseOrEvent(pBufList);
+            pEvent = parseAtResponseOrEvent(pParser, pBufList);
             break;
 
         case U_SHORT_RANGE_EDM_TYPE_START_EVENT:
-            pEvent = allocateEdmEvent();
+            pEvent = allocateEdmEvent(pParser);
             pEvent->type = U_SHORT_RANGE_EDM_EVENT_STARTUP;
             break;
         //lint -e825
@@ -322,183 +326,245 @@ static uShortRangeEdmEvent_t *parseEdmPayload(uint16_t idAndType, uint8_t channe
     }
     return pEvent;
 }
-/* ----------------------------------------------------------------
- * PUBLIC FUNCTIONS
- * -------------------------------------------------------------- */
-bool uShortRangeEdmParserReady(void)
-{
-    return (gEdmParserState != EDM_PARSER_STATE_WAIT_FOR_EVENT_PROCESSING);
-}
-
-void uShortRangeEdmResetParser(void)
-{
-    gEdmParserState = EDM_PARSER_STATE_PARSE_START_BYTE;
-}
 
-bool uShortRangeEdmParse(char c, uShortRangeEdmEvent_t **ppResultEvent, bool *pMemAvailable)
+// Parse a single byte of the framing of an EDM packet, i.e. anything
+// other than the payload, which is handled by
+// pUShortRangeEdmParserPayloadSpace() and
+// uShortRangeEdmParserPayloadCommit().
+static void parseByte(uShortRangeEdmParser_t *pParser, char c,
+                      uShortRangeEdmEvent_t **ppResultEvent)
 {
-    edmParserState_t newState = gEdmParserState;
-    static uint16_t payloadLength;
-    static uShortRangePbuf_t *pBuf;
-    static int32_t pBufSize;
-    static char header[U_SHORT_RANGE_EDM_HEADER_SIZE];
-    static uint32_t headerIndex;
-    static uint16_t idAndType;
-    static uint8_t channel;
-    bool charConsumed = false;
-    int32_t result;
+    uShortRangeEdmParserState_t newState = pParser->state;
 
-    *pMemAvailable = true;
-    switch (gEdmParserState) {
+    switch (pParser->state) {
 
-        case EDM_PARSER_STATE_PARSE_START_BYTE:
+        case U_SHORT_RANGE_EDM_PARSER_STATE_PARSE_START_BYTE:
             if (c == U_SHORT_RANGE_EDM_HEAD) {
-                headerIndex = 0;
-                newState = EDM_PARSER_STATE_PARSE_PAYLOAD_LENGTH;
+                pParser->headerIndex = 0;
+                newState = U_SHORT_RANGE_EDM_PARSER_STATE_PARSE_PAYLOAD_LENGTH;
             }
-            charConsumed = true;
             break;
 
-        case EDM_PARSER_STATE_PARSE_PAYLOAD_LENGTH:
-            if (headerIndex == 0) {
-                payloadLength = (uint16_t)(uint8_t)c << 8;
-                headerIndex++;
+        case U_SHORT_RANGE_EDM_PARSER_STATE_PARSE_PAYLOAD_LENGTH:
+            if (pParser->headerIndex == 0) {
+                pParser->payloadLength = (uint16_t)(uint8_t)c << 8;
+                pParser->headerIndex++;
             } else {
-                payloadLength |= (uint16_t)(uint8_t)c;
-                if (payloadLength < 2) {
+                pParser->payloadLength |= (uint16_t)(uint8_t)c;
+                if (pParser->payloadLength < 2) {
                     // Something is wrong, start over
-                    newState = EDM_PARSER_STATE_PARSE_START_BYTE;
+                    newState = U_SHORT_RANGE_EDM_PARSER_STATE_PARSE_START_BYTE;
                 } else {
-                    headerIndex = 0;
-                    newState = EDM_PARSER_STATE_PARSE_HEADER_LENGTH;
+                    pParser->headerIndex = 0;
+                    newState = U_SHORT_RANGE_EDM_PARSER_STATE_PARSE_HEADER_LENGTH;
                 }
             }
-            charConsumed = true;
             break;
-        case EDM_PARSER_STATE_PARSE_HEADER_LENGTH:
-            header[headerIndex++] = c;
-            payloadLength--;
+        case U_SHORT_RANGE_EDM_PARSER_STATE_PARSE_HEADER_LENGTH:
+            pParser->header[pParser->headerIndex++] = c;
+            pParser->payloadLength--;
 
-            if (headerIndex == 2) {
+            if (pParser->headerIndex == 2) {
 
-                idAndType = ((uint16_t)(uint8_t)header[0] << 8) | (uint16_t)(uint8_t)header[1];
+                pParser->idAndType = ((uint16_t)(uint8_t)pParser->header[0] << 8) |
+                                     (uint16_t)(uint8_t)pParser->header[1];
 
-                if ((idAndType == U_SHORT_RANGE_EDM_TYPE_AT_RESPONSE) ||
-                    (idAndType == U_SHORT_RANGE_EDM_TYPE_AT_EVENT)    ||
-                    (idAndType == U_SHORT_RANGE_EDM_TYPE_START_EVENT) ||
-                    (idAndType == U_SHORT_RANGE_EDM_TYPE_AT_REQUEST)) {
+                if ((pParser->idAndType == U_SHORT_RANGE_EDM_TYPE_AT_RESPONSE) ||
+                    (pParser->idAndType == U_SHORT_RANGE_EDM_TYPE_AT_EVENT)    ||
+                    (pParser->idAndType == U_SHORT_RANGE_EDM_TYPE_START_EVENT) ||
+                    (pParser->idAndType == U_SHORT_RANGE_EDM_TYPE_AT_REQUEST)) {
 
                     // Channel does not exist for these types so
                     // fill in -1
-                    header[headerIndex++] = -1;
+                    pParser->header[pParser->headerIndex++] = -1;
                 }
             }
 
-            if (headerIndex == U_SHORT_RANGE_EDM_HEADER_SIZE) {
-                channel = header[2];
-                // gCurPBufChain should always be NULL here
+            if (pParser->headerIndex == U_SHORT_RANGE_EDM_HEADER_SIZE) {
+                pParser->channel = pParser->header[2];
+                // pBufList should always be NULL here
                 // If it's not we have a leak
-                U_ASSERT(gCurPBufList == NULL);
-                pBuf = NULL;
-                newState = EDM_PARSER_STATE_ALLOCATE_PBUFLIST;
+                U_ASSERT(pParser->pBufList == NULL);
+                pParser->pBuf = NULL;
+                newState = U_SHORT_RANGE_EDM_PARSER_STATE_ALLOCATE_PBUFLIST;
                 // For disconnect event there is no payload
                 // so directly head to parse tail byte
-                if ((idAndType == U_SHORT_RANGE_EDM_TYPE_DISCONNECT_EVENT) ||
-                    (idAndType == U_SHORT_RANGE_EDM_TYPE_START_EVENT)) {
-                    newState = EDM_PARSER_STATE_PARSE_TAIL_BYTE;
+                if ((pParser->idAndType == U_SHORT_RANGE_EDM_TYPE_DISCONNECT_EVENT) ||
+                    (pParser->idAndType == U_SHORT_RANGE_EDM_TYPE_START_EVENT)) {
+                    newState = U_SHORT_RANGE_EDM_PARSER_STATE_PARSE_TAIL_BYTE;
                 }
             }
-            charConsumed = true;
             break;
 
-        case EDM_PARSER_STATE_ALLOCATE_PBUFLIST:
-
-            // if allocation fails stay back until
-            // we have some free memory in their respective pool
-            gCurPBufList = pUShortRangePbufListAlloc();
-            if (gCurPBufList != NULL) {
-                gCurPBufList->edmChannel = channel;
-                newState = EDM_PARSER_STATE_ALLOCATE_PAYLOAD;
-            } else {
-                *pMemAvailable = false; // remain at same state, try again later
+        case U_SHORT_RANGE_EDM_PARSER_STATE_PARSE_TAIL_BYTE:
+            newState = U_SHORT_RANGE_EDM_PARSER_STATE_PARSE_START_BYTE;
+            if (c == U_SHORT_RANGE_EDM_TAIL) {
+                *ppResultEvent = parseEdmPayload(pParser, pParser->idAndType,
+                                                 pParser->channel, pParser->pBufList);
+                if (*ppResultEvent != NULL) {
+                    newState = U_SHORT_RANGE_EDM_PARSER_STATE_WAIT_FOR_EVENT_PROCESSING;
+                }
+            }
+            if (newState == U_SHORT_RANGE_EDM_PARSER_STATE_PARSE_START_BYTE) {
+                // Always de-allocate the buffer when we reset the parser
+                uShortRangePbufListFree(pParser->pBufList);
             }
-            // we dont consume the input char in this state
-            charConsumed = false;
+            pParser->pBufList = NULL;
+            break;
+
+        default:
+            // The allocation/payload states are handled elsewhere;
+            // in the wait state the parser will stay put until it
+            // is reset, to avoid overwriting data in an unprocessed
+            // event: any user of the parser thus has to reset it
+            // when it has processed a generated event.
             break;
+    }
+
+    pParser->state = newState;
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+bool uShortRangeEdmParserReady(const uShortRangeEdmParser_t *pParser)
+{
+    return (pParser->state != U_SHORT_RANGE_EDM_PARSER_STATE_WAIT_FOR_EVENT_PROCESSING);
+}
+
+void uShortRangeEdmResetParser(uShortRangeEdmParser_t *pParser)
+{
+    // Throw away any partial packet (the pbuf list of a generated
+    // event belongs to the event); a pbuf that has not yet been
+    // added to the list is added so that it is freed too
+    if ((pParser->pBuf != NULL) && (pParser->pBufList != NULL)) {
+        uShortRangePbufListAppend(pParser->pBufList, pParser->pBuf);
+    }
+    uShortRangePbufListFree(pParser->pBufList);
+    pParser->pBuf = NULL;
+    pParser->pBufList = NULL;
+    pParser->state = U_SHORT_RANGE_EDM_PARSER_STATE_PARSE_START_BYTE;
+}
+
+char *pUShortRangeEdmParserPayloadSpace(uShortRangeEdmParser_t *pParser,
+                                        size_t *pSize, bool *pMemAvailable)
+{
+    char *pSpace = NULL;
+
+    *pMemAvailable = true;
 
-        case EDM_PARSER_STATE_ALLOCATE_PAYLOAD:
+    if (pParser->state == U_SHORT_RANGE_EDM_PARSER_STATE_ALLOCATE_PBUFLIST) {
+        // if allocation fails stay back until
+        // we have some free memory in their respective pool
+        pParser->pBufList = pUShortRangePbufListAllocFromPool(pParser->poolIndex);
+        if (pParser->pBufList != NULL) {
+            pParser->pBufList->edmChannel = pParser->channel;
+            pParser->state = U_SHORT_RANGE_EDM_PARSER_STATE_ALLOCATE_PAYLOAD;
+        } else {
+            *pMemAvailable = false; // remain at same state, try again later
+        }
+    }
 
-            // if allocation fails stay back until
-            // we have some free memory in their respective pool
-            pBufSize = uShortRangePbufAlloc(&pBuf);
-            if (pBufSize > 0) {
-                headerIndex = 0;
-                newState = EDM_PARSER_STATE_ACCUMULATE_PAYLOAD;
+    if (pParser->state == U_SHORT_RANGE_EDM_PARSER_STATE_ALLOCATE_PAYLOAD) {
+        if (pParser->payloadLength == 0) {
+            // Nothing more to come but the tail
+            pParser->state = U_SHORT_RANGE_EDM_PARSER_STATE_PARSE_TAIL_BYTE;
+        } else {
+            // As above, stay put if there is no memory
+            pParser->pBufSize = uShortRangePbufAllocFromPool(pParser->poolIndex,
+                                                             &pParser->pBuf);
+            if (pParser->pBufSize > 0) {
+                pParser->state = U_SHORT_RANGE_EDM_PARSER_STATE_ACCUMULATE_PAYLOAD;
             } else {
-                *pMemAvailable = false; // remain at same state, try again later
+                pParser->pBuf = NULL;
+                *pMemAvailable = false;
             }
-            // we dont consume the input char in this state
-            charConsumed = false;
-            break;
+        }
+    }
 
-        case EDM_PARSER_STATE_ACCUMULATE_PAYLOAD:
-
-            U_ASSERT(pBufSize > 0);
-            U_ASSERT(pBuf != NULL);
-            U_ASSERT(pBuf->length < pBufSize);
-
-            pBuf->data[pBuf->length++] = c;
-            payloadLength--;
-
-            if ((pBuf->length == pBufSize) ||
-                (payloadLength == 0)) {
-                result = uShortRangePbufListAppend(gCurPBufList, pBuf);
-                U_ASSERT(result == 0);
-                if (payloadLength == 0) {
-                    newState = EDM_PARSER_STATE_PARSE_TAIL_BYTE;
-                } else if (pBuf->length == pBufSize) {
-                    // we have some more data coming in
-                    // so allocate memory for payload
-                    newState = EDM_PARSER_STATE_ALLOCATE_PAYLOAD;
-                }
-                pBuf = NULL;
+    if (pParser->state == U_SHORT_RANGE_EDM_PARSER_STATE_ACCUMULATE_PAYLOAD) {
+        U_ASSERT(pParser->pBuf != NULL);
+        U_ASSERT(pParser->pBuf->length < pParser->pBufSize);
+        pSpace = &pParser->pBuf->data[pParser->pBuf->length];
+        *pSize = (size_t) (pParser->pBufSize - pParser->pBuf->length);
+        if (*pSize > pParser->payloadLength) {
+            *pSize = pParser->payloadLength;
+        }
+    }
+
+    return pSpace;
+}
+
+void uShortRangeEdmParserPayloadCommit(uShortRangeEdmParser_t *pParser,
+                                       size_t length)
+{
+    uShortRangePbuf_t *pBuf = pParser->pBuf;
+    int32_t result;
+
+    if ((pParser->state == U_SHORT_RANGE_EDM_PARSER_STATE_ACCUMULATE_PAYLOAD) &&
+        (length > 0)) {
+        U_ASSERT(length <= (size_t) (pParser->pBufSize - pBuf->length));
+        U_ASSERT(length <= pParser->payloadLength);
+
+        pBuf->length += (uint16_t) length;
+        pParser->payloadLength -= (uint16_t) length;
+
+        if ((pBuf->length == pParser->pBufSize) ||
+            (pParser->payloadLength == 0)) {
+            result = uShortRangePbufListAppend(pParser->pBufList, pBuf);
+            U_ASSERT(result == 0);
+            (void) result;
+            if (pParser->payloadLength == 0) {
+                pParser->state = U_SHORT_RANGE_EDM_PARSER_STATE_PARSE_TAIL_BYTE;
+            } else {
+                // we have some more data coming in
+                // so allocate memory for payload
+                pParser->state = U_SHORT_RANGE_EDM_PARSER_STATE_ALLOCATE_PAYLOAD;
             }
-            charConsumed = true;
-            break;
+            pParser->pBuf = NULL;
+        }
+    }
+}
 
-        case EDM_PARSER_STATE_PARSE_TAIL_BYTE:
-            newState = EDM_PARSER_STATE_PARSE_START_BYTE;
-            if (c == U_SHORT_RANGE_EDM_TAIL) {
-                if (ppResultEvent != NULL) {
-                    *ppResultEvent = parseEdmPayload(idAndType, channel, gCurPBufList);
-                    if (*ppResultEvent == NULL) {
-                        // No event was generated
-                        // Reset parser
-                        newState = EDM_PARSER_STATE_PARSE_START_BYTE;
-                    } else {
-                        newState = EDM_PARSER_STATE_WAIT_FOR_EVENT_PROCESSING;
+size_t uShortRangeEdmParse(uShortRangeEdmParser_t *pParser,
+                           const char *pData, size_t length,
+                           uShortRangeEdmEvent_t **ppResultEvent,
+                           bool *pMemAvailable)
+{
+    size_t consumed = 0;
+    size_t x = 0;
+    char *pSpace;
+
+    *ppResultEvent = NULL;
+    *pMemAvailable = true;
+
+    while ((consumed < length) && *pMemAvailable && (*ppResultEvent == NULL) &&
+           uShortRangeEdmParserReady(pParser)) {
+        switch (pParser->state) {
+            case U_SHORT_RANGE_EDM_PARSER_STATE_ALLOCATE_PBUFLIST:
+            case U_SHORT_RANGE_EDM_PARSER_STATE_ALLOCATE_PAYLOAD:
+            case U_SHORT_RANGE_EDM_PARSER_STATE_ACCUMULATE_PAYLOAD:
+                // Copy as much of the payload as we have in one go;
+                // when there is no memory available in the pool
+                // we stop and the caller has to try again later
+                pSpace = pUShortRangeEdmParserPayloadSpace(pParser, &x, pMemAvailable);
+                if (pSpace != NULL) {
+                    if (x > length - consumed) {
+                        x = length - consumed;
                     }
+                    memcpy(pSpace, pData + consumed, x);
+                    uShortRangeEdmParserPayloadCommit(pParser, x);
+                    consumed += x;
                 }
-            }
-            if (newState == EDM_PARSER_STATE_PARSE_START_BYTE) {
-                // Always de-allocate the buffer when we reset the parser
-                uShortRangePbufListFree(gCurPBufList);
-            }
-            gCurPBufList = NULL;
-            charConsumed = true;
-            break;
-
-        case EDM_PARSER_STATE_WAIT_FOR_EVENT_PROCESSING:
-            // Parser will stay in this state until parser is reset.
-            // This to avoid the parser overwriting data in an unprocessed event
-            // Any user of the parser thus have to reset the parser when it has
-            // processed a generated event, to make it ready for parsing
-            break;
+                break;
+            default:
+                parseByte(pParser, pData[consumed], ppResultEvent);
+                consumed++;
+                break;
+        }
     }
 
-    gEdmParserState = newState;
-
-    return charConsumed;
+    return consumed;
 }
 
 int32_t uShortRangeEdmZeroCopyHeadData(uint8_t channel, uint32_t size, char *pHead)
@@ -99,6 +99,37 @@ typedef struct {
     } params;
 } uShortRangeEdmEvent_t;
 
+typedef enum {
+    U_SHORT_RANGE_EDM_PARSER_STATE_PARSE_START_BYTE = 0,
+    U_SHORT_RANGE_EDM_PARSER_STATE_PARSE_PAYLOAD_LENGTH,
+    U_SHORT_RANGE_EDM_PARSER_STATE_PARSE_HEADER_LENGTH,
+    U_SHORT_RANGE_EDM_PARSER_STATE_ALLOCATE_PBUFLIST,
+    U_SHORT_RANGE_EDM_PARSER_STATE_ALLOCATE_PAYLOAD,
+    U_SHORT_RANGE_EDM_PARSER_STATE_ACCUMULATE_PAYLOAD,
+    U_SHORT_RANGE_EDM_PARSER_STATE_PARSE_TAIL_BYTE,
+    U_SHORT_RANGE_EDM_PARSER_STATE_WAIT_FOR_EVENT_PROCESSING
+} uShortRangeEdmParserState_t;
+
+/** The state of an EDM parser; one of these is needed for each
+ * EDM stream.  Other than poolIndex, which is the set of pbuf
+ * pools the parser allocates from (see
+ * uShortRangePbufAllocFromPool()) and may be set by the owner of
+ * the parser, the contents should be treated as private.
+ */
+typedef struct {
+    int32_t poolIndex;
+    uShortRangeEdmParserState_t state;
+    uint16_t payloadLength;
+    uShortRangePbuf_t *pBuf;
+    int32_t pBufSize;
+    char header[U_SHORT_RANGE_EDM_HEADER_SIZE];
+    uint32_t headerIndex;
+    uint16_t idAndType;
+    uint8_t channel;
+    uShortRangePbufList_t *pBufList;
+    uShortRangeEdmEvent_t event;
+} uShortRangeEdmParser_t;
+
 /**
  *
  * @brief Check if EDM parser is available
@@ -106,36 +137,87 @@ typedef struct {
  * @note  Do not call the uShortRangeEdmParse function if this function
  *        returns false.
  *
+ * @param[in] pParser The parser.
+ *
  * @return True if EDM parser is available
  */
-bool uShortRangeEdmParserReady(void);
+bool uShortRangeEdmParserReady(const uShortRangeEdmParser_t *pParser);
 
 /**
  *
  * @brief Reset the parser. Do this every time the latest EDM event
  *        has been processed to make the parser available again.
+ *        Any partially received packet is thrown away.  A parser
+ *        that is all zeroes is also a reset parser.
+ *
+ * @param[in,out] pParser The parser.
  */
-void uShortRangeEdmResetParser(void);
+void uShortRangeEdmResetParser(uShortRangeEdmParser_t *pParser);
 
 /**
  *
  * @brief Function for parsing binary EDM data
  *
  * @note  Do not call this function if parser is not available,
- *        Check if parser is available with uShortRangeEdmParserAvailable
+ *        Check if parser is available with uShortRangeEdmParserReady
  *        If a packet is invalid it will be silently dropped.
+ *        Payload is copied into pbufs a run at a time, parsing stops
+ *        when an event has been generated or when no pbuf memory is
+ *        available.
+ *
+ * @param[in,out] pParser The parser.
  *
- * @param c Input character.
+ * @param[in] pData Input data.
+ *
+ * @param length The number of bytes at pData.
  *
  * @param[out] ppResultEvent Address of pointer to event, NULL if no event was generated
  *             An event is created when the last character in a EDM packet
- *             is parsed and the packet is valid.
+ *             is parsed and the packet is valid.  The event is stored in
+ *             pParser and remains valid until the parser is reset.
+ *
+ * @param[out] pMemAvailable Pointer to a boolean that indicates if memory was allocated successfully.
+ *
+ * @return The number of bytes at pData that were consumed.
+ */
+size_t uShortRangeEdmParse(uShortRangeEdmParser_t *pParser,
+                           const char *pData, size_t length,
+                           uShortRangeEdmEvent_t **ppResultEvent,
+                           bool *pMemAvailable);
+
+/**
+ *
+ * @brief Get the space that the payload the parser expects next can be
+ *        written to directly, e.g. by a UART read, avoiding a copy.
+ *        If the parser is waiting for payload this will allocate the
+ *        pbuf list and pbuf it needs.
+ *
+ * @param[in,out] pParser The parser.
+ *
+ * @param[out] pSize The number of bytes that may be written at the
+ *             returned pointer; never more than the payload outstanding.
  *
  * @param[out] pMemAvailable Pointer to a boolean that indicates if memory was allocated successfully.
  *
- * @return True when input character c is consumed else false.
+ * @return Where to write the payload, NULL if the parser is not waiting
+ *         for payload (or there is no memory), in which case data should
+ *         be passed to uShortRangeEdmParse.
+ */
+char *pUShortRangeEdmParserPayloadSpace(uShortRangeEdmParser_t *pParser,
+                                        size_t *pSize, bool *pMemAvailable);
+
+/**
+ *
+ * @brief Tell the parser that payload has been written to the space
+ *        returned by pUShortRangeEdmParserPayloadSpace.
+ *
+ * @param[in,out] pParser The parser.
+ *
+ * @param length The number of bytes written, which must be no more than
+ *        the size returned by pUShortRangeEdmParserPayloadSpace.
  */
-bool uShortRangeEdmParse(char c, uShortRangeEdmEvent_t **ppResultEvent, bool *pMemAvailable);
+void uShortRangeEdmParserPayloadCommit(uShortRangeEdmParser_t *pParser,
+                                       size_t length);
 
 /**
  *
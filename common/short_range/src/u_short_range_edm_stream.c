@@ -64,6 +64,9 @@
 // TODO: is this value correct?
 #define U_SHORT_RANGE_EDM_STREAM_AT_RESPONSE_LENGTH 500
 #define U_SHORT_RANGE_EDM_STREAM_MAX_CONNECTIONS    9
+// The size of the buffer that EDM framing is read into from the
+// UART: payload is read straight into pbufs.
+#define U_SHORT_RANGE_EDM_STREAM_RX_BUFFER_LENGTH   128
 
 #ifndef U_EDM_STREAM_TASK_STACK_SIZE_BYTES
 #define U_EDM_STREAM_TASK_STACK_SIZE_BYTES  U_AT_CLIENT_URC_TASK_STACK_SIZE_BYTES
@@ -151,6 +154,7 @@ typedef struct {
 } uShortRangeEdmStreamDataEvent_t;
 
 typedef struct {
+    struct uEdmStreamInstance_t *pEdmStream;
     uShortRangeEdmStreamEventType_t type;
     union {
         // no content in at event       at;
@@ -174,6 +178,7 @@ typedef struct {
 } uShortRangeEdmStreamConnections_t;
 
 typedef struct uEdmStreamInstance_t {
+    uPortMutexHandle_t mutex; // Protects the instance, created by uShortRangeEdmStreamInit()
     bool ignoreUartCallback;
     int32_t handle;
     int32_t uartHandle;
@@ -199,14 +204,21 @@ typedef struct uEdmStreamInstance_t {
     int32_t atResponseLength;
     int32_t atResponseRead;
     uShortRangeEdmStreamConnections_t connections[U_SHORT_RANGE_EDM_STREAM_MAX_CONNECTIONS];
+    uShortRangeEdmParser_t parser;
+    char rxBuffer[U_SHORT_RANGE_EDM_STREAM_RX_BUFFER_LENGTH];
+    size_t rxBufferStart; // Where the unparsed data in rxBuffer starts
+    size_t rxBufferEnd;   // Where the unparsed data in rxBuffer ends
 } uShortRangeEdmStreamInstance_t;
 
 /* ----------------------------------------------------------------
  * VARIABLES
  * -------------------------------------------------------------- */
 
+// Protects the table of instances; if both this and the mutex of
+// an instance are to be locked this must be locked first.
 static uPortMutexHandle_t gMutex = NULL;
-static uShortRangeEdmStreamInstance_t gEdmStream;
+// The instances, the handle of an instance is its index.
+static uShortRangeEdmStreamInstance_t gEdmStream[U_SHORT_RANGE_EDM_STREAM_MAX_NUM];
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -275,13 +287,14 @@ static const char *getProtocolText(uShortRangeIpProtocol_t protocol)
 #endif
 
 // Find connection from channel, use -1 to get the first free slot
-static uShortRangeEdmStreamConnections_t *findConnection(int32_t channel)
+static uShortRangeEdmStreamConnections_t *findConnection(uShortRangeEdmStreamInstance_t *pEdmStream,
+                                                         int32_t channel)
 {
     uShortRangeEdmStreamConnections_t *pConnection = NULL;
 
     for (uint32_t i = 0; i < U_SHORT_RANGE_EDM_STREAM_MAX_CONNECTIONS; i++) {
-        if (gEdmStream.connections[i].channel == channel) {
-            pConnection = &gEdmStream.connections[i];
+        if (pEdmStream->connections[i].channel == channel) {
+            pConnection = &pEdmStream->connections[i];
             break;
         }
     }
@@ -289,11 +302,11 @@ static uShortRangeEdmStreamConnections_t *findConnection(int32_t channel)
     return pConnection;
 }
 
-static void processedEvent(void)
+static void processedEvent(uShortRangeEdmStreamInstance_t *pEdmStream)
 {
     int32_t sendErrorCode;
 
-    uShortRangeEdmResetParser();
+    uShortRangeEdmResetParser(&pEdmStream->parser);
     // Trigger an event from the uart to get parsing going again
     // First use the "try" version so as not to block, which can
     // lead to mutex lock-outs if the queue is full: if the "try"
@@ -301,89 +314,93 @@ static void processedEvent(void)
     // to the blocking version; there is no danger here since,
     // if there are already events in the UART queue, the URC
     // callback will certainly be run anyway.
-    sendErrorCode = uPortUartEventTrySend(gEdmStream.uartHandle,
+    sendErrorCode = uPortUartEventTrySend(pEdmStream->uartHandle,
                                           U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED,
                                           0);
     if ((sendErrorCode == (int32_t) U_ERROR_COMMON_NOT_IMPLEMENTED) ||
         (sendErrorCode == (int32_t) U_ERROR_COMMON_NOT_SUPPORTED)) {
-        uPortUartEventSend(gEdmStream.uartHandle,
+        uPortUartEventSend(pEdmStream->uartHandle,
                            U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED);
     }
 }
 
-static void atEventHandler(void)
+static void atEventHandler(uShortRangeEdmStreamInstance_t *pEdmStream)
 {
-    if (gEdmStream.pAtCallback != NULL) {
-        gEdmStream.pAtCallback(gEdmStream.handle,
-                               U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED,
-                               gEdmStream.pAtCallbackParam);
+    if (pEdmStream->pAtCallback != NULL) {
+        pEdmStream->pAtCallback(pEdmStream->handle,
+                                U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED,
+                                pEdmStream->pAtCallbackParam);
     }
     // This event is not fully processed until uShortRangeEdmStreamAtRead has been called
     // and all event data been read out
 }
 
 // Event handler, calls the user's event callback.
-static void btEventHandler(uShortRangeEdmStreamBtEvent_t *pBtEvent)
+static void btEventHandler(uShortRangeEdmStreamInstance_t *pEdmStream,
+                           uShortRangeEdmStreamBtEvent_t *pBtEvent)
 {
-    if (gEdmStream.pBtEventCallback != NULL) {
-        gEdmStream.pBtEventCallback(gEdmStream.handle, pBtEvent->channel, pBtEvent->type,
-                                    &pBtEvent->conData, gEdmStream.pBtEventCallbackParam);
+    if (pEdmStream->pBtEventCallback != NULL) {
+        pEdmStream->pBtEventCallback(pEdmStream->handle, pBtEvent->channel, pBtEvent->type,
+                                     &pBtEvent->conData, pEdmStream->pBtEventCallbackParam);
     }
     uEdmChLogLine(LOG_CH_BT, "processed");
-    processedEvent();
+    processedEvent(pEdmStream);
 }
 
 // Event handler, calls the user's event callback.
-static void ipEventHandler(uShortRangeEdmStreamIpEvent_t *pIpEvent)
+static void ipEventHandler(uShortRangeEdmStreamInstance_t *pEdmStream,
+                           uShortRangeEdmStreamIpEvent_t *pIpEvent)
 {
-    if (gEdmStream.pIpEventCallback != NULL) {
-        gEdmStream.pIpEventCallback(gEdmStream.handle, pIpEvent->channel, pIpEvent->type,
-                                    &pIpEvent->conData, gEdmStream.pIpEventCallbackParam);
+    if (pEdmStream->pIpEventCallback != NULL) {
+        pEdmStream->pIpEventCallback(pEdmStream->handle, pIpEvent->channel, pIpEvent->type,
+                                     &pIpEvent->conData, pEdmStream->pIpEventCallbackParam);
     }
 
     uEdmChLogLine(LOG_CH_IP, "processed");
-    processedEvent();
+    processedEvent(pEdmStream);
 }
 
 // Event handler, calls the user's event callback.
-static void mqttEventHandler(uShortRangeEdmStreamIpEvent_t *pMqttEvent)
+static void mqttEventHandler(uShortRangeEdmStreamInstance_t *pEdmStream,
+                             uShortRangeEdmStreamIpEvent_t *pMqttEvent)
 {
-    if (gEdmStream.pMqttEventCallback != NULL) {
-        gEdmStream.pMqttEventCallback(gEdmStream.handle, pMqttEvent->channel, pMqttEvent->type,
-                                      &pMqttEvent->conData, gEdmStream.pMqttEventCallbackParam);
+    if (pEdmStream->pMqttEventCallback != NULL) {
+        pEdmStream->pMqttEventCallback(pEdmStream->handle, pMqttEvent->channel, pMqttEvent->type,
+                                       &pMqttEvent->conData, pEdmStream->pMqttEventCallbackParam);
     }
     uEdmChLogLine(LOG_CH_IP, "processed");
-    processedEvent();
+    processedEvent(pEdmStream);
 }
 
-static void dataEventHandler(uShortRangeEdmStreamDataEvent_t *pDataEvent)
+static void dataEventHandler(uShortRangeEdmStreamInstance_t *pEdmStream,
+                             uShortRangeEdmStreamDataEvent_t *pDataEvent)
 {
     uShortRangeEdmStreamConnections_t *pConnection;
     volatile uEdmDataEventCallback_t pDataCallback = NULL;
     volatile void *pCallbackParam = NULL;
     volatile int32_t edmStreamHandle = -1;
 
-    uPortMutexLock(gMutex);
-    pConnection = findConnection(pDataEvent->channel);
+    uPortMutexLock(pEdmStream->mutex);
+    pConnection = findConnection(pEdmStream, pDataEvent->channel);
 
     if (pConnection != NULL) {
-        edmStreamHandle = gEdmStream.handle;
+        edmStreamHandle = pEdmStream->handle;
 
         switch (pConnection->type) {
 
             case U_SHORT_RANGE_CONNECTION_TYPE_BT:
-                pDataCallback = gEdmStream.pBtDataCallback;
-                pCallbackParam = gEdmStream.pBtDataCallbackParam;
+                pDataCallback = pEdmStream->pBtDataCallback;
+                pCallbackParam = pEdmStream->pBtDataCallbackParam;
                 break;
 
             case U_SHORT_RANGE_CONNECTION_TYPE_IP:
-                pDataCallback = gEdmStream.pIpDataCallback;
-                pCallbackParam = gEdmStream.pIpDataCallbackParam;
+                pDataCallback = pEdmStream->pIpDataCallback;
+                pCallbackParam = pEdmStream->pIpDataCallbackParam;
                 break;
 
             case U_SHORT_RANGE_CONNECTION_TYPE_MQTT:
-                pDataCallback = gEdmStream.pMqttDataCallback;
-                pCallbackParam = gEdmStream.pMqttDataCallbackParam;
+                pDataCallback = pEdmStream->pMqttDataCallback;
+                pCallbackParam = pEdmStream->pMqttDataCallbackParam;
                 break;
 
             case U_SHORT_RANGE_CONNECTION_TYPE_INVALID:
@@ -395,47 +412,49 @@ static void dataEventHandler(uShortRangeEdmStreamDataEvent_t *pDataEvent)
     if (pDataCallback != NULL) {
         // Make sure we release the lock before calling the callback
         // otherwise this may result in a deadlock
-        uPortMutexUnlock(gMutex);
+        uPortMutexUnlock(pEdmStream->mutex);
         //lint -e(1773) Suppress "attempt to cast away const"
         pDataCallback(edmStreamHandle, pDataEvent->channel, pDataEvent->pBufList,
                       (void *)pCallbackParam);
-        uPortMutexLock(gMutex);
+        uPortMutexLock(pEdmStream->mutex);
     }
 
     uEdmChLogLine(LOG_CH_DATA, "processed");
-    processedEvent();
-    uPortMutexUnlock(gMutex);
+    processedEvent(pEdmStream);
+    uPortMutexUnlock(pEdmStream->mutex);
 }
 
 static void eventHandler(void *pParam, size_t paramLength)
 {
     uShortRangeEdmStreamEvent_t *pEvent = (uShortRangeEdmStreamEvent_t *)pParam;
+    uShortRangeEdmStreamInstance_t *pEdmStream;
     (void)paramLength;
 
     if (pEvent == NULL) {
         return;
     }
+    pEdmStream = pEvent->pEdmStream;
 
     switch (pEvent->type) {
 
         case U_SHORT_RANGE_EDM_STREAM_EVENT_AT:
-            atEventHandler();
+            atEventHandler(pEdmStream);
             break;
 
         case U_SHORT_RANGE_EDM_STREAM_EVENT_BT:
-            btEventHandler(&(pEvent->bt));
+            btEventHandler(pEdmStream, &(pEvent->bt));
             break;
 
         case U_SHORT_RANGE_EDM_STREAM_EVENT_IP:
-            ipEventHandler(&(pEvent->ip));
+            ipEventHandler(pEdmStream, &(pEvent->ip));
             break;
 
         case U_SHORT_RANGE_EDM_STREAM_EVENT_MQTT:
-            mqttEventHandler(&(pEvent->mqtt));
+            mqttEventHandler(pEdmStream, &(pEvent->mqtt));
             break;
 
         case U_SHORT_RANGE_EDM_STREAM_EVENT_DATA:
-            dataEventHandler(&(pEvent->data));
+            dataEventHandler(pEdmStream, &(pEvent->data));
             break;
 
         default:
@@ -443,26 +462,28 @@ static void eventHandler(void *pParam, size_t paramLength)
     }
 }
 
-static bool enqueueEdmAtEvent(uShortRangeEdmEvent_t *pEvent)
+static bool enqueueEdmAtEvent(uShortRangeEdmStreamInstance_t *pEdmStream,
+                              uShortRangeEdmEvent_t *pEvent)
 {
     bool success = false;
     uShortRangeEdmStreamEvent_t event;
 
     uShortRangePbufList_t *pBufList = pEvent->params.atEvent.pBufList;
-    gEdmStream.atResponseLength = (int32_t)pBufList->totalLen;
-    gEdmStream.atResponseRead = 0;
-    uShortRangePbufListConsumeData(pBufList, gEdmStream.pAtResponseBuffer,
-                                   gEdmStream.atResponseLength);
+    pEdmStream->atResponseLength = (int32_t)pBufList->totalLen;
+    pEdmStream->atResponseRead = 0;
+    uShortRangePbufListConsumeData(pBufList, pEdmStream->pAtResponseBuffer,
+                                   pEdmStream->atResponseLength);
     uShortRangePbufListFree(pBufList);
 
 #ifdef U_CFG_SHORT_RANGE_EDM_STREAM_DEBUG
     uEdmChLogStart(LOG_CH_AT_RX, "\"");
-    dumpAtData(gEdmStream.pAtResponseBuffer, gEdmStream.atResponseLength);
+    dumpAtData(pEdmStream->pAtResponseBuffer, pEdmStream->atResponseLength);
     uEdmChLogEnd("\"");
 #endif
 
+    event.pEdmStream = pEdmStream;
     event.type = U_SHORT_RANGE_EDM_STREAM_EVENT_AT;
-    if (uPortEventQueueSend(gEdmStream.eventQueueHandle,
+    if (uPortEventQueueSend(pEdmStream->eventQueueHandle,
                             &event, sizeof(uShortRangeEdmStreamEvent_t)) == 0) {
         success = true;
     } else {
@@ -472,18 +493,20 @@ static bool enqueueEdmAtEvent(uShortRangeEdmEvent_t *pEvent)
     return success;
 }
 
-static bool enqueueEdmConnectBtEvent(uShortRangeEdmEvent_t *pEvent)
+static bool enqueueEdmConnectBtEvent(uShortRangeEdmStreamInstance_t *pEdmStream,
+                                     uShortRangeEdmEvent_t *pEvent)
 {
     bool success = false;
 
     uShortRangeEdmStreamConnections_t *pConnection =
-        findConnection(pEvent->params.btConnectEvent.channel);
+        findConnection(pEdmStream, pEvent->params.btConnectEvent.channel);
 
     if (pConnection == NULL) {
-        pConnection = findConnection(-1);
+        pConnection = findConnection(pEdmStream, -1);
     }
     if (pConnection != NULL) {
         uShortRangeEdmStreamEvent_t event;
+        event.pEdmStream = pEdmStream;
         pConnection->channel = pEvent->params.btConnectEvent.channel;
         pConnection->type = U_SHORT_RANGE_CONNECTION_TYPE_BT;
         pConnection->bt.frameSize = pEvent->params.btConnectEvent.connection.framesize;
@@ -499,7 +522,7 @@ static bool enqueueEdmConnectBtEvent(uShortRangeEdmEvent_t *pEvent)
         uEdmChLogEnd("");
 #endif
 
-        if (uPortEventQueueSend(gEdmStream.eventQueueHandle,
+        if (uPortEventQueueSend(pEdmStream->eventQueueHandle,
                                 &event, sizeof(uShortRangeEdmStreamEvent_t)) == 0) {
             success = true;
         } else {
@@ -510,18 +533,20 @@ static bool enqueueEdmConnectBtEvent(uShortRangeEdmEvent_t *pEvent)
     return success;
 }
 
-static bool enqueueEdmConnectIpv4Event(uShortRangeEdmEvent_t *pEvent)
+static bool enqueueEdmConnectIpv4Event(uShortRangeEdmStreamInstance_t *pEdmStream,
+                                       uShortRangeEdmEvent_t *pEvent)
 {
     bool success = false;
 
     uShortRangeEdmStreamConnections_t *pConnection =
-        findConnection(pEvent->params.ipv4ConnectEvent.channel);
+        findConnection(pEdmStream, pEvent->params.ipv4ConnectEvent.channel);
 
     if (pConnection == NULL) {
-        pConnection = findConnection(-1);
+        pConnection = findConnection(pEdmStream, -1);
     }
     if (pConnection != NULL) {
         uShortRangeEdmStreamEvent_t event;
+        event.pEdmStream = pEdmStream;
         uShortRangeEdmConnectionEventIpv4_t *ipv4Evt = &pEvent->params.ipv4ConnectEvent;
         uShortRangeIpProtocol_t protocol = ipv4Evt->connection.protocol;
         // IPv4 events are generated by TCP, UDP and MQTT connections
@@ -559,7 +584,7 @@ static bool enqueueEdmConnectIpv4Event(uShortRangeEdmEvent_t *pEvent)
                           rIp[0], rIp[1], rIp[2], rIp[3], rPort);
 #endif
 
-            if (uPortEventQueueSend(gEdmStream.eventQueueHandle,
+            if (uPortEventQueueSend(pEdmStream->eventQueueHandle,
                                     &event, sizeof(uShortRangeEdmStreamEvent_t)) == 0) {
                 success = true;
             } else {
@@ -571,18 +596,20 @@ static bool enqueueEdmConnectIpv4Event(uShortRangeEdmEvent_t *pEvent)
     return success;
 }
 
-static bool enqueueEdmConnectIpv6Event(uShortRangeEdmEvent_t *pEvent)
+static bool enqueueEdmConnectIpv6Event(uShortRangeEdmStreamInstance_t *pEdmStream,
+                                       uShortRangeEdmEvent_t *pEvent)
 {
     bool success = false;
 
     uShortRangeEdmStreamConnections_t *pConnection =
-        findConnection(pEvent->params.ipv6ConnectEvent.channel);
+        findConnection(pEdmStream, pEvent->params.ipv6ConnectEvent.channel);
 
     if (pConnection == NULL) {
-        pConnection = findConnection(-1);
+        pConnection = findConnection(pEdmStream, -1);
     }
     if (pConnection != NULL) {
         uShortRangeEdmStreamEvent_t event;
+        event.pEdmStream = pEdmStream;
         uShortRangeEdmConnectionEventIpv6_t *ipv6Evt = &pEvent->params.ipv6ConnectEvent;
         uShortRangeIpProtocol_t protocol = ipv6Evt->connection.protocol;
         // IPv4 events are generated by TCP, UDP and MQTT connections
@@ -615,7 +642,7 @@ static bool enqueueEdmConnectIpv6Event(uShortRangeEdmEvent_t *pEvent)
                           event.ip.channel, protocolTxt, lPort, rPort);
 #endif
 
-            if (uPortEventQueueSend(gEdmStream.eventQueueHandle,
+            if (uPortEventQueueSend(pEdmStream->eventQueueHandle,
                                     &event, sizeof(uShortRangeEdmStreamEvent_t)) == 0) {
                 success = true;
             } else {
@@ -627,15 +654,17 @@ static bool enqueueEdmConnectIpv6Event(uShortRangeEdmEvent_t *pEvent)
     return success;
 }
 
-static bool enqueueEdmDisconnectEvent(uShortRangeEdmEvent_t *pEvent)
+static bool enqueueEdmDisconnectEvent(uShortRangeEdmStreamInstance_t *pEdmStream,
+                                      uShortRangeEdmEvent_t *pEvent)
 {
     bool success = false;
 
     uint8_t channel = pEvent->params.disconnectEvent.channel;
-    uShortRangeEdmStreamConnections_t *pConnection = findConnection(channel);
+    uShortRangeEdmStreamConnections_t *pConnection = findConnection(pEdmStream, channel);
 
     if (pConnection != NULL) {
         uShortRangeEdmStreamEvent_t event;
+        event.pEdmStream = pEdmStream;
         switch (pConnection->type) {
             case U_SHORT_RANGE_CONNECTION_TYPE_BT:
                 event.type = U_SHORT_RANGE_EDM_STREAM_EVENT_BT;
@@ -644,7 +673,7 @@ static bool enqueueEdmDisconnectEvent(uShortRangeEdmEvent_t *pEvent)
 #ifdef U_CFG_SHORT_RANGE_EDM_STREAM_DEBUG
                 uEdmChLogLine(LOG_CH_BT, "ch: %d, disconnect", channel);
 #endif
-                if (uPortEventQueueSend(gEdmStream.eventQueueHandle,
+                if (uPortEventQueueSend(pEdmStream->eventQueueHandle,
                                         &event, sizeof(uShortRangeEdmStreamEvent_t)) == 0) {
                     success = true;
                 } else {
@@ -659,7 +688,7 @@ static bool enqueueEdmDisconnectEvent(uShortRangeEdmEvent_t *pEvent)
 #ifdef U_CFG_SHORT_RANGE_EDM_STREAM_DEBUG
                 uEdmChLogLine(LOG_CH_IP, "ch: %d, disconnect", channel);
 #endif
-                if (uPortEventQueueSend(gEdmStream.eventQueueHandle,
+                if (uPortEventQueueSend(pEdmStream->eventQueueHandle,
                                         &event, sizeof(uShortRangeEdmStreamEvent_t)) == 0) {
                     success = true;
                 } else {
@@ -674,7 +703,7 @@ static bool enqueueEdmDisconnectEvent(uShortRangeEdmEvent_t *pEvent)
 #ifdef U_CFG_SHORT_RANGE_EDM_STREAM_DEBUG
                 uEdmChLogLine(LOG_CH_IP, "ch: %d, disconnect", channel);
 #endif
-                if (uPortEventQueueSend(gEdmStream.eventQueueHandle,
+                if (uPortEventQueueSend(pEdmStream->eventQueueHandle,
                                         &event, sizeof(uShortRangeEdmStreamEvent_t)) == 0) {
                     success = true;
                 } else {
@@ -692,11 +721,13 @@ static bool enqueueEdmDisconnectEvent(uShortRangeEdmEvent_t *pEvent)
     return success;
 }
 
-static bool enqueueEdmDataEvent(uShortRangeEdmEvent_t *pEvent)
+static bool enqueueEdmDataEvent(uShortRangeEdmStreamInstance_t *pEdmStream,
+                                uShortRangeEdmEvent_t *pEvent)
 {
     bool success = false;
 
     uShortRangeEdmStreamEvent_t event;
+    event.pEdmStream = pEdmStream;
     event.type = U_SHORT_RANGE_EDM_STREAM_EVENT_DATA;
     event.data.channel = pEvent->params.dataEvent.channel;
     event.data.pBufList = pEvent->params.dataEvent.pBufList;
@@ -713,7 +744,7 @@ static bool enqueueEdmDataEvent(uShortRangeEdmEvent_t *pEvent)
 # endif
 #endif
     }
-    if (uPortEventQueueSend(gEdmStream.eventQueueHandle,
+    if (uPortEventQueueSend(pEdmStream->eventQueueHandle,
                             &event, sizeof(uShortRangeEdmStreamEvent_t)) == 0) {
         success = true;
     } else {
@@ -723,34 +754,35 @@ static bool enqueueEdmDataEvent(uShortRangeEdmEvent_t *pEvent)
     return success;
 }
 
-static void processEdmEvent(uShortRangeEdmEvent_t *pEvent)
+static void processEdmEvent(uShortRangeEdmStreamInstance_t *pEdmStream,
+                            uShortRangeEdmEvent_t *pEvent)
 {
     bool enqueued = false;
 
     switch (pEvent->type) {
 
         case U_SHORT_RANGE_EDM_EVENT_AT:
-            enqueued = enqueueEdmAtEvent(pEvent);
+            enqueued = enqueueEdmAtEvent(pEdmStream, pEvent);
             break;
 
         case U_SHORT_RANGE_EDM_EVENT_CONNECT_BT:
-            enqueued = enqueueEdmConnectBtEvent(pEvent);
+            enqueued = enqueueEdmConnectBtEvent(pEdmStream, pEvent);
             break;
 
         case U_SHORT_RANGE_EDM_EVENT_DISCONNECT:
-            enqueued = enqueueEdmDisconnectEvent(pEvent);
+            enqueued = enqueueEdmDisconnectEvent(pEdmStream, pEvent);
             break;
 
         case U_SHORT_RANGE_EDM_EVENT_DATA:
-            enqueued = enqueueEdmDataEvent(pEvent);
+            enqueued = enqueueEdmDataEvent(pEdmStream, pEvent);
             break;
 
         case U_SHORT_RANGE_EDM_EVENT_CONNECT_IPv4:
-            enqueued = enqueueEdmConnectIpv4Event(pEvent);
+            enqueued = enqueueEdmConnectIpv4Event(pEdmStream, pEvent);
             break;
 
         case U_SHORT_RANGE_EDM_EVENT_CONNECT_IPv6:
-            enqueued = enqueueEdmConnectIpv6Event(pEvent);
+            enqueued = enqueueEdmConnectIpv6Event(pEdmStream, pEvent);
             break;
 
         case U_SHORT_RANGE_EDM_EVENT_INVALID: /* Intentional fallthrough */
@@ -762,70 +794,75 @@ static void processEdmEvent(uShortRangeEdmEvent_t *pEvent)
 
     if (!enqueued) {
         /* No event was enqueued to the event queue so we simply consume the event */
-        processedEvent();
+        processedEvent(pEdmStream);
     }
 }
 
 static void uartCallback(int32_t uartHandle, uint32_t eventBitmask,
                          void *pParameters)
 {
-    (void)pParameters;
     bool memAvailable = true;
-
-    if ((gEdmStream.uartHandle == uartHandle) &&
-        !gEdmStream.ignoreUartCallback &&
+    uShortRangeEdmStreamInstance_t *pEdmStream = (uShortRangeEdmStreamInstance_t *) pParameters;
+    uShortRangeEdmParser_t *pParser = &(pEdmStream->parser);
+    uShortRangeEdmEvent_t *pEvent;
+    char *pSpace;
+    size_t size = 0;
+    int32_t sizeOrError;
+
+    if ((pEdmStream->uartHandle == uartHandle) &&
+        !pEdmStream->ignoreUartCallback &&
         (eventBitmask == U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED)) {
         bool uartEmpty = false;
-        // We don't want to read one character at the time from the uart driver since that will be
-        // quite an overhead when pumping a lot of data. Instead we read into a buffer
-        // and then comsume characters from that. But we might not consume all read characters
-        // before an EDM-event is generated by the parser which makes the parser unavailable
-        // and we have to leave this callback. When the parser later is available this
-        // uart-event will be placed on the queue again so that we come back here.
-        // We thus need a static buffer, and if there are unparsed characters left in it we move
-        // them to the beginning of the buffer befor leaving (instead of using a ring buffer).
-        U_PORT_MUTEX_LOCK(gMutex);
-        while (!uartEmpty && uShortRangeEdmParserReady() && memAvailable) {
+        // Payload, which is the bulk of the data, is read from the
+        // UART driver straight into the pbufs of the parser; the
+        // framing around it is read into rxBuffer and parsed from
+        // there, which also copies any payload that came with it
+        // into the pbufs in runs.  An EDM-event generated by the
+        // parser makes the parser unavailable and we have to leave
+        // this callback: when the parser later is available this
+        // uart-event will be placed on the queue again so that we
+        // come back here and carry on with whatever is left in rxBuffer.
+        U_PORT_MUTEX_LOCK(pEdmStream->mutex);
+        while (!uartEmpty && uShortRangeEdmParserReady(pParser) && memAvailable) {
             // Loop until we couldn't read any more characters from uart
             // or EDM parser is unavailable
-            // or no pbuf memory is available
-            static char buffer[128];
-            static size_t charsInBuffer = 0;
-            size_t consumed = 0;
-
-            // Check if there are any existing characters in the buffer and parse them
-            while (uShortRangeEdmParserReady() && (consumed < charsInBuffer) && memAvailable) {
-                //lint -esym(727, buffer)
-                uShortRangeEdmEvent_t *pEvent = NULL;
-                // when there is no memory available in the pool to intake
-                // the data, this call would return false.In such
-                // cases hardware flow control will be triggered if
-                // UART H/W Rx FIFO is full.
-                if (uShortRangeEdmParse(buffer[consumed], &pEvent, &memAvailable)) {
-                    consumed++;
-                }
+            // or no pbuf memory is available, in which case
+            // hardware flow control will be triggered if the
+            // UART H/W Rx FIFO fills up
+            if (pEdmStream->rxBufferStart < pEdmStream->rxBufferEnd) {
+                pEvent = NULL;
+                pEdmStream->rxBufferStart += uShortRangeEdmParse(pParser,
+                                                                 pEdmStream->rxBuffer +
+                                                                 pEdmStream->rxBufferStart,
+                                                                 pEdmStream->rxBufferEnd -
+                                                                 pEdmStream->rxBufferStart,
+                                                                 &pEvent, &memAvailable);
                 if (pEvent != NULL) {
-                    processEdmEvent(pEvent);
+                    processEdmEvent(pEdmStream, pEvent);
                 }
-            }
-            // Move unparsed data to beginning of buffer
-            if ((consumed > 0) && (charsInBuffer - consumed) > 0) {
-                memmove(buffer, buffer + consumed, charsInBuffer - consumed);
-            }
-            charsInBuffer -= consumed;
-
-            // Read as much as possible from uart into rest of buffer
-            if (charsInBuffer < sizeof buffer) {
-                int32_t sizeOrError = uPortUartRead(gEdmStream.uartHandle, buffer + charsInBuffer,
-                                                    sizeof buffer - charsInBuffer);
-                if (sizeOrError > 0) {
-                    charsInBuffer += sizeOrError;
-                } else {
-                    uartEmpty = true;
+            } else {
+                pEdmStream->rxBufferStart = 0;
+                pEdmStream->rxBufferEnd = 0;
+                pSpace = pUShortRangeEdmParserPayloadSpace(pParser, &size, &memAvailable);
+                if (pSpace != NULL) {
+                    sizeOrError = uPortUartRead(pEdmStream->uartHandle, pSpace, size);
+                    if (sizeOrError > 0) {
+                        uShortRangeEdmParserPayloadCommit(pParser, (size_t) sizeOrError);
+                    } else {
+                        uartEmpty = true;
+                    }
+                } else if (memAvailable) {
+                    sizeOrError = uPortUartRead(pEdmStream->uartHandle, pEdmStream->rxBuffer,
+                                                sizeof(pEdmStream->rxBuffer));
+                    if (sizeOrError > 0) {
+                        pEdmStream->rxBufferEnd = (size_t) sizeOrError;
+                    } else {
+                        uartEmpty = true;
+                    }
                 }
             }
         }
-        U_PORT_MUTEX_UNLOCK(gMutex);
+        U_PORT_MUTEX_UNLOCK(pEdmStream->mutex);
     }
 }
 
@@ -840,9 +877,10 @@ static void flushUart(int32_t uartHandle)
     }
 }
 
-static int32_t uartWrite(const void *pData, size_t length)
+static int32_t uartWrite(const uShortRangeEdmStreamInstance_t *pEdmStream,
+                         const void *pData, size_t length)
 {
-    return uPortUartWrite(gEdmStream.uartHandle,
+    return uPortUartWrite(pEdmStream->uartHandle,
                           pData, length);
 }
 
@@ -867,7 +905,7 @@ static int32_t edmSend(const uShortRangeEdmStreamInstance_t *pEdmStream)
             uEdmChLogEnd("\"");
 #endif
             while (written < (uint32_t) sizeOrError) {
-                written += uartWrite((void *) (pPacket + written),
+                written += uartWrite(pEdmStream, (void *) (pPacket + written),
                                      (uint32_t) sizeOrError - written);
             }
         }
@@ -886,37 +924,37 @@ static const char *pInterceptTx(uAtClientHandle_t atHandle,
                                 void *pContext)
 {
     int32_t x = 0;
+    uShortRangeEdmStreamInstance_t *pEdmStream = (uShortRangeEdmStreamInstance_t *) pContext;
 
-    (void) pContext;
     (void) atHandle;
 
     if ((*pLength != 0) || (ppData == NULL)) {
         if (ppData == NULL) {
             // We're being flushed, create and send EDM packet
-            edmSend(&gEdmStream);
+            edmSend(pEdmStream);
             // Reset buffer
-            gEdmStream.atCommandCurrent = 0;
+            pEdmStream->atCommandCurrent = 0;
         } else {
             // Send any whole buffer's worths we have
-            while ((*pLength + gEdmStream.atCommandCurrent > U_SHORT_RANGE_EDM_STREAM_AT_COMMAND_LENGTH) &&
+            while ((*pLength + pEdmStream->atCommandCurrent > U_SHORT_RANGE_EDM_STREAM_AT_COMMAND_LENGTH) &&
                    (x >= 0)) {
-                x = U_SHORT_RANGE_EDM_STREAM_AT_COMMAND_LENGTH - gEdmStream.atCommandCurrent;
-                memcpy(gEdmStream.pAtCommandBuffer + gEdmStream.atCommandCurrent, *ppData, x);
+                x = U_SHORT_RANGE_EDM_STREAM_AT_COMMAND_LENGTH - pEdmStream->atCommandCurrent;
+                memcpy(pEdmStream->pAtCommandBuffer + pEdmStream->atCommandCurrent, *ppData, x);
                 *pLength -= x;
                 *ppData += x;
-                gEdmStream.atCommandCurrent = U_SHORT_RANGE_EDM_STREAM_AT_COMMAND_LENGTH;
+                pEdmStream->atCommandCurrent = U_SHORT_RANGE_EDM_STREAM_AT_COMMAND_LENGTH;
                 // Send a chunk
-                x = edmSend(&gEdmStream);
+                x = edmSend(pEdmStream);
                 if (x < 0) {
                     // Error recovery: tell the caller we've consumed the lot
                     *ppData += *pLength;
                     *pLength = 0;
                 }
-                gEdmStream.atCommandCurrent = 0;
+                pEdmStream->atCommandCurrent = 0;
             }
             // Copy in any partial buffer, will be sent when we are flushed
-            memcpy(gEdmStream.pAtCommandBuffer + gEdmStream.atCommandCurrent, *ppData, *pLength);
-            gEdmStream.atCommandCurrent += (int32_t) * pLength;
+            memcpy(pEdmStream->pAtCommandBuffer + pEdmStream->atCommandCurrent, *ppData, *pLength);
+            pEdmStream->atCommandCurrent += (int32_t) * pLength;
             // Tell the caller what we've consumed.
             *ppData += *pLength;
         }
@@ -929,6 +967,73 @@ static const char *pInterceptTx(uAtClientHandle_t atHandle,
     return 0;
 }
 
+// Find the open instance with the given handle and lock it; if
+// an instance is returned it must be unlocked with instanceUnlock().
+static uShortRangeEdmStreamInstance_t *pInstanceLock(int32_t handle)
+{
+    uShortRangeEdmStreamInstance_t *pEdmStream = NULL;
+
+    if ((gMutex != NULL) && (handle >= 0) &&
+        (handle < (int32_t) (sizeof(gEdmStream) / sizeof(gEdmStream[0])))) {
+        pEdmStream = &(gEdmStream[handle]);
+        uPortMutexLock(pEdmStream->mutex);
+        if (pEdmStream->handle != handle) {
+            // Not open
+            uPortMutexUnlock(pEdmStream->mutex);
+            pEdmStream = NULL;
+        }
+    }
+
+    return pEdmStream;
+}
+
+// Unlock an instance returned by pInstanceLock(), which may be NULL.
+static void instanceUnlock(const uShortRangeEdmStreamInstance_t *pEdmStream)
+{
+    if (pEdmStream != NULL) {
+        uPortMutexUnlock(pEdmStream->mutex);
+    }
+}
+
+// Reset the callbacks of an instance.
+static void clearCallbacks(uShortRangeEdmStreamInstance_t *pEdmStream)
+{
+    pEdmStream->pAtCallback = NULL;
+    pEdmStream->pAtCallbackParam = NULL;
+    pEdmStream->pBtEventCallback = NULL;
+    pEdmStream->pBtEventCallbackParam = NULL;
+    pEdmStream->pBtDataCallback = NULL;
+    pEdmStream->pBtDataCallbackParam = NULL;
+    pEdmStream->pIpEventCallback = NULL;
+    pEdmStream->pIpEventCallbackParam = NULL;
+    pEdmStream->pIpDataCallback = NULL;
+    pEdmStream->pIpDataCallbackParam = NULL;
+    pEdmStream->pMqttEventCallback = NULL;
+    pEdmStream->pMqttEventCallbackParam = NULL;
+    pEdmStream->pMqttDataCallback = NULL;
+    pEdmStream->pMqttDataCallbackParam = NULL;
+}
+
+// Reset the connection table of an instance.
+static void clearConnections(uShortRangeEdmStreamInstance_t *pEdmStream)
+{
+    for (uint32_t i = 0; i < U_SHORT_RANGE_EDM_STREAM_MAX_CONNECTIONS; i++) {
+        pEdmStream->connections[i].channel = -1;
+        pEdmStream->connections[i].type = U_SHORT_RANGE_CONNECTION_TYPE_INVALID;
+    }
+}
+
+// Delete the mutexes of all of the instances.
+static void deleteInstanceMutexes()
+{
+    for (size_t x = 0; x < sizeof(gEdmStream) / sizeof(gEdmStream[0]); x++) {
+        if (gEdmStream[x].mutex != NULL) {
+            uPortMutexDelete(gEdmStream[x].mutex);
+            gEdmStream[x].mutex = NULL;
+        }
+    }
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -936,109 +1041,158 @@ static const char *pInterceptTx(uAtClientHandle_t atHandle,
 int32_t uShortRangeEdmStreamInit()
 {
     uErrorCode_t errorCodeOrHandle = U_ERROR_COMMON_SUCCESS;
+    uShortRangeEdmStreamInstance_t *pEdmStream;
 
     if (gMutex == NULL) {
         errorCodeOrHandle = (uErrorCode_t)uPortMutexCreate(&gMutex);
 
+        for (size_t x = 0; (x < sizeof(gEdmStream) / sizeof(gEdmStream[0])) &&
+             (errorCodeOrHandle == U_ERROR_COMMON_SUCCESS); x++) {
+            pEdmStream = &(gEdmStream[x]);
+            memset(pEdmStream, 0, sizeof(*pEdmStream));
+            pEdmStream->handle = -1;
+            pEdmStream->uartHandle = -1;
+            pEdmStream->eventQueueHandle = -1;
+            // Each stream parses into its own set of pbuf pools,
+            // if there are enough to go around
+            pEdmStream->parser.poolIndex = (int32_t) (x % U_SHORT_RANGE_PBUF_POOL_COUNT);
+            errorCodeOrHandle = (uErrorCode_t)uPortMutexCreate(&(pEdmStream->mutex));
+        }
+
         if (errorCodeOrHandle == U_ERROR_COMMON_SUCCESS) {
             errorCodeOrHandle = (uErrorCode_t)uShortRangeMemPoolInit();
         }
-        gEdmStream.handle = -1;
-        gEdmStream.ignoreUartCallback = false;
-    }
 
-    uShortRangeEdmResetParser();
+        if ((errorCodeOrHandle != U_ERROR_COMMON_SUCCESS) && (gMutex != NULL)) {
+            deleteInstanceMutexes();
+            uPortMutexDelete(gMutex);
+            gMutex = NULL;
+        }
+    }
 
     return (int32_t) errorCodeOrHandle;
 }
 
 void uShortRangeEdmStreamDeinit()
 {
-    uShortRangeEdmResetParser();
+    bool anyOpen = false;
 
     if (gMutex != NULL) {
 
         U_PORT_MUTEX_LOCK(gMutex);
-        uShortRangeMemPoolDeInit();
 
-        if (gEdmStream.eventQueueHandle >= 0) {
-            uPortEventQueueClose(gEdmStream.eventQueueHandle);
+        // Streams may be in use by more than one short-range
+        // module: only tidy up once the last one has been closed
+        for (size_t x = 0; x < sizeof(gEdmStream) / sizeof(gEdmStream[0]); x++) {
+            if (gEdmStream[x].handle >= 0) {
+                anyOpen = true;
+            }
+        }
+
+        if (!anyOpen) {
+            for (size_t x = 0; x < sizeof(gEdmStream) / sizeof(gEdmStream[0]); x++) {
+                uShortRangeEdmResetParser(&(gEdmStream[x].parser));
+            }
+            uShortRangeMemPoolDeInit();
+            deleteInstanceMutexes();
         }
-        gEdmStream.eventQueueHandle = -1;
 
         U_PORT_MUTEX_UNLOCK(gMutex);
-        uPortMutexDelete(gMutex);
-        gMutex = NULL;
+
+        if (!anyOpen) {
+            uPortMutexDelete(gMutex);
+            gMutex = NULL;
+        }
     }
 }
 
 int32_t uShortRangeEdmStreamOpen(int32_t uartHandle)
 {
     uErrorCode_t handleOrErrorCode = U_ERROR_COMMON_NOT_INITIALISED;
+    uShortRangeEdmStreamInstance_t *pEdmStream = NULL;
+    int32_t handle = -1;
 
     if (gMutex != NULL) {
 
         U_PORT_MUTEX_LOCK(gMutex);
         handleOrErrorCode = U_ERROR_COMMON_INVALID_PARAMETER;
 
-        if (uartHandle >= 0 && gEdmStream.handle == -1) {
+        if (uartHandle >= 0) {
+            // Find a free instance, checking that there isn't
+            // already a stream on this UART
+            for (size_t x = 0; (x < sizeof(gEdmStream) / sizeof(gEdmStream[0])) &&
+                 (handleOrErrorCode == U_ERROR_COMMON_INVALID_PARAMETER); x++) {
+                if (gEdmStream[x].handle < 0) {
+                    if (handle < 0) {
+                        handle = (int32_t) x;
+                    }
+                } else if (gEdmStream[x].uartHandle == uartHandle) {
+                    handleOrErrorCode = U_ERROR_COMMON_BUSY;
+                }
+            }
+            if ((handle < 0) && (handleOrErrorCode == U_ERROR_COMMON_INVALID_PARAMETER)) {
+                handleOrErrorCode = U_ERROR_COMMON_NO_MEMORY;
+            }
+        }
+
+        if ((handle >= 0) && (handleOrErrorCode == U_ERROR_COMMON_INVALID_PARAMETER)) {
+            pEdmStream = &(gEdmStream[handle]);
+
+            U_PORT_MUTEX_LOCK(pEdmStream->mutex);
 
             int32_t errorCode = uPortUartEventCallbackSet(uartHandle,
                                                           U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED,
-                                                          uartCallback, NULL,
+                                                          uartCallback, pEdmStream,
                                                           U_EDM_STREAM_TASK_STACK_SIZE_BYTES,
                                                           U_EDM_STREAM_TASK_PRIORITY);
 
             if (errorCode == 0) {
-                gEdmStream.pAtCommandBuffer = (char *)pUPortMalloc(U_SHORT_RANGE_EDM_STREAM_AT_COMMAND_LENGTH);
-                memset(gEdmStream.pAtCommandBuffer, 0, U_SHORT_RANGE_EDM_STREAM_AT_COMMAND_LENGTH);
-                gEdmStream.pAtResponseBuffer = (char *)pUPortMalloc(U_SHORT_RANGE_EDM_STREAM_AT_RESPONSE_LENGTH);
-                memset(gEdmStream.pAtResponseBuffer, 0, U_SHORT_RANGE_EDM_STREAM_AT_RESPONSE_LENGTH);
-                if (gEdmStream.pAtCommandBuffer == NULL ||
-                    gEdmStream.pAtResponseBuffer == NULL) {
+                pEdmStream->pAtCommandBuffer = (char *)pUPortMalloc(U_SHORT_RANGE_EDM_STREAM_AT_COMMAND_LENGTH);
+                pEdmStream->pAtResponseBuffer = (char *)pUPortMalloc(U_SHORT_RANGE_EDM_STREAM_AT_RESPONSE_LENGTH);
+                if (pEdmStream->pAtCommandBuffer == NULL ||
+                    pEdmStream->pAtResponseBuffer == NULL) {
                     handleOrErrorCode = U_ERROR_COMMON_NO_MEMORY;
+                    uPortFree(pEdmStream->pAtCommandBuffer);
+                    pEdmStream->pAtCommandBuffer = NULL;
+                    uPortFree(pEdmStream->pAtResponseBuffer);
+                    pEdmStream->pAtResponseBuffer = NULL;
                     uPortUartEventCallbackRemove(uartHandle);
                 } else {
-                    gEdmStream.eventQueueHandle
+                    memset(pEdmStream->pAtCommandBuffer, 0, U_SHORT_RANGE_EDM_STREAM_AT_COMMAND_LENGTH);
+                    memset(pEdmStream->pAtResponseBuffer, 0, U_SHORT_RANGE_EDM_STREAM_AT_RESPONSE_LENGTH);
+                    // Each stream has its own event queue, and hence task,
+                    // so that a stream that is busy with data doesn't hold
+                    // up the events of another
+                    pEdmStream->eventQueueHandle
                         = uPortEventQueueOpen(eventHandler, "eventEdmStream",
                                               sizeof(uShortRangeEdmStreamEvent_t),
                                               U_EDM_STREAM_TASK_STACK_SIZE_BYTES,
                                               U_EDM_STREAM_TASK_PRIORITY,
                                               U_EDM_STREAM_EVENT_QUEUE_SIZE);
-                    if (gEdmStream.eventQueueHandle < 0) {
-                        gEdmStream.eventQueueHandle = -1;
+                    if (pEdmStream->eventQueueHandle < 0) {
+                        pEdmStream->eventQueueHandle = -1;
                     }
 
-                    gEdmStream.handle = 0;
-                    gEdmStream.uartHandle = uartHandle;
-                    gEdmStream.atHandle = NULL;
-                    gEdmStream.pAtCallback = NULL;
-                    gEdmStream.pAtCallbackParam = NULL;
-                    gEdmStream.pBtEventCallback = NULL;
-                    gEdmStream.pBtEventCallbackParam = NULL;
-                    gEdmStream.pBtDataCallback = NULL;
-                    gEdmStream.pBtDataCallbackParam = NULL;
-                    gEdmStream.pIpEventCallback = NULL;
-                    gEdmStream.pIpEventCallbackParam = NULL;
-                    gEdmStream.pIpDataCallback = NULL;
-                    gEdmStream.pIpDataCallbackParam = NULL;
-                    gEdmStream.pMqttEventCallback = NULL;
-                    gEdmStream.pMqttEventCallbackParam = NULL;
-                    gEdmStream.pMqttDataCallback = NULL;
-                    gEdmStream.pMqttDataCallbackParam = NULL;
-                    gEdmStream.atCommandCurrent = 0;
-
-                    for (uint32_t i = 0; i < U_SHORT_RANGE_EDM_STREAM_MAX_CONNECTIONS; i++) {
-                        gEdmStream.connections[i].channel = -1;
-                        gEdmStream.connections[i].type = U_SHORT_RANGE_CONNECTION_TYPE_INVALID;
-                    }
+                    pEdmStream->handle = handle;
+                    pEdmStream->uartHandle = uartHandle;
+                    pEdmStream->atHandle = NULL;
+                    clearCallbacks(pEdmStream);
+                    pEdmStream->atCommandCurrent = 0;
+                    pEdmStream->atResponseLength = 0;
+                    pEdmStream->atResponseRead = 0;
+                    clearConnections(pEdmStream);
 
-                    handleOrErrorCode = (uErrorCode_t)gEdmStream.handle;
+                    handleOrErrorCode = (uErrorCode_t)pEdmStream->handle;
                     flushUart(uartHandle);
                 }
             }
+            uShortRangeEdmResetParser(&(pEdmStream->parser));
+            pEdmStream->rxBufferStart = 0;
+            pEdmStream->rxBufferEnd = 0;
+
+            U_PORT_MUTEX_UNLOCK(pEdmStream->mutex);
         }
-        uShortRangeEdmResetParser();
+
         U_PORT_MUTEX_UNLOCK(gMutex);
     }
 
@@ -1047,51 +1201,43 @@ int32_t uShortRangeEdmStreamOpen(int32_t uartHandle)
 
 void uShortRangeEdmStreamClose(int32_t handle)
 {
-    if (gMutex != NULL) {
-        gEdmStream.ignoreUartCallback = true;
+    uShortRangeEdmStreamInstance_t *pEdmStream;
+
+    if ((gMutex != NULL) && (handle >= 0) &&
+        (handle < (int32_t) (sizeof(gEdmStream) / sizeof(gEdmStream[0])))) {
+        pEdmStream = &(gEdmStream[handle]);
+        pEdmStream->ignoreUartCallback = true;
         uPortMutexLock(gMutex);
+        uPortMutexLock(pEdmStream->mutex);
 
-        if ((handle != -1) && (handle == gEdmStream.handle)) {
-            gEdmStream.handle = -1;
-            if (gEdmStream.uartHandle >= 0) {
-                uPortUartEventCallbackRemove(gEdmStream.uartHandle);
-            }
-            gEdmStream.uartHandle = -1;
-            if (gEdmStream.eventQueueHandle >= 0) {
-                uPortEventQueueClose(gEdmStream.eventQueueHandle);
+        if (handle == pEdmStream->handle) {
+            pEdmStream->handle = -1;
+            if (pEdmStream->uartHandle >= 0) {
+                uPortUartEventCallbackRemove(pEdmStream->uartHandle);
             }
-            gEdmStream.eventQueueHandle = -1;
-            if (gEdmStream.atHandle != NULL) {
-                uAtClientStreamInterceptTx(gEdmStream.atHandle, NULL, NULL);
+            pEdmStream->uartHandle = -1;
+            if (pEdmStream->eventQueueHandle >= 0) {
+                uPortEventQueueClose(pEdmStream->eventQueueHandle);
             }
-            gEdmStream.atHandle = NULL;
-            gEdmStream.pAtCallback = NULL;
-            gEdmStream.pAtCallbackParam = NULL;
-            gEdmStream.pBtEventCallback = NULL;
-            gEdmStream.pBtEventCallbackParam = NULL;
-            gEdmStream.pBtDataCallback = NULL;
-            gEdmStream.pBtDataCallbackParam = NULL;
-            gEdmStream.pIpEventCallback = NULL;
-            gEdmStream.pIpEventCallbackParam = NULL;
-            gEdmStream.pIpDataCallback = NULL;
-            gEdmStream.pIpDataCallbackParam = NULL;
-            gEdmStream.pMqttEventCallback = NULL;
-            gEdmStream.pMqttEventCallbackParam = NULL;
-            gEdmStream.pMqttDataCallback = NULL;
-            gEdmStream.pMqttDataCallbackParam = NULL;
-            uPortFree(gEdmStream.pAtCommandBuffer);
-            gEdmStream.pAtCommandBuffer = NULL;
-            uPortFree(gEdmStream.pAtResponseBuffer);
-            gEdmStream.pAtResponseBuffer = NULL;
-            for (uint32_t i = 0; i < U_SHORT_RANGE_EDM_STREAM_MAX_CONNECTIONS; i++) {
-                gEdmStream.connections[i].channel = -1;
-                gEdmStream.connections[i].type = U_SHORT_RANGE_CONNECTION_TYPE_INVALID;
+            pEdmStream->eventQueueHandle = -1;
+            if (pEdmStream->atHandle != NULL) {
+                uAtClientStreamInterceptTx((uAtClientHandle_t) pEdmStream->atHandle, NULL, NULL);
             }
+            pEdmStream->atHandle = NULL;
+            clearCallbacks(pEdmStream);
+            uPortFree(pEdmStream->pAtCommandBuffer);
+            pEdmStream->pAtCommandBuffer = NULL;
+            uPortFree(pEdmStream->pAtResponseBuffer);
+            pEdmStream->pAtResponseBuffer = NULL;
+            clearConnections(pEdmStream);
+            uShortRangeEdmResetParser(&(pEdmStream->parser));
+            pEdmStream->rxBufferStart = 0;
+            pEdmStream->rxBufferEnd = 0;
         }
 
-        uShortRangeEdmResetParser();
+        uPortMutexUnlock(pEdmStream->mutex);
         uPortMutexUnlock(gMutex);
-        gEdmStream.ignoreUartCallback = false;
+        pEdmStream->ignoreUartCallback = false;
     }
 }
 
@@ -1101,19 +1247,18 @@ int32_t uShortRangeEdmStreamAtCallbackSet(int32_t handle,
                                           void *pParam)
 {
     uErrorCode_t errorCode = U_ERROR_COMMON_NOT_INITIALISED;
+    uShortRangeEdmStreamInstance_t *pEdmStream;
 
     if (gMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gMutex);
-
         errorCode = U_ERROR_COMMON_INVALID_PARAMETER;
-        if ((handle == gEdmStream.handle) && (pFunction != NULL)) {
-            gEdmStream.pAtCallback = pFunction;
-            gEdmStream.pAtCallbackParam = pParam;
+        pEdmStream = pInstanceLock(handle);
+        if ((pEdmStream != NULL) && (pFunction != NULL)) {
+            pEdmStream->pAtCallback = pFunction;
+            pEdmStream->pAtCallbackParam = pParam;
             errorCode = U_ERROR_COMMON_SUCCESS;
         }
-
-        U_PORT_MUTEX_UNLOCK(gMutex);
+        instanceUnlock(pEdmStream);
     }
 
     return (int32_t)errorCode;
@@ -1124,25 +1269,24 @@ int32_t uShortRangeEdmStreamIpEventCallbackSet(int32_t handle,
                                                void *pParam)
 {
     uErrorCode_t errorCode = U_ERROR_COMMON_NOT_INITIALISED;
+    uShortRangeEdmStreamInstance_t *pEdmStream;
 
     if (gMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gMutex);
-
         errorCode = U_ERROR_COMMON_INVALID_PARAMETER;
-        if (handle == gEdmStream.handle) {
-            if (pFunction != NULL && gEdmStream.pIpEventCallback == NULL) {
-                gEdmStream.pIpEventCallback = pFunction;
-                gEdmStream.pIpEventCallbackParam = pParam;
+        pEdmStream = pInstanceLock(handle);
+        if (pEdmStream != NULL) {
+            if (pFunction != NULL && pEdmStream->pIpEventCallback == NULL) {
+                pEdmStream->pIpEventCallback = pFunction;
+                pEdmStream->pIpEventCallbackParam = pParam;
                 errorCode = U_ERROR_COMMON_SUCCESS;
             } else if (pFunction == NULL) {
-                gEdmStream.pIpEventCallback = NULL;
-                gEdmStream.pIpEventCallbackParam = NULL;
+                pEdmStream->pIpEventCallback = NULL;
+                pEdmStream->pIpEventCallbackParam = NULL;
                 errorCode = U_ERROR_COMMON_SUCCESS;
             }
         }
-
-        U_PORT_MUTEX_UNLOCK(gMutex);
+        instanceUnlock(pEdmStream);
     }
 
     return (int32_t)errorCode;
@@ -1160,25 +1304,24 @@ int32_t uShortRangeEdmStreamMqttEventCallbackSet(int32_t handle,
                                                  void *pParam)
 {
     uErrorCode_t errorCode = U_ERROR_COMMON_NOT_INITIALISED;
+    uShortRangeEdmStreamInstance_t *pEdmStream;
 
     if (gMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gMutex);
-
         errorCode = U_ERROR_COMMON_INVALID_PARAMETER;
-        if (handle == gEdmStream.handle) {
-            if (pFunction != NULL && gEdmStream.pMqttEventCallback == NULL) {
-                gEdmStream.pMqttEventCallback = pFunction;
-                gEdmStream.pMqttEventCallbackParam = pParam;
+        pEdmStream = pInstanceLock(handle);
+        if (pEdmStream != NULL) {
+            if (pFunction != NULL && pEdmStream->pMqttEventCallback == NULL) {
+                pEdmStream->pMqttEventCallback = pFunction;
+                pEdmStream->pMqttEventCallbackParam = pParam;
                 errorCode = U_ERROR_COMMON_SUCCESS;
             } else if (pFunction == NULL) {
-                gEdmStream.pMqttEventCallback = NULL;
-                gEdmStream.pMqttEventCallbackParam = NULL;
+                pEdmStream->pMqttEventCallback = NULL;
+                pEdmStream->pMqttEventCallbackParam = NULL;
                 errorCode = U_ERROR_COMMON_SUCCESS;
             }
         }
-
-        U_PORT_MUTEX_UNLOCK(gMutex);
+        instanceUnlock(pEdmStream);
     }
 
     return (int32_t)errorCode;
@@ -1197,26 +1340,25 @@ int32_t uShortRangeEdmStreamBtEventCallbackSet(int32_t handle,
                                                void *pParam)
 {
     uErrorCode_t errorCode = U_ERROR_COMMON_NOT_INITIALISED;
+    uShortRangeEdmStreamInstance_t *pEdmStream;
 
     if (gMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gMutex);
-
         errorCode = U_ERROR_COMMON_INVALID_PARAMETER;
-        if (handle == gEdmStream.handle) {
-            if (pFunction != NULL && gEdmStream.pBtEventCallback == NULL) {
-                gEdmStream.pBtEventCallback = pFunction;
-                gEdmStream.pBtEventCallbackParam = pParam;
+        pEdmStream = pInstanceLock(handle);
+        if (pEdmStream != NULL) {
+            if (pFunction != NULL && pEdmStream->pBtEventCallback == NULL) {
+                pEdmStream->pBtEventCallback = pFunction;
+                pEdmStream->pBtEventCallbackParam = pParam;
                 errorCode = U_ERROR_COMMON_SUCCESS;
             } else if (pFunction == NULL) {
-                gEdmStream.pBtEventCallback = NULL;
-                gEdmStream.pBtEventCallbackParam = NULL;
+                pEdmStream->pBtEventCallback = NULL;
+                pEdmStream->pBtEventCallbackParam = NULL;
                 errorCode = U_ERROR_COMMON_SUCCESS;
             }
 
         }
-
-        U_PORT_MUTEX_UNLOCK(gMutex);
+        instanceUnlock(pEdmStream);
     }
 
     return (int32_t)errorCode;
@@ -1235,47 +1377,47 @@ int32_t uShortRangeEdmStreamDataEventCallbackSet(int32_t handle,
                                                  void *pParam)
 {
     uErrorCode_t errorCode = U_ERROR_COMMON_NOT_INITIALISED;
+    uShortRangeEdmStreamInstance_t *pEdmStream;
 
     if (gMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gMutex);
-
         errorCode = U_ERROR_COMMON_INVALID_PARAMETER;
-        if (handle == gEdmStream.handle) {
+        pEdmStream = pInstanceLock(handle);
+        if (pEdmStream != NULL) {
             switch (type) {
 
                 case U_SHORT_RANGE_CONNECTION_TYPE_BT:
-                    if (pFunction != NULL && gEdmStream.pBtDataCallback == NULL) {
-                        gEdmStream.pBtDataCallback = pFunction;
-                        gEdmStream.pBtDataCallbackParam = pParam;
+                    if (pFunction != NULL && pEdmStream->pBtDataCallback == NULL) {
+                        pEdmStream->pBtDataCallback = pFunction;
+                        pEdmStream->pBtDataCallbackParam = pParam;
                         errorCode = U_ERROR_COMMON_SUCCESS;
                     } else if (pFunction == NULL) {
-                        gEdmStream.pBtDataCallback = NULL;
-                        gEdmStream.pBtDataCallbackParam = NULL;
+                        pEdmStream->pBtDataCallback = NULL;
+                        pEdmStream->pBtDataCallbackParam = NULL;
                         errorCode = U_ERROR_COMMON_SUCCESS;
                     }
                     break;
 
                 case U_SHORT_RANGE_CONNECTION_TYPE_IP:
-                    if (pFunction != NULL && gEdmStream.pIpDataCallback == NULL) {
-                        gEdmStream.pIpDataCallback = pFunction;
-                        gEdmStream.pIpDataCallbackParam = pParam;
+                    if (pFunction != NULL && pEdmStream->pIpDataCallback == NULL) {
+                        pEdmStream->pIpDataCallback = pFunction;
+                        pEdmStream->pIpDataCallbackParam = pParam;
                         errorCode = U_ERROR_COMMON_SUCCESS;
                     } else if (pFunction == NULL) {
-                        gEdmStream.pIpDataCallback = NULL;
-                        gEdmStream.pIpDataCallbackParam = NULL;
+                        pEdmStream->pIpDataCallback = NULL;
+                        pEdmStream->pIpDataCallbackParam = NULL;
                         errorCode = U_ERROR_COMMON_SUCCESS;
                     }
                     break;
 
                 case U_SHORT_RANGE_CONNECTION_TYPE_MQTT:
-                    if (pFunction != NULL && gEdmStream.pMqttDataCallback == NULL) {
-                        gEdmStream.pMqttDataCallback = pFunction;
-                        gEdmStream.pMqttDataCallbackParam = pParam;
+                    if (pFunction != NULL && pEdmStream->pMqttDataCallback == NULL) {
+                        pEdmStream->pMqttDataCallback = pFunction;
+                        pEdmStream->pMqttDataCallbackParam = pParam;
                         errorCode = U_ERROR_COMMON_SUCCESS;
                     } else if (pFunction == NULL) {
-                        gEdmStream.pMqttDataCallback = NULL;
-                        gEdmStream.pMqttDataCallbackParam = NULL;
+                        pEdmStream->pMqttDataCallback = NULL;
+                        pEdmStream->pMqttDataCallbackParam = NULL;
                         errorCode = U_ERROR_COMMON_SUCCESS;
                     }
                     break;
@@ -1284,8 +1426,7 @@ int32_t uShortRangeEdmStreamDataEventCallbackSet(int32_t handle,
                     break;
             }
         }
-
-        U_PORT_MUTEX_UNLOCK(gMutex);
+        instanceUnlock(pEdmStream);
     }
 
     return (int32_t)errorCode;
@@ -1302,29 +1443,34 @@ void uShortRangeEdmStreamDataEventCallbackRemove(int32_t handle,
 
 void uShortRangeEdmStreamSetAtHandle(int32_t handle, void *atHandle)
 {
-    if (handle == gEdmStream.handle) {
-        uAtClientStreamInterceptTx(atHandle, pInterceptTx, NULL);
-        gEdmStream.atHandle = atHandle;
+    uShortRangeEdmStreamInstance_t *pEdmStream = pInstanceLock(handle);
+
+    if (pEdmStream != NULL) {
+        // The instance is the context of the intercept function
+        uAtClientStreamInterceptTx((uAtClientHandle_t) atHandle, pInterceptTx, pEdmStream);
+        pEdmStream->atHandle = atHandle;
     }
+    instanceUnlock(pEdmStream);
 }
 
 int32_t uShortRangeEdmStreamAtWrite(int32_t handle, const void *pBuffer,
                                     size_t sizeBytes)
 {
     int32_t sizeOrErrorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uShortRangeEdmStreamInstance_t *pEdmStream;
 
     if (gMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gMutex);
         sizeOrErrorCode = (int32_t)U_ERROR_COMMON_INVALID_PARAMETER;
-        if (gEdmStream.handle == handle && pBuffer != NULL && sizeBytes != 0) {
+        pEdmStream = pInstanceLock(handle);
+        if (pEdmStream != NULL && pBuffer != NULL && sizeBytes != 0) {
             sizeOrErrorCode = (int32_t)U_ERROR_COMMON_PLATFORM;
 
             int32_t result;
             uint32_t sent = 0;
 
             do {
-                result = uartWrite(pBuffer, sizeBytes);
+                result = uartWrite(pEdmStream, pBuffer, sizeBytes);
                 if (result > 0) {
                     sent += result;
                 }
@@ -1334,8 +1480,7 @@ int32_t uShortRangeEdmStreamAtWrite(int32_t handle, const void *pBuffer,
                 sizeOrErrorCode = (int32_t)sent;
             }
         }
-
-        U_PORT_MUTEX_UNLOCK(gMutex);
+        instanceUnlock(pEdmStream);
     }
 
     return sizeOrErrorCode;
@@ -1345,34 +1490,36 @@ int32_t uShortRangeEdmStreamAtRead(int32_t handle, void *pBuffer,
                                    size_t sizeBytes)
 {
     int32_t sizeOrErrorCode = (int32_t)U_ERROR_COMMON_NOT_INITIALISED;
+    uShortRangeEdmStreamInstance_t *pEdmStream;
 
     if (gMutex != NULL) {
 
-        if (!gEdmStream.ignoreUartCallback) {
-            U_PORT_MUTEX_LOCK(gMutex);
-
+        if ((handle >= 0) &&
+            (handle < (int32_t) (sizeof(gEdmStream) / sizeof(gEdmStream[0]))) &&
+            gEdmStream[handle].ignoreUartCallback) {
+            sizeOrErrorCode = 0;
+        } else {
             sizeOrErrorCode = (int32_t)U_ERROR_COMMON_INVALID_PARAMETER;
-            if (gEdmStream.handle == handle && pBuffer != NULL && sizeBytes != 0) {
-                sizeOrErrorCode = (int32_t)(gEdmStream.atResponseLength - gEdmStream.atResponseRead);
+            pEdmStream = pInstanceLock(handle);
+            if (pEdmStream != NULL && pBuffer != NULL && sizeBytes != 0) {
+                sizeOrErrorCode = (int32_t)(pEdmStream->atResponseLength - pEdmStream->atResponseRead);
                 if (sizeOrErrorCode > 0) {
                     if (sizeBytes < (uint32_t)sizeOrErrorCode) {
                         sizeOrErrorCode = (int32_t)sizeBytes;
                     }
-                    memcpy(pBuffer, gEdmStream.pAtResponseBuffer + gEdmStream.atResponseRead, sizeOrErrorCode);
-                    gEdmStream.atResponseRead += sizeOrErrorCode;
+                    memcpy(pBuffer, pEdmStream->pAtResponseBuffer + pEdmStream->atResponseRead,
+                           sizeOrErrorCode);
+                    pEdmStream->atResponseRead += sizeOrErrorCode;
 
-                    if (gEdmStream.atResponseRead >= gEdmStream.atResponseLength) {
-                        gEdmStream.atResponseLength = 0;
-                        gEdmStream.atResponseRead = 0;
+                    if (pEdmStream->atResponseRead >= pEdmStream->atResponseLength) {
+                        pEdmStream->atResponseLength = 0;
+                        pEdmStream->atResponseRead = 0;
                         uEdmChLogLine(LOG_CH_AT_RX, "processed");
-                        processedEvent();
+                        processedEvent(pEdmStream);
                     }
                 }
             }
-
-            U_PORT_MUTEX_UNLOCK(gMutex);
-        } else {
-            sizeOrErrorCode = 0;
+            instanceUnlock(pEdmStream);
         }
     }
 
@@ -1384,13 +1531,14 @@ int32_t uShortRangeEdmStreamWrite(int32_t handle, int32_t channel,
                                   uint32_t timeoutMs)
 {
     int32_t sizeOrErrorCode = (int32_t)U_ERROR_COMMON_NOT_INITIALISED;
+    uShortRangeEdmStreamInstance_t *pEdmStream;
 
     if (gMutex != NULL) {
-        U_PORT_MUTEX_LOCK(gMutex);
         sizeOrErrorCode = (int32_t)U_ERROR_COMMON_INVALID_PARAMETER;
-        if (gEdmStream.handle == handle && channel >= 0 &&
+        pEdmStream = pInstanceLock(handle);
+        if (pEdmStream != NULL && channel >= 0 &&
             pBuffer != NULL && sizeBytes != 0) {
-            uShortRangeEdmStreamConnections_t *pConnection = findConnection(channel);
+            uShortRangeEdmStreamConnections_t *pConnection = findConnection(pEdmStream, channel);
             if (pConnection != NULL) {
                 int32_t sent;
                 int32_t send;
@@ -1419,10 +1567,11 @@ int32_t uShortRangeEdmStreamWrite(int32_t handle, int32_t channel,
 #endif
 
                     (void)uShortRangeEdmZeroCopyHeadData((uint8_t)channel, send, (char *)&head[0]);
-                    sent = uartWrite((void *)&head[0], U_SHORT_RANGE_EDM_DATA_HEAD_SIZE);
-                    sent += uartWrite((const void *)((const char *)pBuffer + sizeOrErrorCode), send);
+                    sent = uartWrite(pEdmStream, (void *)&head[0], U_SHORT_RANGE_EDM_DATA_HEAD_SIZE);
+                    sent += uartWrite(pEdmStream,
+                                      (const void *)((const char *)pBuffer + sizeOrErrorCode), send);
                     (void)uShortRangeEdmZeroCopyTail((char *)&tail[0]);
-                    sent += uartWrite((void *)&tail[0], U_SHORT_RANGE_EDM_TAIL_SIZE);
+                    sent += uartWrite(pEdmStream, (void *)&tail[0], U_SHORT_RANGE_EDM_TAIL_SIZE);
 
                     if (sent != (send + U_SHORT_RANGE_EDM_DATA_HEAD_SIZE + U_SHORT_RANGE_EDM_TAIL_SIZE)) {
                         sizeOrErrorCode = (int32_t)U_ERROR_COMMON_DEVICE_ERROR;
@@ -1435,7 +1584,7 @@ int32_t uShortRangeEdmStreamWrite(int32_t handle, int32_t channel,
                          (endTime - startTime < timeoutMs));
             }
         }
-        U_PORT_MUTEX_UNLOCK(gMutex);
+        instanceUnlock(pEdmStream);
     }
 
     return sizeOrErrorCode;
@@ -1444,26 +1593,26 @@ int32_t uShortRangeEdmStreamWrite(int32_t handle, int32_t channel,
 int32_t uShortRangeEdmStreamAtEventSend(int32_t handle, uint32_t eventBitMap)
 {
     int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uShortRangeEdmStreamInstance_t *pEdmStream;
 
     if (gMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gMutex);
-
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
-        if ((handle == 0) &&
-            (gEdmStream.eventQueueHandle >= 0) &&
+        pEdmStream = pInstanceLock(handle);
+        if ((pEdmStream != NULL) &&
+            (pEdmStream->eventQueueHandle >= 0) &&
             // The only event we support right now
             (eventBitMap == U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED)) {
             uShortRangeEdmStreamEvent_t event;
+            event.pEdmStream = pEdmStream;
             event.type = U_SHORT_RANGE_EDM_STREAM_EVENT_AT;
-            errorCode = uPortEventQueueSend(gEdmStream.eventQueueHandle,
+            errorCode = uPortEventQueueSend(pEdmStream->eventQueueHandle,
                                             &event, sizeof(uShortRangeEdmStreamEvent_t));
             if (errorCode != 0) {
                 uPortLog("U_SHO_EDM_STREAM: Failed to enqueue message\n");
             }
         }
-
-        U_PORT_MUTEX_UNLOCK(gMutex);
+        instanceUnlock(pEdmStream);
     }
 
     return errorCode;
@@ -1472,17 +1621,16 @@ int32_t uShortRangeEdmStreamAtEventSend(int32_t handle, uint32_t eventBitMap)
 bool uShortRangeEdmStreamAtEventIsCallback(int32_t handle)
 {
     bool isEventCallback = false;
+    uShortRangeEdmStreamInstance_t *pEdmStream;
 
     if (gMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gMutex);
-
-        if ((handle == gEdmStream.handle) &&
-            (gEdmStream.eventQueueHandle >= 0)) {
-            isEventCallback = uPortEventQueueIsTask(gEdmStream.eventQueueHandle);
+        pEdmStream = pInstanceLock(handle);
+        if ((pEdmStream != NULL) &&
+            (pEdmStream->eventQueueHandle >= 0)) {
+            isEventCallback = uPortEventQueueIsTask(pEdmStream->eventQueueHandle);
         }
-
-        U_PORT_MUTEX_UNLOCK(gMutex);
+        instanceUnlock(pEdmStream);
     }
 
     return isEventCallback;
@@ -1490,15 +1638,15 @@ bool uShortRangeEdmStreamAtEventIsCallback(int32_t handle)
 
 void uShortRangeEdmStreamAtCallbackRemove(int32_t handle)
 {
-    if (gMutex != NULL) {
+    uShortRangeEdmStreamInstance_t *pEdmStream;
 
-        U_PORT_MUTEX_LOCK(gMutex);
+    if (gMutex != NULL) {
 
-        if (handle == gEdmStream.handle) {
-            gEdmStream.pAtCallback = NULL;
+        pEdmStream = pInstanceLock(handle);
+        if (pEdmStream != NULL) {
+            pEdmStream->pAtCallback = NULL;
         }
-
-        U_PORT_MUTEX_UNLOCK(gMutex);
+        instanceUnlock(pEdmStream);
     }
 }
 
@@ -1506,18 +1654,17 @@ void uShortRangeEdmStreamAtCallbackRemove(int32_t handle)
 int32_t uShortRangeEdmStreamAtEventStackMinFree(int32_t handle)
 {
     int32_t sizeOrErrorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uShortRangeEdmStreamInstance_t *pEdmStream;
 
     if (gMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gMutex);
-
         sizeOrErrorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
-        if ((handle == gEdmStream.handle) &&
-            (gEdmStream.eventQueueHandle >= 0)) {
-            sizeOrErrorCode = uPortEventQueueStackMinFree(gEdmStream.eventQueueHandle);
+        pEdmStream = pInstanceLock(handle);
+        if ((pEdmStream != NULL) &&
+            (pEdmStream->eventQueueHandle >= 0)) {
+            sizeOrErrorCode = uPortEventQueueStackMinFree(pEdmStream->eventQueueHandle);
         }
-
-        U_PORT_MUTEX_UNLOCK(gMutex);
+        instanceUnlock(pEdmStream);
     }
 
     return sizeOrErrorCode;
@@ -1526,17 +1673,16 @@ int32_t uShortRangeEdmStreamAtEventStackMinFree(int32_t handle)
 int32_t uShortRangeEdmStreamAtGetReceiveSize(int32_t handle)
 {
     int32_t sizeOrErrorCode = (int32_t)U_ERROR_COMMON_NOT_INITIALISED;
+    uShortRangeEdmStreamInstance_t *pEdmStream;
 
     if (gMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gMutex);
-
         sizeOrErrorCode = (int32_t)U_ERROR_COMMON_INVALID_PARAMETER;
-        if (handle == gEdmStream.handle) {
-            sizeOrErrorCode = gEdmStream.atResponseLength - gEdmStream.atResponseRead;
+        pEdmStream = pInstanceLock(handle);
+        if (pEdmStream != NULL) {
+            sizeOrErrorCode = pEdmStream->atResponseLength - pEdmStream->atResponseRead;
         }
-
-        U_PORT_MUTEX_UNLOCK(gMutex);
+        instanceUnlock(pEdmStream);
     }
 
     return sizeOrErrorCode;
@@ -43,6 +43,11 @@
  * TYPES
  * -------------------------------------------------------------- */
 
+// A set of pools: pbuf lists and the pbufs that go in them.
+typedef struct {
+    uMemPoolDesc_t pBufListPool;
+    uMemPoolDesc_t pBufPool;
+} uShortRangePbufPoolSet_t;
 
 /* ----------------------------------------------------------------
  * STATIC PROTOTYPES
@@ -51,47 +56,111 @@
 /* ----------------------------------------------------------------
  * STATIC VARIABLES
  * -------------------------------------------------------------- */
-static uMemPoolDesc_t gPBufListPool;
-static uMemPoolDesc_t gPBufPool;
+static uShortRangePbufPoolSet_t gPools[U_SHORT_RANGE_PBUF_POOL_COUNT];
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
 
-static void freePbuf(uShortRangePbuf_t *pBuf, bool freeWholeChain)
+// Find the pbuf pool that pBuf came from.
+static uMemPoolDesc_t *pPbufPoolFind(const uShortRangePbuf_t *pBuf)
 {
-    if (freeWholeChain) {
-        while (pBuf != NULL) {
-            uShortRangePbuf_t *pNext = pBuf->pNext;
-            // Basic sanity check - pbuf length should never be longer than pool block size
-            U_ASSERT(pBuf->length <= gPBufPool.blockSize);
-            uMemPoolFreeMem(&gPBufPool, pBuf);
-            pBuf = pNext;
+    uMemPoolDesc_t *pPool = NULL;
+
+    for (size_t x = 0; (x < U_SHORT_RANGE_PBUF_POOL_COUNT) && (pPool == NULL); x++) {
+        if (uMemPoolIsOwner(&(gPools[x].pBufPool), pBuf)) {
+            pPool = &(gPools[x].pBufPool);
+        }
+    }
+    // Memory from outside the pools would be a serious error
+    U_ASSERT(pPool != NULL);
+
+    return pPool;
+}
+
+// Find the pbuf list pool that pBufList came from.
+static uMemPoolDesc_t *pPbufListPoolFind(const uShortRangePbufList_t *pBufList)
+{
+    uMemPoolDesc_t *pPool = NULL;
+
+    for (size_t x = 0; (x < U_SHORT_RANGE_PBUF_POOL_COUNT) && (pPool == NULL); x++) {
+        if (uMemPoolIsOwner(&(gPools[x].pBufListPool), pBufList)) {
+            pPool = &(gPools[x].pBufListPool);
         }
-    } else if (pBuf != NULL) {
+    }
+    U_ASSERT(pPool != NULL);
+
+    return pPool;
+}
+
+// Release a reference to a pbuf, freeing it back to its pool
+// if that was the last; a chain may contain pbufs from different
+// pools, e.g. after uShortRangePbufListMerge().
+static void freePbuf(uShortRangePbuf_t *pBuf, bool freeWholeChain)
+{
+    uMemPoolDesc_t *pPool;
+    uint8_t refCount;
+
+    while (pBuf != NULL) {
+        uShortRangePbuf_t *pNext = pBuf->pNext;
+        pPool = pPbufPoolFind(pBuf);
         // Basic sanity check - pbuf length should never be longer than pool block size
-        U_ASSERT(pBuf->length <= gPBufPool.blockSize);
-        uMemPoolFreeMem(&gPBufPool, pBuf);
+        U_ASSERT(pBuf->length <= gPools[0].pBufPool.blockSize);
+        // The mutex of the pool also protects the reference counts
+        // of the pbufs in it
+        U_PORT_MUTEX_LOCK(pPool->mutex);
+        U_ASSERT(pBuf->refCount > 0);
+        pBuf->refCount--;
+        refCount = pBuf->refCount;
+        U_PORT_MUTEX_UNLOCK(pPool->mutex);
+        if (refCount == 0) {
+            uMemPoolFreeMem(pPool, pBuf);
+        }
+        pBuf = freeWholeChain ? pNext : NULL;
     }
 }
 
+// Add a reference to a pbuf.
+static void refPbuf(uShortRangePbuf_t *pBuf)
+{
+    uMemPoolDesc_t *pPool = pPbufPoolFind(pBuf);
+
+    U_PORT_MUTEX_LOCK(pPool->mutex);
+    U_ASSERT(pBuf->refCount < UINT8_MAX);
+    pBuf->refCount++;
+    U_PORT_MUTEX_UNLOCK(pPool->mutex);
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS
  * -------------------------------------------------------------- */
 
 int32_t uShortRangeMemPoolInit(void)
 {
-    int32_t err;
+    int32_t err = (int32_t)U_ERROR_COMMON_SUCCESS;
+    size_t x;
 
-    err = uMemPoolInit(&gPBufListPool, sizeof(uShortRangePbufList_t),
-                       U_SHORT_RANGE_PBUFLIST_COUNT);
+    for (x = 0; (x < U_SHORT_RANGE_PBUF_POOL_COUNT) &&
+         (err == (int32_t)U_ERROR_COMMON_SUCCESS); x++) {
+        err = uMemPoolInit(&(gPools[x].pBufListPool), sizeof(uShortRangePbufList_t),
+                           U_SHORT_RANGE_PBUFLIST_COUNT);
 
-    if (err == 0) {
+        if (err == 0) {
 
-        err = uMemPoolInit(&gPBufPool, sizeof(uShortRangePbuf_t) + U_SHORT_RANGE_EDM_BLK_SIZE,
-                           U_SHORT_RANGE_EDM_BLK_COUNT);
+            err = uMemPoolInit(&(gPools[x].pBufPool),
+                               sizeof(uShortRangePbuf_t) + U_SHORT_RANGE_EDM_BLK_SIZE,
+                               U_SHORT_RANGE_EDM_BLK_COUNT);
 
-        if (err != (int32_t)U_ERROR_COMMON_SUCCESS) {
-            uMemPoolDeinit(&gPBufListPool);
+            if (err != (int32_t)U_ERROR_COMMON_SUCCESS) {
+                uMemPoolDeinit(&(gPools[x].pBufListPool));
+            }
+        }
+    }
+
+    if (err != (int32_t)U_ERROR_COMMON_SUCCESS) {
+        // Clean up the sets that were initialised before the failure
+        for (x--; x > 0; x--) {
+            uMemPoolDeinit(&(gPools[x - 1].pBufPool));
+            uMemPoolDeinit(&(gPools[x - 1].pBufListPool));
         }
     }
 
@@ -100,28 +169,51 @@ int32_t uShortRangeMemPoolInit(void)
 
 void uShortRangeMemPoolDeInit(void)
 {
-    uMemPoolDeinit(&gPBufPool);
-    uMemPoolDeinit(&gPBufListPool);
+    for (size_t x = 0; x < U_SHORT_RANGE_PBUF_POOL_COUNT; x++) {
+        uMemPoolDeinit(&(gPools[x].pBufPool));
+        uMemPoolDeinit(&(gPools[x].pBufListPool));
+    }
 }
 
 int32_t uShortRangePbufAlloc(uShortRangePbuf_t **ppBuf)
 {
-    int32_t errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
-    *ppBuf = (uShortRangePbuf_t *)uMemPoolAllocMem(&gPBufPool);
-    if (*ppBuf != NULL) {
-        (*ppBuf)->length = 0;
-        (*ppBuf)->pNext = NULL;
-        errorCode = gPBufPool.blockSize - sizeof(uShortRangePbuf_t);
+    return uShortRangePbufAllocFromPool(0, ppBuf);
+}
+
+int32_t uShortRangePbufAllocFromPool(int32_t poolIndex, uShortRangePbuf_t **ppBuf)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+
+    if ((poolIndex >= 0) && (poolIndex < U_SHORT_RANGE_PBUF_POOL_COUNT)) {
+        uMemPoolDesc_t *pPool = &(gPools[poolIndex].pBufPool);
+        errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+        *ppBuf = (uShortRangePbuf_t *)uMemPoolAllocMem(pPool);
+        if (*ppBuf != NULL) {
+            (*ppBuf)->length = 0;
+            (*ppBuf)->refCount = 1;
+            (*ppBuf)->pNext = NULL;
+            errorCode = pPool->blockSize - sizeof(uShortRangePbuf_t);
+        }
+    } else {
+        *ppBuf = NULL;
     }
     return errorCode;
 }
 
 uShortRangePbufList_t *pUShortRangePbufListAlloc(void)
 {
-    uShortRangePbufList_t *pList;
-    pList = (uShortRangePbufList_t *)uMemPoolAllocMem(&gPBufListPool);
-    if (pList != NULL) {
-        memset(pList, 0, sizeof(uShortRangePbufList_t));
+    return pUShortRangePbufListAllocFromPool(0);
+}
+
+uShortRangePbufList_t *pUShortRangePbufListAllocFromPool(int32_t poolIndex)
+{
+    uShortRangePbufList_t *pList = NULL;
+
+    if ((poolIndex >= 0) && (poolIndex < U_SHORT_RANGE_PBUF_POOL_COUNT)) {
+        pList = (uShortRangePbufList_t *)uMemPoolAllocMem(&(gPools[poolIndex].pBufListPool));
+        if (pList != NULL) {
+            memset(pList, 0, sizeof(uShortRangePbufList_t));
+        }
     }
     return pList;
 }
@@ -131,7 +223,7 @@ void uShortRangePbufListFree(uShortRangePbufList_t *pBufList)
     if (pBufList != NULL) {
         freePbuf(pBufList->pBufHead, true);
         pBufList->totalLen = 0;
-        uMemPoolFreeMem(&gPBufListPool, pBufList);
+        uMemPoolFreeMem(pPbufListPoolFind(pBufList), pBufList);
     }
 }
 
@@ -161,6 +253,11 @@ void uShortRangePbufListMerge(uShortRangePbufList_t *pOldList, uShortRangePbufLi
         (pOldList->totalLen > 0) &&
         (pNewList->totalLen > 0)) {
 
+        // Linking on to a shared pbuf would change the lists
+        // it is shared with
+        U_ASSERT((pOldList->pBufTail == NULL) || (pOldList->pBufTail->refCount == 1));
+        U_ASSERT(pNewList->headOffset == 0);
+
         if (pOldList->pBufTail != NULL) {
             pOldList->pBufTail->pNext = pNewList->pBufHead;
             pOldList->pBufTail = pNewList->pBufTail;
@@ -169,7 +266,7 @@ void uShortRangePbufListMerge(uShortRangePbufList_t *pOldList, uShortRangePbufLi
             *pOldList = *pNewList;
         }
 
-        uMemPoolFreeMem(&gPBufListPool, pNewList);
+        uMemPoolFreeMem(pPbufListPoolFind(pNewList), pNewList);
     }
 }
 
@@ -177,6 +274,7 @@ void uShortRangePbufListMerge(uShortRangePbufList_t *pOldList, uShortRangePbufLi
 size_t uShortRangePbufListConsumeData(uShortRangePbufList_t *pBufList, char *pData, size_t len)
 {
     size_t copiedLen = 0;
+    size_t available;
     uShortRangePbuf_t *pTemp;
     uShortRangePbuf_t *pNext = NULL;
 
@@ -184,29 +282,32 @@ size_t uShortRangePbufListConsumeData(uShortRangePbufList_t *pBufList, char *pDa
 
         for (pTemp = pBufList->pBufHead; (len != 0 && pTemp != NULL); pTemp = pNext) {
             // Basic sanity check - pbuf length should never be longer than pool block size
-            U_ASSERT(pTemp->length <= gPBufPool.blockSize);
+            U_ASSERT(pTemp->length <= gPools[0].pBufPool.blockSize);
+            U_ASSERT(pBufList->headOffset <= pTemp->length);
+            available = pTemp->length - pBufList->headOffset;
 
-            if (pTemp->length <= len) {
+            if (available <= len) {
                 // Copy the data to the given buffer
-                memcpy(&pData[copiedLen], &pTemp->data[0], pTemp->length);
-                copiedLen += pTemp->length;
-                pBufList->totalLen -= pTemp->length;
-                len -= pTemp->length;
+                memcpy(&pData[copiedLen], &pTemp->data[pBufList->headOffset], available);
+                copiedLen += available;
+                pBufList->totalLen -= (uint16_t)available;
+                len -= available;
                 pNext = pTemp->pNext;
                 // We are done with this pbuf - put it back in the pool
+                // (if no other list is using it)
                 freePbuf(pTemp, false);
                 pBufList->pBufHead = pNext;
+                pBufList->headOffset = 0;
                 if (pBufList->pBufHead == NULL) {
                     pBufList->pBufTail = NULL;
                 }
             } else {
-                // Do partial copy
-                memcpy(&pData[copiedLen], &pTemp->data[0], len);
+                // Do partial copy, just moving on the offset since
+                // the pbuf may be shared
+                memcpy(&pData[copiedLen], &pTemp->data[pBufList->headOffset], len);
                 copiedLen += len;
                 pBufList->totalLen -= (uint16_t)len;
-                pTemp->length -= (uint16_t)len;
-                // move the remaining data to start
-                memmove(&pTemp->data[0], &pTemp->data[len], pTemp->length);
+                pBufList->headOffset += (uint16_t)len;
                 len = 0;
             }
         }
@@ -215,6 +316,53 @@ size_t uShortRangePbufListConsumeData(uShortRangePbufList_t *pBufList, char *pDa
     return copiedLen;
 }
 
+const char *pUShortRangePbufListSpan(const uShortRangePbufList_t *pBufList,
+                                     const uShortRangePbuf_t **ppBuf,
+                                     size_t *pLength)
+{
+    const char *pSpan = NULL;
+    const uShortRangePbuf_t *pBuf = NULL;
+
+    if ((pBufList != NULL) && (ppBuf != NULL) && (pLength != NULL)) {
+        if (*ppBuf == NULL) {
+            pBuf = pBufList->pBufHead;
+            if (pBuf != NULL) {
+                pSpan = &pBuf->data[pBufList->headOffset];
+                *pLength = pBuf->length - pBufList->headOffset;
+            }
+        } else if (*ppBuf != pBufList->pBufTail) {
+            pBuf = (*ppBuf)->pNext;
+            if (pBuf != NULL) {
+                pSpan = &pBuf->data[0];
+                *pLength = pBuf->length;
+            }
+        }
+        if (pSpan != NULL) {
+            *ppBuf = pBuf;
+        }
+    }
+
+    return pSpan;
+}
+
+uShortRangePbufList_t *pUShortRangePbufListShare(uShortRangePbufList_t *pBufList)
+{
+    uShortRangePbufList_t *pList = NULL;
+    uShortRangePbuf_t *pBuf;
+
+    if (pBufList != NULL) {
+        pList = (uShortRangePbufList_t *)uMemPoolAllocMem(pPbufListPoolFind(pBufList));
+        if (pList != NULL) {
+            *pList = *pBufList;
+            pList->pNext = NULL;
+            for (pBuf = pList->pBufHead; pBuf != NULL; pBuf = pBuf->pNext) {
+                refPbuf(pBuf);
+            }
+        }
+    }
+
+    return pList;
+}
 
 int32_t uShortRangePktListAppend(uShortRangePktList_t *pPktList,
                                  uShortRangePbufList_t *pPbufList)
@@ -240,12 +388,30 @@ int32_t uShortRangePktListAppend(uShortRangePktList_t *pPktList,
     return err;
 }
 
+uShortRangePbufList_t *pUShortRangePktListTake(uShortRangePktList_t *pPktList)
+{
+    uShortRangePbufList_t *pBufList = NULL;
+
+    if ((pPktList != NULL) && (pPktList->pktCount > 0)) {
+        pBufList = pPktList->pBufListHead;
+        if (pBufList != NULL) {
+            pPktList->pBufListHead = pBufList->pNext;
+            pBufList->pNext = NULL;
+            pPktList->pktCount--;
+            if (pPktList->pktCount == 0) {
+                memset((void *)pPktList, 0, sizeof(uShortRangePktList_t));
+            }
+        }
+    }
+
+    return pBufList;
+}
+
 int32_t uShortRangePktListConsumePacket(uShortRangePktList_t *pPktList, char *pData, size_t *pLen,
                                         int32_t *pEdmChannel)
 {
     int32_t err = (int32_t)U_ERROR_COMMON_INVALID_PARAMETER;
     uShortRangePbufList_t *pTemp;
-    uShortRangePbufList_t **ppTemp;
 
     if ((pPktList != NULL) &&
         (pData != NULL) &&
@@ -254,10 +420,11 @@ int32_t uShortRangePktListConsumePacket(uShortRangePktList_t *pPktList, char *pD
 
         err = (int32_t)U_ERROR_COMMON_NO_MEMORY;
         pTemp = pPktList->pBufListHead;
-        ppTemp = &pPktList->pBufListHead;
 
         if ((pTemp != NULL) && (pTemp->totalLen > 0)) {
 
+            pTemp = pUShortRangePktListTake(pPktList);
+
             if (pEdmChannel != NULL) {
                 *pEdmChannel = pTemp->edmChannel;
             }
@@ -269,13 +436,7 @@ int32_t uShortRangePktListConsumePacket(uShortRangePktList_t *pPktList, char *pD
                 err = (int32_t)U_ERROR_COMMON_TEMPORARY_FAILURE;
             }
 
-            *ppTemp = pTemp->pNext;
-            pPktList->pktCount--;
             uShortRangePbufListFree(pTemp);
-
-            if (pPktList->pktCount == 0) {
-                memset((void *)pPktList, 0, sizeof(uShortRangePktList_t));
-            }
         }
     }
 
@@ -89,6 +89,23 @@ static int32_t generatePayLoad(uShortRangePbuf_t **ppBuf)
     }
     return errorCode;
 }
+
+// Make an EDM data event packet, returning its length.
+static size_t makeEdmDataEvent(uint8_t channel, const char *pData,
+                               size_t size, char *pPacket)
+{
+    pPacket[0] = (char) 0xAA;
+    pPacket[1] = (char) ((size + 3) >> 8);
+    pPacket[2] = (char) ((size + 3) & 0xFF);
+    pPacket[3] = 0x00;
+    pPacket[4] = 0x31;
+    pPacket[5] = (char) channel;
+    memcpy(pPacket + 6, pData, size);
+    pPacket[size + 6] = 0x55;
+
+    return size + U_SHORT_RANGE_EDM_DATA_OVERHEAD;
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS: TESTS
  * -------------------------------------------------------------- */
@@ -263,4 +280,335 @@ U_PORT_TEST_FUNCTION("[pbuf]", "pbufPktList")
     U_PORT_TEST_ASSERT((heapUsed == 0) || (heapUsed == (int32_t)U_ERROR_COMMON_NOT_SUPPORTED));
 }
 
+U_PORT_TEST_FUNCTION("[pbuf]", "pbufEdmParser")
+{
+    int32_t errCode;
+    uShortRangeEdmParser_t parser[2];
+    uShortRangeEdmEvent_t *pEvent;
+    char *pPayload[2];
+    char *pPacket[2];
+    size_t packetLength[2];
+    size_t offset[2] = {0};
+    bool done[2] = {false};
+    bool memAvailable;
+    char *pSpace;
+    char *pBuffer;
+    size_t chunk;
+    size_t x;
+    int32_t heapUsed;
+    //lint -e{679} suppress loss of precision
+    //lint -e{647} suppress suspicious truncation
+    size_t payloadLen = (U_SHORT_RANGE_EDM_BLK_SIZE * 4) + 11;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    rand();
+    heapUsed = uPortGetHeapFree();
+
+    errCode = uShortRangeMemPoolInit();
+    U_PORT_TEST_ASSERT(errCode == (int32_t)U_ERROR_COMMON_SUCCESS);
+
+    pBuffer = (char *)pUPortMalloc(payloadLen);
+    U_PORT_TEST_ASSERT(pBuffer != NULL);
+
+    // Two packets of random data on different channels, each
+    // with its own parser
+    memset(parser, 0, sizeof(parser));
+#if U_SHORT_RANGE_PBUF_POOL_COUNT > 1
+    // ...and its own pbuf pools
+    parser[1].poolIndex = 1;
+#endif
+    for (size_t a = 0; a < 2; a++) {
+        pPayload[a] = (char *)pUPortMalloc(payloadLen);
+        U_PORT_TEST_ASSERT(pPayload[a] != NULL);
+        pPacket[a] = (char *)pUPortMalloc(payloadLen + U_SHORT_RANGE_EDM_DATA_OVERHEAD);
+        U_PORT_TEST_ASSERT(pPacket[a] != NULL);
+        for (size_t y = 0; y < payloadLen; y++) {
+            pPayload[a][y] = (char) rand();
+        }
+        packetLength[a] = makeEdmDataEvent((uint8_t) (a + 1), pPayload[a],
+                                           payloadLen, pPacket[a]);
+    }
+
+    // Feed the two packets to their parsers interleaved, in random
+    // sized chunks; the second parser has its payload written
+    // straight into pbuf storage, as the EDM stream does from the UART
+    while (!done[0] || !done[1]) {
+        for (size_t a = 0; a < 2; a++) {
+            if (done[a]) {
+                continue;
+            }
+            chunk = (rand() % 17) + 1;
+            if (chunk > packetLength[a] - offset[a]) {
+                chunk = packetLength[a] - offset[a];
+            }
+            pEvent = NULL;
+            pSpace = NULL;
+            if (a == 1) {
+                pSpace = pUShortRangeEdmParserPayloadSpace(&parser[a], &x, &memAvailable);
+                U_PORT_TEST_ASSERT(memAvailable);
+            }
+            if (pSpace != NULL) {
+                U_PORT_TEST_ASSERT(x > 0);
+                if (x > chunk) {
+                    x = chunk;
+                }
+                memcpy(pSpace, pPacket[a] + offset[a], x);
+                uShortRangeEdmParserPayloadCommit(&parser[a], x);
+                offset[a] += x;
+            } else {
+                offset[a] += uShortRangeEdmParse(&parser[a], pPacket[a] + offset[a],
+                                                 chunk, &pEvent, &memAvailable);
+                U_PORT_TEST_ASSERT(memAvailable);
+            }
+            if (pEvent != NULL) {
+                // The event must come with the tail byte
+                U_PORT_TEST_ASSERT(offset[a] == packetLength[a]);
+                U_PORT_TEST_ASSERT(!uShortRangeEdmParserReady(&parser[a]));
+                U_PORT_TEST_ASSERT(pEvent->type == U_SHORT_RANGE_EDM_EVENT_DATA);
+                U_PORT_TEST_ASSERT(pEvent->params.dataEvent.channel == a + 1);
+                U_PORT_TEST_ASSERT(pEvent->params.dataEvent.pBufList->totalLen == payloadLen);
+                memset(pBuffer, 0, payloadLen);
+                x = uShortRangePbufListConsumeData(pEvent->params.dataEvent.pBufList,
+                                                   pBuffer, payloadLen);
+                U_PORT_TEST_ASSERT(x == payloadLen);
+                U_PORT_TEST_ASSERT(memcmp(pBuffer, pPayload[a], payloadLen) == 0);
+                uShortRangePbufListFree(pEvent->params.dataEvent.pBufList);
+                uShortRangeEdmResetParser(&parser[a]);
+                U_PORT_TEST_ASSERT(uShortRangeEdmParserReady(&parser[a]));
+                done[a] = true;
+            } else {
+                U_PORT_TEST_ASSERT(offset[a] < packetLength[a]);
+            }
+        }
+    }
+
+    // Resetting a parser part way through a packet must
+    // not leak pbufs
+    x = uShortRangeEdmParse(&parser[0], pPacket[0], packetLength[0] / 2,
+                            &pEvent, &memAvailable);
+    U_PORT_TEST_ASSERT(x == packetLength[0] / 2);
+    U_PORT_TEST_ASSERT(pEvent == NULL);
+    uShortRangeEdmResetParser(&parser[0]);
+
+    uShortRangeMemPoolDeInit();
+    for (size_t a = 0; a < 2; a++) {
+        uPortFree(pPayload[a]);
+        uPortFree(pPacket[a]);
+    }
+    uPortFree(pBuffer);
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("we have leaked %d byte(s).", heapUsed);
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT((heapUsed == 0) || (heapUsed == (int32_t)U_ERROR_COMMON_NOT_SUPPORTED));
+}
+
+
+U_PORT_TEST_FUNCTION("[pbuf]", "pbufPools")
+{
+    int32_t errCode;
+    uShortRangePbufList_t *pPbufList[U_SHORT_RANGE_PBUF_POOL_COUNT];
+    uShortRangePbuf_t *pBuf;
+    int32_t heapUsed;
+    int32_t count;
+    char *pBuffer;
+    size_t x;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    heapUsed = uPortGetHeapFree();
+
+    errCode = uShortRangeMemPoolInit();
+    U_PORT_TEST_ASSERT(errCode == (int32_t)U_ERROR_COMMON_SUCCESS);
+
+    // Out of range pools
+    U_PORT_TEST_ASSERT(uShortRangePbufAllocFromPool(-1, &pBuf) < 0);
+    U_PORT_TEST_ASSERT(pBuf == NULL);
+    U_PORT_TEST_ASSERT(uShortRangePbufAllocFromPool(U_SHORT_RANGE_PBUF_POOL_COUNT, &pBuf) < 0);
+    U_PORT_TEST_ASSERT(pUShortRangePbufListAllocFromPool(U_SHORT_RANGE_PBUF_POOL_COUNT) == NULL);
+
+    // Empty each pool in turn into a list: the other pools must be
+    // unaffected
+    for (x = 0; x < U_SHORT_RANGE_PBUF_POOL_COUNT; x++) {
+        pPbufList[x] = pUShortRangePbufListAllocFromPool((int32_t) x);
+        U_PORT_TEST_ASSERT(pPbufList[x] != NULL);
+        count = 0;
+        while (uShortRangePbufAllocFromPool((int32_t) x, &pBuf) > 0) {
+            pBuf->data[0] = (char) x;
+            pBuf->length = 1;
+            U_PORT_TEST_ASSERT(uShortRangePbufListAppend(pPbufList[x], pBuf) == 0);
+            count++;
+        }
+        U_TEST_PRINT_LINE("pool %d has %d pbufs.", (int32_t) x, count);
+        U_PORT_TEST_ASSERT(count == U_SHORT_RANGE_EDM_BLK_COUNT);
+    }
+
+    // Merge all of the lists into the first, which frees the other
+    // lists back to their own pools, then consume it
+    for (x = 1; x < U_SHORT_RANGE_PBUF_POOL_COUNT; x++) {
+        uShortRangePbufListMerge(pPbufList[0], pPbufList[x]);
+        U_PORT_TEST_ASSERT(pUShortRangePbufListAllocFromPool((int32_t) x) == pPbufList[x]);
+        uShortRangePbufListFree(pPbufList[x]);
+    }
+    U_PORT_TEST_ASSERT(pPbufList[0]->totalLen == U_SHORT_RANGE_EDM_BLK_COUNT *
+                       U_SHORT_RANGE_PBUF_POOL_COUNT);
+    pBuffer = (char *)pUPortMalloc(pPbufList[0]->totalLen);
+    U_PORT_TEST_ASSERT(pBuffer != NULL);
+    U_PORT_TEST_ASSERT(uShortRangePbufListConsumeData(pPbufList[0], pBuffer,
+                                                      pPbufList[0]->totalLen) ==
+                       U_SHORT_RANGE_EDM_BLK_COUNT * U_SHORT_RANGE_PBUF_POOL_COUNT);
+    for (x = 0; x < U_SHORT_RANGE_PBUF_POOL_COUNT; x++) {
+        U_PORT_TEST_ASSERT(pBuffer[x * U_SHORT_RANGE_EDM_BLK_COUNT] == (char) x);
+    }
+    uPortFree(pBuffer);
+
+    // Freeing the list must put every pbuf back in the pool
+    // it came from
+    uShortRangePbufListFree(pPbufList[0]);
+    for (x = 0; x < U_SHORT_RANGE_PBUF_POOL_COUNT; x++) {
+        count = 0;
+        pPbufList[x] = pUShortRangePbufListAllocFromPool((int32_t) x);
+        U_PORT_TEST_ASSERT(pPbufList[x] != NULL);
+        while (uShortRangePbufAllocFromPool((int32_t) x, &pBuf) > 0) {
+            U_PORT_TEST_ASSERT(uShortRangePbufListAppend(pPbufList[x], pBuf) == 0);
+            count++;
+        }
+        U_PORT_TEST_ASSERT(count == U_SHORT_RANGE_EDM_BLK_COUNT);
+        uShortRangePbufListFree(pPbufList[x]);
+    }
+
+    uShortRangeMemPoolDeInit();
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("we have leaked %d byte(s).", heapUsed);
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT((heapUsed == 0) || (heapUsed == (int32_t)U_ERROR_COMMON_NOT_SUPPORTED));
+}
+
+
+U_PORT_TEST_FUNCTION("[pbuf]", "pbufShare")
+{
+    int32_t errCode;
+    uShortRangePbufList_t *pPbufList;
+    uShortRangePbufList_t *pShared[2];
+    uShortRangePktList_t pktList;
+    const uShortRangePbuf_t *pSpanBuf;
+    uShortRangePbuf_t *pBuf;
+    const char *pSpan;
+    size_t spanLength;
+    int32_t numOfBlks = 4;
+    int32_t heapUsed;
+    char *pBuffer1;
+    char *pBuffer2;
+    size_t copiedLen;
+    int32_t count;
+    //lint -e{679} suppress loss of precision
+    //lint -e{647} suppress suspicious truncation
+    size_t totalLen = numOfBlks * U_SHORT_RANGE_EDM_BLK_SIZE;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    heapUsed = uPortGetHeapFree();
+
+    errCode = uShortRangeMemPoolInit();
+    U_PORT_TEST_ASSERT(errCode == (int32_t)U_ERROR_COMMON_SUCCESS);
+
+    pBuffer1 = (char *)pUPortMalloc(totalLen);
+    U_PORT_TEST_ASSERT(pBuffer1 != NULL);
+    pBuffer2 = (char *)pUPortMalloc(totalLen);
+    U_PORT_TEST_ASSERT(pBuffer2 != NULL);
+
+    pPbufList = pUShortRangePbufListAlloc();
+    U_PORT_TEST_ASSERT(pPbufList != NULL);
+    pPbufList->edmChannel = 3;
+    for (int32_t i = 0; i < numOfBlks; i++) {
+        U_PORT_TEST_ASSERT(generatePayLoad(&pBuf) == U_SHORT_RANGE_EDM_BLK_SIZE);
+        memcpy(&pBuffer1[i * U_SHORT_RANGE_EDM_BLK_SIZE], &pBuf->data[0],
+               U_SHORT_RANGE_EDM_BLK_SIZE);
+        U_PORT_TEST_ASSERT(uShortRangePbufListAppend(pPbufList, pBuf) == 0);
+    }
+
+    // Read a little of the original, then share it twice: the
+    // shared lists should start where the original had got to
+    U_PORT_TEST_ASSERT(uShortRangePbufListConsumeData(pPbufList, pBuffer2, 10) == 10);
+    U_PORT_TEST_ASSERT(memcmp(pBuffer1, pBuffer2, 10) == 0);
+    pShared[0] = pUShortRangePbufListShare(pPbufList);
+    U_PORT_TEST_ASSERT(pShared[0] != NULL);
+    pShared[1] = pUShortRangePbufListShare(pPbufList);
+    U_PORT_TEST_ASSERT(pShared[1] != NULL);
+    U_PORT_TEST_ASSERT(pShared[0]->totalLen == totalLen - 10);
+    U_PORT_TEST_ASSERT(pShared[0]->edmChannel == 3);
+
+    // Reading the original, in awkward amounts, must not
+    // affect the shared lists
+    copiedLen = 10;
+    while (pPbufList->totalLen > 0) {
+        copiedLen += uShortRangePbufListConsumeData(pPbufList, &pBuffer2[copiedLen], 7);
+    }
+    U_PORT_TEST_ASSERT(copiedLen == totalLen);
+    U_PORT_TEST_ASSERT(memcmp(pBuffer1, pBuffer2, totalLen) == 0);
+    uShortRangePbufListFree(pPbufList);
+
+    // Iterate the spans of the first shared list without copying
+    memset(pBuffer2, 0, totalLen);
+    copiedLen = 0;
+    count = 0;
+    pSpanBuf = NULL;
+    while ((pSpan = pUShortRangePbufListSpan(pShared[0], &pSpanBuf, &spanLength)) != NULL) {
+        U_PORT_TEST_ASSERT(memcmp(pSpan, &pBuffer1[10 + copiedLen], spanLength) == 0);
+        copiedLen += spanLength;
+        count++;
+    }
+    U_PORT_TEST_ASSERT(copiedLen == totalLen - 10);
+    U_PORT_TEST_ASSERT(count == numOfBlks);
+    U_PORT_TEST_ASSERT(pShared[0]->totalLen == totalLen - 10);
+    uShortRangePbufListFree(pShared[0]);
+
+    // Put the second shared list in a packet list, take
+    // ownership of it back and read it
+    memset(&pktList, 0, sizeof(pktList));
+    U_PORT_TEST_ASSERT(uShortRangePktListAppend(&pktList, pShared[1]) == 0);
+    U_PORT_TEST_ASSERT(pUShortRangePktListTake(&pktList) == pShared[1]);
+    U_PORT_TEST_ASSERT(pktList.pktCount == 0);
+    U_PORT_TEST_ASSERT(pUShortRangePktListTake(&pktList) == NULL);
+    U_PORT_TEST_ASSERT(uShortRangePbufListConsumeData(pShared[1], pBuffer2,
+                                                      totalLen) == totalLen - 10);
+    U_PORT_TEST_ASSERT(memcmp(&pBuffer1[10], pBuffer2, totalLen - 10) == 0);
+    uShortRangePbufListFree(pShared[1]);
+
+    // All of the pbufs should now be back in the pool
+    pPbufList = pUShortRangePbufListAlloc();
+    U_PORT_TEST_ASSERT(pPbufList != NULL);
+    count = 0;
+    while (uShortRangePbufAlloc(&pBuf) > 0) {
+        pBuf->length = 1;
+        U_PORT_TEST_ASSERT(uShortRangePbufListAppend(pPbufList, pBuf) == 0);
+        count++;
+    }
+    U_PORT_TEST_ASSERT(count == U_SHORT_RANGE_EDM_BLK_COUNT);
+    uShortRangePbufListFree(pPbufList);
+
+    uPortFree(pBuffer1);
+    uPortFree(pBuffer2);
+    uShortRangeMemPoolDeInit();
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("we have leaked %d byte(s).", heapUsed);
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT((heapUsed == 0) || (heapUsed == (int32_t)U_ERROR_COMMON_NOT_SUPPORTED));
+}
+
 // End of file
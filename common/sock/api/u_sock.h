@@ -45,7 +45,9 @@ extern "C" {
 /** A value for the maximum number of sockets that can be open
  * simultaneously is required by this API in order that if can
  * define #U_SOCK_DESCRIPTOR_SET_SIZE.  A limitation may also be
- * applied by the underlying implementation.
+ * applied by the underlying implementation.  A table of this
+ * many sockets, indexed by descriptor, is statically allocated,
+ * so the cost of finding a socket does not grow with this number.
  */
 # define U_SOCK_MAX_NUM_SOCKETS 7
 #endif
@@ -57,13 +59,14 @@ extern "C" {
 #endif
 
 #ifndef U_SOCK_RECEIVE_POLL_INTERVAL_MS
-/** The interval at which this layer hits the underlying
- * network layer with a request for incoming data while
- * waiting for the uSockReceiveFrom() or uSockRead().
- * This also represents the minimum time these calls will
- * take in the non-blocking case.
- */
-# define U_SOCK_RECEIVE_POLL_INTERVAL_MS 100
+/** A blocking uSockReceiveFrom() or uSockRead(), or a
+ * uSockSelect(), waits for the underlying network layer to
+ * indicate that data has arrived, so data is returned as soon
+ * as it arrives; this is the longest that it will wait for such
+ * an indication before asking the underlying network layer
+ * anyway, a safety net in case an indication is missed.
+ */
+# define U_SOCK_RECEIVE_POLL_INTERVAL_MS 1000
 #endif
 
 #ifndef U_SOCK_CLOSE_TIMEOUT_SECONDS
@@ -285,10 +288,10 @@ extern "C" {
 
 /** Determine if the bit corresponding to a given file descriptor is set.
  */
-#define U_SOCK_FD_ISSET(d, pSet) if (((d) >= 0) &&                           \
-                                     ((d) < U_SOCK_DESCRIPTOR_SET_SIZE)) {   \
-                                     (*(pSet))[(d) / 8] & (1 << ((d) & 7));  \
-                                 }
+#define U_SOCK_FD_ISSET(d, pSet) ((((d) >= 0) &&                                   \
+                                   ((d) < U_SOCK_DESCRIPTOR_SET_SIZE)) ?          \
+                                  (((*(pSet))[(d) / 8] & (1 << ((d) & 7))) != 0) : \
+                                  false)
 
 /* ----------------------------------------------------------------
  * TYPES
@@ -403,6 +406,9 @@ int32_t uSockConnect(uSockDescriptor_t descriptor,
  * call-back using uSockRegisterCallbackClosed() before calling
  * uSockClose().  Also note that closing the socket does NOT
  * free the memory it occupied, see uSockCleanUp() for that.
+ * A socket that has been closed by the remote host must still
+ * be closed with this function: until then its descriptor
+ * is not re-used.
  *
  * @param descriptor the descriptor of the socket to be closed.
  * @return           zero on success else negative error code
@@ -413,15 +419,18 @@ int32_t uSockClose(uSockDescriptor_t descriptor);
 
 /** In order to maintain thread-safe operation, when a socket is
  * closed, either locally or by the remote host, it is only marked
- * as closed and the memory is retained, since some other thread
- * may be refering to it.  You should call this clean-up function
- * when you are sure that there is no socket activity, either
- * locally or from the remote host, in order to free memory
- * allocated for sockets.  A socket that is closed locally but
- * waiting for the far end to close WILL be cleaned-up by this
- * function and so no callback registered by
- * uSockRegisterCallbackClosed() will be triggered when the
- * remote server finally closes the connection.
+ * as closed, since some other thread may be refering to it; the
+ * descriptor of a socket that is fully closed, and on which
+ * uSockClose() has been called, may be re-used by uSockCreate().
+ * You should call this clean-up function when you are sure that
+ * there is no socket activity, either locally or from the remote
+ * host, in order to free the descriptors of sockets that are
+ * still closing and any resources held by the underlying socket
+ * layer.  A socket that is closed locally but waiting for the
+ * far end to close WILL be cleaned-up by this function and so
+ * no callback registered by uSockRegisterCallbackClosed() will
+ * be triggered when the remote server finally closes the
+ * connection.
  */
 void uSockCleanUp();
 
@@ -704,6 +713,21 @@ int32_t uSockAccept(uSockDescriptor_t descriptor,
                     uSockAddress_t *pRemoteAddress);
 
 /** Select: wait for one of a set of sockets to become unblocked.
+ * The wait is event-driven: the calling task sleeps until the
+ * underlying network layer indicates that data has arrived on,
+ * or that the far end has closed, one of the sockets.
+ *
+ * A socket is readable if data may have arrived for it since it
+ * was last read from: as is usual, a read may occasionally find
+ * nothing, hence sockets that are being selected on are best
+ * set to be non-blocking with uSockBlockingSet().  A socket is
+ * writable if it is connected (or is a UDP socket).  A socket
+ * that no longer exists (e.g. because it has been closed by the
+ * far end) is readable, writable and exceptional, since an
+ * operation on it will not block but will return an error.
+ *
+ * Descriptors are allocated lowest first, as for POSIX, so
+ * any open socket will fit into a #uSockDescriptorSet_t.
  *
  * @param maxDescriptor         the highest numbered descriptor in the
  *                              sets that follow to select on + 1.
@@ -716,9 +740,11 @@ int32_t uSockAccept(uSockDescriptor_t descriptor,
  * @param pExceptDescriptorSet  the set of descriptors to check for
  *                              exceptional conditions. May be NULL.
  * @param timeMs                the timeout for the select operation
- *                              in milliseconds.
- * @return                      a positive value if an unblock
- *                              occurred, zero on timeout, negative
+ *                              in milliseconds; zero to poll,
+ *                              negative to wait indefinitely.
+ * @return                      the number of descriptors that are
+ *                              set, across all of the descriptor sets,
+ *                              on return, zero on timeout, negative
  *                              on any other error.  Use
  *                              #U_SOCK_FD_ISSET() to determine
  *                              which descriptor(s) were unblocked.
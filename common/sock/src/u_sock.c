@@ -345,23 +345,11 @@
  * COMPILE-TIME MACROS
  * -------------------------------------------------------------- */
 
-#ifndef U_SOCK_NUM_STATIC_SOCKETS
-/** The number of statically allocated sockets.  When
- * more than this number of sockets are required to
- * be open simultaneously they will be allocated and
- * it is up to the user to call uSockCleanUp()
- * to release the memory occupied by closed allocated
- * sockets when done.
+/** The number of buckets in the hash table used to find the
+ * socket container for a network handle and socket handle;
+ * one per socket keeps the chains short.
  */
-# define U_SOCK_NUM_STATIC_SOCKETS     7
-#endif
-
-/** Increment a socket descriptor.
- */
-#define U_SOCK_INC_DESCRIPTOR(d)  (d)++;         \
-                                  if ((d) < 0) { \
-                                      d = 0;     \
-                                  }
+#define U_SOCK_HASH_TABLE_SIZE U_SOCK_MAX_NUM_SOCKETS
 
 /* ----------------------------------------------------------------
  * TYPES
@@ -379,8 +367,10 @@ typedef enum {
     U_SOCK_STATE_CLOSING, /**< Block all reads and writes, waiting
                                for far end to complete closure, can be
                                tidied up. */
-    U_SOCK_STATE_CLOSED   /**< Actually closed, cannot be found,
-                               container may be re-used. */
+    U_SOCK_STATE_CLOSED,  /**< Actually closed, cannot be found,
+                               but the descriptor remains reserved
+                               until uSockClose() is called on it. */
+    U_SOCK_STATE_FREE     /**< Not in use, container may be re-used. */
 } uSockState_t;
 
 /** A socket.
@@ -404,18 +394,31 @@ typedef struct {
     void (*pClosedCallback) (void *);
     void *pClosedCallbackParameter;
     bool blocking; // At end to optimise structure packing
+    bool dataReady; /**< set by dataCallback(), cleared when
+                         a receive is attempted. */
 } uSockSocket_t;
 
-/** A socket container.
+/** A socket container: the descriptor of the socket is the
+ * index of its container in gContainers[].
  */
-typedef struct uSockContainer_t {
-    struct uSockContainer_t *pPrevious;
-    uSockDescriptor_t descriptor;
+typedef struct {
+    uPortMutexHandle_t mutex; /**< Held while the socket is being
+                                   operated on. */
     uSockSocket_t socket;
-    struct uSockContainer_t *pNext;
-    bool isStatic; // At end to optimise structure packing
+    int32_t hashNext; /**< The index of the next container in the
+                           same hash table bucket, -1 if there is
+                           none. */
+    bool inHashTable; // At end to optimise structure packing
 } uSockContainer_t;
 
+/** A task waiting, in uSockSelect() or in a blocking receive,
+ * for something to happen on a socket.
+ */
+typedef struct uSockWaiter_t {
+    uPortSemaphoreHandle_t semaphore;
+    struct uSockWaiter_t *pNext;
+} uSockWaiter_t;
+
 /* ----------------------------------------------------------------
  * VARIABLES
  * -------------------------------------------------------------- */
@@ -424,7 +427,9 @@ typedef struct uSockContainer_t {
  */
 static bool gInitialised = false;
 
-/** Mutex to protect the container list.
+/** Mutex to protect the allocation of containers and the
+ * hash table; the contents of each container are protected
+ * by the mutex of that container.
  */
 static uPortMutexHandle_t gMutexContainer = NULL;
 
@@ -432,17 +437,21 @@ static uPortMutexHandle_t gMutexContainer = NULL;
  */
 static uPortMutexHandle_t gMutexCallbacks = NULL;
 
-/** Root of the socket container list.
+/** The socket containers, indexed by descriptor.
  */
-static uSockContainer_t *gpContainerListHead = NULL;
+static uSockContainer_t gContainers[U_SOCK_MAX_NUM_SOCKETS];
 
-/** The next descriptor to use.
+/** Hash table to find the container for a network handle and
+ * socket handle, as required by the callbacks from the
+ * underlying cell/wifi socket layer: each entry is the index
+ * of the first container in that bucket, -1 if there is none.
  */
-static uSockDescriptor_t gNextDescriptor = 0;
+static int32_t gHashTable[U_SOCK_HASH_TABLE_SIZE];
 
-/** Containers for statically allocated sockets.
+/** Root of the list of tasks waiting for something to happen
+ * on a socket, protected by gMutexCallbacks.
  */
-static uSockContainer_t gStaticContainers[U_SOCK_NUM_STATIC_SOCKETS];
+static uSockWaiter_t *gpWaiterListHead = NULL;
 
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS: MISC
@@ -454,9 +463,6 @@ static int32_t init()
     int32_t errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
     int32_t errnoLocal = U_SOCK_ENOMEM;
     int32_t errnoLocalCell;
-    uSockContainer_t **ppContainer = &gpContainerListHead;
-    uSockContainer_t *pTmp = NULL;
-    uSockContainer_t **ppPreviousNext = NULL;
 
     // The mutexes are set up once only
     if (gMutexContainer == NULL) {
@@ -465,6 +471,12 @@ static int32_t init()
     if ((errorCode == 0) && (gMutexCallbacks == NULL)) {
         errorCode = uPortMutexCreate(&gMutexCallbacks);
     }
+    for (size_t x = 0; (x < sizeof(gContainers) / sizeof(gContainers[0])) &&
+         (errorCode == 0); x++) {
+        if (gContainers[x].mutex == NULL) {
+            errorCode = uPortMutexCreate(&(gContainers[x].mutex));
+        }
+    }
 
     if (errorCode == 0) {
         errnoLocal = U_SOCK_ENONE;
@@ -484,20 +496,17 @@ static int32_t init()
             }
 
             if (errnoLocal == U_SOCK_ENONE) {
-                //  Link the static containers into the start of the container list
-                for (size_t x = 0; x < sizeof(gStaticContainers) /
-                     sizeof(gStaticContainers[0]); x++) {
-                    *ppContainer = &gStaticContainers[x];
-                    (*ppContainer)->isStatic = true;
-                    (*ppContainer)->socket.state = U_SOCK_STATE_CLOSED;
-                    (*ppContainer)->pNext = NULL;
-                    if (ppPreviousNext != NULL) {
-                        *ppPreviousNext = *ppContainer;
-                    }
-                    ppPreviousNext = &((*ppContainer)->pNext);
-                    (*ppContainer)->pPrevious = pTmp;
-                    pTmp = *ppContainer;
-                    ppContainer = &((*ppContainer)->pNext);
+                // Empty the containers and the hash table
+                for (size_t x = 0; x < sizeof(gContainers) /
+                     sizeof(gContainers[0]); x++) {
+                    gContainers[x].socket.devHandle = NULL;
+                    gContainers[x].socket.state = U_SOCK_STATE_FREE;
+                    gContainers[x].hashNext = -1;
+                    gContainers[x].inHashTable = false;
+                }
+                for (size_t x = 0; x < sizeof(gHashTable) /
+                     sizeof(gHashTable[0]); x++) {
+                    gHashTable[x] = -1;
                 }
 
                 gInitialised = true;
@@ -531,104 +540,175 @@ static void deinitButNotMutex()
  * STATIC FUNCTIONS: CONTAINER STUFF
  * -------------------------------------------------------------- */
 
-// Find the socket container for the given descriptor.
-// Will not find sockets in state CLOSED.
-// This does NOT lock the mutex, you need to do that.
+// Return true if the socket in a container is open, i.e. not
+// CLOSED or FREE.
+static bool containerIsOpen(const uSockContainer_t *pContainer)
+{
+    return (pContainer->socket.state != U_SOCK_STATE_CLOSED) &&
+           (pContainer->socket.state != U_SOCK_STATE_FREE);
+}
+
+// Find the socket container for the given descriptor without
+// locking it, for when only a peek at the contents is required.
+// Will not find sockets in state CLOSED or FREE.
 static uSockContainer_t *pContainerFindByDescriptor(uSockDescriptor_t descriptor)
 {
     uSockContainer_t *pContainer = NULL;
-    uSockContainer_t *pContainerThis = gpContainerListHead;
 
-    while ((pContainerThis != NULL) &&
-           (pContainer == NULL)) {
-        if ((pContainerThis->descriptor == descriptor) &&
-            (pContainerThis->socket.state != U_SOCK_STATE_CLOSED)) {
-            pContainer = pContainerThis;
+    if ((descriptor >= 0) &&
+        (descriptor < (int32_t) (sizeof(gContainers) / sizeof(gContainers[0]))) &&
+        containerIsOpen(&(gContainers[descriptor]))) {
+        pContainer = &(gContainers[descriptor]);
+    }
+
+    return pContainer;
+}
+
+// Find the socket container for the given descriptor and lock
+// it; if a container is returned it must be unlocked with
+// containerUnlock().  Will not find sockets in state FREE and,
+// unless includeClosed is true, will not find sockets in state
+// CLOSED.
+static uSockContainer_t *pContainerLock(uSockDescriptor_t descriptor,
+                                        bool includeClosed)
+{
+    uSockContainer_t *pContainer = NULL;
+
+    if ((descriptor >= 0) &&
+        (descriptor < (int32_t) (sizeof(gContainers) / sizeof(gContainers[0])))) {
+        pContainer = &(gContainers[descriptor]);
+        uPortMutexLock(pContainer->mutex);
+        if ((pContainer->socket.state == U_SOCK_STATE_FREE) ||
+            (!includeClosed && (pContainer->socket.state == U_SOCK_STATE_CLOSED))) {
+            uPortMutexUnlock(pContainer->mutex);
+            pContainer = NULL;
         }
-        pContainerThis = pContainerThis->pNext;
     }
 
     return pContainer;
 }
 
-// Find the socket container for the given network handle
-// and socket handle.  If sockHandle is less than zero,
-// returns the first entry for the given devHandle.
-// Will not find sockets in state CLOSED.
+// Unlock a socket container returned by pContainerLock(),
+// which may be NULL.
+static void containerUnlock(const uSockContainer_t *pContainer)
+{
+    if (pContainer != NULL) {
+        uPortMutexUnlock(pContainer->mutex);
+    }
+}
+
+// Get the hash table bucket for the given socket handle.
+static size_t hashBucket(int32_t sockHandle)
+{
+    return (size_t) (((uint32_t) sockHandle) % U_SOCK_HASH_TABLE_SIZE);
+}
+
+// Add a container to the hash table, using the network
+// handle and socket handle of its socket.
+// This does NOT lock the mutex, you need to do that.
+static void hashAdd(uSockContainer_t *pContainer)
+{
+    size_t bucket = hashBucket(pContainer->socket.sockHandle);
+
+    if (!pContainer->inHashTable) {
+        // Link the container in fully before putting it
+        // at the head of the bucket so that the callbacks,
+        // which don't lock the mutex, see a good chain
+        pContainer->hashNext = gHashTable[bucket];
+        pContainer->inHashTable = true;
+        gHashTable[bucket] = (int32_t) (pContainer - gContainers);
+    }
+}
+
+// Remove a container from the hash table.
 // This does NOT lock the mutex, you need to do that.
+static void hashRemove(uSockContainer_t *pContainer)
+{
+    int32_t *pIndex;
+
+    if (pContainer->inHashTable) {
+        pIndex = &(gHashTable[hashBucket(pContainer->socket.sockHandle)]);
+        while ((*pIndex >= 0) && (&(gContainers[*pIndex]) != pContainer)) {
+            pIndex = &(gContainers[*pIndex].hashNext);
+        }
+        if (*pIndex >= 0) {
+            *pIndex = pContainer->hashNext;
+        }
+        pContainer->hashNext = -1;
+        pContainer->inHashTable = false;
+    }
+}
+
+// Find the socket container for the given network handle
+// and socket handle.
+// Will not find sockets in state CLOSED or FREE.
+// This does NOT lock the mutex: it is called from the callbacks
+// of the underlying cell/wifi socket layer, which may happen
+// while an operation on the socket is in progress.
 static uSockContainer_t *pContainerFindByDeviceHandle(uDeviceHandle_t devHandle,
                                                       int32_t sockHandle)
 {
     uSockContainer_t *pContainer = NULL;
-    uSockContainer_t *pContainerThis = gpContainerListHead;
-
-    while ((pContainerThis != NULL) &&
-           (pContainer == NULL)) {
-        if ((pContainerThis->socket.devHandle == devHandle) &&
-            ((pContainerThis->socket.sockHandle == sockHandle) ||
-             (pContainerThis->socket.sockHandle < 0)) &&
-            (pContainerThis->socket.state != U_SOCK_STATE_CLOSED)) {
-            pContainer = pContainerThis;
+    int32_t index = -1;
+
+    if (sockHandle >= 0) {
+        index = gHashTable[hashBucket(sockHandle)];
+    }
+    while ((index >= 0) && (pContainer == NULL)) {
+        if ((gContainers[index].socket.devHandle == devHandle) &&
+            (gContainers[index].socket.sockHandle == sockHandle) &&
+            containerIsOpen(&(gContainers[index]))) {
+            pContainer = &(gContainers[index]);
         }
-        pContainerThis = pContainerThis->pNext;
+        index = gContainers[index].hashNext;
     }
 
     return pContainer;
 }
 
-// Determine the number of non-closed sockets.
+// Determine whether there are any open sockets on
+// the given network handle.
 // This does NOT lock the mutex, you need to do that.
-static size_t numContainersInUse()
+static bool deviceHasSockets(uDeviceHandle_t devHandle)
 {
-    uSockContainer_t *pContainer = gpContainerListHead;
-    size_t numInUse = 0;
+    bool hasSockets = false;
 
-    while (pContainer != NULL) {
-        if (pContainer->socket.state != U_SOCK_STATE_CLOSED) {
-            numInUse++;
-        }
-        pContainer = pContainer->pNext;
+    for (size_t x = 0; (x < sizeof(gContainers) / sizeof(gContainers[0])) &&
+         !hasSockets; x++) {
+        hasSockets = (gContainers[x].socket.devHandle == devHandle) &&
+                     containerIsOpen(&(gContainers[x]));
     }
 
-    return numInUse;
+    return hasSockets;
 }
 
-// Create a socket in a container with the given descriptor.
-// This does NOT lock the mutex, you need to do that.
-static uSockContainer_t *pSockContainerCreate(uSockDescriptor_t descriptor,
-                                              uSockType_t type,
+// Create a socket in the free container with the lowest
+// descriptor, as POSIX does, which keeps descriptors within the
+// size of a uSockDescriptorSet_t for uSockSelect().  A container
+// only becomes free once uSockClose() has been called on its
+// descriptor, so a descriptor that the application still holds
+// is never handed out again.  The container is returned locked:
+// unlock it with containerUnlock().
+// This does NOT lock gMutexContainer, you need to do that.
+static uSockContainer_t *pSockContainerCreate(uSockType_t type,
                                               uSockProtocol_t protocol)
 {
     uSockContainer_t *pContainer = NULL;
-    uSockContainer_t *pContainerPrevious = NULL;
-    uSockContainer_t **ppContainerThis = &gpContainerListHead;
-
-    // Traverse the list, stopping if there is a container
-    // that holds a closed socket, which we could re-use
-    while ((*ppContainerThis != NULL) && (pContainer == NULL)) {
-        if ((*ppContainerThis)->socket.state == U_SOCK_STATE_CLOSED) {
-            pContainer = *ppContainerThis;
-        }
-        pContainerPrevious = *ppContainerThis;
-        ppContainerThis = &((*ppContainerThis)->pNext);
-    }
 
-    if (pContainer == NULL) {
-        // Reached the end of the list and found no re-usable
-        // containers, so allocate memory for the new container
-        // and add it to the list
-        pContainer = (uSockContainer_t *) pUPortMalloc(sizeof (*pContainer));
-        if (pContainer != NULL) {
-            pContainer->isStatic = false;
-            pContainer->pPrevious = pContainerPrevious;
-            pContainer->pNext = NULL;
-            *ppContainerThis = pContainer;
+    for (size_t x = 0; (x < sizeof(gContainers) / sizeof(gContainers[0])) &&
+         (pContainer == NULL); x++) {
+        if (gContainers[x].socket.state == U_SOCK_STATE_FREE) {
+            pContainer = &(gContainers[x]);
         }
     }
 
-    // Set up the new container and socket
+    // Set up the container and socket
     if (pContainer != NULL) {
-        pContainer->descriptor = descriptor;
+        // Locking the container means that we wait for
+        // anyone who was still operating on the socket
+        // that was in it before it was closed
+        uPortMutexLock(pContainer->mutex);
+        hashRemove(pContainer);
         memset(&(pContainer->socket), 0, sizeof(pContainer->socket));
         pContainer->socket.type = type;
         pContainer->socket.protocol = protocol;
@@ -647,47 +727,72 @@ static uSockContainer_t *pSockContainerCreate(uSockDescriptor_t descriptor,
     return pContainer;
 }
 
-// Free the container corresponding to the descriptor.
-// Has no effect on static containers.
+// Free a container, making it available for re-use.
 // This does NOT lock the mutex, you need to do that.
-static bool containerFree(uSockDescriptor_t descriptor)
+static void containerFree(uSockContainer_t *pContainer)
 {
-    uSockContainer_t **ppContainer = NULL;
-    uSockContainer_t **ppContainerThis = &gpContainerListHead;
-    bool success = false;
-
-    while ((*ppContainerThis != NULL) &&
-           (ppContainer == NULL)) {
-        if ((*ppContainerThis)->descriptor == descriptor) {
-            ppContainer = ppContainerThis;
-        } else {
-            ppContainerThis = &((*ppContainerThis)->pNext);
-        }
+    hashRemove(pContainer);
+    pContainer->socket.devHandle = NULL;
+    pContainer->socket.state = U_SOCK_STATE_FREE;
+}
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS: WAITING
+ * -------------------------------------------------------------- */
+
+// Add a waiter to the list.
+static int32_t waiterAdd(uSockWaiter_t *pWaiter)
+{
+    int32_t errnoLocal = U_SOCK_ENOMEM;
+
+    if (uPortSemaphoreCreate(&(pWaiter->semaphore), 0, 1) == 0) {
+        U_PORT_MUTEX_LOCK(gMutexCallbacks);
+        pWaiter->pNext = gpWaiterListHead;
+        gpWaiterListHead = pWaiter;
+        U_PORT_MUTEX_UNLOCK(gMutexCallbacks);
+        errnoLocal = U_SOCK_ENONE;
     }
 
-    if ((ppContainer != NULL) && (*ppContainer != NULL)) {
-        if (!(*ppContainer)->isStatic) {
-            // If we found it, and it wasn't static, free it
-            // If there is a previous container, move its pNext
-            if ((*ppContainer)->pPrevious != NULL) {
-                (*ppContainer)->pPrevious->pNext = (*ppContainer)->pNext;
-            }
-            // If there is a next container, move its pPrevious
-            if ((*ppContainer)->pNext != NULL) {
-                (*ppContainer)->pNext->pPrevious = (*ppContainer)->pPrevious;
-            }
+    return errnoLocal;
+}
 
-            // Free the memory and NULL the pointer
-            uPortFree(*ppContainer);
-            *ppContainer = NULL;
-        } else {
-            // Nothing to do for a static container,
-        }
+// Remove a waiter from the list.
+static void waiterRemove(uSockWaiter_t *pWaiter)
+{
+    uSockWaiter_t **ppWaiter = &gpWaiterListHead;
 
-        success = true;
+    U_PORT_MUTEX_LOCK(gMutexCallbacks);
+    while ((*ppWaiter != NULL) && (*ppWaiter != pWaiter)) {
+        ppWaiter = &((*ppWaiter)->pNext);
     }
+    if (*ppWaiter != NULL) {
+        *ppWaiter = pWaiter->pNext;
+    }
+    U_PORT_MUTEX_UNLOCK(gMutexCallbacks);
+    uPortSemaphoreDelete(pWaiter->semaphore);
+}
 
-    return success;
+// Wait for something to happen on a socket, up to timeMs or
+// until the poll interval has passed, whichever is the sooner.
+static void waiterWait(const uSockWaiter_t *pWaiter, int32_t timeMs)
+{
+    if (timeMs > U_SOCK_RECEIVE_POLL_INTERVAL_MS) {
+        timeMs = U_SOCK_RECEIVE_POLL_INTERVAL_MS;
+    }
+    if (timeMs > 0) {
+        uPortSemaphoreTryTake(pWaiter->semaphore, timeMs);
+    }
+}
+
+// Wake up all waiters, who will check for themselves whether
+// what has happened is of interest.
+// gMutexCallbacks should be locked before this is called.
+static void waitersSignal(void)
+{
+    for (uSockWaiter_t *pWaiter = gpWaiterListHead; pWaiter != NULL;
+         pWaiter = pWaiter->pNext) {
+        uPortSemaphoreGive(pWaiter->semaphore);
+    }
 }
 
 /* ----------------------------------------------------------------
@@ -701,6 +806,7 @@ static void closedCallback(uDeviceHandle_t devHandle,
                            int32_t sockHandle)
 {
     uSockContainer_t *pContainer;
+    bool closing;
 
     // Don't lock the container mutex here as this
     // needs to be callable while a send or receive is
@@ -708,6 +814,7 @@ static void closedCallback(uDeviceHandle_t devHandle,
     pContainer = pContainerFindByDeviceHandle(devHandle,
                                               sockHandle);
     if (pContainer != NULL) {
+        closing = (pContainer->socket.state == U_SOCK_STATE_CLOSING);
         // Mark the container as closed
         pContainer->socket.state = U_SOCK_STATE_CLOSED;
         U_PORT_MUTEX_LOCK(gMutexCallbacks);
@@ -719,7 +826,14 @@ static void closedCallback(uDeviceHandle_t devHandle,
         // context
         uSecurityTlsRemove(pContainer->socket.pSecurityContext);
         pContainer->socket.pSecurityContext = NULL;
+        waitersSignal();
         U_PORT_MUTEX_UNLOCK(gMutexCallbacks);
+        if (closing) {
+            // uSockClose() has already been called so the
+            // container may now be re-used; it is left in the
+            // hash table, that is tidied up on re-use
+            pContainer->socket.state = U_SOCK_STATE_FREE;
+        }
     }
 }
 
@@ -737,6 +851,8 @@ static void dataCallback(uDeviceHandle_t devHandle,
                                               sockHandle);
     if (pContainer != NULL) {
         U_PORT_MUTEX_LOCK(gMutexCallbacks);
+        pContainer->socket.dataReady = true;
+        waitersSignal();
         if (pContainer->socket.pDataCallback != NULL) {
             pContainer->socket.pDataCallback(pContainer->socket.pDataCallbackParameter);
         }
@@ -1066,7 +1182,7 @@ static void printSocketOption(const void *pOptionValue,
  * -------------------------------------------------------------- */
 
 // Receive data on a socket, either UDP or TCP.
-static int32_t receive(const uSockContainer_t *pContainer,
+static int32_t receive(uSockContainer_t *pContainer,
                        uSockAddress_t *pRemoteAddress,
                        void *pData, size_t dataSizeBytes)
 {
@@ -1075,10 +1191,16 @@ static int32_t receive(const uSockContainer_t *pContainer,
     int32_t negErrnoOrSize = -U_SOCK_ENOSYS;
     int32_t startTimeMs = uPortGetTickTimeMs();
     int32_t devType = uDeviceGetDeviceType(devHandle);
+    uSockWaiter_t waiter;
+    bool waiterAdded = false;
 
     // Run around the loop until a packet of data turns up
     // or we time out or just once if we're non-blocking.
     do {
+        // Clear the data ready flag before trying to receive
+        // so that an indication arriving while we are doing so
+        // is not lost
+        pContainer->socket.dataReady = false;
         if (pContainer->socket.protocol == U_SOCK_PROTOCOL_UDP) {
             // UDP style
             if (devType == (int32_t) U_DEVICE_TYPE_CELL) {
@@ -1108,18 +1230,105 @@ static int32_t receive(const uSockContainer_t *pContainer,
                                                dataSizeBytes);
             }
         }
-        if (negErrnoOrSize < 0) {
-            // Yield for the poll interval
-            uPortTaskBlock(U_SOCK_RECEIVE_POLL_INTERVAL_MS);
+        if (negErrnoOrSize >= 0) {
+            // Got something: there may be more, unless this was
+            // a TCP read that did not fill the buffer
+            if ((pContainer->socket.protocol == U_SOCK_PROTOCOL_UDP) ||
+                (negErrnoOrSize == (int32_t) dataSizeBytes)) {
+                pContainer->socket.dataReady = true;
+            }
+        } else if (pContainer->socket.blocking) {
+            if (!waiterAdded) {
+                // Add ourselves as a waiter and go around
+                // again in case data arrived before we did so;
+                // if there is no room for a waiter we just end
+                // up polling
+                waiterAdded = (waiterAdd(&waiter) == U_SOCK_ENONE);
+            }
+            if (waiterAdded && !pContainer->socket.dataReady) {
+                // Wait for something to happen
+                waiterWait(&waiter, (int32_t) (pContainer->socket.receiveTimeoutMs -
+                                               (uPortGetTickTimeMs() - startTimeMs)));
+            } else if (!waiterAdded) {
+                uPortTaskBlock(U_SOCK_RECEIVE_POLL_INTERVAL_MS);
+            }
         }
     } while ((negErrnoOrSize < 0) &&
              (pContainer->socket.blocking) &&
              (uPortGetTickTimeMs() - startTimeMs <
               pContainer->socket.receiveTimeoutMs));
 
+    if (waiterAdded) {
+        waiterRemove(&waiter);
+    }
+
     return negErrnoOrSize;
 }
 
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS: SELECT
+ * -------------------------------------------------------------- */
+
+// Check which of the descriptors in the given sets, up to
+// maxDescriptor, are unblocked, writing the result to the
+// "out" sets and returning the number of bits set.
+// This does NOT lock the mutex, you need to do that.
+static int32_t selectCheck(int32_t maxDescriptor,
+                           const uSockDescriptorSet_t *pReadDescriptorSet,
+                           const uSockDescriptorSet_t *pWriteDescriptorSet,
+                           const uSockDescriptorSet_t *pExceptDescriptorSet,
+                           uSockDescriptorSet_t *pReadOut,
+                           uSockDescriptorSet_t *pWriteOut,
+                           uSockDescriptorSet_t *pExceptOut)
+{
+    int32_t count = 0;
+    const uSockContainer_t *pContainer;
+    bool read;
+    bool write;
+    bool except;
+
+    U_SOCK_FD_ZERO(pReadOut);
+    U_SOCK_FD_ZERO(pWriteOut);
+    U_SOCK_FD_ZERO(pExceptOut);
+    for (int32_t d = 0; d < maxDescriptor; d++) {
+        read = (pReadDescriptorSet != NULL) && U_SOCK_FD_ISSET(d, pReadDescriptorSet);
+        write = (pWriteDescriptorSet != NULL) && U_SOCK_FD_ISSET(d, pWriteDescriptorSet);
+        except = (pExceptDescriptorSet != NULL) && U_SOCK_FD_ISSET(d, pExceptDescriptorSet);
+        if (read || write || except) {
+            pContainer = pContainerFindByDescriptor(d);
+            if ((pContainer != NULL) &&
+                (pContainer->socket.state != U_SOCK_STATE_CLOSING)) {
+                // A read is unblocked if there may be data or
+                // if it is going to fail anyway
+                read = read && (pContainer->socket.dataReady ||
+                                (pContainer->socket.state == U_SOCK_STATE_SHUTDOWN_FOR_READ) ||
+                                (pContainer->socket.state == U_SOCK_STATE_SHUTDOWN_FOR_READ_WRITE));
+                // A write is unblocked unless this is a TCP
+                // socket that is yet to be connected
+                write = write && ((pContainer->socket.protocol == U_SOCK_PROTOCOL_UDP) ||
+                                  (pContainer->socket.state != U_SOCK_STATE_CREATED));
+                except = false;
+            }
+            // Anything else, i.e. a socket that has gone, is
+            // unblocked for everything
+            if (read) {
+                U_SOCK_FD_SET(d, pReadOut);
+                count++;
+            }
+            if (write) {
+                U_SOCK_FD_SET(d, pWriteOut);
+                count++;
+            }
+            if (except) {
+                U_SOCK_FD_SET(d, pExceptOut);
+                count++;
+            }
+        }
+    }
+
+    return count;
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS: CREATE/OPEN/CLOSE/CLEAN-UP
  * -------------------------------------------------------------- */
@@ -1131,7 +1340,6 @@ int32_t uSockCreate(uDeviceHandle_t devHandle, uSockType_t type,
     int32_t descriptorOrError = (int32_t) U_ERROR_COMMON_SUCCESS;
     int32_t errnoLocal;
     uSockContainer_t *pContainer = NULL;
-    uSockDescriptor_t descriptor = gNextDescriptor;
     int32_t sockHandle = -U_SOCK_ENOSYS;
 
     errnoLocal = init();
@@ -1152,85 +1360,89 @@ int32_t uSockCreate(uDeviceHandle_t devHandle, uSockType_t type,
         U_PORT_MUTEX_LOCK(gMutexContainer);
 
         errnoLocal = U_SOCK_ENOBUFS;
-        if (numContainersInUse() < U_SOCK_MAX_NUM_SOCKETS) {
-            // Find the next free descriptor
-            descriptorOrError = (int32_t) U_ERROR_COMMON_BSD_ERROR;
-            while (descriptorOrError < 0) {
-                // Try the descriptor value, making sure
-                // each time that it can't be found.
-                if (pContainerFindByDescriptor(descriptor) == NULL) {
-                    gNextDescriptor = descriptor;
-                    U_SOCK_INC_DESCRIPTOR(gNextDescriptor);
-                    // Found a free descriptor, now try to
-                    // create the socket in a container
-                    pContainer = pSockContainerCreate(descriptor,
-                                                      type, protocol);
-                    if (pContainer != NULL) {
-                        descriptorOrError = (int32_t) descriptor;
-                    } else {
-                        errnoLocal = U_SOCK_ENOMEM;
-                        uPortLog("U_SOCK: unable to allocate memory"
-                                 " for socket.\n");
-                        // Exit stage left
-                        break;
-                    }
-                }
-                U_SOCK_INC_DESCRIPTOR(descriptor);
-            }
-
-            if ((descriptorOrError >= 0) && (pContainer != NULL)) {
-                int32_t devType = uDeviceGetDeviceType(devHandle);
+        // Find a free container, which is returned locked
+        pContainer = pSockContainerCreate(type, protocol);
+        if (pContainer != NULL) {
+            // The descriptor is the index of the container
+            descriptorOrError = (int32_t) (pContainer - gContainers);
+            int32_t devType = uDeviceGetDeviceType(devHandle);
+            errnoLocal = U_SOCK_ENONE;
+            if (!deviceHasSockets(devHandle)) {
                 errnoLocal = U_SOCK_ENOSYS;
-                if (pContainerFindByDeviceHandle(devHandle, -1) == NULL) {
-                    // If this is the first time we have
-                    // encountered this network layer,
-                    // ask the underlying cell/wifi sockets
-                    // layer to initialise it
-                    if (devType == (int32_t) U_DEVICE_TYPE_CELL) {
-                        errnoLocal = -uCellSockInitInstance(devHandle);
-                    } else if (devType == (int32_t) U_DEVICE_TYPE_SHORT_RANGE) {
-                        errnoLocal = -uWifiSockInitInstance(devHandle);
-                    }
+                // If this is the first time we have
+                // encountered this network layer,
+                // ask the underlying cell/wifi sockets
+                // layer to initialise it
+                if (devType == (int32_t) U_DEVICE_TYPE_CELL) {
+                    errnoLocal = -uCellSockInitInstance(devHandle);
+                } else if (devType == (int32_t) U_DEVICE_TYPE_SHORT_RANGE) {
+                    errnoLocal = -uWifiSockInitInstance(devHandle);
                 }
-                // Get the underlying cell/wifi socket layer to
-                // create the socket there. uXxxSockCreate() returns
-                // a socket handle or a negated value of errno from
-                // the U_SOCK_Exxx list
-                if (errnoLocal == 0) {
-                    if (devType == (int32_t) U_DEVICE_TYPE_CELL) {
-                        sockHandle = uCellSockCreate(devHandle,
-                                                     type, protocol);
-                        // Setting non-blocking so that
-                        // we do the blocking here instead.
-                        // Since this has no return value
-                        // we can do it at the same time
-                        uCellSockBlockingSet(devHandle,
-                                             sockHandle, false);
-                    } else if (devType == (int32_t) U_DEVICE_TYPE_SHORT_RANGE) {
-                        sockHandle = uWifiSockCreate(devHandle,
-                                                     type, protocol);
-                        // TODO: Set blocking stuff
+            }
+            // Get the underlying cell/wifi socket layer to
+            // create the socket there. uXxxSockCreate() returns
+            // a socket handle or a negated value of errno from
+            // the U_SOCK_Exxx list
+            if (errnoLocal == 0) {
+                if (devType == (int32_t) U_DEVICE_TYPE_CELL) {
+                    sockHandle = uCellSockCreate(devHandle,
+                                                 type, protocol);
+                    // Setting non-blocking so that
+                    // we do the blocking here instead.
+                    // Since this has no return value
+                    // we can do it at the same time
+                    uCellSockBlockingSet(devHandle,
+                                         sockHandle, false);
+                    if (sockHandle >= 0) {
+                        // Always have the data and closed callbacks
+                        // so that waiting for data is event-driven
+                        // and a waiter finds out about closure,
+                        // whatever the application has registered
+                        uCellSockRegisterCallbackData(devHandle,
+                                                      sockHandle,
+                                                      dataCallback);
+                        uCellSockRegisterCallbackClosed(devHandle,
+                                                        sockHandle,
+                                                        closedCallback);
                     }
-
+                } else if (devType == (int32_t) U_DEVICE_TYPE_SHORT_RANGE) {
+                    sockHandle = uWifiSockCreate(devHandle,
+                                                 type, protocol);
+                    // TODO: Set blocking stuff
                     if (sockHandle >= 0) {
-                        // All is good, no need to set descriptorOrError
-                        // as it was already set above
-                        pContainer->socket.sockHandle = sockHandle;
-                        pContainer->socket.devHandle = devHandle;
-                        pContainer->socket.bytesSent = 0;
-                        uPortLog("U_SOCK: socket created, descriptor %d,"
-                                 " network handle 0x%08x, socket handle %d.\n",
-                                 descriptorOrError, devHandle, sockHandle);
-                    } else {
-                        // Set errno
-                        errnoLocal = -sockHandle;
-                        // Free the container once more
-                        containerFree(descriptorOrError);
-                        uPortLog("U_SOCK: underlying socket layer could not create"
-                                 " socket (errno %d).\n", errnoLocal);
+                        // As above
+                        uWifiSockRegisterCallbackData(devHandle,
+                                                      sockHandle,
+                                                      dataCallback);
+                        uWifiSockRegisterCallbackClosed(devHandle,
+                                                        sockHandle,
+                                                        closedCallback);
                     }
                 }
+
+                if (sockHandle >= 0) {
+                    // All is good, no need to set descriptorOrError
+                    // as it was already set above
+                    pContainer->socket.sockHandle = sockHandle;
+                    pContainer->socket.devHandle = devHandle;
+                    pContainer->socket.bytesSent = 0;
+                    // Now the callbacks can find it
+                    hashAdd(pContainer);
+                    uPortLog("U_SOCK: socket created, descriptor %d,"
+                             " network handle 0x%08x, socket handle %d.\n",
+                             descriptorOrError, devHandle, sockHandle);
+                } else {
+                    // Set errno
+                    errnoLocal = -sockHandle;
+                    uPortLog("U_SOCK: underlying socket layer could not create"
+                             " socket (errno %d).\n", errnoLocal);
+                }
+            }
+            if (errnoLocal != U_SOCK_ENONE) {
+                // Free the container once more
+                containerFree(pContainer);
             }
+            containerUnlock(pContainer);
         }
 
         U_PORT_MUTEX_UNLOCK(gMutexContainer);
@@ -1263,11 +1475,8 @@ int32_t uSockConnect(uSockDescriptor_t descriptor,
         errnoLocal = U_SOCK_EINVAL;
         // Check that the remote IP address is sensible
         if (pRemoteAddress != NULL) {
-
-            U_PORT_MUTEX_LOCK(gMutexContainer);
-
-            // Find the container
-            pContainer = pContainerFindByDescriptor(descriptor);
+            // Find the container and lock it
+            pContainer = pContainerLock(descriptor, false);
             errnoLocal = U_SOCK_EBADF;
             if (pContainer != NULL) {
                 errnoLocal = U_SOCK_EPERM;
@@ -1324,7 +1533,7 @@ int32_t uSockConnect(uSockDescriptor_t descriptor,
                 }
             }
 
-            U_PORT_MUTEX_UNLOCK(gMutexContainer);
+            containerUnlock(pContainer);
         }
     }
 
@@ -1350,13 +1559,19 @@ int32_t uSockClose(uSockDescriptor_t descriptor)
 
     errnoLocal = init();
     if (errnoLocal == U_SOCK_ENONE) {
-
-        U_PORT_MUTEX_LOCK(gMutexContainer);
-
-        // Find the container
+        // Find the container and lock it, including the
+        // case where it has already been closed by the
+        // remote host, since the descriptor remains ours
+        // until we let go of it here
         errnoLocal = U_SOCK_EBADF;
-        pContainer = pContainerFindByDescriptor(descriptor);
-        if (pContainer != NULL) {
+        pContainer = pContainerLock(descriptor, true);
+        if ((pContainer != NULL) &&
+            (pContainer->socket.state == U_SOCK_STATE_CLOSED)) {
+            // Nothing more to do at the underlying socket
+            // layer, just let the descriptor go
+            errnoLocal = U_SOCK_ENONE;
+            pContainer->socket.state = U_SOCK_STATE_FREE;
+        } else if (pContainer != NULL) {
             // We have found the container, talk to the underlying
             // cell/wifi socket layer to close the socket there.
             // If the underlying socket layer waits while it gets
@@ -1410,6 +1625,10 @@ int32_t uSockClose(uSockDescriptor_t descriptor)
                         pContainer->socket.state = finalState;
                     }
                 }
+                if (pContainer->socket.state == U_SOCK_STATE_CLOSED) {
+                    // Fully closed: the descriptor may be re-used
+                    pContainer->socket.state = U_SOCK_STATE_FREE;
+                }
             } else {
                 errnoLocal = -errorCode;
                 uPortLog("U_SOCK: underlying socket layer returned"
@@ -1417,10 +1636,20 @@ int32_t uSockClose(uSockDescriptor_t descriptor)
                          " network handle 0x%08x, socket handle %d.\n",
                          errnoLocal, descriptor, devHandle,
                          sockHandle);
+                // The underlying socket layer may have closed the
+                // socket nevertheless (e.g. cellular, having lost
+                // buffered data), in which case its closed callback
+                // will free the container; if it hasn't, closing
+                // again will still go to the underlying socket layer
+                if (pContainer->socket.state == U_SOCK_STATE_CLOSED) {
+                    pContainer->socket.state = U_SOCK_STATE_FREE;
+                } else {
+                    pContainer->socket.state = U_SOCK_STATE_CLOSING;
+                }
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gMutexContainer);
+        containerUnlock(pContainer);
     }
 
     if (errnoLocal != U_SOCK_ENONE) {
@@ -1432,11 +1661,10 @@ int32_t uSockClose(uSockDescriptor_t descriptor)
     return errorCode;
 }
 
-// Free memory from any sockets that are no longer in use.
+// Free any sockets that are no longer in use.
 void uSockCleanUp()
 {
-    uSockContainer_t *pContainer = gpContainerListHead;
-    uSockContainer_t *pTmp;
+    uSockContainer_t *pContainer;
     size_t numNonClosedSockets = 0;
     uDeviceHandle_t devHandle;
 
@@ -1444,42 +1672,19 @@ void uSockCleanUp()
 
         U_PORT_MUTEX_LOCK(gMutexContainer);
 
-        // Move through the list removing closed sockets
-        while (pContainer != NULL) {
-            if ((pContainer->socket.state == U_SOCK_STATE_CLOSED) ||
-                (pContainer->socket.state == U_SOCK_STATE_CLOSING)) {
-                if (!(pContainer->isStatic)) {
-                    // If this socket is not static, uncouple it
-                    // If there is a previous container, move its pNext
-                    if (pContainer->pPrevious != NULL) {
-                        pContainer->pPrevious->pNext = pContainer->pNext;
-                    } else {
-                        // If there is no previous container, must be
-                        // at the start of the list so move the head
-                        // pointer on instead
-                        gpContainerListHead = pContainer->pNext;
-                    }
-                    // If there is a next container, move its pPrevious
-                    if (pContainer->pNext != NULL) {
-                        pContainer->pNext->pPrevious = pContainer->pPrevious;
-                    }
-
-                    // Remember the next pointer and the
-                    // network handle
-                    pTmp = pContainer->pNext;
-                    devHandle = pContainer->socket.devHandle;
-
-                    // Free the memory
-                    uPortFree(pContainer);
-                    // Move to the next entry
-                    pContainer = pTmp;
-                } else {
-                    // Remember the network handle
-                    devHandle = pContainer->socket.devHandle;
-                    pContainer->socket.state = U_SOCK_STATE_CLOSED;
-                    // Move on
-                    pContainer = pContainer->pNext;
-                }
+        // Move through the table freeing sockets that have been
+        // closed locally and have not yet been cleaned up; a socket
+        // closed only by the remote host keeps its descriptor
+        // until uSockClose() is called on it
+        for (size_t x = 0; x < sizeof(gContainers) / sizeof(gContainers[0]); x++) {
+            pContainer = &(gContainers[x]);
+            U_PORT_MUTEX_LOCK(pContainer->mutex);
+            if ((pContainer->socket.state == U_SOCK_STATE_CLOSING) ||
+                ((pContainer->socket.state == U_SOCK_STATE_FREE) &&
+                 (pContainer->socket.devHandle != NULL))) {
+                // Remember the network handle
+                devHandle = pContainer->socket.devHandle;
+                containerFree(pContainer);
 
                 if (devHandle != NULL) {
                     int32_t devType = uDeviceGetDeviceType(devHandle);
@@ -1491,11 +1696,11 @@ void uSockCleanUp()
                         uWifiSockCleanup(devHandle);
                     }
                 }
-            } else {
-                // Move on but count the number of non-closed sockets
+            } else if (pContainer->socket.state != U_SOCK_STATE_FREE) {
+                // Count the number of non-closed sockets
                 numNonClosedSockets++;
-                pContainer = pContainer->pNext;
             }
+            U_PORT_MUTEX_UNLOCK(pContainer->mutex);
         }
 
         // If everything has been closed, we can deinit();
@@ -1510,8 +1715,7 @@ void uSockCleanUp()
 // Close all sockets and free resource.
 void uSockDeinit()
 {
-    uSockContainer_t *pContainer = gpContainerListHead;
-    uSockContainer_t *pTmp;
+    uSockContainer_t *pContainer;
     uDeviceHandle_t devHandle;
     int32_t sockHandle;
 
@@ -1519,11 +1723,13 @@ void uSockDeinit()
 
         U_PORT_MUTEX_LOCK(gMutexContainer);
 
-        // Move through the list closing and
-        // removing sockets
-        while (pContainer != NULL) {
+        // Move through the table closing and
+        // freeing sockets
+        for (size_t x = 0; x < sizeof(gContainers) / sizeof(gContainers[0]); x++) {
+            pContainer = &(gContainers[x]);
+            U_PORT_MUTEX_LOCK(pContainer->mutex);
             if ((pContainer->socket.state != U_SOCK_STATE_CLOSING) &&
-                (pContainer->socket.state != U_SOCK_STATE_CLOSED)) {
+                containerIsOpen(pContainer)) {
                 // Talk to the underlying socket layer
                 // to close the socket: ignoring errors here
                 // 'cos there's nothing we can do,
@@ -1537,35 +1743,8 @@ void uSockDeinit()
                     uWifiSockClose(devHandle, sockHandle, NULL);
                 }
             }
-
-            if (!(pContainer->isStatic)) {
-                // If this socket is not static, uncouple it
-                // If there is a previous container, move its pNext
-                if (pContainer->pPrevious != NULL) {
-                    pContainer->pPrevious->pNext = pContainer->pNext;
-                } else {
-                    // If there is no previous container, must be
-                    // at the start of the list so move the head
-                    // pointer on instead
-                    gpContainerListHead = pContainer->pNext;
-                }
-                // If there is a next container, move its pPrevious
-                if (pContainer->pNext != NULL) {
-                    pContainer->pNext->pPrevious = pContainer->pPrevious;
-                }
-
-                // Remember the next pointer
-                pTmp = pContainer->pNext;
-
-                // Free the memory
-                uPortFree(pContainer);
-                // Move to the next entry
-                pContainer = pTmp;
-            } else {
-                pContainer->socket.state = U_SOCK_STATE_CLOSED;
-                // Move on
-                pContainer = pContainer->pNext;
-            }
+            containerFree(pContainer);
+            U_PORT_MUTEX_UNLOCK(pContainer->mutex);
         }
 
         // We can now deinit();
@@ -1587,18 +1766,15 @@ void uSockBlockingSet(uSockDescriptor_t descriptor, bool isBlocking)
 
     errnoLocal = init();
     if (errnoLocal == U_SOCK_ENONE) {
-
-        U_PORT_MUTEX_LOCK(gMutexContainer);
-
-        // Find the container
-        pContainer = pContainerFindByDescriptor(descriptor);
+        // Find the container and lock it
+        pContainer = pContainerLock(descriptor, false);
         errnoLocal = U_SOCK_EBADF;
         if (pContainer != NULL) {
             errnoLocal = U_SOCK_ENONE;
             pContainer->socket.blocking = isBlocking;
         }
 
-        U_PORT_MUTEX_UNLOCK(gMutexContainer);
+        containerUnlock(pContainer);
     }
 
     if (errnoLocal != U_SOCK_ENONE) {
@@ -1616,18 +1792,15 @@ bool uSockBlockingGet(uSockDescriptor_t descriptor)
 
     errnoLocal = init();
     if (errnoLocal == U_SOCK_ENONE) {
-
-        U_PORT_MUTEX_LOCK(gMutexContainer);
-
-        // Find the container
+        // Find the container and lock it
         errnoLocal = U_SOCK_EBADF;
-        pContainer = pContainerFindByDescriptor(descriptor);
+        pContainer = pContainerLock(descriptor, false);
         if (pContainer != NULL) {
             errnoLocal = U_SOCK_ENONE;
             isBlocking = pContainer->socket.blocking;
         }
 
-        U_PORT_MUTEX_UNLOCK(gMutexContainer);
+        containerUnlock(pContainer);
     }
 
     if (errnoLocal != U_SOCK_ENONE) {
@@ -1658,12 +1831,9 @@ int32_t uSockOptionSet(uSockDescriptor_t descriptor,
 
     errnoLocal = init();
     if (errnoLocal == U_SOCK_ENONE) {
-
-        U_PORT_MUTEX_LOCK(gMutexContainer);
-
-        // Find the container
+        // Find the container and lock it
         errnoLocal = U_SOCK_EBADF;
-        pContainer = pContainerFindByDescriptor(descriptor);
+        pContainer = pContainerLock(descriptor, false);
         if (pContainer != NULL) {
             errnoLocal = U_SOCK_EINVAL;
             // Check parameters
@@ -1732,7 +1902,7 @@ int32_t uSockOptionSet(uSockDescriptor_t descriptor,
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gMutexContainer);
+        containerUnlock(pContainer);
     }
 
     if (errnoLocal != U_SOCK_ENONE) {
@@ -1758,12 +1928,9 @@ int32_t uSockOptionGet(uSockDescriptor_t descriptor,
 
     errnoLocal = init();
     if (errnoLocal == U_SOCK_ENONE) {
-
-        U_PORT_MUTEX_LOCK(gMutexContainer);
-
-        // Find the container
+        // Find the container and lock it
         errnoLocal = U_SOCK_EBADF;
-        pContainer = pContainerFindByDescriptor(descriptor);
+        pContainer = pContainerLock(descriptor, false);
         if (pContainer != NULL) {
             errnoLocal = U_SOCK_EINVAL;
             // If there's an optionValue then there must be a length
@@ -1840,7 +2007,7 @@ int32_t uSockOptionGet(uSockDescriptor_t descriptor,
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gMutexContainer);
+        containerUnlock(pContainer);
     }
 
     if (errnoLocal != U_SOCK_ENONE) {
@@ -1864,12 +2031,9 @@ int32_t uSockSecurity(uSockDescriptor_t descriptor,
 
     errnoLocal = init();
     if (errnoLocal == U_SOCK_ENONE) {
-
-        U_PORT_MUTEX_LOCK(gMutexContainer);
-
-        // Find the container
+        // Find the container and lock it
         errnoLocal = U_SOCK_EBADF;
-        pContainer = pContainerFindByDescriptor(descriptor);
+        pContainer = pContainerLock(descriptor, false);
         if (pContainer != NULL) {
             errnoLocal = U_SOCK_ENONE;
             // Talk to the common security layer
@@ -1906,7 +2070,7 @@ int32_t uSockSecurity(uSockDescriptor_t descriptor,
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gMutexContainer);
+        containerUnlock(pContainer);
     }
 
     if (errnoLocal != U_SOCK_ENONE) {
@@ -1971,12 +2135,9 @@ int32_t uSockSendTo(uSockDescriptor_t descriptor,
 
     errnoLocal = init();
     if (errnoLocal == U_SOCK_ENONE) {
-
-        U_PORT_MUTEX_LOCK(gMutexContainer);
-
-        // Find the container
+        // Find the container and lock it
         errnoLocal = U_SOCK_EBADF;
-        pContainer = pContainerFindByDescriptor(descriptor);
+        pContainer = pContainerLock(descriptor, false);
         if (pContainer != NULL) {
             // Check address and state
             if (pRemoteAddress != NULL) {
@@ -2053,7 +2214,7 @@ int32_t uSockSendTo(uSockDescriptor_t descriptor,
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gMutexContainer);
+        containerUnlock(pContainer);
     }
 
     if (errnoLocal != U_SOCK_ENONE) {
@@ -2090,12 +2251,9 @@ int32_t uSockReceiveFrom(uSockDescriptor_t descriptor,
 
     errnoLocal = init();
     if (errnoLocal == U_SOCK_ENONE) {
-
-        U_PORT_MUTEX_LOCK(gMutexContainer);
-
-        // Find the container
+        // Find the container and lock it
         errnoLocal = U_SOCK_EBADF;
-        pContainer = pContainerFindByDescriptor(descriptor);
+        pContainer = pContainerLock(descriptor, false);
         if (pContainer != NULL) {
             errnoLocal = U_SOCK_EPROTOTYPE;
             // It is OK to receive UDP-style on a TCP socket
@@ -2131,7 +2289,7 @@ int32_t uSockReceiveFrom(uSockDescriptor_t descriptor,
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gMutexContainer);
+        containerUnlock(pContainer);
     }
 
     if (errnoLocal != U_SOCK_ENONE) {
@@ -2159,12 +2317,9 @@ int32_t uSockWrite(uSockDescriptor_t descriptor,
 
     errnoLocal = init();
     if (errnoLocal == U_SOCK_ENONE) {
-
-        U_PORT_MUTEX_LOCK(gMutexContainer);
-
-        // Find the container
+        // Find the container and lock it
         errnoLocal = U_SOCK_EBADF;
-        pContainer = pContainerFindByDescriptor(descriptor);
+        pContainer = pContainerLock(descriptor, false);
         if (pContainer != NULL) {
             if (pContainer->socket.state == U_SOCK_STATE_CONNECTED) {
                 errnoLocal = U_SOCK_EINVAL;
@@ -2222,7 +2377,7 @@ int32_t uSockWrite(uSockDescriptor_t descriptor,
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gMutexContainer);
+        containerUnlock(pContainer);
     }
 
     if (errnoLocal != U_SOCK_ENONE) {
@@ -2244,12 +2399,9 @@ int32_t uSockRead(uSockDescriptor_t descriptor,
 
     errnoLocal = init();
     if (errnoLocal == U_SOCK_ENONE) {
-
-        U_PORT_MUTEX_LOCK(gMutexContainer);
-
-        // Find the container
+        // Find the container and lock it
         errnoLocal = U_SOCK_EBADF;
-        pContainer = pContainerFindByDescriptor(descriptor);
+        pContainer = pContainerLock(descriptor, false);
         if (pContainer != NULL) {
             if (pContainer->socket.state == U_SOCK_STATE_CONNECTED) {
                 errnoLocal = U_SOCK_EINVAL;
@@ -2284,7 +2436,7 @@ int32_t uSockRead(uSockDescriptor_t descriptor,
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gMutexContainer);
+        containerUnlock(pContainer);
     }
 
     if (errnoLocal != U_SOCK_ENONE) {
@@ -2308,12 +2460,9 @@ int32_t uSockShutdown(uSockDescriptor_t descriptor,
 
     errnoLocal = init();
     if (errnoLocal == U_SOCK_ENONE) {
-
-        U_PORT_MUTEX_LOCK(gMutexContainer);
-
-        // Find the container
+        // Find the container and lock it
         errnoLocal = U_SOCK_EBADF;
-        pContainer = pContainerFindByDescriptor(descriptor);
+        pContainer = pContainerLock(descriptor, false);
         if (pContainer != NULL) {
             // Set the socket state
             switch (how) {
@@ -2335,7 +2484,7 @@ int32_t uSockShutdown(uSockDescriptor_t descriptor,
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gMutexContainer);
+        containerUnlock(pContainer);
     }
 
     if (errnoLocal != U_SOCK_ENONE) {
@@ -2363,12 +2512,9 @@ void uSockRegisterCallbackData(uSockDescriptor_t descriptor,
 
     errnoLocal = init();
     if (errnoLocal == U_SOCK_ENONE) {
-
-        U_PORT_MUTEX_LOCK(gMutexContainer);
-
-        // Find the container
+        // Find the container and lock it
         errnoLocal = U_SOCK_EBADF;
-        pContainer = pContainerFindByDescriptor(descriptor);
+        pContainer = pContainerLock(descriptor, false);
         if (pContainer != NULL) {
             U_PORT_MUTEX_LOCK(gMutexCallbacks);
 
@@ -2397,7 +2543,7 @@ void uSockRegisterCallbackData(uSockDescriptor_t descriptor,
             U_PORT_MUTEX_UNLOCK(gMutexCallbacks);
         }
 
-        U_PORT_MUTEX_UNLOCK(gMutexContainer);
+        containerUnlock(pContainer);
     }
 
     if (errnoLocal != U_SOCK_ENONE) {
@@ -2418,12 +2564,9 @@ void uSockRegisterCallbackClosed(uSockDescriptor_t descriptor,
 
     errnoLocal = init();
     if (errnoLocal == U_SOCK_ENONE) {
-
-        U_PORT_MUTEX_LOCK(gMutexContainer);
-
-        // Find the container
+        // Find the container and lock it
         errnoLocal = U_SOCK_EBADF;
-        pContainer = pContainerFindByDescriptor(descriptor);
+        pContainer = pContainerLock(descriptor, false);
         if (pContainer != NULL) {
 
             U_PORT_MUTEX_LOCK(gMutexCallbacks);
@@ -2453,7 +2596,7 @@ void uSockRegisterCallbackClosed(uSockDescriptor_t descriptor,
             U_PORT_MUTEX_UNLOCK(gMutexCallbacks);
         }
 
-        U_PORT_MUTEX_UNLOCK(gMutexContainer);
+        containerUnlock(pContainer);
     }
 
     if (errnoLocal != U_SOCK_ENONE) {
@@ -2506,14 +2649,76 @@ int32_t uSockSelect(int32_t maxDescriptor,
                     uSockDescriptorSet_t *pExceptDescriptorSet,
                     int32_t timeMs)
 {
-    // TODO
-    (void) maxDescriptor;
-    (void) pReadDescriptorSet;
-    (void) pWriteDescriptoreSet;
-    (void) pExceptDescriptorSet;
-    (void) timeMs;
-    errno = U_SOCK_ENOSYS;
-    return (int32_t) U_ERROR_COMMON_NOT_IMPLEMENTED;
+    int32_t errorCodeOrCount = 0;
+    int32_t errnoLocal;
+    int32_t startTimeMs = uPortGetTickTimeMs();
+    int32_t timeLeftMs = (timeMs >= 0) ? timeMs : INT_MAX;
+    uSockDescriptorSet_t readSet;
+    uSockDescriptorSet_t writeSet;
+    uSockDescriptorSet_t exceptSet;
+    uSockWaiter_t waiter;
+    bool waiterAdded = false;
+
+    errnoLocal = init();
+    if (errnoLocal == U_SOCK_ENONE) {
+        errnoLocal = U_SOCK_EINVAL;
+        if (maxDescriptor >= 0) {
+            errnoLocal = U_SOCK_ENONE;
+            if (maxDescriptor > U_SOCK_DESCRIPTOR_SET_SIZE) {
+                maxDescriptor = U_SOCK_DESCRIPTOR_SET_SIZE;
+            }
+            do {
+                U_PORT_MUTEX_LOCK(gMutexContainer);
+                errorCodeOrCount = selectCheck(maxDescriptor,
+                                               pReadDescriptorSet,
+                                               pWriteDescriptoreSet,
+                                               pExceptDescriptorSet,
+                                               &readSet, &writeSet,
+                                               &exceptSet);
+                U_PORT_MUTEX_UNLOCK(gMutexContainer);
+                if (timeMs >= 0) {
+                    timeLeftMs = timeMs - (uPortGetTickTimeMs() - startTimeMs);
+                }
+                if ((errorCodeOrCount == 0) && (timeLeftMs > 0)) {
+                    if (!waiterAdded) {
+                        // Add ourselves as a waiter and go around
+                        // again in case something happened before
+                        // we did so
+                        errnoLocal = waiterAdd(&waiter);
+                        waiterAdded = (errnoLocal == U_SOCK_ENONE);
+                    } else {
+                        waiterWait(&waiter, timeLeftMs);
+                    }
+                }
+            } while ((errnoLocal == U_SOCK_ENONE) &&
+                     (errorCodeOrCount == 0) && (timeLeftMs > 0));
+
+            if (waiterAdded) {
+                waiterRemove(&waiter);
+            }
+
+            if (errnoLocal == U_SOCK_ENONE) {
+                // Write back the results
+                if (pReadDescriptorSet != NULL) {
+                    memcpy(pReadDescriptorSet, &readSet, sizeof(readSet));
+                }
+                if (pWriteDescriptoreSet != NULL) {
+                    memcpy(pWriteDescriptoreSet, &writeSet, sizeof(writeSet));
+                }
+                if (pExceptDescriptorSet != NULL) {
+                    memcpy(pExceptDescriptorSet, &exceptSet, sizeof(exceptSet));
+                }
+            }
+        }
+    }
+
+    if (errnoLocal != U_SOCK_ENONE) {
+        // Write the errno
+        errno = errnoLocal;
+        errorCodeOrCount = (int32_t) U_ERROR_COMMON_BSD_ERROR;
+    }
+
+    return errorCodeOrCount;
 }
 
 /* ----------------------------------------------------------------
@@ -2535,12 +2740,9 @@ int32_t uSockGetRemoteAddress(uSockDescriptor_t descriptor,
         errnoLocal = U_SOCK_EINVAL;
         // Check parameters
         if (pRemoteAddress != NULL) {
-
-            U_PORT_MUTEX_LOCK(gMutexContainer);
-
-            // Find the container
+            // Find the container and lock it
             errnoLocal = U_SOCK_EBADF;
-            pContainer = pContainerFindByDescriptor(descriptor);
+            pContainer = pContainerLock(descriptor, false);
             if (pContainer != NULL) {
                 errnoLocal = U_SOCK_EHOSTUNREACH;
                 if (pContainer->socket.state == U_SOCK_STATE_CONNECTED) {
@@ -2551,7 +2753,7 @@ int32_t uSockGetRemoteAddress(uSockDescriptor_t descriptor,
                 }
             }
 
-            U_PORT_MUTEX_UNLOCK(gMutexContainer);
+            containerUnlock(pContainer);
         }
     }
 
@@ -2579,12 +2781,9 @@ int32_t uSockGetLocalAddress(uSockDescriptor_t descriptor,
         errnoLocal = U_SOCK_EINVAL;
         // Check parameters
         if (pLocalAddress != NULL) {
-
-            U_PORT_MUTEX_LOCK(gMutexContainer);
-
             // Check that the descriptor is at least valid
             errnoLocal = U_SOCK_EBADF;
-            pContainer = pContainerFindByDescriptor(descriptor);
+            pContainer = pContainerLock(descriptor, false);
             if (pContainer != NULL) {
                 // Talk to the underlying cell/wifi
                 // socket layer to get the local address.
@@ -2605,7 +2804,7 @@ int32_t uSockGetLocalAddress(uSockDescriptor_t descriptor,
                 }
             }
 
-            U_PORT_MUTEX_UNLOCK(gMutexContainer);
+            containerUnlock(pContainer);
         }
     }
 
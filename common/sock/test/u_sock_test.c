@@ -137,7 +137,7 @@
 /** Expected return time for non-blocking operation
  *in ms during testing.
  */
-# define U_SOCK_TEST_NON_BLOCKING_TIME_MS (U_SOCK_RECEIVE_POLL_INTERVAL_MS + 250)
+# define U_SOCK_TEST_NON_BLOCKING_TIME_MS 350
 #endif
 
 #ifndef U_SOCK_TEST_TIME_MARGIN_PLUS_MS
@@ -1827,6 +1827,10 @@ U_PORT_TEST_FUNCTION("[sock]", "sockNonBlocking")
     bool isBlocking;
     struct timeval timeout;
     char *pData[1];
+    char buffer[sizeof(gAllChars)];
+    uSockDescriptorSet_t readSet;
+    uSockDescriptorSet_t writeSet;
+    int32_t x;
     int32_t startTimeMs;
     int32_t timeoutMs;
     int32_t elapsedMs;
@@ -1975,6 +1979,50 @@ U_PORT_TEST_FUNCTION("[sock]", "sockNonBlocking")
         U_PORT_TEST_ASSERT(elapsedMs < U_SOCK_TEST_NON_BLOCKING_TIME_MS +
                            U_SOCK_TEST_TIME_MARGIN_PLUS_MS);
 
+        U_TEST_PRINT_LINE("check that select times out with nothing to read...");
+        U_SOCK_FD_ZERO(&readSet);
+        U_SOCK_FD_SET(descriptor, &readSet);
+        startTimeMs = uPortGetTickTimeMs();
+        U_PORT_TEST_ASSERT(uSockSelect(descriptor + 1, &readSet,
+                                       NULL, NULL, timeoutMs) == 0);
+        elapsedMs = uPortGetTickTimeMs() - startTimeMs;
+        U_TEST_PRINT_LINE("uSockSelect() with nothing to read took %d"
+                          " millisecond(s)...", (int32_t) elapsedMs);
+        U_PORT_TEST_ASSERT(!U_SOCK_FD_ISSET(descriptor, &readSet));
+        U_PORT_TEST_ASSERT(elapsedMs > timeoutMs -
+                           U_SOCK_TEST_TIME_MARGIN_MINUS_MS);
+        U_PORT_TEST_ASSERT(elapsedMs < timeoutMs +
+                           U_SOCK_TEST_TIME_MARGIN_PLUS_MS);
+
+        U_TEST_PRINT_LINE("check that select says we can write...");
+        U_SOCK_FD_ZERO(&writeSet);
+        U_SOCK_FD_SET(descriptor, &writeSet);
+        U_PORT_TEST_ASSERT(uSockSelect(descriptor + 1, NULL,
+                                       &writeSet, NULL, 0) == 1);
+        U_PORT_TEST_ASSERT(U_SOCK_FD_ISSET(descriptor, &writeSet));
+
+        U_TEST_PRINT_LINE("check that select wakes up on an echo...");
+        U_PORT_TEST_ASSERT(uSockWrite(descriptor, gAllChars,
+                                      sizeof(gAllChars)) == sizeof(gAllChars));
+        x = 0;
+        while ((x < (int32_t) sizeof(gAllChars)) &&
+               (uSockSelect(descriptor + 1, &readSet, NULL, NULL,
+                            U_SOCK_RECEIVE_TIMEOUT_DEFAULT_MS) == 1)) {
+            U_PORT_TEST_ASSERT(U_SOCK_FD_ISSET(descriptor, &readSet));
+            errorCode = uSockRead(descriptor, buffer + x, sizeof(buffer) - x);
+            if (errorCode > 0) {
+                x += errorCode;
+            } else {
+                // Select may occasionally report readable
+                // when there is nothing to read
+                U_PORT_TEST_ASSERT(errno == U_SOCK_EWOULDBLOCK);
+                errno = 0;
+            }
+        }
+        U_TEST_PRINT_LINE("%d byte(s) echoed.", x);
+        U_PORT_TEST_ASSERT(x == sizeof(gAllChars));
+        U_PORT_TEST_ASSERT(memcmp(buffer, gAllChars, sizeof(gAllChars)) == 0);
+
         U_TEST_PRINT_LINE("set blocking again...");
         uSockBlockingSet(descriptor, true);
         U_PORT_TEST_ASSERT(uSockBlockingGet(descriptor));
@@ -98,6 +98,14 @@ void uMemPoolFreeMem(uMemPoolDesc_t *pMemPool, void *ptr);
  */
 void uMemPoolFreeAllMem(uMemPoolDesc_t *pMemPool);
 
+/** Check if a block was allocated from the given pool.
+ *
+ * @param pMemPool      pointer to the memory pool.
+ * @param pMem          pointer to the block.
+ * @return              true if pMem lies within the buffer of the pool.
+ */
+bool uMemPoolIsOwner(const uMemPoolDesc_t *pMemPool, const void *pMem);
+
 #ifdef __cplusplus
 }
 #endif
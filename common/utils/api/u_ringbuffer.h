@@ -40,6 +40,23 @@ extern "C" {
  * COMPILE-TIME MACROS
  * -------------------------------------------------------------- */
 
+#ifndef U_RING_BUFFER_PARSER_STATE_LENGTH_BYTES
+/** The amount of storage a U_RING_BUFFER_PARSER_f function may
+ * use, via pURingBufferParserStateUnprotected(), to keep track of
+ * a message that has only partly arrived.  The storage is kept
+ * per read handle and is only allocated for read handles on a ring
+ * buffer that uRingBufferParseHandle() has been called on.
+ */
+# define U_RING_BUFFER_PARSER_STATE_LENGTH_BYTES 32
+#endif
+
+#ifndef U_RING_BUFFER_PARSER_SYNC_LIST_MAX_LENGTH
+/** The maximum number of sync bytes that may be passed to
+ * uRingBufferParseHandleSync().
+ */
+# define U_RING_BUFFER_PARSER_SYNC_LIST_MAX_LENGTH 8
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -99,11 +116,28 @@ typedef struct {
                                          as a result of add or forced add
                                          being unable to write into the
                                          ring buffer. */
+    size_t writeRegionSize;         /**< the size of the region handed out
+                                         by uRingBufferTakeWriteRegion()/
+                                         uRingBufferForceTakeWriteRegion(),
+                                         zero if there is none. */
+    void *pParseState;              /**< per read pointer parse state, allocated
+                                         by the first call to uRingBufferParseHandle(). */
 } uRingBuffer_t;
 
 typedef void *uParseHandle_t; //!< Parser handle.
 
 /** Parser function prototype, used with uRingBufferParseHandle().
+ *
+ * A parser is given the bytes at the read pointer one at a time,
+ * through uRingBufferGetByteUnprotected(), and must work through
+ * them as a state machine, keeping its state in the storage
+ * returned by pURingBufferParserStateUnprotected(), which is zeroed
+ * at the start of each message.  Should the parser run out of bytes
+ * part-way through a message it returns #U_ERROR_COMMON_TIMEOUT and,
+ * when more data has arrived, it will be called again with its
+ * state as it left it and uRingBufferGetByteUnprotected() returning
+ * the byte after the last one it consumed; this way each byte of
+ * a message is only examined once, however it arrives.
  *
  * @param parseHandle     the parser handle used to access the ring buffer.
  * @param[in] pUserParam  a user parameter, passed in via uRingBufferParseHandle().
@@ -271,6 +305,61 @@ size_t uRingBufferStatReadLoss(uRingBuffer_t *pRingBuffer);
  */
 size_t uRingBufferStatAddLoss(uRingBuffer_t *pRingBuffer);
 
+/* ----------------------------------------------------------------
+ * FUNCTIONS: ZERO-COPY WRITE
+ * -------------------------------------------------------------- */
+
+/** Take a contiguous region of the ring buffer, starting at the
+ * write pointer, that the caller may write into directly, e.g. by
+ * passing it to a UART or I2C read function, avoiding the copy
+ * through a temporary buffer that uRingBufferAdd() would require.
+ * Once the caller has written into the region it MUST call
+ * uRingBufferGiveWriteRegion() with the number of bytes actually
+ * written; until that is done uRingBufferAdd()/uRingBufferForceAdd()
+ * will fail and further calls to this function will return zero,
+ * so there is only ever one writer.  The region is never longer than
+ * the space up to the end of the underlying linear buffer: if the
+ * data wraps, take/give twice.  The ring buffer mutex is NOT held
+ * while the region is outstanding, readers continue as normal.
+ *
+ * @param[in] pRingBuffer  a pointer to the ring buffer, cannot be NULL.
+ * @param[out] ppData      a place to put a pointer to the start of the
+ *                         region; cannot be NULL.
+ * @param length           the maximum length of region wanted.
+ * @return                 the length of the region at *ppData, zero
+ *                         if there is no room or a region is already
+ *                         outstanding.
+ */
+size_t uRingBufferTakeWriteRegion(uRingBuffer_t *pRingBuffer, char **ppData,
+                                  size_t length);
+
+/** As uRingBufferTakeWriteRegion() but, like uRingBufferForceAdd(),
+ * moves any [non-locked] read pointer(s) on to make room if required;
+ * the bytes thrown away are counted in the read loss statistics
+ * at the point this function is called.
+ *
+ * @param[in] pRingBuffer  a pointer to the ring buffer, cannot be NULL.
+ * @param[out] ppData      a place to put a pointer to the start of the
+ *                         region; cannot be NULL.
+ * @param length           the maximum length of region wanted.
+ * @return                 the length of the region at *ppData, zero
+ *                         if there is no room or a region is already
+ *                         outstanding.
+ */
+size_t uRingBufferForceTakeWriteRegion(uRingBuffer_t *pRingBuffer, char **ppData,
+                                       size_t length);
+
+/** Give back a region obtained with uRingBufferTakeWriteRegion()
+ * or uRingBufferForceTakeWriteRegion(), committing the data that
+ * was written into it to the ring buffer.
+ *
+ * @param[in] pRingBuffer  a pointer to the ring buffer, cannot be NULL.
+ * @param length           the number of bytes that were written into
+ *                         the region, may be zero; values larger than
+ *                         the length of the region are truncated.
+ */
+void uRingBufferGiveWriteRegion(uRingBuffer_t *pRingBuffer, size_t length);
+
 /* ----------------------------------------------------------------
  * FUNCTIONS: MULTIPLE READERS
  * -------------------------------------------------------------- */
@@ -336,6 +425,20 @@ bool uRingBufferGetReadRequiresHandle(uRingBuffer_t *pRingBuffer);
  */
 int32_t uRingBufferTakeReadHandle(uRingBuffer_t *pRingBuffer);
 
+/** Take a new read handle whose read pointer starts at the same place
+ * as that of an existing read handle, rather than at the end of the
+ * data currently in the ring buffer.  The new handle is not locked,
+ * even if the existing one is: call uRingBufferLockReadHandle() on it
+ * if that is what you want.  Give the new handle back with
+ * uRingBufferGiveReadHandle() as normal.
+ *
+ * @param[in] pRingBuffer   a pointer to the ring buffer, cannot be NULL.
+ * @param handle            the existing read handle, as originally
+ *                          returned by uRingBufferTakeReadHandle().
+ * @return                  a new read handle else negative error code.
+ */
+int32_t uRingBufferDuplicateReadHandle(uRingBuffer_t *pRingBuffer, int32_t handle);
+
 /** Give back a read handle.
  *
  * @param[in] pRingBuffer   a pointer to the ring buffer, cannot be NULL.
@@ -455,11 +558,38 @@ void uRingBufferFlushHandle(uRingBuffer_t *pRingBuffer, int32_t handle);
 size_t uRingBufferStatReadLossHandle(uRingBuffer_t *pRingBuffer,
                                      int32_t handle);
 
+/** Get a pointer to the data waiting at a read handle, in place,
+ * without copying it.  The region returned is contiguous and so
+ * ends at the end of the underlying linear buffer: to get at data
+ * that has wrapped, call this again with offset increased by the
+ * length returned.  The data remains in the ring buffer, use
+ * uRingBufferReadHandle() with pData set to NULL to move the
+ * read pointer on afterwards.  The read handle should be locked
+ * with uRingBufferLockReadHandle() while the region is being
+ * looked at, otherwise uRingBufferForceAdd() may overwrite it.
+ *
+ * @param[in] pRingBuffer a pointer to the ring buffer, cannot be NULL.
+ * @param handle          a read handle, as originally returned by
+ *                        uRingBufferTakeReadHandle().
+ * @param[out] ppData     a place to put a pointer to the data; cannot
+ *                        be NULL.
+ * @param offset          the offset from the read pointer at which
+ *                        the region should begin.
+ * @return                the number of contiguous bytes at *ppData.
+ */
+size_t uRingBufferPeekRegionHandle(uRingBuffer_t *pRingBuffer, int32_t handle,
+                                   const char **ppData, size_t offset);
+
 /* ----------------------------------------------------------------
  * FUNCTIONS: PARSER
  * -------------------------------------------------------------- */
 
 /** Run a set of parsers over the contents of the ring buffer.
+ * The parse state is kept per read handle: if a parser found only
+ * part of a message last time, and the read handle has not been
+ * moved on except to discard what was in front of that message,
+ * the parser carries on from where it got to rather than starting
+ * again.
  *
  * @param[in] pRingBuffer a pointer to the ring buffer, cannot be NULL.
  * @param handle          a read handle, as originally returned by
@@ -473,6 +603,48 @@ size_t uRingBufferStatReadLossHandle(uRingBuffer_t *pRingBuffer,
 size_t uRingBufferParseHandle(uRingBuffer_t *pRingBuffer, int32_t handle,
                               U_RING_BUFFER_PARSER_f *pParserList, void *pUserParam);
 
+/** As uRingBufferParseHandle() but, where no parser recognises the
+ * data at a given position, rather than moving on by a single byte
+ * and trying all of the parsers again, the ring buffer is searched
+ * (with memchr()) for the next of the given sync bytes, i.e. the bytes
+ * that can begin a message, and parsing resumes there.  This makes
+ * recovering from a large amount of rubbish, e.g. after a UART
+ * overrun, much quicker.
+ *
+ * @param[in] pRingBuffer    a pointer to the ring buffer, cannot be NULL.
+ * @param handle             a read handle, as originally returned by
+ *                           uRingBufferTakeReadHandle().
+ * @param[in] pParserList    a pointer to a list of parsers, terminated by
+ *                           a NULL pointer.
+ * @param[in] pSyncList      a pointer to the list of bytes that can begin
+ *                           a message recognised by one of the parsers;
+ *                           may be NULL if syncListLength is zero.
+ * @param syncListLength     the number of bytes at pSyncList, at most
+ *                           #U_RING_BUFFER_PARSER_SYNC_LIST_MAX_LENGTH;
+ *                           if zero this behaves as uRingBufferParseHandle().
+ * @param[in] pUserParam     a user parameter to pass to each parser in the list.
+ * @return                   the number of bytes lost from the given
+ *                           read handle.
+ */
+size_t uRingBufferParseHandleSync(uRingBuffer_t *pRingBuffer, int32_t handle,
+                                  U_RING_BUFFER_PARSER_f *pParserList,
+                                  const char *pSyncList, size_t syncListLength,
+                                  void *pUserParam);
+
+/** Get the number of bytes which uRingBufferParseHandle() or
+ * uRingBufferParseHandleSync() have reported, for the given read
+ * handle, as recognised by none of the parsers; the caller is expected
+ * to read those bytes out, since they will be reported again otherwise.
+ * The count is reset when the read handle is taken.
+ *
+ * @param[in] pRingBuffer a pointer to the ring buffer, cannot be NULL.
+ * @param handle          a read handle, as originally returned by
+ *                        uRingBufferTakeReadHandle().
+ * @return                the number of bytes discarded.
+ */
+size_t uRingBufferStatParseDiscardHandle(uRingBuffer_t *pRingBuffer,
+                                         int32_t handle);
+
 /** Get a byte from the ring buffer while in a parser function.
  *
  * IMPORTANT: unlike all of the other ring-buffer functions, this function
@@ -510,6 +682,20 @@ size_t uRingBufferBytesAvailableUnprotected(uParseHandle_t parseHandle);
  */
 size_t uRingBufferBytesDiscardUnprotected(uParseHandle_t parseHandle);
 
+/** Get a pointer to the storage in which a parser function should keep
+ * its state, #U_RING_BUFFER_PARSER_STATE_LENGTH_BYTES long and aligned
+ * for a uint32_t; the storage is zeroed at the start of each message.
+ *
+ * IMPORTANT: unlike all of the other ring-buffer functions, this function
+ * is NOT thread-safe, it is ONLY intended to be used from within a
+ * U_RING_BUFFER_PARSER_f function that will be called by uRingBufferParseHandle()
+ * (which adds thread-safety).
+ *
+ * @param parseHandle     the parser handle used to access the ring buffer.
+ * @return                a pointer to the parser state storage.
+ */
+void *pURingBufferParserStateUnprotected(uParseHandle_t parseHandle);
+
 #ifdef __cplusplus
 }
 #endif
@@ -215,4 +215,13 @@ void uMemPoolFreeAllMem(uMemPoolDesc_t *pMemPool)
     }
 }
 
+bool uMemPoolIsOwner(const uMemPoolDesc_t *pMemPool, const void *pMem)
+{
+    // No need to lock: the buffer of a pool doesn't move once
+    // allocated and a block can only be owned if it was allocated
+    return (pMemPool != NULL) && (pMemPool->pBuffer != NULL) &&
+           ((const uint8_t *)pMem >= pMemPool->pBuffer) &&
+           ((const uint8_t *)pMem < (pMemPool->pBuffer + U_BUFFER_SIZE(pMemPool)));
+}
+
 // End of file
@@ -60,6 +60,25 @@
  * TYPES
  * -------------------------------------------------------------- */
 
+/** The state of a parse, kept per read pointer so that a message
+ * which has only partly arrived can be picked up again where it
+ * left off by the next call to uRingBufferParseHandle().
+ */
+typedef struct {
+    const char *pStart;         /**< where the message being parsed
+                                     starts in the ring buffer, NULL
+                                     if no parse is in progress. */
+    U_RING_BUFFER_PARSER_f pParser; /**< the parser that is part-way
+                                         through the message. */
+    size_t bytesParsed;         /**< the number of bytes of the message
+                                     that pParser has consumed so far. */
+    uint32_t parser[(U_RING_BUFFER_PARSER_STATE_LENGTH_BYTES + 3) / 4]; /**< the
+                                                                             parser's
+                                                                             own state. */
+    size_t statDiscardBytes;    /**< the number of bytes that no parser
+                                     recognised. */
+} uRingBufferParseState_t;
+
 /** Parsing context.
  */
 typedef struct {
@@ -68,6 +87,7 @@ typedef struct {
     size_t bytesAvailable;
     size_t bytesParsed;
     size_t bytesDiscard;
+    uRingBufferParseState_t *pState;
 } uRingBufferParseContext_t;
 
 /* ----------------------------------------------------------------
@@ -118,6 +138,102 @@ static U_INLINE const char *pPtrOffset(const char *pData, size_t offset,
     return pData;
 }
 
+// Copy data out of the ring buffer, starting at pSource, in at
+// most two memcpy()s, one up to the end of the linear buffer and
+// one from the start; pData may be NULL, in which case nothing
+// is copied.  The ring buffer's mutex should be locked before
+// this is called.
+static void copyOut(const uRingBuffer_t *pRingBuffer, const char *pSource,
+                    char *pData, size_t length)
+{
+    size_t segmentLength = (pRingBuffer->pBuffer + pRingBuffer->size) - pSource;
+
+    if (pData != NULL) {
+        if (segmentLength > length) {
+            segmentLength = length;
+        }
+        memcpy(pData, pSource, segmentLength);
+        if (length > segmentLength) {
+            memcpy(pData + segmentLength, pRingBuffer->pBuffer,
+                   length - segmentLength);
+        }
+    }
+}
+
+// Copy data into the ring buffer at the write pointer, in at most
+// two memcpy()s, and move the write pointer on.  The caller must
+// have checked that there is room.  The ring buffer's mutex should
+// be locked before this is called.
+static void copyIn(uRingBuffer_t *pRingBuffer, const char *pData,
+                   size_t length)
+{
+    size_t segmentLength = (pRingBuffer->pBuffer + pRingBuffer->size) -
+                           pRingBuffer->pDataWrite;
+
+    if (segmentLength > length) {
+        segmentLength = length;
+    }
+    memcpy(pRingBuffer->pDataWrite, pData, segmentLength);
+    if (length > segmentLength) {
+        memcpy(pRingBuffer->pBuffer, pData + segmentLength,
+               length - segmentLength);
+    }
+    pRingBuffer->pDataWrite = (char *) pPtrOffset(pRingBuffer->pDataWrite, length,
+                                                  pRingBuffer->pBuffer,
+                                                  pRingBuffer->size);
+}
+
+// Return true if the given read pointer may be moved on by an add,
+// i.e. the data behind it may be thrown away.
+static bool readPointerIsMovable(const uRingBuffer_t *pRingBuffer,
+                                 size_t x, bool destructive)
+{
+    // If we're on the "normal" read pointer (0) and it can't be used (because
+    // of the readHandleRequired flag) OR we are being destructive (so a
+    // forced add) and this data read pointer is not locked, then we
+    // are allowed to throw data away.
+    return ((x == 0) && pRingBuffer->readHandleRequired) ||
+           (destructive && ((x == 0) || (pRingBuffer->dataReadLockBitmap & (1ULL << (x - 1))) == 0));
+}
+
+// Return the offset from pData of the first occurrence of the given
+// byte within the next length bytes of the ring buffer, searching
+// both segments with memchr(), or length if it is not there.
+static size_t findByte(const uRingBuffer_t *pRingBuffer, const char *pData,
+                       size_t length, char byte)
+{
+    size_t offset = length;
+    size_t segmentLength = (pRingBuffer->pBuffer + pRingBuffer->size) - pData;
+    const char *pFound;
+
+    if (segmentLength > length) {
+        segmentLength = length;
+    }
+    pFound = (const char *) memchr(pData, (unsigned char) byte, segmentLength);
+    if (pFound != NULL) {
+        offset = pFound - pData;
+    } else if (length > segmentLength) {
+        pFound = (const char *) memchr(pRingBuffer->pBuffer, (unsigned char) byte,
+                                       length - segmentLength);
+        if (pFound != NULL) {
+            offset = segmentLength + (pFound - pRingBuffer->pBuffer);
+        }
+    }
+
+    return offset;
+}
+
+// Forget any parse that was in progress on the given read pointer.
+// The ring buffer's mutex should be locked before this is called.
+static void parseStateClear(uRingBuffer_t *pRingBuffer, size_t x)
+{
+    uRingBufferParseState_t *pState = (uRingBufferParseState_t *) pRingBuffer->pParseState;
+
+    if (pState != NULL) {
+        pState[x].pStart = NULL;
+    }
+}
+
 // The ring buffer's mutex should be locked before this is called
 static void bufferReset(uRingBuffer_t *pRingBuffer)
 {
@@ -129,8 +245,11 @@ static void bufferReset(uRingBuffer_t *pRingBuffer)
         if (pRingBuffer->pDataRead[x] != NULL) {
             pRingBuffer->pDataRead[x] = pRingBuffer->pBuffer;
         }
+        parseStateClear(pRingBuffer, x);
     }
     pRingBuffer->pDataWrite = pRingBuffer->pBuffer;
+    // Any write region that was handed out is no longer valid
+    pRingBuffer->writeRegionSize = 0;
     // The default handle-less read pointer can always be set
     pRingBuffer->pDataRead[0] = pRingBuffer->pDataWrite;
 }
@@ -161,31 +280,37 @@ static size_t read(uRingBuffer_t *pRingBuffer, int32_t handle, char *pData,
             length = available;
         }
 
-        while (bytesRead < length) {
-            if (pData != NULL) {
-                *pData = *pSource;
-                pData++;
-            }
-            pSource = pPtrInc(pSource, pRingBuffer->pBuffer, pRingBuffer->size);
-            bytesRead++;
-        }
+        copyOut(pRingBuffer, pSource, pData, length);
+        bytesRead = length;
         if (destructive) {
-            pRingBuffer->pDataRead[handle] = pSource;
+            pRingBuffer->pDataRead[handle] = pPtrOffset(pSource, length,
+                                                        pRingBuffer->pBuffer,
+                                                        pRingBuffer->size);
+            // A parse in progress remains valid only if the read
+            // has just thrown away what was in front of it
+            if ((pRingBuffer->pParseState != NULL) &&
+                (((uRingBufferParseState_t *) pRingBuffer->pParseState)[handle].pStart !=
+                 pRingBuffer->pDataRead[handle])) {
+                parseStateClear(pRingBuffer, handle);
+            }
         }
     }
 
     return bytesRead;
 }
 
-// The ring buffer's mutex should be locked before this is called
-static bool add(uRingBuffer_t *pRingBuffer, const char *pData,
-                size_t length, bool destructive)
+// Make room for length bytes at the write pointer, moving read
+// pointers on if allowed to do so, returning true if there is room.
+// The ring buffer's mutex should be locked before this is called.
+static bool makeRoom(uRingBuffer_t *pRingBuffer, size_t length,
+                     bool destructive)
 {
     bool dataFitsInBuffer = true;
     size_t lost;
     size_t used;
 
-    if (length >= pRingBuffer->size) {
+    if ((length >= pRingBuffer->size) || (pRingBuffer->writeRegionSize > 0)) {
+        // Too big or someone is writing directly into the buffer
         dataFitsInBuffer = false;
     } else {
         for (size_t x = 0; (x < pRingBuffer->maxNumReadPointers) &&
@@ -194,12 +319,8 @@ static bool add(uRingBuffer_t *pRingBuffer, const char *pData,
                 used = ptrDiff(pRingBuffer->pDataRead[x], pRingBuffer->pDataWrite, pRingBuffer->size);
                 used++; // Account for the fact that we can't have the pointers overlap
                 if (used + length > pRingBuffer->size) {
-                    // If we're on the "normal" read pointer (0) and it can't be used (because
-                    // of the readHandleRequired flag) OR we are being destructive (so a
-                    // forced add) and this data read pointer is not locked, then we
-                    // throw away enough data to make it fit.
-                    if (((x == 0) && pRingBuffer->readHandleRequired) ||
-                        (destructive && ((x == 0) || (pRingBuffer->dataReadLockBitmap & (1ULL << (x - 1))) == 0))) {
+                    // Throw away enough data to make it fit, if we can
+                    if (readPointerIsMovable(pRingBuffer, x, destructive)) {
                         lost = read(pRingBuffer, x, NULL, used + length - pRingBuffer->size, 0, true);
                         if (x == 0) {
                             pRingBuffer->statReadLossNormalBytes += lost;
@@ -214,14 +335,17 @@ static bool add(uRingBuffer_t *pRingBuffer, const char *pData,
         }
     }
 
+    return dataFitsInBuffer;
+}
+
+// The ring buffer's mutex should be locked before this is called
+static bool add(uRingBuffer_t *pRingBuffer, const char *pData,
+                size_t length, bool destructive)
+{
+    bool dataFitsInBuffer = makeRoom(pRingBuffer, length, destructive);
+
     if (dataFitsInBuffer) {
-        while (length > 0) {
-            *(pRingBuffer->pDataWrite) = *pData;
-            pRingBuffer->pDataWrite = (char *) pPtrInc(pRingBuffer->pDataWrite, pRingBuffer->pBuffer,
-                                                       pRingBuffer->size);
-            length--;
-            pData++;
-        }
+        copyIn(pRingBuffer, pData, length);
     } else {
         pRingBuffer->statAddLossBytes += length;
     }
@@ -229,6 +353,54 @@ static bool add(uRingBuffer_t *pRingBuffer, const char *pData,
     return dataFitsInBuffer;
 }
 
+// This function does the ring buffer mutex locking itself.
+static size_t takeWriteRegion(uRingBuffer_t *pRingBuffer, char **ppData,
+                              size_t length, bool destructive)
+{
+    size_t regionSize = 0;
+    size_t freeSize;
+
+    if ((pRingBuffer->pBuffer != NULL) && (ppData != NULL)) {
+
+        U_PORT_MUTEX_LOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+
+        if (pRingBuffer->writeRegionSize == 0) {
+            // Limit to the contiguous space up to the end of the linear buffer
+            regionSize = (pRingBuffer->pBuffer + pRingBuffer->size) - pRingBuffer->pDataWrite;
+            if (regionSize > length) {
+                regionSize = length;
+            }
+            if (regionSize >= pRingBuffer->size) {
+                regionSize = pRingBuffer->size - 1;
+            }
+            // Limit to what the read pointers we are not allowed to move allow
+            for (size_t x = 0; x < pRingBuffer->maxNumReadPointers; x++) {
+                if ((pRingBuffer->pDataRead[x] != NULL) &&
+                    !readPointerIsMovable(pRingBuffer, x, destructive)) {
+                    freeSize = pRingBuffer->size - 1 - ptrDiff(pRingBuffer->pDataRead[x],
+                                                               pRingBuffer->pDataWrite,
+                                                               pRingBuffer->size);
+                    if (regionSize > freeSize) {
+                        regionSize = freeSize;
+                    }
+                }
+            }
+            // Now push on the read pointers we are allowed to move:
+            // this will always succeed given the limiting above
+            if ((regionSize > 0) && makeRoom(pRingBuffer, regionSize, destructive)) {
+                pRingBuffer->writeRegionSize = regionSize;
+                *ppData = pRingBuffer->pDataWrite;
+            } else {
+                regionSize = 0;
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+    }
+
+    return regionSize;
+}
+
 // This function does the ring buffer mutex locking itself.
 static size_t lock(uRingBuffer_t *pRingBuffer, int32_t handle, bool lockNotUnlock)
 {
@@ -343,6 +515,30 @@ static void printPointer(const char *pTitle, const char *pBuffer, size_t bufferS
     uPortLog("\n");
 }
 
+// Take a read handle with its read pointer at pDataRead; the ring
+// buffer must be locked before this is called.
+static int32_t takeReadHandle(uRingBuffer_t *pRingBuffer, const char *pDataRead)
+{
+    int32_t readHandle = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+
+    // Leave out the zeroth entry, which is reserved for
+    // un-handled reads
+    for (size_t x = 1; (x < pRingBuffer->maxNumReadPointers) &&
+         (readHandle < 0); x++) {
+        if (pRingBuffer->pDataRead[x] == NULL) {
+            pRingBuffer->pDataRead[x] = pDataRead;
+            pRingBuffer->statReadLossBytes[x] = 0;
+            parseStateClear(pRingBuffer, x);
+            if (pRingBuffer->pParseState != NULL) {
+                ((uRingBufferParseState_t *) pRingBuffer->pParseState)[x].statDiscardBytes = 0;
+            }
+            readHandle = x;
+        }
+    }
+
+    return readHandle;
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS: DEBUG
  * -------------------------------------------------------------- */
@@ -409,6 +605,8 @@ void uRingBufferDelete(uRingBuffer_t *pRingBuffer)
             uPortFree(pRingBuffer->statReadLossBytes);
             pRingBuffer->statReadLossBytes = NULL;
         }
+        uPortFree(pRingBuffer->pParseState);
+        pRingBuffer->pParseState = NULL;
         pRingBuffer->maxNumReadPointers = 0;
         uPortMutexDelete((uPortMutexHandle_t) pRingBuffer->mutex);
         pRingBuffer->mutex = NULL;
@@ -512,6 +710,7 @@ void uRingBufferFlush(uRingBuffer_t *pRingBuffer)
         U_PORT_MUTEX_LOCK((uPortMutexHandle_t) pRingBuffer->mutex);
 
         pRingBuffer->pDataRead[0] = pRingBuffer->pDataWrite;
+        parseStateClear(pRingBuffer, 0);
 
         U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) pRingBuffer->mutex);
     }
@@ -587,6 +786,38 @@ size_t uRingBufferStatAddLoss(uRingBuffer_t *pRingBuffer)
     return bytesLost;
 }
 
+size_t uRingBufferTakeWriteRegion(uRingBuffer_t *pRingBuffer, char **ppData,
+                                  size_t length)
+{
+    return takeWriteRegion(pRingBuffer, ppData, length, false);
+}
+
+size_t uRingBufferForceTakeWriteRegion(uRingBuffer_t *pRingBuffer, char **ppData,
+                                       size_t length)
+{
+    return takeWriteRegion(pRingBuffer, ppData, length, true);
+}
+
+void uRingBufferGiveWriteRegion(uRingBuffer_t *pRingBuffer, size_t length)
+{
+    if (pRingBuffer->pBuffer != NULL) {
+
+        U_PORT_MUTEX_LOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+
+        if (length > pRingBuffer->writeRegionSize) {
+            // Can't commit more than was taken; this also covers
+            // the case where the ring buffer was reset in the meantime
+            length = pRingBuffer->writeRegionSize;
+        }
+        pRingBuffer->pDataWrite = (char *) pPtrOffset(pRingBuffer->pDataWrite, length,
+                                                      pRingBuffer->pBuffer,
+                                                      pRingBuffer->size);
+        pRingBuffer->writeRegionSize = 0;
+
+        U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+    }
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS: MULTIPLE READERS
  * -------------------------------------------------------------- */
@@ -632,6 +863,7 @@ void uRingBufferSetReadRequiresHandle(uRingBuffer_t *pRingBuffer, bool onNotOff)
             // it off, set the non-handled read
             // pointer so that it gets sensible data
             pRingBuffer->pDataRead[0] = pRingBuffer->pDataWrite;
+            parseStateClear(pRingBuffer, 0);
         }
         pRingBuffer->readHandleRequired = onNotOff;
 
@@ -653,15 +885,25 @@ int32_t uRingBufferTakeReadHandle(uRingBuffer_t *pRingBuffer)
 
         U_PORT_MUTEX_LOCK((uPortMutexHandle_t) pRingBuffer->mutex);
 
-        // Leave out the zeroth entry, which is reserved for
-        // un-handled reads
-        for (size_t x = 1; (x < pRingBuffer->maxNumReadPointers) &&
-             (readHandle < 0); x++) {
-            if (pRingBuffer->pDataRead[x] == NULL) {
-                pRingBuffer->pDataRead[x] = pRingBuffer->pDataWrite;
-                pRingBuffer->statReadLossBytes[x] = 0;
-                readHandle = x;
-            }
+        readHandle = takeReadHandle(pRingBuffer, pRingBuffer->pDataWrite);
+
+        U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+    }
+
+    return readHandle;
+}
+
+int32_t uRingBufferDuplicateReadHandle(uRingBuffer_t *pRingBuffer, int32_t handle)
+{
+    int32_t readHandle = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+
+    if (pRingBuffer->pBuffer != NULL) {
+
+        U_PORT_MUTEX_LOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+
+        if ((handle >= 1) && (handle < (int32_t) pRingBuffer->maxNumReadPointers) &&
+            (pRingBuffer->pDataRead[handle] != NULL)) {
+            readHandle = takeReadHandle(pRingBuffer, pRingBuffer->pDataRead[handle]);
         }
 
         U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) pRingBuffer->mutex);
@@ -679,6 +921,7 @@ void uRingBufferGiveReadHandle(uRingBuffer_t *pRingBuffer, int32_t handle)
         if ((handle >= 1) && (handle < (int32_t) pRingBuffer->maxNumReadPointers)) {
             pRingBuffer->pDataRead[handle] = NULL;
             pRingBuffer->dataReadLockBitmap &= ~(1ULL << (handle - 1));
+            parseStateClear(pRingBuffer, handle);
         }
 
         U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) pRingBuffer->mutex);
@@ -784,6 +1027,7 @@ void uRingBufferFlushHandle(uRingBuffer_t *pRingBuffer, int32_t handle)
         if ((handle >= 1) && (handle < (int32_t) pRingBuffer->maxNumReadPointers) &&
             (pRingBuffer->pDataRead[handle] != NULL)) {
             pRingBuffer->pDataRead[handle] = pRingBuffer->pDataWrite;
+            parseStateClear(pRingBuffer, handle);
         }
 
         U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) pRingBuffer->mutex);
@@ -810,6 +1054,40 @@ size_t uRingBufferStatReadLossHandle(uRingBuffer_t *pRingBuffer,
     return bytesLost;
 }
 
+size_t uRingBufferPeekRegionHandle(uRingBuffer_t *pRingBuffer, int32_t handle,
+                                   const char **ppData, size_t offset)
+{
+    size_t regionSize = 0;
+    size_t available;
+    const char *pSource;
+
+    if ((pRingBuffer->pBuffer != NULL) && (ppData != NULL)) {
+
+        U_PORT_MUTEX_LOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+
+        if ((handle >= 0) && (handle < (int32_t) pRingBuffer->maxNumReadPointers) &&
+            (pRingBuffer->pDataRead[handle] != NULL)) {
+            available = ptrDiff(pRingBuffer->pDataRead[handle], pRingBuffer->pDataWrite,
+                                pRingBuffer->size);
+            if (offset < available) {
+                pSource = pPtrOffset(pRingBuffer->pDataRead[handle], offset,
+                                     pRingBuffer->pBuffer, pRingBuffer->size);
+                // Only up to the end of the linear buffer, the caller
+                // can come back for the wrapped part with a larger offset
+                regionSize = (pRingBuffer->pBuffer + pRingBuffer->size) - pSource;
+                if (regionSize > available - offset) {
+                    regionSize = available - offset;
+                }
+                *ppData = pSource;
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+    }
+
+    return regionSize;
+}
+
 /* ----------------------------------------------------------------
  * FUNCTIONS: PARSER
  * -------------------------------------------------------------- */
@@ -817,49 +1095,129 @@ size_t uRingBufferStatReadLossHandle(uRingBuffer_t *pRingBuffer,
 size_t uRingBufferParseHandle(uRingBuffer_t *pRingBuffer, int32_t handle,
                               U_RING_BUFFER_PARSER_f *pParserList, void *pUserParam)
 {
-    size_t errorCodeOrLength = U_ERROR_COMMON_INVALID_PARAMETER;
+    return uRingBufferParseHandleSync(pRingBuffer, handle, pParserList,
+                                      NULL, 0, pUserParam);
+}
 
-    if (pRingBuffer->pBuffer != NULL) {
+size_t uRingBufferParseHandleSync(uRingBuffer_t *pRingBuffer, int32_t handle,
+                                  U_RING_BUFFER_PARSER_f *pParserList,
+                                  const char *pSyncList, size_t syncListLength,
+                                  void *pUserParam)
+{
+    size_t errorCodeOrLength = U_ERROR_COMMON_INVALID_PARAMETER;
+    uRingBufferParseState_t localState = {0};
+    uRingBufferParseState_t *pState = &localState;
+    U_RING_BUFFER_PARSER_f *pParser;
+    bool resume = false;
+    // Where each sync byte was last found, as an offset from the
+    // read pointer; zero means it has not been looked for yet
+    size_t syncOffset[U_RING_BUFFER_PARSER_SYNC_LIST_MAX_LENGTH] = {0};
+    size_t next;
+
+    if ((pRingBuffer->pBuffer != NULL) &&
+        (syncListLength <= U_RING_BUFFER_PARSER_SYNC_LIST_MAX_LENGTH) &&
+        ((pSyncList != NULL) || (syncListLength == 0))) {
 
         U_PORT_MUTEX_LOCK((uPortMutexHandle_t) pRingBuffer->mutex);
 
         if ((handle >= 0) && (handle < (int32_t) pRingBuffer->maxNumReadPointers) &&
             (pRingBuffer->pDataRead[handle] != NULL)) {
-            const char *pOffset = pPtrOffset(pRingBuffer->pDataRead[handle], 0, pRingBuffer->pBuffer,
-                                             pRingBuffer->size);
+            const char *pHead = pPtrOffset(pRingBuffer->pDataRead[handle], 0, pRingBuffer->pBuffer,
+                                           pRingBuffer->size);
+            const char *pOffset = pHead;
             size_t bytesAvailable = ptrDiff(pOffset, pRingBuffer->pDataWrite, pRingBuffer->size);
+            size_t bytesTotal = bytesAvailable;
             size_t bytesDiscard  = 0;
+            if (pRingBuffer->pParseState == NULL) {
+                // Parse state is only needed by those who parse, hence
+                // it is allocated here; if there is no memory for it
+                // then every parse simply starts from scratch
+                pRingBuffer->pParseState = pUPortMalloc(pRingBuffer->maxNumReadPointers *
+                                                        sizeof(uRingBufferParseState_t));
+                if (pRingBuffer->pParseState != NULL) {
+                    memset(pRingBuffer->pParseState, 0,
+                           pRingBuffer->maxNumReadPointers * sizeof(uRingBufferParseState_t));
+                }
+            }
+            if (pRingBuffer->pParseState != NULL) {
+                pState = ((uRingBufferParseState_t *) pRingBuffer->pParseState) + handle;
+            }
+            if (pState->pStart == pOffset) {
+                // Pick up where we left off, provided the parser
+                // that was part way through is still in the list
+                for (pParser = pParserList; (*pParser != NULL) && !resume; pParser++) {
+                    resume = (*pParser == pState->pParser);
+                }
+            }
             errorCodeOrLength = U_ERROR_COMMON_TIMEOUT;
             while (bytesAvailable) {
-                U_RING_BUFFER_PARSER_f *pParser = pParserList;
-                // find the right protocol
+                uRingBufferParseContext_t ctx = {
+                    .pRingBuffer    = pRingBuffer,
+                    .pSource        = pOffset,
+                    .bytesAvailable = bytesAvailable,
+                    .bytesParsed    = 0,
+                    .bytesDiscard   = bytesDiscard,
+                    .pState         = pState
+                };
                 errorCodeOrLength = U_ERROR_COMMON_NOT_FOUND;
-                while (*pParser) {
-                    uRingBufferParseContext_t ctx = {
-                        .pRingBuffer    = pRingBuffer,
-                        .pSource        = pOffset,
-                        .bytesAvailable = bytesAvailable,
-                        .bytesParsed    = 0,
-                        .bytesDiscard   = bytesDiscard
-                    };
+                if (resume) {
+                    // Only the bytes that have arrived since last
+                    // time need to be looked at
+                    resume = false;
+                    ctx.pSource = pPtrOffset(pOffset, pState->bytesParsed,
+                                             pRingBuffer->pBuffer, pRingBuffer->size);
+                    ctx.bytesAvailable -= pState->bytesParsed;
+                    ctx.bytesParsed = pState->bytesParsed;
+                    errorCodeOrLength = pState->pParser(&ctx, pUserParam);
+                }
+                // find the right protocol
+                for (pParser = pParserList; (*pParser != NULL) &&
+                     (errorCodeOrLength == U_ERROR_COMMON_NOT_FOUND); pParser++) {
+                    memset(pState->parser, 0, sizeof(pState->parser));
+                    pState->pParser = *pParser;
+                    ctx.pSource = pOffset;
+                    ctx.bytesAvailable = bytesAvailable;
+                    ctx.bytesParsed = 0;
                     errorCodeOrLength = (*pParser)(&ctx, pUserParam);
-                    pParser ++;
+                }
+                if (errorCodeOrLength == U_ERROR_COMMON_TIMEOUT) {
+                    // Remember how far we got for next time
+                    pState->pStart = pOffset;
+                    pState->bytesParsed = ctx.bytesParsed;
+                } else {
+                    pState->pStart = NULL;
                     if (errorCodeOrLength == U_ERROR_COMMON_SUCCESS) {
                         errorCodeOrLength = ctx.bytesParsed;
                     }
-                    if (errorCodeOrLength != U_ERROR_COMMON_NOT_FOUND) {
-                        break;
-                    }
                 }
                 if (errorCodeOrLength != U_ERROR_COMMON_NOT_FOUND) {
                     break;
                 }
-                pOffset = pPtrInc(pOffset, pRingBuffer->pBuffer, pRingBuffer->size);
-                bytesDiscard ++;
-                bytesAvailable --;
+                next = bytesDiscard + 1;
+                if (syncListLength > 0) {
+                    // Jump straight to the nearest sync byte, only
+                    // searching again for those we have passed
+                    next = bytesTotal;
+                    for (size_t x = 0; x < syncListLength; x++) {
+                        if (syncOffset[x] <= bytesDiscard) {
+                            syncOffset[x] = bytesDiscard + 1 +
+                                            findByte(pRingBuffer,
+                                                     pPtrInc(pOffset, pRingBuffer->pBuffer,
+                                                             pRingBuffer->size),
+                                                     bytesAvailable - 1, pSyncList[x]);
+                        }
+                        if (syncOffset[x] < next) {
+                            next = syncOffset[x];
+                        }
+                    }
+                }
+                pOffset = pPtrOffset(pHead, next, pRingBuffer->pBuffer, pRingBuffer->size);
+                bytesDiscard = next;
+                bytesAvailable = bytesTotal - next;
             }
             if (bytesDiscard > 0) {
                 errorCodeOrLength = bytesDiscard;
+                pState->statDiscardBytes += bytesDiscard;
             }
         }
 
@@ -869,7 +1227,6 @@ size_t uRingBufferParseHandle(uRingBuffer_t *pRingBuffer, int32_t handle,
     return errorCodeOrLength;
 }
 
-
 bool uRingBufferGetByteUnprotected(uParseHandle_t parseHandle, void *p)
 {
     uRingBufferParseContext_t *pCtx = (uRingBufferParseContext_t *)parseHandle;
@@ -896,4 +1253,30 @@ size_t uRingBufferBytesDiscardUnprotected(uParseHandle_t parseHandle)
     return pCtx->bytesDiscard;
 }
 
+size_t uRingBufferStatParseDiscardHandle(uRingBuffer_t *pRingBuffer,
+                                         int32_t handle)
+{
+    size_t discardBytes = 0;
+
+    if (pRingBuffer->pBuffer != NULL) {
+
+        U_PORT_MUTEX_LOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+
+        if ((handle >= 0) && (handle < (int32_t) pRingBuffer->maxNumReadPointers) &&
+            (pRingBuffer->pParseState != NULL)) {
+            discardBytes = ((uRingBufferParseState_t *) pRingBuffer->pParseState)[handle].statDiscardBytes;
+        }
+
+        U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+    }
+
+    return discardBytes;
+}
+
+void *pURingBufferParserStateUnprotected(uParseHandle_t parseHandle)
+{
+    uRingBufferParseContext_t *pCtx = (uRingBufferParseContext_t *)parseHandle;
+    return pCtx->pState->parser;
+}
+
 // End of file
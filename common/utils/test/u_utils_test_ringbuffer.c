@@ -882,4 +882,127 @@ U_PORT_TEST_FUNCTION("[ringbuffer]", "ringbufferBasic")
     U_PORT_TEST_ASSERT((heapUsed == 0) || (heapUsed == (int32_t)U_ERROR_COMMON_NOT_SUPPORTED));
 }
 
+U_PORT_TEST_FUNCTION("[ringbuffer]", "ringbufferRegion")
+{
+    int32_t heapUsed;
+    uRingBuffer_t ringBuffer = {0};
+    char linearBuffer[U_TEST_UTILS_RINGBUFFER_SIZE + 1];
+    char bufferOut[U_TEST_UTILS_RINGBUFFER_SIZE + 1];
+    char bufferIn[U_TEST_UTILS_RINGBUFFER_SIZE + 1];
+    int32_t handle;
+    int32_t handleDuplicate;
+    char *pRegion = NULL;
+    const char *pPeek = NULL;
+    size_t y;
+    size_t z;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    heapUsed = uPortGetHeapFree();
+
+    U_TEST_PRINT_LINE("testing ring buffer regions.");
+    for (size_t x = 0; x < sizeof(bufferIn); x++) {
+        bufferIn[x] = (char) x;
+    }
+    memset(linearBuffer, 0, sizeof(linearBuffer));
+    U_PORT_TEST_ASSERT(uRingBufferCreateWithReadHandle(&ringBuffer, linearBuffer, sizeof(linearBuffer),
+                                                       U_TEST_UTILS_RINGBUFFER_READ_HANDLES_MAX_NUM) == 0);
+    uRingBufferSetReadRequiresHandle(&ringBuffer, true);
+    handle = uRingBufferTakeReadHandle(&ringBuffer);
+    U_PORT_TEST_ASSERT(handle >= 0);
+
+    // Move the read/write pointers to the middle of the
+    // linear buffer so that the data has to wrap
+    U_PORT_TEST_ASSERT(uRingBufferAdd(&ringBuffer, bufferIn, sizeof(bufferIn) / 2));
+    U_PORT_TEST_ASSERT(uRingBufferReadHandle(&ringBuffer, handle, NULL,
+                                             sizeof(bufferIn) / 2) == sizeof(bufferIn) / 2);
+
+    // Take a region: it must stop at the end of the linear buffer
+    y = uRingBufferTakeWriteRegion(&ringBuffer, &pRegion, sizeof(bufferIn));
+    U_TEST_PRINT_LINE(" first write region is %d byte(s).", y);
+    U_PORT_TEST_ASSERT(y == sizeof(linearBuffer) - sizeof(bufferIn) / 2);
+    U_PORT_TEST_ASSERT(pRegion == linearBuffer + sizeof(bufferIn) / 2);
+    // While it is outstanding no-one else may write
+    pPeek = NULL;
+    U_PORT_TEST_ASSERT(uRingBufferTakeWriteRegion(&ringBuffer, (char **) &pPeek, 1) == 0);
+    U_PORT_TEST_ASSERT(!uRingBufferAdd(&ringBuffer, bufferIn, 1));
+    U_PORT_TEST_ASSERT(uRingBufferDataSizeHandle(&ringBuffer, handle) == 0);
+    memcpy(pRegion, bufferIn, y);
+    uRingBufferGiveWriteRegion(&ringBuffer, y);
+    U_PORT_TEST_ASSERT(uRingBufferDataSizeHandle(&ringBuffer, handle) == y);
+    // Now the wrapped part; there is only room for
+    // the ring buffer size minus one in total
+    z = uRingBufferTakeWriteRegion(&ringBuffer, &pRegion, sizeof(bufferIn));
+    U_TEST_PRINT_LINE(" second write region is %d byte(s).", z);
+    U_PORT_TEST_ASSERT(z == sizeof(linearBuffer) - 1 - y);
+    U_PORT_TEST_ASSERT(pRegion == linearBuffer);
+    memcpy(pRegion, bufferIn + y, z);
+    // Commit one byte less than we took
+    uRingBufferGiveWriteRegion(&ringBuffer, z - 1);
+    U_PORT_TEST_ASSERT(uRingBufferDataSizeHandle(&ringBuffer, handle) == y + z - 1);
+
+    // Peek at the data in place, in two goes
+    U_PORT_TEST_ASSERT(uRingBufferPeekRegionHandle(&ringBuffer, handle, &pPeek, 0) == y);
+    U_PORT_TEST_ASSERT(memcmp(pPeek, bufferIn, y) == 0);
+    U_PORT_TEST_ASSERT(uRingBufferPeekRegionHandle(&ringBuffer, handle, &pPeek, y) == z - 1);
+    U_PORT_TEST_ASSERT(memcmp(pPeek, bufferIn + y, z - 1) == 0);
+    U_PORT_TEST_ASSERT(uRingBufferPeekRegionHandle(&ringBuffer, handle, &pPeek, y + z - 1) == 0);
+
+    // A normal read across the wrap should give the same thing
+    memset(bufferOut, U_TEST_UTILS_RINGBUFFER_FILL_CHAR, sizeof(bufferOut));
+    U_PORT_TEST_ASSERT(uRingBufferPeekHandle(&ringBuffer, handle, bufferOut,
+                                             sizeof(bufferOut), 0) == y + z - 1);
+    U_PORT_TEST_ASSERT(memcmp(bufferOut, bufferIn, y + z - 1) == 0);
+    U_PORT_TEST_ASSERT(bufferOut[y + z - 1] == U_TEST_UTILS_RINGBUFFER_FILL_CHAR);
+
+    // A duplicate of the read handle should see the same data,
+    // independently of the original
+    handleDuplicate = uRingBufferDuplicateReadHandle(&ringBuffer, handle);
+    U_PORT_TEST_ASSERT(handleDuplicate >= 0);
+    U_PORT_TEST_ASSERT(handleDuplicate != handle);
+    U_PORT_TEST_ASSERT(!uRingBufferReadHandleIsLocked(&ringBuffer, handleDuplicate));
+    U_PORT_TEST_ASSERT(uRingBufferDataSizeHandle(&ringBuffer, handleDuplicate) == y + z - 1);
+    U_PORT_TEST_ASSERT(uRingBufferReadHandle(&ringBuffer, handleDuplicate, NULL, 1) == 1);
+    U_PORT_TEST_ASSERT(uRingBufferDataSizeHandle(&ringBuffer, handle) == y + z - 1);
+    uRingBufferGiveReadHandle(&ringBuffer, handleDuplicate);
+    U_PORT_TEST_ASSERT(uRingBufferDuplicateReadHandle(&ringBuffer, handleDuplicate) < 0);
+
+    // There is one byte left: with the read handle locked, even
+    // a forced take should only get that one byte...
+    uRingBufferLockReadHandle(&ringBuffer, handle);
+    U_PORT_TEST_ASSERT(uRingBufferTakeWriteRegion(&ringBuffer, &pRegion, sizeof(bufferIn)) == 1);
+    uRingBufferGiveWriteRegion(&ringBuffer, 0);
+    U_PORT_TEST_ASSERT(uRingBufferForceTakeWriteRegion(&ringBuffer, &pRegion, sizeof(bufferIn)) == 1);
+    uRingBufferGiveWriteRegion(&ringBuffer, 0);
+    // ...while a forced take, once it is unlocked, pushes the
+    // read pointer on, counting the loss
+    uRingBufferUnlockReadHandle(&ringBuffer, handle);
+    y = uRingBufferForceTakeWriteRegion(&ringBuffer, &pRegion, 2);
+    U_PORT_TEST_ASSERT(y == 2);
+    U_PORT_TEST_ASSERT(uRingBufferStatReadLossHandle(&ringBuffer, handle) == 1);
+    memcpy(pRegion, bufferIn, y);
+    uRingBufferGiveWriteRegion(&ringBuffer, y);
+    U_PORT_TEST_ASSERT(uRingBufferDataSizeHandle(&ringBuffer, handle) == sizeof(linearBuffer) - 1);
+
+    // A reset should cancel an outstanding region
+    U_PORT_TEST_ASSERT(uRingBufferForceTakeWriteRegion(&ringBuffer, &pRegion, 1) == 1);
+    uRingBufferReset(&ringBuffer);
+    uRingBufferGiveWriteRegion(&ringBuffer, 1);
+    U_PORT_TEST_ASSERT(uRingBufferDataSizeHandle(&ringBuffer, handle) == 0);
+    U_PORT_TEST_ASSERT(uRingBufferAdd(&ringBuffer, bufferIn, 1));
+
+    uRingBufferGiveReadHandle(&ringBuffer, handle);
+    U_TEST_PRINT_LINE("deleting ring buffer...");
+    uRingBufferDelete(&ringBuffer);
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("we have leaked %d byte(s).", heapUsed);
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT((heapUsed == 0) || (heapUsed == (int32_t)U_ERROR_COMMON_NOT_SUPPORTED));
+}
+
 // End of file
\ No newline at end of file
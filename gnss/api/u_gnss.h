@@ -251,6 +251,26 @@ bool uGnssGetUbxMessagePrint(uDeviceHandle_t gnssHandle);
  */
 void uGnssSetUbxMessagePrint(uDeviceHandle_t gnssHandle, bool onNotOff);
 
+/** Get the usage statistics of the buffer pool that is used when
+ * encoding UBX messages to send to, and receiving UBX messages
+ * from, the GNSS chip.  Each GNSS instance has a small pool of
+ * buffers (see U_GNSS_BUFFER_POOL_NUM_BLOCKS and
+ * U_GNSS_BUFFER_POOL_BLOCK_LENGTH_BYTES), allocated once on first
+ * use; where a pool buffer is not available, or a message is too
+ * large for one, a buffer is instead allocated from the heap.
+ *
+ * @param gnssHandle   the handle of the GNSS instance.
+ * @param pPoolCount   a place to put the number of times a buffer
+ *                     was obtained from the pool; may be NULL.
+ * @param pHeapCount   a place to put the number of times a buffer
+ *                     had to be allocated from the heap instead;
+ *                     may be NULL.
+ * @return             zero on success else negative error code.
+ */
+int32_t uGnssGetBufferPoolStats(uDeviceHandle_t gnssHandle,
+                                int32_t *pPoolCount,
+                                int32_t *pHeapCount);
+
 #ifdef __cplusplus
 }
 #endif
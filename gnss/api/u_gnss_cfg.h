@@ -112,6 +112,12 @@ extern "C" {
                        U_GNSS_CFG_VAL_LAYER_BBRAM |                        \
                        U_GNSS_CFG_VAL_LAYER_FLASH)
 
+/** The maximum number of values that can be stored in a VALXXX
+ * message; this is also the number of values that
+ * uGnssCfgValSetBatchAdd() will accumulate before sending them.
+ */
+#define U_GNSS_CFG_VAL_MSG_MAX_NUM_VALUES 64
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -172,6 +178,42 @@ typedef enum {
     U_GNSS_CFG_VAL_LAYER_MAX_NUM
 } uGnssCfgValLayer_t;
 
+/** Structure to hold the state of a batched VALSET operation, see
+ * uGnssCfgValSetBatchBegin(); the contents should be treated as
+ * read-only by the application, other than the failure information
+ * which may be read after uGnssCfgValSetBatchAdd() or
+ * uGnssCfgValSetBatchCommit() has returned an error.  Note that this
+ * structure is over 1 kbyte in size: you may prefer to allocate it
+ * rather than put it on the stack.
+ */
+typedef struct {
+    uDeviceHandle_t gnssHandle; /**< the GNSS instance the batch is for. */
+    uint32_t layers;            /**< the layers the values are set in. */
+    int32_t errorCode;          /**< the first error that occurred, zero
+                                     if there has been none. */
+    int32_t numValuesTotal;     /**< the number of values added so far. */
+    int32_t numMessagesSent;    /**< the number of UBX-CFG-VALSET messages
+                                     sent so far. */
+    int32_t failedIndex;        /**< if errorCode is non-zero, the index
+                                     (counting from zero in the order
+                                     the values were added) of the first
+                                     value in the UBX-CFG-VALSET message
+                                     that the GNSS chip rejected; since the
+                                     GNSS chip does not say which value in a
+                                     message was at fault, one of the
+                                     failedCount values from here on is the
+                                     culprit.  -1 if there was no error or
+                                     the error cannot be attributed to
+                                     particular values. */
+    int32_t failedCount;        /**< if errorCode is non-zero, the number
+                                     of values in the UBX-CFG-VALSET message
+                                     that the GNSS chip rejected. */
+    size_t numValues;           /**< the number of values in list[] that
+                                     have not yet been sent. */
+    uGnssCfgVal_t list[U_GNSS_CFG_VAL_MSG_MAX_NUM_VALUES]; /**< values
+                                                                 not yet sent. */
+} uGnssCfgValSetBatch_t;
+
 /* ----------------------------------------------------------------
  * FUNCTIONS: SPECIFIC CONFIGURATION FUNCTIONS
  * -------------------------------------------------------------- */
@@ -605,6 +647,79 @@ int32_t uGnssCfgValDelListX(uDeviceHandle_t gnssHandle,
                             uGnssCfgValTransaction_t transaction,
                             uint32_t layers);
 
+/* ----------------------------------------------------------------
+ * FUNCTIONS: BATCHED CONFIGURATION USING VALSET, FROM M9
+ * -------------------------------------------------------------- */
+
+/** Begin a batched set of configuration items; only applicable to
+ * M9 modules and beyond, uses the UBX-CFG-VALSET mechanism.  This is
+ * for when a large number of values are to be set, e.g. at boot:
+ * rather than calling uGnssCfgValSet() for each value, with a
+ * round-trip to the GNSS chip every time, call this function, then
+ * call uGnssCfgValSetBatchAdd() for each value and finally call
+ * uGnssCfgValSetBatchCommit().  Values are packed into as few
+ * UBX-CFG-VALSET messages as possible, each carrying up to
+ * #U_GNSS_CFG_VAL_MSG_MAX_NUM_VALUES values; where more than one
+ * message is required the VALSET transaction mechanism is used so that
+ * the GNSS chip applies all of the values at once, on commit.
+ *
+ * No other set/del operations should be performed on the GNSS
+ * instance while a batch is in progress since that would cancel
+ * the transaction inside the GNSS chip.
+ *
+ * @param gnssHandle  the handle of the GNSS instance.
+ * @param[out] pBatch a pointer to storage for the batch state;
+ *                    cannot be NULL.
+ * @param layers      the layers to set the values in, a bit-map of
+ *                    #uGnssCfgValLayer_t values OR'ed together, as
+ *                    for uGnssCfgValSetList().
+ * @return            zero on success else negative error code.
+ */
+int32_t uGnssCfgValSetBatchBegin(uDeviceHandle_t gnssHandle,
+                                 uGnssCfgValSetBatch_t *pBatch,
+                                 uint32_t layers);
+
+/** Add a value to a batch begun with uGnssCfgValSetBatchBegin().
+ * Nothing is sent to the GNSS chip unless the batch already holds
+ * #U_GNSS_CFG_VAL_MSG_MAX_NUM_VALUES values, in which case they
+ * are sent as part of a transaction to make room.  Once an error has
+ * occurred all further calls return that error without sending
+ * anything.  If sending fails, the transaction is cancelled in
+ * the GNSS chip, as described for uGnssCfgValSetBatchCommit().
+ *
+ * @param[in] pBatch  a pointer to the batch; cannot be NULL.
+ * @param keyId       the key ID of the configuration value to set.
+ * @param value       the value to set.
+ * @return            zero on success else negative error code; on
+ *                    error the failedIndex and failedCount fields of
+ *                    the batch may be read to determine which values
+ *                    were rejected by the GNSS chip.
+ */
+int32_t uGnssCfgValSetBatchAdd(uGnssCfgValSetBatch_t *pBatch,
+                               uint32_t keyId, uint64_t value);
+
+/** Send any values remaining in a batch to the GNSS chip and have
+ * it apply all of the values of the batch.  If the batch fitted into
+ * a single UBX-CFG-VALSET message then no transaction is used.  Once
+ * this function has returned the batch is finished with: a new batch
+ * must be begun with uGnssCfgValSetBatchBegin().
+ *
+ * If a message of a multi-message batch is NACKed or not responded
+ * to, an empty transactionless UBX-CFG-VALSET is sent to cancel the
+ * transaction in the GNSS chip before the error is returned; none of
+ * the values of the batch are then applied, not even those in messages
+ * that were Acked.  Should that cancellation itself not get through,
+ * the transaction is left open and will be discarded by the next
+ * set/del operation on the GNSS chip.
+ *
+ * @param[in] pBatch  a pointer to the batch; cannot be NULL.
+ * @return            zero on success else negative error code; on
+ *                    error the failedIndex and failedCount fields of
+ *                    the batch may be read to determine which values
+ *                    were rejected by the GNSS chip.
+ */
+int32_t uGnssCfgValSetBatchCommit(uGnssCfgValSetBatch_t *pBatch);
+
 #ifdef __cplusplus
 }
 #endif
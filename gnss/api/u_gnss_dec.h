@@ -0,0 +1,637 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _U_GNSS_DEC_H_
+#define _U_GNSS_DEC_H_
+
+/* Only header files representing a direct and unavoidable
+ * dependency between the API of this module and the API
+ * of another module should be included here; otherwise
+ * please keep #includes to your .c files. */
+
+#include "u_gnss_msg.h" // uGnssMsgView_t
+
+/** \addtogroup _GNSS
+ *  @{
+ */
+
+/** @file
+ * @brief This header file defines the UBX message decoders of the
+ * GNSS API.  Each decoder takes the body of a UBX message, as a
+ * #uGnssMsgView_t (i.e. possibly in two pieces, straight out of the
+ * internal ring buffer), and fills in a fixed-layout structure with
+ * the fields of the message converted to native endianness; no
+ * memory is allocated and the message does not need to be copied
+ * into a contiguous buffer first.  The field names are those of the
+ * u-blox interface description.
+ *
+ * For messages that carry a variable number of repeated blocks
+ * (e.g. one per satellite in UBX-NAV-SAT) the decoder for the
+ * message fills in the fixed part and returns the number of
+ * blocks, then each block is decoded by index with the
+ * corresponding "block" decoder, so that no array of blocks need
+ * be allocated.
+ *
+ * To use these decoders from a #uGnssMsgReceiveViewCallback_t,
+ * call uGnssDecUbxBody() to obtain the view of the message body
+ * from the view of the whole message; to use them on a message
+ * body in a contiguous buffer simply set pData1 to the buffer,
+ * size1 to its length and size2 to zero.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** The message class/ID of UBX-NAV-PVT, as returned by
+ * uGnssDecUbxBody().
+ */
+#define U_GNSS_DEC_UBX_ID_NAV_PVT 0x0107
+
+/** The message class/ID of UBX-NAV-STATUS.
+ */
+#define U_GNSS_DEC_UBX_ID_NAV_STATUS 0x0103
+
+/** The message class/ID of UBX-NAV-SAT.
+ */
+#define U_GNSS_DEC_UBX_ID_NAV_SAT 0x0135
+
+/** The message class/ID of UBX-MON-VER.
+ */
+#define U_GNSS_DEC_UBX_ID_MON_VER 0x0a04
+
+/** The message class/ID of UBX-MON-COMMS.
+ */
+#define U_GNSS_DEC_UBX_ID_MON_COMMS 0x0a36
+
+/** The message class/ID of UBX-RXM-RAWX.
+ */
+#define U_GNSS_DEC_UBX_ID_RXM_RAWX 0x0215
+
+/** The message class/ID of UBX-TIM-TP.
+ */
+#define U_GNSS_DEC_UBX_ID_TIM_TP 0x0d01
+
+/** The message class/ID of UBX-ESF-ALG.
+ */
+#define U_GNSS_DEC_UBX_ID_ESF_ALG 0x1014
+
+/** The message class/ID of UBX-ESF-INS.
+ */
+#define U_GNSS_DEC_UBX_ID_ESF_INS 0x1015
+
+/** The message class/ID of UBX-ESF-MEAS.
+ */
+#define U_GNSS_DEC_UBX_ID_ESF_MEAS 0x1002
+
+/** The message class/ID of UBX-ESF-RAW.
+ */
+#define U_GNSS_DEC_UBX_ID_ESF_RAW 0x1003
+
+/** The message class/ID of UBX-ESF-STATUS.
+ */
+#define U_GNSS_DEC_UBX_ID_ESF_STATUS 0x1010
+
+/** The length of the body of a UBX-NAV-PVT message.
+ */
+#define U_GNSS_DEC_UBX_NAV_PVT_BODY_LENGTH_BYTES 92
+
+/** The length of the body of a UBX-NAV-STATUS message.
+ */
+#define U_GNSS_DEC_UBX_NAV_STATUS_BODY_LENGTH_BYTES 16
+
+/** The length of the body of a UBX-TIM-TP message.
+ */
+#define U_GNSS_DEC_UBX_TIM_TP_BODY_LENGTH_BYTES 16
+
+/** The length of the body of a UBX-ESF-ALG message.
+ */
+#define U_GNSS_DEC_UBX_ESF_ALG_BODY_LENGTH_BYTES 16
+
+/** The length of the body of a UBX-ESF-INS message.
+ */
+#define U_GNSS_DEC_UBX_ESF_INS_BODY_LENGTH_BYTES 36
+
+/** The length of the software version string in UBX-MON-VER,
+ * not including a null terminator.
+ */
+#define U_GNSS_DEC_UBX_MON_VER_SW_VERSION_LENGTH_BYTES 30
+
+/** The length of the hardware version string in UBX-MON-VER,
+ * not including a null terminator.
+ */
+#define U_GNSS_DEC_UBX_MON_VER_HW_VERSION_LENGTH_BYTES 10
+
+/** The length of each extension string in UBX-MON-VER,
+ * not including a null terminator.
+ */
+#define U_GNSS_DEC_UBX_MON_VER_EXTENSION_LENGTH_BYTES 30
+
+/** The number of protocol IDs in UBX-MON-COMMS.
+ */
+#define U_GNSS_DEC_UBX_MON_COMMS_NUM_PROT_IDS 4
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** UBX-NAV-PVT: navigation position velocity time solution.
+ */
+typedef struct {
+    uint32_t iTOW;    /**< GPS time of week of the navigation epoch in milliseconds. */
+    uint16_t year;    /**< year (UTC). */
+    uint8_t month;    /**< month, 1 to 12 (UTC). */
+    uint8_t day;      /**< day of month, 1 to 31 (UTC). */
+    uint8_t hour;     /**< hour of day, 0 to 23 (UTC). */
+    uint8_t min;      /**< minute of hour, 0 to 59 (UTC). */
+    uint8_t sec;      /**< seconds of minute, 0 to 60 (UTC). */
+    uint8_t valid;    /**< validity flags: bit 0 date, bit 1 time,
+                           bit 2 fully resolved, bit 3 magnetic
+                           declination. */
+    uint32_t tAcc;    /**< time accuracy estimate in nanoseconds. */
+    int32_t nano;     /**< fraction of second in nanoseconds. */
+    uint8_t fixType;  /**< 0 no fix, 1 dead reckoning only, 2 2D,
+                           3 3D, 4 GNSS plus dead reckoning,
+                           5 time only. */
+    uint8_t flags;    /**< fix status flags, bit 0 being gnssFixOK. */
+    uint8_t flags2;   /**< additional flags. */
+    uint8_t numSV;    /**< number of satellites used in the solution. */
+    int32_t lon;      /**< longitude in degrees * 1e7. */
+    int32_t lat;      /**< latitude in degrees * 1e7. */
+    int32_t height;   /**< height above ellipsoid in millimetres. */
+    int32_t hMSL;     /**< height above mean sea level in millimetres. */
+    uint32_t hAcc;    /**< horizontal accuracy estimate in millimetres. */
+    uint32_t vAcc;    /**< vertical accuracy estimate in millimetres. */
+    int32_t velN;     /**< NED north velocity in millimetres per second. */
+    int32_t velE;     /**< NED east velocity in millimetres per second. */
+    int32_t velD;     /**< NED down velocity in millimetres per second. */
+    int32_t gSpeed;   /**< ground speed in millimetres per second. */
+    int32_t headMot;  /**< heading of motion in degrees * 1e5. */
+    uint32_t sAcc;    /**< speed accuracy estimate in millimetres per second. */
+    uint32_t headAcc; /**< heading accuracy estimate in degrees * 1e5. */
+    uint16_t pDOP;    /**< position dilution of precision * 100. */
+    uint16_t flags3;  /**< additional flags. */
+    int32_t headVeh;  /**< heading of vehicle in degrees * 1e5. */
+    int16_t magDec;   /**< magnetic declination in degrees * 100. */
+    uint16_t magAcc;  /**< magnetic declination accuracy in degrees * 100. */
+} uGnssDecUbxNavPvt_t;
+
+/** UBX-NAV-STATUS: receiver navigation status.
+ */
+typedef struct {
+    uint32_t iTOW;   /**< GPS time of week of the navigation epoch in milliseconds. */
+    uint8_t gpsFix;  /**< fix type, as for fixType in #uGnssDecUbxNavPvt_t. */
+    uint8_t flags;   /**< navigation status flags, bit 0 being gpsFixOk. */
+    uint8_t fixStat; /**< fix status information. */
+    uint8_t flags2;  /**< further information about navigation output. */
+    uint32_t ttff;   /**< time to first fix in milliseconds. */
+    uint32_t msss;   /**< milliseconds since startup or reset. */
+} uGnssDecUbxNavStatus_t;
+
+/** The fixed part of UBX-NAV-SAT: satellite information.
+ */
+typedef struct {
+    uint32_t iTOW;   /**< GPS time of week of the navigation epoch in milliseconds. */
+    uint8_t version; /**< message version. */
+    uint8_t numSvs;  /**< number of satellites. */
+} uGnssDecUbxNavSat_t;
+
+/** One satellite block of UBX-NAV-SAT.
+ */
+typedef struct {
+    uint8_t gnssId; /**< GNSS identifier. */
+    uint8_t svId;   /**< satellite identifier. */
+    uint8_t cno;    /**< carrier to noise ratio in dBHz. */
+    int8_t elev;    /**< elevation in degrees, -90 to +90. */
+    int16_t azim;   /**< azimuth in degrees, 0 to 360. */
+    int16_t prRes;  /**< pseudorange residual in metres * 10. */
+    uint32_t flags; /**< bitmask, bits 0 to 2 being the signal quality. */
+} uGnssDecUbxNavSatSv_t;
+
+/** The fixed part of UBX-MON-VER: receiver and software version.
+ */
+typedef struct {
+    /** null-terminated software version string. */
+    char swVersion[U_GNSS_DEC_UBX_MON_VER_SW_VERSION_LENGTH_BYTES + 1];
+    /** null-terminated hardware version string. */
+    char hwVersion[U_GNSS_DEC_UBX_MON_VER_HW_VERSION_LENGTH_BYTES + 1];
+} uGnssDecUbxMonVer_t;
+
+/** One extension block of UBX-MON-VER.
+ */
+typedef struct {
+    /** null-terminated extended version information string. */
+    char extension[U_GNSS_DEC_UBX_MON_VER_EXTENSION_LENGTH_BYTES + 1];
+} uGnssDecUbxMonVerExtension_t;
+
+/** The fixed part of UBX-MON-COMMS: communication port information.
+ */
+typedef struct {
+    uint8_t version;  /**< message version. */
+    uint8_t nPorts;   /**< the number of ports. */
+    uint8_t txErrors; /**< TX error bitmask. */
+    /** the protocol IDs to which the msgs counts of
+        #uGnssDecUbxMonCommsPort_t refer, 0 for UBX,
+        1 for NMEA, 2 for RTCM2, 5 for RTCM3, 6 for SPARTN,
+        0xFF for none. */
+    uint8_t protIds[U_GNSS_DEC_UBX_MON_COMMS_NUM_PROT_IDS];
+} uGnssDecUbxMonComms_t;
+
+/** One port block of UBX-MON-COMMS.
+ */
+typedef struct {
+    uint16_t portId;      /**< the port identifier, e.g. 0x0100 for UART1. */
+    uint16_t txPending;   /**< the number of bytes pending in the transmit buffer. */
+    uint32_t txBytes;     /**< the number of bytes ever sent. */
+    uint8_t txUsage;      /**< maximum usage of the transmit buffer during
+                               the last sysmon period in percent. */
+    uint8_t txPeakUsage;  /**< maximum usage of the transmit buffer in percent. */
+    uint16_t rxPending;   /**< the number of bytes in the receive buffer. */
+    uint32_t rxBytes;     /**< the number of bytes ever received. */
+    uint8_t rxUsage;      /**< maximum usage of the receive buffer during
+                               the last sysmon period in percent. */
+    uint8_t rxPeakUsage;  /**< maximum usage of the receive buffer in percent. */
+    uint16_t overrunErrs; /**< the number of 100 ms timeslots with overrun errors. */
+    /** the number of messages parsed for each of the protocols in
+        protIds of #uGnssDecUbxMonComms_t. */
+    uint16_t msgs[U_GNSS_DEC_UBX_MON_COMMS_NUM_PROT_IDS];
+    uint32_t skipped;     /**< the number of skipped bytes. */
+} uGnssDecUbxMonCommsPort_t;
+
+/** The fixed part of UBX-RXM-RAWX: multi-GNSS raw measurements.
+ */
+typedef struct {
+    double rcvTow;   /**< receiver time of week in seconds. */
+    uint16_t week;   /**< GPS week number. */
+    int8_t leapS;    /**< GPS leap seconds. */
+    uint8_t numMeas; /**< number of measurements to follow. */
+    uint8_t recStat; /**< receiver tracking status bitfield. */
+    uint8_t version; /**< message version. */
+} uGnssDecUbxRxmRawx_t;
+
+/** One measurement block of UBX-RXM-RAWX.
+ */
+typedef struct {
+    double prMes;     /**< pseudorange measurement in metres. */
+    double cpMes;     /**< carrier phase measurement in cycles. */
+    float doMes;      /**< Doppler measurement in Hz. */
+    uint8_t gnssId;   /**< GNSS identifier. */
+    uint8_t svId;     /**< satellite identifier. */
+    uint8_t sigId;    /**< signal identifier. */
+    uint8_t freqId;   /**< GLONASS frequency slot + 7. */
+    uint16_t locktime; /**< carrier phase locktime counter in milliseconds. */
+    uint8_t cno;      /**< carrier to noise ratio in dBHz. */
+    uint8_t prStdev;  /**< estimated pseudorange standard deviation. */
+    uint8_t cpStdev;  /**< estimated carrier phase standard deviation. */
+    uint8_t doStdev;  /**< estimated Doppler standard deviation. */
+    uint8_t trkStat;  /**< tracking status bitfield. */
+} uGnssDecUbxRxmRawxMeas_t;
+
+/** UBX-TIM-TP: time pulse time data.
+ */
+typedef struct {
+    uint32_t towMS;    /**< time pulse time of week in milliseconds. */
+    uint32_t towSubMS; /**< submillisecond part of towMS in milliseconds * 2^-32. */
+    int32_t qErr;      /**< quantization error of the time pulse in picoseconds. */
+    uint16_t week;     /**< time pulse week number. */
+    uint8_t flags;     /**< flags, bits 0 to 1 being the time base. */
+    uint8_t refInfo;   /**< time reference information. */
+} uGnssDecUbxTimTp_t;
+
+/** UBX-ESF-ALG: IMU alignment information.
+ */
+typedef struct {
+    uint32_t iTOW;   /**< GPS time of week of the navigation epoch in milliseconds. */
+    uint8_t version; /**< message version. */
+    uint8_t flags;   /**< flags, bits 1 to 3 being the alignment status. */
+    uint8_t errors;  /**< error bitfield. */
+    uint32_t yaw;    /**< IMU mount yaw angle in degrees * 100. */
+    int16_t pitch;   /**< IMU mount pitch angle in degrees * 100. */
+    int16_t roll;    /**< IMU mount roll angle in degrees * 100. */
+} uGnssDecUbxEsfAlg_t;
+
+/** UBX-ESF-INS: vehicle dynamics information.
+ */
+typedef struct {
+    uint32_t bitfield0; /**< validity flags. */
+    uint32_t iTOW;      /**< GPS time of week of the navigation epoch in milliseconds. */
+    int32_t xAngRate;   /**< compensated x-axis angular rate in degrees per second * 1e3. */
+    int32_t yAngRate;   /**< compensated y-axis angular rate in degrees per second * 1e3. */
+    int32_t zAngRate;   /**< compensated z-axis angular rate in degrees per second * 1e3. */
+    int32_t xAccel;     /**< compensated x-axis acceleration in metres per second squared * 100. */
+    int32_t yAccel;     /**< compensated y-axis acceleration in metres per second squared * 100. */
+    int32_t zAccel;     /**< compensated z-axis acceleration in metres per second squared * 100. */
+} uGnssDecUbxEsfIns_t;
+
+/** The fixed part of UBX-ESF-MEAS: external sensor fusion measurements.
+ */
+typedef struct {
+    uint32_t timeTag;      /**< time tag of the measurement. */
+    uint16_t flags;        /**< flags, bits 11 to 15 being numMeas. */
+    uint16_t id;           /**< identification number of the data provider. */
+    uint8_t numMeas;       /**< the number of measurements, from flags. */
+    bool calibTtagValid;   /**< true if calibTtag is present. */
+    uint32_t calibTtag;    /**< receiver local time calibrated in
+                                milliseconds, only valid if
+                                calibTtagValid is true. */
+} uGnssDecUbxEsfMeas_t;
+
+/** One data block of UBX-ESF-MEAS or of UBX-ESF-RAW.
+ */
+typedef struct {
+    int32_t dataField; /**< the data, sign-extended from 24 bits. */
+    uint8_t dataType;  /**< the type of the data. */
+    uint32_t sTtag;    /**< the sensor time tag, UBX-ESF-RAW only. */
+} uGnssDecUbxEsfData_t;
+
+/** The fixed part of UBX-ESF-STATUS: external sensor fusion status.
+ */
+typedef struct {
+    uint32_t iTOW;      /**< GPS time of week of the navigation epoch in milliseconds. */
+    uint8_t version;    /**< message version. */
+    uint8_t fusionMode; /**< 0 initialisation, 1 fusion, 2 suspended, 3 disabled. */
+    uint8_t numSens;    /**< the number of sensors. */
+} uGnssDecUbxEsfStatus_t;
+
+/** One sensor block of UBX-ESF-STATUS.
+ */
+typedef struct {
+    uint8_t sensStatus1; /**< sensor status, part 1. */
+    uint8_t sensStatus2; /**< sensor status, part 2. */
+    uint8_t freq;        /**< observation frequency in Hz. */
+    uint8_t faults;      /**< sensor faults. */
+} uGnssDecUbxEsfStatusSens_t;
+
+/* ----------------------------------------------------------------
+ * FUNCTIONS
+ * -------------------------------------------------------------- */
+
+/** Given the view of a whole UBX message, as passed to a
+ * #uGnssMsgReceiveViewCallback_t, check the header and obtain a view
+ * of the message body, which is what the decoders below take.  The
+ * CRC is not checked, the message receive task will have done that
+ * already.
+ *
+ * @param[in] pMessage  the view of the whole UBX message, header,
+ *                      body and CRC; cannot be NULL.
+ * @param[out] pBody    a place to put the view of the body of the
+ *                      message; may be the same as pMessage, cannot
+ *                      be NULL.
+ * @return              on success the message class in the upper
+ *                      byte and the message ID in the lower byte
+ *                      (e.g. #U_GNSS_DEC_UBX_ID_NAV_PVT), else
+ *                      negative error code.
+ */
+int32_t uGnssDecUbxBody(const uGnssMsgView_t *pMessage, uGnssMsgView_t *pBody);
+
+/** Decode the body of a UBX-NAV-PVT message.
+ *
+ * @param[in] pBody     the body of the message; cannot be NULL.
+ * @param[out] pNavPvt  a place to put the decoded message; cannot
+ *                      be NULL.
+ * @return              zero on success else negative error code.
+ */
+int32_t uGnssDecUbxNavPvt(const uGnssMsgView_t *pBody,
+                          uGnssDecUbxNavPvt_t *pNavPvt);
+
+/** Get the UTC time from a decoded UBX-NAV-PVT message.
+ *
+ * @param[in] pNavPvt  the decoded message; cannot be NULL.
+ * @return             the UTC time in seconds since midnight on
+ *                     1st January 1970, or -1 if the date and
+ *                     time in the message are not valid.
+ */
+int64_t uGnssDecUbxNavPvtGetTimeUtc(const uGnssDecUbxNavPvt_t *pNavPvt);
+
+/** Decode the body of a UBX-NAV-STATUS message.
+ *
+ * @param[in] pBody        the body of the message; cannot be NULL.
+ * @param[out] pNavStatus  a place to put the decoded message; cannot
+ *                         be NULL.
+ * @return                 zero on success else negative error code.
+ */
+int32_t uGnssDecUbxNavStatus(const uGnssMsgView_t *pBody,
+                             uGnssDecUbxNavStatus_t *pNavStatus);
+
+/** Decode the fixed part of the body of a UBX-NAV-SAT message;
+ * use uGnssDecUbxNavSatSv() to decode each satellite.
+ *
+ * @param[in] pBody     the body of the message; cannot be NULL.
+ * @param[out] pNavSat  a place to put the decoded fixed part of
+ *                      the message; may be NULL.
+ * @return              on success the number of satellite blocks
+ *                      in the message, else negative error code.
+ */
+int32_t uGnssDecUbxNavSat(const uGnssMsgView_t *pBody,
+                          uGnssDecUbxNavSat_t *pNavSat);
+
+/** Decode one satellite block of a UBX-NAV-SAT message.
+ *
+ * @param[in] pBody  the body of the message; cannot be NULL.
+ * @param index      the index of the block, less than the
+ *                   value returned by uGnssDecUbxNavSat().
+ * @param[out] pSv   a place to put the decoded block; cannot
+ *                   be NULL.
+ * @return           zero on success else negative error code.
+ */
+int32_t uGnssDecUbxNavSatSv(const uGnssMsgView_t *pBody, size_t index,
+                            uGnssDecUbxNavSatSv_t *pSv);
+
+/** Decode the fixed part of the body of a UBX-MON-VER message;
+ * use uGnssDecUbxMonVerExtension() to decode each extension string.
+ *
+ * @param[in] pBody     the body of the message; cannot be NULL.
+ * @param[out] pMonVer  a place to put the decoded fixed part of
+ *                      the message; may be NULL.
+ * @return              on success the number of extension blocks
+ *                      in the message, else negative error code.
+ */
+int32_t uGnssDecUbxMonVer(const uGnssMsgView_t *pBody,
+                          uGnssDecUbxMonVer_t *pMonVer);
+
+/** Decode one extension block of a UBX-MON-VER message.
+ *
+ * @param[in] pBody        the body of the message; cannot be NULL.
+ * @param index            the index of the block, less than the
+ *                         value returned by uGnssDecUbxMonVer().
+ * @param[out] pExtension  a place to put the decoded block; cannot
+ *                         be NULL.
+ * @return                 zero on success else negative error code.
+ */
+int32_t uGnssDecUbxMonVerExtension(const uGnssMsgView_t *pBody, size_t index,
+                                   uGnssDecUbxMonVerExtension_t *pExtension);
+
+/** Decode the fixed part of the body of a UBX-MON-COMMS message;
+ * use uGnssDecUbxMonCommsPort() to decode each port.
+ *
+ * @param[in] pBody       the body of the message; cannot be NULL.
+ * @param[out] pMonComms  a place to put the decoded fixed part of
+ *                        the message; may be NULL.
+ * @return                on success the number of port blocks
+ *                        in the message, else negative error code.
+ */
+int32_t uGnssDecUbxMonComms(const uGnssMsgView_t *pBody,
+                            uGnssDecUbxMonComms_t *pMonComms);
+
+/** Decode one port block of a UBX-MON-COMMS message.
+ *
+ * @param[in] pBody  the body of the message; cannot be NULL.
+ * @param index      the index of the block, less than the
+ *                   value returned by uGnssDecUbxMonComms().
+ * @param[out] pPort a place to put the decoded block; cannot
+ *                   be NULL.
+ * @return           zero on success else negative error code.
+ */
+int32_t uGnssDecUbxMonCommsPort(const uGnssMsgView_t *pBody, size_t index,
+                                uGnssDecUbxMonCommsPort_t *pPort);
+
+/** Decode the fixed part of the body of a UBX-RXM-RAWX message;
+ * use uGnssDecUbxRxmRawxMeas() to decode each measurement.
+ *
+ * @param[in] pBody      the body of the message; cannot be NULL.
+ * @param[out] pRxmRawx  a place to put the decoded fixed part of
+ *                       the message; may be NULL.
+ * @return               on success the number of measurement
+ *                       blocks in the message, else negative
+ *                       error code.
+ */
+int32_t uGnssDecUbxRxmRawx(const uGnssMsgView_t *pBody,
+                           uGnssDecUbxRxmRawx_t *pRxmRawx);
+
+/** Decode one measurement block of a UBX-RXM-RAWX message.
+ *
+ * @param[in] pBody  the body of the message; cannot be NULL.
+ * @param index      the index of the block, less than the
+ *                   value returned by uGnssDecUbxRxmRawx().
+ * @param[out] pMeas a place to put the decoded block; cannot
+ *                   be NULL.
+ * @return           zero on success else negative error code.
+ */
+int32_t uGnssDecUbxRxmRawxMeas(const uGnssMsgView_t *pBody, size_t index,
+                               uGnssDecUbxRxmRawxMeas_t *pMeas);
+
+/** Decode the body of a UBX-TIM-TP message.
+ *
+ * @param[in] pBody    the body of the message; cannot be NULL.
+ * @param[out] pTimTp  a place to put the decoded message; cannot
+ *                     be NULL.
+ * @return             zero on success else negative error code.
+ */
+int32_t uGnssDecUbxTimTp(const uGnssMsgView_t *pBody,
+                         uGnssDecUbxTimTp_t *pTimTp);
+
+/** Decode the body of a UBX-ESF-ALG message.
+ *
+ * @param[in] pBody     the body of the message; cannot be NULL.
+ * @param[out] pEsfAlg  a place to put the decoded message; cannot
+ *                      be NULL.
+ * @return              zero on success else negative error code.
+ */
+int32_t uGnssDecUbxEsfAlg(const uGnssMsgView_t *pBody,
+                          uGnssDecUbxEsfAlg_t *pEsfAlg);
+
+/** Decode the body of a UBX-ESF-INS message.
+ *
+ * @param[in] pBody     the body of the message; cannot be NULL.
+ * @param[out] pEsfIns  a place to put the decoded message; cannot
+ *                      be NULL.
+ * @return              zero on success else negative error code.
+ */
+int32_t uGnssDecUbxEsfIns(const uGnssMsgView_t *pBody,
+                          uGnssDecUbxEsfIns_t *pEsfIns);
+
+/** Decode the fixed part of the body of a UBX-ESF-MEAS message;
+ * use uGnssDecUbxEsfMeasData() to decode each measurement.
+ *
+ * @param[in] pBody      the body of the message; cannot be NULL.
+ * @param[out] pEsfMeas  a place to put the decoded fixed part of
+ *                       the message; may be NULL.
+ * @return               on success the number of data blocks
+ *                       in the message, else negative error code.
+ */
+int32_t uGnssDecUbxEsfMeas(const uGnssMsgView_t *pBody,
+                           uGnssDecUbxEsfMeas_t *pEsfMeas);
+
+/** Decode one data block of a UBX-ESF-MEAS message.
+ *
+ * @param[in] pBody  the body of the message; cannot be NULL.
+ * @param index      the index of the block, less than the
+ *                   value returned by uGnssDecUbxEsfMeas().
+ * @param[out] pData a place to put the decoded block; cannot
+ *                   be NULL.
+ * @return           zero on success else negative error code.
+ */
+int32_t uGnssDecUbxEsfMeasData(const uGnssMsgView_t *pBody, size_t index,
+                               uGnssDecUbxEsfData_t *pData);
+
+/** Get the number of data blocks in the body of a UBX-ESF-RAW
+ * message; use uGnssDecUbxEsfRawData() to decode each one.
+ *
+ * @param[in] pBody  the body of the message; cannot be NULL.
+ * @return           on success the number of data blocks
+ *                   in the message, else negative error code.
+ */
+int32_t uGnssDecUbxEsfRaw(const uGnssMsgView_t *pBody);
+
+/** Decode one data block of a UBX-ESF-RAW message.
+ *
+ * @param[in] pBody  the body of the message; cannot be NULL.
+ * @param index      the index of the block, less than the
+ *                   value returned by uGnssDecUbxEsfRaw().
+ * @param[out] pData a place to put the decoded block; cannot
+ *                   be NULL.
+ * @return           zero on success else negative error code.
+ */
+int32_t uGnssDecUbxEsfRawData(const uGnssMsgView_t *pBody, size_t index,
+                              uGnssDecUbxEsfData_t *pData);
+
+/** Decode the fixed part of the body of a UBX-ESF-STATUS message;
+ * use uGnssDecUbxEsfStatusSens() to decode each sensor.
+ *
+ * @param[in] pBody        the body of the message; cannot be NULL.
+ * @param[out] pEsfStatus  a place to put the decoded fixed part of
+ *                         the message; may be NULL.
+ * @return                 on success the number of sensor blocks
+ *                         in the message, else negative error code.
+ */
+int32_t uGnssDecUbxEsfStatus(const uGnssMsgView_t *pBody,
+                             uGnssDecUbxEsfStatus_t *pEsfStatus);
+
+/** Decode one sensor block of a UBX-ESF-STATUS message.
+ *
+ * @param[in] pBody  the body of the message; cannot be NULL.
+ * @param index      the index of the block, less than the
+ *                   value returned by uGnssDecUbxEsfStatus().
+ * @param[out] pSens a place to put the decoded block; cannot
+ *                   be NULL.
+ * @return           zero on success else negative error code.
+ */
+int32_t uGnssDecUbxEsfStatusSens(const uGnssMsgView_t *pBody, size_t index,
+                                 uGnssDecUbxEsfStatusSens_t *pSens);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @}*/
+
+#endif // _U_GNSS_DEC_H_
+
+// End of file
@@ -64,11 +64,11 @@ extern "C" {
 #endif
 
 #ifndef U_GNSS_MSG_TEMPORARY_BUFFER_LENGTH_BYTES
-/** A temporary buffer, used as a staging post to get stuff
- * from a streaming source (e.g. I2C or UART or SPI) into the
- * ring buffer; must be less than
- * #U_GNSS_MSG_RING_BUFFER_LENGTH_BYTES - 1 but, since this
- * is just a "chunking" temporary buffer, a rather smaller
+/** The maximum amount of data that will be read from a streaming
+ * source (e.g. I2C or UART or SPI) in one go; the data is read
+ * directly into the ring buffer, no temporary buffer is allocated,
+ * this simply limits how long a single read takes.  Must be less
+ * than #U_GNSS_MSG_RING_BUFFER_LENGTH_BYTES - 1 but a rather smaller
  * value is usually a good idea anyway.
  */
 # define U_GNSS_MSG_TEMPORARY_BUFFER_LENGTH_BYTES (U_GNSS_MSG_RING_BUFFER_LENGTH_BYTES / 8)
@@ -81,6 +81,13 @@ extern "C" {
 # define U_GNSS_MSG_RECEIVER_MAX_NUM 10
 #endif
 
+#ifndef U_GNSS_MSG_RECEIVE_PIN_MAX_NUM
+/** The maximum number of messages that may be pinned at any one
+ * time with uGnssMsgReceiveCallbackPin().
+ */
+# define U_GNSS_MSG_RECEIVE_PIN_MAX_NUM 2
+#endif
+
 #ifndef U_GNSS_MSG_RECEIVE_TASK_STACK_SIZE_BYTES
 /** The number of bytes of stack to allocate to the task started
  * by uGnssMsgReceiveStart(), the context in which the
@@ -116,7 +123,8 @@ extern "C" {
  * This callback should be executed as quickly as possible to
  * avoid data loss.  The ONLY GNSS API calls that pCallback may make
  * are uGnssMsgReceiveCallbackRead() / uGnssMsgReceiveCallbackExtract(),
- * no others or you risk getting* mutex-locked.
+ * uGnssMsgReceiveCallbackPin() / uGnssMsgReceivePinRelease(), no
+ * others or you risk getting* mutex-locked.
  * If you are checking for a specific UBX-format message (i.e. no
  * wild-cards) and a NACK is received for that message then
  * errorCodeOrLength will be set to #U_GNSS_ERROR_NACK and there
@@ -162,6 +170,51 @@ typedef void (*uGnssMsgReceiveCallback_t)(uDeviceHandle_t gnssHandle,
                                           int32_t errorCodeOrLength,
                                           void *pCallbackParam);
 
+/** A read-only view of a message sitting in the internal ring buffer,
+ * as passed to a #uGnssMsgReceiveViewCallback_t.  Since the ring
+ * buffer wraps, the message may be in two pieces: the first
+ * size1 bytes at pData1 followed by size2 bytes at pData2.
+ */
+typedef struct {
+    const char *pData1; /**< the start of the message, NULL if there
+                             is no message (e.g. in the NACK case). */
+    size_t size1;       /**< the number of bytes at pData1. */
+    const char *pData2; /**< the rest of the message, NULL if the
+                             message does not wrap. */
+    size_t size2;       /**< the number of bytes at pData2. */
+} uGnssMsgView_t;
+
+/** A callback which will be called by uGnssMsgReceiveStartView()
+ * when a matching message has been received from the GNSS chip.
+ * This is the same as #uGnssMsgReceiveCallback_t except that the
+ * message is passed to it in place, as a view into the internal
+ * ring buffer, so there is no need to copy it out.  The view is only
+ * valid until the callback returns unless the callback calls
+ * uGnssMsgReceiveCallbackPin(), in which case it remains valid until
+ * uGnssMsgReceivePinRelease() is called.  The same restrictions
+ * apply as for #uGnssMsgReceiveCallback_t; in particular the
+ * callback must not write to the view.
+ *
+ * @param gnssHandle             the handle of the GNSS instance.
+ * @param[out] pMessageId        a pointer to the message ID that was
+ *                               detected.
+ * @param errorCodeOrLength      the size of the message or
+ *                               #U_GNSS_ERROR_NACK, as for
+ *                               #uGnssMsgReceiveCallback_t.
+ * @param[in] pView              a pointer to the view of the message,
+ *                               including any header, $, checksum, etc.
+ *                               If an earlier callback has called
+ *                               uGnssMsgReceiveCallbackExtract() then
+ *                               the view will contain only what is left.
+ * @param[in,out] pCallbackParam the callback parameter that was originally
+ *                               given to uGnssMsgReceiveStartView().
+ */
+typedef void (*uGnssMsgReceiveViewCallback_t)(uDeviceHandle_t gnssHandle,
+                                              const uGnssMessageId_t *pMessageId,
+                                              int32_t errorCodeOrLength,
+                                              const uGnssMsgView_t *pView,
+                                              void *pCallbackParam);
+
 /* ----------------------------------------------------------------
  * FUNCTIONS: MISC
  * -------------------------------------------------------------- */
@@ -343,6 +396,14 @@ int32_t uGnssMsgReceive(uDeviceHandle_t gnssHandle,
  * connected to this MCU, it does NOT work for GNSS chips connected
  * via an intermediate [e.g. cellular] module.
  *
+ * If the GNSS chip is connected via a UART and no-one else has set
+ * an event callback on that UART (see uPortUartEventCallbackSet()),
+ * the receive task will set one and be woken as soon as data arrives,
+ * otherwise it polls the transport every
+ * #U_GNSS_MSG_TASK_STACK_YIELD_TIME_MS or so; for I2C and SPI you may
+ * call uGnssMsgReceiveDataReady() when the Data Ready pin of the GNSS
+ * chip indicates that there is something to read.
+ *
  * @param gnssHandle             the handle of the GNSS instance.
  * @param[in] pMessageId         a pointer to the message ID to capture;
  *                               a copy will be taken so this may be
@@ -378,6 +439,31 @@ int32_t uGnssMsgReceiveStart(uDeviceHandle_t gnssHandle,
                              uGnssMsgReceiveCallback_t pCallback,
                              void *pCallbackParam);
 
+/** As uGnssMsgReceiveStart() but pCallback is given a read-only view
+ * of the message where it sits in the internal ring buffer, rather
+ * than having to call uGnssMsgReceiveCallbackRead() to copy it out;
+ * this is useful if there are large messages (e.g. UBX-RXM-RAWX) that
+ * are passed to several consumers.  Readers started with this function
+ * and with uGnssMsgReceiveStart() may be mixed, the returned handle
+ * may be passed to uGnssMsgReceiveStop() in the same way and the
+ * same restrictions apply.
+ *
+ * @param gnssHandle             the handle of the GNSS instance.
+ * @param[in] pMessageId         a pointer to the message ID to capture;
+ *                               a copy will be taken so this may be
+ *                               on the stack; cannot be NULL.
+ * @param[in] pCallback          the callback to be called when a
+ *                               matching message arrives; cannot be NULL.
+ * @param[in] pCallbackParam     will be passed to pCallback as its last
+ *                               parameter.
+ * @return                       a handle for this asynchronous reader on
+ *                               success, else negative error code.
+ */
+int32_t uGnssMsgReceiveStartView(uDeviceHandle_t gnssHandle,
+                                 const uGnssMessageId_t *pMessageId,
+                                 uGnssMsgReceiveViewCallback_t pCallback,
+                                 void *pCallbackParam);
+
 /** To be called from the pCallback of uGnssMsgReceiveStart() to take
  * a peek at the message data from the internal ring buffer, copying it
  * into your buffer but NOT REMOVING IT from the internal ring buffer,
@@ -424,6 +510,44 @@ int32_t uGnssMsgReceiveCallbackRead(uDeviceHandle_t gnssHandle,
 int32_t uGnssMsgReceiveCallbackExtract(uDeviceHandle_t gnssHandle,
                                        char *pBuffer, size_t size);
 
+/** To be called from the pCallback of uGnssMsgReceiveStart() or
+ * uGnssMsgReceiveStartView() to keep the current message where it is
+ * in the internal ring buffer after pCallback has returned, so that a
+ * view of it (see #uGnssMsgView_t) remains valid, e.g. while it is
+ * processed in another task.  The message is kept until
+ * uGnssMsgReceivePinRelease() is called.
+ *
+ * IMPORTANT: while a message is pinned the internal ring buffer cannot
+ * discard it, or anything that arrives after it, so if it is not
+ * released promptly the ring buffer will fill up and data will be
+ * lost; a pinned message should be dealt with and released in
+ * rather less time than it takes the GNSS chip to fill
+ * #U_GNSS_MSG_RING_BUFFER_LENGTH_BYTES.  There may be at most
+ * #U_GNSS_MSG_RECEIVE_PIN_MAX_NUM pins outstanding.
+ *
+ * IMPORTANT: this function can ONLY be called from the message
+ * receive pCallback.
+ *
+ * @param gnssHandle   the handle of the GNSS instance.
+ * @return             on success a pin handle, to be passed to
+ *                     uGnssMsgReceivePinRelease(), else negative
+ *                     error code.
+ */
+int32_t uGnssMsgReceiveCallbackPin(uDeviceHandle_t gnssHandle);
+
+/** Release a message pinned by uGnssMsgReceiveCallbackPin(); after
+ * this is called any view of that message is no longer valid.  This
+ * may be called from any task, including from the message receive
+ * pCallback, and must be called for every pin, even after
+ * uGnssMsgReceiveStop() has been called.
+ *
+ * @param gnssHandle   the handle of the GNSS instance.
+ * @param pinHandle    the handle returned by uGnssMsgReceiveCallbackPin().
+ * @return             zero on success else negative error code.
+ */
+int32_t uGnssMsgReceivePinRelease(uDeviceHandle_t gnssHandle,
+                                  int32_t pinHandle);
+
 /** Stop monitoring the output of the GNSS chip for a message.
  * Once this function returns the pCallback function passed to the
  * associated uGnssMsgReceiveStart() will no longer be called.
@@ -444,6 +568,24 @@ int32_t uGnssMsgReceiveStop(uDeviceHandle_t gnssHandle,
  */
 int32_t uGnssMsgReceiveStopAll(uDeviceHandle_t gnssHandle);
 
+/** Tell the non-blocking message receive task that there is data
+ * waiting to be read from the GNSS chip, e.g. because its Data Ready
+ * pin has become active, so that it does not wait for its next poll;
+ * this is useful with an I2C or SPI transport, where this code has
+ * no other way of knowing that data has arrived, and reduces the
+ * time it takes for a message to reach the callback of
+ * uGnssMsgReceiveStart().  Has no effect if no non-blocking message
+ * receive is running.
+ *
+ * Note that this function locks the GNSS API mutex and hence must
+ * NOT be called from an interrupt service routine: call it, for
+ * instance, from a task that your interrupt service routine wakes up.
+ *
+ * @param gnssHandle  the handle of the GNSS instance.
+ * @return            zero on success else negative error code.
+ */
+int32_t uGnssMsgReceiveDataReady(uDeviceHandle_t gnssHandle);
+
 /** Return the minimum number of bytes of stack free in the task
  * that is running the message receive.  Will return a valid
  * number only if at least one uGnssMsgReceiveStart() is running.
@@ -480,6 +622,22 @@ size_t uGnssMsgReceiveStatReadLoss(uDeviceHandle_t gnssHandle);
  */
 size_t uGnssMsgReceiveStatStreamLoss(uDeviceHandle_t gnssHandle);
 
+/** Get the number of bytes from a streaming source (for instance
+ * I2C or UART or SPI) that have been thrown away because they did
+ * not form part of any UBX, NMEA or RTCM message, e.g. the remains of
+ * messages that were cut short by uGnssMsgReceiveStatStreamLoss().
+ * Every reader of the stream sees the same bytes, so this is the
+ * count for just one of them: the read handle that the non-blocking
+ * message receive task, started by uGnssMsgReceiveStart(), parses
+ * the stream with.  The count is zero if non-blocking message
+ * receive is not running and begins again from zero each time it
+ * is started.
+ *
+ * @param gnssHandle   the handle of the GNSS instance.
+ * @return             the number of bytes discarded.
+ */
+size_t uGnssMsgReceiveStatDiscard(uDeviceHandle_t gnssHandle);
+
 #ifdef __cplusplus
 }
 #endif
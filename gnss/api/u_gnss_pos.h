@@ -200,6 +200,107 @@ int32_t uGnssPosGetStart(uDeviceHandle_t gnssHandle,
  */
 void uGnssPosGetStop(uDeviceHandle_t gnssHandle);
 
+/** Start streamed position: the GNSS chip is configured to emit
+ * UBX-NAV-PVT periodically on the port it is connected to, each
+ * message is decoded once, in the message receive task, and the
+ * result is cached so that uGnssPosGetStreamed() can return the
+ * latest position immediately, without talking to the GNSS chip.
+ * This is much more efficient than calling uGnssPosGet() in a loop
+ * if you need position regularly.  The streamed position is stopped
+ * with uGnssPosGetStreamedStop(); if it is already running
+ * #U_ERROR_COMMON_NO_MEMORY will be returned.
+ *
+ * This uses the message receive mechanism of u_gnss_msg.h and hence
+ * is not supported when the GNSS chip is connected via an
+ * intermediate [cellular] module (#U_GNSS_TRANSPORT_AT); it will also
+ * use one of the #U_GNSS_MSG_RECEIVER_MAX_NUM message receivers.
+ * Note that, while streamed position is running, the GNSS chip will
+ * be sending UBX-NAV-PVT messages of its own accord, so you may
+ * wish to avoid calling uGnssPosGet() at the same time.
+ *
+ * @param gnssHandle          the handle of the GNSS instance to use.
+ * @param measurementPeriodMs the period at which the GNSS chip should
+ *                            perform measurements, and hence emit
+ *                            UBX-NAV-PVT, in milliseconds; use -1 to
+ *                            leave the measurement period as it is.
+ * @param[in] pCallback       optional callback that will be called each
+ *                            time a UBX-NAV-PVT message has been decoded,
+ *                            parameters as for uGnssPosGetStart(); may
+ *                            be NULL.  The callback is run in the
+ *                            message receive task and so should be quick;
+ *                            it must NOT call back into the GNSS API,
+ *                            except for uGnssPosGetStreamed(), which
+ *                            is safe.
+ * @return                    zero on success or negative error code on
+ *                            failure; if the GNSS chip does not Ack
+ *                            the configuration, e.g. #U_GNSS_ERROR_NACK,
+ *                            then streamed position is not started.
+ */
+int32_t uGnssPosGetStreamedStart(uDeviceHandle_t gnssHandle,
+                                 int32_t measurementPeriodMs,
+                                 void (*pCallback) (uDeviceHandle_t gnssHandle,
+                                                    int32_t errorCode,
+                                                    int32_t latitudeX1e7,
+                                                    int32_t longitudeX1e7,
+                                                    int32_t altitudeMillimetres,
+                                                    int32_t radiusMillimetres,
+                                                    int32_t speedMillimetresPerSecond,
+                                                    int32_t svs,
+                                                    int64_t timeUtc));
+
+/** Get the latest position decoded by streamed position, see
+ * uGnssPosGetStreamedStart(); this does not talk to the GNSS chip
+ * and does not wait for any other GNSS API call that is in progress,
+ * it only locks the cached position for long enough to copy it out,
+ * so it may be called as often as you like, from any task.  The
+ * parameters are as described for uGnssPosGet(): the position is
+ * only written if the return value is zero, timeUtc is always written.
+ *
+ * @param gnssHandle                       the handle of the GNSS instance.
+ * @param[out] pLatitudeX1e7               a place to put latitude (in ten
+ *                                         millionths of a degree); may be NULL.
+ * @param[out] pLongitudeX1e7              a place to put longitude (in ten
+ *                                         millionths of a degree); may be NULL.
+ * @param[out] pAltitudeMillimetres        a place to put the altitude (in
+ *                                         millimetres); may be NULL.
+ * @param[out] pRadiusMillimetres          a place to put the radius of
+ *                                         position (in millimetres); may be NULL.
+ * @param[out] pSpeedMillimetresPerSecond  a place to put the speed (in
+ *                                         millimetres per second); may be NULL.
+ * @param[out] pSvs                        a place to store the number of
+ *                                         space vehicles used in the
+ *                                         solution; may be NULL.
+ * @param[out] pTimeUtc                    a place to put the UTC time;
+ *                                         may be NULL.
+ * @return                                 zero if the latest UBX-NAV-PVT
+ *                                         contained a valid fix,
+ *                                         #U_ERROR_COMMON_TIMEOUT if no
+ *                                         fix has yet been obtained,
+ *                                         #U_ERROR_COMMON_NOT_SUPPORTED
+ *                                         if streamed position has not
+ *                                         been started, else negative
+ *                                         error code.
+ */
+int32_t uGnssPosGetStreamed(uDeviceHandle_t gnssHandle,
+                            int32_t *pLatitudeX1e7, int32_t *pLongitudeX1e7,
+                            int32_t *pAltitudeMillimetres,
+                            int32_t *pRadiusMillimetres,
+                            int32_t *pSpeedMillimetresPerSecond,
+                            int32_t *pSvs, int64_t *pTimeUtc);
+
+/** Stop streamed position: periodic output of UBX-NAV-PVT is switched
+ * off again and, once this function has returned, the callback passed
+ * to uGnssPosGetStreamedStart() will no longer be called.  The
+ * measurement period is not restored.  Streamed position is stopped
+ * even if the GNSS chip does not Ack switching UBX-NAV-PVT output off,
+ * in which case it will carry on emitting UBX-NAV-PVT and the error
+ * is returned.
+ *
+ * @param gnssHandle  the handle of the GNSS instance.
+ * @return            zero on success or negative error code on failure.
+ */
+int32_t uGnssPosGetStreamedStop(uDeviceHandle_t gnssHandle);
+
 /** Get the binary RRLP information directly from the GNSS chip,
  * as returned by the UBX-RXM-MEASX command of the UBX protocol.  This
  * is more efficient, both in terms of power and time, than asking
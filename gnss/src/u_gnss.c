@@ -135,8 +135,10 @@ static uGnssPrivateInstance_t *pGetGnssInstanceTransportHandle(uGnssTransportTyp
 // Note: doesn't copy it, just adds it.
 static void addGnssInstance(uGnssPrivateInstance_t *pInstance)
 {
+    U_PORT_MUTEX_LOCK(gUGnssPrivateInstanceListMutex);
     pInstance->pNext = gpUGnssPrivateInstanceList;
     gpUGnssPrivateInstanceList = pInstance;
+    U_PORT_MUTEX_UNLOCK(gUGnssPrivateInstanceListMutex);
 }
 
 // Remove a GNSS instance from the list.
@@ -153,6 +155,26 @@ static void deleteGnssInstance(uGnssPrivateInstance_t *pInstance)
             uGnssPrivateCleanUpPosTask(pInstance);
             // Stop asynchronus message receive from happening
             uGnssPrivateStopMsgReceive(pInstance);
+            // Unlink the instance from the list so that
+            // uGnssPosGetStreamed() can no longer find it
+            U_PORT_MUTEX_LOCK(gUGnssPrivateInstanceListMutex);
+            if (pPrev != NULL) {
+                pPrev->pNext = pCurrent->pNext;
+            } else {
+                gpUGnssPrivateInstanceList = pCurrent->pNext;
+            }
+            U_PORT_MUTEX_UNLOCK(gUGnssPrivateInstanceListMutex);
+            pCurrent = NULL;
+            // uGnssPosGetStreamed() may still have found the instance
+            // before it was unlinked: it locks posStreamedMutex before
+            // letting go of the list, so once we have had the mutex
+            // it is done with the instance
+            U_PORT_MUTEX_LOCK(pInstance->posStreamedMutex);
+            U_PORT_MUTEX_UNLOCK(pInstance->posStreamedMutex);
+            uPortMutexDelete(pInstance->posStreamedMutex);
+            // Free any streamed position, now that nothing can be
+            // writing to it
+            uPortFree(pInstance->pPosStreamed);
             // Free the SPI buffer, if there is one
             if (pInstance->pSpiRingBuffer != NULL) {
                 uRingBufferDelete(pInstance->pSpiRingBuffer);
@@ -164,19 +186,12 @@ static void deleteGnssInstance(uGnssPrivateInstance_t *pInstance)
                 uRingBufferDelete(&(pInstance->ringBuffer));
                 uPortFree(pInstance->pLinearBuffer);
             }
-            // This can go now too
-            uPortFree(pInstance->pTemporaryBuffer);
+            // Free the buffer pool
+            uPortFree(pInstance->bufferPool.pBlocks);
             // Delete the transport mutex
             uPortMutexDelete(pInstance->transportMutex);
             // Deallocate the uDevice instance
             uDeviceDestroyInstance(U_DEVICE_INSTANCE(pInstance->gnssHandle));
-            // Unlink the instance from the list
-            if (pPrev != NULL) {
-                pPrev->pNext = pCurrent->pNext;
-            } else {
-                gpUGnssPrivateInstanceList = pCurrent->pNext;
-            }
-            pCurrent = NULL;
             // Free the instance
             uPortFree(pInstance);
         } else {
@@ -210,6 +225,14 @@ int32_t uGnssInit()
     if (gUGnssPrivateMutex == NULL) {
         // Create the mutex that protects the linked list
         errorCode = uPortMutexCreate(&gUGnssPrivateMutex);
+        if (errorCode == 0) {
+            // ...and the one that lets it be searched without that
+            errorCode = uPortMutexCreate(&gUGnssPrivateInstanceListMutex);
+            if (errorCode != 0) {
+                uPortMutexDelete(gUGnssPrivateMutex);
+                gUGnssPrivateMutex = NULL;
+            }
+        }
     }
 
     return errorCode;
@@ -229,6 +252,8 @@ void uGnssDeinit()
 
         // Unlock the mutex so that we can delete it
         U_PORT_MUTEX_UNLOCK(gUGnssPrivateMutex);
+        uPortMutexDelete(gUGnssPrivateInstanceListMutex);
+        gUGnssPrivateInstanceListMutex = NULL;
         uPortMutexDelete(gUGnssPrivateMutex);
         gUGnssPrivateMutex = NULL;
     }
@@ -300,6 +325,11 @@ int32_t uGnssAdd(uGnssModuleType_t moduleType,
                     pInstance->gnssHandle = (uDeviceHandle_t)pDevInstance;
                     pInstance->transportMutex = NULL;
                     errorCode = uPortMutexCreate(&pInstance->transportMutex);
+                    if (errorCode == 0) {
+                        // ...and the streamed position mutex, which
+                        // uGnssPosGetStreamed() relies on being present
+                        errorCode = uPortMutexCreate(&pInstance->posStreamedMutex);
+                    }
                     if (errorCode == 0) {
                         // Populate the things that aren't good with just the memset()
                         pInstance->transportType = transportType;
@@ -378,52 +408,49 @@ int32_t uGnssAdd(uGnssModuleType_t moduleType,
                             // which we stream messages received from the module
                             pInstance->pLinearBuffer = (char *) pUPortMalloc(U_GNSS_MSG_RING_BUFFER_LENGTH_BYTES);
                             if (pInstance->pLinearBuffer != NULL) {
-                                // Also need a temporary buffer to get stuff out
-                                // of the UART/I2C/SPI in the first place
-                                pInstance->pTemporaryBuffer = (char *) pUPortMalloc(U_GNSS_MSG_TEMPORARY_BUFFER_LENGTH_BYTES);
-                                if (pInstance->pTemporaryBuffer != NULL) {
-                                    // +2 below to keep one for ourselves and one for the
-                                    // blocking transparent receive function
-                                    errorCode = uRingBufferCreateWithReadHandle(&(pInstance->ringBuffer),
-                                                                                pInstance->pLinearBuffer,
-                                                                                U_GNSS_MSG_RING_BUFFER_LENGTH_BYTES,
-                                                                                U_GNSS_MSG_RECEIVER_MAX_NUM + 2);
-                                    if (errorCode == 0) {
-                                        // No sneaky uRingBufferRead()'s allowed
-                                        uRingBufferSetReadRequiresHandle(&(pInstance->ringBuffer), true);
-                                        // Reserve a handle for us
+                                // Three read handles: one for ourselves, one for the
+                                // blocking transparent receive function and one
+                                // shared by all of the non-blocking readers, plus
+                                // any that the non-blocking readers use to pin messages
+                                errorCode = uRingBufferCreateWithReadHandle(&(pInstance->ringBuffer),
+                                                                            pInstance->pLinearBuffer,
+                                                                            U_GNSS_MSG_RING_BUFFER_LENGTH_BYTES,
+                                                                            3 + U_GNSS_MSG_RECEIVE_PIN_MAX_NUM);
+                                if (errorCode == 0) {
+                                    // No sneaky uRingBufferRead()'s allowed
+                                    uRingBufferSetReadRequiresHandle(&(pInstance->ringBuffer), true);
+                                    // Reserve a handle for us
+                                    errorCode = uRingBufferTakeReadHandle(&(pInstance->ringBuffer));
+                                    if (errorCode >= 0) {
+                                        pInstance->ringBufferReadHandlePrivate = errorCode;
+                                        // ...and one for uGnssMsgReceive()
                                         errorCode = uRingBufferTakeReadHandle(&(pInstance->ringBuffer));
                                         if (errorCode >= 0) {
-                                            pInstance->ringBufferReadHandlePrivate = errorCode;
-                                            // ...and one for uGnssMsgReceive()
-                                            errorCode = uRingBufferTakeReadHandle(&(pInstance->ringBuffer));
-                                            if (errorCode >= 0) {
-                                                pInstance->ringBufferReadHandleMsgReceive = errorCode;
-                                                if (pInstance->transportType == U_GNSS_TRANSPORT_SPI) {
-                                                    // Finally, if we are on SPI, we need a local receive
-                                                    // buffer to keep stuff that we receive while we are
-                                                    // just sending
-                                                    // +1 below since we lose one byte in the ring buffer implementation
-                                                    pInstance->pSpiLinearBuffer = (char *) pUPortMalloc(U_GNSS_SPI_BUFFER_LENGTH_BYTES + 1);
-                                                    if (pInstance->pSpiLinearBuffer != NULL) {
-                                                        pInstance->pSpiRingBuffer = (uRingBuffer_t *) pUPortMalloc(sizeof(uRingBuffer_t));
-                                                        if (pInstance->pSpiRingBuffer != NULL) {
-                                                            errorCode = uRingBufferCreate(pInstance->pSpiRingBuffer,
-                                                                                          pInstance->pSpiLinearBuffer,
-                                                                                          U_GNSS_SPI_BUFFER_LENGTH_BYTES + 1);
-                                                        }
-                                                    } else {
-                                                        uRingBufferDelete(&(pInstance->ringBuffer));
+                                            pInstance->ringBufferReadHandleMsgReceive = errorCode;
+                                            if (pInstance->transportType == U_GNSS_TRANSPORT_SPI) {
+                                                // Finally, if we are on SPI, we need a local receive
+                                                // buffer to keep stuff that we receive while we are
+                                                // just sending
+                                                // +1 below since we lose one byte in the ring buffer implementation
+                                                pInstance->pSpiLinearBuffer = (char *) pUPortMalloc(U_GNSS_SPI_BUFFER_LENGTH_BYTES + 1);
+                                                if (pInstance->pSpiLinearBuffer != NULL) {
+                                                    pInstance->pSpiRingBuffer = (uRingBuffer_t *) pUPortMalloc(sizeof(uRingBuffer_t));
+                                                    if (pInstance->pSpiRingBuffer != NULL) {
+                                                        errorCode = uRingBufferCreate(pInstance->pSpiRingBuffer,
+                                                                                      pInstance->pSpiLinearBuffer,
+                                                                                      U_GNSS_SPI_BUFFER_LENGTH_BYTES + 1);
                                                     }
                                                 } else {
-                                                    errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+                                                    uRingBufferDelete(&(pInstance->ringBuffer));
                                                 }
                                             } else {
-                                                uRingBufferDelete(&(pInstance->ringBuffer));
+                                                errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
                                             }
                                         } else {
                                             uRingBufferDelete(&(pInstance->ringBuffer));
                                         }
+                                    } else {
+                                        uRingBufferDelete(&(pInstance->ringBuffer));
                                     }
                                 }
                             }
@@ -446,10 +473,12 @@ int32_t uGnssAdd(uGnssModuleType_t moduleType,
                             uRingBufferDelete(&(pInstance->ringBuffer));
                             uPortFree(pInstance->pLinearBuffer);
                         }
-                        uPortFree(pInstance->pTemporaryBuffer);
                         if (pInstance->transportMutex != NULL) {
                             uPortMutexDelete(pInstance->transportMutex);
                         }
+                        if (pInstance->posStreamedMutex != NULL) {
+                            uPortMutexDelete(pInstance->posStreamedMutex);
+                        }
                         uPortFree(pInstance);
                     }
                 }
@@ -722,4 +751,40 @@ void uGnssSetUbxMessagePrint(uDeviceHandle_t gnssHandle, bool onNotOff)
     }
 }
 
+// Get the buffer pool usage statistics.
+int32_t uGnssGetBufferPoolStats(uDeviceHandle_t gnssHandle,
+                                int32_t *pPoolCount,
+                                int32_t *pHeapCount)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uGnssPrivateInstance_t *pInstance;
+
+    if (gUGnssPrivateMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gUGnssPrivateMutex);
+
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        pInstance = pUGnssPrivateGetInstance(gnssHandle);
+        if (pInstance != NULL) {
+
+            U_PORT_MUTEX_LOCK(pInstance->transportMutex);
+
+            if (pPoolCount != NULL) {
+                *pPoolCount = pInstance->bufferPool.poolCount;
+            }
+            if (pHeapCount != NULL) {
+                *pHeapCount = pInstance->bufferPool.heapCount;
+            }
+
+            U_PORT_MUTEX_UNLOCK(pInstance->transportMutex);
+
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        }
+
+        U_PORT_MUTEX_UNLOCK(gUGnssPrivateMutex);
+    }
+
+    return errorCode;
+}
+
 // End of file
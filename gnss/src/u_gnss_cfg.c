@@ -55,11 +55,6 @@
  * COMPILE-TIME MACROS
  * -------------------------------------------------------------- */
 
-/** The maximum number of values that can be stored in a VALXXX
- * message.
- */
-#define U_GNSS_CFG_VAL_MSG_MAX_NUM_VALUES 64
-
 #ifndef U_GNSS_CFG_MAX_NUM_VAL_GET_SEGMENTS
 /** The maximum number of a VALGET message segments, each containing
  * U_GNSS_CFG_VAL_MSG_MAX_NUM_VALUES, that we can handle.
@@ -604,6 +599,40 @@ static int32_t valSetE1(uGnssPrivateInstance_t *pInstance,
                                       message, sizeof(message));
 }
 
+// Send the values held in a batch with the given transaction state,
+// recording which values were rejected if the GNSS chip says no.
+static int32_t valSetBatchSend(uGnssCfgValSetBatch_t *pBatch,
+                               uGnssCfgValTransaction_t transaction)
+{
+    int32_t errorCode;
+
+    errorCode = valSetList(pBatch->gnssHandle, pBatch->list,
+                           pBatch->numValues, transaction,
+                           pBatch->layers);
+    if (errorCode == 0) {
+        pBatch->numMessagesSent++;
+    } else {
+        pBatch->errorCode = errorCode;
+        if (pBatch->numValues > 0) {
+            pBatch->failedIndex = pBatch->numValuesTotal - (int32_t) pBatch->numValues;
+            pBatch->failedCount = (int32_t) pBatch->numValues;
+        }
+        if (transaction != U_GNSS_CFG_VAL_TRANSACTION_NONE) {
+            // Don't leave a transaction open in the GNSS chip: an
+            // empty transactionless UBX-CFG-VALSET cancels it; we
+            // may not even have got the NACK or the chip may not
+            // have opened one, so do this regardless and ignore
+            // the outcome, the error to report is the one above
+            valSetList(pBatch->gnssHandle, NULL, 0,
+                       U_GNSS_CFG_VAL_TRANSACTION_NONE,
+                       pBatch->layers);
+        }
+    }
+    pBatch->numValues = 0;
+
+    return errorCode;
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS: SPECIFIC CONFIGURATION FUNCTIONS
  * -------------------------------------------------------------- */
@@ -949,4 +978,97 @@ int32_t uGnssCfgValDelListX(uDeviceHandle_t gnssHandle,
     return errorCode;
 }
 
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS: BATCHED CONFIGURATION USING VALSET
+ * -------------------------------------------------------------- */
+
+// Begin a batched set of configuration items.
+int32_t uGnssCfgValSetBatchBegin(uDeviceHandle_t gnssHandle,
+                                 uGnssCfgValSetBatch_t *pBatch,
+                                 uint32_t layers)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uGnssPrivateInstance_t *pInstance;
+
+    if (gUGnssPrivateMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gUGnssPrivateMutex);
+
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        pInstance = pUGnssPrivateGetInstance(gnssHandle);
+        if ((pInstance != NULL) && (pBatch != NULL) &&
+            (layers > 0) && ((layers & ~U_GNSS_CFG_VAL_LAYER_DEFAULT) == 0)) {
+            errorCode = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+            if (U_GNSS_PRIVATE_HAS(pInstance->pModule, U_GNSS_PRIVATE_FEATURE_CFGVALXXX)) {
+                pBatch->gnssHandle = gnssHandle;
+                pBatch->layers = layers;
+                pBatch->errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+                pBatch->numValuesTotal = 0;
+                pBatch->numMessagesSent = 0;
+                pBatch->failedIndex = -1;
+                pBatch->failedCount = 0;
+                pBatch->numValues = 0;
+                errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK(gUGnssPrivateMutex);
+    }
+
+    return errorCode;
+}
+
+// Add a value to a batch.
+int32_t uGnssCfgValSetBatchAdd(uGnssCfgValSetBatch_t *pBatch,
+                               uint32_t keyId, uint64_t value)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uGnssCfgValTransaction_t transaction = U_GNSS_CFG_VAL_TRANSACTION_CONTINUE;
+
+    if (pBatch != NULL) {
+        errorCode = pBatch->errorCode;
+        if ((errorCode == 0) &&
+            (pBatch->numValues >= sizeof(pBatch->list) / sizeof(pBatch->list[0]))) {
+            // Full: send what we have as part of a transaction,
+            // which is begun if this is the first message
+            if (pBatch->numMessagesSent == 0) {
+                transaction = U_GNSS_CFG_VAL_TRANSACTION_BEGIN;
+            }
+            errorCode = valSetBatchSend(pBatch, transaction);
+        }
+        if (errorCode == 0) {
+            pBatch->list[pBatch->numValues].keyId = keyId;
+            pBatch->list[pBatch->numValues].value = value;
+            pBatch->numValues++;
+            pBatch->numValuesTotal++;
+        }
+    }
+
+    return errorCode;
+}
+
+// Send any remaining values in a batch and apply them all.
+int32_t uGnssCfgValSetBatchCommit(uGnssCfgValSetBatch_t *pBatch)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uGnssCfgValTransaction_t transaction = U_GNSS_CFG_VAL_TRANSACTION_NONE;
+
+    if (pBatch != NULL) {
+        errorCode = pBatch->errorCode;
+        if (errorCode == 0) {
+            if (pBatch->numMessagesSent > 0) {
+                // A transaction is in progress: the values that
+                // remain, if any, go with the instruction to execute it
+                transaction = U_GNSS_CFG_VAL_TRANSACTION_EXCUTE;
+            }
+            if ((pBatch->numValues > 0) ||
+                (transaction == U_GNSS_CFG_VAL_TRANSACTION_EXCUTE)) {
+                errorCode = valSetBatchSend(pBatch, transaction);
+            }
+        }
+    }
+
+    return errorCode;
+}
+
 // End of file
@@ -0,0 +1,899 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Only #includes of u_* and the C standard library are allowed here,
+ * no platform stuff and no OS stuff.  Anything required from
+ * the platform/OS must be brought in through u_port* to maintain
+ * portability.
+ */
+
+/** @file
+ * @brief This source file contains the implementation of the UBX
+ * message decoders of the GNSS API.
+ *
+ * Each message is described by a table of fields, giving the offset
+ * of the field in the message body, the offset of the field in the
+ * decoded structure and the UBX type of the field; a single generic
+ * function then walks the table, reading each field from the
+ * message in little-endian byte order and writing it to the structure
+ * in native byte order.  The tables are the schema: to add a message,
+ * add a structure to u_gnss_dec.h and a table here.
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+#include "stddef.h"    // NULL, size_t, offsetof() etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+#include "string.h"    // memcpy()
+
+#include "u_error_common.h"
+
+#include "u_time.h"
+
+#include "u_ubx_protocol.h"
+
+#include "u_device.h"
+
+#include "u_gnss_type.h"
+#include "u_gnss_msg.h"
+#include "u_gnss_dec.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** Helper to populate an entry of a field table: structType is the
+ * type of the decoded structure, field the name of the field in
+ * that structure, bodyOffset the offset of the field in the UBX
+ * message body (or block) and type one of U1, I1, U2, I2, U4, I4,
+ * R4 or R8.
+ */
+#define U_GNSS_DEC_FIELD(structType, field, bodyOffset, type) \
+    {bodyOffset, offsetof(structType, field), U_GNSS_DEC_TYPE_##type}
+
+/** The number of entries in a field table.
+ */
+#define U_GNSS_DEC_NUM_FIELDS(table) (sizeof(table) / sizeof(table[0]))
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** The UBX types a field may have.
+ */
+typedef enum {
+    U_GNSS_DEC_TYPE_U1,
+    U_GNSS_DEC_TYPE_I1,
+    U_GNSS_DEC_TYPE_U2,
+    U_GNSS_DEC_TYPE_I2,
+    U_GNSS_DEC_TYPE_U4,
+    U_GNSS_DEC_TYPE_I4,
+    U_GNSS_DEC_TYPE_R4,
+    U_GNSS_DEC_TYPE_R8
+} uGnssDecType_t;
+
+/** A field of a UBX message.
+ */
+typedef struct {
+    uint16_t bodyOffset;   /**< the offset of the field in the message body. */
+    uint16_t structOffset; /**< the offset of the field in the decoded structure. */
+    uGnssDecType_t type;   /**< the type of the field. */
+} uGnssDecField_t;
+
+/** Description of the repeated blocks in a UBX message.
+ */
+typedef struct {
+    size_t headerLength;   /**< the length of the fixed part of the message body. */
+    size_t blockLength;    /**< the length of one block. */
+    const uGnssDecField_t *pFields; /**< the fields of a block. */
+    size_t numFields;      /**< the number of entries at pFields. */
+} uGnssDecBlock_t;
+
+/* ----------------------------------------------------------------
+ * VARIABLES: THE SCHEMA
+ * -------------------------------------------------------------- */
+
+/** UBX-NAV-PVT.
+ */
+static const uGnssDecField_t gNavPvt[] = {
+    U_GNSS_DEC_FIELD(uGnssDecUbxNavPvt_t, iTOW, 0, U4),
+    U_GNSS_DEC_FIELD(uGnssDecUbxNavPvt_t, year, 4, U2),
+    U_GNSS_DEC_FIELD(uGnssDecUbxNavPvt_t, month, 6, U1),
+    U_GNSS_DEC_FIELD(uGnssDecUbxNavPvt_t, day, 7, U1),
+    U_GNSS_DEC_FIELD(uGnssDecUbxNavPvt_t, hour, 8, U1),
+    U_GNSS_DEC_FIELD(uGnssDecUbxNavPvt_t, min, 9, U1),
+    U_GNSS_DEC_FIELD(uGnssDecUbxNavPvt_t, sec, 10, U1),
+    U_GNSS_DEC_FIELD(uGnssDecUbxNavPvt_t, valid, 11, U1),
+    U_GNSS_DEC_FIELD(uGnssDecUbxNavPvt_t, tAcc, 12, U4),
+    U_GNSS_DEC_FIELD(uGnssDecUbxNavPvt_t, nano, 16, I4),
+    U_GNSS_DEC_FIELD(uGnssDecUbxNavPvt_t, fixType, 20, U1),
+    U_GNSS_DEC_FIELD(uGnssDecUbxNavPvt_t, flags, 21, U1),
+    U_GNSS_DEC_FIELD(uGnssDecUbxNavPvt_t, flags2, 22, U1),
+    U_GNSS_DEC_FIELD(uGnssDecUbxNavPvt_t, numSV, 23, U1),
+    U_GNSS_DEC_FIELD(uGnssDecUbxNavPvt_t, lon, 24, I4),
+    U_GNSS_DEC_FIELD(uGnssDecUbxNavPvt_t, lat, 28, I4),
+    U_GNSS_DEC_FIELD(uGnssDecUbxNavPvt_t, height, 32, I4),
+    U_GNSS_DEC_FIELD(uGnssDecUbxNavPvt_t, hMSL, 36, I4),
+    U_GNSS_DEC_FIELD(uGnssDecUbxNavPvt_t, hAcc, 40, U4),
+    U_GNSS_DEC_FIELD(uGnssDecUbxNavPvt_t, vAcc, 44, U4),
+    U_GNSS_DEC_FIELD(uGnssDecUbxNavPvt_t, velN, 48, I4),
+    U_GNSS_DEC_FIELD(uGnssDecUbxNavPvt_t, velE, 52, I4),
+    U_GNSS_DEC_FIELD(uGnssDecUbxNavPvt_t, velD, 56, I4),
+    U_GNSS_DEC_FIELD(uGnssDecUbxNavPvt_t, gSpeed, 60, I4),
+    U_GNSS_DEC_FIELD(uGnssDecUbxNavPvt_t, headMot, 64, I4),
+    U_GNSS_DEC_FIELD(uGnssDecUbxNavPvt_t, sAcc, 68, U4),
+    U_GNSS_DEC_FIELD(uGnssDecUbxNavPvt_t, headAcc, 72, U4),
+    U_GNSS_DEC_FIELD(uGnssDecUbxNavPvt_t, pDOP, 76, U2),
+    U_GNSS_DEC_FIELD(uGnssDecUbxNavPvt_t, flags3, 78, U2),
+    U_GNSS_DEC_FIELD(uGnssDecUbxNavPvt_t, headVeh, 84, I4),
+    U_GNSS_DEC_FIELD(uGnssDecUbxNavPvt_t, magDec, 88, I2),
+    U_GNSS_DEC_FIELD(uGnssDecUbxNavPvt_t, magAcc, 90, U2)
+};
+
+/** UBX-NAV-STATUS.
+ */
+static const uGnssDecField_t gNavStatus[] = {
+    U_GNSS_DEC_FIELD(uGnssDecUbxNavStatus_t, iTOW, 0, U4),
+    U_GNSS_DEC_FIELD(uGnssDecUbxNavStatus_t, gpsFix, 4, U1),
+    U_GNSS_DEC_FIELD(uGnssDecUbxNavStatus_t, flags, 5, U1),
+    U_GNSS_DEC_FIELD(uGnssDecUbxNavStatus_t, fixStat, 6, U1),
+    U_GNSS_DEC_FIELD(uGnssDecUbxNavStatus_t, flags2, 7, U1),
+    U_GNSS_DEC_FIELD(uGnssDecUbxNavStatus_t, ttff, 8, U4),
+    U_GNSS_DEC_FIELD(uGnssDecUbxNavStatus_t, msss, 12, U4)
+};
+
+/** UBX-NAV-SAT, fixed part.
+ */
+static const uGnssDecField_t gNavSat[] = {
+    U_GNSS_DEC_FIELD(uGnssDecUbxNavSat_t, iTOW, 0, U4),
+    U_GNSS_DEC_FIELD(uGnssDecUbxNavSat_t, version, 4, U1),
+    U_GNSS_DEC_FIELD(uGnssDecUbxNavSat_t, numSvs, 5, U1)
+};
+
+/** UBX-NAV-SAT, satellite block.
+ */
+static const uGnssDecField_t gNavSatSv[] = {
+    U_GNSS_DEC_FIELD(uGnssDecUbxNavSatSv_t, gnssId, 0, U1),
+    U_GNSS_DEC_FIELD(uGnssDecUbxNavSatSv_t, svId, 1, U1),
+    U_GNSS_DEC_FIELD(uGnssDecUbxNavSatSv_t, cno, 2, U1),
+    U_GNSS_DEC_FIELD(uGnssDecUbxNavSatSv_t, elev, 3, I1),
+    U_GNSS_DEC_FIELD(uGnssDecUbxNavSatSv_t, azim, 4, I2),
+    U_GNSS_DEC_FIELD(uGnssDecUbxNavSatSv_t, prRes, 6, I2),
+    U_GNSS_DEC_FIELD(uGnssDecUbxNavSatSv_t, flags, 8, U4)
+};
+
+/** UBX-NAV-SAT blocks.
+ */
+static const uGnssDecBlock_t gNavSatBlock = {8, 12, gNavSatSv,
+                                             U_GNSS_DEC_NUM_FIELDS(gNavSatSv)
+                                            };
+
+/** UBX-MON-VER blocks: there are no fields, the block is a string.
+ */
+static const uGnssDecBlock_t gMonVerBlock = {U_GNSS_DEC_UBX_MON_VER_SW_VERSION_LENGTH_BYTES +
+                                             U_GNSS_DEC_UBX_MON_VER_HW_VERSION_LENGTH_BYTES,
+                                             U_GNSS_DEC_UBX_MON_VER_EXTENSION_LENGTH_BYTES,
+                                             NULL, 0
+                                            };
+
+/** UBX-MON-COMMS, fixed part; protIds[] is added in code.
+ */
+static const uGnssDecField_t gMonComms[] = {
+    U_GNSS_DEC_FIELD(uGnssDecUbxMonComms_t, version, 0, U1),
+    U_GNSS_DEC_FIELD(uGnssDecUbxMonComms_t, nPorts, 1, U1),
+    U_GNSS_DEC_FIELD(uGnssDecUbxMonComms_t, txErrors, 2, U1)
+};
+
+/** UBX-MON-COMMS, port block; msgs[] is added in code.
+ */
+static const uGnssDecField_t gMonCommsPort[] = {
+    U_GNSS_DEC_FIELD(uGnssDecUbxMonCommsPort_t, portId, 0, U2),
+    U_GNSS_DEC_FIELD(uGnssDecUbxMonCommsPort_t, txPending, 2, U2),
+    U_GNSS_DEC_FIELD(uGnssDecUbxMonCommsPort_t, txBytes, 4, U4),
+    U_GNSS_DEC_FIELD(uGnssDecUbxMonCommsPort_t, txUsage, 8, U1),
+    U_GNSS_DEC_FIELD(uGnssDecUbxMonCommsPort_t, txPeakUsage, 9, U1),
+    U_GNSS_DEC_FIELD(uGnssDecUbxMonCommsPort_t, rxPending, 10, U2),
+    U_GNSS_DEC_FIELD(uGnssDecUbxMonCommsPort_t, rxBytes, 12, U4),
+    U_GNSS_DEC_FIELD(uGnssDecUbxMonCommsPort_t, rxUsage, 16, U1),
+    U_GNSS_DEC_FIELD(uGnssDecUbxMonCommsPort_t, rxPeakUsage, 17, U1),
+    U_GNSS_DEC_FIELD(uGnssDecUbxMonCommsPort_t, overrunErrs, 18, U2),
+    U_GNSS_DEC_FIELD(uGnssDecUbxMonCommsPort_t, skipped, 36, U4)
+};
+
+/** UBX-MON-COMMS blocks.
+ */
+static const uGnssDecBlock_t gMonCommsBlock = {8, 40, gMonCommsPort,
+                                               U_GNSS_DEC_NUM_FIELDS(gMonCommsPort)
+                                              };
+
+/** UBX-RXM-RAWX, fixed part.
+ */
+static const uGnssDecField_t gRxmRawx[] = {
+    U_GNSS_DEC_FIELD(uGnssDecUbxRxmRawx_t, rcvTow, 0, R8),
+    U_GNSS_DEC_FIELD(uGnssDecUbxRxmRawx_t, week, 8, U2),
+    U_GNSS_DEC_FIELD(uGnssDecUbxRxmRawx_t, leapS, 10, I1),
+    U_GNSS_DEC_FIELD(uGnssDecUbxRxmRawx_t, numMeas, 11, U1),
+    U_GNSS_DEC_FIELD(uGnssDecUbxRxmRawx_t, recStat, 12, U1),
+    U_GNSS_DEC_FIELD(uGnssDecUbxRxmRawx_t, version, 13, U1)
+};
+
+/** UBX-RXM-RAWX, measurement block.
+ */
+static const uGnssDecField_t gRxmRawxMeas[] = {
+    U_GNSS_DEC_FIELD(uGnssDecUbxRxmRawxMeas_t, prMes, 0, R8),
+    U_GNSS_DEC_FIELD(uGnssDecUbxRxmRawxMeas_t, cpMes, 8, R8),
+    U_GNSS_DEC_FIELD(uGnssDecUbxRxmRawxMeas_t, doMes, 16, R4),
+    U_GNSS_DEC_FIELD(uGnssDecUbxRxmRawxMeas_t, gnssId, 20, U1),
+    U_GNSS_DEC_FIELD(uGnssDecUbxRxmRawxMeas_t, svId, 21, U1),
+    U_GNSS_DEC_FIELD(uGnssDecUbxRxmRawxMeas_t, sigId, 22, U1),
+    U_GNSS_DEC_FIELD(uGnssDecUbxRxmRawxMeas_t, freqId, 23, U1),
+    U_GNSS_DEC_FIELD(uGnssDecUbxRxmRawxMeas_t, locktime, 24, U2),
+    U_GNSS_DEC_FIELD(uGnssDecUbxRxmRawxMeas_t, cno, 26, U1),
+    U_GNSS_DEC_FIELD(uGnssDecUbxRxmRawxMeas_t, prStdev, 27, U1),
+    U_GNSS_DEC_FIELD(uGnssDecUbxRxmRawxMeas_t, cpStdev, 28, U1),
+    U_GNSS_DEC_FIELD(uGnssDecUbxRxmRawxMeas_t, doStdev, 29, U1),
+    U_GNSS_DEC_FIELD(uGnssDecUbxRxmRawxMeas_t, trkStat, 30, U1)
+};
+
+/** UBX-RXM-RAWX blocks.
+ */
+static const uGnssDecBlock_t gRxmRawxBlock = {16, 32, gRxmRawxMeas,
+                                              U_GNSS_DEC_NUM_FIELDS(gRxmRawxMeas)
+                                             };
+
+/** UBX-TIM-TP.
+ */
+static const uGnssDecField_t gTimTp[] = {
+    U_GNSS_DEC_FIELD(uGnssDecUbxTimTp_t, towMS, 0, U4),
+    U_GNSS_DEC_FIELD(uGnssDecUbxTimTp_t, towSubMS, 4, U4),
+    U_GNSS_DEC_FIELD(uGnssDecUbxTimTp_t, qErr, 8, I4),
+    U_GNSS_DEC_FIELD(uGnssDecUbxTimTp_t, week, 12, U2),
+    U_GNSS_DEC_FIELD(uGnssDecUbxTimTp_t, flags, 14, U1),
+    U_GNSS_DEC_FIELD(uGnssDecUbxTimTp_t, refInfo, 15, U1)
+};
+
+/** UBX-ESF-ALG.
+ */
+static const uGnssDecField_t gEsfAlg[] = {
+    U_GNSS_DEC_FIELD(uGnssDecUbxEsfAlg_t, iTOW, 0, U4),
+    U_GNSS_DEC_FIELD(uGnssDecUbxEsfAlg_t, version, 4, U1),
+    U_GNSS_DEC_FIELD(uGnssDecUbxEsfAlg_t, flags, 5, U1),
+    U_GNSS_DEC_FIELD(uGnssDecUbxEsfAlg_t, errors, 6, U1),
+    U_GNSS_DEC_FIELD(uGnssDecUbxEsfAlg_t, yaw, 8, U4),
+    U_GNSS_DEC_FIELD(uGnssDecUbxEsfAlg_t, pitch, 12, I2),
+    U_GNSS_DEC_FIELD(uGnssDecUbxEsfAlg_t, roll, 14, I2)
+};
+
+/** UBX-ESF-INS.
+ */
+static const uGnssDecField_t gEsfIns[] = {
+    U_GNSS_DEC_FIELD(uGnssDecUbxEsfIns_t, bitfield0, 0, U4),
+    U_GNSS_DEC_FIELD(uGnssDecUbxEsfIns_t, iTOW, 8, U4),
+    U_GNSS_DEC_FIELD(uGnssDecUbxEsfIns_t, xAngRate, 12, I4),
+    U_GNSS_DEC_FIELD(uGnssDecUbxEsfIns_t, yAngRate, 16, I4),
+    U_GNSS_DEC_FIELD(uGnssDecUbxEsfIns_t, zAngRate, 20, I4),
+    U_GNSS_DEC_FIELD(uGnssDecUbxEsfIns_t, xAccel, 24, I4),
+    U_GNSS_DEC_FIELD(uGnssDecUbxEsfIns_t, yAccel, 28, I4),
+    U_GNSS_DEC_FIELD(uGnssDecUbxEsfIns_t, zAccel, 32, I4)
+};
+
+/** UBX-ESF-MEAS, fixed part; numMeas, calibTtagValid and
+ * calibTtag are added in code.
+ */
+static const uGnssDecField_t gEsfMeas[] = {
+    U_GNSS_DEC_FIELD(uGnssDecUbxEsfMeas_t, timeTag, 0, U4),
+    U_GNSS_DEC_FIELD(uGnssDecUbxEsfMeas_t, flags, 4, U2),
+    U_GNSS_DEC_FIELD(uGnssDecUbxEsfMeas_t, id, 6, U2)
+};
+
+/** UBX-ESF-MEAS blocks: a single X4 which is split up in code.
+ */
+static const uGnssDecBlock_t gEsfMeasBlock = {8, 4, NULL, 0};
+
+/** UBX-ESF-RAW, data block; the data X4 is split up in code.
+ */
+static const uGnssDecField_t gEsfRawData[] = {
+    U_GNSS_DEC_FIELD(uGnssDecUbxEsfData_t, sTtag, 4, U4)
+};
+
+/** UBX-ESF-RAW blocks.
+ */
+static const uGnssDecBlock_t gEsfRawBlock = {4, 8, gEsfRawData,
+                                             U_GNSS_DEC_NUM_FIELDS(gEsfRawData)
+                                            };
+
+/** UBX-ESF-STATUS, fixed part.
+ */
+static const uGnssDecField_t gEsfStatus[] = {
+    U_GNSS_DEC_FIELD(uGnssDecUbxEsfStatus_t, iTOW, 0, U4),
+    U_GNSS_DEC_FIELD(uGnssDecUbxEsfStatus_t, version, 4, U1),
+    U_GNSS_DEC_FIELD(uGnssDecUbxEsfStatus_t, fusionMode, 12, U1),
+    U_GNSS_DEC_FIELD(uGnssDecUbxEsfStatus_t, numSens, 15, U1)
+};
+
+/** UBX-ESF-STATUS, sensor block.
+ */
+static const uGnssDecField_t gEsfStatusSens[] = {
+    U_GNSS_DEC_FIELD(uGnssDecUbxEsfStatusSens_t, sensStatus1, 0, U1),
+    U_GNSS_DEC_FIELD(uGnssDecUbxEsfStatusSens_t, sensStatus2, 1, U1),
+    U_GNSS_DEC_FIELD(uGnssDecUbxEsfStatusSens_t, freq, 2, U1),
+    U_GNSS_DEC_FIELD(uGnssDecUbxEsfStatusSens_t, faults, 3, U1)
+};
+
+/** UBX-ESF-STATUS blocks.
+ */
+static const uGnssDecBlock_t gEsfStatusBlock = {16, 4, gEsfStatusSens,
+                                                U_GNSS_DEC_NUM_FIELDS(gEsfStatusSens)
+                                               };
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Return the total length of a view.
+static size_t viewLength(const uGnssMsgView_t *pView)
+{
+    return pView->size1 + pView->size2;
+}
+
+// Read a little-endian unsigned integer of sizeBytes (1 to 8) from
+// the given offset in a view, which the caller must have checked
+// is in range; the value may straddle the two pieces of the view.
+static uint64_t viewGet(const uGnssMsgView_t *pView, size_t offset,
+                        size_t sizeBytes)
+{
+    uint64_t value = 0;
+    const char *pByte;
+
+    if (offset + sizeBytes <= pView->size1) {
+        // All in the first piece, the usual case
+        pByte = pView->pData1 + offset;
+        for (size_t x = 0; x < sizeBytes; x++) {
+            value |= ((uint64_t) (uint8_t) * (pByte + x)) << (x * 8);
+        }
+    } else {
+        for (size_t x = 0; x < sizeBytes; x++, offset++) {
+            if (offset < pView->size1) {
+                pByte = pView->pData1 + offset;
+            } else {
+                pByte = pView->pData2 + offset - pView->size1;
+            }
+            value |= ((uint64_t) (uint8_t) *pByte) << (x * 8);
+        }
+    }
+
+    return value;
+}
+
+// Copy a fixed-length string field out of a view, adding a
+// null terminator; pString must be of length sizeBytes + 1.
+static void viewGetString(const uGnssMsgView_t *pView, size_t offset,
+                          size_t sizeBytes, char *pString)
+{
+    for (size_t x = 0; x < sizeBytes; x++) {
+        pString[x] = (char) viewGet(pView, offset + x, 1);
+    }
+    pString[sizeBytes] = 0;
+}
+
+// Decode the fields in the table pFields from the view, starting
+// at offset, into pStruct; the caller must have checked that the
+// view is long enough.
+static void decodeFields(const uGnssMsgView_t *pView, size_t offset,
+                         const uGnssDecField_t *pFields, size_t numFields,
+                         void *pStruct)
+{
+    char *pDestination;
+    uint64_t value;
+    uint8_t value8;
+    uint16_t value16;
+    uint32_t value32;
+
+    for (size_t x = 0; x < numFields; x++, pFields++) {
+        pDestination = ((char *) pStruct) + pFields->structOffset;
+        // The value is assembled numerically from the little-endian
+        // bytes so the native representation of the unsigned
+        // integer of the same width is what is copied into the
+        // structure, whether the field there is signed or floating
+        // point; that is what makes this endian-safe
+        switch (pFields->type) {
+            case U_GNSS_DEC_TYPE_U1:
+            case U_GNSS_DEC_TYPE_I1:
+                value8 = (uint8_t) viewGet(pView, offset + pFields->bodyOffset, 1);
+                memcpy(pDestination, &value8, sizeof(value8));
+                break;
+            case U_GNSS_DEC_TYPE_U2:
+            case U_GNSS_DEC_TYPE_I2:
+                value16 = (uint16_t) viewGet(pView, offset + pFields->bodyOffset, 2);
+                memcpy(pDestination, &value16, sizeof(value16));
+                break;
+            case U_GNSS_DEC_TYPE_U4:
+            case U_GNSS_DEC_TYPE_I4:
+            case U_GNSS_DEC_TYPE_R4:
+                value32 = (uint32_t) viewGet(pView, offset + pFields->bodyOffset, 4);
+                memcpy(pDestination, &value32, sizeof(value32));
+                break;
+            case U_GNSS_DEC_TYPE_R8:
+                value = viewGet(pView, offset + pFields->bodyOffset, 8);
+                memcpy(pDestination, &value, sizeof(value));
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+// Decode a message with no repeated blocks.
+static int32_t decodeFixed(const uGnssMsgView_t *pBody, size_t length,
+                           const uGnssDecField_t *pFields, size_t numFields,
+                           void *pStruct)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+
+    if ((pBody != NULL) && (pStruct != NULL)) {
+        errorCode = (int32_t) U_ERROR_COMMON_DEVICE_ERROR;
+        // Newer versions of a message may be longer, hence >=
+        if (viewLength(pBody) >= length) {
+            decodeFields(pBody, 0, pFields, numFields, pStruct);
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        }
+    }
+
+    return errorCode;
+}
+
+// Check that the given number of blocks fits into a message body;
+// returns the number of blocks or negative error code.
+static int32_t blockCount(const uGnssMsgView_t *pBody,
+                          const uGnssDecBlock_t *pBlock, size_t count)
+{
+    int32_t errorCodeOrCount = (int32_t) U_ERROR_COMMON_DEVICE_ERROR;
+
+    if (viewLength(pBody) >= pBlock->headerLength + (count * pBlock->blockLength)) {
+        errorCodeOrCount = (int32_t) count;
+    }
+
+    return errorCodeOrCount;
+}
+
+// Decode the block at index, where the number of blocks is count;
+// returns the offset of the block in the body or negative error code.
+static int32_t decodeBlock(const uGnssMsgView_t *pBody, size_t index,
+                           int32_t count, const uGnssDecBlock_t *pBlock,
+                           void *pStruct)
+{
+    int32_t errorCodeOrOffset = count;
+
+    if (count >= 0) {
+        errorCodeOrOffset = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if ((pStruct != NULL) && (index < (size_t) count)) {
+            errorCodeOrOffset = (int32_t) (pBlock->headerLength +
+                                           (index * pBlock->blockLength));
+            decodeFields(pBody, (size_t) errorCodeOrOffset, pBlock->pFields,
+                         pBlock->numFields, pStruct);
+        }
+    }
+
+    return errorCodeOrOffset;
+}
+
+// Split up the X4 data word of UBX-ESF-MEAS or UBX-ESF-RAW.
+static void esfData(uint32_t data, uint8_t dataTypeMask,
+                    uGnssDecUbxEsfData_t *pData)
+{
+    uint32_t dataField = data & 0x00FFFFFF;
+
+    // Sign-extend the 24-bit data field
+    if (dataField & 0x00800000) {
+        dataField |= 0xFF000000;
+    }
+    pData->dataField = (int32_t) dataField;
+    pData->dataType = (uint8_t) (data >> 24) & dataTypeMask;
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Get the body of a UBX message.
+int32_t uGnssDecUbxBody(const uGnssMsgView_t *pMessage, uGnssMsgView_t *pBody)
+{
+    int32_t errorCodeOrId = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uGnssMsgView_t body = {0};
+    size_t bodyLength;
+
+    if ((pMessage != NULL) && (pBody != NULL)) {
+        errorCodeOrId = (int32_t) U_ERROR_COMMON_DEVICE_ERROR;
+        if ((viewLength(pMessage) >= U_UBX_PROTOCOL_OVERHEAD_LENGTH_BYTES) &&
+            (viewGet(pMessage, 0, 1) == 0xb5) && (viewGet(pMessage, 1, 1) == 0x62)) {
+            bodyLength = (size_t) viewGet(pMessage, 4, 2);
+            if (viewLength(pMessage) >= bodyLength + U_UBX_PROTOCOL_OVERHEAD_LENGTH_BYTES) {
+                if (pMessage->size1 > U_UBX_PROTOCOL_HEADER_LENGTH_BYTES) {
+                    body.pData1 = pMessage->pData1 + U_UBX_PROTOCOL_HEADER_LENGTH_BYTES;
+                    body.size1 = pMessage->size1 - U_UBX_PROTOCOL_HEADER_LENGTH_BYTES;
+                    if (body.size1 >= bodyLength) {
+                        body.size1 = bodyLength;
+                    } else {
+                        body.pData2 = pMessage->pData2;
+                        body.size2 = bodyLength - body.size1;
+                    }
+                } else {
+                    // The header straddles the wrap, or ends
+                    // exactly at it, so the body is all in pData2
+                    body.pData1 = pMessage->pData2 + U_UBX_PROTOCOL_HEADER_LENGTH_BYTES -
+                                  pMessage->size1;
+                    body.size1 = bodyLength;
+                }
+                errorCodeOrId = (int32_t) viewGet(pMessage, 2, 2);
+                // Class is first in the message, hence the swap
+                errorCodeOrId = ((errorCodeOrId & 0xFF) << 8) | ((errorCodeOrId >> 8) & 0xFF);
+                *pBody = body;
+            }
+        }
+    }
+
+    return errorCodeOrId;
+}
+
+// Decode UBX-NAV-PVT.
+int32_t uGnssDecUbxNavPvt(const uGnssMsgView_t *pBody,
+                          uGnssDecUbxNavPvt_t *pNavPvt)
+{
+    return decodeFixed(pBody, U_GNSS_DEC_UBX_NAV_PVT_BODY_LENGTH_BYTES,
+                       gNavPvt, U_GNSS_DEC_NUM_FIELDS(gNavPvt), pNavPvt);
+}
+
+// Get the UTC time from a decoded UBX-NAV-PVT.
+int64_t uGnssDecUbxNavPvtGetTimeUtc(const uGnssDecUbxNavPvt_t *pNavPvt)
+{
+    int64_t t = -1;
+    int32_t months;
+
+    if ((pNavPvt != NULL) && ((pNavPvt->valid & 0x03) == 0x03)) {
+        // Date and time are valid
+        t = 0;
+        // Year is 1999-2099, so need to adjust to get year since 1970
+        months = ((int32_t) pNavPvt->year - 1999) + 29;
+        // Month (1 to 12), so take away 1 to make it zero-based
+        months = (months * 12) + pNavPvt->month - 1;
+        // Work out the number of seconds due to the year/month count
+        t += uTimeMonthsToSecondsUtc(months);
+        // Day (1 to 31)
+        t += ((int32_t) pNavPvt->day - 1) * 3600 * 24;
+        // Hour (0 to 23)
+        t += ((int32_t) pNavPvt->hour) * 3600;
+        // Minute (0 to 59)
+        t += ((int32_t) pNavPvt->min) * 60;
+        // Second (0 to 60)
+        t += pNavPvt->sec;
+    }
+
+    return t;
+}
+
+// Decode UBX-NAV-STATUS.
+int32_t uGnssDecUbxNavStatus(const uGnssMsgView_t *pBody,
+                             uGnssDecUbxNavStatus_t *pNavStatus)
+{
+    return decodeFixed(pBody, U_GNSS_DEC_UBX_NAV_STATUS_BODY_LENGTH_BYTES,
+                       gNavStatus, U_GNSS_DEC_NUM_FIELDS(gNavStatus),
+                       pNavStatus);
+}
+
+// Decode the fixed part of UBX-NAV-SAT.
+int32_t uGnssDecUbxNavSat(const uGnssMsgView_t *pBody,
+                          uGnssDecUbxNavSat_t *pNavSat)
+{
+    int32_t errorCodeOrCount = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uGnssDecUbxNavSat_t navSat;
+
+    if (pBody != NULL) {
+        errorCodeOrCount = decodeFixed(pBody, gNavSatBlock.headerLength,
+                                       gNavSat, U_GNSS_DEC_NUM_FIELDS(gNavSat),
+                                       &navSat);
+        if (errorCodeOrCount == 0) {
+            errorCodeOrCount = blockCount(pBody, &gNavSatBlock, navSat.numSvs);
+            if (pNavSat != NULL) {
+                *pNavSat = navSat;
+            }
+        }
+    }
+
+    return errorCodeOrCount;
+}
+
+// Decode a satellite block of UBX-NAV-SAT.
+int32_t uGnssDecUbxNavSatSv(const uGnssMsgView_t *pBody, size_t index,
+                            uGnssDecUbxNavSatSv_t *pSv)
+{
+    int32_t errorCode = uGnssDecUbxNavSat(pBody, NULL);
+
+    errorCode = decodeBlock(pBody, index, errorCode, &gNavSatBlock, pSv);
+    if (errorCode > 0) {
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+    }
+
+    return errorCode;
+}
+
+// Decode the fixed part of UBX-MON-VER.
+int32_t uGnssDecUbxMonVer(const uGnssMsgView_t *pBody,
+                          uGnssDecUbxMonVer_t *pMonVer)
+{
+    int32_t errorCodeOrCount = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+
+    if (pBody != NULL) {
+        errorCodeOrCount = (int32_t) U_ERROR_COMMON_DEVICE_ERROR;
+        if (viewLength(pBody) >= gMonVerBlock.headerLength) {
+            if (pMonVer != NULL) {
+                viewGetString(pBody, 0, sizeof(pMonVer->swVersion) - 1,
+                              pMonVer->swVersion);
+                viewGetString(pBody, sizeof(pMonVer->swVersion) - 1,
+                              sizeof(pMonVer->hwVersion) - 1,
+                              pMonVer->hwVersion);
+            }
+            errorCodeOrCount = (int32_t) ((viewLength(pBody) - gMonVerBlock.headerLength) /
+                                          gMonVerBlock.blockLength);
+        }
+    }
+
+    return errorCodeOrCount;
+}
+
+// Decode an extension block of UBX-MON-VER.
+int32_t uGnssDecUbxMonVerExtension(const uGnssMsgView_t *pBody, size_t index,
+                                   uGnssDecUbxMonVerExtension_t *pExtension)
+{
+    int32_t errorCode = uGnssDecUbxMonVer(pBody, NULL);
+
+    errorCode = decodeBlock(pBody, index, errorCode, &gMonVerBlock, pExtension);
+    if (errorCode > 0) {
+        viewGetString(pBody, (size_t) errorCode, gMonVerBlock.blockLength,
+                      pExtension->extension);
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+    }
+
+    return errorCode;
+}
+
+// Decode the fixed part of UBX-MON-COMMS.
+int32_t uGnssDecUbxMonComms(const uGnssMsgView_t *pBody,
+                            uGnssDecUbxMonComms_t *pMonComms)
+{
+    int32_t errorCodeOrCount = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uGnssDecUbxMonComms_t monComms;
+
+    if (pBody != NULL) {
+        errorCodeOrCount = decodeFixed(pBody, gMonCommsBlock.headerLength,
+                                       gMonComms, U_GNSS_DEC_NUM_FIELDS(gMonComms),
+                                       &monComms);
+        if (errorCodeOrCount == 0) {
+            for (size_t x = 0; x < U_GNSS_DEC_UBX_MON_COMMS_NUM_PROT_IDS; x++) {
+                monComms.protIds[x] = (uint8_t) viewGet(pBody, 4 + x, 1);
+            }
+            errorCodeOrCount = blockCount(pBody, &gMonCommsBlock, monComms.nPorts);
+            if (pMonComms != NULL) {
+                *pMonComms = monComms;
+            }
+        }
+    }
+
+    return errorCodeOrCount;
+}
+
+// Decode a port block of UBX-MON-COMMS.
+int32_t uGnssDecUbxMonCommsPort(const uGnssMsgView_t *pBody, size_t index,
+                                uGnssDecUbxMonCommsPort_t *pPort)
+{
+    int32_t errorCode = uGnssDecUbxMonComms(pBody, NULL);
+
+    errorCode = decodeBlock(pBody, index, errorCode, &gMonCommsBlock, pPort);
+    if (errorCode > 0) {
+        for (size_t x = 0; x < U_GNSS_DEC_UBX_MON_COMMS_NUM_PROT_IDS; x++) {
+            pPort->msgs[x] = (uint16_t) viewGet(pBody, (size_t) errorCode + 20 + (x * 2), 2);
+        }
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+    }
+
+    return errorCode;
+}
+
+// Decode the fixed part of UBX-RXM-RAWX.
+int32_t uGnssDecUbxRxmRawx(const uGnssMsgView_t *pBody,
+                           uGnssDecUbxRxmRawx_t *pRxmRawx)
+{
+    int32_t errorCodeOrCount = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uGnssDecUbxRxmRawx_t rxmRawx;
+
+    if (pBody != NULL) {
+        errorCodeOrCount = decodeFixed(pBody, gRxmRawxBlock.headerLength,
+                                       gRxmRawx, U_GNSS_DEC_NUM_FIELDS(gRxmRawx),
+                                       &rxmRawx);
+        if (errorCodeOrCount == 0) {
+            errorCodeOrCount = blockCount(pBody, &gRxmRawxBlock, rxmRawx.numMeas);
+            if (pRxmRawx != NULL) {
+                *pRxmRawx = rxmRawx;
+            }
+        }
+    }
+
+    return errorCodeOrCount;
+}
+
+// Decode a measurement block of UBX-RXM-RAWX.
+int32_t uGnssDecUbxRxmRawxMeas(const uGnssMsgView_t *pBody, size_t index,
+                               uGnssDecUbxRxmRawxMeas_t *pMeas)
+{
+    int32_t errorCode = uGnssDecUbxRxmRawx(pBody, NULL);
+
+    errorCode = decodeBlock(pBody, index, errorCode, &gRxmRawxBlock, pMeas);
+    if (errorCode > 0) {
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+    }
+
+    return errorCode;
+}
+
+// Decode UBX-TIM-TP.
+int32_t uGnssDecUbxTimTp(const uGnssMsgView_t *pBody,
+                         uGnssDecUbxTimTp_t *pTimTp)
+{
+    return decodeFixed(pBody, U_GNSS_DEC_UBX_TIM_TP_BODY_LENGTH_BYTES,
+                       gTimTp, U_GNSS_DEC_NUM_FIELDS(gTimTp), pTimTp);
+}
+
+// Decode UBX-ESF-ALG.
+int32_t uGnssDecUbxEsfAlg(const uGnssMsgView_t *pBody,
+                          uGnssDecUbxEsfAlg_t *pEsfAlg)
+{
+    return decodeFixed(pBody, U_GNSS_DEC_UBX_ESF_ALG_BODY_LENGTH_BYTES,
+                       gEsfAlg, U_GNSS_DEC_NUM_FIELDS(gEsfAlg), pEsfAlg);
+}
+
+// Decode UBX-ESF-INS.
+int32_t uGnssDecUbxEsfIns(const uGnssMsgView_t *pBody,
+                          uGnssDecUbxEsfIns_t *pEsfIns)
+{
+    return decodeFixed(pBody, U_GNSS_DEC_UBX_ESF_INS_BODY_LENGTH_BYTES,
+                       gEsfIns, U_GNSS_DEC_NUM_FIELDS(gEsfIns), pEsfIns);
+}
+
+// Decode the fixed part of UBX-ESF-MEAS.
+int32_t uGnssDecUbxEsfMeas(const uGnssMsgView_t *pBody,
+                           uGnssDecUbxEsfMeas_t *pEsfMeas)
+{
+    int32_t errorCodeOrCount = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uGnssDecUbxEsfMeas_t esfMeas;
+    size_t count;
+
+    if (pBody != NULL) {
+        errorCodeOrCount = decodeFixed(pBody, gEsfMeasBlock.headerLength,
+                                       gEsfMeas, U_GNSS_DEC_NUM_FIELDS(gEsfMeas),
+                                       &esfMeas);
+        if (errorCodeOrCount == 0) {
+            esfMeas.numMeas = (uint8_t) (esfMeas.flags >> 11);
+            esfMeas.calibTtagValid = ((esfMeas.flags & 0x08) != 0);
+            esfMeas.calibTtag = 0;
+            count = esfMeas.numMeas;
+            if (esfMeas.calibTtagValid) {
+                // Count calibTtag as an extra block to check the length
+                count++;
+            }
+            errorCodeOrCount = blockCount(pBody, &gEsfMeasBlock, count);
+            if (errorCodeOrCount >= 0) {
+                if (esfMeas.calibTtagValid) {
+                    esfMeas.calibTtag = (uint32_t) viewGet(pBody, gEsfMeasBlock.headerLength +
+                                                           (esfMeas.numMeas *
+                                                            gEsfMeasBlock.blockLength), 4);
+                }
+                errorCodeOrCount = esfMeas.numMeas;
+            }
+            if (pEsfMeas != NULL) {
+                *pEsfMeas = esfMeas;
+            }
+        }
+    }
+
+    return errorCodeOrCount;
+}
+
+// Decode a data block of UBX-ESF-MEAS.
+int32_t uGnssDecUbxEsfMeasData(const uGnssMsgView_t *pBody, size_t index,
+                               uGnssDecUbxEsfData_t *pData)
+{
+    int32_t errorCode = uGnssDecUbxEsfMeas(pBody, NULL);
+
+    errorCode = decodeBlock(pBody, index, errorCode, &gEsfMeasBlock, pData);
+    if (errorCode > 0) {
+        esfData((uint32_t) viewGet(pBody, (size_t) errorCode, 4), 0x3F, pData);
+        pData->sTtag = 0;
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+    }
+
+    return errorCode;
+}
+
+// Get the number of data blocks in UBX-ESF-RAW.
+int32_t uGnssDecUbxEsfRaw(const uGnssMsgView_t *pBody)
+{
+    int32_t errorCodeOrCount = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+
+    if (pBody != NULL) {
+        errorCodeOrCount = (int32_t) U_ERROR_COMMON_DEVICE_ERROR;
+        if (viewLength(pBody) >= gEsfRawBlock.headerLength) {
+            errorCodeOrCount = (int32_t) ((viewLength(pBody) - gEsfRawBlock.headerLength) /
+                                          gEsfRawBlock.blockLength);
+        }
+    }
+
+    return errorCodeOrCount;
+}
+
+// Decode a data block of UBX-ESF-RAW.
+int32_t uGnssDecUbxEsfRawData(const uGnssMsgView_t *pBody, size_t index,
+                              uGnssDecUbxEsfData_t *pData)
+{
+    int32_t errorCode = uGnssDecUbxEsfRaw(pBody);
+
+    errorCode = decodeBlock(pBody, index, errorCode, &gEsfRawBlock, pData);
+    if (errorCode > 0) {
+        esfData((uint32_t) viewGet(pBody, (size_t) errorCode, 4), 0xFF, pData);
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+    }
+
+    return errorCode;
+}
+
+// Decode the fixed part of UBX-ESF-STATUS.
+int32_t uGnssDecUbxEsfStatus(const uGnssMsgView_t *pBody,
+                             uGnssDecUbxEsfStatus_t *pEsfStatus)
+{
+    int32_t errorCodeOrCount = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uGnssDecUbxEsfStatus_t esfStatus;
+
+    if (pBody != NULL) {
+        errorCodeOrCount = decodeFixed(pBody, gEsfStatusBlock.headerLength,
+                                       gEsfStatus, U_GNSS_DEC_NUM_FIELDS(gEsfStatus),
+                                       &esfStatus);
+        if (errorCodeOrCount == 0) {
+            errorCodeOrCount = blockCount(pBody, &gEsfStatusBlock, esfStatus.numSens);
+            if (pEsfStatus != NULL) {
+                *pEsfStatus = esfStatus;
+            }
+        }
+    }
+
+    return errorCodeOrCount;
+}
+
+// Decode a sensor block of UBX-ESF-STATUS.
+int32_t uGnssDecUbxEsfStatusSens(const uGnssMsgView_t *pBody, size_t index,
+                                 uGnssDecUbxEsfStatusSens_t *pSens)
+{
+    int32_t errorCode = uGnssDecUbxEsfStatus(pBody, NULL);
+
+    errorCode = decodeBlock(pBody, index, errorCode, &gEsfStatusBlock, pSens);
+    if (errorCode > 0) {
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+    }
+
+    return errorCode;
+}
+
+// End of file
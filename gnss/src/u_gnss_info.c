@@ -51,6 +51,7 @@
 #include "u_gnss_type.h"
 #include "u_gnss_private.h"
 #include "u_gnss_msg.h" // uGnssMsgReceiveStatStreamLoss()
+#include "u_gnss_dec.h"
 #include "u_gnss_info.h"
 
 /* ----------------------------------------------------------------
@@ -284,9 +285,11 @@ int32_t uGnssInfoGetCommunicationStats(uDeviceHandle_t gnssHandle,
     int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
     uGnssPrivateInstance_t *pInstance;
     char *pMessage;
-    int32_t messageLength;
-    int32_t numPorts = -1;
-    int32_t protocolId;
+    uGnssMsgView_t body = {0};
+    uGnssDecUbxMonComms_t monComms;
+    uGnssDecUbxMonCommsPort_t monCommsPort;
+    int32_t numPorts;
+    size_t protocolId;
 
     if (gUGnssPrivateMutex != NULL) {
 
@@ -336,49 +339,45 @@ int32_t uGnssInfoGetCommunicationStats(uDeviceHandle_t gnssHandle,
                                                                   NULL, 0, pMessage,
                                                                   U_GNSS_INFO_MESSAGE_BODY_LENGTH_UBX_MON_COMMS);
                     if (errorCode >= 0) {
-                        messageLength = errorCode;
-                        if ((messageLength >= 2) && (*pMessage == 0)) {
-                            // Have a message in a version we understand;
-                            // get the number of ports reported in it
-                            numPorts = *(pMessage + 1);
+                        body.pData1 = pMessage;
+                        body.size1 = (size_t) errorCode;
+                        errorCode = uGnssDecUbxMonComms(&body, &monComms);
+                        if ((errorCode >= 0) && (monComms.version != 0)) {
+                            // Not a message version we understand
+                            errorCode = 0;
                         }
+                        numPorts = errorCode;
                         errorCode = (int32_t) U_ERROR_COMMON_DEVICE_ERROR;
-                        if ((numPorts > 0) && (messageLength >= 8 + (numPorts * 40))) {
-                            // The message has some ports in it and is of the correct
-                            // length for that number of ports; run through the
-                            // message in blocks of 40 bytes, the length of the
-                            // report for one port being 40 bytes, after the initial
-                            // 8 bytes, to find the report for our port number
-                            for (int32_t offset = 0; (8 + offset < messageLength) &&
-                                 (errorCode != (int32_t) U_ERROR_COMMON_SUCCESS); offset += 40) {
-                                // No endian conversion here as port is already endian converted
-                                if (*(uint16_t *) (pMessage + 8 + offset) == port) {
-                                    errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
-                                    if (pStats != NULL) {
-                                        pStats->txPendingBytes = uUbxProtocolUint16Decode(pMessage + 10 + offset);
-                                        pStats->txBytes = uUbxProtocolUint32Decode(pMessage + 12 + offset);
-                                        pStats->txPercentageUsage = *(pMessage + 16 + offset);
-                                        pStats->txPeakPercentageUsage = *(pMessage + 17 + offset);
-                                        pStats->rxPendingBytes = uUbxProtocolUint16Decode(pMessage + 18 + offset);
-                                        pStats->rxBytes = uUbxProtocolUint32Decode(pMessage + 20 + offset);
-                                        pStats->rxPercentageUsage = *(pMessage + 24 + offset);
-                                        pStats->rxPeakPercentageUsage = *(pMessage + 25 + offset);
-                                        pStats->rxOverrunErrors = uUbxProtocolUint16Decode(pMessage + 26 + offset);
-                                        // The number of messages parsed is in the array which follows
-                                        // based on the array of protocol IDs way back at the start
-                                        // of the message in byte 4
-                                        for (size_t x = 0; x < sizeof(pStats->rxNumMessages) / sizeof(pStats->rxNumMessages[0]); x++) {
-                                            pStats->rxNumMessages[x] = -1;
-                                        }
-                                        for (size_t x = 0; x < 4; x++) {
-                                            protocolId = *(pMessage + 4 + x);
-                                            if ((protocolId >= 0) &&
-                                                (protocolId < sizeof(pStats->rxNumMessages) / sizeof(pStats->rxNumMessages[0]))) {
-                                                pStats->rxNumMessages[protocolId] = uUbxProtocolUint16Decode(pMessage + 28 + offset + (x * 2));
-                                            }
+                        // Run through the port blocks to find the report
+                        // for our port number
+                        for (int32_t x = 0; (x < numPorts) &&
+                             (errorCode != (int32_t) U_ERROR_COMMON_SUCCESS); x++) {
+                            if ((uGnssDecUbxMonCommsPort(&body, x, &monCommsPort) == 0) &&
+                                (monCommsPort.portId == port)) {
+                                errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+                                if (pStats != NULL) {
+                                    pStats->txPendingBytes = monCommsPort.txPending;
+                                    pStats->txBytes = monCommsPort.txBytes;
+                                    pStats->txPercentageUsage = monCommsPort.txUsage;
+                                    pStats->txPeakPercentageUsage = monCommsPort.txPeakUsage;
+                                    pStats->rxPendingBytes = monCommsPort.rxPending;
+                                    pStats->rxBytes = monCommsPort.rxBytes;
+                                    pStats->rxPercentageUsage = monCommsPort.rxUsage;
+                                    pStats->rxPeakPercentageUsage = monCommsPort.rxPeakUsage;
+                                    pStats->rxOverrunErrors = monCommsPort.overrunErrs;
+                                    // The number of messages parsed is in the array
+                                    // monCommsPort.msgs[], indexed as for the array of
+                                    // protocol IDs at the start of the message
+                                    for (size_t y = 0; y < sizeof(pStats->rxNumMessages) / sizeof(pStats->rxNumMessages[0]); y++) {
+                                        pStats->rxNumMessages[y] = -1;
+                                    }
+                                    for (size_t y = 0; y < U_GNSS_DEC_UBX_MON_COMMS_NUM_PROT_IDS; y++) {
+                                        protocolId = monComms.protIds[y];
+                                        if (protocolId < sizeof(pStats->rxNumMessages) / sizeof(pStats->rxNumMessages[0])) {
+                                            pStats->rxNumMessages[protocolId] = monCommsPort.msgs[y];
                                         }
-                                        pStats->rxSkippedBytes = uUbxProtocolUint32Decode(pMessage + 44 + offset);
                                     }
+                                    pStats->rxSkippedBytes = monCommsPort.skipped;
                                 }
                             }
                         }
@@ -73,6 +73,7 @@
 #include "u_port_heap.h"
 #include "u_port_os.h"  // Required by u_gnss_private.h
 #include "u_port_debug.h"
+#include "u_port_event_queue.h" // U_PORT_EVENT_QUEUE_MIN_TASK_STACK_SIZE_BYTES
 #include "u_port_uart.h"
 #include "u_port_i2c.h"
 #include "u_port_spi.h"
@@ -112,7 +113,10 @@
 /** How long the asynchronous message receive task guarantees to give
  * to the rest of the system; if this is made larger the asynchronous
  * receive task won't be able to service the input stream so often
- * and hence the UART/I2C transport may overflow.
+ * and hence the UART/I2C transport may overflow.  Where the arrival
+ * of data is signalled, by a UART event or by
+ * uGnssMsgReceiveDataReady(), the task is woken immediately and this
+ * becomes the longest it will wait between polls.
  */
 # define U_GNSS_MSG_TASK_STACK_YIELD_TIME_MS 50
 #endif
@@ -124,6 +128,24 @@
 # error U_GNSS_MSG_TASK_STACK_YIELD_TIME_MS must be at least as big as U_CFG_OS_YIELD_MS
 #endif
 
+/** Make a dispatch key from a protocol type and a 24-bit value.
+ */
+#define U_GNSS_MSG_DISPATCH_KEY(type, value) ((((uint32_t) (type)) << 24) | \
+                                              (((uint32_t) (value)) & 0x00FFFFFFUL))
+
+/** The value used in a dispatch key for an NMEA message ID that
+ * contains "?" wildcards; such readers cannot be found by hash and
+ * so are all placed under this one key.
+ */
+#define U_GNSS_MSG_DISPATCH_NMEA_WILDCARD 0x00FFFFFFUL
+
+/** The maximum number of dispatch keys that a received message
+ * can match: one for ANY, one for ALL (or UNKNOWN) plus, for
+ * NMEA, one for each prefix of the message ID (including the empty
+ * one) and one for the wildcard; NMEA is the worst case.
+ */
+#define U_GNSS_MSG_DISPATCH_KEYS_MAX_NUM (U_GNSS_NMEA_MESSAGE_MATCH_LENGTH_CHARACTERS + 4)
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -136,13 +158,310 @@
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
 
+// UART event callback: wake up the message receive task, which will
+// do the actual reading.
+static void uartEventCallback(int32_t uartHandle, uint32_t eventBitmask,
+                              void *pParameters)
+{
+    (void) uartHandle;
+    (void) eventBitmask;
+
+    uPortSemaphoreGive((uPortSemaphoreHandle_t) pParameters);
+}
+
+// Set a UART event callback to wake up the message receive task,
+// if the transport is a UART and no-one else is using its events.
+static void uartEventCallbackSet(uGnssPrivateInstance_t *pInstance)
+{
+    uGnssPrivateMsgReceive_t *pMsgReceive = pInstance->pMsgReceive;
+    int32_t uartHandle;
+
+    if (uGnssPrivateGetStreamType(pInstance->transportType) == (int32_t) U_GNSS_PRIVATE_STREAM_TYPE_UART) {
+        uartHandle = uGnssPrivateGetStreamHandle(U_GNSS_PRIVATE_STREAM_TYPE_UART,
+                                                 pInstance->transportHandle);
+        if ((uartHandle >= 0) && (uPortUartEventCallbackFilterGet(uartHandle) == 0) &&
+            (uPortUartEventCallbackSet(uartHandle, U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED,
+                                       uartEventCallback,
+                                       (void *) pMsgReceive->dataReadySemaphoreHandle,
+                                       U_PORT_EVENT_QUEUE_MIN_TASK_STACK_SIZE_BYTES,
+                                       U_GNSS_MSG_RECEIVE_TASK_PRIORITY) == 0)) {
+            pMsgReceive->uartEventHandle = uartHandle;
+        }
+    }
+}
+
+// Add to an FNV-1a hash of an NMEA message ID, returning the new
+// hash, trimmed to fit into a dispatch key.
+static uint32_t dispatchHashNmea(uint32_t hash, char character)
+{
+    return ((hash ^ (uint8_t) character) * 16777619UL) % U_GNSS_MSG_DISPATCH_NMEA_WILDCARD;
+}
+
+// The starting value of an NMEA message ID hash.
+static uint32_t dispatchHashNmeaStart(void)
+{
+    return 2166136261UL % U_GNSS_MSG_DISPATCH_NMEA_WILDCARD;
+}
+
+// Get the dispatch key for a reader that wants the given message ID.
+static uint32_t dispatchKeyWanted(const uGnssPrivateMessageId_t *pMessageIdWanted)
+{
+    uint32_t value = 0;
+    const char *pNmea;
+    size_t x;
+
+    switch (pMessageIdWanted->type) {
+        case U_GNSS_PROTOCOL_UBX:
+            value = pMessageIdWanted->id.ubx;
+            break;
+        case U_GNSS_PROTOCOL_RTCM:
+            value = pMessageIdWanted->id.rtcm;
+            break;
+        case U_GNSS_PROTOCOL_NMEA:
+            pNmea = pMessageIdWanted->id.nmea;
+            value = dispatchHashNmeaStart();
+            for (x = 0; (x < U_GNSS_NMEA_MESSAGE_MATCH_LENGTH_CHARACTERS) &&
+                 (pNmea[x] != 0) && (value != U_GNSS_MSG_DISPATCH_NMEA_WILDCARD); x++) {
+                if (pNmea[x] == '?') {
+                    value = U_GNSS_MSG_DISPATCH_NMEA_WILDCARD;
+                } else {
+                    value = dispatchHashNmea(value, pNmea[x]);
+                }
+            }
+            break;
+        default:
+            break;
+    }
+
+    return U_GNSS_MSG_DISPATCH_KEY(pMessageIdWanted->type, value);
+}
+
+// Add a dispatch key to a list of keys if it is not already there.
+static size_t dispatchKeyAdd(uint32_t *pKeyList, size_t numKeys, uint32_t key)
+{
+    bool found = false;
+
+    for (size_t x = 0; (x < numKeys) && !found; x++) {
+        found = (pKeyList[x] == key);
+    }
+    if (!found && (numKeys < U_GNSS_MSG_DISPATCH_KEYS_MAX_NUM)) {
+        pKeyList[numKeys] = key;
+        numKeys++;
+    }
+
+    return numKeys;
+}
+
+// Populate pKeyList with all of the dispatch keys under which readers
+// that might want the given received message could be found,
+// returning the number of keys.
+static size_t dispatchKeysActual(const uGnssPrivateMessageId_t *pMessageId,
+                                 uint32_t *pKeyList)
+{
+    size_t numKeys = 0;
+    uint32_t value;
+    const char *pNmea;
+    size_t x;
+
+    numKeys = dispatchKeyAdd(pKeyList, numKeys,
+                             U_GNSS_MSG_DISPATCH_KEY(U_GNSS_PROTOCOL_ANY, 0));
+    if (pMessageId->type == U_GNSS_PROTOCOL_UNKNOWN) {
+        numKeys = dispatchKeyAdd(pKeyList, numKeys,
+                                 U_GNSS_MSG_DISPATCH_KEY(U_GNSS_PROTOCOL_UNKNOWN, 0));
+    } else {
+        numKeys = dispatchKeyAdd(pKeyList, numKeys,
+                                 U_GNSS_MSG_DISPATCH_KEY(U_GNSS_PROTOCOL_ALL, 0));
+        switch (pMessageId->type) {
+            case U_GNSS_PROTOCOL_UBX:
+                // The exact ID plus the three forms of wildcard
+                value = pMessageId->id.ubx;
+                numKeys = dispatchKeyAdd(pKeyList, numKeys,
+                                         U_GNSS_MSG_DISPATCH_KEY(U_GNSS_PROTOCOL_UBX, value));
+                numKeys = dispatchKeyAdd(pKeyList, numKeys,
+                                         U_GNSS_MSG_DISPATCH_KEY(U_GNSS_PROTOCOL_UBX,
+                                                                 value | U_GNSS_UBX_MESSAGE_ID_ALL));
+                numKeys = dispatchKeyAdd(pKeyList, numKeys,
+                                         U_GNSS_MSG_DISPATCH_KEY(U_GNSS_PROTOCOL_UBX,
+                                                                 value | (U_GNSS_UBX_MESSAGE_CLASS_ALL << 8)));
+                numKeys = dispatchKeyAdd(pKeyList, numKeys,
+                                         U_GNSS_MSG_DISPATCH_KEY(U_GNSS_PROTOCOL_UBX,
+                                                                 U_GNSS_UBX_MESSAGE_ALL));
+                break;
+            case U_GNSS_PROTOCOL_RTCM:
+                numKeys = dispatchKeyAdd(pKeyList, numKeys,
+                                         U_GNSS_MSG_DISPATCH_KEY(U_GNSS_PROTOCOL_RTCM,
+                                                                 pMessageId->id.rtcm));
+                numKeys = dispatchKeyAdd(pKeyList, numKeys,
+                                         U_GNSS_MSG_DISPATCH_KEY(U_GNSS_PROTOCOL_RTCM,
+                                                                 U_GNSS_RTCM_MESSAGE_ID_ALL));
+                break;
+            case U_GNSS_PROTOCOL_NMEA:
+                // A wanted NMEA ID matches if it is a prefix of the
+                // actual one, so hash every prefix, including the
+                // empty one, plus the wildcard key
+                pNmea = pMessageId->id.nmea;
+                value = dispatchHashNmeaStart();
+                numKeys = dispatchKeyAdd(pKeyList, numKeys,
+                                         U_GNSS_MSG_DISPATCH_KEY(U_GNSS_PROTOCOL_NMEA, value));
+                for (x = 0; (x < U_GNSS_NMEA_MESSAGE_MATCH_LENGTH_CHARACTERS) &&
+                     (pNmea[x] != 0); x++) {
+                    value = dispatchHashNmea(value, pNmea[x]);
+                    numKeys = dispatchKeyAdd(pKeyList, numKeys,
+                                             U_GNSS_MSG_DISPATCH_KEY(U_GNSS_PROTOCOL_NMEA, value));
+                }
+                numKeys = dispatchKeyAdd(pKeyList, numKeys,
+                                         U_GNSS_MSG_DISPATCH_KEY(U_GNSS_PROTOCOL_NMEA,
+                                                                 U_GNSS_MSG_DISPATCH_NMEA_WILDCARD));
+                break;
+            default:
+                break;
+        }
+    }
+
+    return numKeys;
+}
+
+// Get the dispatch table bucket for a key.
+static size_t dispatchBucket(uint32_t key)
+{
+    return (size_t) ((key ^ (key >> 8) ^ (key >> 16) ^ (key >> 24)) %
+                     U_GNSS_MSG_RECEIVE_DISPATCH_TABLE_SIZE);
+}
+
+// Add a reader to the dispatch table; readerMutexHandle must be locked.
+// Readers are added to the front of their bucket so that, since handles
+// only ever go up, each bucket is in descending order of handle.
+static void dispatchAdd(uGnssPrivateMsgReceive_t *pMsgReceive,
+                        uGnssPrivateMsgReader_t *pReader)
+{
+    size_t bucket;
+
+    pReader->dispatchKey = dispatchKeyWanted(&(pReader->privateMessageId));
+    bucket = dispatchBucket(pReader->dispatchKey);
+    pReader->pNextDispatch = pMsgReceive->pDispatch[bucket];
+    pMsgReceive->pDispatch[bucket] = pReader;
+}
+
+// Remove a reader from the dispatch table; readerMutexHandle must be locked.
+static void dispatchRemove(uGnssPrivateMsgReceive_t *pMsgReceive,
+                           uGnssPrivateMsgReader_t *pReader)
+{
+    uGnssPrivateMsgReader_t **ppCurrent;
+
+    ppCurrent = &(pMsgReceive->pDispatch[dispatchBucket(pReader->dispatchKey)]);
+    while ((*ppCurrent != NULL) && (*ppCurrent != pReader)) {
+        ppCurrent = &((*ppCurrent)->pNextDispatch);
+    }
+    if (*ppCurrent != NULL) {
+        *ppCurrent = pReader->pNextDispatch;
+    }
+}
+
+// Starting from pReader, find the next reader in a dispatch bucket that
+// is under the given key and wants the given message ID.
+static uGnssPrivateMsgReader_t *pDispatchNext(uGnssPrivateMsgReader_t *pReader,
+                                              uint32_t key,
+                                              uGnssPrivateMessageId_t *pMessageId)
+{
+    while ((pReader != NULL) &&
+           ((pReader->dispatchKey != key) ||
+            !uGnssPrivateMessageIdIsWanted(pMessageId, &(pReader->privateMessageId)))) {
+        pReader = pReader->pNextDispatch;
+    }
+
+    return pReader;
+}
+
+// Populate a view of what remains of the current message in the
+// ring buffer, as seen by the message receive task.
+static void viewGet(uGnssPrivateInstance_t *pInstance, uGnssMsgView_t *pView)
+{
+    uGnssPrivateMsgReceive_t *pMsgReceive = pInstance->pMsgReceive;
+    size_t size = pMsgReceive->msgBytesLeftToRead;
+
+    memset(pView, 0, sizeof(*pView));
+    if (size > 0) {
+        pView->size1 = uRingBufferPeekRegionHandle(&(pInstance->ringBuffer),
+                                                   pMsgReceive->ringBufferReadHandle,
+                                                   &(pView->pData1), 0);
+        if (pView->size1 > size) {
+            pView->size1 = size;
+        }
+        if (pView->size1 < size) {
+            // The message wraps around the end of the ring buffer
+            pView->size2 = uRingBufferPeekRegionHandle(&(pInstance->ringBuffer),
+                                                       pMsgReceive->ringBufferReadHandle,
+                                                       &(pView->pData2), pView->size1);
+            if (pView->size2 > size - pView->size1) {
+                pView->size2 = size - pView->size1;
+            }
+        }
+    }
+}
+
+// Call the callbacks of all of the readers that want the given message,
+// most recently added first, as before; readerMutexHandle must be locked.
+// Only the buckets for the keys the message could match are visited,
+// rather than the entire list of readers.
+static void dispatch(uGnssPrivateInstance_t *pInstance,
+                     uGnssPrivateMessageId_t *pPrivateMessageId,
+                     uGnssMessageId_t *pMessageId, int32_t errorCodeOrLength)
+{
+    uGnssPrivateMsgReceive_t *pMsgReceive = pInstance->pMsgReceive;
+    uint32_t keyList[U_GNSS_MSG_DISPATCH_KEYS_MAX_NUM];
+    uGnssPrivateMsgReader_t *pCursor[U_GNSS_MSG_DISPATCH_KEYS_MAX_NUM];
+    uGnssPrivateMsgReader_t *pReader;
+    uGnssMsgView_t view;
+    size_t numKeys;
+    size_t y;
+
+    numKeys = dispatchKeysActual(pPrivateMessageId, keyList);
+    for (size_t x = 0; x < numKeys; x++) {
+        pCursor[x] = pDispatchNext(pMsgReceive->pDispatch[dispatchBucket(keyList[x])],
+                                   keyList[x], pPrivateMessageId);
+    }
+
+    do {
+        // Merge the matching readers from each key by picking the
+        // one with the highest handle, i.e. the most recently added
+        pReader = NULL;
+        y = 0;
+        for (size_t x = 0; x < numKeys; x++) {
+            if ((pCursor[x] != NULL) &&
+                ((pReader == NULL) || (pCursor[x]->handle > pReader->handle))) {
+                pReader = pCursor[x];
+                y = x;
+            }
+        }
+        if (pReader != NULL) {
+            pCursor[y] = pDispatchNext(pReader->pNextDispatch, keyList[y],
+                                       pPrivateMessageId);
+            // This reader is interested, call the callback
+            if (pReader->callbackIsView) {
+                // Work out the view each time since a previous
+                // callback may have extracted some of the message
+                viewGet(pInstance, &view);
+                ((uGnssMsgReceiveViewCallback_t) pReader->pCallback)(pInstance->gnssHandle,
+                                                                     pMessageId,
+                                                                     errorCodeOrLength,
+                                                                     &view,
+                                                                     pReader->pCallbackParam);
+            } else {
+                ((uGnssMsgReceiveCallback_t) pReader->pCallback)(pInstance->gnssHandle,
+                                                                 pMessageId,
+                                                                 errorCodeOrLength,
+                                                                 pReader->pCallbackParam);
+            }
+        }
+    } while (pReader != NULL);
+}
+
 // Task that runs the non-blocking message receive.
 static void msgReceiveTask(void *pParam)
 {
     uGnssPrivateInstance_t *pInstance = (uGnssPrivateInstance_t *) pParam;
     char queueItem[U_GNSS_MSG_RECEIVE_TASK_QUEUE_ITEM_SIZE_BYTES];
     uGnssPrivateMsgReceive_t *pMsgReceive = pInstance->pMsgReceive;
-    uGnssPrivateMsgReader_t *pReader;
     int32_t errorCodeOrLength = (int32_t) U_ERROR_COMMON_UNKNOWN;
     int32_t receiveSize;
     int32_t yieldTimeMs;
@@ -191,23 +510,12 @@ static void msgReceiveTask(void *pParam)
 
                     if (uGnssPrivateMessageIdToPublic(&privateMessageId, &messageId, nmeaId) == 0) {
                         // Got something, with a message ID now in public form;
-                        // go through the list of readers looking for those interested
+                        // call the readers that are interested
 
                         U_PORT_MUTEX_LOCK(pMsgReceive->readerMutexHandle);
 
-                        pReader = pMsgReceive->pReaderList;
-                        while (pReader != NULL) {
-                            if (uGnssPrivateMessageIdIsWanted(&privateMessageId,
-                                                              &(pReader->privateMessageId))) {
-                                // This reader is interested, call the callback
-                                ((uGnssMsgReceiveCallback_t) pReader->pCallback)(pInstance->gnssHandle,
-                                                                                 &messageId,
-                                                                                 errorCodeOrLength,
-                                                                                 pReader->pCallbackParam);
-                            }
-                            // Next!
-                            pReader = pReader->pNext;
-                        }
+                        dispatch(pInstance, &privateMessageId, &messageId,
+                                 errorCodeOrLength);
 
                         U_PORT_MUTEX_UNLOCK(pMsgReceive->readerMutexHandle);
                     }
@@ -222,12 +530,13 @@ static void msgReceiveTask(void *pParam)
 
         // Relax to let others in; relax for twice as long if we last
         // received nothing and aren't desperately seeking more data,
-        // in order to allow some data to build up
+        // in order to allow some data to build up.  If the arrival
+        // of data is signalled we will be woken up before then.
         yieldTimeMs = U_GNSS_MSG_TASK_STACK_YIELD_TIME_MS;
         if ((receiveSize == 0) && (errorCodeOrLength != (int32_t) U_ERROR_COMMON_TIMEOUT))  {
             yieldTimeMs *= 2;
         }
-        uPortTaskBlock(yieldTimeMs);
+        uPortSemaphoreTryTake(pMsgReceive->dataReadySemaphoreHandle, yieldTimeMs);
     }
 
     // Now we can unlock our ring buffer read handle.  Phew.
@@ -278,6 +587,146 @@ int32_t msgReceiveCallbackRead(uDeviceHandle_t gnssHandle,
     return errorCodeOrLength;
 }
 
+// Monitor the output of the GNSS chip for a message: the guts of
+// uGnssMsgReceiveStart() and uGnssMsgReceiveStartView().
+static int32_t msgReceiveStart(uDeviceHandle_t gnssHandle,
+                               const uGnssMessageId_t *pMessageId,
+                               void *pCallback, bool callbackIsView,
+                               void *pCallbackParam)
+{
+    int32_t errorCodeOrHandle = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uGnssPrivateInstance_t *pInstance;
+    uGnssPrivateMsgReceive_t *pMsgReceive;
+    uGnssPrivateMsgReader_t *pReader;
+    const char *pTaskName = "gnssMsgRx";
+
+    if (gUGnssPrivateMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gUGnssPrivateMutex);
+
+        errorCodeOrHandle = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        pInstance = pUGnssPrivateGetInstance(gnssHandle);
+        if ((pInstance != NULL) && (pMessageId != NULL) && (pCallback != NULL)) {
+            errorCodeOrHandle = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+            pReader = (uGnssPrivateMsgReader_t *) pUPortMalloc(sizeof(uGnssPrivateMsgReader_t));
+            if (pReader != NULL) {
+                memset(pReader, 0, sizeof(*pReader));
+                // If the message receive task is not running
+                // at the moment, start it
+                if (pInstance->pMsgReceive == NULL) {
+                    pInstance->pMsgReceive = (uGnssPrivateMsgReceive_t *) pUPortMalloc(sizeof(
+                                                                                           uGnssPrivateMsgReceive_t));
+                    if (pInstance->pMsgReceive != NULL) {
+                        pMsgReceive = pInstance->pMsgReceive;
+                        memset(pMsgReceive, 0, sizeof(*pMsgReceive));
+                        pMsgReceive->uartEventHandle = -1;
+                        // Take a "master" read handle
+                        pMsgReceive->ringBufferReadHandle = uRingBufferTakeReadHandle(&(pInstance->ringBuffer));
+                        if (pMsgReceive->ringBufferReadHandle >= 0) {
+                            // Create the mutex that controls access to the linked-list of readers
+                            errorCodeOrHandle = uPortMutexCreate(&(pMsgReceive->readerMutexHandle));
+                            if (errorCodeOrHandle == 0) {
+                                // Create the queue that allows us to get the task to exit
+                                errorCodeOrHandle = uPortQueueCreate(U_GNSS_MSG_RECEIVE_TASK_QUEUE_LENGTH,
+                                                                     U_GNSS_MSG_RECEIVE_TASK_QUEUE_ITEM_SIZE_BYTES,
+                                                                     &(pMsgReceive->taskExitQueueHandle));
+                                if (errorCodeOrHandle == 0) {
+                                    // Create the mutex for task running status
+                                    errorCodeOrHandle = uPortMutexCreate(&(pMsgReceive->taskRunningMutexHandle));
+                                    if (errorCodeOrHandle == 0) {
+                                        // Create the semaphore that wakes the task when data arrives
+                                        errorCodeOrHandle = uPortSemaphoreCreate(&(pMsgReceive->dataReadySemaphoreHandle),
+                                                                                 0, 1);
+                                    }
+                                    if (errorCodeOrHandle == 0) {
+                                        //... and then the task
+                                        errorCodeOrHandle = uPortTaskCreate(msgReceiveTask,
+                                                                            pTaskName,
+                                                                            U_GNSS_MSG_RECEIVE_TASK_STACK_SIZE_BYTES,
+                                                                            pInstance, U_GNSS_MSG_RECEIVE_TASK_PRIORITY,
+                                                                            &(pMsgReceive->taskHandle));
+                                        if (errorCodeOrHandle == 0) {
+                                            pInstance->msgReceiveTaskHandle = pMsgReceive->taskHandle;
+                                            // Wait for the task to lock the mutex,
+                                            // which shows it is running
+                                            while (uPortMutexTryLock(pMsgReceive->taskRunningMutexHandle, 0) == 0) {
+                                                uPortMutexUnlock(pMsgReceive->taskRunningMutexHandle);
+                                                uPortTaskBlock(U_CFG_OS_YIELD_MS);
+                                            }
+                                            // If this is a UART that no-one else is getting
+                                            // events from, have it wake the task when data
+                                            // arrives; if that's not possible the task will
+                                            // just poll
+                                            uartEventCallbackSet(pInstance);
+                                        }
+                                    }
+                                }
+                            }
+                            if (errorCodeOrHandle != 0) {
+                                // Tidy up if we couldn't get OS resources
+                                if (pMsgReceive->taskHandle != NULL) {
+                                    uPortTaskDelete(msgReceiveTask);
+                                }
+                                if (pMsgReceive->taskRunningMutexHandle != NULL) {
+                                    uPortMutexDelete(pMsgReceive->taskRunningMutexHandle);
+                                }
+                                if (pMsgReceive->dataReadySemaphoreHandle != NULL) {
+                                    uPortSemaphoreDelete(pMsgReceive->dataReadySemaphoreHandle);
+                                }
+                                if (pMsgReceive->taskExitQueueHandle != NULL) {
+                                    uPortQueueDelete(pMsgReceive->taskExitQueueHandle);
+                                }
+                                if (pMsgReceive->readerMutexHandle != NULL) {
+                                    uPortMutexDelete(pMsgReceive->readerMutexHandle);
+                                }
+                                uRingBufferGiveReadHandle(&(pInstance->ringBuffer),
+                                                          pMsgReceive->ringBufferReadHandle);
+                                uPortFree(pInstance->pMsgReceive);
+                                pInstance->pMsgReceive = NULL;
+                            }
+                        } else {
+                            // Out of handles already
+                            uPortFree(pInstance->pMsgReceive);
+                            pInstance->pMsgReceive = NULL;
+                        }
+                    }
+                }
+                if (pInstance->pMsgReceive == NULL) {
+                    // Clean up on error
+                    uPortFree(pReader);
+                    pReader = NULL;
+                }
+            }
+            if (pReader != NULL) {
+                // The task etc. must be running, we have a read handle,
+                // now populate the rest of the reader structure
+                // and add it to the front of the list
+                pReader->handle = pInstance->pMsgReceive->nextHandle;
+                pInstance->pMsgReceive->nextHandle++;
+                uGnssPrivateMessageIdToPrivate(pMessageId, &(pReader->privateMessageId));
+                pReader->pCallback = pCallback;
+                pReader->callbackIsView = callbackIsView;
+                pReader->pCallbackParam = pCallbackParam;
+                pReader->pNext = pInstance->pMsgReceive->pReaderList;
+
+                U_PORT_MUTEX_LOCK(pInstance->pMsgReceive->readerMutexHandle);
+
+                pInstance->pMsgReceive->pReaderList = pReader;
+                dispatchAdd(pInstance->pMsgReceive, pReader);
+
+                U_PORT_MUTEX_UNLOCK(pInstance->pMsgReceive->readerMutexHandle);
+
+                // Return the handle
+                errorCodeOrHandle = pReader->handle;
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK(gUGnssPrivateMutex);
+    }
+
+    return errorCodeOrHandle;
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS: MISC
  * -------------------------------------------------------------- */
@@ -477,127 +926,18 @@ int32_t uGnssMsgReceiveStart(uDeviceHandle_t gnssHandle,
                              uGnssMsgReceiveCallback_t pCallback,
                              void *pCallbackParam)
 {
-    int32_t errorCodeOrHandle = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
-    uGnssPrivateInstance_t *pInstance;
-    uGnssPrivateMsgReceive_t *pMsgReceive;
-    uGnssPrivateMsgReader_t *pReader;
-    const char *pTaskName = "gnssMsgRx";
-
-    if (gUGnssPrivateMutex != NULL) {
-
-        U_PORT_MUTEX_LOCK(gUGnssPrivateMutex);
-
-        errorCodeOrHandle = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
-        pInstance = pUGnssPrivateGetInstance(gnssHandle);
-        if ((pInstance != NULL) && (pMessageId != NULL) && (pCallback != NULL)) {
-            errorCodeOrHandle = (int32_t) U_ERROR_COMMON_NO_MEMORY;
-            pReader = (uGnssPrivateMsgReader_t *) pUPortMalloc(sizeof(uGnssPrivateMsgReader_t));
-            if (pReader != NULL) {
-                memset(pReader, 0, sizeof(*pReader));
-                // If the message receive task is not running
-                // at the moment, start it
-                if (pInstance->pMsgReceive == NULL) {
-                    pInstance->pMsgReceive = (uGnssPrivateMsgReceive_t *) pUPortMalloc(sizeof(
-                                                                                           uGnssPrivateMsgReceive_t));
-                    if (pInstance->pMsgReceive != NULL) {
-                        pMsgReceive = pInstance->pMsgReceive;
-                        memset(pMsgReceive, 0, sizeof(*pMsgReceive));
-                        // Take a "master" read handle
-                        pMsgReceive->ringBufferReadHandle = uRingBufferTakeReadHandle(&(pInstance->ringBuffer));
-                        if (pMsgReceive->ringBufferReadHandle >= 0) {
-                            // Allocate a temporary buffer that we can use to pull data
-                            // from the streaming source into the ring-buffer from our
-                            // asynchronous task
-                            pMsgReceive->pTemporaryBuffer = (char *) pUPortMalloc(U_GNSS_MSG_TEMPORARY_BUFFER_LENGTH_BYTES);
-                            if (pMsgReceive->pTemporaryBuffer != NULL) {
-                                // Create the mutex that controls access to the linked-list of readers
-                                errorCodeOrHandle = uPortMutexCreate(&(pMsgReceive->readerMutexHandle));
-                                if (errorCodeOrHandle == 0) {
-                                    // Create the queue that allows us to get the task to exit
-                                    errorCodeOrHandle = uPortQueueCreate(U_GNSS_MSG_RECEIVE_TASK_QUEUE_LENGTH,
-                                                                         U_GNSS_MSG_RECEIVE_TASK_QUEUE_ITEM_SIZE_BYTES,
-                                                                         &(pMsgReceive->taskExitQueueHandle));
-                                    if (errorCodeOrHandle == 0) {
-                                        // Create the mutex for task running status
-                                        errorCodeOrHandle = uPortMutexCreate(&(pMsgReceive->taskRunningMutexHandle));
-                                        if (errorCodeOrHandle == 0) {
-                                            //... and then the task
-                                            errorCodeOrHandle = uPortTaskCreate(msgReceiveTask,
-                                                                                pTaskName,
-                                                                                U_GNSS_MSG_RECEIVE_TASK_STACK_SIZE_BYTES,
-                                                                                pInstance, U_GNSS_MSG_RECEIVE_TASK_PRIORITY,
-                                                                                &(pMsgReceive->taskHandle));
-                                            if (errorCodeOrHandle == 0) {
-                                                // Wait for the task to lock the mutex,
-                                                // which shows it is running
-                                                while (uPortMutexTryLock(pMsgReceive->taskRunningMutexHandle, 0) == 0) {
-                                                    uPortMutexUnlock(pMsgReceive->taskRunningMutexHandle);
-                                                    uPortTaskBlock(U_CFG_OS_YIELD_MS);
-                                                }
-                                            }
-                                        }
-                                    }
-                                }
-                            }
-                            if (errorCodeOrHandle != 0) {
-                                // Tidy up if we couldn't get OS resources
-                                if (pMsgReceive->taskHandle != NULL) {
-                                    uPortTaskDelete(msgReceiveTask);
-                                }
-                                if (pMsgReceive->taskRunningMutexHandle != NULL) {
-                                    uPortMutexDelete(pMsgReceive->taskRunningMutexHandle);
-                                }
-                                if (pMsgReceive->taskExitQueueHandle != NULL) {
-                                    uPortQueueDelete(pMsgReceive->taskExitQueueHandle);
-                                }
-                                if (pMsgReceive->readerMutexHandle != NULL) {
-                                    uPortMutexDelete(pMsgReceive->readerMutexHandle);
-                                }
-                                uPortFree(pInstance->pTemporaryBuffer);
-                                uRingBufferGiveReadHandle(&(pInstance->ringBuffer),
-                                                          pMsgReceive->ringBufferReadHandle);
-                                uPortFree(pInstance->pMsgReceive);
-                                pInstance->pMsgReceive = NULL;
-                            }
-                        } else {
-                            // Out of handles already
-                            uPortFree(pInstance->pMsgReceive);
-                            pInstance->pMsgReceive = NULL;
-                        }
-                    }
-                }
-                if (pInstance->pMsgReceive == NULL) {
-                    // Clean up on error
-                    uPortFree(pReader);
-                    pReader = NULL;
-                }
-            }
-            if (pReader != NULL) {
-                // The task etc. must be running, we have a read handle,
-                // now populate the rest of the reader structure
-                // and add it to the front of the list
-                pReader->handle = pInstance->pMsgReceive->nextHandle;
-                pInstance->pMsgReceive->nextHandle++;
-                uGnssPrivateMessageIdToPrivate(pMessageId, &(pReader->privateMessageId));
-                pReader->pCallback = (void *) pCallback;
-                pReader->pCallbackParam = pCallbackParam;
-                pReader->pNext = pInstance->pMsgReceive->pReaderList;
-
-                U_PORT_MUTEX_LOCK(pInstance->pMsgReceive->readerMutexHandle);
-
-                pInstance->pMsgReceive->pReaderList = pReader;
-
-                U_PORT_MUTEX_UNLOCK(pInstance->pMsgReceive->readerMutexHandle);
-
-                // Return the handle
-                errorCodeOrHandle = pReader->handle;
-            }
-        }
-
-        U_PORT_MUTEX_UNLOCK(gUGnssPrivateMutex);
-    }
+    return msgReceiveStart(gnssHandle, pMessageId, (void *) pCallback,
+                           false, pCallbackParam);
+}
 
-    return errorCodeOrHandle;
+// As uGnssMsgReceiveStart() but with a callback that is given a view.
+int32_t uGnssMsgReceiveStartView(uDeviceHandle_t gnssHandle,
+                                 const uGnssMessageId_t *pMessageId,
+                                 uGnssMsgReceiveViewCallback_t pCallback,
+                                 void *pCallbackParam)
+{
+    return msgReceiveStart(gnssHandle, pMessageId, (void *) pCallback,
+                           true, pCallbackParam);
 }
 
 // Read a message from the ring buffer into a user's buffer.
@@ -622,6 +962,88 @@ int32_t uGnssMsgReceiveCallbackExtract(uDeviceHandle_t gnssHandle,
     return msgReceiveCallbackRead(gnssHandle, pBuffer, size, true);
 }
 
+// Keep the current message in the ring buffer until released.
+// This function does NOT lock gUGnssPrivateMutex in order
+// that it can be called from pCallback.
+int32_t uGnssMsgReceiveCallbackPin(uDeviceHandle_t gnssHandle)
+{
+    int32_t errorCodeOrPinHandle = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uGnssPrivateMsgReceive_t *pMsgReceive;
+    uGnssPrivateInstance_t *pInstance;
+
+    pInstance = pUGnssPrivateGetInstance(gnssHandle);
+    if (pInstance != NULL) {
+        errorCodeOrPinHandle = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+        pMsgReceive = pInstance->pMsgReceive;
+        if ((pMsgReceive != NULL) &&
+            uPortTaskIsThis(pMsgReceive->taskHandle)) {
+            // A pin is a read handle that starts where the message
+            // receive task's read handle is, i.e. at the start of
+            // the message, locked so that nothing can overwrite it
+            errorCodeOrPinHandle = uRingBufferDuplicateReadHandle(&(pInstance->ringBuffer),
+                                                                  pMsgReceive->ringBufferReadHandle);
+            if (errorCodeOrPinHandle >= 0) {
+                uRingBufferLockReadHandle(&(pInstance->ringBuffer), errorCodeOrPinHandle);
+            }
+        }
+    }
+
+    return errorCodeOrPinHandle;
+}
+
+// Release a message pinned with uGnssMsgReceiveCallbackPin().
+// From any task other than the message receive task this locks
+// gUGnssPrivateMutex, since pMsgReceive may otherwise be freed
+// under us by uGnssMsgReceiveStop(); the message receive task
+// itself must NOT lock it, since uGnssMsgReceiveStop() holds
+// gUGnssPrivateMutex while it waits for that task to exit, but
+// then pMsgReceive cannot go away while we are using it.
+int32_t uGnssMsgReceivePinRelease(uDeviceHandle_t gnssHandle,
+                                  int32_t pinHandle)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uGnssPrivateInstance_t *pInstance;
+    int32_t asyncReadHandle = -1;
+    bool locked = false;
+
+    if (gUGnssPrivateMutex != NULL) {
+
+        pInstance = pUGnssPrivateGetInstance(gnssHandle);
+        if ((pInstance == NULL) ||
+            !uPortTaskIsThis(pInstance->msgReceiveTaskHandle)) {
+
+            U_PORT_MUTEX_LOCK(gUGnssPrivateMutex);
+
+            locked = true;
+            // Look again, now that nothing can change under us
+            pInstance = pUGnssPrivateGetInstance(gnssHandle);
+        }
+
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if (pInstance != NULL) {
+            if (pInstance->pMsgReceive != NULL) {
+                asyncReadHandle = pInstance->pMsgReceive->ringBufferReadHandle;
+            }
+            // Pins are always locked and are never one of the
+            // read handles we keep for ourselves; the ring buffer
+            // does its own locking against the receive task pinning
+            if ((pinHandle != pInstance->ringBufferReadHandlePrivate) &&
+                (pinHandle != pInstance->ringBufferReadHandleMsgReceive) &&
+                (pinHandle != asyncReadHandle) &&
+                uRingBufferReadHandleIsLocked(&(pInstance->ringBuffer), pinHandle)) {
+                uRingBufferGiveReadHandle(&(pInstance->ringBuffer), pinHandle);
+                errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            }
+        }
+
+        if (locked) {
+            U_PORT_MUTEX_UNLOCK(gUGnssPrivateMutex);
+        }
+    }
+
+    return errorCode;
+}
+
 // Stop monitoring the output of the GNSS chip for a message.
 int32_t uGnssMsgReceiveStop(uDeviceHandle_t gnssHandle, int32_t asyncHandle)
 {
@@ -654,6 +1076,7 @@ int32_t uGnssMsgReceiveStop(uDeviceHandle_t gnssHandle, int32_t asyncHandle)
                         } else {
                             pMsgReceive->pReaderList = pCurrent->pNext;
                         }
+                        dispatchRemove(pMsgReceive, pCurrent);
                         uPortFree(pCurrent);
                         pCurrent = NULL;
                         errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
@@ -771,4 +1194,54 @@ size_t uGnssMsgReceiveStatStreamLoss(uDeviceHandle_t gnssHandle)
     return bytesLost;
 }
 
+// Wake up the message receive task because data is waiting.
+int32_t uGnssMsgReceiveDataReady(uDeviceHandle_t gnssHandle)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uGnssPrivateInstance_t *pInstance;
+
+    if (gUGnssPrivateMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gUGnssPrivateMutex);
+
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        pInstance = pUGnssPrivateGetInstance(gnssHandle);
+        if (pInstance != NULL) {
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            if (pInstance->pMsgReceive != NULL) {
+                uPortSemaphoreGive(pInstance->pMsgReceive->dataReadySemaphoreHandle);
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK(gUGnssPrivateMutex);
+    }
+
+    return errorCode;
+}
+
+// Count of bytes discarded as not being part of any message.
+size_t uGnssMsgReceiveStatDiscard(uDeviceHandle_t gnssHandle)
+{
+    size_t bytesDiscarded = 0;
+    uGnssPrivateInstance_t *pInstance;
+
+    if (gUGnssPrivateMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gUGnssPrivateMutex);
+
+        pInstance = pUGnssPrivateGetInstance(gnssHandle);
+        if ((pInstance != NULL) && (pInstance->pMsgReceive != NULL)) {
+            // All of the read handles parse the same stream, so
+            // adding them up would count the same bytes more than
+            // once: report those of the message receive task
+            bytesDiscarded = uRingBufferStatParseDiscardHandle(&(pInstance->ringBuffer),
+                                                               pInstance->pMsgReceive->ringBufferReadHandle);
+        }
+
+        U_PORT_MUTEX_UNLOCK(gUGnssPrivateMutex);
+    }
+
+    return bytesDiscarded;
+}
+
 // End of file
@@ -44,13 +44,15 @@
 #include "u_port_os.h"  // Required by u_gnss_private.h
 #include "u_port_debug.h"
 
-#include "u_time.h"
-
 #include "u_ubx_protocol.h"
 
 #include "u_gnss_module_type.h"
 #include "u_gnss_type.h"
 #include "u_gnss_private.h"
+#include "u_gnss_cfg_val_key.h"
+#include "u_gnss_cfg.h"         // U_GNSS_CFG_VAL_LAYER_RAM
+#include "u_gnss_msg.h"         // uGnssMsgReceiveStartView()
+#include "u_gnss_dec.h"
 #include "u_gnss_pos.h"
 
 /* ----------------------------------------------------------------
@@ -113,6 +115,84 @@ typedef struct {
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
 
+// Convert a decoded UBX-NAV-PVT message into position, returning
+// zero if there is a fix else U_ERROR_COMMON_TIMEOUT.
+static int32_t posDecode(const uGnssDecUbxNavPvt_t *pNavPvt,
+                         int32_t *pLatitudeX1e7, int32_t *pLongitudeX1e7,
+                         int32_t *pAltitudeMillimetres,
+                         int32_t *pRadiusMillimetres,
+                         int32_t *pSpeedMillimetresPerSecond,
+                         int32_t *pSvs, int64_t *pTimeUtc, bool printIt)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_TIMEOUT;
+    int32_t y;
+    int64_t t;
+
+    // Time and date may be valid even without a fix; we don't
+    // indicate success based on this but we report it anyway
+    // if it is valid
+    t = uGnssDecUbxNavPvtGetTimeUtc(pNavPvt);
+    if (printIt && (t >= 0)) {
+        uPortLog("U_GNSS_POS: UTC time = %d.\n", (int32_t) t);
+    }
+    if (pTimeUtc != NULL) {
+        *pTimeUtc = t;
+    }
+    if (pNavPvt->flags & 0x01) {
+        if (printIt) {
+            uPortLog("U_GNSS_POS: %dD fix achieved.\n", pNavPvt->fixType);
+        }
+        y = (int32_t) pNavPvt->numSV;
+        if (printIt) {
+            uPortLog("U_GNSS_POS: satellite(s) = %d.\n", y);
+        }
+        if (pSvs != NULL) {
+            *pSvs = y;
+        }
+        y = pNavPvt->lon;
+        if (printIt) {
+            uPortLog("U_GNSS_POS: longitude = %d (degrees * 10^7).\n", y);
+        }
+        if (pLongitudeX1e7 != NULL) {
+            *pLongitudeX1e7 = y;
+        }
+        y = pNavPvt->lat;
+        if (printIt) {
+            uPortLog("U_GNSS_POS: latitude = %d (degrees * 10^7).\n", y);
+        }
+        if (pLatitudeX1e7 != NULL) {
+            *pLatitudeX1e7 = y;
+        }
+        y = INT_MIN;
+        if (pNavPvt->fixType == 0x03) {
+            y = pNavPvt->hMSL;
+            if (printIt) {
+                uPortLog("U_GNSS_POS: altitude = %d (mm).\n", y);
+            }
+        }
+        if (pAltitudeMillimetres != NULL) {
+            *pAltitudeMillimetres = y;
+        }
+        y = (int32_t) pNavPvt->hAcc;
+        if (printIt) {
+            uPortLog("U_GNSS_POS: radius = %d (mm).\n", y);
+        }
+        if (pRadiusMillimetres != NULL) {
+            *pRadiusMillimetres = y;
+        }
+        y = pNavPvt->gSpeed;
+        if (printIt) {
+            uPortLog("U_GNSS_POS: speed = %d (mm/s).\n", y);
+        }
+        if (pSpeedMillimetresPerSecond != NULL) {
+            *pSpeedMillimetresPerSecond = y;
+        }
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+    }
+
+    return errorCode;
+}
+
 // Establish position.
 static int32_t posGet(uGnssPrivateInstance_t *pInstance,
                       int32_t *pLatitudeX1e7, int32_t *pLongitudeX1e7,
@@ -121,103 +201,25 @@ static int32_t posGet(uGnssPrivateInstance_t *pInstance,
                       int32_t *pSpeedMillimetresPerSecond,
                       int32_t *pSvs, int64_t *pTimeUtc, bool printIt)
 {
-    int32_t errorCode = (int32_t) U_ERROR_COMMON_TIMEOUT;
+    int32_t errorCode;
     // Enough room for the body of the UBX-NAV-PVT message
-    char message[92] = {0};
-    int32_t months;
-    int32_t year;
+    char message[U_GNSS_DEC_UBX_NAV_PVT_BODY_LENGTH_BYTES] = {0};
+    uGnssMsgView_t body = {0};
+    uGnssDecUbxNavPvt_t navPvt;
     int32_t y;
-    int64_t t = -1;
 
     y = uGnssPrivateSendReceiveUbxMessage(pInstance,
                                           0x01, 0x07, NULL, 0,
                                           message, sizeof(message));
     if (y == sizeof(message)) {
         // Got the correct message body length, process it
-        if ((message[11] & 0x03) == 0x03) {
-            // Time and date are valid; we don't indicate
-            // success based on this but we report it anyway
-            // if it is valid
-            t = 0;
-            // Year is 1999-2099, so need to adjust to get year since 1970
-            year = ((int32_t) uUbxProtocolUint16Decode(message + 4) - 1999) + 29;
-            // Month (1 to 12), so take away 1 to make it zero-based
-            months = message[6] - 1;
-            months += year * 12;
-            // Work out the number of seconds due to the year/month count
-            t += uTimeMonthsToSecondsUtc(months);
-            // Day (1 to 31)
-            t += ((int32_t) message[7] - 1) * 3600 * 24;
-            // Hour (0 to 23)
-            t += ((int32_t) message[8]) * 3600;
-            // Minute (0 to 59)
-            t += ((int32_t) message[9]) * 60;
-            // Second (0 to 60)
-            t += message[10];
-            if (printIt) {
-                uPortLog("U_GNSS_POS: UTC time = %d.\n", (int32_t) t);
-            }
-        }
-        if (pTimeUtc != NULL) {
-            *pTimeUtc = t;
-        }
-        // From here onwards Lint complains about accesses
-        // into message[] and it doesn't seem to be possible
-        // to suppress those warnings with -esym(690, message)
-        // or even -e(690), hence do it the blunt way
-        //lint -save -e690
-        if (message[21] & 0x01) {
-            if (printIt) {
-                uPortLog("U_GNSS_POS: %dD fix achieved.\n", message[20]);
-            }
-            y = (int32_t) message[23];
-            if (printIt) {
-                uPortLog("U_GNSS_POS: satellite(s) = %d.\n", y);
-            }
-            if (pSvs != NULL) {
-                *pSvs = y;
-            }
-            y = (int32_t) uUbxProtocolUint32Decode(message + 24);
-            if (printIt) {
-                uPortLog("U_GNSS_POS: longitude = %d (degrees * 10^7).\n", y);
-            }
-            if (pLongitudeX1e7 != NULL) {
-                *pLongitudeX1e7 = y;
-            }
-            y = (int32_t) uUbxProtocolUint32Decode(message + 28);
-            if (printIt) {
-                uPortLog("U_GNSS_POS: latitude = %d (degrees * 10^7).\n", y);
-            }
-            if (pLatitudeX1e7 != NULL) {
-                *pLatitudeX1e7 = y;
-            }
-            y = INT_MIN;
-            if (message[20] == 0x03) {
-                y = (int32_t) uUbxProtocolUint32Decode(message + 36);
-                if (printIt) {
-                    uPortLog("U_GNSS_POS: altitude = %d (mm).\n", y);
-                }
-            }
-            if (pAltitudeMillimetres != NULL) {
-                *pAltitudeMillimetres = y;
-            }
-            y = (int32_t) uUbxProtocolUint32Decode(message + 40);
-            if (printIt) {
-                uPortLog("U_GNSS_POS: radius = %d (mm).\n", y);
-            }
-            if (pRadiusMillimetres != NULL) {
-                *pRadiusMillimetres = y;
-            }
-            y = (int32_t) uUbxProtocolUint32Decode(message + 60);
-            if (printIt) {
-                uPortLog("U_GNSS_POS: speed = %d (mm/s).\n", y);
-            }
-            if (pSpeedMillimetresPerSecond != NULL) {
-                *pSpeedMillimetresPerSecond = y;
-            }
-            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
-            //lint -restore
-        }
+        body.pData1 = message;
+        body.size1 = sizeof(message);
+        uGnssDecUbxNavPvt(&body, &navPvt);
+        errorCode = posDecode(&navPvt, pLatitudeX1e7, pLongitudeX1e7,
+                              pAltitudeMillimetres, pRadiusMillimetres,
+                              pSpeedMillimetresPerSecond, pSvs, pTimeUtc,
+                              printIt);
     } else {
         errorCode = y;
         if (errorCode >= 0) {
@@ -279,6 +281,139 @@ static void posGetTask(void *pParameter)
     uPortTaskDelete(NULL);
 }
 
+// Switch periodic output of UBX-NAV-PVT on the port we are connected
+// to on or off and, if measurementPeriodMs is greater than zero, set
+// the measurement period, which is the period of UBX-NAV-PVT.  As
+// for uGnssCfgValSet(), each message is sent with
+// uGnssPrivateSendUbxMessage(), which waits for the Ack, so a NACK
+// or no response at all is returned as an error.
+static int32_t posStreamedConfigure(uGnssPrivateInstance_t *pInstance,
+                                    bool onNotOff,
+                                    int32_t measurementPeriodMs)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+    // Enough room for the body of a UBX-CFG-VALSET message with
+    // a four byte header, a one byte value and a two byte value;
+    // also big enough for UBX-CFG-RATE and UBX-CFG-MSG
+    char message[4 + (4 + 1) + (4 + 2)] = {0};
+    size_t messageSizeBytes = 4;
+    uint32_t keyId;
+    uint16_t value;
+
+    if (U_GNSS_PRIVATE_HAS(pInstance->pModule, U_GNSS_PRIVATE_FEATURE_CFGVALXXX)) {
+        errorCode = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+        if (pInstance->portNumber < U_GNSS_PORT_MAX_NUM) {
+            // The 4-byte UBX-CFG-VALSET message header is version,
+            // layer and two reserved bytes
+            message[1] = U_GNSS_CFG_VAL_LAYER_RAM;
+            // The item IDs for the NAV-PVT output rate on each
+            // port are in the same order as the port numbers
+            keyId = uUbxProtocolUint32Encode(U_GNSS_CFG_VAL_KEY_ID_MSGOUT_UBX_NAV_PVT_I2C_U1 +
+                                             pInstance->portNumber);
+            memcpy(message + messageSizeBytes, &keyId, sizeof(keyId));
+            messageSizeBytes += sizeof(keyId);
+            message[messageSizeBytes] = (char) onNotOff;
+            messageSizeBytes++;
+            if (measurementPeriodMs > 0) {
+                keyId = uUbxProtocolUint32Encode(U_GNSS_CFG_VAL_KEY_ID_RATE_MEAS_U2);
+                memcpy(message + messageSizeBytes, &keyId, sizeof(keyId));
+                messageSizeBytes += sizeof(keyId);
+                value = uUbxProtocolUint16Encode((uint16_t) measurementPeriodMs);
+                memcpy(message + messageSizeBytes, &value, sizeof(value));
+                messageSizeBytes += sizeof(value);
+            }
+            errorCode = uGnssPrivateSendUbxMessage(pInstance, 0x06, 0x8a,
+                                                   message, messageSizeBytes);
+        }
+    } else {
+        if (measurementPeriodMs > 0) {
+            // Read-modify-write UBX-CFG-RATE, six bytes of body,
+            // the first two of which are the measurement rate
+            errorCode = uGnssPrivateSendReceiveUbxMessage(pInstance, 0x06, 0x08,
+                                                          NULL, 0, message, 6);
+            if (errorCode == 6) {
+                value = uUbxProtocolUint16Encode((uint16_t) measurementPeriodMs);
+                memcpy(message, &value, sizeof(value));
+                errorCode = uGnssPrivateSendUbxMessage(pInstance, 0x06, 0x08,
+                                                       message, 6);
+            } else if (errorCode >= 0) {
+                errorCode = (int32_t) U_ERROR_COMMON_DEVICE_ERROR;
+            }
+        }
+        if (errorCode == 0) {
+            // UBX-CFG-MSG with a three byte body sets the rate of
+            // the given message class/ID on the port we are using
+            message[0] = 0x01;
+            message[1] = 0x07;
+            message[2] = (char) onNotOff;
+            errorCode = uGnssPrivateSendUbxMessage(pInstance, 0x06, 0x01,
+                                                   message, 3);
+        }
+    }
+
+    return errorCode;
+}
+
+// Message receive callback for streamed UBX-NAV-PVT messages: decode
+// the message into the latest position and call the user's callback,
+// if there is one.  This is run in the message receive task.
+static void posStreamedCallback(uDeviceHandle_t gnssHandle,
+                                const uGnssMessageId_t *pMessageId,
+                                int32_t errorCodeOrLength,
+                                const uGnssMsgView_t *pView,
+                                void *pCallbackParam)
+{
+    uGnssPrivateInstance_t *pInstance = (uGnssPrivateInstance_t *) pCallbackParam;
+    uGnssPrivatePosStreamed_t *pPosStreamed;
+    uGnssPrivatePosStreamed_t latest = {.latitudeX1e7 = INT_MIN,
+                                        .longitudeX1e7 = INT_MIN,
+                                        .altitudeMillimetres = INT_MIN,
+                                        .radiusMillimetres = -1,
+                                        .speedMillimetresPerSecond = INT_MIN,
+                                        .svs = -1,
+                                        .timeUtc = -1
+                                       };
+    uGnssMsgView_t body;
+    uGnssDecUbxNavPvt_t navPvt;
+
+    (void) pMessageId;
+
+    // Decode straight out of the ring buffer, no need to copy
+    if ((errorCodeOrLength > 0) &&
+        (uGnssDecUbxBody(pView, &body) == U_GNSS_DEC_UBX_ID_NAV_PVT) &&
+        (uGnssDecUbxNavPvt(&body, &navPvt) == 0)) {
+        latest.errorCode = posDecode(&navPvt,
+                                     &latest.latitudeX1e7, &latest.longitudeX1e7,
+                                     &latest.altitudeMillimetres,
+                                     &latest.radiusMillimetres,
+                                     &latest.speedMillimetresPerSecond,
+                                     &latest.svs, &latest.timeUtc, false);
+
+        U_PORT_MUTEX_LOCK(pInstance->posStreamedMutex);
+
+        pPosStreamed = pInstance->pPosStreamed;
+        if (pPosStreamed != NULL) {
+            latest.asyncHandle = pPosStreamed->asyncHandle;
+            latest.pCallback = pPosStreamed->pCallback;
+            *pPosStreamed = latest;
+        }
+
+        U_PORT_MUTEX_UNLOCK(pInstance->posStreamedMutex);
+
+        if (latest.pCallback != NULL) {
+            ((void (*) (uDeviceHandle_t, int32_t, int32_t, int32_t,
+                        int32_t, int32_t, int32_t, int32_t,
+                        int64_t)) latest.pCallback)(gnssHandle, latest.errorCode,
+                                                    latest.latitudeX1e7,
+                                                    latest.longitudeX1e7,
+                                                    latest.altitudeMillimetres,
+                                                    latest.radiusMillimetres,
+                                                    latest.speedMillimetresPerSecond,
+                                                    latest.svs, latest.timeUtc);
+        }
+    }
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS: WORKAROUND FOR LINKER ISSUE
  * -------------------------------------------------------------- */
@@ -474,6 +609,223 @@ void uGnssPosGetStop(uDeviceHandle_t gnssHandle)
     }
 }
 
+// Start streamed position.
+int32_t uGnssPosGetStreamedStart(uDeviceHandle_t gnssHandle,
+                                 int32_t measurementPeriodMs,
+                                 void (*pCallback) (uDeviceHandle_t gnssHandle,
+                                                    int32_t errorCode,
+                                                    int32_t latitudeX1e7,
+                                                    int32_t longitudeX1e7,
+                                                    int32_t altitudeMillimetres,
+                                                    int32_t radiusMillimetres,
+                                                    int32_t speedMillimetresPerSecond,
+                                                    int32_t svs,
+                                                    int64_t timeUtc))
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uGnssPrivateInstance_t *pInstance;
+    uGnssPrivatePosStreamed_t *pPosStreamed = NULL;
+    uGnssMessageId_t messageId;
+
+    if (gUGnssPrivateMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gUGnssPrivateMutex);
+
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        pInstance = pUGnssPrivateGetInstance(gnssHandle);
+        if ((pInstance != NULL) && (measurementPeriodMs <= UINT16_MAX)) {
+            errorCode = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+            // Message receive only works on a streamed transport
+            if (pInstance->transportType != U_GNSS_TRANSPORT_AT) {
+                errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+                if (pInstance->pPosStreamed == NULL) {
+                    pPosStreamed = (uGnssPrivatePosStreamed_t *) pUPortMalloc(sizeof(*pPosStreamed));
+                    if (pPosStreamed != NULL) {
+                        memset(pPosStreamed, 0, sizeof(*pPosStreamed));
+                        pPosStreamed->asyncHandle = -1;
+                        pPosStreamed->pCallback = (void *) pCallback;
+                        pPosStreamed->errorCode = (int32_t) U_ERROR_COMMON_TIMEOUT;
+                        pPosStreamed->latitudeX1e7 = INT_MIN;
+                        pPosStreamed->longitudeX1e7 = INT_MIN;
+                        pPosStreamed->altitudeMillimetres = INT_MIN;
+                        pPosStreamed->radiusMillimetres = -1;
+                        pPosStreamed->speedMillimetresPerSecond = INT_MIN;
+                        pPosStreamed->svs = -1;
+                        pPosStreamed->timeUtc = -1;
+                        errorCode = posStreamedConfigure(pInstance, true,
+                                                         measurementPeriodMs);
+                        if (errorCode == 0) {
+                            U_PORT_MUTEX_LOCK(pInstance->posStreamedMutex);
+                            pInstance->pPosStreamed = pPosStreamed;
+                            U_PORT_MUTEX_UNLOCK(pInstance->posStreamedMutex);
+                        } else {
+                            uPortFree(pPosStreamed);
+                            pPosStreamed = NULL;
+                        }
+                    }
+                }
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK(gUGnssPrivateMutex);
+
+        if (pPosStreamed != NULL) {
+            // Now hook in a message receiver for UBX-NAV-PVT; this
+            // has to be done with gUGnssPrivateMutex unlocked
+            messageId.type = U_GNSS_PROTOCOL_UBX;
+            messageId.id.ubx = 0x0107;
+            errorCode = uGnssMsgReceiveStartView(gnssHandle, &messageId,
+                                                 posStreamedCallback,
+                                                 (void *) pInstance);
+            if (errorCode >= 0) {
+
+                U_PORT_MUTEX_LOCK(gUGnssPrivateMutex);
+
+                // Check that the instance, and our streamed
+                // position, are still there before touching them
+                pInstance = pUGnssPrivateGetInstance(gnssHandle);
+                if ((pInstance != NULL) && (pInstance->pPosStreamed == pPosStreamed)) {
+                    U_PORT_MUTEX_LOCK(pInstance->posStreamedMutex);
+                    pPosStreamed->asyncHandle = errorCode;
+                    U_PORT_MUTEX_UNLOCK(pInstance->posStreamedMutex);
+                }
+
+                U_PORT_MUTEX_UNLOCK(gUGnssPrivateMutex);
+
+                errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            } else {
+                // Return the error from the message receiver
+                // rather than any from tidying up
+                uGnssPosGetStreamedStop(gnssHandle);
+            }
+        }
+    }
+
+    return errorCode;
+}
+
+// Get the latest streamed position.
+int32_t uGnssPosGetStreamed(uDeviceHandle_t gnssHandle,
+                            int32_t *pLatitudeX1e7, int32_t *pLongitudeX1e7,
+                            int32_t *pAltitudeMillimetres,
+                            int32_t *pRadiusMillimetres,
+                            int32_t *pSpeedMillimetresPerSecond,
+                            int32_t *pSvs, int64_t *pTimeUtc)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uGnssPrivateInstance_t *pInstance;
+    uGnssPrivatePosStreamed_t *pPosStreamed;
+
+    if (gUGnssPrivateInstanceListMutex != NULL) {
+
+        // Deliberately NOT locking gUGnssPrivateMutex, which may
+        // be held for a long time while we talk to the GNSS chip:
+        // gUGnssPrivateInstanceListMutex, held only until we have
+        // posStreamedMutex, stops the instance being removed
+        // underneath us
+        U_PORT_MUTEX_LOCK(gUGnssPrivateInstanceListMutex);
+
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        pInstance = pUGnssPrivateGetInstance(gnssHandle);
+        if (pInstance != NULL) {
+            U_PORT_MUTEX_LOCK(pInstance->posStreamedMutex);
+        }
+
+        U_PORT_MUTEX_UNLOCK(gUGnssPrivateInstanceListMutex);
+
+        if (pInstance != NULL) {
+            errorCode = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+
+            pPosStreamed = pInstance->pPosStreamed;
+            if (pPosStreamed != NULL) {
+                errorCode = pPosStreamed->errorCode;
+                // As for uGnssPosGet(), time may be valid without a fix
+                if (pTimeUtc != NULL) {
+                    *pTimeUtc = pPosStreamed->timeUtc;
+                }
+                if (errorCode == 0) {
+                    if (pLatitudeX1e7 != NULL) {
+                        *pLatitudeX1e7 = pPosStreamed->latitudeX1e7;
+                    }
+                    if (pLongitudeX1e7 != NULL) {
+                        *pLongitudeX1e7 = pPosStreamed->longitudeX1e7;
+                    }
+                    if (pAltitudeMillimetres != NULL) {
+                        *pAltitudeMillimetres = pPosStreamed->altitudeMillimetres;
+                    }
+                    if (pRadiusMillimetres != NULL) {
+                        *pRadiusMillimetres = pPosStreamed->radiusMillimetres;
+                    }
+                    if (pSpeedMillimetresPerSecond != NULL) {
+                        *pSpeedMillimetresPerSecond = pPosStreamed->speedMillimetresPerSecond;
+                    }
+                    if (pSvs != NULL) {
+                        *pSvs = pPosStreamed->svs;
+                    }
+                }
+            }
+
+            U_PORT_MUTEX_UNLOCK(pInstance->posStreamedMutex);
+        }
+    }
+
+    return errorCode;
+}
+
+// Stop streamed position.
+int32_t uGnssPosGetStreamedStop(uDeviceHandle_t gnssHandle)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uGnssPrivateInstance_t *pInstance;
+    uGnssPrivatePosStreamed_t *pPosStreamed = NULL;
+    int32_t asyncHandle = -1;
+
+    if (gUGnssPrivateMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gUGnssPrivateMutex);
+
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        pInstance = pUGnssPrivateGetInstance(gnssHandle);
+        if (pInstance != NULL) {
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            if (pInstance->pPosStreamed != NULL) {
+                pPosStreamed = pInstance->pPosStreamed;
+                asyncHandle = pPosStreamed->asyncHandle;
+                // Switch UBX-NAV-PVT output off again; if this
+                // fails we still tear down but report the error
+                errorCode = posStreamedConfigure(pInstance, false, -1);
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK(gUGnssPrivateMutex);
+
+        if (pPosStreamed != NULL) {
+            // Once the message receiver is stopped our
+            // callback cannot be running; this has to be
+            // done with gUGnssPrivateMutex unlocked
+            if (asyncHandle >= 0) {
+                uGnssMsgReceiveStop(gnssHandle, asyncHandle);
+            }
+
+            U_PORT_MUTEX_LOCK(gUGnssPrivateMutex);
+
+            // If the instance has been removed in the meantime
+            // then the streamed position will have gone with it
+            pInstance = pUGnssPrivateGetInstance(gnssHandle);
+            if ((pInstance != NULL) && (pInstance->pPosStreamed == pPosStreamed)) {
+                U_PORT_MUTEX_LOCK(pInstance->posStreamedMutex);
+                pInstance->pPosStreamed = NULL;
+                U_PORT_MUTEX_UNLOCK(pInstance->posStreamedMutex);
+                uPortFree(pPosStreamed);
+            }
+
+            U_PORT_MUTEX_UNLOCK(gUGnssPrivateMutex);
+        }
+    }
+
+    return errorCode;
+}
+
 // Get RRLP information from the GNSS chip.
 int32_t uGnssPosGetRrlp(uDeviceHandle_t gnssHandle, char *pBuffer,
                         size_t sizeBytes, int32_t svsThreshold,
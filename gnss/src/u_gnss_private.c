@@ -126,6 +126,40 @@ typedef struct {
                           CRC calculation will fail. */
 } uGnssPrivateUbxReceiveMessage_t;
 
+/** The state of parseUbx(), kept by the ring buffer between calls.
+ */
+typedef struct {
+    int32_t step;    /**< where we are: 0 header 0xB5, 1 header 0x62,
+                          2 class, 3 ID, 4 length LSB, 5 length MSB,
+                          6 body, 7 CK_A, 8 CK_B. */
+    uint16_t id;     /**< class in the top byte, ID in the bottom byte. */
+    uint16_t length; /**< the number of body bytes still to come. */
+    uint8_t cka;
+    uint8_t ckb;
+} uGnssPrivateParseStateUbx_t;
+
+/** The state of parseNmea(), kept by the ring buffer between calls.
+ */
+typedef struct {
+    int32_t step;    /**< where we are: 0 '$', 1 talker/sentence,
+                          2 body, 3 checksum high nibble, 4 checksum
+                          low nibble, 5 '\r', 6 '\n'. */
+    int32_t idLength;
+    char crc;
+    char id[U_GNSS_NMEA_MESSAGE_MATCH_LENGTH_CHARACTERS + 1];
+} uGnssPrivateParseStateNmea_t;
+
+/** The state of parseRtcm(), kept by the ring buffer between calls.
+ */
+typedef struct {
+    int32_t step;    /**< where we are: 0 preamble 0xD3, 1 length
+                          MSBs, 2 length LSB, 3 ID MSB, 4 ID LSBs,
+                          5 body, 6, 7 and 8 CRC. */
+    uint32_t crc;
+    uint16_t length; /**< the number of bytes still to come before the CRC. */
+    uint16_t id;
+} uGnssPrivateParseStateRtcm_t;
+
 /* ----------------------------------------------------------------
  * VARIABLES THAT ARE SHARED THROUGHOUT THE GNSS IMPLEMENTATION
  * -------------------------------------------------------------- */
@@ -138,6 +172,12 @@ uGnssPrivateInstance_t *gpUGnssPrivateInstanceList = NULL;
  */
 uPortMutexHandle_t gUGnssPrivateMutex = NULL;
 
+/** Mutex held, only briefly, while an instance is linked into
+ * or unlinked from the list, so that the list may be searched
+ * without waiting for gUGnssPrivateMutex.
+ */
+uPortMutexHandle_t gUGnssPrivateInstanceListMutex = NULL;
+
 /** The characteristics of the modules supported by this driver,
  * compiled into the driver.  Order is important: uGnssModuleType_t
  * is used to index into this array.
@@ -275,6 +315,74 @@ static void printId(uGnssPrivateMessageId_t *pId)
 }
 #endif
 
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS: BUFFER POOL
+ * -------------------------------------------------------------- */
+
+// Get a buffer of at least sizeBytes for sending/receiving a
+// message, from the pool of buffers if possible, else from the
+// heap; if forCaller is true the buffer is going to be handed
+// to the caller of this API, who will free it with uPortFree(),
+// and so it must come from the heap.  Release the buffer with
+// bufferRelease().
+// IMPORTANT: pInstance->transportMutex must be locked.
+static char *pBufferGet(uGnssPrivateInstance_t *pInstance,
+                        size_t sizeBytes, bool forCaller)
+{
+    uGnssPrivateBufferPool_t *pPool = &(pInstance->bufferPool);
+    char *pBuffer = NULL;
+    size_t blockLengthBytes;
+
+    if ((pPool->pBlocks == NULL) && (U_GNSS_BUFFER_POOL_NUM_BLOCKS > 0)) {
+        // First use: allocate the blocks, just the once
+        blockLengthBytes = U_GNSS_BUFFER_POOL_BLOCK_LENGTH_BYTES;
+        if ((pInstance->transportType == U_GNSS_TRANSPORT_AT) &&
+            (blockLengthBytes < U_GNSS_AT_BUFFER_LENGTH_BYTES + 1)) {
+            // Must be able to hold a hex-encoded message plus terminator
+            blockLengthBytes = U_GNSS_AT_BUFFER_LENGTH_BYTES + 1;
+        }
+        pPool->pBlocks = (char *) pUPortMalloc(blockLengthBytes * U_GNSS_BUFFER_POOL_NUM_BLOCKS);
+        if (pPool->pBlocks != NULL) {
+            pPool->blockLengthBytes = blockLengthBytes;
+        }
+    }
+
+    if (!forCaller && (sizeBytes <= pPool->blockLengthBytes)) {
+        for (size_t x = 0; (x < U_GNSS_BUFFER_POOL_NUM_BLOCKS) && (pBuffer == NULL); x++) {
+            if ((pPool->inUseBitmap & (1UL << x)) == 0) {
+                pPool->inUseBitmap |= 1UL << x;
+                pBuffer = pPool->pBlocks + (x * pPool->blockLengthBytes);
+                pPool->poolCount++;
+            }
+        }
+    }
+    if (pBuffer == NULL) {
+        // Too big, all in use or it's for the caller: use the heap
+        pBuffer = (char *) pUPortMalloc(sizeBytes);
+        if (pBuffer != NULL) {
+            pPool->heapCount++;
+        }
+    }
+
+    return pBuffer;
+}
+
+// Release a buffer obtained with pBufferGet(); may be NULL.
+// IMPORTANT: pInstance->transportMutex must be locked.
+static void bufferRelease(uGnssPrivateInstance_t *pInstance, char *pBuffer)
+{
+    uGnssPrivateBufferPool_t *pPool = &(pInstance->bufferPool);
+    size_t x;
+
+    if ((pPool->pBlocks != NULL) && (pBuffer >= pPool->pBlocks) &&
+        (pBuffer < pPool->pBlocks + (pPool->blockLengthBytes * U_GNSS_BUFFER_POOL_NUM_BLOCKS))) {
+        x = (size_t) (pBuffer - pPool->pBlocks) / pPool->blockLengthBytes;
+        pPool->inUseBitmap &= ~(1UL << x);
+    } else {
+        uPortFree(pBuffer);
+    }
+}
+
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS: STREAMING TRANSPORT ONLY
  * -------------------------------------------------------------- */
@@ -408,6 +516,7 @@ static int32_t sendMessageStream(uGnssPrivateInstance_t *pInstance,
 // expected response, wild cards permitted.  On success it will
 // be set to the message ID received and the UBX message body length
 // will be returned.
+// IMPORTANT: pInstance->transportMutex must be locked.
 static int32_t receiveUbxMessageStream(uGnssPrivateInstance_t *pInstance,
                                        uGnssPrivateUbxReceiveMessage_t *pResponse,
                                        int32_t timeoutMs, bool printIt)
@@ -415,6 +524,7 @@ static int32_t receiveUbxMessageStream(uGnssPrivateInstance_t *pInstance,
     int32_t errorCodeOrLength = 0;            // Deliberate choice to return 0 if pResponse
     uGnssPrivateMessageId_t privateMessageId; // indicates that no response is required
     char *pBuffer = NULL;
+    size_t bufferSize = 0;
 
     if ((pInstance != NULL) && (pResponse != NULL) && (pResponse->ppBody != NULL)) {
         // Convert uGnssPrivateUbxReceiveMessage_t into uGnssPrivateMessageId_t
@@ -426,13 +536,26 @@ static int32_t receiveUbxMessageStream(uGnssPrivateInstance_t *pInstance,
         if (pResponse->id >= 0) {
             privateMessageId.id.ubx = (privateMessageId.id.ubx & 0xff00) | pResponse->id;
         }
+        if ((*(pResponse->ppBody) != NULL) &&
+            (pResponse->bodySize + U_UBX_PROTOCOL_OVERHEAD_LENGTH_BYTES <=
+             pInstance->bufferPool.blockLengthBytes)) {
+            // We know how much of the message we need and it
+            // will fit into a block from the pool; anything
+            // longer will be truncated, which doesn't matter
+            // since the body would be truncated to bodySize anyway
+            bufferSize = pInstance->bufferPool.blockLengthBytes;
+            pBuffer = pBufferGet(pInstance, bufferSize, false);
+        }
         // Now wait for the message, allowing a buffer to be allocated by
-        // the message receive function
+        // the message receive function if we don't have one
         errorCodeOrLength = uGnssPrivateReceiveStreamMessage(pInstance,
                                                              &privateMessageId,
                                                              pInstance->ringBufferReadHandlePrivate,
-                                                             &pBuffer, 0,
+                                                             &pBuffer, bufferSize,
                                                              timeoutMs, NULL);
+        if ((bufferSize == 0) && (pBuffer != NULL)) {
+            pInstance->bufferPool.heapCount++;
+        }
         if (errorCodeOrLength >= U_UBX_PROTOCOL_OVERHEAD_LENGTH_BYTES) {
             // Convert uGnssPrivateMessageId_t into uGnssPrivateUbxReceiveMessage_t
             pResponse->cls = privateMessageId.id.ubx >> 8;
@@ -467,7 +590,7 @@ static int32_t receiveUbxMessageStream(uGnssPrivateInstance_t *pInstance,
         }
 
         // Free memory
-        uPortFree(pBuffer);
+        bufferRelease(pInstance, pBuffer);
     }
 
     return errorCodeOrLength;
@@ -481,7 +604,8 @@ static int32_t receiveUbxMessageStream(uGnssPrivateInstance_t *pInstance,
 // the response.  No matching of message ID or class for
 // the response is performed as it is not possible to get other
 // responses when using an AT command.
-static int32_t sendReceiveUbxMessageAt(const uAtClientHandle_t atHandle,
+// IMPORTANT: pInstance->transportMutex must be locked.
+static int32_t sendReceiveUbxMessageAt(uGnssPrivateInstance_t *pInstance,
                                        const char *pSend,
                                        size_t sendLengthBytes,
                                        uGnssPrivateUbxReceiveMessage_t *pResponse,
@@ -489,6 +613,8 @@ static int32_t sendReceiveUbxMessageAt(const uAtClientHandle_t atHandle,
                                        bool printIt)
 {
     int32_t errorCodeOrLength = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+    //lint -e{1773} Suppress attempt to cast away const: I'm not!
+    const uAtClientHandle_t atHandle = (const uAtClientHandle_t) pInstance->transportHandle.pAt;
     int32_t x;
     size_t bytesToSend;
     char *pBuffer;
@@ -509,7 +635,11 @@ static int32_t sendReceiveUbxMessageAt(const uAtClientHandle_t atHandle,
     if (x < U_GNSS_AT_BUFFER_LENGTH_BYTES + 1) {
         x = U_GNSS_AT_BUFFER_LENGTH_BYTES + 1;
     }
-    pBuffer = (char *) pUPortMalloc(x);
+    // If the caller has not provided a buffer for the body of
+    // the response then this buffer is passed back to them,
+    // in which case it has to come from the heap
+    pBuffer = pBufferGet(pInstance, x, (pResponse->ppBody != NULL) &&
+                         (*(pResponse->ppBody) == NULL));
     if (pBuffer != NULL) {
         errorCodeOrLength = (int32_t) U_GNSS_ERROR_TRANSPORT;
         bytesToSend = uBinToHex(pSend, sendLengthBytes, pBuffer);
@@ -600,7 +730,7 @@ static int32_t sendReceiveUbxMessageAt(const uAtClientHandle_t atHandle,
         uAtClientDebugSet(atHandle, atDebugPrintOn);
 
         if (!bufferReuse) {
-            uPortFree(pBuffer);
+            bufferRelease(pInstance, pBuffer);
         }
     }
 
@@ -631,17 +761,18 @@ static int32_t sendReceiveUbxMessage(uGnssPrivateInstance_t *pInstance,
         ((pResponse->bodySize == 0) || (pResponse->ppBody != NULL))) {
         errorCodeOrResponseLength = (int32_t) U_ERROR_COMMON_NO_MEMORY;
         privateStreamTypeOrError = uGnssPrivateGetStreamType(pInstance->transportType);
-        // Allocate a buffer big enough to encode the outgoing message
-        pBuffer = (char *) pUPortMalloc(messageBodyLengthBytes + U_UBX_PROTOCOL_OVERHEAD_LENGTH_BYTES);
+
+        U_PORT_MUTEX_LOCK(pInstance->transportMutex);
+
+        // Get a buffer big enough to encode the outgoing message
+        pBuffer = pBufferGet(pInstance, messageBodyLengthBytes + U_UBX_PROTOCOL_OVERHEAD_LENGTH_BYTES,
+                             false);
         if (pBuffer != NULL) {
             errorCodeOrResponseLength = (int32_t) U_GNSS_ERROR_TRANSPORT;
             bytesToSend = uUbxProtocolEncode(messageClass, messageId,
                                              pMessageBody, messageBodyLengthBytes,
                                              pBuffer);
             if (bytesToSend > 0) {
-
-                U_PORT_MUTEX_LOCK(pInstance->transportMutex);
-
                 if ((pResponse != NULL) && (pResponse->ppBody != NULL) &&
                     (privateStreamTypeOrError >= 0)) {
                     // For a streaming transport, if we're going to wait for
@@ -668,9 +799,7 @@ static int32_t sendReceiveUbxMessage(uGnssPrivateInstance_t *pInstance,
                     }
                 } else {
                     // Not a stream, we're on AT
-                    //lint -e{1773} Suppress attempt to cast away const: I'm not!
-                    errorCodeOrResponseLength = sendReceiveUbxMessageAt((const uAtClientHandle_t)
-                                                                        pInstance->transportHandle.pAt,
+                    errorCodeOrResponseLength = sendReceiveUbxMessageAt(pInstance,
                                                                         pBuffer, bytesToSend,
                                                                         pResponse, pInstance->timeoutMs,
                                                                         pInstance->printUbxMessages);
@@ -678,13 +807,13 @@ static int32_t sendReceiveUbxMessage(uGnssPrivateInstance_t *pInstance,
 
                 // Make sure the read handle is always unlocked afterwards
                 uRingBufferUnlockReadHandle(&(pInstance->ringBuffer), pInstance->ringBufferReadHandlePrivate);
-
-                U_PORT_MUTEX_UNLOCK(pInstance->transportMutex);
             }
 
             // Free memory
-            uPortFree(pBuffer);
+            bufferRelease(pInstance, pBuffer);
         }
+
+        U_PORT_MUTEX_UNLOCK(pInstance->transportMutex);
     }
 
     return errorCodeOrResponseLength;
@@ -702,69 +831,82 @@ static int32_t sendReceiveUbxMessage(uGnssPrivateInstance_t *pInstance,
  */
 static int32_t parseUbx(uParseHandle_t parseHandle, void *pUserParam)
 {
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_TIMEOUT;
     uGnssPrivateMessageId_t *pMsgId = (uGnssPrivateMessageId_t *) pUserParam;
+    uGnssPrivateParseStateUbx_t *pState = (uGnssPrivateParseStateUbx_t *) pURingBufferParserStateUnprotected(
+                                              parseHandle);
     uint8_t by = 0;
-    if (!uRingBufferGetByteUnprotected(parseHandle, &by)) {
-        return U_ERROR_COMMON_TIMEOUT;
-    }
-    if (0xB5 != by) {
-        return U_ERROR_COMMON_NOT_FOUND;    // = µ, 0xB5
-    }
-    if (!uRingBufferGetByteUnprotected(parseHandle, &by)) {
-        return U_ERROR_COMMON_TIMEOUT;
-    }
-    if (0x62 != by) {
-        return U_ERROR_COMMON_NOT_FOUND;    // = b
-    }
-    if (4 > uRingBufferBytesAvailableUnprotected(parseHandle)) {
-        return U_ERROR_COMMON_TIMEOUT;
-    }
-    uint8_t ckb = 0;
-    uint8_t cka = 0;
-    uint8_t cls, id;
-    uRingBufferGetByteUnprotected(parseHandle, &cls); // cls
-    cka += cls;
-    ckb += cka;
-    uRingBufferGetByteUnprotected(parseHandle, &id); // id
-    cka += id;
-    ckb += cka;
-    pMsgId->id.ubx = (cls << 8) + id;
-    uRingBufferGetByteUnprotected(parseHandle, &by); // len low
-    cka += by;
-    ckb += cka;
-    uint16_t l = by;
-    uRingBufferGetByteUnprotected(parseHandle, &by); // len high
-    cka += by;
-    ckb += cka;
-    l += (((uint16_t) by) << 8);
-    if (l > uRingBufferBytesAvailableUnprotected(parseHandle)) {
-        return U_ERROR_COMMON_TIMEOUT;
-    }
-    while (l --) {
-        uRingBufferGetByteUnprotected(parseHandle, &by);
-        cka += by;
-        ckb += cka;
-    }
-    cka = cka & 0xFF;
-    ckb = ckb & 0xFF;
-    if (!uRingBufferGetByteUnprotected(parseHandle, &by)) {
-        return U_ERROR_COMMON_TIMEOUT;
-    }
-    if (by != cka) {
-        return U_ERROR_COMMON_NOT_FOUND;
-    }
-    if (!uRingBufferGetByteUnprotected(parseHandle, &by)) {
-        return U_ERROR_COMMON_TIMEOUT;
-    }
-    if (by != ckb) {
-        return U_ERROR_COMMON_NOT_FOUND;
+
+    U_ASSERT(sizeof(*pState) <= U_RING_BUFFER_PARSER_STATE_LENGTH_BYTES);
+
+    while ((errorCode == (int32_t) U_ERROR_COMMON_TIMEOUT) &&
+           uRingBufferGetByteUnprotected(parseHandle, &by)) {
+        if ((pState->step >= 2) && (pState->step <= 6)) {
+            // Class, ID, length and body are all in the checksum
+            pState->cka += by;
+            pState->ckb += pState->cka;
+        }
+        switch (pState->step) {
+            case 0:
+                if (by != 0xB5) { // = µ, 0xB5
+                    errorCode = (int32_t) U_ERROR_COMMON_NOT_FOUND;
+                }
+                pState->step++;
+                break;
+            case 1:
+                if (by != 0x62) { // = b
+                    errorCode = (int32_t) U_ERROR_COMMON_NOT_FOUND;
+                }
+                pState->step++;
+                break;
+            case 2: // cls
+                pState->id = ((uint16_t) by) << 8;
+                pState->step++;
+                break;
+            case 3: // id
+                pState->id |= by;
+                pState->step++;
+                break;
+            case 4: // len low
+                pState->length = by;
+                pState->step++;
+                break;
+            case 5: // len high
+                pState->length += ((uint16_t) by) << 8;
+                pState->step = (pState->length > 0) ? 6 : 7;
+                break;
+            case 6: // body
+                pState->length--;
+                if (pState->length == 0) {
+                    pState->step++;
+                }
+                break;
+            case 7:
+                if (by != pState->cka) {
+                    errorCode = (int32_t) U_ERROR_COMMON_NOT_FOUND;
+                }
+                pState->step++;
+                break;
+            default:
+                if (by != pState->ckb) {
+                    errorCode = (int32_t) U_ERROR_COMMON_NOT_FOUND;
+                } else {
+                    errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+                }
+                break;
+        }
     }
-    // We can only claim this as a UBX-format message if
-    // there was nothing that needed discarding first.
-    if (uRingBufferBytesDiscardUnprotected(parseHandle) == 0) {
-        pMsgId->type = U_GNSS_PROTOCOL_UBX;
+
+    if (errorCode == (int32_t) U_ERROR_COMMON_SUCCESS) {
+        pMsgId->id.ubx = pState->id;
+        // We can only claim this as a UBX-format message if
+        // there was nothing that needed discarding first.
+        if (uRingBufferBytesDiscardUnprotected(parseHandle) == 0) {
+            pMsgId->type = U_GNSS_PROTOCOL_UBX;
+        }
     }
-    return U_ERROR_COMMON_SUCCESS;
+
+    return errorCode;
 }
 
 /** NMEA Parser function.
@@ -775,70 +917,84 @@ static int32_t parseUbx(uParseHandle_t parseHandle, void *pUserParam)
  */
 static int32_t parseNmea(uParseHandle_t parseHandle, void *pUserParam)
 {
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_TIMEOUT;
     uGnssPrivateMessageId_t *pMsgId = (uGnssPrivateMessageId_t *) pUserParam;
-    char ch = 0;
+    uGnssPrivateParseStateNmea_t *pState = (uGnssPrivateParseStateNmea_t *) pURingBufferParserStateUnprotected(
+                                               parseHandle);
     const char *hex = "0123456789ABCDEF";
-    if (!uRingBufferGetByteUnprotected(parseHandle, &ch)) {
-        return U_ERROR_COMMON_TIMEOUT;
-    }
-    if ('$' != ch) {
-        return U_ERROR_COMMON_NOT_FOUND;
-    }
-    char crc = 0;
-    int i = 0;
-    while (uRingBufferGetByteUnprotected(parseHandle, &ch)) {
-        crc ^= ch;
-        if (',' == ch) {
-            break;
-        }
-        if (i >= U_GNSS_NMEA_MESSAGE_MATCH_LENGTH_CHARACTERS) {
-            return U_ERROR_COMMON_NOT_FOUND;
-        }
-        if (('0' > ch) || ('Z' < ch) || (('9' < ch) && ('A' > ch))) {
-            return U_ERROR_COMMON_NOT_FOUND;    // A-Z, 0-9
+    char ch = 0;
+
+    U_ASSERT(sizeof(*pState) <= U_RING_BUFFER_PARSER_STATE_LENGTH_BYTES);
+
+    while ((errorCode == (int32_t) U_ERROR_COMMON_TIMEOUT) &&
+           uRingBufferGetByteUnprotected(parseHandle, &ch)) {
+        switch (pState->step) {
+            case 0:
+                if (ch != '$') {
+                    errorCode = (int32_t) U_ERROR_COMMON_NOT_FOUND;
+                }
+                pState->step++;
+                break;
+            case 1: // talker/sentence
+                pState->crc ^= ch;
+                if (ch == ',') {
+                    pState->step++;
+                } else if ((pState->idLength >= U_GNSS_NMEA_MESSAGE_MATCH_LENGTH_CHARACTERS) ||
+                           ('0' > ch) || ('Z' < ch) || (('9' < ch) && ('A' > ch))) {
+                    errorCode = (int32_t) U_ERROR_COMMON_NOT_FOUND;    // A-Z, 0-9
+                } else {
+                    pState->id[pState->idLength] = ch;
+                    pState->idLength++;
+                }
+                break;
+            case 2: // body
+                if ((' ' > ch) || ('~' < ch)) {
+                    errorCode = (int32_t) U_ERROR_COMMON_NOT_FOUND;    // not in printable range 32 - 126
+                } else if (ch == '*') {
+                    pState->step++;
+                } else {
+                    pState->crc ^= ch;
+                }
+                break;
+            case 3:
+                if (hex[(pState->crc >> 4) & 0xF] != ch) {
+                    errorCode = (int32_t) U_ERROR_COMMON_NOT_FOUND;
+                }
+                pState->step++;
+                break;
+            case 4:
+                if (hex[pState->crc & 0xF] != ch) {
+                    errorCode = (int32_t) U_ERROR_COMMON_NOT_FOUND;
+                }
+                pState->step++;
+                break;
+            case 5:
+                if (ch != '\r') {
+                    errorCode = (int32_t) U_ERROR_COMMON_NOT_FOUND;
+                }
+                pState->step++;
+                break;
+            default:
+                if (ch != '\n') {
+                    errorCode = (int32_t) U_ERROR_COMMON_NOT_FOUND;
+                } else {
+                    errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+                }
+                break;
         }
-        pMsgId->id.nmea[i++] = ch;
     }
-    pMsgId->id.nmea[i] = '\0';
-    while (uRingBufferGetByteUnprotected(parseHandle, &ch)) {
-        if ((' ' > ch) || ('~' < ch)) {
-            return U_ERROR_COMMON_NOT_FOUND;    // not in printable range 32 - 126
-        }
-        if ('*' == ch) {
-            break;    // *
+
+    if (errorCode == (int32_t) U_ERROR_COMMON_SUCCESS) {
+        // The state was zeroed at the start so id[] is terminated
+        memcpy(pMsgId->id.nmea, pState->id, sizeof(pMsgId->id.nmea));
+        // We can only claim this as an NMEA-format message if
+        // there was nothing that needed discarding first.
+        if (uRingBufferBytesDiscardUnprotected(parseHandle) == 0) {
+            pMsgId->type = U_GNSS_PROTOCOL_NMEA;
         }
-        crc ^= ch;
-    }
-    if (!uRingBufferGetByteUnprotected(parseHandle, &ch)) {
-        return U_ERROR_COMMON_TIMEOUT;
-    }
-    if (hex[(crc >> 4) & 0xF] != ch) {
-        return U_ERROR_COMMON_NOT_FOUND;
-    }
-    if (!uRingBufferGetByteUnprotected(parseHandle, &ch)) {
-        return U_ERROR_COMMON_TIMEOUT;
-    }
-    if (hex[crc & 0xF] != ch) {
-        return U_ERROR_COMMON_NOT_FOUND;
-    }
-    if (!uRingBufferGetByteUnprotected(parseHandle, &ch)) {
-        return U_ERROR_COMMON_TIMEOUT;
     }
-    if ('\r' != ch) {
-        return U_ERROR_COMMON_NOT_FOUND;
-    }
-    if (!uRingBufferGetByteUnprotected(parseHandle, &ch)) {
-        return U_ERROR_COMMON_TIMEOUT;
-    }
-    if ('\n' != ch) {
-        return U_ERROR_COMMON_NOT_FOUND;
-    }
-    // We can only claim this as an NMEA-format message if
-    // there was nothing that needed discarding first.
-    if (uRingBufferBytesDiscardUnprotected(parseHandle) == 0) {
-        pMsgId->type = U_GNSS_PROTOCOL_NMEA;
-    }
-    return U_ERROR_COMMON_SUCCESS;
+
+    return errorCode;
 }
 
 /** RTCM Parser function.
@@ -849,17 +1005,13 @@ static int32_t parseNmea(uParseHandle_t parseHandle, void *pUserParam)
  */
 static int32_t parseRtcm(uParseHandle_t parseHandle, void *pUserParam)
 {
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_TIMEOUT;
     uGnssPrivateMessageId_t *pMsgId = (uGnssPrivateMessageId_t *) pUserParam;
-    uint8_t by;
-    uint32_t crc = 0;
-    if (!uRingBufferGetByteUnprotected(parseHandle, &by)) {
-        return U_ERROR_COMMON_TIMEOUT;
-    }
-    if (0xD3 != by) {
-        return U_ERROR_COMMON_NOT_FOUND;
-    }
+    uGnssPrivateParseStateRtcm_t *pState = (uGnssPrivateParseStateRtcm_t *) pURingBufferParserStateUnprotected(
+                                               parseHandle);
+    uint8_t by = 0;
     // CRC24Q check
-    const uint32_t _crc24qTable[] = {
+    static const uint32_t _crc24qTable[] = {
         /* 00 */ 0x000000, 0x864cfb, 0x8ad50d, 0x0c99f6, 0x93e6e1, 0x15aa1a, 0x1933ec, 0x9f7f17,
         /* 08 */ 0xa18139, 0x27cdc2, 0x2b5434, 0xad18cf, 0x3267d8, 0xb42b23, 0xb8b2d5, 0x3efe2e,
         /* 10 */ 0xc54e89, 0x430272, 0x4f9b84, 0xc9d77f, 0x56a868, 0xd0e493, 0xdc7d65, 0x5a319e,
@@ -894,55 +1046,76 @@ static int32_t parseRtcm(uParseHandle_t parseHandle, void *pUserParam)
         /* f8 */ 0x42fa2f, 0xc4b6d4, 0xc82f22, 0x4e63d9, 0xd11cce, 0x575035, 0x5bc9c3, 0xdd8538
     };
 #define RTCM_CRC(crc, by) (crc << 8) ^ _crc24qTable[(by ^ (crc >> 16)) & 0xff]
-    // CRC is over the entire message, 0xD3 included
-    crc = RTCM_CRC(crc, by);
-    if (!uRingBufferGetByteUnprotected(parseHandle, &by)) {
-        return U_ERROR_COMMON_TIMEOUT;
-    }
-    if ((0xFC & by) != 0) {
-        return U_ERROR_COMMON_NOT_FOUND;
-    }
-    uint16_t l = (by & 0x3) << 8;
-    crc = RTCM_CRC(crc, by);
-    if (!uRingBufferGetByteUnprotected(parseHandle, &by)) {
-        return U_ERROR_COMMON_TIMEOUT;
-    }
-    l += by;
-    // Length includes the two-byte message ID and the message
-    // body, i.e. up to the start of the 3-byte CRC, i.e.
-    // the total message length - 6.
-    if (l > uRingBufferBytesAvailableUnprotected(parseHandle) + 3) {
-        return U_ERROR_COMMON_TIMEOUT;
-    }
-    crc = RTCM_CRC(crc, by);
-    uint8_t idLo, idHi;
-    if (!uRingBufferGetByteUnprotected(parseHandle, &idLo)) {
-        return U_ERROR_COMMON_TIMEOUT;
-    }
-    l--;
-    crc = RTCM_CRC(crc, idLo);
-    if (!uRingBufferGetByteUnprotected(parseHandle, &idHi)) {
-        return U_ERROR_COMMON_TIMEOUT;
-    }
-    l--;
-    crc = RTCM_CRC(crc, idHi);
-    pMsgId->id.rtcm = (idHi >> 4) + (idLo << 4);
-    while (l--) {
-        uRingBufferGetByteUnprotected(parseHandle, &by);
-        crc = RTCM_CRC(crc, by);
-    }
-    // Compare CRC
-    for (int32_t x = 2; (x >= 0) && uRingBufferGetByteUnprotected(parseHandle, &by); x--) {
-        if (by != (uint8_t) (crc >> (8 * x))) {
-            return U_ERROR_COMMON_TIMEOUT;
+
+    U_ASSERT(sizeof(*pState) <= U_RING_BUFFER_PARSER_STATE_LENGTH_BYTES);
+
+    while ((errorCode == (int32_t) U_ERROR_COMMON_TIMEOUT) &&
+           uRingBufferGetByteUnprotected(parseHandle, &by)) {
+        if (pState->step <= 5) {
+            // CRC is over the entire message, 0xD3 included
+            pState->crc = RTCM_CRC(pState->crc, by);
+        }
+        switch (pState->step) {
+            case 0:
+                if (by != 0xD3) {
+                    errorCode = (int32_t) U_ERROR_COMMON_NOT_FOUND;
+                }
+                pState->step++;
+                break;
+            case 1:
+                if ((0xFC & by) != 0) {
+                    errorCode = (int32_t) U_ERROR_COMMON_NOT_FOUND;
+                }
+                pState->length = ((uint16_t) (by & 0x3)) << 8;
+                pState->step++;
+                break;
+            case 2:
+                // Length includes the two-byte message ID and the
+                // message body, i.e. up to the start of the 3-byte CRC
+                pState->length += by;
+                if (pState->length < 2) {
+                    errorCode = (int32_t) U_ERROR_COMMON_NOT_FOUND;
+                }
+                pState->step++;
+                break;
+            case 3:
+                pState->id = ((uint16_t) by) << 4;
+                pState->length--;
+                pState->step++;
+                break;
+            case 4:
+                pState->id += by >> 4;
+                pState->length--;
+                pState->step = (pState->length > 0) ? 5 : 6;
+                break;
+            case 5: // body
+                pState->length--;
+                if (pState->length == 0) {
+                    pState->step++;
+                }
+                break;
+            default:
+                // Compare CRC, most significant byte first
+                if (by != (uint8_t) (pState->crc >> (8 * (8 - pState->step)))) {
+                    errorCode = (int32_t) U_ERROR_COMMON_NOT_FOUND;
+                } else if (pState->step == 8) {
+                    errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+                }
+                pState->step++;
+                break;
         }
     }
-    // We can only claim this as an RTCM-format message if
-    // there was nothing that needed discarding first.
-    if (uRingBufferBytesDiscardUnprotected(parseHandle) == 0) {
-        pMsgId->type = U_GNSS_PROTOCOL_RTCM;
+
+    if (errorCode == (int32_t) U_ERROR_COMMON_SUCCESS) {
+        pMsgId->id.rtcm = pState->id;
+        // We can only claim this as an RTCM-format message if
+        // there was nothing that needed discarding first.
+        if (uRingBufferBytesDiscardUnprotected(parseHandle) == 0) {
+            pMsgId->type = U_GNSS_PROTOCOL_RTCM;
+        }
     }
-    return U_ERROR_COMMON_SUCCESS;
+
+    return errorCode;
 }
 
 /* ----------------------------------------------------------------
@@ -1379,8 +1552,15 @@ void uGnssPrivateStopMsgReceive(uGnssPrivateInstance_t *pInstance)
     if ((pInstance != NULL) && (pInstance->pMsgReceive != NULL)) {
         pMsgReceive = pInstance->pMsgReceive;
 
-        // Sending the task anything will cause it to exit
+        // Stop UART events from waking the task, if they were
+        if (pMsgReceive->uartEventHandle >= 0) {
+            uPortUartEventCallbackRemove(pMsgReceive->uartEventHandle);
+        }
+
+        // Sending the task anything will cause it to exit, waking
+        // it up so that it notices quickly
         uPortQueueSend(pMsgReceive->taskExitQueueHandle, queueItem);
+        uPortSemaphoreGive(pMsgReceive->dataReadySemaphoreHandle);
         U_PORT_MUTEX_LOCK(pMsgReceive->taskRunningMutexHandle);
         U_PORT_MUTEX_UNLOCK(pMsgReceive->taskRunningMutexHandle);
         // Wait for the task to actually exit: the STM32F4 platform
@@ -1400,20 +1580,19 @@ void uGnssPrivateStopMsgReceive(uGnssPrivateInstance_t *pInstance)
         uPortMutexDelete(pMsgReceive->taskRunningMutexHandle);
         uPortQueueDelete(pMsgReceive->taskExitQueueHandle);
         uPortMutexDelete(pMsgReceive->readerMutexHandle);
+        uPortSemaphoreDelete(pMsgReceive->dataReadySemaphoreHandle);
 
         // Pause here to allow the deletions
         // to actually occur in the idle thread,
         // required by some RTOSs (e.g. FreeRTOS)
         uPortTaskBlock(U_CFG_OS_YIELD_MS);
 
-        // Free the temporary buffer
-        uPortFree(pMsgReceive->pTemporaryBuffer);
-
         // Give the ring buffer handle back
         uRingBufferGiveReadHandle(&(pInstance->ringBuffer),
                                   pMsgReceive->ringBufferReadHandle);
 
         // Add it's done
+        pInstance->msgReceiveTaskHandle = NULL;
         uPortFree(pInstance->pMsgReceive);
         pInstance->pMsgReceive = NULL;
     }
@@ -1660,10 +1839,13 @@ int32_t uGnssPrivateStreamDecodeRingBuffer(uRingBuffer_t *pRingBuffer,
                 parseRtcm,
                 NULL
             };
+            // The bytes that the parsers above can start with
+            const char syncList[] = {(char) 0xB5, '$', (char) 0xD3};
             uGnssPrivateMessageId_t msg;
             memset(&msg, 0, sizeof(msg));
             msg.type = U_GNSS_PROTOCOL_UNKNOWN;
-            errorCodeOrLength = uRingBufferParseHandle(pRingBuffer, readHandle, parserList, &msg);
+            errorCodeOrLength = uRingBufferParseHandleSync(pRingBuffer, readHandle, parserList,
+                                                           syncList, sizeof(syncList), &msg);
             if (errorCodeOrLength <= 0) {
                 break;
             } else if (uGnssPrivateMessageIdIsWanted(&msg, pPrivateMessageId)) {
@@ -1731,18 +1913,12 @@ int32_t uGnssPrivateStreamFillRingBuffer(uGnssPrivateInstance_t *pInstance,
     int32_t receiveSize;
     int32_t totalReceiveSize = 0;
     int32_t ringBufferAvailableSize;
-    char *pTemporaryBuffer;
+    int32_t leftToRead;
+    int32_t regionSize;
+    int32_t thisSize;
+    char *pRegion = NULL;
 
     if (pInstance != NULL) {
-        pTemporaryBuffer = pInstance->pTemporaryBuffer;
-        if ((pInstance->pMsgReceive != NULL) &&
-            uPortTaskIsThis(pInstance->pMsgReceive->taskHandle)) {
-            // If we're being called from the message receive task,
-            // which does not lock gUGnssPrivateMutex, we use its
-            // temporary buffer in order to avoid clashes with
-            // the main application task
-            pTemporaryBuffer = pInstance->pMsgReceive->pTemporaryBuffer;
-        }
         errorCodeOrLength = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
         privateStreamTypeOrError = uGnssPrivateGetStreamType(pInstance->transportType);
         streamHandle = uGnssPrivateGetStreamHandle((uGnssPrivateStreamType_t) privateStreamTypeOrError,
@@ -1761,52 +1937,72 @@ int32_t uGnssPrivateStreamFillRingBuffer(uGnssPrivateInstance_t *pInstance,
                     receiveSize = ringBufferAvailableSize;
                 }
                 if (receiveSize > 0) {
-                    // Read into a temporary buffer
                     if (receiveSize > U_GNSS_MSG_TEMPORARY_BUFFER_LENGTH_BYTES) {
                         receiveSize = U_GNSS_MSG_TEMPORARY_BUFFER_LENGTH_BYTES;
                     }
-                    switch (privateStreamTypeOrError) {
-                        case U_GNSS_PRIVATE_STREAM_TYPE_UART:
-                            // For UART we ask for as much data as we can, it will just
-                            // bring in more if more has arrived between the "receive
-                            // size" call above and now
-                            receiveSize = uPortUartRead(streamHandle, pTemporaryBuffer,
-                                                        U_GNSS_MSG_TEMPORARY_BUFFER_LENGTH_BYTES);
-                            break;
-                        case U_GNSS_PRIVATE_STREAM_TYPE_I2C:
-                            // For I2C we need to ask for the amount we know is there since
-                            // the I2C buffer is effectively on the GNSS chip and I2C drivers
-                            // often don't say how much they've read, just giving us back
-                            // the number we asked for on a successful read
-                            receiveSize = uPortI2cControllerSendReceive(streamHandle,
-                                                                        pInstance->i2cAddress,
-                                                                        NULL, 0,
-                                                                        pTemporaryBuffer,
-                                                                        receiveSize);
-                            break;
-                        case U_GNSS_PRIVATE_STREAM_TYPE_SPI:
-                            // For the SPI case, we need to pull the data that was
-                            // received in uGnssPrivateStreamGetReceiveSize() back
-                            // out of the SPI ring buffer and into our temporary buffer
-                            receiveSize = (int32_t) uRingBufferRead(pInstance->pSpiRingBuffer,
-                                                                    pTemporaryBuffer, receiveSize);
-                        default:
+                    // Read straight into the ring buffer; this may take two
+                    // goes if the region we are given wraps.  We use a forced
+                    // take: it is up to this MCU to keep up, we don't want
+                    // to block data from the GNSS chip, after all it has
+                    // no UART flow control lines that we can stop it with.
+                    // If someone else (e.g. the message receive task) is
+                    // already writing to the ring buffer we will be given
+                    // no room, which is fine, they will pick the data up
+                    leftToRead = receiveSize;
+                    receiveSize = 0;
+                    for (size_t x = 0; (x < 2) && (leftToRead > 0); x++) {
+                        regionSize = (int32_t) uRingBufferForceTakeWriteRegion(&(pInstance->ringBuffer),
+                                                                               &pRegion, leftToRead);
+                        if (regionSize == 0) {
+                            if ((x == 0) && (timeoutMs > 0)) {
+                                // Someone else is filling the ring buffer,
+                                // give them a moment
+                                uPortTaskBlock(10);
+                            }
                             break;
-                    }
-                    if (receiveSize >= 0) {
-                        totalReceiveSize += receiveSize;
-                        errorCodeOrLength = totalReceiveSize;
-                        // Now stuff this into the ring buffer; we use a forced
-                        // add: it is up to this MCU to keep up, we don't want
-                        // to block data from the GNSS chip, after all it has
-                        // no UART flow control lines that we can stop it with
-                        if (!uRingBufferForceAdd(&(pInstance->ringBuffer),
-                                                 pTemporaryBuffer, receiveSize)) {
-                            errorCodeOrLength = (int32_t) U_ERROR_COMMON_NO_MEMORY;
                         }
-                    } else {
-                        // Error case
-                        errorCodeOrLength = receiveSize;
+                        switch (privateStreamTypeOrError) {
+                            case U_GNSS_PRIVATE_STREAM_TYPE_UART:
+                                thisSize = uPortUartRead(streamHandle, pRegion, regionSize);
+                                break;
+                            case U_GNSS_PRIVATE_STREAM_TYPE_I2C:
+                                // For I2C we need to ask for the amount we know is there since
+                                // the I2C buffer is effectively on the GNSS chip and I2C drivers
+                                // often don't say how much they've read, just giving us back
+                                // the number we asked for on a successful read
+                                thisSize = uPortI2cControllerSendReceive(streamHandle,
+                                                                         pInstance->i2cAddress,
+                                                                         NULL, 0,
+                                                                         pRegion, regionSize);
+                                break;
+                            case U_GNSS_PRIVATE_STREAM_TYPE_SPI:
+                                // For the SPI case, we need to pull the data that was
+                                // received in uGnssPrivateStreamGetReceiveSize() back
+                                // out of the SPI ring buffer
+                                thisSize = (int32_t) uRingBufferRead(pInstance->pSpiRingBuffer,
+                                                                     pRegion, regionSize);
+                                break;
+                            default:
+                                thisSize = 0;
+                                break;
+                        }
+                        uRingBufferGiveWriteRegion(&(pInstance->ringBuffer),
+                                                   thisSize > 0 ? thisSize : 0);
+                        if (thisSize >= 0) {
+                            receiveSize += thisSize;
+                            totalReceiveSize += thisSize;
+                            errorCodeOrLength = totalReceiveSize;
+                            leftToRead -= thisSize;
+                            if (thisSize < regionSize) {
+                                // Nothing more to be had
+                                leftToRead = 0;
+                            }
+                        } else {
+                            // Error case
+                            errorCodeOrLength = thisSize;
+                            receiveSize = thisSize;
+                            leftToRead = 0;
+                        }
                     }
                 } else if ((ringBufferAvailableSize > 0) && (timeoutMs > 0)) {
                     // Relax while we're waiting for more data to arrive
@@ -1870,23 +2066,22 @@ int32_t uGnssPrivateSendOnlyStreamUbxMessage(uGnssPrivateInstance_t *pInstance,
              (messageBodyLengthBytes > 0))) {
             errorCodeOrSentLength = (int32_t) U_ERROR_COMMON_NO_MEMORY;
 
-            // Allocate a buffer big enough to encode the outgoing message
-            pBuffer = (char *) pUPortMalloc(messageBodyLengthBytes + U_UBX_PROTOCOL_OVERHEAD_LENGTH_BYTES);
+            U_PORT_MUTEX_LOCK(pInstance->transportMutex);
+
+            // Get a buffer big enough to encode the outgoing message
+            pBuffer = pBufferGet(pInstance, messageBodyLengthBytes + U_UBX_PROTOCOL_OVERHEAD_LENGTH_BYTES,
+                                 false);
             if (pBuffer != NULL) {
                 bytesToSend = uUbxProtocolEncode(messageClass, messageId,
                                                  pMessageBody, messageBodyLengthBytes,
                                                  pBuffer);
-
-                U_PORT_MUTEX_LOCK(pInstance->transportMutex);
-
                 errorCodeOrSentLength = sendMessageStream(pInstance, pBuffer, bytesToSend,
                                                           pInstance->printUbxMessages);
-
-                U_PORT_MUTEX_UNLOCK(pInstance->transportMutex);
-
                 // Free memory
-                uPortFree(pBuffer);
+                bufferRelease(pInstance, pBuffer);
             }
+
+            U_PORT_MUTEX_UNLOCK(pInstance->transportMutex);
         }
     }
 
@@ -75,6 +75,41 @@ extern "C" {
 # define U_GNSS_RING_BUFFER_MIN_FILL_TIME_MS 100
 #endif
 
+#ifndef U_GNSS_MSG_RECEIVE_DISPATCH_TABLE_SIZE
+/** The number of buckets in the table used by the message receive
+ * task to find the readers that want a given message; readers are
+ * hashed into it by the message ID they asked for, so there should
+ * be no need to increase this unless there are very many readers.
+ */
+# define U_GNSS_MSG_RECEIVE_DISPATCH_TABLE_SIZE 16
+#endif
+
+#ifndef U_GNSS_BUFFER_POOL_NUM_BLOCKS
+/** The number of blocks in the pool of buffers, per GNSS instance,
+ * used when encoding and sending UBX-format messages and receiving
+ * the responses; a send/receive needs two at once.  Set this to
+ * zero to allocate every buffer from the heap instead.  Cannot be
+ * more than 32.
+ */
+# define U_GNSS_BUFFER_POOL_NUM_BLOCKS 2
+#endif
+
+#if U_GNSS_BUFFER_POOL_NUM_BLOCKS > 32
+# error U_GNSS_BUFFER_POOL_NUM_BLOCKS must be less than or equal to 32 (the size of the in-use mask)
+#endif
+
+#ifndef U_GNSS_BUFFER_POOL_BLOCK_LENGTH_BYTES
+/** The length of each block in the pool of buffers: this should
+ * be big enough for the largest UBX-format message, including
+ * overhead, that the application sends or receives; anything
+ * bigger will be allocated from the heap.  Note that on an AT
+ * transport the block length is increased, if required, to be
+ * big enough to hold a hex-encoded message.
+ */
+# define U_GNSS_BUFFER_POOL_BLOCK_LENGTH_BYTES (U_GNSS_MAX_UBX_PROTOCOL_MESSAGE_BODY_LENGTH_BYTES + \
+                                                U_UBX_PROTOCOL_OVERHEAD_LENGTH_BYTES)
+#endif
+
 /** Determine if the given feature is supported or not
  * by the pointed-to module.
  */
@@ -165,7 +200,14 @@ typedef struct uGnssPrivateMsgReader_t {
     void *pCallback; /**< stored as a void * to avoid having to bring
                           all the types of uGnssTransparentReceiveCallback_t
                           into everything. */
+    bool callbackIsView; /**< true if pCallback is a
+                              uGnssMsgReceiveViewCallback_t. */
     void *pCallbackParam;
+    uint32_t dispatchKey; /**< the key, derived from privateMessageId,
+                               under which this reader is in the
+                               dispatch table. */
+    struct uGnssPrivateMsgReader_t *pNextDispatch; /**< the next reader in the
+                                                        same dispatch table bucket. */
     struct uGnssPrivateMsgReader_t *pNext;
 } uGnssPrivateMsgReader_t;
 
@@ -175,15 +217,52 @@ typedef struct uGnssPrivateMsgReader_t {
 typedef struct {
     int32_t nextHandle;
     uPortTaskHandle_t taskHandle;
-    char *pTemporaryBuffer;
     uPortMutexHandle_t taskRunningMutexHandle;
     uPortQueueHandle_t taskExitQueueHandle;
     uPortMutexHandle_t readerMutexHandle;
+    uPortSemaphoreHandle_t dataReadySemaphoreHandle; /**< given when there may be data to
+                                                          receive, e.g. from a UART event. */
+    int32_t uartEventHandle; /**< the UART on which we set an event callback, -1 if none. */
     int32_t ringBufferReadHandle;
     size_t msgBytesLeftToRead;
     uGnssPrivateMsgReader_t *pReaderList;
+    uGnssPrivateMsgReader_t *pDispatch[U_GNSS_MSG_RECEIVE_DISPATCH_TABLE_SIZE]; /**< the readers
+                                                                                     again, hashed
+                                                                                     on dispatchKey. */
 } uGnssPrivateMsgReceive_t;
 
+/** The latest position received by the streamed position API,
+ * see uGnssPosGetStreamedStart(); the position fields are as for
+ * uGnssPosGet().
+ */
+typedef struct {
+    int32_t asyncHandle; /**< the handle of the UBX-NAV-PVT message receiver. */
+    void *pCallback; /**< the user's callback, stored as a void * in the same
+                          way as for uGnssPrivateMsgReader_t; may be NULL. */
+    int32_t errorCode; /**< zero if the fields below are a valid fix. */
+    int32_t latitudeX1e7;
+    int32_t longitudeX1e7;
+    int32_t altitudeMillimetres;
+    int32_t radiusMillimetres;
+    int32_t speedMillimetresPerSecond;
+    int32_t svs;
+    int64_t timeUtc;
+} uGnssPrivatePosStreamed_t;
+
+/** A pool of buffers, used when sending/receiving UBX-format
+ * messages so as to avoid allocating memory from the heap for
+ * every message; the memory for the blocks is allocated on first
+ * use and kept until the instance is removed.  Protected by the
+ * transportMutex of the instance.
+ */
+typedef struct {
+    char *pBlocks; /**< U_GNSS_BUFFER_POOL_NUM_BLOCKS blocks of blockLengthBytes. */
+    size_t blockLengthBytes; /**< the length of each block. */
+    uint32_t inUseBitmap; /**< bit 0 set if block 0 is in use, etc. */
+    int32_t poolCount; /**< the number of buffers taken from the pool. */
+    int32_t heapCount; /**< the number of buffers that had to come from the heap. */
+} uGnssPrivateBufferPool_t;
+
 /** Definition of a GNSS instance.
  * Note: a pointer to this structure is passed to the asynchronous
  * "get position" function (posGetTask()) which does NOT lock the
@@ -202,7 +281,6 @@ typedef struct uGnssPrivateInstance_t {
     char *pSpiLinearBuffer; /**< the linear buffer that will be used by pSpiRingBuffer. */
     uRingBuffer_t ringBuffer; /**< the ring buffer where we put messages from the GNSS chip. */
     char *pLinearBuffer; /**< the linear buffer that will be used by ringBuffer. */
-    char *pTemporaryBuffer; /**< a temporary buffer, used to get stuff into ringBuffer. */
     int32_t ringBufferReadHandlePrivate; /**< the read handle for this code to use, -1 if there isn't one. */
     int32_t ringBufferReadHandleMsgReceive; /**< the read handle for uGnssUtilTransparentReceive(). */
     uint16_t i2cAddress; /**< the I2C address of the GNSS chip, only relevant if the transport is I2C. */
@@ -216,13 +294,26 @@ typedef struct uGnssPrivateInstance_t {
     uGnssPort_t portNumber; /**< the internal port number of the GNSS device that we are connected on. */
     uPortMutexHandle_t transportMutex; /**< mutex so that we can have an asynchronous
                                             task use the transport. */
+    uGnssPrivateBufferPool_t bufferPool; /**< buffers for sending/receiving UBX messages,
+                                              protected by transportMutex. */
     uPortTaskHandle_t posTask; /**< handle for a task associated with
                                     non-blocking position establishment. */
     uPortMutexHandle_t posMutex; /**< handle for mutex associated with
                                       non-blocking position establishment. */
     volatile uint8_t posTaskFlags; /**< flags to synchronisation the pos task. */
+    uPortMutexHandle_t posStreamedMutex; /**< mutex protecting pPosStreamed, which
+                                              is NOT protected by gUGnssPrivateMutex;
+                                              exists for the life of the instance. */
+    uGnssPrivatePosStreamed_t *pPosStreamed; /**< the streamed position, NULL if
+                                                  uGnssPosGetStreamedStart() is not
+                                                  running. */
     uGnssPrivateMsgReceive_t *pMsgReceive; /**< stuff associated with the asychronous
                                                 message receive utility functions. */
+    uPortTaskHandle_t msgReceiveTaskHandle; /**< a copy of pMsgReceive->taskHandle,
+                                                 NULL if there is no such task, so that
+                                                 the task can be recognised without
+                                                 touching pMsgReceive; protected by
+                                                 gUGnssPrivateMutex. */
     struct uGnssPrivateInstance_t *pNext;
 } uGnssPrivateInstance_t;
 // *INDENT-ON*
@@ -248,6 +339,13 @@ extern uGnssPrivateInstance_t *gpUGnssPrivateInstanceList;
  */
 extern uPortMutexHandle_t gUGnssPrivateMutex;
 
+/** Mutex held, only briefly, while an instance is linked into
+ * or unlinked from the list, so that the list may be searched
+ * without waiting for gUGnssPrivateMutex; if both are to be
+ * locked then gUGnssPrivateMutex must be locked first.
+ */
+extern uPortMutexHandle_t gUGnssPrivateInstanceListMutex;
+
 /* ----------------------------------------------------------------
  * FUNCTIONS: MISC
  * -------------------------------------------------------------- */
@@ -81,6 +81,12 @@
 # define U_GNSS_CFG_TEST_MIN_HEAP_TO_READ_ALL_BYTES (1024 * 16)
 #endif
 
+/** A key ID that the GNSS chip will not recognise, used to check
+ * that a UBX-CFG-VALSET message is rejected: group 0xFF, item 0xFFF,
+ * storage size one bit.
+ */
+#define U_GNSS_CFG_TEST_KEY_ID_INVALID 0x10ff0fff
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -435,6 +441,7 @@ U_PORT_TEST_FUNCTION("[gnssCfg]", "gnssCfgValBasic")
     uint64_t value;
     uint64_t savedValue;
     uGnssCfgVal_t *pCfgValList = NULL;
+    uGnssCfgValSetBatch_t *pCfgValBatch;
     int32_t numValues;
     size_t iterations;
     uGnssTransportType_t transportTypes[U_GNSS_TRANSPORT_MAX_NUM_WITH_UBX];
@@ -539,6 +546,92 @@ U_PORT_TEST_FUNCTION("[gnssCfg]", "gnssCfgValBasic")
                     uPortTaskBlock(10);
                 }
 
+                // Modify every value again and write them back using a batch
+                U_TEST_PRINT_LINE("modifying all the GEOFENCE values again.");
+                modValues(pCfgValList, numValues);
+                U_TEST_PRINT_LINE("writing GEOFENCE values as a batch.");
+                pCfgValBatch = (uGnssCfgValSetBatch_t *) pUPortMalloc(sizeof(*pCfgValBatch));
+                U_PORT_TEST_ASSERT(pCfgValBatch != NULL);
+                U_PORT_TEST_ASSERT(uGnssCfgValSetBatchBegin(gnssHandle, pCfgValBatch,
+                                                            U_GNSS_CFG_VAL_LAYER_RAM) == 0);
+                for (int32_t x = 0; x < numValues; x++) {
+                    U_PORT_TEST_ASSERT(uGnssCfgValSetBatchAdd(pCfgValBatch,
+                                                              (pCfgValList + x)->keyId,
+                                                              (pCfgValList + x)->value) == 0);
+                }
+                // Nothing should have been sent yet
+                U_PORT_TEST_ASSERT(pCfgValBatch->numMessagesSent == 0);
+                U_PORT_TEST_ASSERT(uGnssCfgValSetBatchCommit(pCfgValBatch) == 0);
+                // All in one go
+                U_PORT_TEST_ASSERT(pCfgValBatch->numMessagesSent == 1);
+                U_PORT_TEST_ASSERT(pCfgValBatch->numValuesTotal == numValues);
+                U_PORT_TEST_ASSERT(pCfgValBatch->failedIndex < 0);
+
+                // Write the same values enough times over that two
+                // messages, and hence a transaction, are needed
+                y = U_GNSS_CFG_VAL_MSG_MAX_NUM_VALUES + numValues;
+                U_TEST_PRINT_LINE("writing %d values as a batch in a transaction.", y);
+                U_PORT_TEST_ASSERT(uGnssCfgValSetBatchBegin(gnssHandle, pCfgValBatch,
+                                                            U_GNSS_CFG_VAL_LAYER_RAM) == 0);
+                for (int32_t x = 0; x < y; x++) {
+                    U_PORT_TEST_ASSERT(uGnssCfgValSetBatchAdd(pCfgValBatch,
+                                                              (pCfgValList + (x % numValues))->keyId,
+                                                              (pCfgValList + (x % numValues))->value) == 0);
+                }
+                // The first message should have gone with BEGIN
+                U_PORT_TEST_ASSERT(pCfgValBatch->numMessagesSent == 1);
+                U_PORT_TEST_ASSERT(uGnssCfgValSetBatchCommit(pCfgValBatch) == 0);
+                // ...and the rest with EXECUTE
+                U_PORT_TEST_ASSERT(pCfgValBatch->numMessagesSent == 2);
+                U_PORT_TEST_ASSERT(pCfgValBatch->numValuesTotal == y);
+                U_PORT_TEST_ASSERT(pCfgValBatch->failedIndex < 0);
+
+                // Do that again but put a key that the GNSS chip will
+                // reject at the start of the second message
+                U_TEST_PRINT_LINE("writing %d values as a batch, one of which is invalid.", y);
+                U_PORT_TEST_ASSERT(uGnssCfgValSetBatchBegin(gnssHandle, pCfgValBatch,
+                                                            U_GNSS_CFG_VAL_LAYER_RAM) == 0);
+                for (int32_t x = 0; x < y; x++) {
+                    if (x == U_GNSS_CFG_VAL_MSG_MAX_NUM_VALUES) {
+                        U_PORT_TEST_ASSERT(uGnssCfgValSetBatchAdd(pCfgValBatch,
+                                                                  U_GNSS_CFG_TEST_KEY_ID_INVALID,
+                                                                  1) == 0);
+                    } else {
+                        U_PORT_TEST_ASSERT(uGnssCfgValSetBatchAdd(pCfgValBatch,
+                                                                  (pCfgValList + (x % numValues))->keyId,
+                                                                  (pCfgValList + (x % numValues))->value) == 0);
+                    }
+                }
+                U_PORT_TEST_ASSERT(uGnssCfgValSetBatchCommit(pCfgValBatch) < 0);
+                U_TEST_PRINT_LINE("%d message(s) sent, failed index %d, failed count %d.",
+                                  pCfgValBatch->numMessagesSent, pCfgValBatch->failedIndex,
+                                  pCfgValBatch->failedCount);
+                U_PORT_TEST_ASSERT(pCfgValBatch->numMessagesSent == 1);
+                U_PORT_TEST_ASSERT(pCfgValBatch->failedIndex == U_GNSS_CFG_VAL_MSG_MAX_NUM_VALUES);
+                U_PORT_TEST_ASSERT(pCfgValBatch->failedCount == numValues);
+                // Once failed, the batch should stay failed
+                U_PORT_TEST_ASSERT(uGnssCfgValSetBatchAdd(pCfgValBatch,
+                                                          pCfgValList->keyId,
+                                                          pCfgValList->value) < 0);
+                uPortFree(pCfgValBatch);
+                // The transaction should have been cancelled in the GNSS
+                // chip, so a transactionless set should just work
+                U_PORT_TEST_ASSERT(uGnssCfgValSet(gnssHandle, pCfgValList->keyId,
+                                                  pCfgValList->value,
+                                                  U_GNSS_CFG_VAL_TRANSACTION_NONE,
+                                                  U_GNSS_CFG_VAL_LAYER_RAM) == 0);
+
+                U_TEST_PRINT_LINE("reading back the batch-modified GEOFENCE values.");
+                for (int32_t x = 0; x < numValues; x++) {
+                    value = 0;
+                    U_PORT_TEST_ASSERT(uGnssCfgValGet(gnssHandle, gKeyIdGeofence[x],
+                                                      &value, storageSizeBytes(gKeyIdGeofence[x]),
+                                                      U_GNSS_CFG_VAL_LAYER_RAM) == 0);
+                    U_PORT_TEST_ASSERT(valueMatches(gKeyIdGeofence[x], value,  pCfgValList, numValues));
+                    // Don't overload logging
+                    uPortTaskBlock(10);
+                }
+
                 // Now modify one value, non-list style, using the helper macro
                 value = 0xFFFFFFFF;
                 U_TEST_PRINT_LINE("modifying one GEOFENCE value 0x%08x to 0x%08x.",
@@ -0,0 +1,296 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Only #includes of u_* and the C standard library are allowed here,
+ * no platform stuff and no OS stuff.  Anything required from
+ * the platform/OS must be brought in through u_port* to maintain
+ * portability.
+ */
+
+/** @file
+ * @brief Tests for the UBX message decoders of the GNSS API: these
+ * do not require a GNSS chip and should pass on all platforms.
+ * IMPORTANT: see notes in u_cfg_test_platform_specific.h for the
+ * naming rules that must be followed when using the U_PORT_TEST_FUNCTION()
+ * macro.
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+#include "string.h"    // memset(), memcpy(), strcmp()
+
+#include "u_cfg_sw.h"
+#include "u_cfg_os_platform_specific.h"
+#include "u_cfg_app_platform_specific.h"
+#include "u_cfg_test_platform_specific.h"
+
+#include "u_error_common.h"
+
+#include "u_port.h"
+#include "u_port_heap.h"
+#include "u_port_debug.h"
+#include "u_port_os.h"
+
+#include "u_ubx_protocol.h"
+
+#include "u_device.h"
+
+#include "u_gnss_type.h"
+#include "u_gnss_msg.h"
+#include "u_gnss_dec.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** The string to put at the start of all prints from this test.
+ */
+#define U_TEST_PREFIX "U_GNSS_DEC_TEST: "
+
+/** Print a whole line, with terminator, prefixed for this test file.
+ */
+#define U_TEST_PRINT_LINE(format, ...) uPortLog(U_TEST_PREFIX format "\n", ##__VA_ARGS__)
+
+/** Room for the biggest message we test with, including overhead.
+ */
+#define U_GNSS_DEC_TEST_MESSAGE_MAX_LENGTH_BYTES (100 + U_UBX_PROTOCOL_OVERHEAD_LENGTH_BYTES)
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/** A buffer to build messages in.
+ */
+static char gMessage[U_GNSS_DEC_TEST_MESSAGE_MAX_LENGTH_BYTES];
+
+/** A buffer to split messages into, mimicking the wrap of a ring buffer.
+ */
+static char gWrapped[U_GNSS_DEC_TEST_MESSAGE_MAX_LENGTH_BYTES];
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Write a little-endian value into a message body.
+static void put(char *pBody, size_t offset, uint64_t value, size_t sizeBytes)
+{
+    for (size_t x = 0; x < sizeBytes; x++) {
+        pBody[offset + x] = (char) (value >> (x * 8));
+    }
+}
+
+// Encode a UBX message containing pBody into gMessage and then
+// set up a view of it split at splitAt, as it might be in a
+// ring buffer: the second piece is placed at the start of
+// gWrapped and the first piece at the end of it; then get
+// the body view of it, checking the message class/ID.
+static void viewMake(int32_t messageClass, int32_t messageId,
+                     const char *pBody, size_t bodyLength,
+                     size_t splitAt, uGnssMsgView_t *pBodyView)
+{
+    uGnssMsgView_t view = {0};
+    size_t length = bodyLength + U_UBX_PROTOCOL_OVERHEAD_LENGTH_BYTES;
+
+    U_PORT_TEST_ASSERT(uUbxProtocolEncode(messageClass, messageId,
+                                          pBody, bodyLength,
+                                          gMessage) == (int32_t) length);
+    U_PORT_TEST_ASSERT(splitAt <= length);
+    memset(gWrapped, 0xFF, sizeof(gWrapped));
+    memcpy(gWrapped, gMessage + splitAt, length - splitAt);
+    memcpy(gWrapped + sizeof(gWrapped) - splitAt, gMessage, splitAt);
+    view.pData1 = gWrapped + sizeof(gWrapped) - splitAt;
+    view.size1 = splitAt;
+    if (length > splitAt) {
+        view.pData2 = gWrapped;
+        view.size2 = length - splitAt;
+    }
+    U_PORT_TEST_ASSERT(uGnssDecUbxBody(&view, pBodyView) ==
+                       ((messageClass << 8) | messageId));
+    U_PORT_TEST_ASSERT(pBodyView->size1 + pBodyView->size2 == bodyLength);
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS: TESTS
+ * -------------------------------------------------------------- */
+
+/** Test the UBX message decoders on messages that wrap at every
+ * possible point.
+ */
+U_PORT_TEST_FUNCTION("[gnssDec]", "gnssDecUbx")
+{
+    int32_t heapUsed;
+    char body[100];
+    uGnssMsgView_t bodyView;
+    uGnssDecUbxNavPvt_t navPvt;
+    uGnssDecUbxNavSat_t navSat;
+    uGnssDecUbxNavSatSv_t sv;
+    uGnssDecUbxMonVer_t monVer;
+    uGnssDecUbxMonVerExtension_t extension;
+    uGnssDecUbxMonCommsPort_t port;
+    uGnssDecUbxRxmRawx_t rxmRawx;
+    uGnssDecUbxRxmRawxMeas_t meas;
+    uGnssDecUbxEsfMeas_t esfMeas;
+    uGnssDecUbxEsfData_t data;
+    double d = -1234.5;
+    uint64_t dAsInt;
+
+    // Obtain the initial heap size
+    heapUsed = uPortGetHeapFree();
+
+    U_TEST_PRINT_LINE("testing UBX-NAV-PVT.");
+    memset(body, 0, sizeof(body));
+    put(body, 4, 2022, 2);  // year
+    put(body, 6, 12, 1);    // month
+    put(body, 7, 31, 1);    // day
+    put(body, 8, 23, 1);    // hour
+    put(body, 9, 59, 1);    // min
+    put(body, 10, 58, 1);   // sec
+    put(body, 11, 0x03, 1); // valid
+    put(body, 20, 3, 1);    // fixType
+    put(body, 23, 12, 1);   // numSV
+    put(body, 24, (uint32_t) -1234567890, 4); // lon
+    put(body, 28, 523456789, 4);              // lat
+    put(body, 88, (uint16_t) -300, 2);        // magDec
+    for (size_t x = 0; x <= U_GNSS_DEC_UBX_NAV_PVT_BODY_LENGTH_BYTES +
+         U_UBX_PROTOCOL_OVERHEAD_LENGTH_BYTES; x++) {
+        viewMake(0x01, 0x07, body, U_GNSS_DEC_UBX_NAV_PVT_BODY_LENGTH_BYTES,
+                 x, &bodyView);
+        memset(&navPvt, 0xFF, sizeof(navPvt));
+        U_PORT_TEST_ASSERT(uGnssDecUbxNavPvt(&bodyView, &navPvt) == 0);
+        U_PORT_TEST_ASSERT(navPvt.year == 2022);
+        U_PORT_TEST_ASSERT(navPvt.fixType == 3);
+        U_PORT_TEST_ASSERT(navPvt.numSV == 12);
+        U_PORT_TEST_ASSERT(navPvt.lon == -1234567890);
+        U_PORT_TEST_ASSERT(navPvt.lat == 523456789);
+        U_PORT_TEST_ASSERT(navPvt.magDec == -300);
+        U_PORT_TEST_ASSERT(navPvt.iTOW == 0);
+        U_PORT_TEST_ASSERT(uGnssDecUbxNavPvtGetTimeUtc(&navPvt) == 1672531198LL);
+    }
+    // Too short
+    bodyView.size1 = U_GNSS_DEC_UBX_NAV_PVT_BODY_LENGTH_BYTES - 1;
+    bodyView.size2 = 0;
+    U_PORT_TEST_ASSERT(uGnssDecUbxNavPvt(&bodyView, &navPvt) < 0);
+    U_PORT_TEST_ASSERT(uGnssDecUbxNavPvt(NULL, &navPvt) < 0);
+
+    U_TEST_PRINT_LINE("testing UBX-NAV-SAT.");
+    memset(body, 0, sizeof(body));
+    put(body, 0, 123456, 4);      // iTOW
+    put(body, 5, 2, 1);           // numSvs
+    put(body, 8 + 12 + 1, 17, 1); // svId of second satellite
+    put(body, 8 + 12 + 3, (uint8_t) -5, 1); // elev
+    put(body, 8 + 12 + 6, (uint16_t) -42, 2); // prRes
+    for (size_t x = 0; x <= 8 + (2 * 12) + U_UBX_PROTOCOL_OVERHEAD_LENGTH_BYTES; x++) {
+        viewMake(0x01, 0x35, body, 8 + (2 * 12), x, &bodyView);
+        U_PORT_TEST_ASSERT(uGnssDecUbxNavSat(&bodyView, &navSat) == 2);
+        U_PORT_TEST_ASSERT(navSat.iTOW == 123456);
+        U_PORT_TEST_ASSERT(uGnssDecUbxNavSatSv(&bodyView, 1, &sv) == 0);
+        U_PORT_TEST_ASSERT(sv.svId == 17);
+        U_PORT_TEST_ASSERT(sv.elev == -5);
+        U_PORT_TEST_ASSERT(sv.prRes == -42);
+        U_PORT_TEST_ASSERT(uGnssDecUbxNavSatSv(&bodyView, 2, &sv) < 0);
+    }
+    // Claiming more satellites than there is room for
+    put(body, 5, 3, 1);
+    viewMake(0x01, 0x35, body, 8 + (2 * 12), 0, &bodyView);
+    U_PORT_TEST_ASSERT(uGnssDecUbxNavSat(&bodyView, &navSat) < 0);
+
+    U_TEST_PRINT_LINE("testing UBX-MON-VER.");
+    memset(body, 0, sizeof(body));
+    memcpy(body, "ROM SPG 5.10 (7b202e)", 21);
+    memcpy(body + 30, "00190000", 8);
+    memcpy(body + 40, "PROTVER=34.10", 13);
+    for (size_t x = 0; x <= 70 + U_UBX_PROTOCOL_OVERHEAD_LENGTH_BYTES; x++) {
+        viewMake(0x0a, 0x04, body, 70, x, &bodyView);
+        U_PORT_TEST_ASSERT(uGnssDecUbxMonVer(&bodyView, &monVer) == 1);
+        U_PORT_TEST_ASSERT(strcmp(monVer.swVersion, "ROM SPG 5.10 (7b202e)") == 0);
+        U_PORT_TEST_ASSERT(strcmp(monVer.hwVersion, "00190000") == 0);
+        U_PORT_TEST_ASSERT(uGnssDecUbxMonVerExtension(&bodyView, 0, &extension) == 0);
+        U_PORT_TEST_ASSERT(strcmp(extension.extension, "PROTVER=34.10") == 0);
+    }
+
+    U_TEST_PRINT_LINE("testing UBX-MON-COMMS.");
+    memset(body, 0, sizeof(body));
+    put(body, 1, 2, 1);                // nPorts
+    put(body, 8 + 40, 0x0100, 2);      // portId of second port
+    put(body, 8 + 40 + 12, 9876543, 4); // rxBytes
+    put(body, 8 + 40 + 20 + 2, 77, 2);  // msgs[1]
+    put(body, 8 + 40 + 36, 5, 4);       // skipped
+    viewMake(0x0a, 0x36, body, 8 + (2 * 40), 50, &bodyView);
+    U_PORT_TEST_ASSERT(uGnssDecUbxMonComms(&bodyView, NULL) == 2);
+    U_PORT_TEST_ASSERT(uGnssDecUbxMonCommsPort(&bodyView, 1, &port) == 0);
+    U_PORT_TEST_ASSERT(port.portId == 0x0100);
+    U_PORT_TEST_ASSERT(port.rxBytes == 9876543);
+    U_PORT_TEST_ASSERT(port.msgs[1] == 77);
+    U_PORT_TEST_ASSERT(port.skipped == 5);
+
+    U_TEST_PRINT_LINE("testing UBX-RXM-RAWX.");
+    memset(body, 0, sizeof(body));
+    memcpy(&dAsInt, &d, sizeof(dAsInt));
+    put(body, 0, dAsInt, 8);           // rcvTow
+    put(body, 10, (uint8_t) 18, 1);    // leapS
+    put(body, 11, 1, 1);               // numMeas
+    put(body, 16, dAsInt, 8);          // prMes
+    put(body, 16 + 26, 45, 1);         // cno
+    for (size_t x = 0; x <= 16 + 32 + U_UBX_PROTOCOL_OVERHEAD_LENGTH_BYTES; x++) {
+        viewMake(0x02, 0x15, body, 16 + 32, x, &bodyView);
+        U_PORT_TEST_ASSERT(uGnssDecUbxRxmRawx(&bodyView, &rxmRawx) == 1);
+        U_PORT_TEST_ASSERT(rxmRawx.rcvTow == d);
+        U_PORT_TEST_ASSERT(rxmRawx.leapS == 18);
+        U_PORT_TEST_ASSERT(uGnssDecUbxRxmRawxMeas(&bodyView, 0, &meas) == 0);
+        U_PORT_TEST_ASSERT(meas.prMes == d);
+        U_PORT_TEST_ASSERT(meas.cno == 45);
+    }
+
+    U_TEST_PRINT_LINE("testing UBX-ESF-MEAS.");
+    memset(body, 0, sizeof(body));
+    put(body, 4, (2 << 11) | 0x08, 2);            // flags: two measurements plus calibTtag
+    put(body, 8 + 4, (14UL << 24) | 0xFFFFFE, 4); // second: type 14, -2
+    put(body, 8 + 8, 31415, 4);                   // calibTtag
+    viewMake(0x10, 0x02, body, 8 + 12, 12, &bodyView);
+    U_PORT_TEST_ASSERT(uGnssDecUbxEsfMeas(&bodyView, &esfMeas) == 2);
+    U_PORT_TEST_ASSERT(esfMeas.calibTtagValid);
+    U_PORT_TEST_ASSERT(esfMeas.calibTtag == 31415);
+    U_PORT_TEST_ASSERT(uGnssDecUbxEsfMeasData(&bodyView, 1, &data) == 0);
+    U_PORT_TEST_ASSERT(data.dataType == 14);
+    U_PORT_TEST_ASSERT(data.dataField == -2);
+    U_PORT_TEST_ASSERT(uGnssDecUbxEsfMeasData(&bodyView, 2, &data) < 0);
+
+    // Not a UBX message
+    memset(gWrapped, 0, sizeof(gWrapped));
+    bodyView.pData1 = gWrapped;
+    bodyView.size1 = U_UBX_PROTOCOL_OVERHEAD_LENGTH_BYTES;
+    bodyView.pData2 = NULL;
+    bodyView.size2 = 0;
+    U_PORT_TEST_ASSERT(uGnssDecUbxBody(&bodyView, &bodyView) < 0);
+
+    // Check for memory leaks: there should be no allocations at all
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("we have leaked %d byte(s).", heapUsed);
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT(heapUsed <= 0);
+}
+
+// End of file
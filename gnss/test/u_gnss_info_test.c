@@ -125,6 +125,8 @@ U_PORT_TEST_FUNCTION("[gnssInfo]", "gnssInfoStatic")
     char *pTmp;
     size_t iterations;
     uGnssTransportType_t transportTypes[U_GNSS_TRANSPORT_MAX_NUM_WITH_UBX];
+    int32_t poolCount = -1;
+    int32_t heapCount = -1;
 
     // In case a previous test failed
     uGnssTestPrivateCleanup(&gHandles);
@@ -223,6 +225,15 @@ U_PORT_TEST_FUNCTION("[gnssInfo]", "gnssInfoStatic")
                  version.rom, version.fw,
                  version.prot, version.mod);
 
+        // The UBX message exchanges above should have been served
+        // from the buffer pool
+        y = uGnssGetBufferPoolStats(gnssHandle, &poolCount, &heapCount);
+        U_PORT_TEST_ASSERT(y == 0);
+        U_TEST_PRINT_LINE("buffer pool used %d time(s), heap used %d time(s).",
+                          poolCount, heapCount);
+        U_PORT_TEST_ASSERT(poolCount > 0);
+        U_PORT_TEST_ASSERT(heapCount >= 0);
+
         // Free memory
         uPortFree(pBuffer);
 
@@ -131,6 +131,14 @@
 # define U_GNSS_MSG_TEST_MESSAGE_RECEIVE_NON_BLOCKING_POLL_DELAY_SECONDS 3
 #endif
 
+#ifndef U_GNSS_MSG_TEST_MESSAGE_RECEIVE_NON_BLOCKING_PIN_CHECK_MS
+/** How often the non-blocking test checks for, and releases, messages
+ * that the view readers have pinned; this must be short enough that
+ * the ring buffer does not fill up behind a pinned message.
+ */
+# define U_GNSS_MSG_TEST_MESSAGE_RECEIVE_NON_BLOCKING_PIN_CHECK_MS 100
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -151,6 +159,12 @@ typedef struct {
     size_t numWhenStopped;
     size_t numNotWanted;
     bool useNmeaComprehender;
+    bool useView;
+    size_t numPinned;
+    volatile int32_t pinHandle;
+    uGnssMsgView_t pinView;
+    char *pPinCopy;
+    size_t pinLength;
     void *pNmeaComprehenderContext;
     bool nmeaSequenceHasBegun;
     size_t numNmeaSequence;
@@ -250,15 +264,60 @@ static void checkMessageReceive(uGnssMessageId_t *pMessageId,
 // NRF52, which we use NRF5SDK on, doesn't have enough heap for this test
 #ifndef U_CFG_TEST_USING_NRF5SDK
 
-// Callback for the non-blocking message receives.
-static void messageReceiveCallback(uDeviceHandle_t gnssHandle,
-                                   const uGnssMessageId_t *pMessageId,
-                                   int32_t errorCodeOrLength,
-                                   void *pCallbackParam)
+// Process a message that has been read by one of the non-blocking
+// message receive callbacks into pMsgReceive->pBuffer.
+static void messageReceiveProcess(uGnssMsgTestReceive_t *pMsgReceive,
+                                  int32_t length)
 {
-    uGnssMsgTestReceive_t *pMsgReceive = (uGnssMsgTestReceive_t *) pCallbackParam;
     int32_t nmeaComprehenderErrorCode;
 
+    pMsgReceive->numRead++;
+    pMsgReceive->numDecoded++;
+    // NOTE: uGnssTestPrivateNmeaComprehender() doesn't support
+    // M8, hence this check
+    if ((pMsgReceive->messageId.type == U_GNSS_PROTOCOL_NMEA) &&
+        (pMsgReceive->moduleType != U_GNSS_MODULE_TYPE_M8) &&
+        (pMsgReceive->useNmeaComprehender)) {
+#ifdef U_GNSS_MSG_TEST_MESSAGE_RECEIVE_NON_BLOCKING_PRINT
+        // It's often useful to see these messages but the load is
+        // heavy so we don't enable printing unless required
+        U_TEST_PRINT_LINE("%.*s", length - 2, pMsgReceive->pBuffer);
+#endif
+        // This is an NMEA message, pass it to the comprehender
+        nmeaComprehenderErrorCode = uGnssTestPrivateNmeaComprehender(pMsgReceive->pBuffer,
+                                                                     length,
+                                                                     &(pMsgReceive->pNmeaComprehenderContext),
+                                                                     !U_CFG_OS_CLIB_LEAKS);
+        if (pMsgReceive->nmeaSequenceHasBegun) {
+            if (nmeaComprehenderErrorCode == (int32_t) U_ERROR_COMMON_NOT_FOUND) {
+                // NMEA sequence is not as expected
+                pMsgReceive->numNmeaBadSequence++;
+                pMsgReceive->nmeaSequenceHasBegun = false;
+            } else if (nmeaComprehenderErrorCode == (int32_t) U_ERROR_COMMON_SUCCESS) {
+                // An NMEA sequence has been completed, well done
+                pMsgReceive->nmeaSequenceHasBegun = false;
+            }
+        } else {
+            if (nmeaComprehenderErrorCode == (int32_t) U_ERROR_COMMON_TIMEOUT) {
+                // An NMEA sequence has started
+                pMsgReceive->nmeaSequenceHasBegun = true;
+                pMsgReceive->numNmeaSequence++;
+            }
+        }
+    }
+}
+
+// Handle a message arriving at one of the non-blocking message
+// receive callbacks; pView is non-NULL for a view callback.
+static void messageReceive(uDeviceHandle_t gnssHandle,
+                           const uGnssMessageId_t *pMessageId,
+                           int32_t errorCodeOrLength,
+                           const uGnssMsgView_t *pView,
+                           void *pCallbackParam)
+{
+    uGnssMsgTestReceive_t *pMsgReceive = (uGnssMsgTestReceive_t *) pCallbackParam;
+    int32_t pinHandle;
+
     if (gnssHandle != gHandles.gnssHandle) {
         gCallbackErrorCode = 1;
     }
@@ -271,6 +330,12 @@ static void messageReceiveCallback(uDeviceHandle_t gnssHandle,
     if (pCallbackParam == NULL) {
         gCallbackErrorCode = 4;
     }
+    if ((pView != NULL) && (errorCodeOrLength > 0) &&
+        ((pView->pData1 == NULL) ||
+         (pView->size1 + pView->size2 != (size_t) errorCodeOrLength) ||
+         ((pView->size2 > 0) && (pView->pData2 == NULL)))) {
+        gCallbackErrorCode = 6;
+    }
 
     if (pMsgReceive != NULL) {
         pMsgReceive->numReceived++;
@@ -282,43 +347,34 @@ static void messageReceiveCallback(uDeviceHandle_t gnssHandle,
         }
         if ((errorCodeOrLength > 0) &&
             (errorCodeOrLength <= U_GNSS_MSG_TEST_MESSAGE_RECEIVE_NON_BLOCKING_BUFFER_SIZE_BYTES)) {
-            if (uGnssMsgReceiveCallbackRead(gnssHandle,
-                                            pMsgReceive->pBuffer,
-                                            errorCodeOrLength) == errorCodeOrLength) {
-                pMsgReceive->numRead++;
-                pMsgReceive->numDecoded++;
-                // NOTE: uGnssTestPrivateNmeaComprehender() doesn't support
-                // M8, hence this check
-                if ((pMsgReceive->messageId.type == U_GNSS_PROTOCOL_NMEA) &&
-                    (pMsgReceive->moduleType != U_GNSS_MODULE_TYPE_M8) &&
-                    (pMsgReceive->useNmeaComprehender)) {
-#ifdef U_GNSS_MSG_TEST_MESSAGE_RECEIVE_NON_BLOCKING_PRINT
-                    // It's often useful to see these messages but the load is
-                    // heavy so we don't enable printing unless required
-                    U_TEST_PRINT_LINE("%.*s", errorCodeOrLength - 2, pMsgReceive->pBuffer);
-#endif
-                    // This is an NMEA message, pass it to the comprehender
-                    nmeaComprehenderErrorCode = uGnssTestPrivateNmeaComprehender(pMsgReceive->pBuffer,
-                                                                                 errorCodeOrLength,
-                                                                                 &(pMsgReceive->pNmeaComprehenderContext),
-                                                                                 !U_CFG_OS_CLIB_LEAKS);
-                    if (pMsgReceive->nmeaSequenceHasBegun) {
-                        if (nmeaComprehenderErrorCode == (int32_t) U_ERROR_COMMON_NOT_FOUND) {
-                            // NMEA sequence is not as expected
-                            pMsgReceive->numNmeaBadSequence++;
-                            pMsgReceive->nmeaSequenceHasBegun = false;
-                        } else if (nmeaComprehenderErrorCode == (int32_t) U_ERROR_COMMON_SUCCESS) {
-                            // An NMEA sequence has been completed, well done
-                            pMsgReceive->nmeaSequenceHasBegun = false;
-                        }
+            if (pView != NULL) {
+                // Copy the message out of the view so that
+                // it can be checked in the same way as the others
+                memcpy(pMsgReceive->pBuffer, pView->pData1, pView->size1);
+                if (pView->size2 > 0) {
+                    memcpy(pMsgReceive->pBuffer + pView->size1, pView->pData2, pView->size2);
+                }
+                // Pin the occasional one and keep it pinned after we
+                // return: pinnedCheckRelease(), called from the test
+                // task, checks that the view is still intact then
+                // releases it; pinHandle is set last as it is what
+                // the test task looks at
+                if ((pMsgReceive->pinHandle < 0) && ((pMsgReceive->numReceived % 10) == 0)) {
+                    pinHandle = uGnssMsgReceiveCallbackPin(gnssHandle);
+                    if (pinHandle >= 0) {
+                        pMsgReceive->pinView = *pView;
+                        memcpy(pMsgReceive->pPinCopy, pMsgReceive->pBuffer, errorCodeOrLength);
+                        pMsgReceive->pinLength = errorCodeOrLength;
+                        pMsgReceive->pinHandle = pinHandle;
                     } else {
-                        if (nmeaComprehenderErrorCode == (int32_t) U_ERROR_COMMON_TIMEOUT) {
-                            // An NMEA sequence has started
-                            pMsgReceive->nmeaSequenceHasBegun = true;
-                            pMsgReceive->numNmeaSequence++;
-                        }
+                        gCallbackErrorCode = 7;
                     }
                 }
+                messageReceiveProcess(pMsgReceive, errorCodeOrLength);
+            } else if (uGnssMsgReceiveCallbackRead(gnssHandle,
+                                                   pMsgReceive->pBuffer,
+                                                   errorCodeOrLength) == errorCodeOrLength) {
+                messageReceiveProcess(pMsgReceive, errorCodeOrLength);
             }
         } else {
             // Not an error: some messages might just be too large
@@ -330,6 +386,77 @@ static void messageReceiveCallback(uDeviceHandle_t gnssHandle,
     }
 }
 
+// Callback for the non-blocking message receives.
+static void messageReceiveCallback(uDeviceHandle_t gnssHandle,
+                                   const uGnssMessageId_t *pMessageId,
+                                   int32_t errorCodeOrLength,
+                                   void *pCallbackParam)
+{
+    messageReceive(gnssHandle, pMessageId, errorCodeOrLength, NULL, pCallbackParam);
+}
+
+// Callback for the non-blocking message receives that are given a view.
+static void messageReceiveViewCallback(uDeviceHandle_t gnssHandle,
+                                       const uGnssMessageId_t *pMessageId,
+                                       int32_t errorCodeOrLength,
+                                       const uGnssMsgView_t *pView,
+                                       void *pCallbackParam)
+{
+    if (pView == NULL) {
+        gCallbackErrorCode = 9;
+    }
+    messageReceive(gnssHandle, pMessageId, errorCodeOrLength, pView, pCallbackParam);
+}
+
+// Called from the test task: check that any message pinned by
+// messageReceive() is still intact in the ring buffer, although the
+// callback that pinned it has long since returned, then release it.
+// Returns false if a pinned message was not intact or could not be
+// released.
+static bool pinnedCheckRelease(uDeviceHandle_t gnssHandle)
+{
+    bool success = true;
+    uGnssMsgTestReceive_t *pMsgReceive;
+    const uGnssMsgView_t *pView;
+
+    for (size_t x = 0; x < sizeof(gpMessageReceive) / sizeof(gpMessageReceive[0]); x++) {
+        pMsgReceive = gpMessageReceive[x];
+        if ((pMsgReceive != NULL) && (pMsgReceive->pinHandle >= 0)) {
+            pView = &(pMsgReceive->pinView);
+            if ((pView->size1 + pView->size2 != pMsgReceive->pinLength) ||
+                (memcmp(pMsgReceive->pPinCopy, pView->pData1, pView->size1) != 0) ||
+                ((pView->size2 > 0) &&
+                 (memcmp(pMsgReceive->pPinCopy + pView->size1, pView->pData2, pView->size2) != 0))) {
+                U_TEST_PRINT_LINE("message pinned by handle %d has changed.",
+                                  pMsgReceive->asyncHandle);
+                success = false;
+            }
+            if (uGnssMsgReceivePinRelease(gnssHandle, pMsgReceive->pinHandle) == 0) {
+                pMsgReceive->numPinned++;
+            } else {
+                success = false;
+            }
+            pMsgReceive->pinHandle = -1;
+        }
+    }
+
+    return success;
+}
+
+// Wait for the given time, checking and releasing any pinned
+// messages as we go; *pBad is set to true if a check fails.
+static void pinnedWait(uDeviceHandle_t gnssHandle, int32_t delayMs, bool *pBad)
+{
+    int32_t startTimeMs = uPortGetTickTimeMs();
+
+    while (uPortGetTickTimeMs() - startTimeMs < delayMs) {
+        uPortTaskBlock(U_GNSS_MSG_TEST_MESSAGE_RECEIVE_NON_BLOCKING_PIN_CHECK_MS);
+        if (!pinnedCheckRelease(gnssHandle)) {
+            *pBad = true;
+        }
+    }
+}
+
 #endif // #ifndef U_CFG_TEST_USING_NRF5SDK 
 
 /* ----------------------------------------------------------------
@@ -556,16 +683,32 @@ U_PORT_TEST_FUNCTION("[gnssMsg]", "gnssMsgReceiveNonBlocking")
                         // Just NMEA this time
                         pTmp->useNmeaComprehender = true;
                     }
+                    // Make every fourth one take a view of the message
+                    // rather than reading it
+                    pTmp->useView = ((x % 4) == 2);
+                    pTmp->pinHandle = -1;
+                    if (pTmp->useView) {
+                        pTmp->pPinCopy = (char *) pUPortMalloc(
+                                             U_GNSS_MSG_TEST_MESSAGE_RECEIVE_NON_BLOCKING_BUFFER_SIZE_BYTES);
+                        U_PORT_TEST_ASSERT(pTmp->pPinCopy != NULL);
+                    }
                 }
 
                 // Hook them in, passing a pointer to the entry as the callback parameter
                 gCallbackErrorCode = 0;
                 for (size_t x = 0; x < sizeof(gpMessageReceive) / sizeof(gpMessageReceive[0]); x++) {
                     pTmp = gpMessageReceive[x];
-                    pTmp->asyncHandle = uGnssMsgReceiveStart(gnssHandle,
-                                                             &(pTmp->messageId),
-                                                             messageReceiveCallback,
-                                                             (void *) pTmp);
+                    if (pTmp->useView) {
+                        pTmp->asyncHandle = uGnssMsgReceiveStartView(gnssHandle,
+                                                                     &(pTmp->messageId),
+                                                                     messageReceiveViewCallback,
+                                                                     (void *) pTmp);
+                    } else {
+                        pTmp->asyncHandle = uGnssMsgReceiveStart(gnssHandle,
+                                                                 &(pTmp->messageId),
+                                                                 messageReceiveCallback,
+                                                                 (void *) pTmp);
+                    }
                     pTmp->moduleType = pModule->moduleType;
                     U_PORT_TEST_ASSERT(pTmp->asyncHandle >= 0);
                 }
@@ -580,17 +723,21 @@ U_PORT_TEST_FUNCTION("[gnssMsg]", "gnssMsgReceiveNonBlocking")
                                           (U_GNSS_MSG_TEST_MESSAGE_RECEIVE_NON_BLOCKING_MIN_STEPS - x));
                         U_PORT_TEST_ASSERT(uGnssMsgSend(gnssHandle, command,
                                                         sizeof(command)) == sizeof(command));
+                        // Nudge the receive task, as a Data Ready pin would
+                        U_PORT_TEST_ASSERT(uGnssMsgReceiveDataReady(gnssHandle) == 0);
                     } else {
                         U_TEST_PRINT_LINE("%3d waiting.",
                                           U_GNSS_MSG_TEST_MESSAGE_RECEIVE_NON_BLOCKING_POLL_DELAY_SECONDS *
                                           (U_GNSS_MSG_TEST_MESSAGE_RECEIVE_NON_BLOCKING_MIN_STEPS - x));
                     }
-                    uPortTaskBlock(U_GNSS_MSG_TEST_MESSAGE_RECEIVE_NON_BLOCKING_POLL_DELAY_SECONDS * 1000);
+                    pinnedWait(gnssHandle,
+                               U_GNSS_MSG_TEST_MESSAGE_RECEIVE_NON_BLOCKING_POLL_DELAY_SECONDS * 1000,
+                               &bad);
                 }
 
                 // Wait for all of those to come through
                 U_TEST_PRINT_LINE("wait for it...");
-                uPortTaskBlock(5000);
+                pinnedWait(gnssHandle, 5000, &bad);
 
                 // Now stop the odd ones
                 for (size_t x = 1; x < sizeof(gpMessageReceive) / sizeof(gpMessageReceive[0]); x += 2) {
@@ -606,6 +753,10 @@ U_PORT_TEST_FUNCTION("[gnssMsg]", "gnssMsgReceiveNonBlocking")
                 uPortTaskBlock(100);
                 b = uGnssMsgReceiveStopAll(gnssHandle);
                 uPortTaskBlock(100);
+                // Pins must be released even after stopping
+                if (!pinnedCheckRelease(gnssHandle)) {
+                    bad = true;
+                }
                 c = uGnssMsgReceiveStatStreamLoss(gnssHandle);
                 d = uGnssMsgReceiveStatReadLoss(gnssHandle);
 
@@ -686,6 +837,9 @@ U_PORT_TEST_FUNCTION("[gnssMsg]", "gnssMsgReceiveNonBlocking")
                     if (pTmp->numWhenStopped > 0) {
                         bad = true;
                     }
+                    if (pTmp->useView && (pTmp->numRead > 10) && (pTmp->numPinned == 0)) {
+                        bad = true;
+                    }
                     // Such a burst of logging can overwhelm some platforms
                     // (e.g. NRF5SDK) so pause between prints so as not to lose stuff.
                     uPortTaskBlock(10);
@@ -752,6 +906,7 @@ U_PORT_TEST_FUNCTION("[gnssMsg]", "gnssMsgReceiveNonBlocking")
                 // Free memory
                 for (size_t x = 0; x < sizeof(gpMessageReceive) / sizeof(gpMessageReceive[0]); x++) {
                     uPortFree(gpMessageReceive[x]->pBuffer);
+                    uPortFree(gpMessageReceive[x]->pPinCopy);
                     uPortFree(gpMessageReceive[x]->pNmeaComprehenderContext);
                     uPortFree(gpMessageReceive[x]);
                     gpMessageReceive[x] = NULL;
@@ -787,6 +942,7 @@ U_PORT_TEST_FUNCTION("[gnssMsg]", "gnssMsgCleanUp")
     for (size_t x = 0; x < sizeof(gpMessageReceive) / sizeof(gpMessageReceive[0]); x++) {
         if (gpMessageReceive[x] != NULL) {
             uPortFree(gpMessageReceive[x]->pBuffer);
+            uPortFree(gpMessageReceive[x]->pPinCopy);
             uPortFree(gpMessageReceive[x]);
         }
     }
@@ -382,6 +382,40 @@ U_PORT_TEST_FUNCTION("[gnssPos]", "gnssPosPos")
         U_PORT_TEST_ASSERT(gSvs >= 0);
         U_PORT_TEST_ASSERT(gTimeUtc > 0);
 
+        if (transportTypes[x] != U_GNSS_TRANSPORT_AT) {
+            U_TEST_PRINT_LINE("using the streamed API.");
+            latitudeX1e7 = INT_MIN;
+            longitudeX1e7 = INT_MIN;
+            timeUtc = LONG_MIN;
+            gErrorCode = 0xFFFFFFFF;
+            U_PORT_TEST_ASSERT(uGnssPosGetStreamed(gnssHandle, NULL, NULL, NULL, NULL,
+                                                   NULL, NULL, NULL) < 0);
+            U_PORT_TEST_ASSERT(uGnssPosGetStreamedStart(gnssHandle, 1000, posCallback) == 0);
+            // Can't start it twice
+            U_PORT_TEST_ASSERT(uGnssPosGetStreamedStart(gnssHandle, 1000, posCallback) < 0);
+            startTime = uPortGetTickTimeMs();
+            gStopTimeMs = startTime + U_GNSS_POS_TEST_TIMEOUT_SECONDS * 1000;
+            y = -1;
+            while ((y != 0) && (uPortGetTickTimeMs() < gStopTimeMs)) {
+                uPortTaskBlock(500);
+                y = uGnssPosGetStreamed(gnssHandle, &latitudeX1e7, &longitudeX1e7,
+                                        &altitudeMillimetres, &radiusMillimetres,
+                                        &speedMillimetresPerSecond, &svs, &timeUtc);
+            }
+            U_TEST_PRINT_LINE("streamed API returned %d after %d second(s).", y,
+                              (int32_t) (uPortGetTickTimeMs() - startTime) / 1000);
+            U_PORT_TEST_ASSERT(uGnssPosGetStreamedStop(gnssHandle) == 0);
+            U_PORT_TEST_ASSERT(y == 0);
+            U_PORT_TEST_ASSERT(latitudeX1e7 > INT_MIN);
+            U_PORT_TEST_ASSERT(longitudeX1e7 > INT_MIN);
+            U_PORT_TEST_ASSERT(timeUtc > 0);
+            // The callback should have been called with the same outcome
+            U_PORT_TEST_ASSERT(gGnssHandle == gnssHandle);
+            U_PORT_TEST_ASSERT(gErrorCode == 0);
+            U_PORT_TEST_ASSERT(uGnssPosGetStreamed(gnssHandle, NULL, NULL, NULL, NULL,
+                                                   NULL, NULL, NULL) < 0);
+        }
+
         // Check that we haven't dropped any incoming data
         y = uGnssMsgReceiveStatStreamLoss(gnssHandle);
         U_TEST_PRINT_LINE("%d byte(s) lost at the input to the ring-buffer during that test.", y);
@@ -487,6 +487,44 @@ static bool checkDecodeUbx(uRingBuffer_t *pRingBuffer, int32_t readHandle,
     return passNotFail;
 }
 
+// As checkDecodeUbx() but with pBuffer added to the ring buffer in
+// random-sized pieces, calling uGnssPrivateStreamDecodeRingBuffer()
+// after each, so that the parse has to be picked up part way through.
+static bool checkDecodeUbxInPieces(uRingBuffer_t *pRingBuffer, int32_t readHandle,
+                                   const char *pBuffer, size_t bufferSize,
+                                   uint8_t messageClass, uint8_t messageId,
+                                   int32_t expectedReturnValue)
+{
+    uGnssPrivateMessageId_t msgId = {0};
+    int32_t errorCodeOrSize = (int32_t) U_ERROR_COMMON_TIMEOUT;
+    size_t pieceSize;
+
+    msgId.type = U_GNSS_PROTOCOL_UBX;
+    msgId.id.ubx = (((uint16_t) messageClass) << 8) + messageId;
+
+    while ((bufferSize > 0) && (errorCodeOrSize == (int32_t) U_ERROR_COMMON_TIMEOUT)) {
+        pieceSize = 1 + (rand() % 16);
+        if (pieceSize > bufferSize) {
+            pieceSize = bufferSize;
+        }
+        U_PORT_TEST_ASSERT(uRingBufferAdd(pRingBuffer, pBuffer, pieceSize));
+        pBuffer += pieceSize;
+        bufferSize -= pieceSize;
+        errorCodeOrSize = uGnssPrivateStreamDecodeRingBuffer(pRingBuffer, readHandle, &msgId);
+    }
+    if (errorCodeOrSize != expectedReturnValue) {
+        U_TEST_PRINT_LINE("decoding in pieces with class 0x%02x, ID 0x%02x: expected"
+                          " return value %d, actual return value %d.", messageClass,
+                          messageId, expectedReturnValue, errorCodeOrSize);
+    }
+
+    // Remove everything from the ring buffer
+    uRingBufferReadHandle(pRingBuffer, readHandle, NULL,
+                          uRingBufferDataSizeHandle(pRingBuffer, readHandle));
+
+    return (errorCodeOrSize == expectedReturnValue);
+}
+
 #endif // #ifndef __ZEPHYR__
 
 /* ----------------------------------------------------------------
@@ -851,6 +889,11 @@ U_PORT_TEST_FUNCTION("[gnss]", "gnssPrivateUbx")
                                           messageClass, messageId,
                                           bodySize + U_UBX_PROTOCOL_OVERHEAD_LENGTH_BYTES));
 
+        // Then with the message arriving in pieces
+        U_PORT_TEST_ASSERT(checkDecodeUbxInPieces(&gRingBuffer, readHandle, gpBuffer, bufferSize,
+                                                  messageClass, messageId,
+                                                  bodySize + U_UBX_PROTOCOL_OVERHEAD_LENGTH_BYTES));
+
         // Then with a wrong message class
         y = (uint8_t) (messageClass + 1);
         if (y == U_GNSS_UBX_MESSAGE_CLASS_ALL) {
@@ -887,6 +930,11 @@ U_PORT_TEST_FUNCTION("[gnss]", "gnssPrivateUbx")
         gpBuffer = NULL;
     }
 
+    // There was rubbish around the messages, which should have been counted
+    y = uRingBufferStatParseDiscardHandle(&gRingBuffer, readHandle);
+    U_TEST_PRINT_LINE("%d byte(s) of rubbish were discarded.", y);
+    U_PORT_TEST_ASSERT(y > 0);
+
     // Free memory.
     uRingBufferDelete(&gRingBuffer);
     uPortFree(gpLinearBuffer);
@@ -910,6 +958,170 @@ U_PORT_TEST_FUNCTION("[gnss]", "gnssPrivateUbx")
 # endif
 }
 
+/** Test that the count of discarded bytes on a read handle is exact.
+ */
+U_PORT_TEST_FUNCTION("[gnss]", "gnssPrivateDiscard")
+{
+    int32_t readHandle;
+    char body[] = {0x01, 0x02, 0x03, 0x04};
+    size_t messageSize = sizeof(body) + U_UBX_PROTOCOL_OVERHEAD_LENGTH_BYTES;
+    uGnssPrivateMessageId_t msgId;
+    size_t bufferSize;
+    size_t total = 0;
+    int32_t heapUsed;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    heapUsed = uPortGetHeapFree();
+
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+
+    gpLinearBuffer = (char *) pUPortMalloc(U_GNSS_PRIVATE_TEST_RINGBUFFER_SIZE);
+    U_PORT_TEST_ASSERT(gpLinearBuffer != NULL);
+    U_PORT_TEST_ASSERT(uRingBufferCreateWithReadHandle(&gRingBuffer, gpLinearBuffer,
+                                                       U_GNSS_PRIVATE_TEST_RINGBUFFER_SIZE,
+                                                       1) == 0);
+    uRingBufferSetReadRequiresHandle(&gRingBuffer, true);
+    readHandle = uRingBufferTakeReadHandle(&gRingBuffer);
+    U_PORT_TEST_ASSERT(readHandle >= 0);
+    U_PORT_TEST_ASSERT(uRingBufferStatParseDiscardHandle(&gRingBuffer, readHandle) == 0);
+
+    gpBuffer = (char *) pUPortMalloc(U_GNSS_PRIVATE_TEST_RUBBISH_ROOM_BYTES + messageSize);
+    U_PORT_TEST_ASSERT(gpBuffer != NULL);
+
+    // Put N bytes of rubbish, none of which can be the start
+    // of a message, in front of a UBX message, for each N
+    for (size_t n = 0; n <= U_GNSS_PRIVATE_TEST_RUBBISH_ROOM_BYTES; n++) {
+        for (size_t x = 0; x < n; x++) {
+            *(gpBuffer + x) = (char) ('a' + (x % 26));
+        }
+        U_PORT_TEST_ASSERT(uUbxProtocolEncode(0x01, 0x07, body, sizeof(body),
+                                              gpBuffer + n) == (int32_t) messageSize);
+        bufferSize = n + messageSize;
+        U_PORT_TEST_ASSERT(uRingBufferAdd(&gRingBuffer, gpBuffer, bufferSize));
+        memset(&msgId, 0, sizeof(msgId));
+        msgId.type = U_GNSS_PROTOCOL_UBX;
+        msgId.id.ubx = 0x0107;
+        U_PORT_TEST_ASSERT(uGnssPrivateStreamDecodeRingBuffer(&gRingBuffer, readHandle,
+                                                              &msgId) == (int32_t) messageSize);
+        U_PORT_TEST_ASSERT(uRingBufferReadHandle(&gRingBuffer, readHandle, NULL,
+                                                 messageSize) == messageSize);
+        // The rubbish, and only the rubbish, should have been counted
+        total += n;
+        U_PORT_TEST_ASSERT(uRingBufferStatParseDiscardHandle(&gRingBuffer, readHandle) == total);
+    }
+
+    // Free memory
+    uPortFree(gpBuffer);
+    gpBuffer = NULL;
+    uRingBufferDelete(&gRingBuffer);
+    uPortFree(gpLinearBuffer);
+    gpLinearBuffer = NULL;
+
+    uPortDeinit();
+
+# ifndef __XTENSA__
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("we have leaked %d byte(s).", heapUsed);
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT(heapUsed <= 0);
+# else
+    (void) heapUsed;
+# endif
+}
+
+/** Test that flushing a read handle part way through a message
+ * throws away the parse of that message.
+ */
+U_PORT_TEST_FUNCTION("[gnss]", "gnssPrivateFlush")
+{
+    int32_t readHandle;
+    char body[] = {0x01, 0x02, 0x03, 0x04};
+    size_t messageSize = sizeof(body) + U_UBX_PROTOCOL_OVERHEAD_LENGTH_BYTES;
+    uGnssPrivateMessageId_t msgId;
+    int32_t heapUsed;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    heapUsed = uPortGetHeapFree();
+
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+
+    gpLinearBuffer = (char *) pUPortMalloc(U_GNSS_PRIVATE_TEST_RINGBUFFER_SIZE);
+    U_PORT_TEST_ASSERT(gpLinearBuffer != NULL);
+    U_PORT_TEST_ASSERT(uRingBufferCreateWithReadHandle(&gRingBuffer, gpLinearBuffer,
+                                                       U_GNSS_PRIVATE_TEST_RINGBUFFER_SIZE,
+                                                       1) == 0);
+    uRingBufferSetReadRequiresHandle(&gRingBuffer, true);
+    readHandle = uRingBufferTakeReadHandle(&gRingBuffer);
+    U_PORT_TEST_ASSERT(readHandle >= 0);
+
+    gpBuffer = (char *) pUPortMalloc(messageSize);
+    U_PORT_TEST_ASSERT(gpBuffer != NULL);
+
+    // Feed in the first half of a UBX-NAV-STATUS message, which
+    // the parser will be part way through when it runs out
+    U_PORT_TEST_ASSERT(uUbxProtocolEncode(0x01, 0x03, body, sizeof(body),
+                                          gpBuffer) == (int32_t) messageSize);
+    U_PORT_TEST_ASSERT(uRingBufferAdd(&gRingBuffer, gpBuffer, messageSize / 2));
+    memset(&msgId, 0, sizeof(msgId));
+    msgId.type = U_GNSS_PROTOCOL_UBX;
+    msgId.id.ubx = U_GNSS_UBX_MESSAGE_ALL;
+    U_PORT_TEST_ASSERT(uGnssPrivateStreamDecodeRingBuffer(&gRingBuffer, readHandle,
+                                                          &msgId) == (int32_t) U_ERROR_COMMON_TIMEOUT);
+
+    // Flush the handle, which should forget that parse
+    uRingBufferFlushHandle(&gRingBuffer, readHandle);
+    U_PORT_TEST_ASSERT(uRingBufferDataSizeHandle(&gRingBuffer, readHandle) == 0);
+
+    // Feed in a whole UBX-NAV-PVT message: it, and only it,
+    // should be found
+    U_PORT_TEST_ASSERT(uUbxProtocolEncode(0x01, 0x07, body, sizeof(body),
+                                          gpBuffer) == (int32_t) messageSize);
+    U_PORT_TEST_ASSERT(uRingBufferAdd(&gRingBuffer, gpBuffer, messageSize));
+    memset(&msgId, 0, sizeof(msgId));
+    msgId.type = U_GNSS_PROTOCOL_UBX;
+    msgId.id.ubx = U_GNSS_UBX_MESSAGE_ALL;
+    U_PORT_TEST_ASSERT(uGnssPrivateStreamDecodeRingBuffer(&gRingBuffer, readHandle,
+                                                          &msgId) == (int32_t) messageSize);
+    U_PORT_TEST_ASSERT(msgId.type == U_GNSS_PROTOCOL_UBX);
+    U_PORT_TEST_ASSERT(msgId.id.ubx == 0x0107);
+    U_PORT_TEST_ASSERT(uRingBufferReadHandle(&gRingBuffer, readHandle, NULL,
+                                             messageSize) == messageSize);
+    memset(&msgId, 0, sizeof(msgId));
+    msgId.type = U_GNSS_PROTOCOL_UBX;
+    msgId.id.ubx = U_GNSS_UBX_MESSAGE_ALL;
+    U_PORT_TEST_ASSERT(uGnssPrivateStreamDecodeRingBuffer(&gRingBuffer, readHandle,
+                                                          &msgId) < 0);
+    U_PORT_TEST_ASSERT(uRingBufferStatParseDiscardHandle(&gRingBuffer, readHandle) == 0);
+
+    // Free memory
+    uPortFree(gpBuffer);
+    gpBuffer = NULL;
+    uRingBufferDelete(&gRingBuffer);
+    uPortFree(gpLinearBuffer);
+    gpLinearBuffer = NULL;
+
+    uPortDeinit();
+
+# ifndef __XTENSA__
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("we have leaked %d byte(s).", heapUsed);
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT(heapUsed <= 0);
+# else
+    (void) heapUsed;
+# endif
+}
+
 #endif // #ifndef __ZEPHYR__
 
 /** Clean-up to be run at the end of this round of tests, just
@@ -87,6 +87,24 @@
  * the task.  This is a cooperative process: your function
  * must have emptied the queue and exited for shut-down to
  * complete.
+ *
+ * Where only one task or interrupt ever sends to an event queue
+ * it may instead be opened with `uPortEventQueueOpenSpsc()`
+ * (single-producer, single-consumer): the parameter block is then
+ * written in place into a ring buffer, without locking any mutex
+ * or allocating any memory, and your function is called with a
+ * pointer into that ring buffer.  `uPortEventQueueStatsGet()`
+ * returns the high-water mark and latency of such a queue.
+ *
+ * By default every event queue has a task of its own.  If
+ * #U_PORT_EVENT_QUEUE_SHARED_WORKER_NUM is set to a non-zero
+ * value then a pool of that many worker tasks is created
+ * instead and event queues opened with `uPortEventQueueOpen()`
+ * are serviced by whichever worker is free, saving the RAM of
+ * their stacks; a given event queue is only ever run by one
+ * worker at a time, so the events on it are still handled
+ * one at a time and in order.  See `uPortEventQueueOpen()` for
+ * the details.
  */
 
 #ifdef __cplusplus
@@ -122,10 +140,61 @@ extern "C" {
                            U_PORT_EVENT_QUEUE_MAX_PARAM_LENGTH_BYTES
 #endif
 
+#ifndef U_PORT_EVENT_QUEUE_SHARED_WORKER_NUM
+/** The number of worker tasks to share between event queues; zero,
+ * the default, means that every event queue has its own task.
+ * Note that an event function which blocks waiting for something
+ * that is itself delivered by an event queue (e.g. an AT client
+ * callback which sends an AT command) ties up a worker while it
+ * waits; if every worker can be tied up in this way then nothing
+ * will move, so be generous.
+ */
+# define U_PORT_EVENT_QUEUE_SHARED_WORKER_NUM 0
+#endif
+
+#ifndef U_PORT_EVENT_QUEUE_SHARED_WORKER_STACK_SIZE_BYTES
+/** The stack size of each shared worker task; event queues that
+ * ask for a larger stack than this get a task of their own.
+ */
+# define U_PORT_EVENT_QUEUE_SHARED_WORKER_STACK_SIZE_BYTES (1024 * 3)
+#endif
+
+#ifndef U_PORT_EVENT_QUEUE_SHARED_WORKER_PRIORITY
+/** The priority of the shared worker tasks.
+ */
+# define U_PORT_EVENT_QUEUE_SHARED_WORKER_PRIORITY U_CFG_OS_APP_TASK_PRIORITY
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
 
+/** Statistics for an event queue opened with
+ * uPortEventQueueOpenSpsc().
+ */
+typedef struct {
+    size_t queueLength;       /**< the number of entries the queue
+                                   can hold. */
+    size_t highWaterMark;     /**< the largest number of entries that
+                                   have been waiting on the queue at
+                                   any one time. */
+    uint32_t eventCount;      /**< the number of events that have been
+                                   passed to the event function. */
+    uint32_t sendFailCount;   /**< the number of sends that were
+                                   refused because the queue was full;
+                                   only uPortEventQueueSendIrq() can
+                                   fail in this way. */
+    int32_t latencyMaxMs;     /**< the longest time that an event has
+                                   waited on the queue before being
+                                   passed to the event function; since
+                                   the time is not read in interrupt
+                                   context, only events sent with
+                                   uPortEventQueueSend() are included. */
+    int32_t latencyAverageMs; /**< the average time that events sent
+                                   with uPortEventQueueSend() have
+                                   waited on the queue. */
+} uPortEventQueueStats_t;
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -175,6 +244,14 @@ extern "C" {
  *                             error, must be at least 1.
  * @return                     a handle for the event queue on success,
  *                             else negative error code.
+ *
+ * If #U_PORT_EVENT_QUEUE_SHARED_WORKER_NUM is non-zero and
+ * stackSizeBytes is no larger than
+ * #U_PORT_EVENT_QUEUE_SHARED_WORKER_STACK_SIZE_BYTES then no task
+ * is created: the function is instead called from one of the
+ * shared worker tasks, which run at
+ * #U_PORT_EVENT_QUEUE_SHARED_WORKER_PRIORITY; pName and priority
+ * are then ignored.
  */
 int32_t uPortEventQueueOpen(void (*pFunction) (void *, size_t),
                             const char *pName,
@@ -183,6 +260,54 @@ int32_t uPortEventQueueOpen(void (*pFunction) (void *, size_t),
                             int32_t priority,
                             size_t queueLength);
 
+/** Open an event queue that will only ever be sent to by a single
+ * task or a single interrupt, the single-producer, single-consumer
+ * case (e.g. a UART interrupt which only ever calls
+ * uPortEventQueueSendIrq()).  Rather than an OS queue, the event
+ * queue is then a ring buffer of queueLength entries, allocated
+ * here, into which uPortEventQueueSend() and
+ * uPortEventQueueSendIrq() write the parameter block directly,
+ * without locking a mutex or allocating memory; the event function
+ * is passed a pointer to the parameter block in the ring buffer,
+ * which is valid only until the event function returns.
+ * Statistics for the queue may be obtained with
+ * uPortEventQueueStatsGet().
+ *
+ * IMPORTANT: it is up to the caller to make sure that there is
+ * never more than one sender at a time; if there is any chance of
+ * that, use uPortEventQueueOpen() instead.  Also note that, should
+ * the queue be full, uPortEventQueueSend() will poll for room
+ * rather than blocking on the OS.
+ *
+ * The parameters are as for uPortEventQueueOpen().
+ *
+ * @param[in] pFunction        the function that will be called by
+ *                             the queue, cannot be NULL.
+ * @param[in] pName            a name to give the task that is
+ *                             at the end of the event queue, may
+ *                             be NULL.
+ * @param paramMaxLengthBytes  the maximum length of the parameters
+ *                             structure to pass to the function,
+ *                             cannot be larger than
+ *                             #U_PORT_EVENT_QUEUE_MAX_PARAM_LENGTH_BYTES.
+ * @param stackSizeBytes       the stack size of the task that the
+ *                             function will be run in, must be
+ *                             at least
+ *                             #U_PORT_EVENT_QUEUE_MIN_TASK_STACK_SIZE_BYTES.
+ * @param priority             the priority of the task that the
+ *                             function will be run in.
+ * @param queueLength          the number of entries in the ring
+ *                             buffer, must be at least 1.
+ * @return                     a handle for the event queue on success,
+ *                             else negative error code.
+ */
+int32_t uPortEventQueueOpenSpsc(void (*pFunction) (void *, size_t),
+                                const char *pName,
+                                size_t paramMaxLengthBytes,
+                                size_t stackSizeBytes,
+                                int32_t priority,
+                                size_t queueLength);
+
 /** Send to an event queue.  The data at pParam will be copied
  * onto the queue.  If the queue is full this function will block
  * until room is available.  An event queue should not be closed
@@ -237,7 +362,8 @@ bool uPortEventQueueIsTask(int32_t handle);
 
 /** Get the stack high watermark, the minimum free
  * stack, for the task at the end of the given event
- * queue in bytes.
+ * queue in bytes.  For an event queue serviced by the
+ * shared worker tasks this is the lowest of the workers.
  *
  * @param handle   the handle of the queue to check.
  * @return         the minimum stack free for the lifetime
@@ -300,6 +426,22 @@ int32_t uPortEventQueueClose(int32_t handle);
  */
 int32_t uPortEventQueueGetFree(int32_t handle);
 
+/** Get the statistics for an event queue that was opened with
+ * uPortEventQueueOpenSpsc().  The statistics are gathered without
+ * locking and so, if events are flowing at the time, they are
+ * a snapshot rather than an exact set.
+ *
+ * @param handle      the handle of the event queue.
+ * @param[out] pStats a place to put the statistics; cannot be NULL.
+ * @return            zero on success else negative error code;
+ *                    if the event queue was opened with
+ *                    uPortEventQueueOpen()
+ *                    #U_ERROR_COMMON_NOT_SUPPORTED will be
+ *                    returned.
+ */
+int32_t uPortEventQueueStatsGet(int32_t handle,
+                                uPortEventQueueStats_t *pStats);
+
 /** Free memory occupied by closed event queues.
  */
 void uPortEventQueueCleanUp(void);
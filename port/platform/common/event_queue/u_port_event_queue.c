@@ -24,6 +24,15 @@
  * protection) but, most importantly, means that no loop is required
  * to find a queue, ensuring the lowest possible latency so that
  * send-to-queue can safely be called from an interrupt.
+ *
+ * An event queue opened with uPortEventQueueOpenSpsc() uses, in
+ * place of the OS queue, a ring buffer with read and write indexes
+ * that run from zero to twice the length of the ring buffer, so
+ * that full and empty can be told apart without wasting an entry
+ * and without a wrap at 2^32 landing two live indexes on the same
+ * entry: only the (single) sender writes the write index and only
+ * the event task writes the read index, hence neither needs a lock,
+ * and a binary semaphore is used to wake up the event task.
  */
 
 #ifdef U_CFG_OVERRIDE
@@ -37,6 +46,7 @@
 #include "u_cfg_os_platform_specific.h"
 #include "u_error_common.h"
 #include "u_assert.h"
+#include "u_port.h"
 #include "u_port_heap.h"
 #include "u_port_os.h"
 
@@ -52,6 +62,48 @@
  * COMPILE-TIME MACROS
  * -------------------------------------------------------------- */
 
+#ifndef U_PORT_EVENT_QUEUE_MEMORY_BARRIER
+# ifdef _MSC_VER
+#  include <intrin.h>
+/** Memory barrier between writing an entry of the ring buffer of
+ * an SPSC event queue and moving the index on; x86, the only
+ * target of MSVC here, doesn't re-order stores with stores or
+ * loads with loads, so a compiler barrier is sufficient.
+ */
+#  define U_PORT_EVENT_QUEUE_MEMORY_BARRIER() _ReadWriteBarrier()
+# else
+/** Memory barrier between writing an entry of the ring buffer of
+ * an SPSC event queue and moving the index on.
+ */
+#  define U_PORT_EVENT_QUEUE_MEMORY_BARRIER() __sync_synchronize()
+# endif
+#endif
+
+#ifndef U_PORT_EVENT_QUEUE_ATOMIC_INCREMENT
+# ifdef _MSC_VER
+#  include <intrin.h>
+/** Atomically increment an int32_t, returning the new value.
+ */
+#  define U_PORT_EVENT_QUEUE_ATOMIC_INCREMENT(pValue) _InterlockedIncrement((volatile long *) (pValue))
+/** Atomically decrement an int32_t, returning the new value.
+ */
+#  define U_PORT_EVENT_QUEUE_ATOMIC_DECREMENT(pValue) _InterlockedDecrement((volatile long *) (pValue))
+# else
+/** Atomically increment an int32_t, returning the new value.
+ */
+#  define U_PORT_EVENT_QUEUE_ATOMIC_INCREMENT(pValue) __atomic_add_fetch((pValue), 1, __ATOMIC_SEQ_CST)
+/** Atomically decrement an int32_t, returning the new value.
+ */
+#  define U_PORT_EVENT_QUEUE_ATOMIC_DECREMENT(pValue) __atomic_sub_fetch((pValue), 1, __ATOMIC_SEQ_CST)
+# endif
+#endif
+
+/** The size of the header of each entry in the ring buffer of an
+ * SPSC event queue, rounded up to keep the parameter block that
+ * follows it aligned.
+ */
+#define U_EVENT_QUEUE_RING_HEADER_SIZE_BYTES ((sizeof(uEventQueueRingHeader_t) + 7) & ~7)
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -66,8 +118,38 @@ typedef struct uEventQueue_t {
     size_t paramMaxLengthBytes; /** Max length of an item on this OS queue. */
     uPortTaskHandle_t task; /** Handle for the OS task. */
     uPortMutexHandle_t taskRunningMutex; /** Mutex to determine if task has exited. */
+    char *pRing;              /** Ring buffer for SPSC mode, else NULL. */
+    size_t ringLength;        /** Number of entries in pRing. */
+    size_t ringEntrySizeBytes; /** Size of each entry in pRing. */
+    volatile size_t ringWrite; /** Written only by the sender, 0 to (2 * ringLength) - 1. */
+    volatile size_t ringRead;  /** Written only by the event task, 0 to (2 * ringLength) - 1. */
+    volatile bool ringExit;      /** Set to tell the event task to exit. */
+    uPortSemaphoreHandle_t ringSemaphore; /** Wakes up the event task. */
+    uint64_t latencyTotalMs;  /** For calculating the average latency. */
+    uint32_t latencyCount;    /** The number of events in latencyTotalMs. */
+    uPortEventQueueStats_t stats; /** Statistics for SPSC mode. */
+    bool shared;              /** true if run by the shared workers. */
+    volatile int32_t pendingCount; /** Events not yet run, shared only. */
 } uEventQueue_t;
 
+#if (U_PORT_EVENT_QUEUE_SHARED_WORKER_NUM > 0)
+/** A shared worker task.
+ */
+typedef struct {
+    uPortTaskHandle_t task; /** Handle for the OS task. */
+    uPortMutexHandle_t runningMutex; /** Mutex to determine if task has exited. */
+} uEventQueueWorker_t;
+#endif
+
+/** The header on each entry in the ring buffer of an SPSC event
+ * queue; the parameter block follows it.
+ */
+typedef struct {
+    int32_t size; /** The size of the parameter block. */
+    int32_t timeMs; /** The time at which the entry was written. */
+    bool timed; /** false if written from an interrupt, when timeMs is not set. */
+} uEventQueueRingHeader_t;
+
 /** The control/size word, prefixed to the parameter block sent to
  * the queue. Negative values are a control word, else this is the
  * size of the parameter block which follows.
@@ -93,10 +175,174 @@ static uPortMutexHandle_t gMutex = NULL;
  */
 static uEventQueue_t *gpEventQueue[U_PORT_EVENT_QUEUE_MAX_NUM];
 
+#if (U_PORT_EVENT_QUEUE_SHARED_WORKER_NUM > 0)
+/** The shared worker tasks.
+ */
+static uEventQueueWorker_t gWorker[U_PORT_EVENT_QUEUE_SHARED_WORKER_NUM];
+
+/** Queue of the handles of shared event queues which have events
+ * waiting, read by the shared workers; a handle of -1 tells a
+ * worker to exit.
+ */
+static uPortQueueHandle_t gWorkerQueue = NULL;
+#endif
+
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
 
+// Return the number of entries in use in the ring buffer of an
+// SPSC event queue, given its read and write indexes.
+static size_t ringUsed(const uEventQueue_t *pEventQueue,
+                       size_t read, size_t write)
+{
+    if (write < read) {
+        write += pEventQueue->ringLength << 1;
+    }
+
+    return write - read;
+}
+
+// Return a pointer to the entry in the ring buffer of an SPSC
+// event queue at the given read or write index.
+static uEventQueueRingHeader_t *pRingEntry(const uEventQueue_t *pEventQueue,
+                                           size_t index)
+{
+    if (index >= pEventQueue->ringLength) {
+        index -= pEventQueue->ringLength;
+    }
+
+    return (uEventQueueRingHeader_t *) (pEventQueue->pRing +
+                                        (index * pEventQueue->ringEntrySizeBytes));
+}
+
+// Advance a read or write index of the ring buffer of an SPSC
+// event queue.
+static size_t ringNext(const uEventQueue_t *pEventQueue, size_t index)
+{
+    index++;
+    if (index >= (pEventQueue->ringLength << 1)) {
+        index = 0;
+    }
+
+    return index;
+}
+
+// Write an entry into the ring buffer of an SPSC event queue, waking
+// up the event task; if the ring buffer is full and this is not
+// an interrupt then wait for room.  uPortGetTickTimeMs() is not
+// called from an interrupt, hence an entry written from an interrupt
+// does not count towards the latency statistics.
+static uErrorCode_t ringSend(uEventQueue_t *pEventQueue,
+                             const void *pParam, size_t paramLengthBytes,
+                             bool isIrq)
+{
+    uErrorCode_t errorCode = U_ERROR_COMMON_NO_MEMORY;
+    size_t write = pEventQueue->ringWrite;
+    size_t used = ringUsed(pEventQueue, pEventQueue->ringRead, write);
+    uEventQueueRingHeader_t *pHeader;
+
+    while (!isIrq && (used >= pEventQueue->ringLength) &&
+           !pEventQueue->ringExit) {
+        uPortTaskBlock(U_CFG_OS_YIELD_MS);
+        used = ringUsed(pEventQueue, pEventQueue->ringRead, write);
+    }
+
+    if (used < pEventQueue->ringLength) {
+        pHeader = pRingEntry(pEventQueue, write);
+        pHeader->size = (int32_t) paramLengthBytes;
+        pHeader->timed = !isIrq;
+        if (!isIrq) {
+            pHeader->timeMs = uPortGetTickTimeMs();
+        }
+        if (pParam != NULL) {
+            memcpy(((char *) pHeader) + U_EVENT_QUEUE_RING_HEADER_SIZE_BYTES,
+                   pParam, paramLengthBytes);
+        }
+        // Make sure the entry is written before it is made visible
+        U_PORT_EVENT_QUEUE_MEMORY_BARRIER();
+        pEventQueue->ringWrite = ringNext(pEventQueue, write);
+        used++;
+        if (used > pEventQueue->stats.highWaterMark) {
+            pEventQueue->stats.highWaterMark = used;
+        }
+        // The semaphore has a limit of one so this may fail,
+        // which is fine: the event task has yet to run
+        if (isIrq) {
+            uPortSemaphoreGiveIrq(pEventQueue->ringSemaphore);
+        } else {
+            uPortSemaphoreGive(pEventQueue->ringSemaphore);
+        }
+        errorCode = U_ERROR_COMMON_SUCCESS;
+    } else {
+        pEventQueue->stats.sendFailCount++;
+    }
+
+    return errorCode;
+}
+
+// Call the user function for each entry in the ring buffer of an
+// SPSC event queue, straight from the ring buffer, until told
+// to exit; called in the event task.
+static void ringRun(uEventQueue_t *pEventQueue)
+{
+    size_t read = pEventQueue->ringRead;
+    uEventQueueRingHeader_t *pHeader;
+    int32_t latencyMs;
+
+    while (!pEventQueue->ringExit) {
+        uPortSemaphoreTake(pEventQueue->ringSemaphore);
+        while (read != pEventQueue->ringWrite) {
+            // Make sure the entry is read after the index
+            U_PORT_EVENT_QUEUE_MEMORY_BARRIER();
+            pHeader = pRingEntry(pEventQueue, read);
+            if (pHeader->timed) {
+                latencyMs = uPortGetTickTimeMs() - pHeader->timeMs;
+                if (latencyMs > pEventQueue->stats.latencyMaxMs) {
+                    pEventQueue->stats.latencyMaxMs = latencyMs;
+                }
+                pEventQueue->latencyTotalMs += (uint64_t) latencyMs;
+                pEventQueue->latencyCount++;
+            }
+            pEventQueue->stats.eventCount++;
+            if (pHeader->size > 0) {
+                pEventQueue->pFunction(((char *) pHeader) + U_EVENT_QUEUE_RING_HEADER_SIZE_BYTES,
+                                       (size_t) pHeader->size);
+            } else {
+                pEventQueue->pFunction(NULL, 0);
+            }
+            // Make sure we're done with the entry before
+            // handing it back to the sender
+            U_PORT_EVENT_QUEUE_MEMORY_BARRIER();
+            read = ringNext(pEventQueue, read);
+            pEventQueue->ringRead = read;
+        }
+    }
+}
+
+// Call the user function with a block received from the OS queue
+// of an event queue, unless it is a control message.
+static void eventCall(uEventQueue_t *pEventQueue, char *pBlock)
+{
+    //lint -e(826) Suppress area too small
+    uEventQueueControlOrSize_t controlOrSize = *((uEventQueueControlOrSize_t *) pBlock);
+
+    // If this is not a control message, call the
+    // user function with the parameter block,
+    // skipping the "control or size" word at the
+    // start and passing it in instead as the size
+    // parameter
+    if ((int32_t) controlOrSize >= 0) {
+        if ((int32_t) controlOrSize > 0) {
+            pEventQueue->pFunction((void *) (pBlock + U_PORT_EVENT_QUEUE_CONTROL_OR_SIZE_LENGTH_BYTES),
+                                   // Cast in two stages to keep Lint happy
+                                   (size_t) (int32_t) controlOrSize);
+        } else {
+            pEventQueue->pFunction(NULL, 0);
+        }
+    }
+}
+
 // Run the user function.  This will be run multiple times in a
 // task of its own.
 static void eventQueueTask(void *pParam)
@@ -123,23 +369,14 @@ static void eventQueueTask(void *pParam)
 #endif
 
     *pControlOrSize = U_EVENT_CONTROL_NONE;
+    if (pEventQueue->pRing != NULL) {
+        ringRun(pEventQueue);
+        *pControlOrSize = U_EVENT_CONTROL_EXIT_NOW;
+    }
     // Continue until we're told to exit
     while (*pControlOrSize != U_EVENT_CONTROL_EXIT_NOW) {
         if (uPortQueueReceive(pEventQueue->queue, param) == 0) {
-            // If this is not a control message, call the
-            // user function with the parameter block,
-            // skipping the "control or size" word at the
-            // start and passing it in instead as the size
-            // parameter
-            if ((int32_t) *pControlOrSize >= 0) {
-                if ((int32_t) *pControlOrSize > 0) {
-                    pEventQueue->pFunction((void *) & (param[U_PORT_EVENT_QUEUE_CONTROL_OR_SIZE_LENGTH_BYTES]),
-                                           // Cast in two stages to keep Lint happy
-                                           (size_t) (int32_t) *pControlOrSize);
-                } else {
-                    pEventQueue->pFunction(NULL, 0);
-                }
-            }
+            eventCall(pEventQueue, param);
         }
     }
 
@@ -149,46 +386,256 @@ static void eventQueueTask(void *pParam)
     uPortTaskDelete(NULL);
 }
 
+#if (U_PORT_EVENT_QUEUE_SHARED_WORKER_NUM > 0)
+
+// A shared worker task: takes the handle of an event queue with
+// events waiting from gWorkerQueue and runs the user function for
+// them until there are none left.  Since a handle is only put on
+// gWorkerQueue when the pending count of the event queue goes from
+// zero to one, only one worker at a time can be running a given
+// event queue, hence the events stay in order.
+static void workerTask(void *pParam)
+{
+    uEventQueueWorker_t *pWorker = (uEventQueueWorker_t *) pParam;
+    uEventQueue_t *pEventQueue;
+    int32_t handle = 0;
+    char param[U_PORT_EVENT_QUEUE_CONTROL_OR_SIZE_LENGTH_BYTES +
+                                                               U_PORT_EVENT_QUEUE_MAX_PARAM_LENGTH_BYTES];
+
+    U_PORT_MUTEX_LOCK(pWorker->runningMutex);
+
+    // Continue until we're told to exit
+    while (handle >= 0) {
+        if ((uPortQueueReceive(gWorkerQueue, &handle) == 0) &&
+            (handle >= 0)) {
+            // No need to lock gMutex, an event queue
+            // is not freed while it has events pending
+            pEventQueue = gpEventQueue[handle];
+            do {
+                // Set task only while the user function is running,
+                // once the pending count is decremented the event
+                // queue may belong to another worker
+                pEventQueue->task = pWorker->task;
+                if (uPortQueueReceive(pEventQueue->queue, param) == 0) {
+                    eventCall(pEventQueue, param);
+                }
+                pEventQueue->task = NULL;
+            } while (U_PORT_EVENT_QUEUE_ATOMIC_DECREMENT(&(pEventQueue->pendingCount)) > 0);
+        }
+    }
+
+    U_PORT_MUTEX_UNLOCK(pWorker->runningMutex);
+
+    // Delete ourself
+    uPortTaskDelete(NULL);
+}
+
+// Having put an event on the OS queue of a shared event queue,
+// give the event queue to a worker, unless one already has it.
+static int32_t workerSchedule(uEventQueue_t *pEventQueue, bool isIrq)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+
+    if (U_PORT_EVENT_QUEUE_ATOMIC_INCREMENT(&(pEventQueue->pendingCount)) == 1) {
+        // gWorkerQueue has room for every handle, plus the
+        // exit messages, so this can't fail for lack of room
+        if (isIrq) {
+            errorCode = uPortQueueSendIrq(gWorkerQueue, &(pEventQueue->handle));
+        } else {
+            errorCode = uPortQueueSend(gWorkerQueue, &(pEventQueue->handle));
+        }
+    }
+
+    return errorCode;
+}
+
+// Stop the shared worker tasks; may be called if they were
+// only partly started.
+static void workersStop(void)
+{
+    int32_t handle = -1;
+
+    if (gWorkerQueue != NULL) {
+        for (size_t x = 0; x < sizeof(gWorker) / sizeof(gWorker[0]); x++) {
+            if (gWorker[x].runningMutex != NULL) {
+                while (uPortQueueSend(gWorkerQueue, &handle) != 0) {
+                    uPortTaskBlock(10);
+                }
+            }
+        }
+        for (size_t x = 0; x < sizeof(gWorker) / sizeof(gWorker[0]); x++) {
+            if (gWorker[x].runningMutex != NULL) {
+                U_PORT_MUTEX_LOCK(gWorker[x].runningMutex);
+                U_PORT_MUTEX_UNLOCK(gWorker[x].runningMutex);
+                uPortMutexDelete(gWorker[x].runningMutex);
+                gWorker[x].runningMutex = NULL;
+            }
+        }
+        uPortQueueDelete(gWorkerQueue);
+        gWorkerQueue = NULL;
+        // Pause here to allow the deletions
+        // above to actually occur in the idle thread,
+        // required by some RTOSs (e.g. FreeRTOS)
+        uPortTaskBlock(U_CFG_OS_YIELD_MS);
+    }
+}
+
+// Get the lowest stack minimum free of the shared workers.
+static int32_t workersStackMinFree(void)
+{
+    int32_t sizeOrErrorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    int32_t x;
+
+    for (size_t y = 0; y < sizeof(gWorker) / sizeof(gWorker[0]); y++) {
+        if (gWorker[y].runningMutex != NULL) {
+            x = uPortTaskStackMinFree(gWorker[y].task);
+            if ((sizeOrErrorCode < 0) || (x < sizeOrErrorCode)) {
+                sizeOrErrorCode = x;
+            }
+        }
+    }
+
+    return sizeOrErrorCode;
+}
+
+// Start the shared worker tasks.
+static int32_t workersStart(void)
+{
+    int32_t errorCode = uPortQueueCreate(U_PORT_EVENT_QUEUE_MAX_NUM +
+                                         U_PORT_EVENT_QUEUE_SHARED_WORKER_NUM,
+                                         sizeof(int32_t), &gWorkerQueue);
+
+    for (size_t x = 0; (errorCode == 0) &&
+         (x < sizeof(gWorker) / sizeof(gWorker[0])); x++) {
+        errorCode = uPortMutexCreate(&(gWorker[x].runningMutex));
+        if (errorCode == 0) {
+            errorCode = uPortTaskCreate(workerTask, "eventQueueWorker",
+                                        U_PORT_EVENT_QUEUE_SHARED_WORKER_STACK_SIZE_BYTES,
+                                        (void *) &(gWorker[x]),
+                                        U_PORT_EVENT_QUEUE_SHARED_WORKER_PRIORITY,
+                                        &(gWorker[x].task));
+            if (errorCode == 0) {
+                // Wait for the worker to lock the mutex,
+                // which shows it is running
+                while (uPortMutexTryLock(gWorker[x].runningMutex, 0) == 0) {
+                    uPortMutexUnlock(gWorker[x].runningMutex);
+                    uPortTaskBlock(U_CFG_OS_YIELD_MS);
+                }
+            } else {
+                uPortMutexDelete(gWorker[x].runningMutex);
+                gWorker[x].runningMutex = NULL;
+            }
+        }
+    }
+
+    if (errorCode != 0) {
+        workersStop();
+    }
+
+    return errorCode;
+}
+
+#endif // #if (U_PORT_EVENT_QUEUE_SHARED_WORKER_NUM > 0)
+
+// Create the queue that feeds the event task: an OS queue or,
+// for SPSC mode, a ring buffer and the semaphore that wakes the
+// event task up.
+static uErrorCode_t queueCreate(uEventQueue_t *pEventQueue,
+                                size_t queueLength, bool spsc)
+{
+    uErrorCode_t errorCode;
+
+    if (spsc) {
+        errorCode = U_ERROR_COMMON_NO_MEMORY;
+        pEventQueue->ringLength = queueLength;
+        pEventQueue->ringEntrySizeBytes = U_EVENT_QUEUE_RING_HEADER_SIZE_BYTES +
+                                          ((pEventQueue->paramMaxLengthBytes + 7) & ~7);
+        pEventQueue->pRing = (char *) pUPortMalloc(queueLength *
+                                                   pEventQueue->ringEntrySizeBytes);
+        if (pEventQueue->pRing != NULL) {
+            errorCode = (uErrorCode_t) uPortSemaphoreCreate(&(pEventQueue->ringSemaphore),
+                                                            0, 1);
+            if (errorCode != U_ERROR_COMMON_SUCCESS) {
+                uPortFree(pEventQueue->pRing);
+                pEventQueue->pRing = NULL;
+            }
+        }
+        pEventQueue->stats.queueLength = queueLength;
+    } else {
+        errorCode = (uErrorCode_t) uPortQueueCreate(queueLength,
+                                                    pEventQueue->paramMaxLengthBytes +
+                                                    U_PORT_EVENT_QUEUE_CONTROL_OR_SIZE_LENGTH_BYTES,
+                                                    &(pEventQueue->queue));
+    }
+
+    return errorCode;
+}
+
+// Delete the queue that feeds the event task.
+static int32_t queueDelete(uEventQueue_t *pEventQueue)
+{
+    int32_t errorCode;
+
+    if (pEventQueue->pRing != NULL) {
+        errorCode = uPortSemaphoreDelete(pEventQueue->ringSemaphore);
+        uPortFree(pEventQueue->pRing);
+        pEventQueue->pRing = NULL;
+    } else {
+        errorCode = uPortQueueDelete(pEventQueue->queue);
+    }
+
+    return errorCode;
+}
+
 // Free memory held by an event queue.
 // The mutex must be locked before this is called.
 static int32_t eventQueueFree(uEventQueue_t *pEventQueue)
 {
-    int32_t errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
-    void *pControl;
-
+    int32_t errorCode;
     // It would be nice to send just U_EVENT_CONTROL_EXIT_NOW
     // on its own here but, as address sanitizer points out,
     // the uPortQueueSend() function must copy the required
     // length for an item on the queue so it has to be
-    // given that data size, hence we allocate the block,
-    // put U_EVENT_CONTROL_EXIT_NOW at the start of it and
-    // then free it once it is sent
-    pControl = pUPortMalloc(pEventQueue->paramMaxLengthBytes +
-                            U_PORT_EVENT_QUEUE_CONTROL_OR_SIZE_LENGTH_BYTES);
-
-    if (pControl != NULL) {
-        *((uEventQueueControlOrSize_t *) pControl) = U_EVENT_CONTROL_EXIT_NOW;
-        // Get the task to exit, persisting until it is done
-        while (uPortQueueSend(pEventQueue->queue, pControl) != 0) {
-            uPortTaskBlock(10);
+    // given that data size, hence the full-size block with
+    // U_EVENT_CONTROL_EXIT_NOW at the start of it
+    char control[U_PORT_EVENT_QUEUE_CONTROL_OR_SIZE_LENGTH_BYTES +
+                                                                 U_PORT_EVENT_QUEUE_MAX_PARAM_LENGTH_BYTES];
+
+    if (pEventQueue->shared) {
+        // No task to stop: just wait for the workers to run
+        // whatever is still on the queue
+        while (pEventQueue->pendingCount > 0) {
+            uPortTaskBlock(U_CFG_OS_YIELD_MS);
+        }
+    } else {
+        if (pEventQueue->pRing != NULL) {
+            // Get the task to exit once it has emptied the ring buffer
+            pEventQueue->ringExit = true;
+            uPortSemaphoreGive(pEventQueue->ringSemaphore);
+        } else {
+            //lint -e(826) Suppress area too small
+            *((uEventQueueControlOrSize_t *) control) = U_EVENT_CONTROL_EXIT_NOW;
+            // Get the task to exit, persisting until it is done
+            while (uPortQueueSend(pEventQueue->queue, control) != 0) {
+                uPortTaskBlock(10);
+            }
         }
-        uPortFree(pControl);
         U_PORT_MUTEX_LOCK(pEventQueue->taskRunningMutex);
         U_PORT_MUTEX_UNLOCK(pEventQueue->taskRunningMutex);
-
-        // Tidy up
         uPortMutexDelete(pEventQueue->taskRunningMutex);
-        errorCode = uPortQueueDelete(pEventQueue->queue);
+    }
 
-        // Pause here to allow the deletions
-        // above to actually occur in the idle thread,
-        // required by some RTOSs (e.g. FreeRTOS)
-        uPortTaskBlock(U_CFG_OS_YIELD_MS);
+    // Tidy up
+    errorCode = queueDelete(pEventQueue);
 
-        // Now remove it from the list and free it
-        gpEventQueue[pEventQueue->handle] = NULL;
-        uPortFree(pEventQueue);
-    }
+    // Pause here to allow the deletions
+    // above to actually occur in the idle thread,
+    // required by some RTOSs (e.g. FreeRTOS)
+    uPortTaskBlock(U_CFG_OS_YIELD_MS);
+
+    // Now remove it from the list and free it
+    gpEventQueue[pEventQueue->handle] = NULL;
+    uPortFree(pEventQueue);
 
     return errorCode;
 }
@@ -230,73 +677,13 @@ static inline uEventQueue_t *pEventQueueGet(int32_t handle)
     return pEventQueue;
 }
 
-/* ----------------------------------------------------------------
- * PUBLIC FUNCTIONS: BUT ONES THAT SHOULD BE CALLED INTERNALLY ONLY
- * -------------------------------------------------------------- */
-
-// Initialise event queues.
-// Suppress Lint warnings about this not being called etc., Lint just
-// can't see where it is being called from.
-//lint -esym(759, uPortEventQueuePrivateInit)
-//lint -esym(765, uPortEventQueuePrivateInit)
-//lint -esym(714, uPortEventQueuePrivateInit)
-int32_t uPortEventQueuePrivateInit(void)
-{
-    int32_t errorCode = 0;
-
-    if (gMutex == NULL) {
-        for (size_t x = 0;
-             x < sizeof(gpEventQueue) / sizeof(gpEventQueue[0]);
-             x++) {
-            gpEventQueue[x] = NULL;
-        }
-        // Allocate the mutex to protect the table
-        errorCode = uPortMutexCreate(&gMutex);
-    }
-
-    return errorCode;
-}
-
-// Deinitialise event queues.
-// Suppress Lint warnings about this not being called etc., Lint just
-// can't see where it is being called from.
-//lint -esym(759, uPortEventQueuePrivateDeinit)
-//lint -esym(765, uPortEventQueuePrivateDeinit)
-//lint -esym(714, uPortEventQueuePrivateDeinit)
-void uPortEventQueuePrivateDeinit(void)
-{
-    if (gMutex != NULL) {
-
-        U_PORT_MUTEX_LOCK(gMutex);
-
-        // Remove all the event queues
-        for (size_t x = 0;
-             x < sizeof(gpEventQueue) / sizeof(gpEventQueue[0]);
-             x++) {
-            if (gpEventQueue[x] != NULL) {
-                U_ASSERT(eventQueueFree(gpEventQueue[x]) == 0);
-            }
-        }
-
-        U_PORT_MUTEX_UNLOCK(gMutex);
-
-        // Finally delete the mutex
-        uPortMutexDelete(gMutex);
-        gMutex = NULL;
-    }
-}
-
-/* ----------------------------------------------------------------
- * PUBLIC FUNCTIONS
- * -------------------------------------------------------------- */
-
-// Open an event queue.
-int32_t uPortEventQueueOpen(void (*pFunction) (void *, size_t),
-                            const char *pName,
-                            size_t paramMaxLengthBytes,
-                            size_t stackSizeBytes,
-                            int32_t priority,
-                            size_t queueLength)
+// Open an event queue, either kind.
+static int32_t eventQueueOpen(void (*pFunction) (void *, size_t),
+                              const char *pName,
+                              size_t paramMaxLengthBytes,
+                              size_t stackSizeBytes,
+                              int32_t priority,
+                              size_t queueLength, bool spsc)
 {
     uEventQueue_t *pEventQueue = NULL;
     uErrorCode_t handleOrError = U_ERROR_COMMON_NOT_INITIALISED;
@@ -322,15 +709,24 @@ int32_t uPortEventQueueOpen(void (*pFunction) (void *, size_t),
                 // Malloc a structure to represent the event queue
                 pEventQueue = (uEventQueue_t *) pUPortMalloc(sizeof(uEventQueue_t));
                 if (pEventQueue != NULL) {
+                    memset(pEventQueue, 0, sizeof(*pEventQueue));
                     pEventQueue->closed = false;
                     pEventQueue->pFunction = pFunction;
                     pEventQueue->paramMaxLengthBytes = paramMaxLengthBytes;
+#if (U_PORT_EVENT_QUEUE_SHARED_WORKER_NUM > 0)
+                    pEventQueue->shared = !spsc &&
+                                          (stackSizeBytes <= U_PORT_EVENT_QUEUE_SHARED_WORKER_STACK_SIZE_BYTES);
+#endif
                     // Create the queue
-                    handleOrError = (uErrorCode_t) uPortQueueCreate(queueLength,
-                                                                    paramMaxLengthBytes +
-                                                                    U_PORT_EVENT_QUEUE_CONTROL_OR_SIZE_LENGTH_BYTES,
-                                                                    &(pEventQueue->queue));
-                    if (handleOrError == U_ERROR_COMMON_SUCCESS) {
+                    handleOrError = queueCreate(pEventQueue, queueLength, spsc);
+                    if ((handleOrError == U_ERROR_COMMON_SUCCESS) && pEventQueue->shared) {
+                        // No task needed, the shared workers will run it:
+                        // add the event queue structure to the list
+                        pEventQueue->handle = handle;
+                        gpEventQueue[handle] = pEventQueue;
+                        // Return the handle
+                        handleOrError = (uErrorCode_t) handle;
+                    } else if (handleOrError == U_ERROR_COMMON_SUCCESS) {
                         // Create the mutex for task running status
                         handleOrError = (uErrorCode_t) uPortMutexCreate(&(pEventQueue->taskRunningMutex));
                         if (handleOrError == U_ERROR_COMMON_SUCCESS) {
@@ -360,13 +756,13 @@ int32_t uPortEventQueueOpen(void (*pFunction) (void *, size_t),
                                 // Couldn't create the task, delete the
                                 // mutex and queue and free the structure
                                 uPortMutexDelete(pEventQueue->taskRunningMutex);
-                                uPortQueueDelete(pEventQueue->queue);
+                                queueDelete(pEventQueue);
                                 uPortFree(pEventQueue);
                             }
                         } else {
                             // Couldn't create the mutex, delete the queue
                             // and free the structure
-                            uPortQueueDelete(pEventQueue->queue);
+                            queueDelete(pEventQueue);
                             uPortFree(pEventQueue);
                         }
                     } else {
@@ -383,61 +779,165 @@ int32_t uPortEventQueueOpen(void (*pFunction) (void *, size_t),
     return (int32_t) handleOrError;
 }
 
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS: BUT ONES THAT SHOULD BE CALLED INTERNALLY ONLY
+ * -------------------------------------------------------------- */
+
+// Initialise event queues.
+// Suppress Lint warnings about this not being called etc., Lint just
+// can't see where it is being called from.
+//lint -esym(759, uPortEventQueuePrivateInit)
+//lint -esym(765, uPortEventQueuePrivateInit)
+//lint -esym(714, uPortEventQueuePrivateInit)
+int32_t uPortEventQueuePrivateInit(void)
+{
+    int32_t errorCode = 0;
+
+    if (gMutex == NULL) {
+        for (size_t x = 0;
+             x < sizeof(gpEventQueue) / sizeof(gpEventQueue[0]);
+             x++) {
+            gpEventQueue[x] = NULL;
+        }
+        // Allocate the mutex to protect the table
+        errorCode = uPortMutexCreate(&gMutex);
+#if (U_PORT_EVENT_QUEUE_SHARED_WORKER_NUM > 0)
+        if (errorCode == 0) {
+            // Start the shared workers
+            errorCode = workersStart();
+            if (errorCode != 0) {
+                uPortMutexDelete(gMutex);
+                gMutex = NULL;
+            }
+        }
+#endif
+    }
+
+    return errorCode;
+}
+
+// Deinitialise event queues.
+// Suppress Lint warnings about this not being called etc., Lint just
+// can't see where it is being called from.
+//lint -esym(759, uPortEventQueuePrivateDeinit)
+//lint -esym(765, uPortEventQueuePrivateDeinit)
+//lint -esym(714, uPortEventQueuePrivateDeinit)
+void uPortEventQueuePrivateDeinit(void)
+{
+    if (gMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gMutex);
+
+        // Remove all the event queues
+        for (size_t x = 0;
+             x < sizeof(gpEventQueue) / sizeof(gpEventQueue[0]);
+             x++) {
+            if (gpEventQueue[x] != NULL) {
+                U_ASSERT(eventQueueFree(gpEventQueue[x]) == 0);
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK(gMutex);
+
+#if (U_PORT_EVENT_QUEUE_SHARED_WORKER_NUM > 0)
+        // Stop the shared workers
+        workersStop();
+#endif
+
+        // Finally delete the mutex
+        uPortMutexDelete(gMutex);
+        gMutex = NULL;
+    }
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Open an event queue.
+int32_t uPortEventQueueOpen(void (*pFunction) (void *, size_t),
+                            const char *pName,
+                            size_t paramMaxLengthBytes,
+                            size_t stackSizeBytes,
+                            int32_t priority,
+                            size_t queueLength)
+{
+    return eventQueueOpen(pFunction, pName, paramMaxLengthBytes,
+                          stackSizeBytes, priority, queueLength, false);
+}
+
+// Open a single-producer, single-consumer event queue.
+int32_t uPortEventQueueOpenSpsc(void (*pFunction) (void *, size_t),
+                                const char *pName,
+                                size_t paramMaxLengthBytes,
+                                size_t stackSizeBytes,
+                                int32_t priority,
+                                size_t queueLength)
+{
+    return eventQueueOpen(pFunction, pName, paramMaxLengthBytes,
+                          stackSizeBytes, priority, queueLength, true);
+}
+
 // Send to an event queue.
 int32_t uPortEventQueueSend(int32_t handle, const void *pParam,
                             size_t paramLengthBytes)
 {
     uErrorCode_t errorCode = U_ERROR_COMMON_NOT_INITIALISED;
     uEventQueue_t *pEventQueue;
-    char *pBlock = NULL;
+    char block[U_PORT_EVENT_QUEUE_CONTROL_OR_SIZE_LENGTH_BYTES +
+                                                               U_PORT_EVENT_QUEUE_MAX_PARAM_LENGTH_BYTES];
     uPortQueueHandle_t queue = NULL;
 
     if (gMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gMutex);
-
         errorCode = U_ERROR_COMMON_INVALID_PARAMETER;
         pEventQueue = pEventQueueGet(handle);
-        if ((pEventQueue != NULL) &&
-            (paramLengthBytes <= pEventQueue->paramMaxLengthBytes) &&
-            ((pParam != NULL) || (paramLengthBytes == 0))) {
-            queue = pEventQueue->queue;
-            errorCode = U_ERROR_COMMON_NO_MEMORY;
-            // We need to add the control word to the start, so pUPortMalloc
-            // a block that is paramMaxLengthBytes (i.e. paramMaxLengthBytes
-            // of the queue, not just the paramLengthBytes passed in, since
-            // uPortQueueSend() will expect to copy the full length) plus
-            // plus the control word length
-            pBlock = (char *) pUPortMalloc(pEventQueue->paramMaxLengthBytes +
-                                           U_PORT_EVENT_QUEUE_CONTROL_OR_SIZE_LENGTH_BYTES);
-            if (pBlock != NULL) {
-                // Copy in the control word, which is actually just
-                // the size in this case
-                //lint -e(826) Suppress area too small; the size of pBlock is always
-                // at least U_PORT_EVENT_QUEUE_CONTROL_OR_SIZE_LENGTH_BYTES in size
-                *((uEventQueueControlOrSize_t *) pBlock) = (uEventQueueControlOrSize_t) paramLengthBytes;
-                if (pParam != NULL) {
-                    // Copy in param
-                    //lint -e{826} Suppress pointed-to area too small, we make sure it is OK above
-                    memcpy(pBlock + U_PORT_EVENT_QUEUE_CONTROL_OR_SIZE_LENGTH_BYTES,
-                           pParam, paramLengthBytes);
-                }
+        if ((pEventQueue != NULL) && (pEventQueue->pRing != NULL)) {
+            // SPSC mode: no need to lock the mutex, there is
+            // only one of us and the ring buffer can be
+            // written directly
+            if ((paramLengthBytes <= pEventQueue->paramMaxLengthBytes) &&
+                ((pParam != NULL) || (paramLengthBytes == 0))) {
+                errorCode = ringSend(pEventQueue, pParam, paramLengthBytes, false);
             }
-        }
+        } else {
 
-        // We release the mutex before sending to the
-        // queue since the send process may block (e.g.
-        // if the queue is full) and we don't want
-        // that to block the entire API
-        U_PORT_MUTEX_UNLOCK(gMutex);
+            U_PORT_MUTEX_LOCK(gMutex);
+
+            pEventQueue = pEventQueueGet(handle);
+            if ((pEventQueue != NULL) &&
+                (paramLengthBytes <= pEventQueue->paramMaxLengthBytes) &&
+                ((pParam != NULL) || (paramLengthBytes == 0))) {
+                queue = pEventQueue->queue;
+            }
+
+            // We release the mutex before sending to the
+            // queue since the send process may block (e.g.
+            // if the queue is full) and we don't want
+            // that to block the entire API
+            U_PORT_MUTEX_UNLOCK(gMutex);
 
-        if (pBlock != NULL) {
             if (queue != NULL) {
+                // Add the control word to the start, which is
+                // actually just the size in this case; the block
+                // is on the stack and is of the maximum size since
+                // uPortQueueSend() will copy the full length of
+                // an item on the queue
+                //lint -e(826) Suppress area too small
+                *((uEventQueueControlOrSize_t *) block) = (uEventQueueControlOrSize_t) paramLengthBytes;
+                if (pParam != NULL) {
+                    // Copy in param
+                    memcpy(block + U_PORT_EVENT_QUEUE_CONTROL_OR_SIZE_LENGTH_BYTES,
+                           pParam, paramLengthBytes);
+                }
                 // Send it off
-                errorCode = (uErrorCode_t) uPortQueueSend(queue, pBlock);
+                errorCode = (uErrorCode_t) uPortQueueSend(queue, block);
+#if (U_PORT_EVENT_QUEUE_SHARED_WORKER_NUM > 0)
+                if ((errorCode == U_ERROR_COMMON_SUCCESS) && pEventQueue->shared) {
+                    errorCode = (uErrorCode_t) workerSchedule(pEventQueue, false);
+                }
+#endif
             }
-            // Free memory again
-            uPortFree(pBlock);
         }
     }
 
@@ -461,20 +961,29 @@ int32_t uPortEventQueueSendIrq(int32_t handle, const void *pParam,
         if ((pEventQueue != NULL) &&
             (paramLengthBytes <= pEventQueue->paramMaxLengthBytes) &&
             ((pParam != NULL) || (paramLengthBytes == 0))) {
-            // Copy in the control word, which is actually just
-            // the size in this case
-            //lint -e(826) Suppress area too small; the size of pBlock is always
-            // at least U_PORT_EVENT_QUEUE_CONTROL_OR_SIZE_LENGTH_BYTES in size
-            uEventQueueControlOrSize_t *pControlOrSize = (uEventQueueControlOrSize_t *) block;
-            *pControlOrSize = (uEventQueueControlOrSize_t) paramLengthBytes;
-            if (pParam != NULL) {
-                // Copy in param
-                memcpy(block + U_PORT_EVENT_QUEUE_CONTROL_OR_SIZE_LENGTH_BYTES,
-                       pParam, paramLengthBytes);
+            if (pEventQueue->pRing != NULL) {
+                errorCode = ringSend(pEventQueue, pParam, paramLengthBytes, true);
+            } else {
+                // Copy in the control word, which is actually just
+                // the size in this case
+                //lint -e(826) Suppress area too small; the size of pBlock is always
+                // at least U_PORT_EVENT_QUEUE_CONTROL_OR_SIZE_LENGTH_BYTES in size
+                uEventQueueControlOrSize_t *pControlOrSize = (uEventQueueControlOrSize_t *) block;
+                *pControlOrSize = (uEventQueueControlOrSize_t) paramLengthBytes;
+                if (pParam != NULL) {
+                    // Copy in param
+                    memcpy(block + U_PORT_EVENT_QUEUE_CONTROL_OR_SIZE_LENGTH_BYTES,
+                           pParam, paramLengthBytes);
+                }
+                // Send it off
+                errorCode = (uErrorCode_t) uPortQueueSendIrq(pEventQueue->queue,
+                                                             block);
+#if (U_PORT_EVENT_QUEUE_SHARED_WORKER_NUM > 0)
+                if ((errorCode == U_ERROR_COMMON_SUCCESS) && pEventQueue->shared) {
+                    errorCode = (uErrorCode_t) workerSchedule(pEventQueue, true);
+                }
+#endif
             }
-            // Send it off
-            errorCode = (uErrorCode_t) uPortQueueSendIrq(pEventQueue->queue,
-                                                         block);
         }
     }
 #else
@@ -505,7 +1014,9 @@ bool uPortEventQueueIsTask(int32_t handle)
         U_PORT_MUTEX_LOCK(gMutex);
 
         pEventQueue = pEventQueueGet(handle);
-        if (pEventQueue != NULL) {
+        if ((pEventQueue != NULL) && (pEventQueue->task != NULL)) {
+            // For a shared event queue task is only populated
+            // while a worker is running the user function
             isEventTask = uPortTaskIsThis(pEventQueue->task);
         }
 
@@ -528,7 +1039,15 @@ int32_t uPortEventQueueStackMinFree(int32_t handle)
         sizeOrErrorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         pEventQueue = pEventQueueGet(handle);
         if (pEventQueue != NULL) {
+#if (U_PORT_EVENT_QUEUE_SHARED_WORKER_NUM > 0)
+            if (pEventQueue->shared) {
+                sizeOrErrorCode = workersStackMinFree();
+            } else {
+                sizeOrErrorCode = uPortTaskStackMinFree(pEventQueue->task);
+            }
+#else
             sizeOrErrorCode = uPortTaskStackMinFree(pEventQueue->task);
+#endif
         }
 
         U_PORT_MUTEX_UNLOCK(gMutex);
@@ -583,7 +1102,14 @@ int32_t uPortEventQueueGetFree(int32_t handle)
 
         pEventQueue = pEventQueueGet(handle);
         if (pEventQueue != NULL) {
-            errorCodeOrFree = uPortQueueGetFree(pEventQueue->queue);
+            if (pEventQueue->pRing != NULL) {
+                errorCodeOrFree = (int32_t) (pEventQueue->ringLength -
+                                             ringUsed(pEventQueue,
+                                                      pEventQueue->ringRead,
+                                                      pEventQueue->ringWrite));
+            } else {
+                errorCodeOrFree = uPortQueueGetFree(pEventQueue->queue);
+            }
         }
 
         U_PORT_MUTEX_UNLOCK(gMutex);
@@ -592,6 +1118,38 @@ int32_t uPortEventQueueGetFree(int32_t handle)
     return errorCodeOrFree;
 }
 
+// Get the statistics for an SPSC event queue.
+int32_t uPortEventQueueStatsGet(int32_t handle,
+                                uPortEventQueueStats_t *pStats)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uEventQueue_t *pEventQueue;
+
+    if (gMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gMutex);
+
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        pEventQueue = pEventQueueGet(handle);
+        if ((pEventQueue != NULL) && (pStats != NULL)) {
+            errorCode = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+            if (pEventQueue->pRing != NULL) {
+                *pStats = pEventQueue->stats;
+                pStats->latencyAverageMs = 0;
+                if (pEventQueue->latencyCount > 0) {
+                    pStats->latencyAverageMs = (int32_t) (pEventQueue->latencyTotalMs /
+                                                          pEventQueue->latencyCount);
+                }
+                errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK(gMutex);
+    }
+
+    return errorCode;
+}
+
 // Free memory in closed event queues
 void uPortEventQueueCleanUp(void)
 {
@@ -325,6 +325,15 @@ static int32_t gEventQueueMinErrorFlag;
 // Counter for event queue callback min length
 static int32_t gEventQueueMinCounter;
 
+#if (U_PORT_EVENT_QUEUE_SHARED_WORKER_NUM > 0)
+// Counters for the shared worker event queues, incremented by
+// each event, which carries what the count should be.
+static int32_t gEventQueueSharedCounter[U_PORT_EVENT_QUEUE_SHARED_WORKER_NUM + 2];
+
+// Error flag for the shared worker event queues.
+static int32_t gEventQueueSharedErrorFlag;
+#endif
+
 #if (U_CFG_TEST_UART_A >= 0) && (U_CFG_TEST_UART_B < 0)
 
 // The data to send during UART testing.
@@ -872,6 +881,27 @@ static void eventQueueMinFunction(void *pParam,
     gEventQueueMinCounter++;
 }
 
+#if (U_PORT_EVENT_QUEUE_SHARED_WORKER_NUM > 0)
+// Event queue function for the shared worker test: the parameter
+// is the index of the event queue followed by the count that
+// event queue should have reached.
+static void eventQueueSharedFunction(void *pParam,
+                                     size_t paramLength)
+{
+    int32_t *pIndexAndCount = (int32_t *) pParam;
+
+    if ((pParam == NULL) || (paramLength != sizeof(int32_t) * 2)) {
+        gEventQueueSharedErrorFlag = 1;
+    } else {
+        if (*(pIndexAndCount + 1) != gEventQueueSharedCounter[*pIndexAndCount]) {
+            // Out of order
+            gEventQueueSharedErrorFlag = 2;
+        }
+        gEventQueueSharedCounter[*pIndexAndCount]++;
+    }
+}
+#endif
+
 #if (U_CFG_TEST_UART_A >= 0) && (U_CFG_TEST_UART_B < 0)
 
 // Callback that is called when data arrives at the UART
@@ -2135,6 +2165,262 @@ U_PORT_TEST_FUNCTION("[port]", "portEventQueue")
                        (heapUsed <= ((int32_t) gSystemHeapLost) - heapClibLossOffset));
 }
 
+/** Test event queues in single-producer, single-consumer mode,
+ * alongside a normal event queue.
+ */
+U_PORT_TEST_FUNCTION("[port]", "portEventQueueSpsc")
+{
+    uint8_t *pParam;
+    uint8_t fill;
+    size_t x;
+    int32_t y;
+    uPortEventQueueStats_t stats;
+    int32_t heapUsed;
+    int32_t heapClibLossOffset = (int32_t) gSystemHeapLost;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    heapUsed = uPortGetHeapFree();
+
+    // Reset error flags and counters
+    gEventQueueMaxErrorFlag = 0;
+    gEventQueueMaxCounter = 0;
+    gEventQueueMinErrorFlag = 0;
+    gEventQueueMinCounter = 0;
+
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+
+    U_TEST_PRINT_LINE("opening an SPSC event queue and a normal one...");
+    // The event queue functions are those of the portEventQueue
+    // test, this time with "event queue max" in SPSC mode
+    gEventQueueMaxHandle = uPortEventQueueOpenSpsc(eventQueueMaxFunction, NULL,
+                                                   U_PORT_EVENT_QUEUE_MAX_PARAM_LENGTH_BYTES,
+                                                   U_PORT_EVENT_QUEUE_MIN_TASK_STACK_SIZE_BYTES,
+                                                   U_CFG_TEST_OS_TASK_PRIORITY,
+                                                   U_PORT_TEST_QUEUE_LENGTH);
+    U_PORT_TEST_ASSERT(gEventQueueMaxHandle >= 0);
+    U_PORT_TEST_ASSERT(uPortEventQueueGetFree(gEventQueueMaxHandle) == U_PORT_TEST_QUEUE_LENGTH);
+    gEventQueueMinHandle = uPortEventQueueOpen(eventQueueMinFunction, "blah",
+                                               U_PORT_TEST_OS_EVENT_QUEUE_PARAM_MIN_SIZE_BYTES,
+                                               U_PORT_EVENT_QUEUE_MIN_TASK_STACK_SIZE_BYTES,
+                                               U_CFG_TEST_OS_TASK_PRIORITY,
+                                               U_PORT_TEST_QUEUE_LENGTH);
+    U_PORT_TEST_ASSERT(gEventQueueMinHandle >= 0);
+    // Only the SPSC event queue has statistics
+    U_PORT_TEST_ASSERT(uPortEventQueueStatsGet(gEventQueueMinHandle,
+                                               &stats) == (int32_t) U_ERROR_COMMON_NOT_SUPPORTED);
+    U_PORT_TEST_ASSERT(uPortEventQueueStatsGet(gEventQueueMaxHandle, &stats) == 0);
+    U_PORT_TEST_ASSERT(stats.queueLength == U_PORT_TEST_QUEUE_LENGTH);
+    U_PORT_TEST_ASSERT(stats.highWaterMark == 0);
+    U_PORT_TEST_ASSERT(stats.eventCount == 0);
+
+    // Generate a block with a known test pattern, 0xFF to 0 repeated.
+    //lint -esym(613, pParam) Suppress possible use of NULL pointer: it is checked
+    pParam = (uint8_t *) pUPortMalloc(U_PORT_EVENT_QUEUE_MAX_PARAM_LENGTH_BYTES);
+    U_PORT_TEST_ASSERT(pParam != NULL);
+    fill = 0xFF;
+    for (x = 0; x < U_PORT_EVENT_QUEUE_MAX_PARAM_LENGTH_BYTES; x++) {
+        *(pParam + x) = fill;
+        fill--;
+    }
+
+    U_TEST_PRINT_LINE("sending to the two event queues %d time(s)...",
+                      U_PORT_TEST_OS_EVENT_QUEUE_ITERATIONS + 1);
+
+    // Too much should fail in SPSC mode also
+    U_PORT_TEST_ASSERT(uPortEventQueueSend(gEventQueueMaxHandle,
+                                           pParam,
+                                           U_PORT_EVENT_QUEUE_MAX_PARAM_LENGTH_BYTES + 1) < 0);
+
+    // As for portEventQueue, using both the IRQ and non-IRQ versions
+    // of the call; this task is the only sender to the SPSC event
+    // queue.  The IRQ version doesn't wait for room, so keep
+    // trying if the event queue is full
+    for (x = 0; (x < U_PORT_TEST_OS_EVENT_QUEUE_ITERATIONS) &&
+         (gEventQueueMaxErrorFlag == 0) &&
+         (gEventQueueMinErrorFlag == 0); x++) {
+        *(pParam + U_PORT_EVENT_QUEUE_MAX_PARAM_LENGTH_BYTES - 1) = (uint8_t) x;
+        if (x & 1) {
+            U_PORT_TEST_ASSERT(uPortEventQueueSend(gEventQueueMaxHandle,
+                                                   (void *) pParam,
+                                                   U_PORT_EVENT_QUEUE_MAX_PARAM_LENGTH_BYTES) == 0);
+        } else {
+            do {
+                y = uPortEventQueueSendIrq(gEventQueueMaxHandle, (void *) pParam,
+                                           U_PORT_EVENT_QUEUE_MAX_PARAM_LENGTH_BYTES);
+                if (y == (int32_t) U_ERROR_COMMON_NOT_SUPPORTED) {
+                    y = uPortEventQueueSend(gEventQueueMaxHandle, (void *) pParam,
+                                            U_PORT_EVENT_QUEUE_MAX_PARAM_LENGTH_BYTES);
+                }
+                if (y == (int32_t) U_ERROR_COMMON_NO_MEMORY) {
+                    uPortTaskBlock(U_CFG_OS_YIELD_MS);
+                }
+            } while (y == (int32_t) U_ERROR_COMMON_NO_MEMORY);
+            U_PORT_TEST_ASSERT(y == 0);
+        }
+        U_PORT_TEST_ASSERT(uPortEventQueueSend(gEventQueueMinHandle,
+                                               (void *) &x, U_PORT_TEST_OS_EVENT_QUEUE_PARAM_MIN_SIZE_BYTES) == 0);
+    }
+
+    // Bonus iteration with NULL parameter
+    U_PORT_TEST_ASSERT(uPortEventQueueSend(gEventQueueMaxHandle,
+                                           NULL, 0) == 0);
+    U_PORT_TEST_ASSERT(uPortEventQueueSend(gEventQueueMinHandle,
+                                           NULL, 0) == 0);
+
+#ifndef U_PORT_TEST_CHECK_TIME_TAKEN
+    // Let everything get to its destination
+    uPortTaskBlock(1000);
+#else
+    uPortTaskBlock(100);
+#endif
+
+    U_TEST_PRINT_LINE("event queue min received %d message(s).",
+                      gEventQueueMinCounter);
+    U_TEST_PRINT_LINE("SPSC event queue max received %d message(s).",
+                      gEventQueueMaxCounter);
+    U_PORT_TEST_ASSERT(gEventQueueMaxErrorFlag == 0);
+    U_PORT_TEST_ASSERT(gEventQueueMaxCounter == U_PORT_TEST_OS_EVENT_QUEUE_ITERATIONS + 1);
+    U_PORT_TEST_ASSERT(gEventQueueMinErrorFlag == 0);
+    U_PORT_TEST_ASSERT(gEventQueueMinCounter == U_PORT_TEST_OS_EVENT_QUEUE_ITERATIONS + 1);
+    U_PORT_TEST_ASSERT(uPortEventQueueGetFree(gEventQueueMaxHandle) == U_PORT_TEST_QUEUE_LENGTH);
+
+    U_PORT_TEST_ASSERT(uPortEventQueueStatsGet(gEventQueueMaxHandle, &stats) == 0);
+    U_TEST_PRINT_LINE("SPSC event queue: high-water mark %d, %d send(s)"
+                      " refused, latency maximum %d ms, average %d ms.",
+                      stats.highWaterMark, stats.sendFailCount,
+                      stats.latencyMaxMs, stats.latencyAverageMs);
+    U_PORT_TEST_ASSERT(stats.eventCount == U_PORT_TEST_OS_EVENT_QUEUE_ITERATIONS + 1);
+    U_PORT_TEST_ASSERT((stats.highWaterMark > 0) &&
+                       (stats.highWaterMark <= U_PORT_TEST_QUEUE_LENGTH));
+    U_PORT_TEST_ASSERT((stats.latencyMaxMs >= 0) &&
+                       (stats.latencyAverageMs >= 0) &&
+                       (stats.latencyAverageMs <= stats.latencyMaxMs));
+
+    U_TEST_PRINT_LINE("closing the event queues...");
+    U_PORT_TEST_ASSERT(uPortEventQueueClose(gEventQueueMaxHandle) == 0);
+    uPortEventQueueCleanUp();
+    U_PORT_TEST_ASSERT(uPortEventQueueClose(gEventQueueMinHandle) == 0);
+
+    // Check that they are no longer available
+    U_PORT_TEST_ASSERT(uPortEventQueueSend(gEventQueueMaxHandle,
+                                           pParam,
+                                           U_PORT_EVENT_QUEUE_MAX_PARAM_LENGTH_BYTES) < 0);
+    U_PORT_TEST_ASSERT(uPortEventQueueStatsGet(gEventQueueMaxHandle, &stats) < 0);
+
+    // Free memory
+    uPortFree(pParam);
+
+    uPortDeinit();
+
+    // Give the RTOS idle task time to tidy-away the tasks
+    uPortTaskBlock(1000);
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("%d byte(s) of heap were lost to the C library"
+                      " during this test and we have leaked %d byte(s).",
+                      gSystemHeapLost - heapClibLossOffset,
+                      heapUsed - (gSystemHeapLost - heapClibLossOffset));
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT((heapUsed < 0) ||
+                       (heapUsed <= ((int32_t) gSystemHeapLost) - heapClibLossOffset));
+}
+
+#if (U_PORT_EVENT_QUEUE_SHARED_WORKER_NUM > 0)
+/** Test more event queues than there are shared workers, checking
+ * that the events on each stay in order.
+ */
+U_PORT_TEST_FUNCTION("[port]", "portEventQueueShared")
+{
+    int32_t handle[U_PORT_EVENT_QUEUE_SHARED_WORKER_NUM + 2];
+    int32_t indexAndCount[2];
+    int32_t y;
+    int32_t heapUsed;
+    int32_t heapClibLossOffset = (int32_t) gSystemHeapLost;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    heapUsed = uPortGetHeapFree();
+
+    gEventQueueSharedErrorFlag = 0;
+    memset(gEventQueueSharedCounter, 0, sizeof(gEventQueueSharedCounter));
+
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+
+    U_TEST_PRINT_LINE("opening %d event queues to share %d worker(s)...",
+                      sizeof(handle) / sizeof(handle[0]),
+                      U_PORT_EVENT_QUEUE_SHARED_WORKER_NUM);
+    for (size_t x = 0; x < sizeof(handle) / sizeof(handle[0]); x++) {
+        handle[x] = uPortEventQueueOpen(eventQueueSharedFunction, NULL,
+                                        sizeof(indexAndCount),
+                                        U_PORT_EVENT_QUEUE_MIN_TASK_STACK_SIZE_BYTES,
+                                        U_CFG_TEST_OS_TASK_PRIORITY,
+                                        U_PORT_TEST_QUEUE_LENGTH);
+        U_PORT_TEST_ASSERT(handle[x] >= 0);
+    }
+
+    // Send to all of the event queues in turn, using both the IRQ
+    // and non-IRQ versions of the call
+    for (int32_t x = 0; (x < U_PORT_TEST_OS_EVENT_QUEUE_ITERATIONS) &&
+         (gEventQueueSharedErrorFlag == 0); x++) {
+        indexAndCount[1] = x;
+        for (size_t z = 0; z < sizeof(handle) / sizeof(handle[0]); z++) {
+            indexAndCount[0] = (int32_t) z;
+            y = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+            if (x & 1) {
+                y = uPortEventQueueSendIrq(handle[z], indexAndCount,
+                                           sizeof(indexAndCount));
+                while (y == (int32_t) U_ERROR_COMMON_NO_MEMORY) {
+                    // Full, give the workers a chance
+                    uPortTaskBlock(U_CFG_OS_YIELD_MS);
+                    y = uPortEventQueueSendIrq(handle[z], indexAndCount,
+                                               sizeof(indexAndCount));
+                }
+            }
+            if (y == (int32_t) U_ERROR_COMMON_NOT_SUPPORTED) {
+                y = uPortEventQueueSend(handle[z], indexAndCount,
+                                        sizeof(indexAndCount));
+            }
+            U_PORT_TEST_ASSERT(y == 0);
+        }
+    }
+
+    // Let everything get to its destination
+    uPortTaskBlock(1000);
+
+    U_PORT_TEST_ASSERT(gEventQueueSharedErrorFlag == 0);
+    for (size_t x = 0; x < sizeof(handle) / sizeof(handle[0]); x++) {
+        U_TEST_PRINT_LINE("event queue %d received %d message(s).",
+                          x, gEventQueueSharedCounter[x]);
+        U_PORT_TEST_ASSERT(gEventQueueSharedCounter[x] == U_PORT_TEST_OS_EVENT_QUEUE_ITERATIONS);
+        U_PORT_TEST_ASSERT(!uPortEventQueueIsTask(handle[x]));
+        U_PORT_TEST_ASSERT(uPortEventQueueClose(handle[x]) == 0);
+    }
+
+    uPortDeinit();
+
+    // Give the RTOS idle task time to tidy-away the tasks
+    uPortTaskBlock(1000);
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("%d byte(s) of heap were lost to the C library"
+                      " during this test and we have leaked %d byte(s).",
+                      gSystemHeapLost - heapClibLossOffset,
+                      heapUsed - (gSystemHeapLost - heapClibLossOffset));
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT((heapUsed < 0) ||
+                       (heapUsed <= ((int32_t) gSystemHeapLost) - heapClibLossOffset));
+}
+#endif
+
 /** Test: strtok_r since we have our own implementation on
  * some platforms.
  */
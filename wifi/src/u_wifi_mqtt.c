@@ -504,6 +504,7 @@ static void edmMqttDataCallback(int32_t edmHandle, int32_t edmChannel,
 {
     uWifiMqttSession_t *pMqttSession = NULL;
     uWifiMqttTopic_t *pTopic;
+    uShortRangePbufList_t *pList = pBufList;
     int32_t i;
     (void) edmHandle;
     (void)pCallbackParameter;
@@ -520,8 +521,15 @@ static void edmMqttDataCallback(int32_t edmHandle, int32_t edmChannel,
             if ((pTopic->edmChannel == edmChannel) && (!pTopic->isTopicUnsubscribed)) {
 
                 uPortLog("U_WIFI_MQTT: EDM data event for channel %d\n", edmChannel);
+                if (pList == NULL) {
+                    // Already delivered to another subscriber: rather
+                    // than copying the message, give this one a list
+                    // that shares the same pbufs
+                    pList = pUShortRangePbufListShare(pBufList);
+                }
                 if (uShortRangePktListAppend(&pMqttSession->rxPkt,
-                                             pBufList) == (int32_t)U_ERROR_COMMON_SUCCESS) {
+                                             pList) == (int32_t)U_ERROR_COMMON_SUCCESS) {
+                    pList = NULL;
                     doCallback = (pMqttSession->rxPkt.pktCount > pMqttSession->unreadMsgsCount);
                     pMqttSession->unreadMsgsCount = pMqttSession->rxPkt.pktCount;
                     // Schedule user data pDataCb
@@ -538,12 +546,15 @@ static void edmMqttDataCallback(int32_t edmHandle, int32_t edmChannel,
                     }
                 } else {
                     uPortLog("U_WIFI_MQTT: Pkt insert failed\n");
-                    uShortRangePbufListFree(pBufList);
                 }
             }
         }
     }
 
+    // Free whatever list was not delivered (which is the
+    // original one if there were no subscribers)
+    uShortRangePbufListFree(pList);
+
     U_PORT_MUTEX_UNLOCK(gMqttSessionMutex);
 }
 